@@ -0,0 +1,681 @@
+/* bench.c -- Headless benchmark suite of R3D.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+// Renders scripted scenes along fixed camera paths, with a fixed time step and a fixed
+// random seed, so that two runs submit exactly the same frames. The CPU time of each
+// frame is measured around R3D_Begin()/R3D_End(), the GPU time comes from the profiler.
+//
+// Usage: r3d_bench [--scene <name|all>] [--frames N] [--warmup N] [--width W] [--height H]
+//                  [--flags fxaa,taa,...] [--format csv|json] [--output <file>]
+
+#include <r3d/r3d.h>
+#include <raymath.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef RESOURCES_PATH
+#	define RESOURCES_PATH "./"
+#endif
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define BENCH_TIME_STEP     (1.0f / 60.0f)
+#define BENCH_SEED          1337
+
+// ========================================
+// TYPES
+// ========================================
+
+typedef struct {
+    const char* name;
+    void (*load)(void);
+    void (*update)(float t);    //< 't' goes from zero to one along the camera path
+    void (*draw)(void);
+    void (*unload)(void);
+} bench_scene_t;
+
+typedef struct {
+    const char* name;
+    R3D_Flags flag;
+} bench_flag_t;
+
+typedef struct {
+    const char* scene;
+    int frames;
+    int gpuFrames;
+    double cpuMean, cpuP95;
+    double gpuMean, gpuP95;
+    double gpuPass[R3D_PROFILE_PASS_COUNT];
+    double cpuPass[R3D_PROFILE_PASS_COUNT];
+    double cullingTime, sortingTime;
+    double drawCalls, drawCommands, instances, triangles;
+    double viewCulled, shadowCulled;
+    double programBinds, textureBinds, vaoBinds, uniformUploads;
+    double shadowMaps, instanceBytes, boneBytes;
+} bench_result_t;
+
+// ========================================
+// SHARED SCENE DATA
+// ========================================
+
+static Camera3D camera;
+
+static R3D_Mesh plane;
+static R3D_Mesh cube;
+static R3D_Mesh sphere;
+static R3D_Material material;
+
+static void load_common(void)
+{
+    plane = R3D_GenMeshPlane(200, 200, 1, 1);
+    cube = R3D_GenMeshCube(1, 1, 1);
+    sphere = R3D_GenMeshSphere(0.5f, 16, 32);
+    material = R3D_GetDefaultMaterial();
+}
+
+static void unload_common(void)
+{
+    R3D_UnloadMesh(&plane);
+    R3D_UnloadMesh(&cube);
+    R3D_UnloadMesh(&sphere);
+    R3D_UnloadMaterial(&material);
+}
+
+static void orbit_camera(float t, float radius, float height, Vector3 target)
+{
+    float angle = 2.0f * PI * t;
+
+    camera = (Camera3D) {
+        .position = {target.x + cosf(angle) * radius, height, target.z + sinf(angle) * radius},
+        .target = target,
+        .up = {0, 1, 0},
+        .fovy = 60.0f,
+        .projection = CAMERA_PERSPECTIVE
+    };
+}
+
+// ========================================
+// SCENE: MANY LIGHTS
+// ========================================
+
+#define LIGHTS_GRID 16
+
+static void lights_load(void)
+{
+    load_common();
+
+    R3D_ENVIRONMENT_SET(ambient.color, (Color){10, 10, 10, 255});
+
+    for (int z = 0; z < LIGHTS_GRID; z++) {
+        for (int x = 0; x < LIGHTS_GRID; x++) {
+            int index = z * LIGHTS_GRID + x;
+            R3D_Light light = R3D_CreateLight(R3D_LIGHT_OMNI);
+            R3D_SetLightPosition(light, (Vector3){(x - LIGHTS_GRID / 2) * 4.0f, 3.0f, (z - LIGHTS_GRID / 2) * 4.0f});
+            R3D_SetLightColor(light, ColorFromHSV(360.0f * index / (LIGHTS_GRID * LIGHTS_GRID), 1.0f, 1.0f));
+            R3D_SetLightRange(light, 8.0f);
+            if (index % 64 == 0) R3D_EnableShadow(light, 1024);
+            R3D_SetLightActive(light, true);
+        }
+    }
+}
+
+static void lights_update(float t)
+{
+    orbit_camera(t, 30.0f, 15.0f, Vector3Zero());
+}
+
+static void lights_draw(void)
+{
+    R3D_DrawMesh(&plane, &material, MatrixIdentity());
+
+    for (int z = 0; z < LIGHTS_GRID * 2; z++) {
+        for (int x = 0; x < LIGHTS_GRID * 2; x++) {
+            Vector3 position = {(x - LIGHTS_GRID) * 2.0f + 1.0f, 0.5f, (z - LIGHTS_GRID) * 2.0f + 1.0f};
+            R3D_DrawMesh(((x + z) % 2) ? &cube : &sphere, &material, MatrixTranslate(position.x, position.y, position.z));
+        }
+    }
+}
+
+// ========================================
+// SCENE: INSTANCED VEGETATION
+// ========================================
+
+#define VEGETATION_COUNT 50000
+
+static R3D_InstanceBuffer vegetation;
+static R3D_Material vegetationMat;
+
+static void vegetation_load(void)
+{
+    load_common();
+
+    R3D_ENVIRONMENT_SET(background.color, SKYBLUE);
+    R3D_ENVIRONMENT_SET(ambient.color, (Color){60, 70, 80, 255});
+
+    Matrix* transforms = RL_MALLOC(VEGETATION_COUNT * sizeof(Matrix));
+    Color* colors = RL_MALLOC(VEGETATION_COUNT * sizeof(Color));
+
+    for (int i = 0; i < VEGETATION_COUNT; i++) {
+        float x = GetRandomValue(-95000, 95000) / 1000.0f;
+        float z = GetRandomValue(-95000, 95000) / 1000.0f;
+        float h = GetRandomValue(500, 3000) / 1000.0f;
+        float yaw = GetRandomValue(0, 6283) / 1000.0f;
+        transforms[i] = MatrixMultiply(
+            MatrixMultiply(MatrixScale(0.2f, h, 0.2f), MatrixRotateY(yaw)),
+            MatrixTranslate(x, 0.5f * h, z)
+        );
+        colors[i] = ColorFromHSV(GetRandomValue(80, 140), 0.7f, 0.8f);
+    }
+
+    vegetation = R3D_LoadInstanceBuffer(VEGETATION_COUNT, R3D_INSTANCE_COLOR, R3D_STATIC_INSTANCES);
+    R3D_UploadInstances(&vegetation, 0, VEGETATION_COUNT, transforms, colors);
+
+    RL_FREE(transforms);
+    RL_FREE(colors);
+
+    vegetationMat = R3D_GetDefaultMaterial();
+
+    R3D_Light sun = R3D_CreateLight(R3D_LIGHT_DIR);
+    R3D_SetLightDirection(sun, (Vector3){-1, -1, -0.5f});
+    R3D_EnableShadow(sun, 4096);
+    R3D_SetLightActive(sun, true);
+}
+
+static void vegetation_update(float t)
+{
+    orbit_camera(t, 60.0f, 8.0f, (Vector3){0, 1, 0});
+}
+
+static void vegetation_draw(void)
+{
+    R3D_DrawMesh(&plane, &material, MatrixIdentity());
+    R3D_DrawMeshInstanceBuffer(&cube, &vegetationMat, &vegetation);
+}
+
+static void vegetation_unload(void)
+{
+    R3D_UnloadInstanceBuffer(&vegetation);
+    R3D_UnloadMaterial(&vegetationMat);
+    unload_common();
+}
+
+// ========================================
+// SCENE: SKINNED CROWD
+// ========================================
+
+#define CROWD_GRID 10
+
+static R3D_Model dancer;
+static R3D_AnimationLib dancerAnims;
+static Matrix crowd[CROWD_GRID * CROWD_GRID];
+
+static void crowd_load(void)
+{
+    load_common();
+
+    R3D_ENVIRONMENT_SET(ambient.color, (Color){30, 30, 30, 255});
+
+    dancer = R3D_LoadModel(RESOURCES_PATH "dancer.glb");
+    dancerAnims = R3D_LoadAnimationLib(RESOURCES_PATH "dancer.glb");
+    dancer.player = R3D_LoadAnimationPlayer(&dancer.skeleton, &dancerAnims);
+    dancer.player->states[0].weight = 1.0f;
+    dancer.player->states[0].loop = true;
+
+    for (int z = 0; z < CROWD_GRID; z++) {
+        for (int x = 0; x < CROWD_GRID; x++) {
+            crowd[z * CROWD_GRID + x] = MatrixTranslate((x - CROWD_GRID / 2) * 1.5f, 0, (z - CROWD_GRID / 2) * 1.5f);
+        }
+    }
+
+    R3D_Light light = R3D_CreateLight(R3D_LIGHT_SPOT);
+    R3D_LightLookAt(light, (Vector3){0, 20, 10}, Vector3Zero());
+    R3D_EnableShadow(light, 2048);
+    R3D_SetLightActive(light, true);
+}
+
+static void crowd_update(float t)
+{
+    orbit_camera(t, 14.0f, 5.0f, (Vector3){0, 1, 0});
+    R3D_UpdateAnimationPlayer(dancer.player, BENCH_TIME_STEP);
+}
+
+static void crowd_draw(void)
+{
+    R3D_DrawMesh(&plane, &material, MatrixIdentity());
+    R3D_DrawModelInstanced(&dancer, crowd, CROWD_GRID * CROWD_GRID);
+}
+
+static void crowd_unload(void)
+{
+    R3D_UnloadAnimationLib(&dancerAnims);
+    R3D_UnloadModel(&dancer, true);
+    unload_common();
+}
+
+// ========================================
+// SCENE: PARTICLES
+// ========================================
+
+#define PARTICLE_SYSTEMS 4
+
+static R3D_ParticleSystem particles[PARTICLE_SYSTEMS];
+static R3D_InterpolationCurve particleCurve;
+static R3D_Material particleMat;
+
+static void particles_load(void)
+{
+    load_common();
+
+    R3D_ENVIRONMENT_SET(background.color, (Color){4, 4, 4, 255});
+    R3D_ENVIRONMENT_SET(bloom.mode, R3D_BLOOM_ADDITIVE);
+
+    particleCurve = R3D_LoadInterpolationCurve(3);
+    R3D_AddKeyframe(&particleCurve, 0.0f, 0.0f);
+    R3D_AddKeyframe(&particleCurve, 0.5f, 1.0f);
+    R3D_AddKeyframe(&particleCurve, 1.0f, 0.0f);
+
+    for (int i = 0; i < PARTICLE_SYSTEMS; i++) {
+        particles[i] = R3D_LoadParticleSystem(4096);
+        particles[i].position = (Vector3){(i % 2) * 8.0f - 4.0f, 0, (i / 2) * 8.0f - 4.0f};
+        particles[i].initialVelocity = (Vector3){0, 10.0f, 0};
+        particles[i].scaleOverLifetime = &particleCurve;
+        particles[i].spreadAngle = 45.0f;
+        particles[i].emissionRate = 2048;
+        particles[i].lifetime = 2.0f;
+        R3D_CalculateParticleSystemBoundingBox(&particles[i]);
+    }
+
+    particleMat = R3D_GetDefaultMaterial();
+    particleMat.emission.color = (Color){255, 80, 0, 255};
+    particleMat.emission.energy = 1.0f;
+}
+
+static void particles_update(float t)
+{
+    orbit_camera(t, 16.0f, 8.0f, (Vector3){0, 4, 0});
+
+    for (int i = 0; i < PARTICLE_SYSTEMS; i++) {
+        R3D_UpdateParticleSystem(&particles[i], BENCH_TIME_STEP);
+    }
+}
+
+static void particles_draw(void)
+{
+    for (int i = 0; i < PARTICLE_SYSTEMS; i++) {
+        R3D_DrawParticleSystem(&particles[i], &sphere, &particleMat);
+    }
+}
+
+static void particles_unload(void)
+{
+    for (int i = 0; i < PARTICLE_SYSTEMS; i++) {
+        R3D_UnloadParticleSystem(&particles[i]);
+    }
+    R3D_UnloadInterpolationCurve(particleCurve);
+    R3D_UnloadMaterial(&particleMat);
+    unload_common();
+}
+
+// ========================================
+// SCENE: FULL POST-PROCESSING STACK
+// ========================================
+
+static void post_load(void)
+{
+    load_common();
+
+    R3D_ENVIRONMENT_SET(background.color, SKYBLUE);
+    R3D_ENVIRONMENT_SET(ambient.color, DARKGRAY);
+    R3D_ENVIRONMENT_SET(ssao.enabled, true);
+    R3D_ENVIRONMENT_SET(ssil.enabled, true);
+    R3D_ENVIRONMENT_SET(ssr.enabled, true);
+    R3D_ENVIRONMENT_SET(fog.mode, R3D_FOG_EXP);
+    R3D_ENVIRONMENT_SET(dof.mode, R3D_DOF_ENABLED);
+    R3D_ENVIRONMENT_SET(dof.focusPoint, 10.0f);
+    R3D_ENVIRONMENT_SET(bloom.mode, R3D_BLOOM_MIX);
+    R3D_ENVIRONMENT_SET(tonemap.mode, R3D_TONEMAP_ACES);
+
+    material.orm.roughness = 0.2f;
+    material.orm.metalness = 0.5f;
+
+    R3D_Light sun = R3D_CreateLight(R3D_LIGHT_DIR);
+    R3D_SetLightDirection(sun, (Vector3){-1, -1, -1});
+    R3D_EnableShadow(sun, 2048);
+    R3D_SetLightActive(sun, true);
+}
+
+static void post_update(float t)
+{
+    orbit_camera(t, 12.0f, 4.0f, (Vector3){0, 1, 0});
+}
+
+static void post_draw(void)
+{
+    R3D_DrawMesh(&plane, &material, MatrixIdentity());
+
+    for (int i = 0; i < 24; i++) {
+        float angle = 2.0f * PI * i / 24;
+        Matrix transform = MatrixTranslate(cosf(angle) * 6.0f, 1.0f, sinf(angle) * 6.0f);
+        R3D_DrawMesh((i % 2) ? &cube : &sphere, &material, MatrixMultiply(MatrixScale(2, 2, 2), transform));
+    }
+}
+
+// ========================================
+// SCENES AND FLAGS
+// ========================================
+
+static const bench_scene_t SCENES[] = {
+    {"lights", lights_load, lights_update, lights_draw, unload_common},
+    {"vegetation", vegetation_load, vegetation_update, vegetation_draw, vegetation_unload},
+    {"crowd", crowd_load, crowd_update, crowd_draw, crowd_unload},
+    {"particles", particles_load, particles_update, particles_draw, particles_unload},
+    {"post", post_load, post_update, post_draw, unload_common},
+};
+
+static const bench_flag_t FLAGS[] = {
+    {"fxaa", R3D_FLAG_FXAA},
+    {"taa", R3D_FLAG_TAA},
+    {"opaque_sorting", R3D_FLAG_OPAQUE_SORTING},
+    {"transparent_sorting", R3D_FLAG_TRANSPARENT_SORTING},
+    {"no_frustum_culling", R3D_FLAG_NO_FRUSTUM_CULLING},
+    {"gpu_instance_culling", R3D_FLAG_GPU_INSTANCE_CULLING},
+    {"occlusion_culling", R3D_FLAG_OCCLUSION_CULLING},
+    {"compact_gbuffer", R3D_FLAG_COMPACT_GBUFFER},
+};
+
+#define SCENE_COUNT (int)(sizeof(SCENES) / sizeof(SCENES[0]))
+#define FLAG_COUNT  (int)(sizeof(FLAGS) / sizeof(FLAGS[0]))
+
+static bool parse_flags(const char* list, R3D_Flags* flags)
+{
+    char buffer[256];
+    strncpy(buffer, list, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = '\0';
+
+    for (char* name = strtok(buffer, ","); name != NULL; name = strtok(NULL, ",")) {
+        int i = 0;
+        while (i < FLAG_COUNT && strcmp(FLAGS[i].name, name) != 0) i++;
+        if (i == FLAG_COUNT) {
+            fprintf(stderr, "r3d_bench: unknown flag '%s'\n", name);
+            return false;
+        }
+        *flags |= FLAGS[i].flag;
+    }
+
+    return true;
+}
+
+// ========================================
+// MEASURES
+// ========================================
+
+static int compare_float(const void* a, const void* b)
+{
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+static void mean_p95(float* values, int count, double* mean, double* p95)
+{
+    *mean = *p95 = 0.0;
+    if (count == 0) return;
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += values[i];
+    *mean = sum / count;
+
+    qsort(values, count, sizeof(float), compare_float);
+    *p95 = values[(int)(0.95f * (count - 1))];
+}
+
+static bench_result_t run_scene(const bench_scene_t* scene, int width, int height, R3D_Flags flags, int warmup, int frames)
+{
+    bench_result_t result = {.scene = scene->name, .frames = frames};
+
+    float* cpuTimes = RL_CALLOC(frames, sizeof(float));
+    float* gpuTimes = RL_CALLOC(frames, sizeof(float));
+    uint32_t lastProfile = UINT32_MAX;
+
+    SetRandomSeed(BENCH_SEED);
+    R3D_Init(width, height, flags | R3D_FLAG_GPU_PROFILING);
+    scene->load();
+
+    int total = warmup + frames;
+    for (int i = 0; i < total; i++)
+    {
+        scene->update((float)i / total);
+
+        double start = GetTime();
+
+        BeginDrawing();
+            R3D_Begin(camera);
+                scene->draw();
+            R3D_End();
+        EndDrawing();
+
+        if (i < warmup) continue;
+
+        cpuTimes[i - warmup] = (float)((GetTime() - start) * 1000.0);
+
+        // The counters describe the frame just rendered
+        R3D_FrameStats stats = R3D_GetFrameStats();
+        for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) result.cpuPass[p] += stats.passTime[p];
+        result.cullingTime += stats.cullingTime;
+        result.sortingTime += stats.sortingTime;
+        result.drawCalls += stats.drawCalls;
+        result.drawCommands += stats.drawCommands;
+        result.instances += stats.instancesDrawn;
+        result.triangles += (double)stats.trianglesSubmitted;
+        result.viewCulled += stats.viewCulledCalls;
+        result.shadowCulled += stats.shadowCulledCalls;
+        result.programBinds += stats.programBinds;
+        result.textureBinds += stats.textureBinds;
+        result.vaoBinds += stats.vaoBinds;
+        result.uniformUploads += stats.uniformUploads;
+        result.shadowMaps += stats.shadowMapsUpdated;
+        result.instanceBytes += (double)stats.instanceBytes;
+        result.boneBytes += (double)stats.boneBytes;
+
+        // The GPU timings arrive a few frames late, only the measured frames are kept
+        R3D_FrameProfile profile = R3D_GetFrameProfile();
+        if (profile.valid && profile.frame != lastProfile && profile.frame >= (uint32_t)warmup) {
+            lastProfile = profile.frame;
+            gpuTimes[result.gpuFrames++] = profile.totalTime;
+            for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) result.gpuPass[p] += profile.passTime[p];
+        }
+    }
+
+    scene->unload();
+    R3D_Close();
+
+    double* averaged[] = {
+        &result.cullingTime, &result.sortingTime, &result.drawCalls, &result.drawCommands,
+        &result.instances, &result.triangles, &result.viewCulled, &result.shadowCulled,
+        &result.programBinds, &result.textureBinds, &result.vaoBinds, &result.uniformUploads,
+        &result.shadowMaps, &result.instanceBytes, &result.boneBytes
+    };
+    for (int i = 0; i < (int)(sizeof(averaged) / sizeof(averaged[0])); i++) {
+        *averaged[i] /= frames;
+    }
+    for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) {
+        result.cpuPass[p] /= frames;
+        if (result.gpuFrames > 0) result.gpuPass[p] /= result.gpuFrames;
+    }
+
+    mean_p95(cpuTimes, frames, &result.cpuMean, &result.cpuP95);
+    mean_p95(gpuTimes, result.gpuFrames, &result.gpuMean, &result.gpuP95);
+
+    RL_FREE(cpuTimes);
+    RL_FREE(gpuTimes);
+
+    return result;
+}
+
+// ========================================
+// OUTPUT
+// ========================================
+
+static void pass_key(char* dst, size_t size, const char* prefix, int pass)
+{
+    // Names like "Depth Pyramid" become "depth_pyramid"
+    int n = snprintf(dst, size, "%s", prefix);
+    for (const char* c = R3D_GetProfilePassName(pass); *c && n < (int)size - 1; c++) {
+        dst[n++] = (*c == ' ' || *c == '-') ? '_' : (char)((*c >= 'A' && *c <= 'Z') ? *c + 32 : *c);
+    }
+    dst[n] = '\0';
+}
+
+static void write_csv(FILE* out, const bench_result_t* results, int count, int width, int height, const char* flags)
+{
+    char key[64];
+
+    fprintf(out, "scene,width,height,flags,frames,gpu_frames,cpu_ms_mean,cpu_ms_p95,gpu_ms_mean,gpu_ms_p95");
+    for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) { pass_key(key, sizeof(key), "gpu_ms_", p); fprintf(out, ",%s", key); }
+    for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) { pass_key(key, sizeof(key), "cpu_ms_", p); fprintf(out, ",%s", key); }
+    fprintf(out, ",cpu_ms_culling,cpu_ms_sorting,draw_calls,draw_commands,instances,triangles,view_culled_calls,shadow_culled_calls"
+                 ",program_binds,texture_binds,vao_binds,uniform_uploads,shadow_maps,instance_bytes,bone_bytes\n");
+
+    for (int i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        fprintf(out, "%s,%d,%d,%s,%d,%d,%.4f,%.4f,%.4f,%.4f", r->scene, width, height, flags,
+                r->frames, r->gpuFrames, r->cpuMean, r->cpuP95, r->gpuMean, r->gpuP95);
+        for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) fprintf(out, ",%.4f", r->gpuPass[p]);
+        for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) fprintf(out, ",%.4f", r->cpuPass[p]);
+        fprintf(out, ",%.4f,%.4f,%.1f,%.1f,%.1f,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%.0f,%.0f\n",
+                r->cullingTime, r->sortingTime, r->drawCalls, r->drawCommands, r->instances, r->triangles,
+                r->viewCulled, r->shadowCulled, r->programBinds, r->textureBinds, r->vaoBinds,
+                r->uniformUploads, r->shadowMaps, r->instanceBytes, r->boneBytes);
+    }
+}
+
+static void write_json(FILE* out, const bench_result_t* results, int count, int width, int height, const char* flags)
+{
+    char key[64];
+
+    fprintf(out, "{\n  \"width\": %d,\n  \"height\": %d,\n  \"flags\": \"%s\",\n  \"scenes\": [\n", width, height, flags);
+
+    for (int i = 0; i < count; i++) {
+        const bench_result_t* r = &results[i];
+        fprintf(out, "    {\n      \"scene\": \"%s\", \"frames\": %d, \"gpu_frames\": %d,\n", r->scene, r->frames, r->gpuFrames);
+        fprintf(out, "      \"cpu_ms_mean\": %.4f, \"cpu_ms_p95\": %.4f, \"gpu_ms_mean\": %.4f, \"gpu_ms_p95\": %.4f,\n",
+                r->cpuMean, r->cpuP95, r->gpuMean, r->gpuP95);
+        fprintf(out, "      \"gpu_ms\": {");
+        for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) {
+            pass_key(key, sizeof(key), "", p);
+            fprintf(out, "%s\"%s\": %.4f", p ? ", " : "", key, r->gpuPass[p]);
+        }
+        fprintf(out, "},\n      \"cpu_ms\": {");
+        for (int p = 0; p < R3D_PROFILE_PASS_COUNT; p++) {
+            pass_key(key, sizeof(key), "", p);
+            fprintf(out, "%s\"%s\": %.4f", p ? ", " : "", key, r->cpuPass[p]);
+        }
+        fprintf(out, ", \"culling\": %.4f, \"sorting\": %.4f},\n", r->cullingTime, r->sortingTime);
+        fprintf(out, "      \"draw_calls\": %.1f, \"draw_commands\": %.1f, \"instances\": %.1f, \"triangles\": %.0f,\n",
+                r->drawCalls, r->drawCommands, r->instances, r->triangles);
+        fprintf(out, "      \"view_culled_calls\": %.1f, \"shadow_culled_calls\": %.1f, \"shadow_maps\": %.2f,\n",
+                r->viewCulled, r->shadowCulled, r->shadowMaps);
+        fprintf(out, "      \"program_binds\": %.1f, \"texture_binds\": %.1f, \"vao_binds\": %.1f, \"uniform_uploads\": %.1f,\n",
+                r->programBinds, r->textureBinds, r->vaoBinds, r->uniformUploads);
+        fprintf(out, "      \"instance_bytes\": %.0f, \"bone_bytes\": %.0f\n", r->instanceBytes, r->boneBytes);
+        fprintf(out, "    }%s\n", (i < count - 1) ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+// ========================================
+// MAIN
+// ========================================
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: r3d_bench [--scene <name|all>] [--frames N] [--warmup N] [--width W] [--height H]\n"
+                    "                 [--flags a,b,...] [--format csv|json] [--output <file>]\n");
+    fprintf(stderr, "scenes:");
+    for (int i = 0; i < SCENE_COUNT; i++) fprintf(stderr, " %s", SCENES[i].name);
+    fprintf(stderr, "\nflags:");
+    for (int i = 0; i < FLAG_COUNT; i++) fprintf(stderr, " %s", FLAGS[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* sceneName = "all";
+    const char* flagList = "";
+    const char* format = "csv";
+    const char* output = NULL;
+    int frames = 600, warmup = 60;
+    int width = 1920, height = 1080;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value == NULL) { usage(); return 1; }
+        if (strcmp(arg, "--scene") == 0) sceneName = value;
+        else if (strcmp(arg, "--frames") == 0) frames = atoi(value);
+        else if (strcmp(arg, "--warmup") == 0) warmup = atoi(value);
+        else if (strcmp(arg, "--width") == 0) width = atoi(value);
+        else if (strcmp(arg, "--height") == 0) height = atoi(value);
+        else if (strcmp(arg, "--flags") == 0) flagList = value;
+        else if (strcmp(arg, "--format") == 0) format = value;
+        else if (strcmp(arg, "--output") == 0) output = value;
+        else { usage(); return 1; }
+        i++;
+    }
+
+    R3D_Flags flags = 0;
+    if (frames <= 0 || warmup < 0 || width <= 0 || height <= 0 || !parse_flags(flagList, &flags)) {
+        usage();
+        return 1;
+    }
+
+    // The window is hidden and not synchronized, frames are rendered as fast as possible
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, "[r3d] - Benchmark");
+    SetTargetFPS(0);
+
+    bench_result_t results[SCENE_COUNT];
+    int count = 0;
+
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        if (strcmp(sceneName, "all") != 0 && strcmp(sceneName, SCENES[i].name) != 0) continue;
+        fprintf(stderr, "r3d_bench: %s...\n", SCENES[i].name);
+        results[count++] = run_scene(&SCENES[i], width, height, flags, warmup, frames);
+    }
+
+    CloseWindow();
+
+    if (count == 0) {
+        fprintf(stderr, "r3d_bench: unknown scene '%s'\n", sceneName);
+        usage();
+        return 1;
+    }
+
+    FILE* out = output ? fopen(output, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "r3d_bench: can't open '%s'\n", output);
+        return 1;
+    }
+
+    // The flags are listed with '+' so that they fit in a single CSV field
+    char flagField[256];
+    snprintf(flagField, sizeof(flagField), "%s", flagList);
+    for (char* c = flagField; *c; c++) if (*c == ',') *c = '+';
+
+    if (strcmp(format, "json") == 0) write_json(out, results, count, width, height, flagField);
+    else write_csv(out, results, count, width, height, flagField);
+
+    if (out != stdout) fclose(out);
+
+    return 0;
+}
@@ -0,0 +1,748 @@
+/* microbench.c -- Micro-benchmarks of the R3D CPU kernels.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+// Times the CPU kernels of R3D over fixed sizes, without any window or GL context.
+// The inputs are generated from a fixed seed so that two builds process the same data.
+//
+// The SIMD paths are selected at compile time, so the scalar reference is a second build
+// of this file with R3D_NO_SIMD defined. '--dump' writes the results of the math and
+// culling kernels, '--compare' checks them against a dump of the other build.
+//
+// Built with R3D_MICROBENCH_KERNELS_ONLY, only the math and frustum kernels are run,
+// which only need 'r3d_frustum.c' and raymath.
+//
+// Usage: r3d_microbench [--filter <name>] [--reps N] [--dump <file>] [--compare <file>]
+
+#include "details/r3d_frustum.h"
+#include "details/r3d_math.h"
+
+#ifndef R3D_MICROBENCH_KERNELS_ONLY
+#   include "modules/r3d_draw.h"
+#   include <r3d/r3d_mesh_data.h>
+#   include <r3d/r3d_particles.h>
+#   include <r3d/r3d_curves.h>
+#endif
+
+#include <raymath.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define MB_SEED             1337
+#define MB_DEFAULT_REPS     20
+
+#define MB_MATRIX_COUNT     65536       //< Matrices multiplied per repetition
+#define MB_BOX_COUNT        65536       //< Boxes tested per repetition
+#define MB_SORT_CALLS       16384       //< Draw calls sorted per repetition
+#define MB_SORT_GROUPS      2048        //< Groups sharing the sorted draw calls
+#define MB_CURVE_SAMPLES    1048576     //< Curve evaluations per repetition
+#define MB_PARTICLES        65536       //< Particles alive during the update
+
+#define MB_FLOAT_TOLERANCE  1e-5f       //< Relative tolerance between two builds
+#define MB_PLANE_MARGIN     1e-3f       //< Boxes closer to a plane are not compared, FMA may round them either way
+
+// ========================================
+// TYPES
+// ========================================
+
+typedef struct {
+    const char* name;
+    int items;                  //< Items processed by one repetition, for the time per item
+    void (*setup)(void);
+    void (*run)(void);
+    void (*cleanup)(void);
+} mb_kernel_t;
+
+// ========================================
+// UTILITY FUNCTIONS
+// ========================================
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec * 1e-6;
+}
+
+static uint32_t mbRandom = MB_SEED;
+
+static float random_float(float min, float max)
+{
+    // xorshift32, the inputs must not depend on the C library
+    mbRandom ^= mbRandom << 13;
+    mbRandom ^= mbRandom >> 17;
+    mbRandom ^= mbRandom << 5;
+    return min + (max - min) * ((mbRandom >> 8) * (1.0f / 16777216.0f));
+}
+
+static Matrix random_transform(float range)
+{
+    Vector3 axis = Vector3Normalize((Vector3) {
+        random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f), random_float(0.1f, 1.0f)
+    });
+
+    Matrix scale = MatrixScale(random_float(0.5f, 2.0f), random_float(0.5f, 2.0f), random_float(0.5f, 2.0f));
+    Matrix rotate = MatrixRotate(axis, random_float(-PI, PI));
+    Matrix translate = MatrixTranslate(
+        random_float(-range, range), random_float(-range * 0.25f, range * 0.25f), random_float(-range, range)
+    );
+
+    return MatrixMultiply(MatrixMultiply(scale, rotate), translate);
+}
+
+static BoundingBox random_box(void)
+{
+    Vector3 size = { random_float(0.1f, 4.0f), random_float(0.1f, 4.0f), random_float(0.1f, 4.0f) };
+    return (BoundingBox) {
+        .min = Vector3Scale(size, -0.5f),
+        .max = Vector3Scale(size, 0.5f)
+    };
+}
+
+/*
+ * Distance of an oriented box to the nearest decision boundary of the frustum test.
+ * The results of two builds may only differ below a few ulps of this distance.
+ */
+static float box_plane_margin(const r3d_frustum_t* frustum, const BoundingBox* aabb, const Matrix* transform)
+{
+    Vector3 center = Vector3Scale(Vector3Add(aabb->min, aabb->max), 0.5f);
+    Vector3 extent = Vector3Scale(Vector3Subtract(aabb->max, aabb->min), 0.5f);
+    Vector3 world = Vector3Transform(center, *transform);
+
+    float margin = INFINITY;
+
+    for (int i = 0; i < R3D_PLANE_COUNT; i++) {
+        const Vector4* p = &frustum->planes[i];
+        double d = (double)p->x * world.x + (double)p->y * world.y + (double)p->z * world.z + p->w;
+        d += fabs((double)p->x * transform->m0 + (double)p->y * transform->m1 + (double)p->z * transform->m2) * extent.x;
+        d += fabs((double)p->x * transform->m4 + (double)p->y * transform->m5 + (double)p->z * transform->m6) * extent.y;
+        d += fabs((double)p->x * transform->m8 + (double)p->y * transform->m9 + (double)p->z * transform->m10) * extent.z;
+        margin = fminf(margin, (float)fabs(d));
+    }
+
+    return margin;
+}
+
+// ========================================
+// MATH KERNELS
+// ========================================
+
+static Matrix* mbLeft;
+static Matrix* mbRight;
+static Matrix* mbResult;
+
+static void matrix_setup(void)
+{
+    mbLeft = malloc(MB_MATRIX_COUNT * sizeof(Matrix));
+    mbRight = malloc(MB_MATRIX_COUNT * sizeof(Matrix));
+    mbResult = malloc(MB_MATRIX_COUNT * sizeof(Matrix));
+
+    mbRandom = MB_SEED;
+    for (int i = 0; i < MB_MATRIX_COUNT; i++) {
+        mbLeft[i] = random_transform(100.0f);
+        mbRight[i] = random_transform(100.0f);
+    }
+}
+
+static void matrix_cleanup(void)
+{
+    free(mbLeft);
+    free(mbRight);
+    free(mbResult);
+}
+
+static void matrix_multiply_run(void)
+{
+    for (int i = 0; i < MB_MATRIX_COUNT; i++) {
+        mbResult[i] = r3d_matrix_multiply(&mbLeft[i], &mbRight[i]);
+    }
+}
+
+static void matrix_multiply_batch_run(void)
+{
+    r3d_matrix_multiply_batch(mbResult, mbLeft, mbRight, MB_MATRIX_COUNT);
+}
+
+// ========================================
+// FRUSTUM KERNELS
+// ========================================
+
+static r3d_frustum_t mbFrustum;
+static BoundingBox* mbBoxes;
+static Matrix* mbTransforms;
+static r3d_frustum_boxes_t mbWorldBoxes;
+static uint32_t* mbVisibility;
+static int mbVisibleCount;
+
+static void store_world_box(int index)
+{
+    Vector3 center, extent;
+    r3d_frustum_get_world_box(&mbBoxes[index], &mbTransforms[index], &center, &extent);
+
+    mbWorldBoxes.centerX[index] = center.x;
+    mbWorldBoxes.centerY[index] = center.y;
+    mbWorldBoxes.centerZ[index] = center.z;
+    mbWorldBoxes.extentX[index] = extent.x;
+    mbWorldBoxes.extentY[index] = extent.y;
+    mbWorldBoxes.extentZ[index] = extent.z;
+}
+
+/*
+ * Box of the given index moved by the translation of its transform, for the AABB test.
+ */
+static BoundingBox translated_box(int index)
+{
+    Vector3 offset = { mbTransforms[index].m12, mbTransforms[index].m13, mbTransforms[index].m14 };
+    return (BoundingBox) {
+        Vector3Add(mbBoxes[index].min, offset),
+        Vector3Add(mbBoxes[index].max, offset)
+    };
+}
+
+static void frustum_setup(void)
+{
+    Matrix view = MatrixLookAt((Vector3) { 0, 20, -60 }, (Vector3) { 0, 0, 0 }, (Vector3) { 0, 1, 0 });
+    Matrix proj = MatrixPerspective(60.0 * DEG2RAD, 16.0 / 9.0, 0.1, 150.0);
+    mbFrustum = r3d_frustum_create(MatrixMultiply(view, proj));
+
+    mbBoxes = malloc(MB_BOX_COUNT * sizeof(BoundingBox));
+    mbTransforms = malloc(MB_BOX_COUNT * sizeof(Matrix));
+    mbVisibility = malloc(((MB_BOX_COUNT + 31) / 32) * sizeof(uint32_t));
+
+    float* soa = malloc(6 * MB_BOX_COUNT * sizeof(float));
+    mbWorldBoxes = (r3d_frustum_boxes_t) {
+        soa + 0 * MB_BOX_COUNT, soa + 1 * MB_BOX_COUNT, soa + 2 * MB_BOX_COUNT,
+        soa + 3 * MB_BOX_COUNT, soa + 4 * MB_BOX_COUNT, soa + 5 * MB_BOX_COUNT
+    };
+
+    mbRandom = MB_SEED;
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        mbBoxes[i] = random_box();
+        mbTransforms[i] = random_transform(120.0f);
+
+        store_world_box(i);
+    }
+}
+
+static void frustum_cleanup(void)
+{
+    free(mbBoxes);
+    free(mbTransforms);
+    free(mbVisibility);
+    free(mbWorldBoxes.centerX);
+}
+
+static void frustum_aabb_run(void)
+{
+    int visible = 0;
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        BoundingBox box = translated_box(i);
+        visible += r3d_frustum_is_aabb_in(&mbFrustum, &box);
+    }
+    mbVisibleCount = visible;
+}
+
+static void frustum_obb_run(void)
+{
+    int visible = 0;
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        visible += r3d_frustum_is_obb_in(&mbFrustum, &mbBoxes[i], &mbTransforms[i]);
+    }
+    mbVisibleCount = visible;
+}
+
+static void frustum_world_box_run(void)
+{
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        store_world_box(i);
+    }
+}
+
+static void frustum_cull_boxes_run(void)
+{
+    r3d_frustum_cull_boxes(&mbFrustum, &mbWorldBoxes, MB_BOX_COUNT, mbVisibility);
+}
+
+#ifndef R3D_MICROBENCH_KERNELS_ONLY
+
+// ========================================
+// DRAW LIST KERNELS
+// ========================================
+
+static R3D_Material* mbMaterials;
+static int* mbSubmitOrder;
+
+/*
+ * Fills the draw module by hand, as 'r3d_draw_init()' would create GL buffers.
+ * The calls share a few materials and meshes, like the props of a real scene.
+ */
+static void sort_setup(void)
+{
+    memset(&R3D_MOD_DRAW, 0, sizeof(R3D_MOD_DRAW));
+
+    R3D_MOD_DRAW.groups = calloc(MB_SORT_GROUPS, sizeof(*R3D_MOD_DRAW.groups));
+    R3D_MOD_DRAW.calls = calloc(MB_SORT_CALLS, sizeof(*R3D_MOD_DRAW.calls));
+    R3D_MOD_DRAW.groupIndices = malloc(MB_SORT_CALLS * sizeof(int));
+    R3D_MOD_DRAW.sortKeys = malloc(MB_SORT_CALLS * sizeof(uint64_t));
+    R3D_MOD_DRAW.sortKeysTmp = malloc(MB_SORT_CALLS * sizeof(uint64_t));
+    R3D_MOD_DRAW.sortValuesTmp = malloc(MB_SORT_CALLS * sizeof(int));
+    R3D_MOD_DRAW.list[R3D_DRAW_DEFERRED].calls = malloc(MB_SORT_CALLS * sizeof(int));
+    R3D_MOD_DRAW.numGroups = MB_SORT_GROUPS;
+    R3D_MOD_DRAW.numCalls = MB_SORT_CALLS;
+    R3D_MOD_DRAW.capacity = MB_SORT_CALLS;
+
+    mbMaterials = calloc(64, sizeof(R3D_Material));
+    mbSubmitOrder = malloc(MB_SORT_CALLS * sizeof(int));
+
+    mbRandom = MB_SEED;
+
+    for (int i = 0; i < 64; i++) {
+        // The shaders are only hashed by address, they are never dereferenced
+        mbMaterials[i].shader = (i % 8 == 0) ? (R3D_Shader*)(uintptr_t)(0x10000 * (i / 8 + 1)) : NULL;
+        mbMaterials[i].albedo.texture.id = 1 + i % 24;
+        mbMaterials[i].normal.texture.id = 32 + i % 16;
+        mbMaterials[i].orm.texture.id = 64 + i % 12;
+    }
+
+    for (int i = 0; i < MB_SORT_GROUPS; i++) {
+        R3D_MOD_DRAW.groups[i].transform = random_transform(200.0f);
+    }
+
+    for (int i = 0; i < MB_SORT_CALLS; i++) {
+        r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[i];
+        call->material = &mbMaterials[(int)random_float(0.0f, 64.0f) & 63];
+        call->mesh.vao = 1 + ((int)random_float(0.0f, 256.0f) & 255);
+        call->mesh.aabb = random_box();
+        R3D_MOD_DRAW.groupIndices[i] = (i * MB_SORT_GROUPS) / MB_SORT_CALLS;
+        mbSubmitOrder[i] = i;
+    }
+}
+
+static void sort_cleanup(void)
+{
+    free(R3D_MOD_DRAW.groups);
+    free(R3D_MOD_DRAW.calls);
+    free(R3D_MOD_DRAW.groupIndices);
+    free(R3D_MOD_DRAW.sortKeys);
+    free(R3D_MOD_DRAW.sortKeysTmp);
+    free(R3D_MOD_DRAW.sortValuesTmp);
+    free(R3D_MOD_DRAW.list[R3D_DRAW_DEFERRED].calls);
+    memset(&R3D_MOD_DRAW, 0, sizeof(R3D_MOD_DRAW));
+
+    free(mbMaterials);
+    free(mbSubmitOrder);
+}
+
+static void sort_run(r3d_draw_sort_enum_t mode)
+{
+    // Each repetition sorts the submission order, not the result of the previous one
+    r3d_draw_list_t* list = &R3D_MOD_DRAW.list[R3D_DRAW_DEFERRED];
+    memcpy(list->calls, mbSubmitOrder, MB_SORT_CALLS * sizeof(int));
+    list->numCalls = MB_SORT_CALLS;
+
+    r3d_draw_sort_list(R3D_DRAW_DEFERRED, (Vector3) { 10, 5, -40 }, mode);
+}
+
+static void sort_front_to_back_run(void) { sort_run(R3D_DRAW_SORT_FRONT_TO_BACK); }
+static void sort_back_to_front_run(void) { sort_run(R3D_DRAW_SORT_BACK_TO_FRONT); }
+static void sort_state_run(void) { sort_run(R3D_DRAW_SORT_STATE); }
+
+// ========================================
+// CURVE KERNELS
+// ========================================
+
+static R3D_InterpolationCurve mbCurve;
+static float mbCurveSum;
+
+static void curve_setup(void)
+{
+    mbCurve = R3D_LoadInterpolationCurve(16);
+
+    mbRandom = MB_SEED;
+    for (int i = 0; i < 16; i++) {
+        R3D_AddKeyframe(&mbCurve, i / 15.0f, random_float(0.0f, 1.0f));
+    }
+}
+
+static void curve_baked_setup(void)
+{
+    curve_setup();
+    R3D_BakeCurve(&mbCurve, 256);
+}
+
+static void curve_cleanup(void)
+{
+    R3D_UnloadInterpolationCurve(mbCurve);
+}
+
+static void curve_evaluate_run(void)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < MB_CURVE_SAMPLES; i++) {
+        sum += R3D_EvaluateCurve(mbCurve, i * (1.0f / MB_CURVE_SAMPLES));
+    }
+    mbCurveSum = sum;
+}
+
+// ========================================
+// PARTICLE KERNELS
+// ========================================
+
+static R3D_ParticleSystem mbParticles;
+static R3D_InterpolationCurve mbParticleCurve;
+
+static void particles_setup(void)
+{
+    SetRandomSeed(MB_SEED);
+
+    mbParticles = R3D_LoadParticleSystemEx(MB_PARTICLES, R3D_PARTICLE_MODE_CPU);
+    mbParticles.lifetime = 1e6f;
+    mbParticles.emissionRate = MB_PARTICLES;
+    mbParticles.initialVelocity = (Vector3) { 0, 5, 0 };
+    mbParticles.velocityVariance = (Vector3) { 2, 2, 2 };
+    mbParticles.angularVelocityVariance = (Vector3) { 90, 90, 90 };
+    mbParticles.spreadAngle = 30.0f;
+
+    mbParticleCurve = R3D_LoadInterpolationCurve(2);
+    R3D_AddKeyframe(&mbParticleCurve, 0.0f, 1.0f);
+    R3D_AddKeyframe(&mbParticleCurve, 1.0f, 0.0f);
+    mbParticles.scaleOverLifetime = &mbParticleCurve;
+
+    // Fills the system once, the repetitions then only update it
+    R3D_UpdateParticleSystem(&mbParticles, 1.0f);
+    mbParticles.autoEmission = false;
+}
+
+static void particles_cleanup(void)
+{
+    R3D_UnloadParticleSystem(&mbParticles);
+    R3D_UnloadInterpolationCurve(mbParticleCurve);
+}
+
+static void particles_update_run(void)
+{
+    R3D_UpdateParticleSystem(&mbParticles, 1.0f / 60.0f);
+}
+
+// ========================================
+// MESH DATA KERNELS
+// ========================================
+
+static void mesh_sphere_run(void)
+{
+    R3D_MeshData data = R3D_GenMeshDataSphere(1.0f, 128, 128);
+    R3D_UnloadMeshData(&data);
+}
+
+static void mesh_plane_run(void)
+{
+    R3D_MeshData data = R3D_GenMeshDataPlane(100.0f, 100.0f, 256, 256);
+    R3D_UnloadMeshData(&data);
+}
+
+static void mesh_torus_run(void)
+{
+    R3D_MeshData data = R3D_GenMeshDataTorus(1.0f, 0.5f, 128, 64);
+    R3D_UnloadMeshData(&data);
+}
+
+static void mesh_knot_run(void)
+{
+    R3D_MeshData data = R3D_GenMeshDataKnot(1.0f, 0.5f, 256, 64);
+    R3D_UnloadMeshData(&data);
+}
+
+static R3D_MeshData mbMeshData;
+
+static void mesh_tangents_setup(void)
+{
+    mbMeshData = R3D_GenMeshDataSphere(1.0f, 128, 128);
+}
+
+static void mesh_tangents_cleanup(void)
+{
+    R3D_UnloadMeshData(&mbMeshData);
+}
+
+static void mesh_tangents_run(void)
+{
+    R3D_GenMeshDataTangents(&mbMeshData);
+}
+
+#endif // R3D_MICROBENCH_KERNELS_ONLY
+
+// ========================================
+// KERNEL LIST
+// ========================================
+
+static const mb_kernel_t KERNELS[] = {
+    { "matrix_multiply",        MB_MATRIX_COUNT,    matrix_setup,       matrix_multiply_run,        matrix_cleanup },
+    { "matrix_multiply_batch",  MB_MATRIX_COUNT,    matrix_setup,       matrix_multiply_batch_run,  matrix_cleanup },
+    { "frustum_aabb",           MB_BOX_COUNT,       frustum_setup,      frustum_aabb_run,           frustum_cleanup },
+    { "frustum_obb",            MB_BOX_COUNT,       frustum_setup,      frustum_obb_run,            frustum_cleanup },
+    { "frustum_world_box",      MB_BOX_COUNT,       frustum_setup,      frustum_world_box_run,      frustum_cleanup },
+    { "frustum_cull_boxes",     MB_BOX_COUNT,       frustum_setup,      frustum_cull_boxes_run,     frustum_cleanup },
+#ifndef R3D_MICROBENCH_KERNELS_ONLY
+    { "sort_front_to_back",     MB_SORT_CALLS,      sort_setup,         sort_front_to_back_run,     sort_cleanup },
+    { "sort_back_to_front",     MB_SORT_CALLS,      sort_setup,         sort_back_to_front_run,     sort_cleanup },
+    { "sort_state",             MB_SORT_CALLS,      sort_setup,         sort_state_run,             sort_cleanup },
+    { "curve_evaluate",         MB_CURVE_SAMPLES,   curve_setup,        curve_evaluate_run,         curve_cleanup },
+    { "curve_evaluate_baked",   MB_CURVE_SAMPLES,   curve_baked_setup,  curve_evaluate_run,         curve_cleanup },
+    { "particles_update",       MB_PARTICLES,       particles_setup,    particles_update_run,       particles_cleanup },
+    { "mesh_gen_sphere",        129 * 129,          NULL,               mesh_sphere_run,            NULL },
+    { "mesh_gen_plane",         257 * 257,          NULL,               mesh_plane_run,             NULL },
+    { "mesh_gen_torus",         129 * 65,           NULL,               mesh_torus_run,             NULL },
+    { "mesh_gen_knot",          257 * 65,           NULL,               mesh_knot_run,              NULL },
+    { "mesh_gen_tangents",      129 * 129,          mesh_tangents_setup, mesh_tangents_run,         mesh_tangents_cleanup },
+#endif
+};
+
+#define KERNEL_COUNT (int)(sizeof(KERNELS) / sizeof(*KERNELS))
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_kernel(const mb_kernel_t* kernel, int reps)
+{
+    double* times = malloc(reps * sizeof(double));
+
+    if (kernel->setup) kernel->setup();
+    kernel->run(); // Warm up the caches and the allocator
+
+    for (int i = 0; i < reps; i++) {
+        double start = now_ms();
+        kernel->run();
+        times[i] = now_ms() - start;
+    }
+
+    if (kernel->cleanup) kernel->cleanup();
+
+    qsort(times, reps, sizeof(double), compare_doubles);
+
+    double median = times[reps / 2];
+    printf("%-24s %10.4f %10.4f %10.2f\n", kernel->name, times[0], median, median * 1e6 / kernel->items);
+
+    free(times);
+}
+
+// ========================================
+// CROSS-CHECK
+// ========================================
+
+/*
+ * Results of the math and culling kernels, in a fixed order.
+ * The visibility of a box is stored with its margin to the planes.
+ */
+typedef struct {
+    float* values;
+    float* margins;             //< Margin of each value, negative for the float results
+    int count;
+} mb_results_t;
+
+static void results_push(mb_results_t* results, float value, float margin)
+{
+    results->values[results->count] = value;
+    results->margins[results->count] = margin;
+    results->count++;
+}
+
+static mb_results_t collect_results(void)
+{
+    int capacity = 2 * 16 * MB_MATRIX_COUNT + 4 * MB_BOX_COUNT;
+
+    mb_results_t results = {
+        .values = malloc(capacity * sizeof(float)),
+        .margins = malloc(capacity * sizeof(float)),
+    };
+
+    matrix_setup();
+    matrix_multiply_run();
+    for (int i = 0; i < MB_MATRIX_COUNT; i++) {
+        for (int j = 0; j < 16; j++) results_push(&results, ((float*)&mbResult[i])[j], -1.0f);
+    }
+    matrix_multiply_batch_run();
+    for (int i = 0; i < MB_MATRIX_COUNT; i++) {
+        for (int j = 0; j < 16; j++) results_push(&results, ((float*)&mbResult[i])[j], -1.0f);
+    }
+    matrix_cleanup();
+
+    frustum_setup();
+    frustum_cull_boxes_run();
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        BoundingBox moved = translated_box(i);
+        Matrix translate = MatrixTranslate(mbTransforms[i].m12, mbTransforms[i].m13, mbTransforms[i].m14);
+        BoundingBox world = {
+            { mbWorldBoxes.centerX[i] - mbWorldBoxes.extentX[i], mbWorldBoxes.centerY[i] - mbWorldBoxes.extentY[i], mbWorldBoxes.centerZ[i] - mbWorldBoxes.extentZ[i] },
+            { mbWorldBoxes.centerX[i] + mbWorldBoxes.extentX[i], mbWorldBoxes.centerY[i] + mbWorldBoxes.extentY[i], mbWorldBoxes.centerZ[i] + mbWorldBoxes.extentZ[i] }
+        };
+
+        results_push(&results, r3d_frustum_is_aabb_in(&mbFrustum, &moved), box_plane_margin(&mbFrustum, &mbBoxes[i], &translate));
+        results_push(&results, r3d_frustum_is_obb_in(&mbFrustum, &mbBoxes[i], &mbTransforms[i]), box_plane_margin(&mbFrustum, &mbBoxes[i], &mbTransforms[i]));
+        results_push(&results, (mbVisibility[i / 32] >> (i % 32)) & 1, box_plane_margin(&mbFrustum, &world, &R3D_MATRIX_IDENTITY));
+        results_push(&results, mbWorldBoxes.extentX[i] + mbWorldBoxes.extentY[i] + mbWorldBoxes.extentZ[i], -1.0f);
+    }
+    frustum_cleanup();
+
+    return results;
+}
+
+static bool values_match(float a, float b, float margin)
+{
+    if (margin >= 0.0f) {
+        return (a == b) || (margin < MB_PLANE_MARGIN);
+    }
+    return fabsf(a - b) <= MB_FLOAT_TOLERANCE * fmaxf(1.0f, fmaxf(fabsf(a), fabsf(b)));
+}
+
+static int dump_results(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot open '%s'\n", path);
+        return 1;
+    }
+
+    mb_results_t results = collect_results();
+
+    fprintf(file, "%d\n", results.count);
+    for (int i = 0; i < results.count; i++) {
+        fprintf(file, "%.9g\n", results.values[i]);
+    }
+
+    fclose(file);
+    free(results.values);
+    free(results.margins);
+
+    printf("Wrote %d results to '%s'\n", results.count, path);
+
+    return 0;
+}
+
+static int compare_results(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open '%s'\n", path);
+        return 1;
+    }
+
+    mb_results_t results = collect_results();
+
+    int count = 0, mismatches = 0;
+    if (fscanf(file, "%d", &count) != 1 || count != results.count) {
+        fprintf(stderr, "'%s' holds %d results, expected %d\n", path, count, results.count);
+        mismatches = 1;
+    }
+
+    for (int i = 0; i < results.count && !mismatches; i++) {
+        float reference = 0.0f;
+        if (fscanf(file, "%f", &reference) != 1) {
+            fprintf(stderr, "'%s' is truncated at result %d\n", path, i);
+            mismatches = 1;
+            break;
+        }
+        if (!values_match(reference, results.values[i], results.margins[i])) {
+            if (mismatches < 16) fprintf(stderr, "Result %d: %.9g, expected %.9g\n", i, results.values[i], reference);
+            mismatches++;
+        }
+    }
+
+    // The world box encloses the OBB, the batched culling can't reject a box the OBB test accepts
+    int offset = 2 * 16 * MB_MATRIX_COUNT;
+    for (int i = 0; i < MB_BOX_COUNT; i++) {
+        const float* v = &results.values[offset + 4 * i];
+        const float* m = &results.margins[offset + 4 * i];
+        if (v[1] > v[2] && fminf(m[1], m[2]) >= MB_PLANE_MARGIN) {
+            if (mismatches < 16) fprintf(stderr, "Box %d: culled by the batch but visible as an OBB\n", i);
+            mismatches++;
+        }
+    }
+
+    fclose(file);
+    free(results.values);
+    free(results.margins);
+
+    if (mismatches > 0) {
+        fprintf(stderr, "%d results differ from '%s'\n", mismatches, path);
+        return 1;
+    }
+
+    printf("All %d results match '%s'\n", results.count, path);
+
+    return 0;
+}
+
+// ========================================
+// MAIN
+// ========================================
+
+static const char* simd_path_name(void)
+{
+#if defined(R3D_HAS_FMA_AVX)
+    return "FMA+AVX";
+#elif defined(R3D_HAS_AVX)
+    return "AVX";
+#elif defined(R3D_HAS_SSE42)
+    return "SSE4.2";
+#elif defined(R3D_HAS_SSE41)
+    return "SSE4.1";
+#elif defined(R3D_HAS_SSE)
+    return "SSE";
+#elif defined(R3D_HAS_NEON_FMA)
+    return "NEON+FMA";
+#elif defined(R3D_HAS_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = NULL;
+    const char* dumpPath = NULL;
+    const char* comparePath = NULL;
+    int reps = MB_DEFAULT_REPS;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "--reps") && i + 1 < argc) reps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--dump") && i + 1 < argc) dumpPath = argv[++i];
+        else if (!strcmp(argv[i], "--compare") && i + 1 < argc) comparePath = argv[++i];
+        else {
+            fprintf(stderr, "Usage: %s [--filter <name>] [--reps N] [--dump <file>] [--compare <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (reps < 1) reps = 1;
+
+    if (dumpPath) return dump_results(dumpPath);
+    if (comparePath) return compare_results(comparePath);
+
+    printf("SIMD path: %s, %d repetitions\n", simd_path_name(), reps);
+    printf("%-24s %10s %10s %10s\n", "kernel", "min ms", "median ms", "ns/item");
+
+    for (int i = 0; i < KERNEL_COUNT; i++) {
+        if (filter && !strstr(KERNELS[i].name, filter)) continue;
+        run_kernel(&KERNELS[i], reps);
+    }
+
+    return 0;
+}
@@ -45,6 +45,10 @@ int main(void)
         colors[i] = ColorFromHSV((float)GetRandomValue(0, 360000) / 1000, 1.0f, 1.0f);
     }
 
+    // Upload the instances once, they are reused by every frame
+    R3D_InstanceBuffer instances = R3D_LoadInstanceBuffer(INSTANCE_COUNT, R3D_INSTANCE_COLOR, R3D_STATIC_INSTANCES);
+    R3D_UploadInstances(&instances, 0, INSTANCE_COUNT, transforms, colors);
+
     // Setup directional light
     R3D_Light light = R3D_CreateLight(R3D_LIGHT_DIR);
     R3D_SetLightDirection(light, (Vector3){0, -1, 0});
@@ -70,7 +74,7 @@ int main(void)
             ClearBackground(RAYWHITE);
 
             R3D_Begin(camera);
-                R3D_DrawMeshInstancedEx(&mesh, &material, transforms, colors, INSTANCE_COUNT);
+                R3D_DrawMeshInstanceBuffer(&mesh, &material, &instances);
             R3D_End();
 
             DrawFPS(10, 10);
@@ -78,6 +82,7 @@ int main(void)
     }
 
     // Cleanup
+    R3D_UnloadInstanceBuffer(&instances);
     R3D_UnloadMesh(&mesh);
     R3D_UnloadMaterial(&material);
     R3D_Close();
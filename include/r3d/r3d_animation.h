@@ -28,11 +28,18 @@
  *
  * Represents a single animated property (translation, rotation or scale).
  * Keys are sampled by time and interpolated at runtime.
+ *
+ * Tracks imported with compression store their values on 16 bits per component,
+ * see `R3D_SetAnimationCompression()`. Vector3 values are normalized in the range
+ * of the track and quaternions are stored in smallest-three form, 6 bytes per key.
  */
 typedef struct R3D_AnimationTrack {
     const float* times;   ///< Keyframe times (sorted, in animation ticks).
-    const void*  values;  ///< Keyframe values (Vector3 or Quaternion).
+    const void*  values;  ///< Keyframe values (Vector3 or Quaternion), packed if the track is quantized.
     int          count;   ///< Number of keyframes.
+    bool         quantized; ///< True if the values are packed on 16 bits per component.
+    Vector3      rangeMin;  ///< Minimum of the quantized Vector3 values.
+    Vector3      rangeSize; ///< Extent of the quantized Vector3 values.
 } R3D_AnimationTrack;
 
 /**
@@ -87,6 +94,20 @@ typedef struct R3D_AnimationState {
     bool loop;          ///< True to enable looping playback.
 } R3D_AnimationState;
 
+/**
+ * @brief Level of detail policy of an animation player.
+ *
+ * The renderer records the screen size of each player it draws, as a fraction of the
+ * screen height like the mesh levels of detail. The next update of the player then
+ * skips the work its policy allows. A zeroed policy always evaluates the full pose.
+ */
+typedef struct R3D_AnimationLod {
+    float reducedSize;  ///< Below this screen size, the pose is evaluated at 'reducedRate' and interpolated in between (0 disables).
+    float reducedRate;  ///< Pose evaluations per second of the reduced players.
+    float leafSize;     ///< Below this screen size, the bones without children keep their bind pose (0 disables).
+    bool freezeCulled;  ///< Keep the pose of the players not drawn by the last frame, their time still advances.
+} R3D_AnimationLod;
+
 /**
  * @brief Controls playback and blending of animations for a skeleton.
  *
@@ -102,9 +123,36 @@ typedef struct R3D_AnimationPlayer {
     R3D_Skeleton skeleton;              ///< Target skeleton to animate.
     Matrix* localPose;                  ///< Array of bone transforms representing the blended pose.
     Matrix* globalPose;                 ///< Array of bone transforms containing the boneOffsets*localPose.
-    uint32_t texGlobalPose;             ///< Texture ID that contains the global pose for GPU skinning. This is a 1D Texture RGBA32F 4*boneCount.
+    int* channelMap;                    ///< Channel index of each bone in each animation (animation * boneCount + bone), -1 if not animated.
+    Matrix* rootParentPose;             ///< Scene transform of the parent of each root bone, from the bind pose. Identity for the other bones.
+    uint32_t* keyCursors;               ///< Last key sampled in the translation, rotation and scale tracks of each channel, indexed like `channelMap`.
+    int poseOffset;                     ///< Offset of the global pose in the bone palette shared by all the players, in matrices.
+    R3D_AnimationLod lod;               ///< Level of detail policy applied by the updates, disabled by default.
+    float lodScreenSize;                ///< Largest screen size of the player in the last frame drawing it (written by the renderer).
+    uint32_t lodFrame;                  ///< Frame in which 'lodScreenSize' was recorded (written by the renderer).
+    bool* leafBones;                    ///< True for the bones without children.
+    bool skipLeafBones;                 ///< The leaf bones keep their bind pose in the next evaluations (internal).
+    Matrix* reducedPoses;               ///< Two last poses evaluated at the reduced rate, interpolated by the updates (internal).
+    float reducedElapsed;               ///< Time since the last reduced evaluation, negative if none (internal).
 } R3D_AnimationPlayer;
 
+/**
+ * @brief Animations of a library pre-sampled at a fixed frame rate.
+ *
+ * The poses of every frame are stored in the bone palette, after a small table describing
+ * each animation. Instances drawn with `R3D_INSTANCE_ANIMATION` select an animation and a
+ * time per instance, and their pose is read from the nearest baked frame on the GPU,
+ * without any CPU work per instance.
+ */
+typedef struct R3D_BakedAnimationLib {
+    int count;                          ///< Number of baked animations, in the order of the animation library.
+    int boneCount;                      ///< Number of bones of each baked pose.
+    int frameCount;                     ///< Total number of frames baked for all the animations.
+    float frameRate;                    ///< Frames baked per second of animation.
+    int poseOffset;                     ///< Offset of the animation table in the bone palette, in matrices. Negative if not baked.
+    int matrixCount;                    ///< Number of matrices reserved in the bone palette, table included.
+} R3D_BakedAnimationLib;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -219,12 +267,61 @@ R3DAPI void R3D_CalculateAnimationPlayerPose(R3D_AnimationPlayer* player);
  * @note If the sum of animation state weights is less than or equal to 0.0,
  *       the bind pose will be used as the current pose.
  * @note The total sum of animation state weights is the responsibility of the user.
+ * @note Unlike `R3D_CalculateAnimationPlayerPose`, the pose follows the `lod` policy of the player.
  *
  * @param player Pointer to the animation player.
  * @param dt Delta time to advance, in seconds.
  */
 R3DAPI void R3D_UpdateAnimationPlayer(R3D_AnimationPlayer* player, float dt);
 
+/**
+ * @brief Updates several animation players at once, like `R3D_UpdateAnimationPlayer` for each of them.
+ *
+ * The poses are calculated and the times advanced on worker threads when there are enough
+ * players to share, then all the poses are uploaded from the calling thread, which must own
+ * the OpenGL context. The players must be distinct, but can share skeletons and libraries.
+ *
+ * @param players Array of pointers to the animation players.
+ * @param count Number of players in the array.
+ * @param dt Delta time to advance, in seconds.
+ */
+R3DAPI void R3D_UpdateAnimationPlayers(R3D_AnimationPlayer** players, int count, float dt);
+
+// ----------------------------------------
+// ANIMATION: Baked Animation Functions
+// ----------------------------------------
+
+/**
+ * @brief Samples all the animations of a library into the bone palette.
+ *
+ * Each animation is evaluated alone at `frameRate` frames per second, over its whole duration.
+ * The baked library is drawn through the `bakedAnimations` field of a model, with an instance
+ * buffer created with `R3D_INSTANCE_ANIMATION`.
+ *
+ * @param skeleton Pointer to the skeleton animated by the library.
+ * @param animLib Pointer to the animation library to bake.
+ * @param frameRate Number of frames sampled per second, must be greater than 0.
+ * @param loop True to wrap the time of the instances, false to hold the last frame.
+ * @return Baked animation library, invalid on failure.
+ * @note Free the baked library using R3D_UnloadBakedAnimationLib().
+ */
+R3DAPI R3D_BakedAnimationLib R3D_BakeAnimationLib(const R3D_Skeleton* skeleton, const R3D_AnimationLib* animLib, float frameRate, bool loop);
+
+/**
+ * @brief Releases the frames of a baked animation library from the bone palette.
+ *
+ * @param baked Pointer to the baked animation library to unload.
+ */
+R3DAPI void R3D_UnloadBakedAnimationLib(R3D_BakedAnimationLib* baked);
+
+/**
+ * @brief Check if a baked animation library is valid.
+ *
+ * @param baked Pointer to the baked animation library to check.
+ * @return true if its frames are stored in the bone palette, false otherwise.
+ */
+R3DAPI bool R3D_IsBakedAnimationLibValid(const R3D_BakedAnimationLib* baked);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
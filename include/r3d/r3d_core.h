@@ -11,6 +11,7 @@
 
 #include "./r3d_platform.h"
 #include <raylib.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
@@ -35,7 +36,16 @@ typedef uint32_t R3D_Flags;
 #define R3D_FLAG_ASPECT_KEEP            (1 << 2)    ///< Maintains the aspect ratio of the internal resolution when blitting the final image
 #define R3D_FLAG_NO_FRUSTUM_CULLING     (1 << 3)    ///< Disables internal frustum culling. Manual culling is allowed, but may break shadow visibility if objects casting shadows are skipped.
 #define R3D_FLAG_TRANSPARENT_SORTING    (1 << 4)    ///< Back-to-front sorting of transparent objects for correct blending of non-discarded fragments. Be careful, in 'force forward' mode this flag will also sort opaque objects in 'near-to-far' but in the same sorting pass.
-#define R3D_FLAG_OPAQUE_SORTING         (1 << 5)    ///< Front-to-back sorting of opaque objects to optimize depth testing at the cost of additional sorting. Please note, in 'force forward' mode this flag has no effect, see transparent sorting.
+#define R3D_FLAG_OPAQUE_SORTING         (1 << 5)    ///< Front-to-back sorting of opaque objects to optimize depth testing at the cost of additional sorting. Objects are still grouped by shader, textures and mesh first, front-to-back applies within each group. Please note, in 'force forward' mode this flag has no effect, see transparent sorting.
+#define R3D_FLAG_GPU_INSTANCE_CULLING   (1 << 6)    ///< Culls each instance of large instanced draws with a compute shader, against the frustum of every pass (camera and shadow faces). Requires OpenGL 4.3, ignored otherwise or when frustum culling is disabled.
+#define R3D_FLAG_OCCLUSION_CULLING      (1 << 7)    ///< Skips the draw groups hidden behind the depth of the previous frame, using a hierarchical depth pyramid reprojected on the CPU. Only opaque deferred geometry acts as occluder. The spot and omni lights hidden for a few frames in a row are also culled, shadow updates included. Relies on frustum culling, ignored when it is disabled. Newly uncovered objects may appear one frame late.
+#define R3D_FLAG_TAA                    (1 << 8)    ///< Enables Temporal Anti-Aliasing (TAA), which also reconstructs the full resolution when the scene is rendered at a lower scale, see R3D_SetResolutionScale(). Only the camera motion is reprojected, fast moving objects may look softer. Replaces FXAA when both are set.
+#define R3D_FLAG_COMPACT_GBUFFER        (1 << 9)    ///< Accumulates the deferred lighting into packed 32-bit float buffers (R11G11B10F) instead of 64-bit ones, halving the bandwidth of every light. Lowers the precision of the lighting slightly and drops negative values. Recommended on fill-rate bound GPUs.
+#define R3D_FLAG_GPU_PROFILING          (1 << 10)   ///< Measures the GPU time of each render pass with timestamp queries, read back a few frames later without stalling, see R3D_GetFrameProfile(). Also labels the passes as debug groups when OpenGL 4.3 is available.
+#define R3D_FLAG_DEPTH_PREPASS          (1 << 11)   ///< Renders the depth of the opaque deferred geometry first, then fills the G-buffer with an equal depth test so that each pixel is shaded once. Doubles the vertex work of the deferred geometry, worth it on high overdraw scenes. Objects with custom shaders are left out of the prepass.
+#define R3D_FLAG_WEIGHTED_OIT           (1 << 12)   ///< Blends the alpha transparent forward objects (R3D_TRANSPARENCY_ALPHA with R3D_BLEND_MIX) with weighted blended order-independent transparency: accumulated in any order then resolved over the scene, so intersecting surfaces blend smoothly and the forward objects are grouped by state instead of sorted, R3D_FLAG_TRANSPARENT_SORTING then only applies to the prepass objects. The result approximates the blending, favouring the nearest and most opaque layers.
+#define R3D_FLAG_PRE_SKINNING           (1 << 13)   ///< Skins the animated meshes once per frame with a compute shader, then draws the skinned vertices as static meshes in every pass (shadow maps, prepass, geometry and forward) instead of skinning them again in each one. Requires OpenGL 4.3, ignored otherwise. Meshes with the compact vertex format and instances of baked animations are still skinned by each pass.
+#define R3D_FLAG_AUTO_INSTANCING        (1 << 14)   ///< Merges the consecutive draws of the same mesh with the same material, like the repeated R3D_DrawModel() calls of a model, into instanced draws in the depth prepass, the shadow maps of the spot and directional lights and the geometry pass, after their culling. Only the static meshes drawn with the built-in shaders and without billboarding are merged. The geometry pass already merges the meshes of the arena into multi-draws with OpenGL 4.3.
 
 /**
  * @brief Bitfield type used to specify rendering layers for 3D objects.
@@ -73,6 +83,21 @@ typedef uint32_t R3D_Layer;
 
 #define R3D_LAYER_ALL   0xFFFFFFFF
 
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief OpenGL state statistics of the last rendered frame.
+ *
+ * R3D keeps track of the programs, vertex arrays, framebuffers, texture bindings,
+ * and blend, cull and depth states it sets, and drops the calls that would not change them.
+ */
+typedef struct R3D_StateStats {
+    int issuedCalls;    ///< Number of state calls sent to the driver during `R3D_End`
+    int filteredCalls;  ///< Number of redundant state calls dropped during `R3D_End`
+} R3D_StateStats;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -154,6 +179,44 @@ R3DAPI void R3D_GetResolution(int* width, int* height);
  */
 R3DAPI void R3D_UpdateResolution(int width, int height);
 
+/**
+ * @brief Sets the fraction of the internal resolution the scene is rendered at.
+ *
+ * The image is upscaled to the internal resolution when blitted, reconstructed over
+ * several frames with R3D_FLAG_TAA or simply filtered otherwise. A scale of 0.5 to 0.75
+ * with TAA is a good trade-off. With dynamic resolution, it is the highest scale used.
+ *
+ * @param scale The fraction of the resolution rendered, on each axis. Clamped to [0.1, 1.0]. Default is 1.0.
+ */
+R3DAPI void R3D_SetResolutionScale(float scale);
+
+/**
+ * @brief Enables the dynamic resolution.
+ *
+ * The scene is rendered into a fraction of the internal resolution, adjusted each frame
+ * to keep the GPU time of R3D_End() around the target, then upscaled when blitted.
+ * The time is measured with timer queries read a few frames later, the scale drops quickly
+ * when over budget and recovers slowly. Probe captures are always rendered at full scale.
+ *
+ * @param targetFrameTime The GPU time budget of R3D_End(), in milliseconds.
+ * @param minScale The smallest fraction of the resolution rendered, on each axis. Clamped to [0.1, 1.0].
+ */
+R3DAPI void R3D_EnableDynamicResolution(float targetFrameTime, float minScale);
+
+/**
+ * @brief Disables the dynamic resolution.
+ *
+ * The next frames are rendered at the full internal resolution.
+ */
+R3DAPI void R3D_DisableDynamicResolution(void);
+
+/**
+ * @brief Gets the fraction of the internal resolution rendered by the last frame.
+ *
+ * @return The scale on each axis, 1.0 when the dynamic resolution is disabled.
+ */
+R3DAPI float R3D_GetResolutionScale(void);
+
 /**
  * @brief Sets the default texture filtering mode.
  * 
@@ -211,6 +274,167 @@ R3DAPI void R3D_EnableLayers(R3D_Layer bitfield);
  */
 R3DAPI void R3D_DisableLayers(R3D_Layer bitfield);
 
+/**
+ * @brief Sets the bias applied to the level of detail selection of the camera passes.
+ *
+ * The projected size of each mesh is multiplied by the bias before being compared
+ * to the screen sizes of its levels of detail. A higher bias keeps the detailed levels
+ * longer, a lower one switches to the coarser levels sooner.
+ *
+ * The default bias is 1.0.
+ *
+ * @param bias Multiplier applied to the projected size of the meshes.
+ */
+R3DAPI void R3D_SetLodBias(float bias);
+
+/**
+ * @brief Sets the bias applied to the level of detail selection of the shadow passes.
+ *
+ * Shadow maps select their levels from the camera distance like the other passes,
+ * with their own bias, since coarse casters are rarely noticeable in shadows.
+ *
+ * The default bias is 0.5.
+ *
+ * @param bias Multiplier applied to the projected size of the meshes.
+ */
+R3DAPI void R3D_SetShadowLodBias(float bias);
+
+/**
+ * @brief Sets the number of levels of detail generated for the loaded models.
+ *
+ * Each level is simplified from the previous one to about half of its triangles,
+ * and is selected when the projected height of the mesh falls below half the screen
+ * size of the previous level. Generation stops early for meshes that cannot be
+ * simplified any further without a visible error.
+ *
+ * The default count is 0, models are loaded without levels of detail.
+ *
+ * @param count Number of levels to generate, up to `R3D_MESH_MAX_LODS`.
+ */
+R3DAPI void R3D_SetModelLodCount(int count);
+
+/**
+ * @brief Sets whether the loaded models store their vertices in the compact format.
+ *
+ * Compact vertices are quantized to 32 bytes instead of 84, which mostly benefits
+ * large static meshes. Their precision is relative to the bounds of each mesh,
+ * and they are never merged into multi-draw commands.
+ *
+ * Disabled by default.
+ *
+ * @param enabled True to load the meshes with `R3D_VERTEX_FORMAT_COMPACT`.
+ */
+R3DAPI void R3D_SetModelCompactVertices(bool enabled);
+
+/**
+ * @brief Sets whether the textures of the loaded models are compressed on the GPU.
+ *
+ * Uncompressed images are encoded to DXT1, or DXT5 for albedo maps with alpha, by the
+ * loading threads, along with their mipmaps. Normal maps keep X and Y only, which the
+ * shaders already expect. A compressed map uses 4 to 8 times less memory and bandwidth.
+ *
+ * Images loaded from DDS or KTX files are uploaded with their own compression either way,
+ * as long as raylib was built with these formats.
+ *
+ * Disabled by default. Requires `GL_EXT_texture_compression_s3tc`.
+ *
+ * @param enabled True to compress the textures of the loaded models.
+ */
+R3DAPI void R3D_SetModelTextureCompression(bool enabled);
+
+/**
+ * @brief Sets whether the textures of the loaded models are streamed by mipmap level.
+ *
+ * Large textures are first uploaded with their levels of 128 pixels and below only.
+ * Each frame, the finer levels are requested from the screen size of the drawn objects
+ * and uploaded progressively, a few megabytes per frame, within the budget set by
+ * `R3D_SetTextureStreamingBudget()`. Levels unused for a while are released first when
+ * the budget is exceeded.
+ *
+ * The decoded images are kept in memory to upload the levels again later.
+ *
+ * Disabled by default. Only applies with a trilinear or anisotropic texture filter.
+ *
+ * @param enabled True to stream the textures of the loaded models.
+ */
+R3DAPI void R3D_SetModelTextureStreaming(bool enabled);
+
+/**
+ * @brief Sets the GPU memory allowed to the streamed textures.
+ *
+ * The coarse levels uploaded at loading are counted but never released,
+ * so the budget may be exceeded by them alone.
+ *
+ * @param bytes Memory budget in bytes, 0 for no limit (default).
+ */
+R3DAPI void R3D_SetTextureStreamingBudget(size_t bytes);
+
+/**
+ * @brief Sets the error tolerated when compressing the loaded animations.
+ *
+ * With a positive tolerance, the keys that can be interpolated from their neighbors
+ * within the tolerance are removed, and the remaining values are quantized on 16 bits
+ * per component, which divides the memory of large motion capture libraries several times.
+ * The tolerance is in scene units for translations and scales, and in radians for rotations.
+ *
+ * The default tolerance is 0, animations are loaded without compression.
+ *
+ * @param tolerance Maximum error of the removed keys, 0 to disable the compression.
+ */
+R3DAPI void R3D_SetAnimationCompression(float tolerance);
+
+/**
+ * @brief Sets the directory where the linked shader programs are saved between runs.
+ *
+ * Shaders are compiled the first time they are used, which can stall the first frames
+ * using a new effect. With a directory, the binary of each program is saved after
+ * its compilation and loaded directly by the next runs, including the custom shaders.
+ * The binaries are keyed by their final sources and the driver strings, and are
+ * recompiled whenever the driver rejects them.
+ *
+ * The directory must exist and be writable. Should be called right after `R3D_Init`,
+ * the programs loaded before are not saved. Ignored if the driver has no binary format.
+ *
+ * Disabled by default.
+ *
+ * @param path Path of the directory, or NULL to disable the cache.
+ */
+R3DAPI void R3D_SetShaderCacheDirectory(const char* path);
+
+/**
+ * @brief Starts the compilation of all the built-in shaders in the background.
+ *
+ * Shaders are otherwise compiled the first time they are used, which stalls the frame.
+ * The programs are submitted to the driver without waiting for them, and are finished
+ * by `R3D_PollShaderPrecompilation`. Programs saved in the shader cache directory are
+ * loaded immediately. A shader used before being finished is still loaded on demand.
+ *
+ * Custom shaders are compiled by `R3D_CreateCustomShader` and are not concerned.
+ *
+ * @see R3D_SetShaderCacheDirectory
+ */
+R3DAPI void R3D_PrecompileShaders(void);
+
+/**
+ * @brief Finishes the loading of the shaders compiled in the background.
+ *
+ * Meant to be called once per frame, for example during a loading screen, until it returns zero.
+ * With `GL_KHR_parallel_shader_compile`, only the shaders already compiled by the driver are
+ * finished and the call never waits. Otherwise a single shader is finished per call.
+ *
+ * @return The number of shaders still being compiled.
+ */
+R3DAPI int R3D_PollShaderPrecompilation(void);
+
+/**
+ * @brief Returns the OpenGL state statistics of the last frame.
+ *
+ * The counters are updated by each `R3D_End`.
+ *
+ * @return The number of state calls issued and filtered as redundant.
+ */
+R3DAPI R3D_StateStats R3D_GetStateStats(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -18,6 +18,22 @@
  * @{
  */
 
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief Occlusion culling statistics of the last rendered frame.
+ *
+ * Only the groups that passed frustum culling are tested against the depth pyramid.
+ *
+ * @see R3D_FLAG_OCCLUSION_CULLING
+ */
+typedef struct R3D_OcclusionStats {
+    int testedGroups;   ///< Number of draw groups tested against the depth of the previous frame
+    int culledGroups;   ///< Number of draw groups found hidden and skipped
+} R3D_OcclusionStats;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -105,6 +121,16 @@ R3DAPI bool R3D_IsAABBInFrustum(BoundingBox aabb);
  */
 R3DAPI bool R3D_IsOBBInFrustum(BoundingBox aabb, Matrix transform);
 
+/**
+ * @brief Returns the occlusion culling statistics of the last frame.
+ *
+ * The counters are updated during `R3D_End` when `R3D_FLAG_OCCLUSION_CULLING` is set,
+ * they are zero otherwise.
+ *
+ * @return The number of groups tested and culled by the occlusion test.
+ */
+R3DAPI R3D_OcclusionStats R3D_GetOcclusionStats(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -39,11 +39,17 @@ typedef struct R3D_Keyframe {
  * This structure contains an array of keyframes and metadata about the array, such as the current number of keyframes
  * and the allocated capacity. The keyframes define a curve that can be used for smooth interpolation between values
  * over a normalized time range (0.0 to 1.0).
+ *
+ * A curve can optionally be baked into a lookup table, evaluated in constant time, and uploaded
+ * as a 1D texture sampled by the GPU particle systems.
  */
 typedef struct R3D_InterpolationCurve {
     R3D_Keyframe* keyframes;    ///< Dynamic array of keyframes defining the interpolation curve.
     unsigned int capacity;      ///< Allocated size of the keyframes array.
     unsigned int count;         ///< Current number of keyframes in the array.
+    float* lut;                 ///< Values sampled uniformly from 0.0 to 1.0, NULL if the curve is not baked.
+    unsigned int lutSize;       ///< Number of samples in the lookup table.
+    unsigned int texture;       ///< OpenGL 1D texture holding the lookup table, 0 if the curve is not uploaded.
 } R3D_InterpolationCurve;
 
 // ========================================
@@ -95,7 +101,8 @@ R3DAPI bool R3D_AddKeyframe(R3D_InterpolationCurve* curve, float time, float val
  * @brief Evaluates the interpolation curve at a specific time.
  *
  * This function evaluates the value of the interpolation curve at a given time. The curve will interpolate between
- * keyframes based on the time provided.
+ * keyframes based on the time provided. Baked curves interpolate between the two nearest samples of their lookup table
+ * instead, with the time clamped between 0.0 and 1.0.
  *
  * @param curve The interpolation curve to be evaluated.
  * @param time The time at which to evaluate the curve.
@@ -103,6 +110,30 @@ R3DAPI bool R3D_AddKeyframe(R3D_InterpolationCurve* curve, float time, float val
  */
 R3DAPI float R3D_EvaluateCurve(R3D_InterpolationCurve curve, float time);
 
+/**
+ * @brief Bakes the interpolation curve into a lookup table.
+ *
+ * The table is rebuilt automatically by `R3D_AddKeyframe`, but this function must be called again
+ * after modifying the keyframes directly. Baking with a resolution of zero releases the table,
+ * along with the texture of the curve.
+ *
+ * @param curve A pointer to the interpolation curve to bake.
+ * @param resolution Number of samples of the table (e.g. 64 or 256), at least 2, or 0 to release the table.
+ * @return `true` if the table was built or released, `false` on invalid resolution or allocation failure.
+ */
+R3DAPI bool R3D_BakeCurve(R3D_InterpolationCurve* curve, int resolution);
+
+/**
+ * @brief Uploads the lookup table of a baked curve to a 1D texture.
+ *
+ * The texture is sampled by the GPU particle systems in place of the per-update sampling of the curve,
+ * and is updated each time the curve is baked again.
+ *
+ * @param curve A pointer to a baked interpolation curve.
+ * @return `true` if the texture was uploaded, `false` if the curve is not baked.
+ */
+R3DAPI bool R3D_UploadCurve(R3D_InterpolationCurve* curve);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -10,6 +10,7 @@
 #define R3D_DRAW_H
 
 #include "./r3d_particles.h"
+#include "./r3d_instance.h"
 #include "./r3d_platform.h"
 #include "./r3d_model.h"
 #include "./r3d_decal.h"
@@ -20,6 +21,41 @@
  * @{
  */
 
+// ========================================
+// DEFINES
+// ========================================
+
+#define R3D_MAX_VIEWS   8   ///< Maximum number of views rendered by `R3D_BeginMultiView()`
+
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief Buffer recording draws away from the rendering thread.
+ *
+ * A draw buffer is owned by a single thread at a time, typically a worker of a job system.
+ * Recording into it performs no GL call and does not touch the global draw state,
+ * so several threads can record into their own buffer concurrently.
+ * All buffers are merged by `R3D_End()`, in their creation order, then emptied.
+ */
+typedef struct R3D_DrawBuffer R3D_DrawBuffer;
+
+/**
+ * @brief Compact instance of a sprite, expanded into a quad by the vertex shader.
+ *
+ * Records are 44 bytes and are copied as is into the instance stream.
+ * The quad of the sprite is rolled around its facing axis before the
+ * billboard mode of the material is applied, so the roll is kept when facing the camera.
+ */
+typedef struct R3D_Sprite {
+    Vector3 position;                   ///< Center of the sprite.
+    float rotation;                     ///< Roll of the sprite around its facing axis, in radians.
+    Vector2 size;                       ///< Width and height of the sprite.
+    Color color;                        ///< Color of the sprite, multiplied with the albedo.
+    Rectangle uvRect;                   ///< Region of the texture atlas in normalized coordinates (x, y, width, height).
+} R3D_Sprite;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -53,6 +89,40 @@ R3DAPI void R3D_Begin(Camera3D camera);
  */
 R3DAPI void R3D_BeginEx(Camera3D camera, const RenderTexture* target);
 
+/**
+ * @brief Begins a rendering session for several cameras sharing the same draws.
+ *
+ * The draws are submitted once and `R3D_End()` renders them from each camera into its target,
+ * in order, as split-screen or picture-in-picture views. The lights are culled and the shadow maps
+ * are rendered once for all the views, only the culling, sorting and shading of the draws are done per view.
+ *
+ * The history of the temporal effects and of the occlusion culling belongs to a single view,
+ * TAA, temporal SSAO and SSIL, and occlusion culling are therefore disabled in multi-view frames.
+ * The levels of detail are selected from the first camera.
+ *
+ * @param cameras Array of 'count' cameras. Cannot be NULL.
+ * @param targets Array of 'count' render targets, one per camera. Cannot be NULL.
+ * @param count Number of views, between 1 and `R3D_MAX_VIEWS`.
+ */
+R3DAPI void R3D_BeginMultiView(const Camera3D* cameras, const RenderTexture* targets, int count);
+
+/**
+ * @brief Begins a rendering session for the two eyes of a stereo headset.
+ *
+ * The eye poses and projections are taken as given by the VR runtime, off-axis projections included.
+ * The near and far planes are recovered from the perspective projections.
+ *
+ * In addition to what is shared by `R3D_BeginMultiView()`, both eyes are culled with a single frustum
+ * enclosing them and share their sorted draw lists, the draws are sorted from the midpoint between the eyes.
+ * The same restrictions on temporal effects and occlusion culling apply, and the levels of detail
+ * are selected from the left eye.
+ *
+ * @param views Array of 2 view matrices, left eye first. Cannot be NULL.
+ * @param projections Array of 2 perspective projection matrices, left eye first. Cannot be NULL.
+ * @param targets Array of 2 render targets, left eye first. Cannot be NULL.
+ */
+R3DAPI void R3D_BeginStereo(const Matrix* views, const Matrix* projections, const RenderTexture* targets);
+
 /**
  * @brief Ends the current rendering session.
  * 
@@ -129,6 +199,32 @@ R3DAPI void R3D_DrawMeshInstancedPro(const R3D_Mesh* mesh, const R3D_Material* m
                                      const Color* instanceColors, int colorsStride,
                                      int instanceCount);
 
+/**
+ * @brief Draws a mesh with the instances stored in an instance buffer.
+ *
+ * The content of the buffer is not uploaded again, all render passes
+ * directly read the GPU storage of the buffer.
+ *
+ * @param mesh A pointer to the mesh to render. Cannot be NULL.
+ * @param material A pointer to the material to apply to the mesh. Can be NULL, default material will be used.
+ * @param instances A pointer to the instance buffer to draw. Must remain valid until `R3D_End()`.
+ */
+R3DAPI void R3D_DrawMeshInstanceBuffer(const R3D_Mesh* mesh, const R3D_Material* material, const R3D_InstanceBuffer* instances);
+
+/**
+ * @brief Draws a mesh with the instances stored in an instance buffer and a global transformation.
+ *
+ * @param mesh A pointer to the mesh to render. Cannot be NULL.
+ * @param material A pointer to the material to apply to the mesh. Can be NULL, default material will be used.
+ * @param globalAabb Optional bounding box encompassing all instances, in local space. Used for frustum culling.
+ *                   Can be NULL to disable culling. Will be transformed by the global matrix if necessary.
+ * @param globalTransform The global transformation matrix applied to all instances.
+ * @param instances A pointer to the instance buffer to draw. Must remain valid until `R3D_End()`.
+ */
+R3DAPI void R3D_DrawMeshInstanceBufferPro(const R3D_Mesh* mesh, const R3D_Material* material,
+                                          const BoundingBox* globalAabb, Matrix globalTransform,
+                                          const R3D_InstanceBuffer* instances);
+
 /**
  * @brief Draws a model at a specified position and scale.
  * 
@@ -219,6 +315,27 @@ R3DAPI void R3D_DrawModelInstancedPro(const R3D_Model* model,
                                       const Color* instanceColors, int colorsStride,
                                       int instanceCount);
 
+/**
+ * @brief Draws a model with the instances stored in an instance buffer.
+ *
+ * @param model A pointer to the model to render. Cannot be NULL.
+ * @param instances A pointer to the instance buffer to draw. Must remain valid until `R3D_End()`.
+ */
+R3DAPI void R3D_DrawModelInstanceBuffer(const R3D_Model* model, const R3D_InstanceBuffer* instances);
+
+/**
+ * @brief Draws a model with the instances stored in an instance buffer and a global transformation.
+ *
+ * @param model A pointer to the model to render. Cannot be NULL.
+ * @param globalAabb Optional bounding box encompassing all instances, in local space. Used for frustum culling.
+ *                   Can be NULL to disable culling. Will be transformed by the global matrix if necessary.
+ * @param globalTransform The global transformation matrix applied to all instances.
+ * @param instances A pointer to the instance buffer to draw. Must remain valid until `R3D_End()`.
+ */
+R3DAPI void R3D_DrawModelInstanceBufferPro(const R3D_Model* model,
+                                           const BoundingBox* globalAabb, Matrix globalTransform,
+                                           const R3D_InstanceBuffer* instances);
+
 /**
  * @brief Draws a decal using a transformation matrix.
  *
@@ -272,6 +389,71 @@ R3DAPI void R3D_DrawParticleSystem(const R3D_ParticleSystem* system, const R3D_M
  */
 R3DAPI void R3D_DrawParticleSystemEx(const R3D_ParticleSystem* system, const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform);
 
+/**
+ * @brief Renders a batch of sprites sharing the same atlas in a single instanced draw.
+ *
+ * Each sprite selects its region of the atlas with its `uvRect`, so every sprite
+ * of the batch must use the textures of `material`. The quad is expanded from the
+ * compact records by the vertex shader, the billboard mode of the material decides
+ * whether the sprites face the camera.
+ *
+ * @param mesh A pointer to the quad used by every sprite, facing +Z with dimensions 1.0,
+ *             e.g. `R3D_GenMeshQuad(1, 1, 1, 1, (Vector3) {0, 0, 1})`. Cannot be NULL.
+ * @param material A pointer to the material applied to the sprites. Can be NULL, default material will be used.
+ * @param sprites Array of sprites to render. Cannot be NULL.
+ * @param count The number of sprites to render. Must be greater than 0.
+ */
+R3DAPI void R3D_DrawSprites(const R3D_Mesh* mesh, const R3D_Material* material, const R3D_Sprite* sprites, int count);
+
+// ----------------------------------------
+// DRAW: Draw Buffer Functions
+// ----------------------------------------
+
+/**
+ * @brief Creates a draw buffer merged by every `R3D_End()`.
+ *
+ * Must be called from the rendering thread, outside of any recording.
+ *
+ * @return The new draw buffer, or NULL on allocation failure.
+ */
+R3DAPI R3D_DrawBuffer* R3D_CreateDrawBuffer(void);
+
+/**
+ * @brief Destroys a draw buffer, the draws it still holds are discarded.
+ *
+ * Must be called from the rendering thread, outside of any recording.
+ *
+ * @param buffer The draw buffer to destroy.
+ */
+R3DAPI void R3D_DestroyDrawBuffer(R3D_DrawBuffer* buffer);
+
+/**
+ * @brief Records a mesh draw into a draw buffer.
+ *
+ * Same as `R3D_DrawMesh()`, but can be called from any thread owning the buffer.
+ * The material is copied, the mesh resources must remain valid until `R3D_End()`.
+ * The world bounds are computed by the recording thread.
+ *
+ * @param buffer The draw buffer to record into.
+ * @param mesh A pointer to the mesh to render. Cannot be NULL.
+ * @param material A pointer to the material to apply to the mesh. Can be NULL, default material will be used.
+ * @param transform The transformation matrix to apply to the mesh.
+ */
+R3DAPI void R3D_DrawBufferMesh(R3D_DrawBuffer* buffer, const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform);
+
+/**
+ * @brief Records a model draw into a draw buffer.
+ *
+ * Same as `R3D_DrawModelPro()`, but can be called from any thread owning the buffer.
+ * The model is referenced, it must remain valid until `R3D_End()`.
+ * The world bounds are computed by the recording thread.
+ *
+ * @param buffer The draw buffer to record into.
+ * @param model A pointer to the model to render. Cannot be NULL.
+ * @param transform The transformation matrix to apply to the model.
+ */
+R3DAPI void R3D_DrawBufferModel(R3D_DrawBuffer* buffer, const R3D_Model* model, Matrix transform);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
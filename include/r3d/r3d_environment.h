@@ -71,6 +71,7 @@
             .radius = 0.5f,                             \
             .bias = 0.005f,                             \
             .lightAffect = 0.0f,                        \
+            .temporal = false,                          \
             .enabled = false,                           \
         },                                              \
         .ssil = {                                       \
@@ -80,6 +81,8 @@
             .hitThickness = 0.5f,                       \
             .aoPower = 1.0f,                            \
             .energy = 1.0f,                             \
+            .convergence = 0.25f,                       \
+            .temporal = false,                          \
             .enabled = false,                           \
         },                                              \
         .bloom = {                                      \
@@ -98,6 +101,7 @@
             .depthTolerance = 0.005f,                   \
             .edgeFadeStart = 0.7f,                      \
             .edgeFadeEnd = 1.0f,                        \
+            .roughnessCutoff = 0.8f,                    \
             .enabled = false,                           \
         },                                              \
         .fog = {                                        \
@@ -212,6 +216,7 @@ typedef struct R3D_EnvSSAO {
     float radius;           ///< Sampling radius in world space (default: 0.5)
     float bias;             ///< Depth bias to prevent self-shadowing artifacts (default: 0.005)
     float lightAffect;      ///< How much SSAO affects direct lighting [0.0-1.0] (default: 0.0)
+    bool temporal;          ///< Accumulate over frames instead of blurring, a quarter of the samples is enough (default: false)
     bool enabled;           ///< Enable/disable SSAO effect (default: false)
 } R3D_EnvSSAO;
 
@@ -227,6 +232,8 @@ typedef struct R3D_EnvSSIL {
     float hitThickness;     ///< Thickness threshold for occluders (default: 0.5)
     float aoPower;          ///< Exponential falloff for visibility factor (too high = more noise) (default: 1.0)
     float energy;           ///< Multiplier for indirect light intensity (default: 1.0)
+    float convergence;      ///< Weight of the new samples in the history when temporal, lower is smoother but slower to react [0.0-1.0] (default: 0.25)
+    bool temporal;          ///< Shade a quarter of the pixels per frame and accumulate them over frames (default: false)
     bool enabled;           ///< Enable/disable SSIL effect (default: false)
 } R3D_EnvSSIL;
 
@@ -248,15 +255,17 @@ typedef struct R3D_EnvBloom {
  * @brief Screen Space Reflections (SSR) settings.
  *
  * Real-time reflections calculated in screen space.
+ * The rays traverse a min depth pyramid of the scene, so their cost barely depends on their length.
  */
 typedef struct R3D_EnvSSR {
-    int maxRaySteps;            ///< Maximum ray marching iterations (default: 64)
+    int maxRaySteps;            ///< Maximum depth pyramid traversal iterations (default: 64)
     int binarySearchSteps;      ///< Refinement steps for intersection (default: 8)
     float rayMarchLength;       ///< Maximum ray distance in view space (default: 8.0)
     float depthThickness;       ///< Depth tolerance for valid hits (default: 0.2)
     float depthTolerance;       ///< Negative margin to prevent false negatives (default: 0.005)
     float edgeFadeStart;        ///< Screen edge fade start [0-1] (default: 0.7)
     float edgeFadeEnd;          ///< Screen edge fade end [0-1] (default: 1.0)
+    float roughnessCutoff;      ///< Roughness above which no ray is traced, reflections fade out just before (default: 0.8)
     bool enabled;               ///< Enable/disable SSR (default: false)
 } R3D_EnvSSR;
 
@@ -0,0 +1,171 @@
+/* r3d_instance.h -- R3D Instance Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_INSTANCE_H
+#define R3D_INSTANCE_H
+
+#include "./r3d_platform.h"
+#include <raylib.h>
+#include <stdint.h>
+
+/**
+ * @defgroup Instance
+ * @{
+ */
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+/**
+ * @brief Number of ring segments allocated by streamed instance buffers.
+ *
+ * Streamed buffers write each frame into a different segment so that the CPU
+ * never overwrites data still being read by the GPU for a previous frame.
+ */
+#define R3D_INSTANCE_RING_SIZE 3
+
+// ========================================
+// ENUMS TYPES
+// ========================================
+
+/**
+ * @brief Hint on how an instance buffer will be updated.
+ */
+typedef enum R3D_InstanceUsage {
+    R3D_STATIC_INSTANCES,       ///< Filled once, rarely or never updated.
+    R3D_DYNAMIC_INSTANCES,      ///< Updated occasionally, possibly by sub-range.
+    R3D_STREAMED_INSTANCES      ///< Rewritten every frame, uses a ring of R3D_INSTANCE_RING_SIZE segments.
+} R3D_InstanceUsage;
+
+/**
+ * @brief Bitfield of the per-instance attributes stored in an instance buffer.
+ */
+typedef uint32_t R3D_InstanceFlags;
+
+#define R3D_INSTANCE_TRANSFORM      (1 << 0)    ///< Per-instance model matrix (always present).
+#define R3D_INSTANCE_COLOR          (1 << 1)    ///< Per-instance color.
+#define R3D_INSTANCE_ANIMATION      (1 << 2)    ///< Per-instance baked animation, see R3D_BakedAnimationLib.
+
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief Baked animation played by one instance.
+ *
+ * Only used by the models drawn with a baked animation library,
+ * the pose of the instance is the baked frame nearest to its time.
+ */
+typedef struct R3D_InstanceAnimation {
+    int animation;                  ///< Index of the animation in the baked library.
+    float time;                     ///< Playback time in seconds.
+} R3D_InstanceAnimation;
+
+/**
+ * @brief Long-lived GPU storage for per-instance data.
+ *
+ * The buffer is filled by the application, entirely or by sub-range, and can be
+ * drawn any number of times without re-uploading its content. Every pass of a frame
+ * (shadows, prepass, geometry, forward) reads the same GPU storage.
+ *
+ * When `GL_ARB_buffer_storage` is available, streamed buffers are persistently mapped
+ * and written directly, otherwise each update is done with `glBufferSubData` into
+ * the current ring segment.
+ */
+typedef struct R3D_InstanceBuffer {
+
+    uint32_t vboTransforms;         ///< OpenGL buffer holding the instance matrices.
+    uint32_t vboColors;             ///< OpenGL buffer holding the instance colors (0 without R3D_INSTANCE_COLOR).
+    uint32_t vboAnimations;         ///< OpenGL buffer holding the instance animations (0 without R3D_INSTANCE_ANIMATION).
+
+    void* mapTransforms;            ///< Persistently mapped storage of the transforms (NULL if not mapped).
+    void* mapColors;                ///< Persistently mapped storage of the colors (NULL if not mapped).
+    void* mapAnimations;            ///< Persistently mapped storage of the animations (NULL if not mapped).
+
+    void* fences[R3D_INSTANCE_RING_SIZE];   ///< Sync objects guarding each ring segment (internal).
+    uint32_t frame;                         ///< Frame of the last ring advance (internal).
+    int numSegments;                        ///< Number of ring segments (1, or R3D_INSTANCE_RING_SIZE for streamed buffers).
+    int segment;                            ///< Ring segment currently written and drawn.
+
+    int capacity;                   ///< Maximum number of instances per segment.
+    int count;                      ///< Number of instances drawn, must not exceed capacity.
+
+    R3D_InstanceFlags flags;        ///< Attributes stored in the buffer.
+    R3D_InstanceUsage usage;        ///< Update hint given at creation.
+
+} R3D_InstanceBuffer;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates an instance buffer able to hold `capacity` instances.
+ *
+ * @param capacity Maximum number of instances stored in the buffer.
+ * @param flags Attributes to allocate (R3D_INSTANCE_TRANSFORM is implied).
+ * @param usage Hint on how the buffer will be updated.
+ * @return Created instance buffer, with a count of zero.
+ */
+R3DAPI R3D_InstanceBuffer R3D_LoadInstanceBuffer(int capacity, R3D_InstanceFlags flags, R3D_InstanceUsage usage);
+
+/**
+ * @brief Destroys an instance buffer and frees its GPU resources.
+ * @param buffer Pointer to the instance buffer to destroy.
+ */
+R3DAPI void R3D_UnloadInstanceBuffer(R3D_InstanceBuffer* buffer);
+
+/**
+ * @brief Check if an instance buffer is valid for rendering.
+ * @param buffer Pointer to the instance buffer to check.
+ * @return true if the buffer owns a transform storage, false otherwise.
+ */
+R3DAPI bool R3D_IsInstanceBufferValid(const R3D_InstanceBuffer* buffer);
+
+/**
+ * @brief Uploads a range of instances into the buffer.
+ *
+ * Either array may be NULL to leave the corresponding attribute untouched.
+ * The instance count is extended to cover the written range if needed.
+ *
+ * @note Streamed buffers switch to their next ring segment on the first update of a frame,
+ *       the whole used range must then be rewritten during that frame.
+ *
+ * @param buffer Pointer to the instance buffer to update.
+ * @param offset Index of the first instance to write.
+ * @param count Number of instances to write.
+ * @param transforms Array of `count` matrices (may be NULL).
+ * @param colors Array of `count` colors (may be NULL).
+ */
+R3DAPI void R3D_UploadInstances(R3D_InstanceBuffer* buffer, int offset, int count, const Matrix* transforms, const Color* colors);
+
+/**
+ * @brief Uploads the baked animations of a range of instances.
+ *
+ * Follows the same rules as `R3D_UploadInstances()`, the buffer must have been created
+ * with `R3D_INSTANCE_ANIMATION`.
+ *
+ * @param buffer Pointer to the instance buffer to update.
+ * @param offset Index of the first instance to write.
+ * @param count Number of instances to write.
+ * @param animations Array of `count` instance animations.
+ */
+R3DAPI void R3D_UploadInstanceAnimations(R3D_InstanceBuffer* buffer, int offset, int count, const R3D_InstanceAnimation* animations);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of Instance
+
+#endif // R3D_INSTANCE_H
@@ -44,6 +44,18 @@ typedef enum R3D_ShadowUpdateMode {
     R3D_SHADOW_UPDATE_CONTINUOUS        ///< Shadow maps update every frame for real-time accuracy.
 } R3D_ShadowUpdateMode;
 
+/**
+ * @brief Filtering quality of the shadows of a light.
+ *
+ * Each tap compares the 4 nearest texels of the shadow map, filtered by the hardware.
+ * The cost of a shadowed pixel is proportional to the number of taps.
+ */
+typedef enum R3D_ShadowQuality {
+    R3D_SHADOW_QUALITY_LOW,             ///< A single tap, the softness is ignored.
+    R3D_SHADOW_QUALITY_MEDIUM,          ///< 4 taps within the softness radius.
+    R3D_SHADOW_QUALITY_HIGH             ///< 8 taps within the softness radius (default).
+} R3D_ShadowQuality;
+
 // ========================================
 // ALIASES TYPES
 // ========================================
@@ -394,15 +406,18 @@ R3DAPI void R3D_SetLightOuterCutOff(R3D_Light id, float degrees);
 /**
  * @brief Enables shadow casting for a light and sets its shadow map resolution.
  *
- * Allocates a shadow map at the given resolution and enables shadow rendering.
- * This function can be called multiple times to resize the shadow map, but doing so
- * reallocates GPU resources and has a performance cost.
+ * The shadows of all the lights are rendered in a shared atlas, where each visible light
+ * receives tiles every frame according to its screen coverage (six tiles for omni lights).
+ * The resolution is the maximum size of these tiles, it is rounded down to a power of two
+ * and limited by the atlas size. The size rendered scales with the square root of the
+ * fraction of the screen covered by the light volume, so that small or distant lights fall
+ * to 128 or 256 pixels while the close ones get the full resolution. The size only changes
+ * once the coverage moved well away from it, to not reallocate the tiles every frame.
  *
  * @param id The ID of the light.
- * @param resolution The shadow map resolution.
+ * @param resolution The maximum shadow map resolution.
  *
- * @note Shadow maps are memory-intensive. High resolutions (e.g. 4K) consume significant
- * GPU memory; creating many high-resolution shadow maps may lead crashes...
+ * @note At most 32 visible lights receive shadows each frame, the ones covering the most of the screen.
  */
 R3DAPI void R3D_EnableShadow(R3D_Light id, int resolution);
 
@@ -426,6 +441,17 @@ R3DAPI void R3D_DisableShadow(R3D_Light id);
  */
 R3DAPI bool R3D_IsShadowEnabled(R3D_Light id);
 
+/**
+ * @brief Gets the shadow map resolution given to a light for the current frame.
+ *
+ * This is the size of the tiles of the light in the shadow atlas, chosen from its screen
+ * coverage and bounded by the resolution given to `R3D_EnableShadow()`.
+ *
+ * @param id The ID of the light.
+ * @return The size in pixels of the shadow tiles, 0 if the light has none this frame.
+ */
+R3DAPI int R3D_GetShadowResolution(R3D_Light id);
+
 /**
  * @brief Gets the shadow map update mode of a light.
  *
@@ -484,6 +510,58 @@ R3DAPI void R3D_SetShadowUpdateFrequency(R3D_Light id, int msec);
  */
 R3DAPI void R3D_UpdateShadowMap(R3D_Light id);
 
+/**
+ * @brief Gets the maximum number of shadow views rendered per frame.
+ */
+R3DAPI int R3D_GetShadowUpdateBudget(void);
+
+/**
+ * @brief Sets the maximum number of shadow views rendered per frame, for all the lights.
+ *
+ * A view is a spot shadow, a cascade of a directional shadow or a face of an omni shadow.
+ * When the pending updates exceed the budget, the lights covering the most of the screen
+ * are rendered first and the others are postponed to the next frames, their priority growing
+ * with the frames they waited. The faces of an omni shadow can be spread over several frames.
+ * This bounds the cost of the shadows per frame rather than their freshness.
+ * Shadows that just got their tiles in the shadow atlas are always rendered immediately.
+ *
+ * @param views The number of views per frame, 0 for no limit (default: 0).
+ */
+R3DAPI void R3D_SetShadowUpdateBudget(int views);
+
+/**
+ * @brief Gets the maximum number of lights shaded per frame.
+ */
+R3DAPI int R3D_GetLightBudget(void);
+
+/**
+ * @brief Sets the maximum number of lights shaded per frame.
+ *
+ * Each frame the visible lights are ranked by importance: their energy, attenuation factor and
+ * brightest color channel times the fraction of the screen covered by their bounds.
+ * Only the most important lights within the budget are shaded, in the deferred and the forward passes.
+ * The least important of them fade out as they approach the first light left out, so that
+ * lights entering or leaving the budget do not pop. Directional lights are always shaded.
+ *
+ * @param lights The number of lights per frame, 0 for no limit (default: 0).
+ */
+R3DAPI void R3D_SetLightBudget(int lights);
+
+/**
+ * @brief Gets the importance below which the visible lights are skipped.
+ */
+R3DAPI float R3D_GetLightImportanceThreshold(void);
+
+/**
+ * @brief Sets the importance below which the visible lights are skipped.
+ *
+ * Lights fade out from twice the threshold to the threshold, see `R3D_SetLightBudget()` for the importance.
+ * For example, a light of energy 1 covering 1% of the screen has an importance of 0.01.
+ *
+ * @param threshold The importance threshold, 0 to keep every visible light (default: 0).
+ */
+R3DAPI void R3D_SetLightImportanceThreshold(float threshold);
+
 /**
  * @brief Retrieves the softness radius used to simulate penumbra in shadows.
  *
@@ -510,6 +588,22 @@ R3DAPI float R3D_GetShadowSoftness(R3D_Light id);
  */
 R3DAPI void R3D_SetShadowSoftness(R3D_Light id, float softness);
 
+/**
+ * @brief Gets the filtering quality of the shadows of a light.
+ */
+R3DAPI R3D_ShadowQuality R3D_GetShadowQuality(R3D_Light id);
+
+/**
+ * @brief Sets the filtering quality of the shadows of a light.
+ *
+ * Lower qualities take fewer taps in the shadow map for each shaded pixel,
+ * which suits the lights covering a large part of the screen or with sharp shadows.
+ *
+ * @param id The ID of the light.
+ * @param quality The filtering quality (default: R3D_SHADOW_QUALITY_HIGH).
+ */
+R3DAPI void R3D_SetShadowQuality(R3D_Light id, R3D_ShadowQuality quality);
+
 /**
  * @brief Gets the shadow depth bias value.
  */
@@ -539,6 +633,56 @@ R3DAPI float R3D_GetShadowSlopeBias(R3D_Light id);
  */
 R3DAPI void R3D_SetShadowSlopeBias(R3D_Light id, float value);
 
+/**
+ * @brief Gets the number of shadow cascades of a directional light.
+ */
+R3DAPI int R3D_GetShadowCascadeCount(R3D_Light id);
+
+/**
+ * @brief Sets the number of shadow cascades of a directional light.
+ *
+ * The view is split in depth up to the light range, each cascade receives its own
+ * tile in the shadow atlas, so that the shadows close to the camera stay sharp.
+ * The cascades are all rendered with the next shadow update.
+ *
+ * @param id The ID of the light.
+ * @param count The number of cascades, between 1 and 4 (default: 4).
+ */
+R3DAPI void R3D_SetShadowCascadeCount(R3D_Light id, int count);
+
+/**
+ * @brief Gets the split blend of the shadow cascades of a directional light.
+ */
+R3DAPI float R3D_GetShadowCascadeSplit(R3D_Light id);
+
+/**
+ * @brief Sets the split blend of the shadow cascades of a directional light.
+ *
+ * The cascade splits blend between uniform splits (0.0), which suit short shadow ranges,
+ * and logarithmic splits (1.0), which give more resolution close to the camera.
+ *
+ * @param id The ID of the light.
+ * @param split The blend factor between 0.0 and 1.0 (default: 0.75).
+ */
+R3DAPI void R3D_SetShadowCascadeSplit(R3D_Light id, float split);
+
+/**
+ * @brief Gets the update interval of the far shadow cascades of a directional light.
+ */
+R3DAPI int R3D_GetShadowCascadeUpdateInterval(R3D_Light id);
+
+/**
+ * @brief Sets the update interval of the far shadow cascades of a directional light.
+ *
+ * The nearest cascade is rendered with each shadow update, the other ones only once every
+ * given number of updates, on different updates, to bound the cost of the shadows.
+ * The far cascades then follow the camera with a delay, which is rarely noticeable.
+ *
+ * @param id The ID of the light.
+ * @param updates The number of shadow updates between two renders of a far cascade (default: 1).
+ */
+R3DAPI void R3D_SetShadowCascadeUpdateInterval(R3D_Light id, int updates);
+
 // ----------------------------------------
 // LIGHTING: Light Helper Functions
 // ----------------------------------------
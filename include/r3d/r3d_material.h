@@ -75,6 +75,23 @@ typedef enum R3D_CullMode {
     R3D_CULL_FRONT              ///< Cull front-facing polygons (faces with counter-clockwise winding order).
 } R3D_CullMode;
 
+/**
+ * @brief Rendering resolutions of the forward draws.
+ *
+ * Large blended effects like smoke, fire or fog volumes are bound by their overdraw,
+ * they can be drawn into a reduced target, tested against a downsampled depth buffer,
+ * then upsampled over the scene before the post-processing with a depth-aware filter.
+ *
+ * @note Only applies to the blended draws: `R3D_TRANSPARENCY_ALPHA` with `R3D_BLEND_MIX` or
+ *       `R3D_BLEND_PREMULTIPLIED_ALPHA`, and `R3D_BLEND_ADDITIVE`. The other draws, including
+ *       the ones using `R3D_TRANSPARENCY_PREPASS` or `R3D_BLEND_MULTIPLY`, stay at full resolution.
+ */
+typedef enum R3D_RenderResolution {
+    R3D_RESOLUTION_FULL,            ///< Drawn directly into the scene.
+    R3D_RESOLUTION_HALF,            ///< Drawn at half the width and height of the scene, a quarter of the fragments.
+    R3D_RESOLUTION_QUARTER          ///< Drawn at a quarter of the width and height of the scene, a sixteenth of the fragments.
+} R3D_RenderResolution;
+
 // ========================================
 // STRUCTS TYPES
 // ========================================
@@ -113,6 +130,7 @@ typedef struct R3D_Material {
     R3D_BillboardMode billboardMode;        ///< Billboard mode applied to the object.
     R3D_BlendMode blendMode;                ///< Blend mode used for rendering.
     R3D_CullMode cullMode;                  ///< Face culling mode used for rendering.
+    R3D_RenderResolution resolution;        ///< Resolution of the blended forward draws, see `R3D_RenderResolution`.
 
     Vector2 uvOffset;                       /**< UV offset applied to the texture coordinates.
                                              *  For models, this can be set manually.
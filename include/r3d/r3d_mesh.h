@@ -19,6 +19,15 @@
  * @{
  */
 
+// ========================================
+// CONSTANTS
+// ========================================
+
+/**
+ * @brief Maximum number of levels of detail a mesh can hold, the mesh itself excluded.
+ */
+#define R3D_MESH_MAX_LODS 4
+
 // ========================================
 // ENUMS TYPES
 // ========================================
@@ -32,6 +41,19 @@ typedef enum R3D_MeshUsage {
     R3D_STREAMED_MESH           ///< Will be update on each frame.
 } R3D_MeshUsage;
 
+/**
+ * @brief Layout of the vertices stored on the GPU.
+ *
+ * The compact format quantizes the attributes of `R3D_Vertex` to 32 bytes per vertex:
+ * positions are 16-bit normalized relative to the mesh bounds, normals and tangents are
+ * octahedral encoded on 2x16 bits, texture coordinates are half floats,
+ * and bone indices and weights are stored on 8 bits.
+ */
+typedef enum R3D_VertexFormat {
+    R3D_VERTEX_FORMAT_FULL,         ///< Attributes stored at full precision, as in `R3D_Vertex`.
+    R3D_VERTEX_FORMAT_COMPACT       ///< Quantized attributes, 32 bytes per vertex instead of 84.
+} R3D_VertexFormat;
+
 /**
  * @brief Defines the geometric primitive type.
  */
@@ -68,21 +90,44 @@ typedef enum R3D_ShadowCastMode {
 // STRUCTS TYPES
 // ========================================
 
+/**
+ * @brief Coarser level of detail of a mesh.
+ *
+ * A level is a range of indices of the mesh's index buffer, referencing the same vertices.
+ * It replaces the previous level once the projected height of the mesh bounds,
+ * as a fraction of the screen height, falls below its screen size.
+ */
+typedef struct R3D_MeshLod {
+    int firstIndex;                         ///< First index of the level in the index buffer.
+    int indexCount;                         ///< Number of indices of the level.
+    float screenSize;                       ///< Screen coverage below which this level is used.
+} R3D_MeshLod;
+
 /**
  * @brief Represents a 3D mesh.
  *
  * Stores vertex and index data, shadow casting settings, bounding box, and layer information.
  * Can represent a static or skinned mesh.
+ *
+ * Vertices are split into a position stream, a skinning stream and a stream of the other attributes,
+ * so that the depth and shadow passes only fetch what they need.
  */
 typedef struct R3D_Mesh {
-    uint32_t vao, vbo, ebo;                 ///< OpenGL objects handles.
+    uint32_t vao, vbo, ebo;                 ///< OpenGL objects handles, `vbo` only holds the positions.
+    uint32_t depthVao;                      ///< Vertex array of the positions and skinning only, used by the depth passes (zero if the vertex colors are translucent).
+    uint32_t skinVbo, attribVbo;            ///< Buffers of the skinning data (zero without bone weights) and of the other attributes.
     int vertexCount, indexCount;            ///< Number of vertices and indices currently in use.
     int allocVertexCount, allocIndexCount;  ///< Number of vertices and indices allocated in GPU buffers.
+    int baseVertex, firstIndex;             ///< Offsets of the mesh inside its buffers (non-zero when sharing buffers with other meshes).
     R3D_ShadowCastMode shadowCastMode;      ///< Shadow casting mode for the mesh.
     R3D_PrimitiveType primitiveType;        ///< Type of primitive that constitutes the vertices.
     R3D_MeshUsage usage;                    ///< Hint about the usage of the mesh, retained in case of update if there is a reallocation.
+    R3D_VertexFormat vertexFormat;          ///< Layout of the vertices in the vertex buffer.
+    BoundingBox quantizationBounds;         ///< Bounds the positions of compact vertices are relative to.
     R3D_Layer layerMask;                    ///< Bitfield indicating the rendering layer(s) of this mesh.
     BoundingBox aabb;                       ///< Axis-Aligned Bounding Box in local space.
+    R3D_MeshLod lods[R3D_MESH_MAX_LODS];    ///< Coarser levels of detail, from the most to the least detailed.
+    int lodCount;                           ///< Number of levels of detail in use.
 } R3D_Mesh;
 
 // ========================================
@@ -101,9 +146,26 @@ extern "C" {
  * @param usage Hint on how the mesh will be used.
  * @return Created R3D_Mesh.
  * @note The function copies all vertex and index data into GPU buffers.
+ * @note Static indexed triangle meshes are sub-allocated from buffers shared with other meshes
+ *       when multi-draw-indirect is supported, so that compatible draws can be merged.
+ *       Their `vbo` and `ebo` handles are then shared, use `baseVertex` and `firstIndex` to locate them.
  */
 R3DAPI R3D_Mesh R3D_LoadMesh(R3D_PrimitiveType type, const R3D_MeshData* data, const BoundingBox* aabb, R3D_MeshUsage usage);
 
+/**
+ * @brief Creates a 3D mesh from CPU-side mesh data with the given vertex format.
+ * @param type Primitive type used to interpret vertex data.
+ * @param data Pointer to the R3D_MeshData containing vertices and indices (cannot be NULL).
+ * @param aabb Optional pointer to a bounding box. If NULL, it will be computed automatically.
+ * @param usage Hint on how the mesh will be used.
+ * @param format Layout of the vertices on the GPU.
+ * @return Created R3D_Mesh.
+ * @note Compact meshes always own their buffers and are never merged into multi-draw commands.
+ * @note Meshes with bone indices outside of [0, 255] fall back to `R3D_VERTEX_FORMAT_FULL`.
+ * @see R3D_LoadMesh
+ */
+R3DAPI R3D_Mesh R3D_LoadMeshEx(R3D_PrimitiveType type, const R3D_MeshData* data, const BoundingBox* aabb, R3D_MeshUsage usage, R3D_VertexFormat format);
+
 /**
  * @brief Destroys a 3D mesh and frees its resources.
  * @param mesh Pointer to the R3D_Mesh to destroy.
@@ -250,6 +312,9 @@ R3DAPI R3D_Mesh R3D_GenMeshCubicmap(Image cubicmap, Vector3 cubeSize);
  * If `aabb` is provided, it will be used as the mesh's bounding box; if null,
  * the bounding box is automatically recalculated from the vertex data.
  *
+ * The buffers of `R3D_STREAMED_MESH` meshes are reallocated on every update, so that
+ * the driver orphans the previous storage instead of waiting for the GPU to finish reading it.
+ *
  * @param mesh Pointer to the mesh structure to upload or update.
  * @param data Pointer to the mesh data (vertices and indices) to upload.
  * @param aabb Optional bounding box; if null, it is recalculated automatically.
@@ -257,6 +322,53 @@ R3DAPI R3D_Mesh R3D_GenMeshCubicmap(Image cubicmap, Vector3 cubeSize);
  */
 R3DAPI bool R3D_UpdateMesh(R3D_Mesh* mesh, const R3D_MeshData* data, const BoundingBox* aabb);
 
+/**
+ * @brief Rewrites a range of vertices of a mesh on the GPU.
+ *
+ * Only the given vertices are uploaded, the indices, the levels of detail and the vertex count
+ * of the mesh are kept. The range must lie within the current vertices of the mesh.
+ * The bounding box is not recalculated, `aabb` of the mesh must be updated by the caller if needed.
+ *
+ * Compact meshes keep their quantization bounds, the vertices must remain inside them.
+ * Bone weights can only be written to meshes that already have some.
+ * Use `R3D_UpdateMesh()` when these conditions are not met.
+ *
+ * Unlike `R3D_UpdateMesh()`, the storage of streamed meshes is not orphaned,
+ * since the vertices outside of the range must be preserved.
+ *
+ * @param mesh Pointer to the mesh to update.
+ * @param firstVertex Index of the first vertex to rewrite.
+ * @param vertexCount Number of vertices to rewrite.
+ * @param vertices The new vertices, `vertexCount` of them.
+ * @return Returns true if the update is successful, false otherwise.
+ */
+R3DAPI bool R3D_UpdateMeshRange(R3D_Mesh* mesh, int firstVertex, int vertexCount, const R3D_Vertex* vertices);
+
+/**
+ * @brief Appends a coarser level of detail to an indexed mesh.
+ *
+ * The indices reference the vertices of the mesh and are uploaded next to its own indices.
+ * Levels must be added from the most to the least detailed, with decreasing screen sizes.
+ * The level is selected when the projected height of the mesh bounds falls below
+ * `screenSize`, expressed as a fraction of the screen height.
+ *
+ * Instanced draws always use the full mesh. Updating the mesh drops all its levels.
+ *
+ * @param mesh Pointer to the mesh receiving the level.
+ * @param indices Indices of the level, relative to the vertices of the mesh.
+ * @param indexCount Number of indices.
+ * @param screenSize Screen coverage below which the level is used, between 0 and 1.
+ * @return True if the level has been added, false otherwise.
+ */
+R3DAPI bool R3D_AddMeshLod(R3D_Mesh* mesh, const uint32_t* indices, int indexCount, float screenSize);
+
+/**
+ * @brief Removes all the levels of detail of a mesh.
+ *
+ * @param mesh Pointer to the mesh.
+ */
+R3DAPI void R3D_ClearMeshLods(R3D_Mesh* mesh);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
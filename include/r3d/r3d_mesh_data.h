@@ -340,6 +340,42 @@ R3DAPI void R3D_GenMeshDataTangents(R3D_MeshData* meshData);
  */
 R3DAPI BoundingBox R3D_CalculateMeshDataBoundingBox(const R3D_MeshData* meshData);
 
+/**
+ * @brief Simplifies the triangles of the mesh by collapsing its edges.
+ *
+ * Edges are collapsed onto their existing vertices following their quadric error,
+ * so the resulting indices still reference the vertices of the mesh and can be used
+ * as a level of detail with `R3D_AddMeshLod()`. Open borders and attribute seams
+ * (normals, UVs, tangents, colors, bone weights) only collapse along themselves.
+ *
+ * Simplification stops once the index count reaches the target, or when the next
+ * collapse would exceed the target error. Errors are relative to the size of the mesh,
+ * 0.01 being one percent of its largest extent.
+ *
+ * @param meshData Mesh data to simplify; non-indexed data is treated as a triangle list.
+ * @param indices Destination of the new indices, large enough to hold the original ones; may be the indices of the mesh data.
+ * @param targetIndexCount Number of indices to reach.
+ * @param targetError Maximum error allowed.
+ * @param resultError Optional pointer receiving the error of the result.
+ * @return The number of indices written, 0 on failure.
+ */
+R3DAPI int R3D_SimplifyMeshData(const R3D_MeshData* meshData, uint32_t* indices, int targetIndexCount, float targetError, float* resultError);
+
+/**
+ * @brief Reorders the triangles and vertices of the mesh for faster rendering.
+ *
+ * Three passes are applied in order: triangles are sorted to maximize the hits of
+ * the post-transform vertex cache, clusters of triangles are then sorted so that
+ * the outer ones are drawn first to reduce overdraw, and finally vertices are
+ * sorted in their order of first use for sequential fetching.
+ *
+ * The geometry is left unchanged. Non-indexed mesh data is left untouched.
+ * Models loaded from files are optimized automatically.
+ *
+ * @param meshData Mesh data to optimize.
+ */
+R3DAPI void R3D_OptimizeMeshData(R3D_MeshData* meshData);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
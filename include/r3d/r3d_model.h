@@ -42,9 +42,26 @@ typedef struct R3D_Model {
     R3D_Skeleton skeleton;              ///< Skeleton hierarchy and bind pose used for skinning (NULL if non-skinned).
 
     R3D_AnimationPlayer* player;        ///< Animation player controlling the skeleton. If NULL the model uses its bind pose.
+    const R3D_BakedAnimationLib* bakedAnimations;   ///< Baked animations of the instance buffers with R3D_INSTANCE_ANIMATION (may be NULL).
 
 } R3D_Model;
 
+/**
+ * @brief Status of an asynchronous model request.
+ */
+typedef enum R3D_ModelRequestStatus {
+    R3D_MODEL_REQUEST_PENDING,          ///< The model is still loading.
+    R3D_MODEL_REQUEST_READY,            ///< The model is fully loaded.
+    R3D_MODEL_REQUEST_FAILED,           ///< The model could not be loaded.
+} R3D_ModelRequestStatus;
+
+/**
+ * @brief Opaque handle of a model being loaded asynchronously.
+ *
+ * @see R3D_LoadModelAsync()
+ */
+typedef struct R3D_ModelRequest R3D_ModelRequest;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -97,6 +114,26 @@ R3DAPI R3D_Model R3D_LoadModelFromMemory(const void* data, unsigned int size, co
  */
 R3DAPI R3D_Model R3D_LoadModelFromMesh(const R3D_Mesh* mesh);
 
+/**
+ * @brief Merge placed static models into a model with one mesh per material and cell.
+ *
+ * The meshes of every model are transformed to world space and grouped by material,
+ * shadow cast mode and layer mask, then split into a grid of cubic cells so that
+ * each merged mesh can still be frustum culled. The result is drawn with an identity transform.
+ *
+ * @param models Array of models to merge.
+ * @param transforms World transform of each model.
+ * @param count Number of models.
+ * @param cellSize Edge length of the grid cells, zero or less merges everything into a single cell.
+ *
+ * @return Batched model, or a model without meshes if nothing could be merged.
+ *
+ * @note Skinned meshes, non-triangle meshes and billboarded materials are left out,
+ *       levels of detail are dropped. The materials are shallow copies of the source ones,
+ *       unload the batch with unloadMaterials set to false while the source models are alive.
+ */
+R3DAPI R3D_Model R3D_BuildStaticBatch(const R3D_Model* models, const Matrix* transforms, int count, float cellSize);
+
 /**
  * @brief Unload a model and optionally its materials.
  *
@@ -109,6 +146,117 @@ R3DAPI R3D_Model R3D_LoadModelFromMesh(const R3D_Mesh* mesh);
  */
 R3DAPI void R3D_UnloadModel(R3D_Model* model, bool unloadMaterials);
 
+/**
+ * @brief Save a model to a binary cache file.
+ *
+ * Writes the meshes exactly as they are stored on the GPU (vertex streams, indices and levels of detail),
+ * the material parameters with the pixels of their textures, and the skeleton.
+ * The file can then be loaded with R3D_LoadModelCache() without going through the importer.
+ *
+ * @param model Pointer to the model to save.
+ * @param filePath Path of the cache file to write.
+ *
+ * @return True on success, the file is removed on failure.
+ *
+ * @note The vertex layout and the byte order are those of the running build, the cache is not meant to be shared
+ *       between platforms. Custom shaders, animations and compressed textures are not stored.
+ */
+R3DAPI bool R3D_SaveModelCache(const R3D_Model* model, const char* filePath);
+
+/**
+ * @brief Load a model from a binary cache file.
+ *
+ * The file is mapped in memory and its vertex and index blobs are uploaded directly,
+ * without any parsing, conversion or optimization of the meshes.
+ *
+ * @param filePath Path of a file written by R3D_SaveModelCache().
+ *
+ * @return Loaded model, or a model without meshes if the file is missing, outdated or corrupted.
+ */
+R3DAPI R3D_Model R3D_LoadModelCache(const char* filePath);
+
+/**
+ * @brief Load a 3D model through a binary cache file.
+ *
+ * Loads the cache if it is more recent than the model file, otherwise imports
+ * the model with R3D_LoadModel() and writes the cache for the next loads.
+ *
+ * @param filePath Path to the 3D model file to load.
+ * @param cachePath Path of the cache file to read or to write.
+ *
+ * @return Loaded model structure containing meshes and materials.
+ */
+R3DAPI R3D_Model R3D_LoadModelCached(const char* filePath, const char* cachePath);
+
+/**
+ * @brief Start loading a 3D model in the background.
+ *
+ * The file is parsed, its textures decoded and its meshes converted by worker threads.
+ * The GPU uploads are left to R3D_PumpUploads(), which must be called every frame
+ * from the thread owning the OpenGL context until the request is no longer pending.
+ *
+ * The loading settings (texture filter, compression, vertex format, LODs) are captured by this call.
+ *
+ * @param filePath Path to the 3D model file to load.
+ *
+ * @return Handle of the request, to be released with R3D_FinishModelRequest(), or NULL on failure.
+ */
+R3DAPI R3D_ModelRequest* R3D_LoadModelAsync(const char* filePath);
+
+/**
+ * @brief Perform the GPU uploads of the pending model requests.
+ *
+ * Uploads textures and meshes until the time budget is spent, at least one upload
+ * is done per call when one is available. The materials and the skeleton are created
+ * by the call that completes the request.
+ *
+ * @param budgetMs Time budget in milliseconds.
+ */
+R3DAPI void R3D_PumpUploads(float budgetMs);
+
+/**
+ * @brief Get the status of an asynchronous model request.
+ *
+ * @param request Request to query.
+ *
+ * @return Current status of the request.
+ */
+R3DAPI R3D_ModelRequestStatus R3D_GetModelRequestStatus(const R3D_ModelRequest* request);
+
+/**
+ * @brief Get the loading progress of an asynchronous model request.
+ *
+ * @param request Request to query.
+ *
+ * @return Ratio of the textures and meshes uploaded, from 0 to 1.
+ */
+R3DAPI float R3D_GetModelRequestProgress(const R3D_ModelRequest* request);
+
+/**
+ * @brief Get the model of an asynchronous request.
+ *
+ * Until the request is ready, an empty model is returned so it can be drawn without checks.
+ * The returned model remains owned by the request.
+ *
+ * @param request Request to query.
+ *
+ * @return Pointer to the loaded model, or to an empty model.
+ */
+R3DAPI const R3D_Model* R3D_GetModelRequestModel(const R3D_ModelRequest* request);
+
+/**
+ * @brief Release an asynchronous model request.
+ *
+ * If the request is ready, the ownership of its model is given to the caller.
+ * A pending request is cancelled, its loading threads are joined and its resources released.
+ * Every request must be finished before closing R3D.
+ *
+ * @param request Request to release.
+ *
+ * @return Loaded model, or an empty model if the request was not ready.
+ */
+R3DAPI R3D_Model R3D_FinishModelRequest(R3D_ModelRequest* request);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
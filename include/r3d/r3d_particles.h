@@ -11,6 +11,7 @@
 
 #include "./r3d_platform.h"
 #include "./r3d_curves.h"
+#include "./r3d_instance.h"
 #include <raylib.h>
 
 /**
@@ -19,47 +20,93 @@
  */
 
 // ========================================
-// STRUCTS TYPES
+// ENUM TYPES
 // ========================================
 
 /**
- * @struct R3D_Particle
- * @brief Represents a particle in a 3D particle system, with properties
- *        such as position, velocity, rotation, and color modulation.
+ * @brief Where the particles of a particle system are simulated.
  */
-typedef struct R3D_Particle {
-
-    float lifetime;                 ///< Duration of the particle's existence in seconds.
-
-    Matrix transform;               ///< The particle's current transformation matrix in 3D space.
+typedef enum R3D_ParticleMode {
+    R3D_PARTICLE_MODE_CPU,      ///< Simulated on the CPU, the compact instances are uploaded once per frame when drawn.
+    R3D_PARTICLE_MODE_GPU       ///< Simulated by a compute shader, the particles never leave the GPU (requires OpenGL 4.3).
+} R3D_ParticleMode;
 
-    Vector3 position;               ///< The current position of the particle in 3D space.
-    Vector3 rotation;               ///< The current rotation of the particle in 3D space (Euler angles).
-    Vector3 scale;                  ///< The current scale of the particle in 3D space.
-    Color color;                    ///< The current color of the particle, representing its color modulation.
-
-    Vector3 velocity;               ///< The current velocity of the particle in 3D space.
-    Vector3 angularVelocity;        ///< The current angular velocity of the particle in radians (Euler angles).
+/**
+ * @brief Components of the particles stored by a particle system.
+ *
+ * Each component is stored in its own array of floats, indexed by particle,
+ * the components of a vector follow each other in the X, Y, Z order.
+ */
+typedef enum R3D_ParticleStream {
+    R3D_PARTICLE_LIFETIME,                  ///< Remaining lifetime of the particle in seconds.
+    R3D_PARTICLE_POSITION_X,                ///< Current position of the particle in 3D space.
+    R3D_PARTICLE_POSITION_Y,
+    R3D_PARTICLE_POSITION_Z,
+    R3D_PARTICLE_ROTATION_X,                ///< Current rotation of the particle in radians (Euler angles).
+    R3D_PARTICLE_ROTATION_Y,
+    R3D_PARTICLE_ROTATION_Z,
+    R3D_PARTICLE_SCALE_X,                   ///< Current scale of the particle.
+    R3D_PARTICLE_SCALE_Y,
+    R3D_PARTICLE_SCALE_Z,
+    R3D_PARTICLE_VELOCITY_X,                ///< Current velocity of the particle.
+    R3D_PARTICLE_VELOCITY_Y,
+    R3D_PARTICLE_VELOCITY_Z,
+    R3D_PARTICLE_ANGULAR_VELOCITY_X,        ///< Current angular velocity of the particle in degrees (Euler angles).
+    R3D_PARTICLE_ANGULAR_VELOCITY_Y,
+    R3D_PARTICLE_ANGULAR_VELOCITY_Z,
+    R3D_PARTICLE_BASE_SCALE_X,              ///< Initial scale of the particle.
+    R3D_PARTICLE_BASE_SCALE_Y,
+    R3D_PARTICLE_BASE_SCALE_Z,
+    R3D_PARTICLE_BASE_VELOCITY_X,           ///< Initial velocity of the particle.
+    R3D_PARTICLE_BASE_VELOCITY_Y,
+    R3D_PARTICLE_BASE_VELOCITY_Z,
+    R3D_PARTICLE_BASE_ANGULAR_VELOCITY_X,   ///< Initial angular velocity of the particle in degrees (Euler angles).
+    R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Y,
+    R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Z,
+    R3D_PARTICLE_BASE_OPACITY,              ///< Initial opacity of the particle, from 0 to 255.
+    R3D_PARTICLE_STREAM_COUNT
+} R3D_ParticleStream;
 
-    Vector3 baseScale;              ///< The initial scale of the particle in 3D space.
-    Vector3 baseVelocity;           ///< The initial velocity of the particle in 3D space.
-    Vector3 baseAngularVelocity;    ///< The initial angular velocity of the particle in radians (Euler angles).
-    unsigned char baseOpacity;      ///< The initial opacity of the particle, ranging from 0 (fully transparent) to 255 (fully opaque).
+// ========================================
+// STRUCTS TYPES
+// ========================================
 
-} R3D_Particle;
+/**
+ * @brief Compact instance of a particle, expanded into a transformation matrix by the vertex shader.
+ *
+ * Records are 32 bytes, half the size of a matrix, and are written by the simulation
+ * so that drawing a system only copies them into the instance stream once per frame.
+ * The rotation and scale are stored as half floats, their last component is unused.
+ */
+typedef struct R3D_ParticleInstance {
+    Vector3 position;                   ///< Position of the particle.
+    Color color;                        ///< Color of the particle, its alpha includes the opacity curve.
+    uint16_t rotation[4];               ///< Rotation of the particle in radians (Euler angles), wrapped to [-PI, PI].
+    uint16_t scale[4];                  ///< Scale of the particle.
+} R3D_ParticleInstance;
 
 /**
- * @brief Represents a CPU-based particle system with various properties and settings.
+ * @brief Represents a particle system with various properties and settings.
  *
  * This structure contains configuration data for a particle system, such as mesh information, initial properties,
  * curves for controlling properties over time, and settings for shadow casting, emission rate, and more.
+ *
+ * The settings are shared by both simulation modes. In GPU mode, the per-particle arrays are NULL,
+ * the particles only exist in GPU buffers and `count` stays at zero.
  */
 typedef struct R3D_ParticleSystem {
 
-    R3D_Particle* particles;            ///< Pointer to the array of particles in the system.
+    R3D_ParticleInstance* instances;    ///< Instance record of each active particle, see `R3D_ParticleInstance`.
+    float* streams[R3D_PARTICLE_STREAM_COUNT];  ///< Simulation state of the particles, one array of 'capacity' floats per component.
     int capacity;                       ///< The maximum number of particles the system can manage.
     int count;                          ///< The current number of active particles in the system.
 
+    R3D_ParticleMode mode;              ///< Where the particles are simulated, chosen at load time.
+    R3D_InstanceBuffer instanceBuffer;  ///< Instances written by the simulation in GPU mode (internal).
+    uint32_t ssboParticles;             ///< Simulation state of the particles in GPU mode (internal).
+    int pendingEmissions;               ///< Particles emitted on the GPU at the next update (internal).
+    uint32_t seed;                      ///< Random state of the emission, and seed of the next GPU update (internal).
+
     Vector3 position;                   ///< The initial position of the particle system. Default: (0, 0, 0).
     Vector3 gravity;                    ///< The gravity applied to the particles. Default: (0, -9.81, 0).
 
@@ -90,7 +137,13 @@ typedef struct R3D_ParticleSystem {
     R3D_InterpolationCurve* opacityOverLifetime;            ///< Curve controlling the opacity evolution of the particles over their lifetime. Default: NULL.
     R3D_InterpolationCurve* angularVelocityOverLifetime;    ///< Curve controlling the angular velocity evolution of the particles over their lifetime. Default: NULL.
 
-    BoundingBox aabb;                   ///< For frustum culling. Defaults to a large AABB; compute manually via `R3D_CalculateParticleSystemBoundingBox` after setup.
+    BoundingBox aabb;                   /**< For frustum culling, in the local space of the system. Refitted to the positions of the live particles
+                                         *   by each update when `autoBounds` is set, otherwise defaults to a large AABB.
+                                         */
+    float boundsScale;                  ///< Largest scale of the live particles, pads `aabb` by the mesh size when drawn with `autoBounds` (internal).
+    bool autoBounds;                    /**< Indicates whether `aabb` follows the live particles. Default: true in CPU mode, false in GPU mode.
+                                         *   Cleared by `R3D_CalculateParticleSystemBoundingBox`, which computes a fixed estimate instead.
+                                         */
 
     bool autoEmission;                  /**< Indicates whether particle emission is automatic when calling `R3D_UpdateParticleSystem`.
                                          *   If false, emission is manual using `R3D_EmitParticle`. Default: true.
@@ -124,6 +177,20 @@ extern "C" {
  */
 R3DAPI R3D_ParticleSystem R3D_LoadParticleSystem(int maxParticles);
 
+/**
+ * @brief Loads a particle emitter system simulated on the CPU or on the GPU.
+ *
+ * In GPU mode, emission, lifetime, curves and integration run in a compute shader and the
+ * particles are drawn straight from the simulation output. All the settings of the system keep
+ * their meaning, the curves are sampled each update. Falls back to the CPU mode with a warning
+ * when compute shaders are not supported.
+ *
+ * @param maxParticles The maximum number of particles the system can handle at once.
+ * @param mode Where the particles are simulated.
+ * @return A newly initialized `R3D_ParticleSystem` structure.
+ */
+R3DAPI R3D_ParticleSystem R3D_LoadParticleSystemEx(int maxParticles, R3D_ParticleMode mode);
+
 /**
  * @brief Unloads the particle emitter system and frees allocated memory.
  *
@@ -140,7 +207,9 @@ R3DAPI void R3D_UnloadParticleSystem(R3D_ParticleSystem* system);
  * This function triggers the emission of a new particle in the particle system. It handles the logic of adding a new
  * particle to the system and initializing its properties based on the current state of the system.
  *
- * @param system A pointer to the `R3D_ParticleSystemCPU` where the particle will be emitted.
+ * In GPU mode, the emission is deferred to the next update and is only performed if a particle slot is free by then.
+ *
+ * @param system A pointer to the `R3D_ParticleSystem` where the particle will be emitted.
  * @return `true` if the particle was successfully emitted, `false` if the system is at full capacity and cannot emit more particles.
  */
 R3DAPI bool R3D_EmitParticle(R3D_ParticleSystem* system);
@@ -156,6 +225,24 @@ R3DAPI bool R3D_EmitParticle(R3D_ParticleSystem* system);
  */
 R3DAPI void R3D_UpdateParticleSystem(R3D_ParticleSystem* system, float deltaTime);
 
+/**
+ * @brief Updates several particle systems at once, spreading the work over multiple threads.
+ *
+ * Emission is performed on the calling thread, then the live particles of all the CPU systems
+ * are split into chunks simulated in parallel. Large systems thus benefit from the threads even
+ * when updated alone, which `R3D_UpdateParticleSystem` does through this function.
+ * Up to 16 chunks of 16384 particles are listed without any allocation, and a single chunk
+ * is simulated on the calling thread without starting any thread.
+ *
+ * @warning Each system must appear only once in the array. The chunks of a system listed
+ *          twice would be simulated and compacted by two threads at the same time.
+ *
+ * @param systems Array of pointers to the particle systems to update.
+ * @param count Number of systems in the array.
+ * @param deltaTime The time elapsed since the last update (in seconds).
+ */
+R3DAPI void R3D_UpdateParticleSystems(R3D_ParticleSystem** systems, int count, float deltaTime);
+
 /**
  * @brief Computes and updates the AABB (Axis-Aligned Bounding Box) of a particle system.
  *
@@ -164,6 +251,9 @@ R3DAPI void R3D_UpdateParticleSystem(R3D_ParticleSystem* system, float deltaTime
  * which is then stored in the system's `aabb` field. This is useful for enabling frustum culling,
  * especially when the bounds are not known beforehand.
  *
+ * The estimate is kept as is and `autoBounds` is cleared. CPU systems already refit their bounds
+ * on each update, so this is mostly useful in GPU mode.
+ *
  * @param system Pointer to the `R3D_ParticleSystem` to update.
  */
 R3DAPI void R3D_CalculateParticleSystemBoundingBox(R3D_ParticleSystem* system);
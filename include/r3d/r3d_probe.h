@@ -0,0 +1,287 @@
+/* r3d_probe.h -- R3D Reflection Probe Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_PROBE_H
+#define R3D_PROBE_H
+
+#include "./r3d_platform.h"
+#include <raylib.h>
+#include <stdint.h>
+
+/**
+ * @defgroup ReflectionProbe
+ * @{
+ */
+
+// ========================================
+// ENUMS TYPES
+// ========================================
+
+/**
+ * @brief Modes for updating reflection probes.
+ *
+ * Determines when the cubemap of a probe is captured again.
+ */
+typedef enum R3D_ProbeUpdateMode {
+    R3D_PROBE_UPDATE_ONCE,              ///< The probe is captured once, then only on R3D_UpdateReflectionProbe().
+    R3D_PROBE_UPDATE_ALWAYS             ///< The probe is captured again as soon as a capture completes.
+} R3D_ProbeUpdateMode;
+
+// ========================================
+// ALIASES TYPES
+// ========================================
+
+/**
+ * @brief Unique identifier for an R3D reflection probe.
+ *
+ * ID type used to reference a reflection probe.
+ * A negative value indicates an invalid probe.
+ */
+typedef int32_t R3D_ReflectionProbe;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ----------------------------------------
+// PROBE: Probes Config Functions
+// ----------------------------------------
+
+/**
+ * @brief Creates a new reflection probe.
+ *
+ * The probe replaces the specular reflections of the skybox inside its bounds,
+ * with a parallax correction against the same box. Overlapping probes are blended,
+ * the smallest ones taking precedence. The probe is captured from the center of its bounds
+ * by default, its first capture is requested immediately.
+ *
+ * Requires the 'GL_ARB_texture_cube_map_array' extension, and a skybox set in the environment.
+ * At most 16 probes can exist at once, and 8 are blended in a frame.
+ *
+ * @param bounds The volume influenced by the probe, in world space.
+ * @return The ID of the created probe, or -1 on failure.
+ */
+R3DAPI R3D_ReflectionProbe R3D_CreateReflectionProbe(BoundingBox bounds);
+
+/**
+ * @brief Destroys the specified reflection probe.
+ *
+ * @param id The ID of the probe to destroy.
+ */
+R3DAPI void R3D_DestroyReflectionProbe(R3D_ReflectionProbe id);
+
+/**
+ * @brief Checks if a reflection probe exists.
+ *
+ * @param id The ID of the probe to check.
+ * @return True if the probe exists, false otherwise.
+ */
+R3DAPI bool R3D_IsReflectionProbeExist(R3D_ReflectionProbe id);
+
+/**
+ * @brief Checks if a reflection probe is active.
+ *
+ * @param id The ID of the probe.
+ * @return True if the probe is active, false otherwise.
+ */
+R3DAPI bool R3D_IsReflectionProbeActive(R3D_ReflectionProbe id);
+
+/**
+ * @brief Enables or disables a reflection probe.
+ *
+ * Inactive probes are neither blended nor captured.
+ *
+ * @param id The ID of the probe.
+ * @param active True to enable the probe, false to disable it.
+ */
+R3DAPI void R3D_SetReflectionProbeActive(R3D_ReflectionProbe id, bool active);
+
+/**
+ * @brief Gets the bounds of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The volume influenced by the probe.
+ */
+R3DAPI BoundingBox R3D_GetReflectionProbeBounds(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the bounds of a reflection probe.
+ *
+ * The capture position is kept, the probe is not captured again.
+ *
+ * @param id The ID of the probe.
+ * @param bounds The volume influenced by the probe, in world space.
+ */
+R3DAPI void R3D_SetReflectionProbeBounds(R3D_ReflectionProbe id, BoundingBox bounds);
+
+/**
+ * @brief Gets the capture position of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The position the cubemap is captured from.
+ */
+R3DAPI Vector3 R3D_GetReflectionProbePosition(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the capture position of a reflection probe.
+ *
+ * The position should be inside the bounds. The next capture uses it,
+ * call R3D_UpdateReflectionProbe() to request one.
+ *
+ * @param id The ID of the probe.
+ * @param position The position the cubemap is captured from.
+ */
+R3DAPI void R3D_SetReflectionProbePosition(R3D_ReflectionProbe id, Vector3 position);
+
+/**
+ * @brief Gets the blend distance of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The distance inside the bounds over which the probe fades out.
+ */
+R3DAPI float R3D_GetReflectionProbeBlendDistance(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the blend distance of a reflection probe.
+ *
+ * The probe fades out over this distance inside its bounds,
+ * into the larger probes around it or into the skybox. Default is 1.0.
+ *
+ * @param id The ID of the probe.
+ * @param distance The blend distance, in world units.
+ */
+R3DAPI void R3D_SetReflectionProbeBlendDistance(R3D_ReflectionProbe id, float distance);
+
+/**
+ * @brief Gets the intensity of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The multiplier of the captured radiance.
+ */
+R3DAPI float R3D_GetReflectionProbeIntensity(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the intensity of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @param intensity The multiplier of the captured radiance. Default is 1.0.
+ */
+R3DAPI void R3D_SetReflectionProbeIntensity(R3D_ReflectionProbe id, float intensity);
+
+/**
+ * @brief Gets the importance of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The scheduling priority of the captures.
+ */
+R3DAPI float R3D_GetReflectionProbeImportance(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the importance of a reflection probe.
+ *
+ * Pending captures are scheduled by importance, divided by the distance to the camera
+ * and multiplied by the frames they have waited. Probes never captured always come first.
+ *
+ * @param id The ID of the probe.
+ * @param importance The scheduling priority of the captures. Default is 1.0.
+ */
+R3DAPI void R3D_SetReflectionProbeImportance(R3D_ReflectionProbe id, float importance);
+
+/**
+ * @brief Gets the update mode of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @return The update mode of the probe.
+ */
+R3DAPI R3D_ProbeUpdateMode R3D_GetReflectionProbeUpdateMode(R3D_ReflectionProbe id);
+
+/**
+ * @brief Sets the update mode of a reflection probe.
+ *
+ * @param id The ID of the probe.
+ * @param mode The update mode of the probe. Default is R3D_PROBE_UPDATE_ONCE.
+ */
+R3DAPI void R3D_SetReflectionProbeUpdateMode(R3D_ReflectionProbe id, R3D_ProbeUpdateMode mode);
+
+/**
+ * @brief Requests a new capture of a reflection probe.
+ *
+ * The previous capture remains in use until the new one is complete.
+ *
+ * @param id The ID of the probe.
+ */
+R3DAPI void R3D_UpdateReflectionProbe(R3D_ReflectionProbe id);
+
+// ----------------------------------------
+// PROBE: Capture Functions
+// ----------------------------------------
+
+/**
+ * @brief Begins the capture of a reflection probe face.
+ *
+ * Call it once per frame, before the regular rendering. When a capture is pending,
+ * it begins a frame like R3D_Begin() from the next probe face to capture,
+ * the scene must then be drawn as usual and the frame ended with R3D_End().
+ * A probe is complete after six captures, the faces are captured one per call.
+ *
+ * The captures are rendered without post-processing, screen space effects and occlusion culling,
+ * and only reflect the skybox.
+ *
+ * @code
+ * if (R3D_BeginReflectionProbeCapture()) {
+ *     DrawScene();
+ *     R3D_End();
+ * }
+ * R3D_Begin(camera);
+ *     DrawScene();
+ * R3D_End();
+ * @endcode
+ *
+ * @return True if a capture has begun, false if no capture is pending.
+ */
+R3DAPI bool R3D_BeginReflectionProbeCapture(void);
+
+// ----------------------------------------
+// PROBE: Baking Functions
+// ----------------------------------------
+
+/**
+ * @brief Saves the captured cubemap of a reflection probe.
+ *
+ * All the prefiltered levels are read back from the GPU and written as half floats.
+ * Only the captured lighting is saved, not the settings of the probe.
+ *
+ * @param id The ID of the probe, it must have been captured.
+ * @param filePath The path of the file to write.
+ * @return True if the file was written successfully.
+ */
+R3DAPI bool R3D_SaveReflectionProbe(R3D_ReflectionProbe id, const char* filePath);
+
+/**
+ * @brief Loads a cubemap saved with R3D_SaveReflectionProbe() into a reflection probe.
+ *
+ * The probe is marked as captured, no capture is needed before it is used.
+ * Probes in R3D_PROBE_UPDATE_ALWAYS mode are still captured again.
+ *
+ * @param id The ID of the probe.
+ * @param filePath The path to the baked probe file.
+ * @return True if the probe was loaded successfully.
+ */
+R3DAPI bool R3D_LoadReflectionProbeBaked(R3D_ReflectionProbe id, const char* filePath);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of ReflectionProbe
+
+#endif // R3D_PROBE_H
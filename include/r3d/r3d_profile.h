@@ -0,0 +1,141 @@
+/* r3d_profile.h -- R3D Profiling Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_PROFILE_H
+#define R3D_PROFILE_H
+
+#include "./r3d_platform.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup Profile
+ * @brief GPU timings of the render passes, enabled with `R3D_FLAG_GPU_PROFILING`,
+ *        and CPU statistics of each frame.
+ * @{
+ */
+
+// ========================================
+// ENUMS TYPES
+// ========================================
+
+/**
+ * @brief Render passes measured by the profiler.
+ *
+ * Passes skipped during a frame report a time of zero.
+ */
+typedef enum R3D_ProfilePass {
+    R3D_PROFILE_SHADOWS,            ///< Shadow maps updated this frame, all lights together
+    R3D_PROFILE_GEOMETRY,           ///< Deferred geometry into the G-buffer
+    R3D_PROFILE_DEPTH_PYRAMID,      ///< Depth pyramid for the occlusion culling and the reflections
+    R3D_PROFILE_DECALS,             ///< Decals projected onto the G-buffer
+    R3D_PROFILE_SSAO,               ///< Screen space ambient occlusion, blur or accumulation included
+    R3D_PROFILE_LIGHTING,           ///< Deferred direct lighting
+    R3D_PROFILE_SSIL,               ///< Screen space indirect lighting, blur or accumulation included
+    R3D_PROFILE_SSR,                ///< Screen space reflections
+    R3D_PROFILE_AMBIENT,            ///< Ambient lighting and composition of the deferred lighting
+    R3D_PROFILE_BACKGROUND,         ///< Skybox or background color
+    R3D_PROFILE_FORWARD,            ///< Forward and prepass geometry
+    R3D_PROFILE_FOG,                ///< Fog, when not fused into the output
+    R3D_PROFILE_DOF,                ///< Depth of field
+    R3D_PROFILE_BLOOM,              ///< Bloom downsampling and upsampling
+    R3D_PROFILE_OUTPUT,             ///< Output composition and tonemapping
+    R3D_PROFILE_ANTI_ALIASING,      ///< FXAA or TAA
+    R3D_PROFILE_PASS_COUNT
+} R3D_ProfilePass;
+
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief GPU timings of a frame, in milliseconds.
+ *
+ * The timings are read back a few frames late, without waiting for the GPU.
+ *
+ * @see R3D_FLAG_GPU_PROFILING
+ */
+typedef struct R3D_FrameProfile {
+    float passTime[R3D_PROFILE_PASS_COUNT]; ///< GPU time of each pass, indexed by R3D_ProfilePass
+    float totalTime;                        ///< GPU time of the whole R3D_End(), passes not listed included
+    uint32_t frame;                         ///< Index of the frame measured, counted since R3D_Init()
+    bool valid;                             ///< False until a first frame has been measured
+} R3D_FrameProfile;
+
+/**
+ * @brief CPU counters of a frame.
+ *
+ * The counters cover everything done since the previous `R3D_End()` of the camera,
+ * the probe faces captured in between are included. They are always recorded.
+ */
+typedef struct R3D_FrameStats {
+    int drawGroups;                         ///< Draw groups pushed, retained scene included
+    int drawCalls;                          ///< Draw calls pushed, retained scene included
+    int viewCulledCalls;                    ///< Calls culled by the camera passes, once per pass that tested them
+    int shadowCulledCalls;                  ///< Calls culled by the shadow passes, once per light view that tested them
+    int drawCommands;                       ///< Draw commands sent to the driver, a multi-draw counts as one
+    int instancesDrawn;                     ///< Instances drawn, before the GPU instance culling
+    int64_t trianglesSubmitted;             ///< Triangles submitted, before the GPU instance culling
+    int programBinds;                       ///< Shader programs bound, redundant binds excluded
+    int textureBinds;                       ///< Textures bound, redundant binds excluded
+    int vaoBinds;                           ///< Vertex arrays bound, redundant binds excluded
+    int uniformUploads;                     ///< Uniforms sent to the built-in shaders, unchanged values excluded
+    int shadowMapsUpdated;                  ///< Lights whose shadow map has been rendered
+    size_t instanceBytes;                   ///< Bytes written for the instances, streamed or uploaded to instance buffers
+    size_t boneBytes;                       ///< Bytes of bone matrices uploaded
+    float cullingTime;                      ///< CPU time spent culling the lights, groups and scene for the camera, in milliseconds
+    float sortingTime;                      ///< CPU time spent sorting the draw lists, in milliseconds
+    float passTime[R3D_PROFILE_PASS_COUNT]; ///< CPU time spent recording each pass, in milliseconds
+} R3D_FrameStats;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Returns the GPU timings of the most recent frame available.
+ *
+ * Requires `R3D_FLAG_GPU_PROFILING`, the timings are invalid otherwise.
+ * The frames are measured with timestamp queries, up to three frames in flight.
+ *
+ * @return The timings of the last frame read back.
+ */
+R3DAPI R3D_FrameProfile R3D_GetFrameProfile(void);
+
+/**
+ * @brief Returns the CPU statistics of the last frame.
+ *
+ * The counters are updated by each `R3D_End()` that renders the camera.
+ *
+ * @return The counters of the last frame rendered.
+ */
+R3DAPI R3D_FrameStats R3D_GetFrameStats(void);
+
+/**
+ * @brief Returns the name of a profiled pass.
+ *
+ * The same names label the debug groups of the passes, visible in RenderDoc or Nsight
+ * when OpenGL 4.3 is available.
+ *
+ * @param pass The pass.
+ * @return A static string, "Unknown" for an invalid pass.
+ */
+R3DAPI const char* R3D_GetProfilePassName(R3D_ProfilePass pass);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of Profile
+
+#endif // R3D_PROFILE_H
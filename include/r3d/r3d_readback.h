@@ -0,0 +1,189 @@
+/* r3d_readback.h -- R3D Readback Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_READBACK_H
+#define R3D_READBACK_H
+
+#include "./r3d_platform.h"
+#include <raylib.h>
+
+/**
+ * @defgroup Readback
+ * @brief Asynchronous reading of rendered targets, for batches of offscreen renders.
+ *
+ * `LoadImageFromTexture()` waits for the GPU to finish the frame before copying its pixels,
+ * so each render of a batch stalls the next one. A readback queue copies the target into
+ * one of its pixel buffers instead, the copy is done by the GPU after the frame, and the
+ * pixels are retrieved later, typically while the following renders are in flight.
+ *
+ * A batch renders each item with `R3D_BeginEx()` and `R3D_End()` into a target, queues its
+ * readback, then polls the readbacks that completed:
+ *
+ * @code
+ * for (int i = 0; i < count; i++) {
+ *     R3D_BeginEx(camera, &target);
+ *     R3D_DrawModel(models[i], position, 1.0f);
+ *     R3D_End();
+ *     while (!R3D_QueueReadback(queue, &target, i)) {
+ *         R3D_PollReadback(queue, &image, &tag, true);   // The queue is full, wait for the oldest one
+ *         save(image, tag);
+ *     }
+ *     while (R3D_PollReadback(queue, &image, &tag, false)) save(image, tag);
+ * }
+ * while (R3D_PollReadback(queue, &image, &tag, true)) save(image, tag);
+ * @endcode
+ *
+ * Rendering offscreen doesn't require a window. Once an OpenGL 3.3 context is current, from
+ * a hidden window or a surfaceless EGL context for example, the functions can be loaded with
+ * `rlLoadExtensions()` and raylib initialized with `rlglInit()` before `R3D_Init()`.
+ * Every frame must then be rendered with `R3D_BeginEx()` and a target.
+ *
+ * Picking reads the depth and normals of a few pixels of the G-buffer the same way, the
+ * area requested is copied at the end of the next `R3D_End()` and its result is polled
+ * one or two frames later, instead of reading the targets with `glReadPixels()`:
+ *
+ * @code
+ * R3D_RequestPick((Rectangle) {mouse.x, mouse.y, 1, 1}, 0);
+ * R3D_Begin(camera);
+ * ...
+ * R3D_End();
+ * while (R3D_PollPick(&pick, false)) {
+ *     if (pick.hit) cursor = pick.position;
+ * }
+ * @endcode
+ *
+ * @{
+ */
+
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief Opaque handle of a readback queue.
+ *
+ * @see R3D_LoadReadbackQueue()
+ */
+typedef struct R3D_ReadbackQueue R3D_ReadbackQueue;
+
+/**
+ * @brief Result of a pick, for the nearest surface found in the area.
+ *
+ * @see R3D_RequestPick()
+ */
+typedef struct R3D_PickResult {
+    Vector3 position;   ///< World position of the nearest surface
+    Vector3 normal;     ///< World normal of the surface, zero if no opaque geometry was rendered during the frame
+    float distance;     ///< Distance from the camera of the frame to the position
+    int tag;            ///< Tag given to R3D_RequestPick()
+    bool hit;           ///< False if the area only covers the background
+} R3D_PickResult;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Creates a queue of asynchronous readbacks.
+ *
+ * Each slot of the queue holds the pixels of one readback until it is polled.
+ * Three slots let the readback of a frame overlap the rendering of the next two.
+ *
+ * @param capacity Number of readbacks in flight, at least 1.
+ *
+ * @return Handle of the queue, or NULL on failure.
+ */
+R3DAPI R3D_ReadbackQueue* R3D_LoadReadbackQueue(int capacity);
+
+/**
+ * @brief Destroys a readback queue.
+ *
+ * The readbacks that were not polled are discarded.
+ *
+ * @param queue Queue to destroy.
+ */
+R3DAPI void R3D_UnloadReadbackQueue(R3D_ReadbackQueue* queue);
+
+/**
+ * @brief Queues the readback of the color of a render target.
+ *
+ * Must be called after `R3D_End()`, outside of any raylib texture mode.
+ * The copy is only recorded, the function returns without waiting for the GPU.
+ *
+ * @param queue Queue receiving the readback.
+ * @param target Target to read, its color attachment must use an 8 bits RGBA format.
+ * @param tag Value returned with the pixels, to identify the render.
+ *
+ * @return False if all the slots are waiting to be polled, or if the target is invalid.
+ */
+R3DAPI bool R3D_QueueReadback(R3D_ReadbackQueue* queue, const RenderTexture* target, int tag);
+
+/**
+ * @brief Retrieves the oldest readback of the queue once the GPU is done with it.
+ *
+ * The image is in `PIXELFORMAT_UNCOMPRESSED_R8G8B8A8`, with its rows from top to bottom
+ * like the images of `LoadImageFromTexture()`, and must be released with `UnloadImage()`.
+ *
+ * @param queue Queue to poll.
+ * @param image Receives the pixels of the readback.
+ * @param tag Receives the tag given to `R3D_QueueReadback()` (may be NULL).
+ * @param wait True to wait for the oldest readback if it is not complete yet.
+ *
+ * @return True if an image was retrieved, false if the queue is empty or the oldest readback is in flight.
+ */
+R3DAPI bool R3D_PollReadback(R3D_ReadbackQueue* queue, Image* image, int* tag, bool wait);
+
+/**
+ * @brief Returns the number of readbacks queued and not polled yet.
+ *
+ * @param queue Queue to query.
+ *
+ * @return Number of readbacks in flight or ready.
+ */
+R3DAPI int R3D_GetReadbackCount(const R3D_ReadbackQueue* queue);
+
+/**
+ * @brief Requests the depth and normal of an area of the next frame rendered.
+ *
+ * The area is copied at the end of the next `R3D_End()` rendering a single view, the
+ * function can be called at any time before it. Up to eight picks can be in flight.
+ * The area is limited to 8x8 pixels of the rendered resolution, centered on the request,
+ * an empty area reads the pixel under its position.
+ *
+ * @param area Area in pixels of the screen or of the target given to `R3D_BeginEx()`, from the top left.
+ * @param tag Value returned with the result, to identify the request.
+ *
+ * @return False if too many picks are in flight.
+ */
+R3DAPI bool R3D_RequestPick(Rectangle area, int tag);
+
+/**
+ * @brief Retrieves the result of the oldest pick once the GPU is done with it.
+ *
+ * The normal is the one written by the opaque geometry, surfaces of the transparent or
+ * forward materials that write their depth report the normal of the geometry behind them.
+ *
+ * @param result Receives the result of the pick.
+ * @param wait True to wait for the oldest pick if its copy is not complete yet.
+ *             Never waits for a pick whose frame has not been rendered.
+ *
+ * @return True if a result was retrieved, false if no pick is ready.
+ */
+R3DAPI bool R3D_PollPick(R3D_PickResult* result, bool wait);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of Readback
+
+#endif // R3D_READBACK_H
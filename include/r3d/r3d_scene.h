@@ -0,0 +1,198 @@
+/* r3d_scene.h -- R3D Scene Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_SCENE_H
+#define R3D_SCENE_H
+
+#include "./r3d_platform.h"
+#include "./r3d_material.h"
+#include "./r3d_model.h"
+#include "./r3d_mesh.h"
+#include <raylib.h>
+#include <stdint.h>
+
+/**
+ * @defgroup Scene
+ * @brief Retained objects submitted automatically every frame.
+ *
+ * Scene objects are an alternative to calling the draw functions every frame.
+ * They are created once, keep their transform and bounds between frames, and are
+ * submitted by `R3D_End()` together with the draws issued since `R3D_Begin()`.
+ * Active objects are indexed in a bounding volume hierarchy, so that only the objects
+ * inside the view or inside a shadow frustum are visited each frame.
+ *
+ * @{
+ */
+
+// ========================================
+// ALIASES TYPES
+// ========================================
+
+/**
+ * @brief Unique identifier for an R3D scene object.
+ *
+ * ID type used to reference a scene object.
+ * A negative value indicates an invalid object.
+ */
+typedef int32_t R3D_SceneObject;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ----------------------------------------
+// SCENE: Objects Config Functions
+// ----------------------------------------
+
+/**
+ * @brief Creates a scene object drawing a model.
+ *
+ * The model is referenced, not copied, it must remain valid as long as the object exists.
+ * The object is active once created and must be destroyed manually by calling
+ * `R3D_DestroySceneObject`.
+ *
+ * @param model Pointer to the model drawn by the object.
+ * @param transform World transform of the object.
+ * @return The ID of the created object, or a negative value on failure.
+ */
+R3DAPI R3D_SceneObject R3D_CreateSceneModel(const R3D_Model* model, Matrix transform);
+
+/**
+ * @brief Creates a scene object drawing a single mesh.
+ *
+ * The mesh is referenced, not copied, it must remain valid as long as the object exists.
+ * The material is copied into the object, the default material is used if NULL.
+ *
+ * @param mesh Pointer to the mesh drawn by the object.
+ * @param material Optional material of the mesh.
+ * @param transform World transform of the object.
+ * @return The ID of the created object, or a negative value on failure.
+ */
+R3DAPI R3D_SceneObject R3D_CreateSceneMesh(const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform);
+
+/**
+ * @brief Destroys the specified scene object.
+ *
+ * The object is no longer drawn and its ID becomes invalid.
+ * The model or mesh it referenced is not unloaded.
+ *
+ * @param id The ID of the object to destroy.
+ */
+R3DAPI void R3D_DestroySceneObject(R3D_SceneObject id);
+
+/**
+ * @brief Checks if a scene object exists.
+ *
+ * @param id The ID of the object to check.
+ * @return True if the object exists, false otherwise.
+ */
+R3DAPI bool R3D_IsSceneObjectExist(R3D_SceneObject id);
+
+/**
+ * @brief Checks if a scene object is active.
+ *
+ * @param id The ID of the object.
+ * @return True if the object is drawn by `R3D_End()`, false otherwise.
+ */
+R3DAPI bool R3D_IsSceneObjectActive(R3D_SceneObject id);
+
+/**
+ * @brief Sets the active state of a scene object.
+ *
+ * Inactive objects are kept but skipped entirely during submission.
+ *
+ * @param id The ID of the object.
+ * @param active True to draw the object, false to hide it.
+ */
+R3DAPI void R3D_SetSceneObjectActive(R3D_SceneObject id, bool active);
+
+/**
+ * @brief Gets the world transform of a scene object.
+ *
+ * @param id The ID of the object.
+ * @return The world transform of the object.
+ */
+R3DAPI Matrix R3D_GetSceneObjectTransform(R3D_SceneObject id);
+
+/**
+ * @brief Sets the world transform of a scene object.
+ *
+ * The world bounds of the object are only recomputed here, not on every frame,
+ * and the hierarchy is only restructured when the object leaves its enlarged bounds.
+ *
+ * @param id The ID of the object.
+ * @param transform The new world transform.
+ */
+R3DAPI void R3D_SetSceneObjectTransform(R3D_SceneObject id, Matrix transform);
+
+/**
+ * @brief Overrides the material of a scene object.
+ *
+ * For a model, the material replaces the materials of all its meshes.
+ * For a mesh, it replaces the material given at creation.
+ * The material is copied. Passing NULL restores the original materials of a model,
+ * or the default material for a mesh.
+ *
+ * @param id The ID of the object.
+ * @param material Material override, or NULL.
+ */
+R3DAPI void R3D_SetSceneObjectMaterial(R3D_SceneObject id, const R3D_Material* material);
+
+/**
+ * @brief Checks if a scene object is static.
+ *
+ * @param id The ID of the object.
+ * @return True if the shadow of the object is cached by the lights, false otherwise.
+ */
+R3DAPI bool R3D_IsSceneObjectStatic(R3D_SceneObject id);
+
+/**
+ * @brief Marks a scene object as static or dynamic for the shadows.
+ *
+ * Each shadowed light keeps a cache of the depth of its static casters, copied into its
+ * shadow map when it is updated, so that only the dynamic casters are rendered again.
+ * Moving, (de)activating, destroying or changing the material of a static object
+ * invalidates the caches of all lights, objects that change often should stay dynamic.
+ * The animation of a static model is not reflected in the cached shadows, animated models
+ * should stay dynamic. Immediate draws are always dynamic, objects are dynamic by default.
+ *
+ * @param id The ID of the object.
+ * @param isStatic True to cache the shadow of the object, false to render it every update.
+ */
+R3DAPI void R3D_SetSceneObjectStatic(R3D_SceneObject id, bool isStatic);
+
+// ----------------------------------------
+// SCENE: Query Functions
+// ----------------------------------------
+
+/**
+ * @brief Finds the active scene objects overlapping a bounding box.
+ *
+ * The query traverses the bounding volume hierarchy of the scene instead of testing
+ * every object, which makes it suitable for gameplay or light overlap tests.
+ * Objects without bounds are not reported. The world bounds of the objects are
+ * slightly enlarged, a few objects just outside of the box may be reported.
+ *
+ * @param box World-space box to test.
+ * @param objects Array receiving the IDs found, can be NULL to only count them.
+ * @param maxObjects Capacity of the array.
+ * @return The total number of objects found, which can exceed `maxObjects`.
+ */
+R3DAPI int R3D_QuerySceneObjects(BoundingBox box, R3D_SceneObject* objects, int maxObjects);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of Scene
+
+#endif // R3D_SCENE_H
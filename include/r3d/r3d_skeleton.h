@@ -48,7 +48,7 @@ typedef struct R3D_Skeleton {
     Matrix* bindLocal;      ///< Bind pose transforms in local bone space (relative to parent).
     Matrix* bindPose;       ///< Bind pose transforms in model space (global). Used as the default pose when not animated.
 
-    uint32_t texBindPose;   ///< Texture ID that contains the bind pose for GPU skinning. This is a 1D Texture RGBA32F 4*boneCount.
+    int bindPoseOffset;     ///< Offset of the bind pose in the bone palette used for GPU skinning, in matrices.
 
 } R3D_Skeleton;
 
@@ -94,7 +94,7 @@ R3DAPI void R3D_UnloadSkeleton(R3D_Skeleton* skeleton);
 /**
  * @brief Check if a skeleton is valid.
  * 
- * Returns true if atleast the texBindPose is greater than zero.
+ * Returns true if the skeleton has bones and its bind pose is in the bone palette.
  *
  * @param skeleton Pointer to the skeleton to check.
  * @return true if valid, false otherwise.
@@ -29,10 +29,18 @@
  */
 typedef struct R3D_Skybox {
     TextureCubemap cubemap;  ///< The skybox cubemap texture for the background and reflections.
-    Texture2D irradiance;    ///< The irradiance cubemap for diffuse ambient lighting.
     Texture2D prefilter;     ///< The prefiltered cubemap for specular reflections with mipmaps.
+    Vector3 irradianceSH[9]; ///< L2 spherical harmonics of the irradiance for diffuse ambient lighting, convolved and divided by PI.
 } R3D_Skybox;
 
+/**
+ * @brief Opaque handle regenerating a skybox over several frames.
+ *
+ * The updater owns two skyboxes: the one returned by R3D_GetUpdatedSkybox()
+ * and the one being regenerated, swapped only once the update is complete.
+ */
+typedef struct R3D_SkyboxUpdater R3D_SkyboxUpdater;
+
 // ========================================
 // PUBLIC API
 // ========================================
@@ -54,6 +62,8 @@ extern "C" {
  * @param filePath The path to the texture file.
  * @param layout The cubemap layout format.
  * @return The loaded skybox object.
+ *
+ * @note HDR images are converted to half floats in place once decoded, before their upload.
  */
 R3DAPI R3D_Skybox R3D_LoadSkybox(const char* filePath, CubemapLayout layout);
 
@@ -66,6 +76,9 @@ R3DAPI R3D_Skybox R3D_LoadSkybox(const char* filePath, CubemapLayout layout);
  * @param image The source image in memory.
  * @param layout The cubemap layout format.
  * @return The loaded skybox object.
+ *
+ * @note The faces are uploaded directly from the image, which is not copied nor modified.
+ *       Compressed images are not supported, float images are stored in half precision.
  */
 R3DAPI R3D_Skybox R3D_LoadSkyboxFromMemory(Image image, CubemapLayout layout);
 
@@ -78,6 +91,8 @@ R3DAPI R3D_Skybox R3D_LoadSkyboxFromMemory(Image image, CubemapLayout layout);
  * @param filePath The path to the panorama texture file.
  * @param size The resolution of the generated cubemap (e.g., 512, 1024).
  * @return The loaded skybox object.
+ *
+ * @note HDR images are converted to half floats in place once decoded, before their upload.
  */
 R3DAPI R3D_Skybox R3D_LoadSkyboxPanorama(const char* filePath, int size);
 
@@ -90,9 +105,96 @@ R3DAPI R3D_Skybox R3D_LoadSkyboxPanorama(const char* filePath, int size);
  * @param image The panorama image in memory.
  * @param size The resolution of the generated cubemap (e.g., 512, 1024).
  * @return The loaded skybox object.
+ *
+ * @note Float images are uploaded in half precision, converted by the driver.
  */
 R3DAPI R3D_Skybox R3D_LoadSkyboxPanoramaFromMemory(Image image, int size);
 
+/**
+ * @brief Saves a skybox along with its precomputed lighting textures.
+ *
+ * The cubemap and all the levels of the prefiltered cubemap are read back from the GPU
+ * and written as half floats in a single file, along with the irradiance harmonics.
+ * The file can then be reloaded with R3D_LoadSkyboxBaked() without any convolution pass.
+ *
+ * @param sky The skybox to save.
+ * @param filePath The path of the file to write.
+ * @return True if the file was written successfully.
+ */
+R3DAPI bool R3D_SaveSkybox(R3D_Skybox sky, const char* filePath);
+
+/**
+ * @brief Loads a skybox saved with R3D_SaveSkybox().
+ *
+ * The textures are uploaded as they were saved, only the mipmaps of the
+ * cubemap are generated again. The cubemap is always loaded in half floats.
+ *
+ * @param filePath The path to the baked skybox file.
+ * @return The loaded skybox object, empty on failure.
+ */
+R3DAPI R3D_Skybox R3D_LoadSkyboxBaked(const char* filePath);
+
+// ----------------------------------------
+// SKYBOX: Incremental Update Functions
+// ----------------------------------------
+
+/**
+ * @brief Creates an updater regenerating dynamic skies over several frames.
+ *
+ * Both skyboxes of the updater are allocated here with the given cubemap size,
+ * the updates then render into them without any allocation.
+ * Until the first update completes, the returned skybox is black.
+ *
+ * @param size The resolution of the generated cubemaps (e.g., 256, 512).
+ * @return The updater, or NULL on failure.
+ */
+R3DAPI R3D_SkyboxUpdater* R3D_LoadSkyboxUpdater(int size);
+
+/**
+ * @brief Destroys an updater along with its two skyboxes.
+ *
+ * @param updater The updater to destroy, may be NULL.
+ */
+R3DAPI void R3D_UnloadSkyboxUpdater(R3D_SkyboxUpdater* updater);
+
+/**
+ * @brief Starts the regeneration of the skybox from a panorama texture.
+ *
+ * Any update in progress is restarted from the beginning with the new panorama.
+ * The panorama is not copied, it must remain valid until the update completes.
+ *
+ * @param updater The updater.
+ * @param panorama The panorama (equirectangular) texture to convert.
+ */
+R3DAPI void R3D_RequestSkyboxUpdate(R3D_SkyboxUpdater* updater, Texture2D panorama);
+
+/**
+ * @brief Advances the update in progress by a bounded number of passes.
+ *
+ * A pass renders one face of one level, generates the mipmaps of the cubemap,
+ * or queues the readback used for the irradiance harmonics. The update takes
+ * 56 passes, plus the wait for the readback, which never stalls the GPU.
+ *
+ * When true is returned, the new skybox has been swapped in and must be fetched
+ * again with R3D_GetUpdatedSkybox(), as the previous one will be overwritten
+ * by the next update.
+ *
+ * @param updater The updater.
+ * @param maxPasses The maximum number of passes rendered by this call, at least one.
+ * @return True if a new skybox is available.
+ */
+R3DAPI bool R3D_UpdateSkyboxIncremental(R3D_SkyboxUpdater* updater, int maxPasses);
+
+/**
+ * @brief Returns the last skybox completed by the updater.
+ *
+ * The skybox belongs to the updater and must not be unloaded.
+ *
+ * @param updater The updater.
+ * @return The last complete skybox.
+ */
+R3DAPI R3D_Skybox R3D_GetUpdatedSkybox(const R3D_SkyboxUpdater* updater);
+
 /**
  * @brief Unloads a skybox and frees its resources.
  *
@@ -0,0 +1,90 @@
+/* r3d_terrain.h -- R3D Terrain Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_TERRAIN_H
+#define R3D_TERRAIN_H
+
+#include "./r3d_platform.h"
+#include "./r3d_material.h"
+#include "./r3d_mesh.h"
+#include <raylib.h>
+
+/**
+ * @defgroup Terrain
+ * @{
+ */
+
+// ========================================
+// STRUCTS TYPES
+// ========================================
+
+/**
+ * @brief Heightmap terrain split into a grid of chunks.
+ *
+ * Each chunk is a separate mesh with its own levels of detail, so chunks are culled
+ * and select their level individually. The borders of the chunks are extended downward
+ * by skirts, which hide the cracks between neighbours drawn at different levels.
+ */
+typedef struct R3D_Terrain {
+    R3D_Mesh* chunks;                   ///< Meshes of the chunks, row by row along Z.
+    int chunkCountX;                    ///< Number of chunks along X.
+    int chunkCountZ;                    ///< Number of chunks along Z.
+    R3D_Material material;              ///< Material used to draw every chunk.
+    BoundingBox aabb;                   ///< Axis-Aligned Bounding Box of the whole terrain, skirts included.
+} R3D_Terrain;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Load a chunked terrain from a heightmap image.
+ *
+ * The vertices are laid out like `R3D_GenMeshDataHeightmap()`, centered on the origin,
+ * with texture coordinates spanning the whole terrain. Coarser levels skip every other
+ * row and column of the previous one, level `n` is selected below a screen size of `0.5 / 2^(n-1)`
+ * and can be tuned with `R3D_SetLodBias()`.
+ *
+ * @param heightmap Image containing height data (the red channel represents elevation).
+ * @param size Terrain dimensions (width, max height, depth).
+ * @param chunkSize Number of quads along the edges of a chunk, powers of two give the most even levels.
+ * @param lodCount Number of coarser levels per chunk, up to `R3D_MESH_MAX_LODS`.
+ *
+ * @return Loaded terrain with a default material, or a terrain without chunks on failure.
+ */
+R3DAPI R3D_Terrain R3D_LoadTerrain(Image heightmap, Vector3 size, int chunkSize, int lodCount);
+
+/**
+ * @brief Unload a terrain and optionally its material.
+ *
+ * @param terrain Pointer to the terrain to unload.
+ * @param unloadMaterial If true, also unloads the material of the terrain.
+ */
+R3DAPI void R3D_UnloadTerrain(R3D_Terrain* terrain, bool unloadMaterial);
+
+/**
+ * @brief Draw a terrain at a given position.
+ *
+ * Each chunk is submitted as its own draw, frustum culling and level selection are done per chunk.
+ *
+ * @param terrain Pointer to the terrain to draw.
+ * @param position World position of the terrain center.
+ */
+R3DAPI void R3D_DrawTerrain(const R3D_Terrain* terrain, Vector3 position);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/** @} */ // end of Terrain
+
+#endif // R3D_TERRAIN_H
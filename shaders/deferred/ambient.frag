@@ -8,15 +8,24 @@
 
 #version 330 core
 
+#ifdef PROBES
+#extension GL_ARB_texture_cube_map_array : require
+#endif
+
 #ifdef IBL
 
 /* === Includes === */
 
 #include "../include/blocks/view.glsl"
+#include "../include/blocks/sky.glsl"
 #include "../include/math.glsl"
 #include "../include/ibl.glsl"
 #include "../include/pbr.glsl"
 
+#ifdef PROBES
+#include "../include/blocks/probe.glsl"
+#endif
+
 /* === Varyings === */
 
 noperspective in vec2 vTexCoord;
@@ -31,10 +40,13 @@ uniform sampler2D uTexSSIL;
 uniform sampler2D uTexSSR;
 uniform sampler2D uTexORM;
 
-uniform samplerCube uCubeIrradiance;
 uniform samplerCube uCubePrefilter;
 uniform sampler2D uTexBrdfLut;
 
+#ifdef PROBES
+uniform samplerCubeArray uCubeProbes;
+#endif
+
 uniform float uAmbientEnergy;
 uniform float uReflectEnergy;
 uniform float uMipCountSSR;
@@ -73,17 +85,24 @@ void main()
     vec3 kD = (1.0 - kS) * (1.0 - metalness);
 
     vec3 Nr = M_Rotate3D(N, uQuatSkybox);
-    vec3 irradiance = texture(uCubeIrradiance, Nr).rgb;
+    vec3 irradiance = S_GetIrradiance(Nr);
     vec3 diffuse = albedo * kD * (irradiance + ssil.rgb);
 
     FragDiffuse = vec4(diffuse * occlusion * uAmbientEnergy, 1.0);
 
     /* --- Specular --- */
 
-    vec3 R = M_Rotate3D(reflect(-V, N), uQuatSkybox);
+    vec3 R = reflect(-V, N);
 
     const float MAX_REFLECTION_LOD = 7.0;
-    vec3 radiance = textureLod(uCubePrefilter, R, roughness * MAX_REFLECTION_LOD).rgb;
+    float lod = roughness * MAX_REFLECTION_LOD;
+    vec3 radiance = textureLod(uCubePrefilter, M_Rotate3D(R, uQuatSkybox), lod).rgb;
+
+#ifdef PROBES
+    // The probes are in world space, the sky only fills what they do not cover
+    radiance = P_GetRadiance(uCubeProbes, position, R, lod, radiance);
+#endif
+
     float specularOcclusion = IBL_GetSpecularOcclusion(NdotV, occlusion, roughness);
     vec3 specularBRDF = IBL_GetMultiScatterBRDF(uTexBrdfLut, NdotV, roughness, F0);
 
@@ -11,41 +11,36 @@
 /* === Includes === */
 
 #include "../include/blocks/view.glsl"
+#include "../include/blocks/shadow.glsl"
 #include "../include/light.glsl"
 #include "../include/math.glsl"
 #include "../include/pbr.glsl"
 
+/* === Variants === */
+
+// The loader defines LIGHT_TYPE to LIGHT_DIR, LIGHT_SPOT or LIGHT_OMNI,
+// and SHADOW for the lights casting shadows, one program is compiled per combination
+
+#ifndef LIGHT_TYPE
+#   define LIGHT_TYPE LIGHT_DIR
+#endif
+
 /* === Structs === */
 
 struct Light
 {
-    mat4 matVP;                     //< View/projection matrix of the light, used for directional and spot shadow projection
-    sampler2D shadowMap;            //< 2D shadow map used for directional and spot shadow projection
-    samplerCube shadowCubemap;      //< Cube shadow map used for omni-directional shadow projection
     vec3 color;                     //< Light color modulation tint
     vec3 position;                  //< Light position (spot/omni)
     vec3 direction;                 //< Light direction (spot/dir)
     float specular;                 //< Specular factor (not physically accurate but provides more flexibility)
     float energy;                   //< Light energy factor
     float range;                    //< Maximum distance the light can travel before being completely attenuated (spot/omni)
-    float size;                     //< Light size, currently used only for shadows (PCSS)
-    float near;                     //< Near plane for the shadow map projection
-    float far;                      //< Far plane for the shadow map projection
     float attenuation;              //< Additional light attenuation factor (spot/omni)
     float innerCutOff;              //< Spot light inner cutoff angle
     float outerCutOff;              //< Spot light outer cutoff angle
-    float shadowSoftness;           //< Softness factor to simulate a penumbra
-    float shadowTexelSize;          //< Size of a texel in the 2D shadow map
-    float shadowDepthBias;          //< Constant depth bias applied to shadow mapping to reduce shadow acne
-    float shadowSlopeBias;          //< Additional bias scaled by surface slope to reduce artifacts on angled geometry
-    lowp int type;                  //< Light type (dir/spot/omni)
-    bool shadow;                    //< Indicates whether the light generates shadows
+    int shadowIndex;                //< Index of the light shadow in the shadow block, only used with SHADOW
 };
 
-/* === Varyings === */
-
-noperspective in vec2 vTexCoord;
-
 /* === Uniforms === */
 
 uniform sampler2D uTexAlbedo;
@@ -53,6 +48,7 @@ uniform sampler2D uTexNormal;
 uniform sampler2D uTexDepth;
 uniform sampler2D uTexSSAO;
 uniform sampler2D uTexORM;
+uniform sampler2DShadow uTexShadowAtlas;
 
 uniform Light uLight;
 
@@ -63,123 +59,23 @@ uniform float uSSAOLightAffect;
 layout(location = 0) out vec4 FragDiffuse;
 layout(location = 1) out vec4 FragSpecular;
 
-/* === Constants === */
-
-#define SHADOW_SAMPLES 8
-
-const vec2 VOGEL_DISK[8] = vec2[8](
-    vec2(0.250000, 0.000000),
-    vec2(-0.319290, 0.292496),
-    vec2(0.048872, -0.556877),
-    vec2(0.402444, 0.524918),
-    vec2(-0.738535, -0.130636),
-    vec2(0.699605, -0.445031),
-    vec2(-0.234004, 0.870484),
-    vec2(-0.446271, -0.859268)
-);
-
-/* === Shadow functions === */
-
-float ShadowDir(vec3 position, float cNdotL, mat2 diskRot)
-{
-    /* --- Light Space Projection --- */
-
-    vec4 projPos = uLight.matVP * vec4(position, 1.0);
-    vec3 projCoords = projPos.xyz / projPos.w * 0.5 + 0.5;
-
-    /* --- Shadow Bias and Depth Adjustment --- */
-
-    float bias = uLight.shadowSlopeBias * (1.0 - cNdotL);
-    bias = max(bias, uLight.shadowDepthBias * projCoords.z);
-    float currentDepth = projCoords.z - bias;
-
-    /* --- Poisson Disk PCF Sampling --- */
-
-    float shadow = 0.0;
-    for (int i = 0; i < SHADOW_SAMPLES; ++i) {
-        vec2 offset = diskRot * VOGEL_DISK[i] * uLight.shadowSoftness;
-        shadow += step(currentDepth, texture(uLight.shadowMap, projCoords.xy + offset).r);
-    }
-    shadow /= float(SHADOW_SAMPLES);
-
-    /* --- Apply a fade to the edges of the projection --- */
-
-    vec3 distToBorder = min(projCoords, 1.0 - projCoords);
-    float edgeFade = smoothstep(0.0, 0.15, min(distToBorder.x, min(distToBorder.y, distToBorder.z)));
-    shadow = mix(1.0, shadow, edgeFade);
-
-    /* --- Final Shadow Value --- */
-
-    return shadow;
-}
-
-float ShadowSpot(vec3 position, float cNdotL, mat2 diskRot)
-{
-    /* --- Light Space Projection --- */
-
-    vec4 projPos = uLight.matVP * vec4(position, 1.0);
-    vec3 projCoords = projPos.xyz / projPos.w * 0.5 + 0.5;
-
-    /* --- Shadow Bias and Depth Adjustment --- */
-
-    float bias = uLight.shadowSlopeBias * (1.0 - cNdotL);
-    bias = max(bias, uLight.shadowDepthBias * projCoords.z);
-    float currentDepth = projCoords.z - bias;
-
-    /* --- Poisson Disk PCF Sampling --- */
-
-    float shadow = 0.0;
-    for (int i = 0; i < SHADOW_SAMPLES; ++i) {
-        vec2 offset = diskRot * VOGEL_DISK[i] * uLight.shadowSoftness;
-        shadow += step(currentDepth, texture(uLight.shadowMap, projCoords.xy + offset).r);
-    }
-
-    /* --- Final Shadow Value --- */
-
-    return shadow / float(SHADOW_SAMPLES);
-}
+/* === Main === */
 
-float ShadowOmni(vec3 position, float cNdotL, mat2 diskRot)
+void main()
 {
-    /* --- Light Vector and Distance Calculation --- */
-
-    vec3 lightToFrag = position - uLight.position;
-    float currentDepth = length(lightToFrag);
-    vec3 direction = normalize(lightToFrag);
+    /* Compute the texture coordinates from the fragment, the light volumes can be clipped */
 
-    /* --- Shadow Bias and Depth Adjustment --- */
+    vec2 texCoord = gl_FragCoord.xy / vec2(textureSize(uTexDepth, 0));
 
-    float bias = uLight.shadowSlopeBias * (1.0 - cNdotL * 0.5);
-    bias = max(bias, uLight.shadowDepthBias * currentDepth);
-    currentDepth -= bias;
-
-    /* --- Build orthonormal basis for perturbation --- */
-
-    mat3 OBN = M_OrthonormalBasis(direction);
-
-    /* --- Poisson Disk PCF Sampling --- */
-
-    float shadow = 0.0;
-    for (int i = 0; i < SHADOW_SAMPLES; ++i) {
-        vec2 diskOffset = diskRot * VOGEL_DISK[i] * uLight.shadowSoftness;
-        vec3 sampleDir = normalize(OBN * vec3(diskOffset.xy, 1.0));
-        float sampleDepth = texture(uLight.shadowCubemap, sampleDir).r * uLight.far;
-        shadow += step(currentDepth, sampleDepth);
+    // The front faces of the light volumes also cover the background
+    if (texelFetch(uTexDepth, ivec2(gl_FragCoord.xy), 0).r == 1.0) {
+        discard;
     }
 
-    /* --- Final Shadow Value --- */
-
-    return shadow / float(SHADOW_SAMPLES);
-}
-
-/* === Main === */
-
-void main()
-{
     /* Sample albedo and ORM texture and extract values */
     
-    vec3 albedo = texture(uTexAlbedo, vTexCoord).rgb;
-    vec3 orm = texture(uTexORM, vTexCoord).rgb;
+    vec3 albedo = texture(uTexAlbedo, texCoord).rgb;
+    vec3 orm = texture(uTexORM, texCoord).rgb;
     float roughness = orm.g;
     float metalness = orm.b;
 
@@ -189,8 +85,8 @@ void main()
 
     /* Get position and normal in world space */
 
-    vec3 position = V_GetWorldPosition(uTexDepth, vTexCoord);
-    vec3 N = V_GetWorldNormal(uTexNormal, vTexCoord);
+    vec3 position = V_GetWorldPosition(uTexDepth, texCoord);
+    vec3 N = V_GetWorldNormal(uTexNormal, texCoord);
 
     /* Compute view direction and the dot product of the normal and view direction */
     
@@ -201,7 +97,11 @@ void main()
 
     /* Compute light direction and the dot product of the normal and light direction */
 
-    vec3 L = (uLight.type == LIGHT_DIR) ? -uLight.direction : normalize(uLight.position - position);
+#if LIGHT_TYPE == LIGHT_DIR
+    vec3 L = -uLight.direction;
+#else
+    vec3 L = normalize(uLight.position - position);
+#endif
 
     float NdotL = max(dot(N, L), 0.0);
     float cNdotL = min(NdotL, 1.0); // Clamped to avoid division by zero
@@ -230,6 +130,12 @@ void main()
     vec3 specular = L_Specular(F0, cLdotH, cNdotH, cNdotV, cNdotL, roughness);
     specular *= lightColE * uLight.specular;
 
+    /* Apply shadow factor if the light casts shadows */
+
+    float shadow = 1.0;
+
+#ifdef SHADOW
+
     /* --- Calculating a random rotation matrix for shadow debanding --- */
 
     float r = M_TAU * M_HashIGN(gl_FragCoord.xy);
@@ -237,39 +143,37 @@ void main()
 
     mat2 diskRot = mat2(vec2(cr, -sr), vec2(sr, cr));
 
-    /* Apply shadow factor if the light casts shadows */
+    LightShadow params = uLightShadows[uLight.shadowIndex];
 
-    float shadow = 1.0;
+#if LIGHT_TYPE == LIGHT_DIR
+    shadow = S_ShadowDir(uTexShadowAtlas, params, position, cNdotL, diskRot);
+#elif LIGHT_TYPE == LIGHT_SPOT
+    shadow = S_ShadowSpot(uTexShadowAtlas, params, position, cNdotL, diskRot);
+#else
+    shadow = S_ShadowOmni(uTexShadowAtlas, params, uLight.position, position, cNdotL, diskRot);
+#endif
 
-    if (uLight.shadow) {
-        switch (uLight.type) {
-        case LIGHT_DIR: shadow = ShadowDir(position, cNdotL, diskRot); break;
-        case LIGHT_SPOT: shadow = ShadowSpot(position, cNdotL, diskRot); break;
-        case LIGHT_OMNI: shadow = ShadowOmni(position, cNdotL, diskRot); break;
-        }
-    }
+#endif // SHADOW
 
     /* Apply attenuation based on the distance from the light */
 
-    if (uLight.type != LIGHT_DIR)
-    {
-        float dist = length(uLight.position - position);
-        float atten = 1.0 - clamp(dist / uLight.range, 0.0, 1.0);
-        shadow *= atten * uLight.attenuation;
-    }
+#if LIGHT_TYPE != LIGHT_DIR
+    float dist = length(uLight.position - position);
+    float atten = 1.0 - clamp(dist / uLight.range, 0.0, 1.0);
+    shadow *= atten * uLight.attenuation;
+#endif
 
     /* Apply spotlight effect if the light is a spotlight */
 
-    if (uLight.type == LIGHT_SPOT)
-    {
-        float theta = dot(L, -uLight.direction);
-        float epsilon = (uLight.innerCutOff - uLight.outerCutOff);
-        shadow *= smoothstep(0.0, 1.0, (theta - uLight.outerCutOff) / epsilon);
-    }
+#if LIGHT_TYPE == LIGHT_SPOT
+    float theta = dot(L, -uLight.direction);
+    float epsilon = (uLight.innerCutOff - uLight.outerCutOff);
+    shadow *= smoothstep(0.0, 1.0, (theta - uLight.outerCutOff) / epsilon);
+#endif
 
 	/* Apply SSAO to diffuse lighting (accordingly to light affect) */
 
-    diffuse *= mix(1.0, texture(uTexSSAO, vTexCoord).r, uSSAOLightAffect);
+    diffuse *= mix(1.0, texture(uTexSSAO, texCoord).r, uSSAOLightAffect);
 
     /* Compute final lighting contribution */
 
@@ -0,0 +1,46 @@
+/* lighting.vert -- Vertex shader for the light volumes of deferred shading
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+
+/* === Attributes === */
+
+layout(location = 0) in vec3 aPosition;
+
+/* === Uniforms === */
+
+uniform mat4 uMatModel;     ///< Transform of the light volume
+uniform bool uVolume;       ///< Rasterize the light volume instead of a full-screen triangle
+
+/* === Constants === */
+
+const vec2 positions[3] = vec2[]
+(
+    vec2(-1.0, -1.0),
+    vec2( 3.0, -1.0),
+    vec2(-1.0,  3.0)
+);
+
+/* === Main === */
+
+void main()
+{
+    if (uVolume) {
+        gl_Position = uView.viewProj * (uMatModel * vec4(aPosition, 1.0));
+        return;
+    }
+
+    // Same as screen.vert, Z is fixed at 1.0 so
+    // that GL_GREATER only invokes the shader on geometry
+
+    gl_Position = vec4(positions[gl_VertexID], 1.0, 1.0);
+}
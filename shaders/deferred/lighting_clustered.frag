@@ -0,0 +1,156 @@
+/* lighting_clustered.frag -- Fragment shader for applying the direct lighting of the clustered lights for deferred shading
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+#include "../include/blocks/light.glsl"
+#include "../include/math.glsl"
+#include "../include/pbr.glsl"
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexAlbedo;
+uniform sampler2D uTexNormal;
+uniform sampler2D uTexDepth;
+uniform sampler2D uTexSSAO;
+uniform sampler2D uTexORM;
+
+uniform usamplerBuffer uTexLightClusters;   ///< Offset and count in 'uTexLightIndices' of each cluster
+uniform usamplerBuffer uTexLightIndices;    ///< Index in the light block of the lights of each cluster
+uniform vec2 uClusterTileScale;
+uniform vec2 uClusterSlice;
+
+uniform float uSSAOLightAffect;
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragDiffuse;
+layout(location = 1) out vec4 FragSpecular;
+
+/* === Helper functions === */
+
+int GetClusterIndex(float depth)
+{
+    int slice = int(log(max(depth, 1e-4)) * uClusterSlice.x + uClusterSlice.y);
+    ivec2 tile = ivec2(gl_FragCoord.xy * uClusterTileScale);
+
+    ivec3 maxCluster = ivec3(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1, LIGHT_CLUSTER_Z - 1);
+    ivec3 cluster = clamp(ivec3(tile, slice), ivec3(0), maxCluster);
+
+    return (cluster.z * LIGHT_CLUSTER_Y + cluster.y) * LIGHT_CLUSTER_X + cluster.x;
+}
+
+/* === Main === */
+
+void main()
+{
+    /* Sample albedo and ORM texture and extract values */
+
+    vec3 albedo = texture(uTexAlbedo, vTexCoord).rgb;
+    vec3 orm = texture(uTexORM, vTexCoord).rgb;
+    float roughness = orm.g;
+    float metalness = orm.b;
+
+    /* Compute F0 (reflectance at normal incidence) based on the metallic factor */
+
+    vec3 F0 = PBR_ComputeF0(metalness, 0.5, albedo);
+
+    /* Get position and normal in world space */
+
+    vec3 viewPosition = V_GetViewPosition(uTexDepth, vTexCoord);
+    vec3 position = V_GetWorldPosition(viewPosition);
+    vec3 N = V_GetWorldNormal(uTexNormal, vTexCoord);
+
+    /* Compute view direction and the dot product of the normal and view direction */
+
+    vec3 V = normalize(uView.position - position);
+
+    float NdotV = dot(N, V);
+    float cNdotV = max(NdotV, 1e-4); // Clamped to avoid division by zero
+
+    /* Accumulate all the lights of the cluster with a single read of the G-buffer */
+
+    vec3 diffuse = vec3(0.0);
+    vec3 specular = vec3(0.0);
+
+    uvec2 cluster = texelFetch(uTexLightClusters, GetClusterIndex(-viewPosition.z)).rg;
+
+    for (uint i = 0u; i < cluster.y; i++)
+    {
+        Light light = uLights[int(texelFetch(uTexLightIndices, int(cluster.x + i)).r)];
+
+        /* Compute light direction and the dot product of the normal and light direction */
+
+        vec3 L = (light.type == LIGHT_DIR) ? -light.direction : normalize(light.position - position);
+
+        float NdotL = dot(N, L);
+        if (NdotL <= 0.0) continue;
+        float cNdotL = min(NdotL, 1.0); // Clamped to avoid division by zero
+
+        /* Compute the halfway vector between the view and light directions */
+
+        vec3 H = normalize(V + L);
+
+        float LdotH = max(dot(L, H), 0.0);
+        float cLdotH = min(LdotH, 1.0);
+
+        float NdotH = max(dot(N, H), 0.0);
+        float cNdotH = min(NdotH, 1.0);
+
+        /* Compute light color energy */
+
+        vec3 lightColE = light.color * light.energy;
+
+        /* Compute diffuse and specular lighting */
+
+        vec3 diffLight = L_Diffuse(cLdotH, cNdotV, cNdotL, roughness);
+        diffLight *= albedo * lightColE * (1.0 - metalness);
+
+        vec3 specLight = L_Specular(F0, cLdotH, cNdotH, cNdotV, cNdotL, roughness);
+        specLight *= lightColE * light.specular;
+
+        /* Apply attenuation based on the distance from the light */
+
+        float factor = 1.0;
+
+        if (light.type != LIGHT_DIR)
+        {
+            float dist = length(light.position - position);
+            float atten = 1.0 - clamp(dist / light.range, 0.0, 1.0);
+            factor *= atten * light.attenuation;
+        }
+
+        /* Apply spotlight effect if the light is a spotlight */
+
+        if (light.type == LIGHT_SPOT)
+        {
+            float theta = dot(L, -light.direction);
+            float epsilon = (light.innerCutOff - light.outerCutOff);
+            factor *= smoothstep(0.0, 1.0, (theta - light.outerCutOff) / epsilon);
+        }
+
+        diffuse += diffLight * factor;
+        specular += specLight * factor;
+    }
+
+    /* Apply SSAO to diffuse lighting (accordingly to light affect) */
+
+    diffuse *= mix(1.0, texture(uTexSSAO, vTexCoord).r, uSSAOLightAffect);
+
+    /* Compute final lighting contribution */
+
+    FragDiffuse = vec4(diffuse, 1.0);
+    FragSpecular = vec4(specular, 1.0);
+}
@@ -8,6 +8,8 @@
 
 #version 330 core
 
+#include "../include/blocks/view.glsl"
+
 const vec2 positions[3] = vec2[]
 (
     vec2(-1.0, -1.0),
@@ -23,7 +25,9 @@ void main()
     // For fullscreen passes that match the depth buffer resolution:
     //   - GL_EQUAL allows rendering only the background
     //   - GL_GREATER allows invoking the shader only on geometry
+    // The texture coordinates only cover the rendered area of the targets,
+    // smaller than the targets themselves with dynamic resolution.
 
     gl_Position = vec4(positions[gl_VertexID], 1.0, 1.0);
-    vTexCoord = (gl_Position.xy * 0.5) + 0.5;
+    vTexCoord = ((gl_Position.xy * 0.5) + 0.5) * uView.uvScale;
 }
@@ -0,0 +1,42 @@
+/* light.glsl -- Contains the lights visible in the current frame
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "../light.glsl"
+
+/* === Defines === */
+
+#define LIGHT_BLOCK_COUNT 192
+
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+
+/* === Structs === */
+
+struct Light {
+    vec3 color;
+    float specular;
+    vec3 position;
+    float energy;
+    vec3 direction;
+    float range;
+    float attenuation;
+    float innerCutOff;
+    float outerCutOff;
+    int type;
+};
+
+/* === Blocks === */
+
+/*
+ * The shadowed lights come first in the block, their
+ * shadows are at the same index in the shadow block.
+ */
+layout(std140) uniform LightBlock {
+    Light uLights[LIGHT_BLOCK_COUNT];
+};
@@ -0,0 +1,69 @@
+/* probe.glsl -- Contains the reflection probes visible in the current frame
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+/* === Defines === */
+
+#define PROBE_BLOCK_COUNT 8
+
+/* === Structs === */
+
+struct Probe {
+    vec4 position;      //< xyz: Capture position, w: Intensity
+    vec4 boxMin;        //< xyz: Minimum of the bounds, w: Blend distance
+    vec4 boxMax;        //< xyz: Maximum of the bounds, w: Index of the cubemap in the array
+};
+
+/* === Blocks === */
+
+/*
+ * The probes are sorted from the smallest to the largest,
+ * so the inner probes take precedence over the ones around them.
+ */
+layout(std140) uniform ProbeBlock {
+    Probe uProbes[PROBE_BLOCK_COUNT];
+    int uProbeCount;
+};
+
+/* === Functions === */
+
+float P_GetWeight(Probe probe, vec3 position)
+{
+    // Fades out over the blend distance inside the bounds
+    vec3 d = min(position - probe.boxMin.xyz, probe.boxMax.xyz - position);
+    float edge = min(min(d.x, d.y), d.z);
+    return clamp(edge / max(probe.boxMin.w, 1e-4), 0.0, 1.0);
+}
+
+vec3 P_GetParallaxDirection(Probe probe, vec3 position, vec3 dir)
+{
+    // The reflected ray hits the bounds, seen from the capture position
+    vec3 t1 = (probe.boxMax.xyz - position) / dir;
+    vec3 t2 = (probe.boxMin.xyz - position) / dir;
+    vec3 tFar = max(t1, t2);
+    float t = min(min(tFar.x, tFar.y), tFar.z);
+    return position + dir * t - probe.position.xyz;
+}
+
+vec3 P_GetRadiance(samplerCubeArray probes, vec3 position, vec3 dir, float lod, vec3 fallback)
+{
+    vec3 radiance = vec3(0.0);
+    float remaining = 1.0;
+
+    for (int i = 0; i < uProbeCount && remaining > 0.0; i++) {
+        float weight = P_GetWeight(uProbes[i], position) * remaining;
+        if (weight <= 0.0) continue;
+
+        vec3 R = P_GetParallaxDirection(uProbes[i], position, dir);
+        vec3 sampled = textureLod(probes, vec4(R, uProbes[i].boxMax.w), lod).rgb;
+
+        radiance += sampled * uProbes[i].position.w * weight;
+        remaining -= weight;
+    }
+
+    return radiance + fallback * remaining;
+}
@@ -0,0 +1,240 @@
+/* shadow.glsl -- Contains the shadows of the lights visible in the current frame
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "../math.glsl"
+
+/* === Defines === */
+
+#define LIGHT_BLOCK_SHADOWS 32
+
+#define SHADOW_SAMPLES 8            //< Taps of the highest quality, see 'LightShadow.samples'
+
+#define SHADOW_CASCADES 4
+
+/* === Structs === */
+
+struct LightShadow {
+    mat4 matVP[SHADOW_CASCADES];    //< One per cascade for dir lights, only [0] for spot lights
+    vec4 tiles[6];                  //< Normalized rectangles in the atlas, one per cascade for dir lights, only [0] for spot lights
+    float near;
+    float far;
+    float softness;
+    float texelSize;
+    float depthBias;
+    float slopeBias;
+    int cascades;                   //< Number of cascades of dir lights
+    int samples;                    //< Filtered taps per pixel: 1, 4 or SHADOW_SAMPLES
+};
+
+/* === Blocks === */
+
+/*
+ * The shadowed lights come first in the light block,
+ * so that the shadow of a light is at the same index as the light.
+ */
+layout(std140) uniform ShadowBlock {
+    LightShadow uLightShadows[LIGHT_BLOCK_SHADOWS];
+};
+
+/* === Constants === */
+
+const vec2 VOGEL_DISK[8] = vec2[8](
+    vec2(0.250000, 0.000000),
+    vec2(-0.319290, 0.292496),
+    vec2(0.048872, -0.556877),
+    vec2(0.402444, 0.524918),
+    vec2(-0.738535, -0.130636),
+    vec2(0.699605, -0.445031),
+    vec2(-0.234004, 0.870484),
+    vec2(-0.446271, -0.859268)
+);
+
+const vec2 VOGEL_DISK_4[4] = vec2[4](
+    vec2(0.353553, 0.000000),
+    vec2(-0.451544, 0.413652),
+    vec2(0.069116, -0.787542),
+    vec2(0.569142, 0.742346)
+);
+
+/* === Functions === */
+
+/*
+ * Returns the position in the unit disk of a tap of the filter.
+ * A single tap is centered, its softness only comes from the hardware filtering.
+ */
+vec2 S_DiskTap(int i, int samples)
+{
+    if (samples == 1) return vec2(0.0);
+    return (samples == 4) ? VOGEL_DISK_4[i] : VOGEL_DISK[i];
+}
+
+vec2 S_AtlasCoord(vec4 tile, vec2 uv, float texelSize)
+{
+    // Clamped to the tile, the neighbor tiles belong to other lights
+    uv = clamp(uv, vec2(0.5 * texelSize), vec2(1.0 - 0.5 * texelSize));
+    return tile.xy + uv * tile.zw;
+}
+
+/*
+ * Returns the coordinates in the cube face and the face index of a direction.
+ * The faces follow the views used to render the omni shadows.
+ */
+vec3 S_OmniFaceCoord(vec3 dir)
+{
+    vec3 a = abs(dir);
+    vec3 D, U;
+    float face;
+
+    if (a.x >= a.y && a.x >= a.z) {
+        face = (dir.x > 0.0) ? 0.0 : 1.0;
+        D = vec3(sign(dir.x), 0.0, 0.0);
+        U = vec3(0.0, -1.0, 0.0);
+    }
+    else if (a.y >= a.z) {
+        face = (dir.y > 0.0) ? 2.0 : 3.0;
+        D = vec3(0.0, sign(dir.y), 0.0);
+        U = vec3(0.0, 0.0, sign(dir.y));
+    }
+    else {
+        face = (dir.z > 0.0) ? 4.0 : 5.0;
+        D = vec3(0.0, 0.0, sign(dir.z));
+        U = vec3(0.0, -1.0, 0.0);
+    }
+
+    vec2 ndc = vec2(dot(dir, cross(D, U)), dot(dir, U)) / dot(dir, D);
+
+    return vec3(ndc * 0.5 + 0.5, face);
+}
+
+/*
+ * Returns the size of the projection of a cascade in world units, from the scale of its first row.
+ */
+float S_CascadeExtent(mat4 matVP)
+{
+    return 1.0 / length(vec3(matVP[0][0], matVP[1][0], matVP[2][0]));
+}
+
+float S_ShadowDir(sampler2DShadow atlas, LightShadow params, vec3 position, float cNdotL, mat2 diskRot)
+{
+    /* --- Select the first cascade containing the position --- */
+
+    // The cascades are selected from their projection rather than from the view depth,
+    // so that the far cascades rendered from an older view position remain usable
+    float margin = params.softness + params.texelSize;
+
+    int cascade = -1;
+    vec3 projCoords = vec3(0.0);
+
+    for (int i = 0; i < params.cascades; i++) {
+        vec4 projPos = params.matVP[i] * vec4(position, 1.0);
+        projCoords = projPos.xyz / projPos.w * 0.5 + 0.5;
+        if (all(greaterThan(projCoords, vec3(margin, margin, 0.0))) &&
+            all(lessThan(projCoords, vec3(1.0 - margin, 1.0 - margin, 1.0)))) {
+            cascade = i;
+            break;
+        }
+    }
+
+    if (cascade < 0) {
+        return 1.0;
+    }
+
+    /* --- Shadow Bias and Depth Adjustment --- */
+
+    // The texels of the far cascades cover more of the scene
+    float texelScale = S_CascadeExtent(params.matVP[cascade]) / S_CascadeExtent(params.matVP[0]);
+
+    float bias = params.slopeBias * (1.0 - cNdotL);
+    bias = max(bias, params.depthBias * projCoords.z) * texelScale;
+    float currentDepth = projCoords.z - bias;
+
+    /* --- Poisson Disk PCF Sampling --- */
+
+    // Each tap compares the 4 nearest texels, filtered by the hardware
+    float shadow = 0.0;
+    for (int i = 0; i < params.samples; ++i) {
+        vec2 offset = diskRot * S_DiskTap(i, params.samples) * params.softness;
+        vec2 coord = S_AtlasCoord(params.tiles[cascade], projCoords.xy + offset, params.texelSize);
+        shadow += texture(atlas, vec3(coord, currentDepth));
+    }
+    shadow /= float(params.samples);
+
+    /* --- Apply a fade to the edges of the last cascade --- */
+
+    if (cascade == params.cascades - 1) {
+        vec3 distToBorder = min(projCoords, 1.0 - projCoords);
+        float edgeFade = smoothstep(0.0, 0.15, min(distToBorder.x, min(distToBorder.y, distToBorder.z)));
+        shadow = mix(1.0, shadow, edgeFade);
+    }
+
+    /* --- Final Shadow Value --- */
+
+    return shadow;
+}
+
+float S_ShadowSpot(sampler2DShadow atlas, LightShadow params, vec3 position, float cNdotL, mat2 diskRot)
+{
+    /* --- Light Space Projection --- */
+
+    vec4 projPos = params.matVP[0] * vec4(position, 1.0);
+    vec3 projCoords = projPos.xyz / projPos.w * 0.5 + 0.5;
+
+    /* --- Shadow Bias and Depth Adjustment --- */
+
+    float bias = params.slopeBias * (1.0 - cNdotL);
+    bias = max(bias, params.depthBias * projCoords.z);
+    float currentDepth = projCoords.z - bias;
+
+    /* --- Poisson Disk PCF Sampling --- */
+
+    float shadow = 0.0;
+    for (int i = 0; i < params.samples; ++i) {
+        vec2 offset = diskRot * S_DiskTap(i, params.samples) * params.softness;
+        vec2 coord = S_AtlasCoord(params.tiles[0], projCoords.xy + offset, params.texelSize);
+        shadow += texture(atlas, vec3(coord, currentDepth));
+    }
+
+    /* --- Final Shadow Value --- */
+
+    return shadow / float(params.samples);
+}
+
+float S_ShadowOmni(sampler2DShadow atlas, LightShadow params, vec3 lightPosition, vec3 position, float cNdotL, mat2 diskRot)
+{
+    /* --- Light Vector and Distance Calculation --- */
+
+    vec3 lightToFrag = position - lightPosition;
+    float currentDepth = length(lightToFrag);
+    vec3 direction = normalize(lightToFrag);
+
+    /* --- Shadow Bias and Depth Adjustment --- */
+
+    float bias = params.slopeBias * (1.0 - cNdotL * 0.5);
+    bias = max(bias, params.depthBias * currentDepth);
+    currentDepth -= bias;
+
+    /* --- Build orthonormal basis for perturbation --- */
+
+    mat3 OBN = M_OrthonormalBasis(direction);
+
+    /* --- Poisson Disk PCF Sampling --- */
+
+    // Each sample selects its own face, so the filtering continues across the edges
+    // The faces store the distance to the light divided by the far plane
+    float shadow = 0.0;
+    for (int i = 0; i < params.samples; ++i) {
+        vec2 diskOffset = diskRot * S_DiskTap(i, params.samples) * params.softness;
+        vec3 faceCoord = S_OmniFaceCoord(OBN * vec3(diskOffset.xy, 1.0));
+        vec2 coord = S_AtlasCoord(params.tiles[int(faceCoord.z)], faceCoord.xy, params.texelSize);
+        shadow += texture(atlas, vec3(coord, currentDepth / params.far));
+    }
+
+    /* --- Final Shadow Value --- */
+
+    return shadow / float(params.samples);
+}
@@ -0,0 +1,38 @@
+/* sky.glsl -- Contains the diffuse lighting of the current skybox
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+/* === Blocks === */
+
+/*
+ * L2 spherical harmonics of the sky irradiance, already convolved with
+ * the cosine lobe and divided by PI, in the order (0,0), (1,-1), (1,0),
+ * (1,1), (2,-2), (2,-1), (2,0), (2,1), (2,2). See 'R3D_Skybox'.
+ */
+layout(std140) uniform SkyBlock {
+    vec4 uSkyIrradianceSH[9];
+};
+
+/* === Functions === */
+
+vec3 S_GetIrradiance(vec3 n)
+{
+    vec3 e = uSkyIrradianceSH[0].rgb * 0.282095;
+
+    e += uSkyIrradianceSH[1].rgb * (0.488603 * n.y);
+    e += uSkyIrradianceSH[2].rgb * (0.488603 * n.z);
+    e += uSkyIrradianceSH[3].rgb * (0.488603 * n.x);
+
+    e += uSkyIrradianceSH[4].rgb * (1.092548 * n.x * n.y);
+    e += uSkyIrradianceSH[5].rgb * (1.092548 * n.y * n.z);
+    e += uSkyIrradianceSH[6].rgb * (0.315392 * (3.0 * n.z * n.z - 1.0));
+    e += uSkyIrradianceSH[7].rgb * (1.092548 * n.x * n.z);
+    e += uSkyIrradianceSH[8].rgb * (0.546274 * (n.x * n.x - n.y * n.y));
+
+    // The truncation can ring below zero around very bright sources
+    return max(e, vec3(0.0));
+}
@@ -18,15 +18,20 @@ struct View {
     float aspect;
     float near;
     float far;
+    vec2 uvScale;       //< Fraction of the render targets covered by the rendered area
 };
 
 layout(std140) uniform ViewBlock {
     View uView;
 };
 
+// NOTE: The texture coordinates given to and returned by these functions
+//       address the render targets, whose rendered area can be smaller
+//       than the targets with dynamic resolution, see 'uView.uvScale'
+
 vec3 V_GetViewPosition(float depth, vec2 texCoord)
 {
-    vec4 ndcPos = vec4(texCoord * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 ndcPos = vec4((texCoord / uView.uvScale) * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
     vec4 viewPos = uView.invProj * ndcPos;
     return viewPos.xyz / viewPos.w;
 }
@@ -80,19 +85,19 @@ vec3 V_GetWorldNormal(sampler2D texNormal, vec2 texCoord)
 vec2 V_ViewToScreen(vec3 viewPosition)
 {
     vec4 clipPos = uView.proj * vec4(viewPosition, 1.0);
-    return (clipPos.xy / clipPos.w) * 0.5 + 0.5;
+    return ((clipPos.xy / clipPos.w) * 0.5 + 0.5) * uView.uvScale;
 }
 
 vec2 V_WorldToScreen(vec3 worldPosition)
 {
     vec4 projPos = uView.viewProj * vec4(worldPosition, 1.0);
-    return (projPos.xy / projPos.w) * 0.5 + 0.5;
+    return ((projPos.xy / projPos.w) * 0.5 + 0.5) * uView.uvScale;
 }
 
 bool V_OffScreen(vec2 texCoord)
 {
     return any(lessThan(texCoord, vec2(0.0))) ||
-           any(greaterThan(texCoord, vec2(1.0)));
+           any(greaterThan(texCoord, uView.uvScale));
 }
 
 float V_LinearizeDepth(float depth)
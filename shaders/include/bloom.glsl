@@ -0,0 +1,187 @@
+/* bloom.glsl -- Contains the downsampling filter shared by the bloom shaders
+ *
+ * Original implementation by Jorge Jiménez, presented at SIGGRAPH 2014
+ * (used in Call of Duty: Advanced Warfare)
+ *
+ * Copyright (c) 2014 Jorge Jiménez
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+/* === Definitions === */
+
+#define BLOOM_MIX           1
+#define BLOOM_ADDITIVE      2
+#define BLOOM_SCREEN        3
+
+/* === Functions === */
+
+vec3 B_LinearToSRGB(vec3 color)
+{
+	// color = clamp(color, vec3(0.0), vec3(1.0));
+	// const vec3 a = vec3(0.055f);
+	// return mix((vec3(1.0f) + a) * pow(color.rgb, vec3(1.0f / 2.4f)) - a, 12.92f * color.rgb, lessThan(color.rgb, vec3(0.0031308f)));
+	// Approximation from http://chilliant.blogspot.com/2012/08/srgb-approximations-for-hlsl.html
+	return max(vec3(1.055) * pow(color, vec3(0.416666667)) - vec3(0.055), vec3(0.0));
+}
+
+float B_SRGBToLuma(vec3 col)
+{
+    //return dot(col, vec3(0.2126, 0.7152, 0.0722));
+    return dot(col, vec3(0.299, 0.587, 0.114));
+}
+
+float B_KarisAverage(vec3 col)
+{
+    // Formula is 1 / (1 + luma)
+    float luma = B_SRGBToLuma(B_LinearToSRGB(col)) * 0.25f;
+    return 1.0f / (1.0f + luma);
+}
+
+vec3 B_Prefilter(vec3 col, vec4 prefilter)
+{
+	float brightness = max(col.r, max(col.g, col.b));
+	float soft = brightness - prefilter.y;
+	soft = clamp(soft, 0, prefilter.z);
+	soft = soft * soft * prefilter.w;
+	float contribution = max(soft, brightness - prefilter.x);
+	contribution /= max(brightness, 0.00001);
+	return col * contribution;
+}
+
+/*
+ * 13-tap downsampling of the given level, 'texelSize' is the reciprocal of its resolution.
+ * With 'karis', the Karis average is applied to each block of 4 samples and the result is prefiltered.
+ */
+vec3 B_Downsample(sampler2D tex, vec2 texCoord, vec2 texelSize, float level, bool karis, vec4 prefilter)
+{
+    float x = texelSize.x;
+    float y = texelSize.y;
+
+    // Take 13 samples around current texel:
+    // a - b - c
+    // - j - k -
+    // d - e - f
+    // - l - m -
+    // g - h - i
+    // === ('e' is the current texel) ===
+    vec3 a = textureLod(tex, vec2(texCoord.x - 2*x, texCoord.y + 2*y), level).rgb;
+    vec3 b = textureLod(tex, vec2(texCoord.x,       texCoord.y + 2*y), level).rgb;
+    vec3 c = textureLod(tex, vec2(texCoord.x + 2*x, texCoord.y + 2*y), level).rgb;
+
+    vec3 d = textureLod(tex, vec2(texCoord.x - 2*x, texCoord.y), level).rgb;
+    vec3 e = textureLod(tex, vec2(texCoord.x,       texCoord.y), level).rgb;
+    vec3 f = textureLod(tex, vec2(texCoord.x + 2*x, texCoord.y), level).rgb;
+
+    vec3 g = textureLod(tex, vec2(texCoord.x - 2*x, texCoord.y - 2*y), level).rgb;
+    vec3 h = textureLod(tex, vec2(texCoord.x,       texCoord.y - 2*y), level).rgb;
+    vec3 i = textureLod(tex, vec2(texCoord.x + 2*x, texCoord.y - 2*y), level).rgb;
+
+    vec3 j = textureLod(tex, vec2(texCoord.x - x, texCoord.y + y), level).rgb;
+    vec3 k = textureLod(tex, vec2(texCoord.x + x, texCoord.y + y), level).rgb;
+    vec3 l = textureLod(tex, vec2(texCoord.x - x, texCoord.y - y), level).rgb;
+    vec3 m = textureLod(tex, vec2(texCoord.x + x, texCoord.y - y), level).rgb;
+
+    // Apply weighted distribution:
+    // 0.5 + 0.125 + 0.125 + 0.125 + 0.125 = 1
+    // a,b,d,e * 0.125
+    // b,c,e,f * 0.125
+    // d,e,g,h * 0.125
+    // e,f,h,i * 0.125
+    // j,k,l,m * 0.5
+    // This shows 5 square areas that are being sampled. But some of them overlap,
+    // so to have an energy preserving downsample we need to make some adjustments.
+    // The weights are the distributed, so that the sum of j,k,l,m (e.g.)
+    // contribute 0.5 to the final color output. The code below is written
+    // to effectively yield this sum. We get:
+    // 0.125*5 + 0.03125*4 + 0.0625*4 = 1
+
+    vec3 color = vec3(0.0);
+
+    if (karis)
+    {
+        // We are writing to mip 0, so we need to apply Karis average to each block
+        // of 4 samples to prevent fireflies (very bright subpixels, leads to pulsating artifacts).
+        vec3 groups[5];
+        groups[0] = (a+b+d+e) * (0.125/4.0);
+        groups[1] = (b+c+e+f) * (0.125/4.0);
+        groups[2] = (d+e+g+h) * (0.125/4.0);
+        groups[3] = (e+f+h+i) * (0.125/4.0);
+        groups[4] = (j+k+l+m) * (0.5/4.0);
+        groups[0] *= B_KarisAverage(groups[0]);
+        groups[1] *= B_KarisAverage(groups[1]);
+        groups[2] *= B_KarisAverage(groups[2]);
+        groups[3] *= B_KarisAverage(groups[3]);
+        groups[4] *= B_KarisAverage(groups[4]);
+        color = groups[0]+groups[1]+groups[2]+groups[3]+groups[4];
+        color = max(color, 0.0001);
+        color = B_Prefilter(color, prefilter);
+    }
+    else
+    {
+        color = e*0.125;                // ok
+        color += (a+c+g+i)*0.03125;     // ok
+        color += (b+d+f+h)*0.0625;      // ok
+        color += (j+k+l+m)*0.125;       // ok
+    }
+
+    return color;
+}
+
+/*
+ * 3x3 tent upsampling of the given level, the radius is given in texture coordinates.
+ */
+vec3 B_Upsample(sampler2D tex, vec2 texCoord, vec2 radius, float level)
+{
+    float x = radius.x;
+    float y = radius.y;
+
+    // Take 9 samples around current texel:
+    // a - b - c
+    // d - e - f
+    // g - h - i
+    // === ('e' is the current texel) ===
+    vec3 a = textureLod(tex, vec2(texCoord.x - x, texCoord.y + y), level).rgb;
+    vec3 b = textureLod(tex, vec2(texCoord.x,     texCoord.y + y), level).rgb;
+    vec3 c = textureLod(tex, vec2(texCoord.x + x, texCoord.y + y), level).rgb;
+
+    vec3 d = textureLod(tex, vec2(texCoord.x - x, texCoord.y), level).rgb;
+    vec3 e = textureLod(tex, vec2(texCoord.x,     texCoord.y), level).rgb;
+    vec3 f = textureLod(tex, vec2(texCoord.x + x, texCoord.y), level).rgb;
+
+    vec3 g = textureLod(tex, vec2(texCoord.x - x, texCoord.y - y), level).rgb;
+    vec3 h = textureLod(tex, vec2(texCoord.x,     texCoord.y - y), level).rgb;
+    vec3 i = textureLod(tex, vec2(texCoord.x + x, texCoord.y - y), level).rgb;
+
+    // Apply weighted distribution, by using a 3x3 tent filter:
+    //  1   | 1 2 1 |
+    // -- * | 2 4 2 |
+    // 16   | 1 2 1 |
+    vec3 color = e*4.0;
+    color += (b+d+f+h)*2.0;
+    color += (a+c+g+i);
+    return color * (1.0 / 16.0);
+}
+
+/*
+ * Blends the upsampled bloom over the scene color according to the bloom mode.
+ */
+vec3 B_Composite(vec3 color, vec3 bloom, int mode, float intensity)
+{
+    bloom *= intensity;
+
+    if (mode == BLOOM_MIX) {
+        color = mix(color, bloom, intensity);
+    }
+    else if (mode == BLOOM_ADDITIVE) {
+        color += bloom;
+    }
+    else if (mode == BLOOM_SCREEN) {
+        bloom = clamp(bloom, vec3(0.0), vec3(1.0));
+        color = max((color + bloom) - (color * bloom), vec3(0.0));
+    }
+
+    return color;
+}
@@ -0,0 +1,41 @@
+/* fog.glsl -- Contains the fog factors shared by the post-processing shaders
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+/* === Definitions === */
+
+#define FOG_DISABLED 0
+#define FOG_LINEAR 1
+#define FOG_EXP2 2
+#define FOG_EXP 3
+
+/* === Functions === */
+
+float F_FactorLinear(float dist, float start, float end)
+{
+    return 1.0 - clamp((end - dist) / (end - start), 0.0, 1.0);
+}
+
+float F_FactorExp2(float dist, float density)
+{
+    const float LOG2 = -1.442695;
+    float d = density * dist;
+    return 1.0 - clamp(exp2(d * d * LOG2), 0.0, 1.0);
+}
+
+float F_FactorExp(float dist, float density)
+{
+    return 1.0 - clamp(exp(-density * dist), 0.0, 1.0);
+}
+
+float F_Factor(float dist, int mode, float density, float start, float end)
+{
+    if (mode == FOG_LINEAR) return F_FactorLinear(dist, start, end);
+    if (mode == FOG_EXP2) return F_FactorExp2(dist, density);
+    if (mode == FOG_EXP) return F_FactorExp(dist, density);
+    return 1.0; // FOG_DISABLED
+}
@@ -0,0 +1,79 @@
+/* instance.glsl -- Contains everything you need to read the instance transforms
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+/* === Constants === */
+
+#define INSTANCING_NONE     0   //< No instance attributes
+#define INSTANCING_MATRIX   1   //< Model matrix stored row by row
+#define INSTANCING_PARTICLE 2   //< Position, rotation and scale of 'R3D_ParticleInstance'
+#define INSTANCING_SPRITE   3   //< Position, roll, size and texture rect of 'R3D_Sprite'
+
+/* === Functions === */
+
+mat4 ParticleMatrix(vec3 t, vec3 r, vec3 s)
+{
+    // NOTE: Must match 'r3d_matrix_scale_rotxyz_translate()'
+    float cx = cos(r.x), sx = sin(r.x);
+    float cy = cos(r.y), sy = sin(r.y);
+    float cz = cos(r.z), sz = sin(r.z);
+
+    mat4 rows = mat4(
+        vec4(s.x * (cy*cz), s.x * (-cy*sz), s.x * sy, t.x),
+        vec4(s.y * (sx*sy*cz + cx*sz), s.y * (-sx*sy*sz + cx*cz), s.y * (-sx*cy), t.y),
+        vec4(s.z * (-cx*sy*cz + sx*sz), s.z * (cx*sy*sz + sx*cz), s.z * (cx*cy), t.z),
+        vec4(0.0, 0.0, 0.0, 1.0)
+    );
+
+    return transpose(rows);
+}
+
+mat4 SpriteMatrix(vec3 t, vec2 s)
+{
+    return mat4(
+        vec4(s.x, 0.0, 0.0, 0.0),
+        vec4(0.0, s.y, 0.0, 0.0),
+        vec4(0.0, 0.0, 1.0, 0.0),
+        vec4(t, 1.0)
+    );
+}
+
+mat4 InstanceMatrix(mat4 attribute, int mode)
+{
+    // Particle records only fill the first three columns of the attribute
+    if (mode == INSTANCING_PARTICLE) {
+        return ParticleMatrix(attribute[0].xyz, attribute[1].xyz, attribute[2].xyz);
+    }
+
+    // The roll of the sprites is not part of the matrix, see 'InstanceLocal()'
+    if (mode == INSTANCING_SPRITE) {
+        return SpriteMatrix(attribute[0].xyz, attribute[1].xy);
+    }
+
+    return transpose(attribute);
+}
+
+vec3 InstanceLocal(vec3 v, mat4 attribute, int mode)
+{
+    // Sprites are rolled in the plane of the quad, before the billboard replaces the axes of the model
+    if (mode == INSTANCING_SPRITE) {
+        float c = cos(attribute[0].w), s = sin(attribute[0].w);
+        return vec3(c * v.x - s * v.y, s * v.x + c * v.y, v.z);
+    }
+
+    return v;
+}
+
+vec2 InstanceTexCoord(vec2 texCoord, mat4 attribute, int mode)
+{
+    // Sprites select their region of the atlas
+    if (mode == INSTANCING_SPRITE) {
+        return attribute[2].xy + texCoord * attribute[2].zw;
+    }
+
+    return texCoord;
+}
@@ -11,8 +11,6 @@
 
 /* === Defines === */
 
-#define LIGHT_FORWARD_COUNT 8
-
 #define LIGHT_DIR   0
 #define LIGHT_SPOT  1
 #define LIGHT_OMNI  2
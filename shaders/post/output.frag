@@ -3,6 +3,9 @@
  * Performs tone mapping, debanding, color adjustments, and
  * converts from linear color space to sRGB.
  *
+ * The fog and the bloom composition are fused in when their variants are
+ * compiled with 'FOG' and 'BLOOM', saving a full screen pass for each.
+ *
  * Copyright (c) 2025 Victor Le Juez
  *
  * This software is distributed under the terms of the accompanying LICENSE file.
@@ -15,6 +18,15 @@
 
 #include "../include/math.glsl"
 
+#ifdef FOG
+#   include "../include/blocks/view.glsl"
+#   include "../include/fog.glsl"
+#endif
+
+#ifdef BLOOM
+#   include "../include/bloom.glsl"
+#endif
+
 /* === Definitions === */
 
 #define TONEMAP_LINEAR 0
@@ -37,6 +49,23 @@ uniform float uBrightness;          //< Brightness adjustment
 uniform float uContrast;            //< Contrast adjustment
 uniform float uSaturation;          //< Saturation adjustment
 
+#ifdef FOG
+uniform sampler2D uTexDepth;        //< Scene depth texture
+uniform lowp int uFogMode;          //< Fog mode used (e.g. FOG_LINEAR)
+uniform vec3 uFogColor;
+uniform float uFogStart;
+uniform float uFogEnd;
+uniform float uFogDensity;
+uniform float uSkyAffect;
+#endif
+
+#ifdef BLOOM
+uniform sampler2D uTexBloomBlur;    //< Bloom chain, its first level and the second to upsample
+uniform vec2 uFilterRadius;         //< Radius of the last upsampling, negative without a second level
+uniform lowp int uBloomMode;        //< Bloom mode used (e.g. BLOOM_MIX)
+uniform float uBloomIntensity;
+#endif
+
 /* === Fragments === */
 
 out vec4 FragColor;
@@ -221,6 +250,22 @@ void main()
 {
     vec3 color = texture(uTexColor, vTexCoord).rgb;
 
+#ifdef FOG
+    float depth = V_GetLinearDepth(uTexDepth, vTexCoord);
+    float fogFactor = F_Factor(depth, uFogMode, uFogDensity, uFogStart, uFogEnd);
+    fogFactor *= uSkyAffect * step(depth, uView.far);
+    color = mix(color, uFogColor, fogFactor);
+#endif
+
+#ifdef BLOOM
+    // The last upsampling is done here rather than written to the first level
+    vec3 bloom = textureLod(uTexBloomBlur, vTexCoord, 0.0).rgb;
+    if (uFilterRadius.x >= 0.0) {
+        bloom += B_Upsample(uTexBloomBlur, vTexCoord, uFilterRadius, 1.0);
+    }
+    color = B_Composite(color, bloom, uBloomMode, uBloomIntensity);
+#endif
+
     color = Tonemapping(color, uTonemapExposure, uTonemapWhite);
     color = Adjustments(color, uBrightness, uContrast, uSaturation);
     color = Debanding(color);
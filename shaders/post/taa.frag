@@ -0,0 +1,127 @@
+/* taa.frag -- Temporal anti-aliasing and upscaling of the scene
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+// The scene is rendered with a sub-pixel jitter that changes every frame, possibly below the output resolution.
+// Each output pixel reprojects the history from the depth, clamps it to the neighbourhood of the current
+// samples, then blends in the current samples weighted by their distance to the pixel center.
+// Only the camera motion is reprojected, moving objects rely on the neighbourhood clamping.
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+
+/* === Uniforms === */
+
+uniform sampler2D uTexColor;        //< Rendered area of the scene, see 'uView.uvScale'
+uniform sampler2D uTexDepth;
+uniform sampler2D uTexHistory;      //< Previous output, at the resolution of the targets
+
+uniform mat4 uMatPrevViewProj;      //< Previous view-projection, without jitter
+uniform vec2 uJitter;               //< Sub-pixel offset of the projection, in rendered pixels
+uniform float uHistoryWeight;       //< Zero when there is no history
+
+/* === Constants === */
+
+const float CURRENT_WEIGHT = 0.1;   //< Blend factor of a current sample centered on the output pixel
+
+/* === Fragments === */
+
+out vec4 FragColor;
+
+/* === Helper functions === */
+
+vec3 RGBToYCoCg(vec3 c)
+{
+    return vec3(
+         0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+         0.5  * c.r             - 0.5  * c.b,
+        -0.25 * c.r + 0.5 * c.g - 0.25 * c.b
+    );
+}
+
+vec3 YCoCgToRGB(vec3 c)
+{
+    return vec3(
+        c.x + c.y - c.z,
+        c.x       + c.z,
+        c.x - c.y - c.z
+    );
+}
+
+// Inverse luminance weighting, keeps the bright samples from dominating the resolve
+vec3 Tonemap(vec3 c) { return c / (1.0 + max(c.r, max(c.g, c.b))); }
+vec3 TonemapInverse(vec3 c) { return c / max(1.0 - max(c.r, max(c.g, c.b)), 1e-4); }
+
+/* === Main program === */
+
+void main()
+{
+    vec2 outputSize = vec2(textureSize(uTexDepth, 0));
+    vec2 texCoord = gl_FragCoord.xy / outputSize;
+
+    /* --- Current samples around the output pixel, in rendered pixels --- */
+
+    ivec2 renderMax = ivec2(outputSize * uView.uvScale) - 1;
+    vec2 renderPos = texCoord * outputSize * uView.uvScale;
+    ivec2 center = ivec2(floor(renderPos + uJitter));
+
+    vec3 current = vec3(0.0);
+    vec3 m1 = vec3(0.0), m2 = vec3(0.0);
+    float currentWeight = 0.0;
+    float closestDepth = 1.0;
+
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 pixel = clamp(center + ivec2(x, y), ivec2(0), renderMax);
+            vec3 color = Tonemap(texelFetch(uTexColor, pixel, 0).rgb);
+            vec3 ycocg = RGBToYCoCg(color);
+            m1 += ycocg;
+            m2 += ycocg * ycocg;
+
+            // The samples closest to the pixel center rebuild the current frame, with a gaussian fit of Blackman-Harris
+            vec2 delta = (vec2(pixel) + 0.5 - uJitter) - renderPos;
+            float w = exp(-2.29 * dot(delta, delta));
+            current += color * w;
+            currentWeight += w;
+
+            closestDepth = min(closestDepth, texelFetch(uTexDepth, pixel, 0).r);
+        }
+    }
+
+    current /= max(currentWeight, 1e-4);
+
+    /* --- Reproject the history from the closest surface, keeps the edges of the foreground --- */
+
+    vec3 position = V_GetWorldPosition(closestDepth, texCoord * uView.uvScale);
+    vec4 prevClip = uMatPrevViewProj * vec4(position, 1.0);
+    vec2 prevTexCoord = prevClip.xy / prevClip.w * 0.5 + 0.5;
+
+    float historyWeight = uHistoryWeight;
+    if (any(lessThan(prevTexCoord, vec2(0.0))) || any(greaterThan(prevTexCoord, vec2(1.0)))) {
+        historyWeight = 0.0;
+    }
+
+    /* --- Clamp the history to the variance of the neighbourhood --- */
+
+    vec3 mean = m1 / 9.0;
+    vec3 sigma = sqrt(max(m2 / 9.0 - mean * mean, 0.0));
+    vec3 boxMin = mean - 1.25 * sigma;
+    vec3 boxMax = mean + 1.25 * sigma;
+
+    vec3 history = Tonemap(texture(uTexHistory, prevTexCoord).rgb);
+    history = YCoCgToRGB(clamp(RGBToYCoCg(history), boxMin, boxMax));
+
+    /* --- Blend, the current samples count less when they land far from the pixel center --- */
+
+    float alpha = clamp(CURRENT_WEIGHT * currentWeight / 1.5, CURRENT_WEIGHT * 0.25, 1.0);
+    alpha = mix(1.0, alpha, historyWeight);
+
+    FragColor = vec4(TonemapInverse(mix(history, current, alpha)), 1.0);
+}
@@ -15,6 +15,10 @@
 
 #version 330 core
 
+/* === Includes === */
+
+#include "../include/bloom.glsl"
+
 /* === Varyings === */
 
 noperspective in vec2 vTexCoord;
@@ -33,32 +37,5 @@ void main()
 {
     // The filter kernel is applied with a radius, specified in texture
     // coordinates, so that the radius will vary across mip resolutions.
-    float x = uFilterRadius.x;
-    float y = uFilterRadius.y;
-
-    // Take 9 samples around current texel:
-    // a - b - c
-    // d - e - f
-    // g - h - i
-    // === ('e' is the current texel) ===
-    vec3 a = textureLod(uTexture, vec2(vTexCoord.x - x, vTexCoord.y + y), uSrcLevel).rgb;
-    vec3 b = textureLod(uTexture, vec2(vTexCoord.x,     vTexCoord.y + y), uSrcLevel).rgb;
-    vec3 c = textureLod(uTexture, vec2(vTexCoord.x + x, vTexCoord.y + y), uSrcLevel).rgb;
-
-    vec3 d = textureLod(uTexture, vec2(vTexCoord.x - x, vTexCoord.y), uSrcLevel).rgb;
-    vec3 e = textureLod(uTexture, vec2(vTexCoord.x,     vTexCoord.y), uSrcLevel).rgb;
-    vec3 f = textureLod(uTexture, vec2(vTexCoord.x + x, vTexCoord.y), uSrcLevel).rgb;
-
-    vec3 g = textureLod(uTexture, vec2(vTexCoord.x - x, vTexCoord.y - y), uSrcLevel).rgb;
-    vec3 h = textureLod(uTexture, vec2(vTexCoord.x,     vTexCoord.y - y), uSrcLevel).rgb;
-    vec3 i = textureLod(uTexture, vec2(vTexCoord.x + x, vTexCoord.y - y), uSrcLevel).rgb;
-
-    // Apply weighted distribution, by using a 3x3 tent filter:
-    //  1   | 1 2 1 |
-    // -- * | 2 4 2 |
-    // 16   | 1 2 1 |
-    FragColor = e*4.0;
-    FragColor += (b+d+f+h)*2.0;
-    FragColor += (a+c+g+i);
-    FragColor *= 1.0 / 16.0;
+    FragColor = B_Upsample(uTexture, vTexCoord, uFilterRadius, uSrcLevel);
 }
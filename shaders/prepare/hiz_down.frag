@@ -0,0 +1,52 @@
+/* hiz_down.frag -- Min/max-reduction downsampling shader used to build the depth pyramid
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Uniforms === */
+
+// NOTE: When reducing the pyramid itself, the source level
+//       is selected with the base level of the texture
+
+uniform sampler2D uTexDepth;    //< Depth buffer, or the pyramid itself after the first level
+uniform int uFirstLevel;        //< The source is the depth buffer, its single channel is both the min and max
+
+/* === Fragments === */
+
+layout(location = 0) out vec2 FragDepth;   //< R: max depth, G: min depth
+
+/* === Main program === */
+
+void main()
+{
+    ivec2 srcSize = textureSize(uTexDepth, 0);
+    ivec2 srcCoord = ivec2(gl_FragCoord.xy) * 2;
+    ivec2 srcMax = srcSize - 1;
+
+    // The destination size is rounded down, so the last
+    // column/row also has to cover the odd texel left over
+
+    ivec2 dstSize = max(srcSize / 2, ivec2(1));
+    ivec2 extra = ivec2(
+        (int(gl_FragCoord.x) == dstSize.x - 1 && (srcSize.x & 1) != 0) ? 2 : 1,
+        (int(gl_FragCoord.y) == dstSize.y - 1 && (srcSize.y & 1) != 0) ? 2 : 1
+    );
+
+    vec2 depth = vec2(0.0, 1.0);
+
+    for (int y = 0; y <= extra.y; y++) {
+        for (int x = 0; x <= extra.x; x++) {
+            ivec2 coord = min(srcCoord + ivec2(x, y), srcMax);
+            vec2 texel = texelFetch(uTexDepth, coord, 0).rg;
+            if (uFirstLevel != 0) texel.g = texel.r;
+            depth = vec2(max(depth.x, texel.r), min(depth.y, texel.g));
+        }
+    }
+
+    FragDepth = depth;
+}
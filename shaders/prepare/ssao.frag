@@ -32,6 +32,7 @@ uniform float uRadius;
 uniform float uBias;
 uniform float uIntensity;
 uniform float uPower;
+uniform int uFrameIndex;
 
 /* === Constants === */
 
@@ -70,7 +71,8 @@ void main()
 
     // For the spin, the AlchemyAO method did this: float((3*px.x^px.y+px.x*px.y)*10)
     // But I found that using a simple IGN produce a really more stable result
-    float spin = M_TAU * M_HashIGN(gl_FragCoord.xy);
+    // The offset rotates the pattern when accumulated over frames, it is zero otherwise
+    float spin = M_TAU * M_HashIGN(gl_FragCoord.xy + 5.588238 * float(uFrameIndex % 64));
     float radiusSq = uRadius * uRadius;
 
     float aoSum = 0.0;
@@ -78,7 +80,7 @@ void main()
     {
         float rNorm;
         vec2 dir = TapLocation(i, spin, rNorm);
-        vec2 offset = vTexCoord + dir * ssRadius * rNorm;
+        vec2 offset = vTexCoord + dir * ssRadius * rNorm * uView.uvScale;
 
         // The "SAO" paper recommends using mipmaps of the linearized depth here, but hey
         vec3 samplePos = V_GetViewPosition(uTexDepth, offset);
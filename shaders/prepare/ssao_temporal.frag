@@ -0,0 +1,67 @@
+/* ssao_temporal.frag -- Temporal accumulation of the ambient occlusion
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+// The history stores the accumulated occlusion along with the depth it was computed at,
+// the reprojected history is rejected when the depth seen last frame does not match.
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexSource;
+uniform sampler2D uTexHistory;
+uniform sampler2D uTexDepth;
+
+uniform mat4 uMatPrevViewProj;
+uniform vec2 uPrevUvScale;          //< Rendered area of the history, see 'uView.uvScale'
+uniform float uHistoryWeight;
+
+/* === Constants === */
+
+const float DEPTH_TOLERANCE = 0.05;     //< Relative depth difference accepted between two frames
+
+/* === Fragments === */
+
+out vec2 FragOcclusion;
+
+/* === Main program === */
+
+void main()
+{
+    float current = texture(uTexSource, vTexCoord).r;
+    float depth = texture(uTexDepth, vTexCoord).r;
+
+    vec3 position = V_GetWorldPosition(depth, vTexCoord);
+    float linearDepth = (uView.viewProj * vec4(position, 1.0)).w;
+
+    // Reproject the surface into the previous frame
+    vec4 prevClip = uMatPrevViewProj * vec4(position, 1.0);
+    vec2 prevTexCoord = (prevClip.xy / prevClip.w * 0.5 + 0.5) * uPrevUvScale;
+
+    float weight = uHistoryWeight;
+
+    if (any(lessThan(prevTexCoord, vec2(0.0))) || any(greaterThan(prevTexCoord, uPrevUvScale))) {
+        weight = 0.0;
+    }
+
+    // Disoccluded or moving surfaces no longer match the depth of the history
+    vec2 history = texture(uTexHistory, prevTexCoord).rg;
+    if (abs(history.g - prevClip.w) > DEPTH_TOLERANCE * prevClip.w) {
+        weight = 0.0;
+    }
+
+    FragOcclusion = vec2(mix(current, history.r, weight), linearDepth);
+}
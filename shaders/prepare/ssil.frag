@@ -37,6 +37,10 @@ uniform float uHitThickness;
 uniform float uEnergy;
 uniform float uAoPower;
 
+uniform int uFrameIndex;        //< Rotates the jitter when accumulated over frames, zero otherwise
+uniform vec2 uPixelOffset;      //< Pixel shaded in each 2x2 block when interleaved
+uniform vec2 uTexelSize;        //< Texel size of the reconstructed target when interleaved, zero otherwise
+
 /* === Fragments === */
 
 layout(location = 0) out vec4 FragColor;
@@ -72,14 +76,22 @@ void main()
     float visibility = 0.0;
     vec3 lighting = vec3(0.0);
 
-    vec3 position = V_GetViewPosition(uTexDepth, vTexCoord);
-    vec3 normal = V_GetViewNormal(uTexNormal, vTexCoord);
+    // When interleaved, each fragment shades one pixel of a 2x2 block of the reconstructed target
+    vec2 pixel = gl_FragCoord.xy;
+    vec2 texCoord = vTexCoord;
+    if (uTexelSize.x > 0.0) {
+        pixel = floor(gl_FragCoord.xy) * 2.0 + uPixelOffset + 0.5;
+        texCoord = pixel * uTexelSize;
+    }
+
+    vec3 position = V_GetViewPosition(uTexDepth, texCoord);
+    vec3 normal = V_GetViewNormal(uTexNormal, texCoord);
     vec3 camera = normalize(-position);
 
     float sliceRotation = M_TAU / (uSliceCount - 1.0);
     float sampleScale = (-uSampleRadius * uView.proj[0][0]) / position.z;  // World-space to screen-space conversion
     float sampleOffset = 0.01;
-    float jitter = M_HashIGN(gl_FragCoord.xy) - 0.5;
+    float jitter = M_HashIGN(pixel + 5.588238 * float(uFrameIndex % 64)) - 0.5;
 
     // Iterate over angular slices around the hemisphere
     for (float slice = 0.0; slice < uSliceCount + 0.5; slice += 1.0)
@@ -104,7 +116,7 @@ void main()
         for (float currentSample = 0.0; currentSample < uSampleCount + 0.5; currentSample += 1.0)
         {
             float sampleStep = (currentSample + jitter) / uSampleCount + sampleOffset;
-            vec2 sampleUV = vTexCoord - sampleStep * sampleScale * omega * uView.aspect;
+            vec2 sampleUV = texCoord - sampleStep * sampleScale * omega * uView.aspect * uView.uvScale;
 
             vec3 samplePosition = V_GetViewPosition(uTexDepth, sampleUV);
             vec3 sampleNormal = V_GetViewNormal(uTexNormal, sampleUV);
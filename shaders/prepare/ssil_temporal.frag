@@ -0,0 +1,82 @@
+/* ssil_temporal.frag -- Temporal reconstruction of the interleaved indirect lighting
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+// Each frame, one pixel of every 2x2 block is shaded into the sparse target.
+// The shaded pixels are blended into the reprojected history, the others keep their history.
+// The history is rejected when the depth or the normal seen last frame does not match,
+// the pixel then takes the sample shaded in its block this frame.
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+#include "../include/math.glsl"
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexSparse;
+uniform sampler2D uTexHistory;
+uniform sampler2D uTexHistoryGeometry;
+uniform sampler2D uTexDepth;
+uniform sampler2D uTexNormal;
+
+uniform mat4 uMatPrevViewProj;
+uniform vec2 uPrevUvScale;          //< Rendered area of the history, see 'uView.uvScale'
+uniform vec2 uPixelOffset;
+uniform float uConvergence;
+
+/* === Constants === */
+
+const float DEPTH_TOLERANCE = 0.05;     //< Relative depth difference accepted between two frames
+const float NORMAL_TOLERANCE = 0.9;     //< Minimum cosine between the normals of two frames
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragIndirect;
+layout(location = 1) out vec3 FragGeometry;
+
+/* === Main program === */
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 sparsePixel = min(pixel / 2, textureSize(uTexSparse, 0) - 1);
+    vec4 current = texelFetch(uTexSparse, sparsePixel, 0);
+    bool shaded = all(equal(pixel % 2, ivec2(uPixelOffset)));
+
+    float depth = texture(uTexDepth, vTexCoord).r;
+    vec3 position = V_GetWorldPosition(depth, vTexCoord);
+    vec3 normal = V_GetWorldNormal(uTexNormal, vTexCoord);
+    float linearDepth = (uView.viewProj * vec4(position, 1.0)).w;
+
+    // Reproject the surface into the previous frame
+    vec4 prevClip = uMatPrevViewProj * vec4(position, 1.0);
+    vec2 prevTexCoord = (prevClip.xy / prevClip.w * 0.5 + 0.5) * uPrevUvScale;
+
+    bool valid = (uConvergence < 1.0)
+        && all(greaterThanEqual(prevTexCoord, vec2(0.0)))
+        && all(lessThanEqual(prevTexCoord, uPrevUvScale));
+
+    // Disoccluded or moving surfaces no longer match the geometry of the history
+    vec3 prevGeometry = texture(uTexHistoryGeometry, prevTexCoord).rgb;
+    valid = valid && abs(prevGeometry.x - prevClip.w) <= DEPTH_TOLERANCE * prevClip.w;
+    valid = valid && dot(M_DecodeOctahedral(prevGeometry.yz), normal) >= NORMAL_TOLERANCE;
+
+    vec4 history = texture(uTexHistory, prevTexCoord);
+
+    if (!valid) FragIndirect = current;
+    else if (shaded) FragIndirect = mix(history, current, uConvergence);
+    else FragIndirect = history;
+
+    FragGeometry = vec3(linearDepth, M_EncodeOctahedral(normal));
+}
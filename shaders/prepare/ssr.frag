@@ -25,7 +25,9 @@ uniform sampler2D uTexAlbedo;
 uniform sampler2D uTexNormal;
 uniform sampler2D uTexORM;
 uniform sampler2D uTexDepth;
+uniform sampler2D uTexHiZ;      //< Depth pyramid, R: max depth, G: min depth
 
+uniform int uHiZMaxLevel;
 uniform int uMaxRaySteps;
 uniform int uBinarySearchSteps;
 uniform float uRayMarchLength;
@@ -33,10 +35,16 @@ uniform float uDepthThickness;
 uniform float uDepthTolerance;
 uniform float uEdgeFadeStart;
 uniform float uEdgeFadeEnd;
+uniform float uRoughnessCutoff;
 
 uniform vec3 uAmbientColor;
 uniform float uAmbientEnergy;
 
+/* === Constants === */
+
+const float ROUGHNESS_FADE = 0.1;       //< Roughness range over which the reflections fade out before the cutoff
+const float CELL_EPSILON = 1e-5;        //< Distance in texture space used to step into the next cell
+
 /* === Output === */
 
 out vec4 FragColor;
@@ -60,61 +68,133 @@ vec4 SampleScene(vec2 texCoord)
     vec3 ambient = uAmbientColor * uAmbientEnergy;
     ambient *= albedo * (1.0 - orm.b);
 
-    float fade = ScreenEdgeFade(texCoord);
+    float fade = ScreenEdgeFade(texCoord / uView.uvScale);
     return vec4(light + ambient, fade);
 }
 
-/* === Raymarching === */
+vec3 ProjectToScreen(vec3 worldPos)
+{
+    vec4 clipPos = uView.viewProj * vec4(worldPos, 1.0);
+    vec3 screenPos = (clipPos.xyz / clipPos.w) * 0.5 + 0.5;
+    return vec3(screenPos.xy * uView.uvScale, screenPos.z);
+}
 
-vec3 BinarySearch(vec3 startPos, vec3 endPos)
+float GetViewDepth(vec3 screenPos)
 {
-    for (int i = 0; i < uBinarySearchSteps; i++)
-    {
-        vec3 midPos = (startPos + endPos) * 0.5;
-        vec2 uv = V_WorldToScreen(midPos);
+    return -V_GetViewPosition(screenPos.z, screenPos.xy).z;
+}
 
-        vec3 sampledViewPos = V_GetViewPosition(uTexDepth, uv);
-        vec3 midViewPos = (uView.view * vec4(midPos, 1.0)).xyz;
+/* === Hi-Z Traversal === */
 
-        float depthDiff = sampledViewPos.z - midViewPos.z;
+// The ray is traced in texture space, where the depth varies linearly along it.
+// It climbs the min depth pyramid while it stays in front of the cells it crosses,
+// and goes down when it reaches the nearest depth of a cell, until it hits the first level.
+
+float IntersectCell(vec3 origin, vec3 dir, vec2 cell, vec2 cellCount)
+{
+    vec2 boundary = (cell + step(0.0, dir.xy)) / cellCount;
+    vec2 t = (boundary - origin.xy) / dir.xy;
+    return min(t.x, t.y);
+}
+
+vec3 BinarySearch(vec3 origin, vec3 dir, float tFront, float tBehind)
+{
+    for (int i = 0; i < uBinarySearchSteps; i++)
+    {
+        float tMid = (tFront + tBehind) * 0.5;
+        vec3 midPos = origin + dir * tMid;
 
-        if (depthDiff > -uDepthTolerance) {
-            endPos = midPos;    // surface in front of us
+        if (midPos.z >= texture(uTexDepth, midPos.xy).r) {
+            tBehind = tMid;     // surface in front of us
         }
         else {
-            startPos = midPos;  // surface behind
+            tFront = tMid;      // surface behind
         }
     }
 
-    return endPos; // refined final position
+    return origin + dir * tBehind; // refined final position
 }
 
 vec4 TraceReflectionRay(vec3 startPos, vec3 reflectionDir)
 {
-    float minStep = uRayMarchLength / float(uMaxRaySteps);
-    float stepSize = minStep;
+    /* --- Clip the ray to the near plane, the projection flips behind it --- */
 
-    vec3 currentPos = startPos;
+    float rayLength = uRayMarchLength;
 
-    for (int i = 0; i < uMaxRaySteps; i++)
-    {
-        currentPos += reflectionDir * stepSize;
+    vec3 viewPos = (uView.view * vec4(startPos, 1.0)).xyz;
+    vec3 viewDir = mat3(uView.view) * reflectionDir;
+
+    if (viewDir.z > 0.0) {
+        rayLength = min(rayLength, 0.99 * (-uView.near - viewPos.z) / viewDir.z);
+    }
 
-        vec2 uv = V_WorldToScreen(currentPos);
-        if (V_OffScreen(uv)) break;
+    if (rayLength <= 0.0) return vec4(0.0);
 
-        vec3 sampledViewPos = V_GetViewPosition(uTexDepth, uv);
-        vec3 currentViewPos = (uView.view * vec4(currentPos, 1.0)).xyz;
+    /* --- Setup the ray in texture space --- */
 
-        float depthDiff = sampledViewPos.z - currentViewPos.z;
+    vec3 origin = ProjectToScreen(startPos);
+    vec3 dir = ProjectToScreen(startPos + reflectionDir * rayLength) - origin;
 
-        if (depthDiff > -uDepthTolerance && depthDiff < uDepthThickness) {
-            currentPos = BinarySearch(startPos, currentPos);
-            uv = V_WorldToScreen(currentPos);
-            return SampleScene(uv);
-        }
+    // Avoids divisions by zero when crossing the cells
+    dir.xy = mix(dir.xy, vec2(1e-7), lessThan(abs(dir.xy), vec2(1e-7)));
+
+    float tEpsilon = min(CELL_EPSILON / length(dir.xy), 0.01);
+
+    // The ray leaves the cell of its origin first, to avoid intersecting its own surface
+    vec2 baseCount = vec2(textureSize(uTexHiZ, 0));
+    float t = IntersectCell(origin, dir, floor(origin.xy * baseCount), baseCount) + tEpsilon;
+    float tFront = 0.0;
+
+    /* --- Traverse the pyramid --- */
 
-        stepSize = max(depthDiff * 0.9, minStep);
+    int level = 0;
+
+    for (int i = 0; i < uMaxRaySteps && t < 1.0; i++)
+    {
+        vec3 rayPos = origin + dir * t;
+        if (V_OffScreen(rayPos.xy)) break;
+
+        vec2 cellCount = vec2(textureSize(uTexHiZ, level));
+        vec2 cell = min(floor(rayPos.xy * cellCount), cellCount - 1.0);
+        float minDepth = texelFetch(uTexHiZ, ivec2(cell), level).g;
+
+        float tCell = IntersectCell(origin, dir, cell, cellCount) + tEpsilon;
+
+        if (rayPos.z < minDepth)
+        {
+            // In front of the whole cell, until it leaves it or reaches its nearest depth
+            float tDepth = (dir.z > 0.0) ? (minDepth - origin.z) / dir.z : 2.0;
+
+            tFront = t;
+
+            if (tCell < tDepth) {
+                t = tCell;
+                level = min(level + 1, uHiZMaxLevel);
+            }
+            else {
+                t = tDepth;
+                level = max(level - 1, 0);
+            }
+        }
+        else if (level > 0)
+        {
+            level--;
+        }
+        else
+        {
+            // Candidate hit, the thickness is checked against the full resolution depth
+            float sceneDepth = texture(uTexDepth, rayPos.xy).r;
+            float depthDiff = GetViewDepth(rayPos) - GetViewDepth(vec3(rayPos.xy, sceneDepth));
+
+            if (depthDiff > -uDepthTolerance && depthDiff < uDepthThickness) {
+                vec3 hitPos = BinarySearch(origin, dir, tFront, t);
+                return SampleScene(hitPos.xy);
+            }
+
+            // Passes behind the surface, or in front of it within a cell, at the finest level
+            tFront = t;
+            t = tCell;
+        }
     }
 
     return vec4(0.0);
@@ -129,6 +209,11 @@ void main()
     float depth = texture(uTexDepth, vTexCoord).r;
     if (depth > 1.0 - 1e-5) return;
 
+    // Rough surfaces have blurry reflections, the sky and probes are enough there
+    float roughness = texture(uTexORM, vTexCoord).g;
+    float roughnessFade = 1.0 - smoothstep(uRoughnessCutoff - ROUGHNESS_FADE, uRoughnessCutoff, roughness);
+    if (roughnessFade <= 0.0) return;
+
     vec3 worldNormal = V_GetWorldNormal(uTexNormal, vTexCoord);
     vec3 worldPos = V_GetWorldPosition(depth, vTexCoord);
 
@@ -137,4 +222,5 @@ void main()
     if (dot(reflectionDir, worldNormal) < 0.0) return;
 
     FragColor = TraceReflectionRay(worldPos, reflectionDir);
+    FragColor.a *= roughnessFade;
 }
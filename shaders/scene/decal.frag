@@ -50,9 +50,9 @@ layout(location = 3) out vec3 FragORM;
 
 void main()
 {
-    // Normalize screen position to [0, 1]
+    // Normalize screen position to the rendered area of the targets
     vec2 screenPos = vClipPos.xy / vClipPos.w;
-    vec2 fragTexCoord = screenPos * 0.5 + 0.5;
+    vec2 fragTexCoord = (screenPos * 0.5 + 0.5) * uView.uvScale;
 
     // Reconstruct position in view space
     vec3 positionViewSpace = V_GetViewPosition(uTexDepth, fragTexCoord);
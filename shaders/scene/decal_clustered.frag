@@ -0,0 +1,98 @@
+/* decal_clustered.frag -- Fragment shader applying the decals of the screen tiles into G-buffers
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+
+/* === Defines === */
+
+#define DECAL_TILE_X 32
+#define DECAL_TILE_Y 18
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexAlbedo;
+uniform sampler2D uTexEmission;
+uniform sampler2D uTexORM;
+uniform sampler2D uTexDepth;
+
+uniform samplerBuffer uTexDecals;           ///< Parameters of each decal, seven texels each
+uniform usamplerBuffer uTexDecalTiles;      ///< Offset and count in 'uTexDecalIndices' of each tile
+uniform usamplerBuffer uTexDecalIndices;    ///< Index in 'uTexDecals' of the decals of each tile
+uniform vec2 uTileScale;
+uniform int uTileOffset;                    ///< First tile of the batch in 'uTexDecalTiles'
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragAlbedo;
+layout(location = 1) out vec4 FragEmission;
+layout(location = 2) out vec4 FragORM;
+
+/* === Main function === */
+
+void main()
+{
+    /* Get the world position of the geometry */
+
+    vec4 position = vec4(V_GetWorldPosition(uTexDepth, vTexCoord), 1.0);
+
+    /* Get the decals of the tile */
+
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * uTileScale), ivec2(0), ivec2(DECAL_TILE_X - 1, DECAL_TILE_Y - 1));
+    uvec2 range = texelFetch(uTexDecalTiles, uTileOffset + tile.y * DECAL_TILE_X + tile.x).rg;
+
+    /* Composite the decals in submission order, the result is blended once with premultiplied alpha */
+
+    vec4 albedo = vec4(0.0);
+    vec4 emission = vec4(0.0);
+    vec4 orm = vec4(0.0);
+
+    for (uint i = 0u; i < range.y; i++)
+    {
+        int base = 7 * int(texelFetch(uTexDecalIndices, int(range.x + i)).r);
+
+        // Convert from world space to decal projector's model space
+        vec3 positionModelSpace = vec3(
+            dot(texelFetch(uTexDecals, base + 0), position),
+            dot(texelFetch(uTexDecals, base + 1), position),
+            dot(texelFetch(uTexDecals, base + 2), position)
+        );
+
+        if (any(greaterThan(abs(positionModelSpace), vec3(0.5)))) {
+            continue;
+        }
+
+        vec4 color = texelFetch(uTexDecals, base + 3);
+        vec4 emissionCutoff = texelFetch(uTexDecals, base + 4);
+        vec4 texCoord = texelFetch(uTexDecals, base + 5);
+        vec3 factorORM = texelFetch(uTexDecals, base + 6).xyz;
+
+        vec2 decalTexCoord = texCoord.xy + (positionModelSpace.xz + 0.5) * texCoord.zw;
+
+        vec4 decalAlbedo = color * texture(uTexAlbedo, decalTexCoord);
+        if (decalAlbedo.a < emissionCutoff.w) continue;
+
+        vec4 decalEmission = vec4(emissionCutoff.rgb, 1.0) * texture(uTexEmission, decalTexCoord);
+        vec3 decalORM = factorORM * texture(uTexORM, decalTexCoord).xyz;
+
+        albedo = mix(albedo, vec4(decalAlbedo.rgb, 1.0), decalAlbedo.a);
+        emission = mix(emission, vec4(decalEmission.rgb, 1.0), decalEmission.a);
+        orm = mix(orm, vec4(decalORM, 1.0), decalAlbedo.a);
+    }
+
+    FragAlbedo = albedo;
+    FragEmission = emission;
+    FragORM = orm;
+}
@@ -11,10 +11,11 @@
 /* === Includes === */
 
 #include "../include/billboard.glsl"
+#include "../include/instance.glsl"
 
 /* === Attributes === */
 
-layout(location = 0) in vec3 aPosition;
+layout(location = 0) in vec4 aPosition;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 3) in vec4 aColor;
 layout(location = 5) in ivec4 aBoneIDs;
@@ -24,64 +25,96 @@ layout(location = 6) in vec4 aWeights;
 
 layout(location = 10) in mat4 iMatModel;
 layout(location = 14) in vec4 iColor;
+layout(location = 15) in ivec2 iAnimation;    //< Baked animation index and time bits, see 'R3D_InstanceAnimation'
 
 /* === Uniforms === */
 
-uniform sampler1D uTexBoneMatrices;
+uniform samplerBuffer uTexBoneMatrices;
+uniform int uBoneOffset;       ///< First matrix of the pose in the bone palette
+uniform bool uBakedAnimation;  ///< Pose selected per instance in the baked library at 'uBoneOffset'
 
 uniform mat4 uMatInvView;       ///< Only for billboard modes
 uniform mat4 uMatModel;
-uniform mat4 uMatVP;
 
 uniform vec2 uTexCoordOffset;
 uniform vec2 uTexCoordScale;
 uniform float uAlpha;
 
-uniform bool uInstancing;
+uniform int uInstancing;       ///< Layout of the instance attributes, see INSTANCING_*
 uniform bool uSkinning;
 uniform int uBillboard;
 
+uniform bool uCompactVertex;   ///< Quantized attributes, see R3D_VERTEX_FORMAT_COMPACT
+uniform vec3 uPositionMin;
+uniform vec3 uPositionSize;
+
 /* === Varyings === */
 
-out vec3 vPosition;
-out vec2 vTexCoord;
-out float vAlpha;
+// Read by the geometry shader, which projects the vertices on each face
+out vec3 gPosition;
+out vec2 gTexCoord;
+out float gAlpha;
 
 /* === Helper functions === */
 
-mat4 BoneMatrix(int boneID)
+int BakedPoseOffset(int animation, float time)
 {
-    int baseIndex = 4 * boneID;
+    // NOTE: The table layout must match 'R3D_BakeAnimationLib()', one texel per animation
+    //       after the bone count, holding the first matrix, frame count, frame rate and loop flag
+    int tableIndex = 4 * uBoneOffset;
+    int boneCount = int(texelFetch(uTexBoneMatrices, tableIndex).x);
+    vec4 anim = texelFetch(uTexBoneMatrices, tableIndex + 1 + animation);
+
+    int frameCount = int(anim.y);
+    int frame = max(int(time * anim.z + 0.5), 0);
+    frame = (anim.w > 0.5) ? frame % frameCount : min(frame, frameCount - 1);
 
-    vec4 row0 = texelFetch(uTexBoneMatrices, baseIndex + 0, 0);
-    vec4 row1 = texelFetch(uTexBoneMatrices, baseIndex + 1, 0);
-    vec4 row2 = texelFetch(uTexBoneMatrices, baseIndex + 2, 0);
-    vec4 row3 = texelFetch(uTexBoneMatrices, baseIndex + 3, 0);
+    return uBoneOffset + int(anim.x) + frame * boneCount;
+}
+
+mat4 BoneMatrix(int poseOffset, int boneID)
+{
+    int baseIndex = 4 * (poseOffset + boneID);
+
+    vec4 row0 = texelFetch(uTexBoneMatrices, baseIndex + 0);
+    vec4 row1 = texelFetch(uTexBoneMatrices, baseIndex + 1);
+    vec4 row2 = texelFetch(uTexBoneMatrices, baseIndex + 2);
+    vec4 row3 = texelFetch(uTexBoneMatrices, baseIndex + 3);
 
     return transpose(mat4(row0, row1, row2, row3));
 }
 
-mat4 SkinMatrix(ivec4 boneIDs, vec4 weights)
+mat4 SkinMatrix(int poseOffset, ivec4 boneIDs, vec4 weights)
 {
-    return weights.x * BoneMatrix(boneIDs.x) +
-           weights.y * BoneMatrix(boneIDs.y) +
-           weights.z * BoneMatrix(boneIDs.z) +
-           weights.w * BoneMatrix(boneIDs.w);
+    return weights.x * BoneMatrix(poseOffset, boneIDs.x) +
+           weights.y * BoneMatrix(poseOffset, boneIDs.y) +
+           weights.z * BoneMatrix(poseOffset, boneIDs.z) +
+           weights.w * BoneMatrix(poseOffset, boneIDs.w);
 }
 
 /* === Main function === */
 
 void main()
 {
+    vec3 localPosition = aPosition.xyz;
+    if (uCompactVertex) {
+        localPosition = uPositionMin + aPosition.xyz * uPositionSize;
+    }
+
     mat4 matModel = uMatModel;
 
     if (uSkinning) {
-        mat4 sMatModel = SkinMatrix(aBoneIDs, aWeights);
+        int poseOffset = uBoneOffset;
+        if (uBakedAnimation) {
+            poseOffset = BakedPoseOffset(iAnimation.x, intBitsToFloat(iAnimation.y));
+        }
+        mat4 sMatModel = SkinMatrix(poseOffset, aBoneIDs, aWeights);
         matModel = matModel * sMatModel;
     }
 
-    if (uInstancing) {
-        matModel = transpose(iMatModel) * matModel;
+    if (uInstancing != INSTANCING_NONE) {
+        localPosition = InstanceLocal(localPosition, iMatModel, uInstancing);
+        matModel = InstanceMatrix(iMatModel, uInstancing) * matModel;
     }
 
     switch(uBillboard) {
@@ -95,9 +128,7 @@ void main()
         break;
     }
 
-    vPosition = vec3(matModel * vec4(aPosition, 1.0));
-    vTexCoord = uTexCoordOffset + aTexCoord * uTexCoordScale;
-    vAlpha = uAlpha * iColor.a * aColor.a;
-
-    gl_Position = uMatVP * vec4(vPosition, 1.0);
+    gPosition = vec3(matModel * vec4(localPosition, 1.0));
+    gTexCoord = uTexCoordOffset + InstanceTexCoord(aTexCoord, iMatModel, uInstancing) * uTexCoordScale;
+    gAlpha = uAlpha * iColor.a * aColor.a;
 }
@@ -0,0 +1,55 @@
+/* depth_downsample.frag -- Depth reduction for the reduced resolution forward draws
+ *
+ * Writes the farthest depth of each block of the full resolution depth buffer,
+ * and clears the color of the reduced target in the same draw.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Uniforms === */
+
+uniform sampler2D uTexDepth;    //< Full resolution depth buffer
+uniform int uFactor;            //< Full resolution texels per reduced texel, on each axis
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragColor;
+
+/* === Main program === */
+
+void main()
+{
+    ivec2 srcSize = textureSize(uTexDepth, 0);
+    ivec2 dstSize = max(srcSize / uFactor, ivec2(1));
+    ivec2 dstCoord = ivec2(gl_FragCoord.xy);
+
+    // The reduced size is rounded down, so the last
+    // column/row also covers the texels left over
+
+    ivec2 srcBegin = dstCoord * uFactor;
+    ivec2 srcEnd = srcBegin + uFactor;
+    if (dstCoord.x == dstSize.x - 1) srcEnd.x = srcSize.x;
+    if (dstCoord.y == dstSize.y - 1) srcEnd.y = srcSize.y;
+    srcEnd = min(srcEnd, srcSize);
+
+    // The farthest depth keeps the effects behind thin foreground edges,
+    // the bilateral upsample then rejects them over the foreground texels
+
+    float depth = 0.0;
+
+    for (int y = srcBegin.y; y < srcEnd.y; y++) {
+        for (int x = srcBegin.x; x < srcEnd.x; x++) {
+            depth = max(depth, texelFetch(uTexDepth, ivec2(x, y), 0).r);
+        }
+    }
+
+    gl_FragDepth = depth;
+
+    // Nothing drawn yet, the scene is fully transmitted
+    FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+}
@@ -10,35 +10,14 @@
 
 /* === Includes === */
 
-#include "../include/light.glsl"
+#include "../include/blocks/light.glsl"
+#include "../include/blocks/shadow.glsl"
+#include "../include/blocks/view.glsl"
+#include "../include/blocks/sky.glsl"
 #include "../include/math.glsl"
 #include "../include/pbr.glsl"
 #include "../include/ibl.glsl"
 
-/* === Structs === */
-
-struct Light
-{
-    vec3 color;
-    vec3 position;
-    vec3 direction;
-    float specular;
-    float energy;
-    float range;
-    float near;
-    float far;
-    float attenuation;
-    float innerCutOff;
-    float outerCutOff;
-    float shadowSoftness;
-    float shadowTexelSize;
-    float shadowDepthBias;
-    float shadowSlopeBias;
-    lowp int type;
-    bool enabled;
-    bool shadow;
-};
-
 /* === Varyings === */
 
 in vec3 vPosition;
@@ -46,8 +25,6 @@ in vec2 vTexCoord;
 in vec4 vColor;
 in mat3 vTBN;
 
-in vec4 vPosLightSpace[LIGHT_FORWARD_COUNT];
-
 /* === Uniforms === */
 
 uniform sampler2D uTexAlbedo;
@@ -55,8 +32,7 @@ uniform sampler2D uTexEmission;
 uniform sampler2D uTexNormal;
 uniform sampler2D uTexORM;
 
-uniform samplerCube uShadowMapCube[LIGHT_FORWARD_COUNT];
-uniform sampler2D uShadowMap2D[LIGHT_FORWARD_COUNT];
+uniform sampler2DShadow uTexShadowAtlas;
 
 uniform float uEmissionEnergy;
 uniform float uNormalScale;
@@ -67,7 +43,6 @@ uniform float uMetalness;
 uniform vec3 uAmbientColor;
 uniform vec3 uEmissionColor;
 
-uniform samplerCube uCubeIrradiance;
 uniform samplerCube uCubePrefilter;
 uniform sampler2D uTexBrdfLut;
 uniform vec4 uQuatSkybox;
@@ -75,130 +50,112 @@ uniform bool uHasSkybox;
 uniform float uAmbientEnergy;
 uniform float uReflectEnergy;
 
-uniform Light uLights[LIGHT_FORWARD_COUNT];
+uniform int uShadowIndices[LIGHT_BLOCK_SHADOWS];   ///< Index in the light block of the shadowed lights affecting the draw
+uniform int uShadowCount;
+
+uniform usamplerBuffer uTexLightClusters;   ///< Offset and count in 'uTexLightIndices' of each cluster
+uniform usamplerBuffer uTexLightIndices;    ///< Index in the light block of the lights of each cluster
+uniform vec2 uClusterTileScale;
+uniform vec2 uClusterSlice;
 
 uniform float uAlphaCutoff;
 uniform vec3 uViewPosition;
 
-/* === Constants === */
-
-#define SHADOW_SAMPLES 8
-
-const vec2 VOGEL_DISK[8] = vec2[8](
-    vec2(0.250000, 0.000000),
-    vec2(-0.319290, 0.292496),
-    vec2(0.048872, -0.556877),
-    vec2(0.402444, 0.524918),
-    vec2(-0.738535, -0.130636),
-    vec2(0.699605, -0.445031),
-    vec2(-0.234004, 0.870484),
-    vec2(-0.446271, -0.859268)
-);
+uniform bool uWeightedOIT;                  ///< Writes the weighted accumulation of 'oit_resolve.frag' instead of the color
 
 /* === Fragments === */
 
 layout(location = 0) out vec4 FragColor;
+layout(location = 1) out float FragWeight;
 
-/* === Shadow functions === */
+/* === Lighting functions === */
 
-float ShadowDir(int i, float cNdotL, mat2 diskRot)
+int GetClusterIndex()
 {
-    Light light = uLights[i];
-
-    /* --- Light Space Projection --- */
+    float depth = -(uView.view * vec4(vPosition, 1.0)).z;
+    int slice = int(log(max(depth, 1e-4)) * uClusterSlice.x + uClusterSlice.y);
+    ivec2 tile = ivec2(gl_FragCoord.xy * uClusterTileScale);
 
-    vec4 p = vPosLightSpace[i];
-    vec3 projCoords = p.xyz / p.w;
-    projCoords = projCoords * 0.5 + 0.5;
+    ivec3 maxCluster = ivec3(LIGHT_CLUSTER_X - 1, LIGHT_CLUSTER_Y - 1, LIGHT_CLUSTER_Z - 1);
+    ivec3 cluster = clamp(ivec3(tile, slice), ivec3(0), maxCluster);
 
-    /* --- Shadow Bias and Depth Adjustment --- */
-
-    float bias = light.shadowSlopeBias * (1.0 - cNdotL);
-    bias = max(bias, light.shadowDepthBias * projCoords.z);
-    float currentDepth = projCoords.z - bias;
-
-    /* --- Poisson Disk PCF Sampling --- */
-
-    float shadow = 0.0;
-    for (int j = 0; j < SHADOW_SAMPLES; ++j) {
-        vec2 offset = diskRot * VOGEL_DISK[j] * light.shadowSoftness;
-        shadow += step(currentDepth, texture(uShadowMap2D[i], projCoords.xy + offset).r);
-    }
-    shadow /= float(SHADOW_SAMPLES);
-
-    /* --- Apply a fade to the edges of the projection --- */
+    return (cluster.z * LIGHT_CLUSTER_Y + cluster.y) * LIGHT_CLUSTER_X + cluster.x;
+}
 
-    vec3 distToBorder = min(projCoords, 1.0 - projCoords);
-    float edgeFade = smoothstep(0.0, 0.15, min(distToBorder.x, min(distToBorder.y, distToBorder.z)));
-    shadow = mix(1.0, shadow, edgeFade);
+void LightContribution(Light light, int shadowIndex, vec3 N, vec3 V, float cNdotV, vec3 F0,
+                       float roughness, float metalness, mat2 diskRot, inout vec3 diffuse, inout vec3 specular)
+{
+    /* Compute light direction */
 
-    /* --- Final Shadow Value --- */
+    vec3 L = vec3(0.0);
+    if (light.type == LIGHT_DIR) L = -light.direction;
+    else L = normalize(light.position - vPosition);
 
-    return shadow;
-}
+    /* Compute the dot product of the normal and light direction */
 
-float ShadowSpot(int i, float cNdotL, mat2 diskRot)
-{
-    Light light = uLights[i];
+    float NdotL = dot(N, L);
+    if (NdotL <= 0.0) return;
+    float cNdotL = min(NdotL, 1.0); // clamped NdotL
 
-    /* --- Light Space Projection --- */
+    /* Compute the halfway vector between the view and light directions */
 
-    vec4 p = vPosLightSpace[i];
-    vec3 projCoords = p.xyz / p.w;
-    projCoords = projCoords * 0.5 + 0.5;
+    vec3 H = normalize(V + L);
 
-    /* --- Shadow Bias and Depth Adjustment --- */
+    float LdotH = max(dot(L, H), 0.0);
+    float cLdotH = min(LdotH, 1.0);
 
-    float bias = light.shadowSlopeBias * (1.0 - cNdotL);
-    bias = max(bias, light.shadowDepthBias * projCoords.z);
-    float currentDepth = projCoords.z - bias;
+    float NdotH = max(dot(N, H), 0.0);
+    float cNdotH = min(NdotH, 1.0);
 
-    /* --- Poisson Disk PCF Sampling --- */
+    /* Compute light color energy */
 
-    float shadow = 0.0;
-    for (int j = 0; j < SHADOW_SAMPLES; ++j) {
-        vec2 offset = diskRot * VOGEL_DISK[j] * light.shadowSoftness;
-        shadow += step(currentDepth, texture(uShadowMap2D[i], projCoords.xy + offset).r);
-    }
+    vec3 lightColE = light.color * light.energy;
 
-    /* --- Final Shadow Value --- */
+    /* Compute diffuse lighting */
 
-    return shadow / float(SHADOW_SAMPLES);
-}
+    vec3 diffLight = L_Diffuse(cLdotH, cNdotV, cNdotL, roughness);
+    diffLight *= lightColE * (1.0 - metalness); // 0.0 for pure metal, 1.0 for dielectric
 
-float ShadowOmni(int i, float cNdotL, mat2 diskRot)
-{
-    Light light = uLights[i];
+    /* Compute specular lighting */
 
-    /* --- Light Vector and Distance Calculation --- */
+    vec3 specLight =  L_Specular(F0, cLdotH, cNdotH, cNdotV, cNdotL, roughness);
+    specLight *= lightColE * light.specular;
 
-    vec3 lightToFrag = vPosition - light.position;
-    float currentDepth = length(lightToFrag);
-    vec3 direction = normalize(lightToFrag);
+    /* Apply shadow factor if the light casts shadows */
 
-    /* --- Shadow Bias and Depth Adjustment --- */
+    float shadow = 1.0;
 
-    float bias = light.shadowSlopeBias * (1.0 - cNdotL * 0.5);
-    bias = max(bias, light.shadowDepthBias * currentDepth);
-    currentDepth -= bias;
+    if (shadowIndex >= 0) {
+        LightShadow params = uLightShadows[shadowIndex];
+        switch (light.type) {
+        case LIGHT_DIR: shadow = S_ShadowDir(uTexShadowAtlas, params, vPosition, cNdotL, diskRot); break;
+        case LIGHT_SPOT: shadow = S_ShadowSpot(uTexShadowAtlas, params, vPosition, cNdotL, diskRot); break;
+        case LIGHT_OMNI: shadow = S_ShadowOmni(uTexShadowAtlas, params, light.position, vPosition, cNdotL, diskRot); break;
+        }
+    }
 
-    /* --- Build orthonormal basis for perturbation --- */
+    /* Apply attenuation based on the distance from the light */
 
-    mat3 OBN = M_OrthonormalBasis(direction);
+    if (light.type != LIGHT_DIR)
+    {
+        float dist = length(light.position - vPosition);
+        float atten = 1.0 - clamp(dist / light.range, 0.0, 1.0);
+        shadow *= atten * light.attenuation;
+    }
 
-    /* --- Poisson Disk PCF Sampling --- */
+    /* Apply spotlight effect if the light is a spotlight */
 
-    float shadow = 0.0;
-    for (int j = 0; j < SHADOW_SAMPLES; ++j) {
-        vec2 diskOffset = diskRot * VOGEL_DISK[j] * light.shadowSoftness;
-        vec3 sampleDir = normalize(OBN * vec3(diskOffset.xy, 1.0));
-        float sampleDepth = texture(uShadowMapCube[i], sampleDir).r * light.far;
-        shadow += step(currentDepth, sampleDepth);
+    if (light.type == LIGHT_SPOT)
+    {
+        float theta = dot(L, -light.direction);
+        float epsilon = (light.innerCutOff - light.outerCutOff);
+        shadow *= smoothstep(0.0, 1.0, (theta - light.outerCutOff) / epsilon);
     }
 
-    /* --- Final Shadow Value --- */
+    /* Accumulate the diffuse and specular lighting contributions */
 
-    return shadow / float(SHADOW_SAMPLES);
+    diffuse += diffLight * shadow;
+    specular += specLight * shadow;
 }
 
 /* === Main === */
@@ -231,96 +188,30 @@ void main()
     float NdotV = dot(N, V);
     float cNdotV = max(NdotV, 1e-4);  // Clamped to avoid division by zero
 
-    /* Loop through all light sources accumulating diffuse and specular light */
+    /* Calculating a random rotation matrix for shadow debanding */
 
-    vec3 diffuse = vec3(0.0);
-    vec3 specular = vec3(0.0);
-
-    for (int i = 0; i < LIGHT_FORWARD_COUNT; i++)
-    {
-        if (!uLights[i].enabled) {
-            continue;
-        }
+    float r = M_TAU * M_HashIGN(gl_FragCoord.xy);
+    float sr = sin(r), cr = cos(r);
 
-        Light light = uLights[i];
+    mat2 diskRot = mat2(vec2(cr, -sr), vec2(sr, cr));
 
-        /* Compute light direction */
+    /* Accumulate the shadowed lights affecting this draw */
 
-        vec3 L = vec3(0.0);
-        if (light.type == LIGHT_DIR) L = -light.direction;
-        else L = normalize(light.position - vPosition);
-
-        /* Compute the dot product of the normal and light direction */
-
-        float NdotL = dot(N, L);
-        if (NdotL <= 0.0) continue;
-        float cNdotL = min(NdotL, 1.0); // clamped NdotL
-
-        /* Compute the halfway vector between the view and light directions */
-
-        vec3 H = normalize(V + L);
-
-        float LdotH = max(dot(L, H), 0.0);
-        float cLdotH = min(LdotH, 1.0);
-
-        float NdotH = max(dot(N, H), 0.0);
-        float cNdotH = min(NdotH, 1.0);
-
-        /* Compute light color energy */
-
-        vec3 lightColE = light.color * light.energy;
-
-        /* Compute diffuse lighting */
-
-        vec3 diffLight = L_Diffuse(cLdotH, cNdotV, cNdotL, roughness);
-        diffLight *= lightColE * (1.0 - metalness); // 0.0 for pure metal, 1.0 for dielectric
-
-        /* Compute specular lighting */
-
-        vec3 specLight =  L_Specular(F0, cLdotH, cNdotH, cNdotV, cNdotL, roughness);
-        specLight *= lightColE * light.specular;
-
-        /* --- Calculating a random rotation matrix for shadow debanding --- */
-
-        float r = M_TAU * M_HashIGN(gl_FragCoord.xy);
-        float sr = sin(r), cr = cos(r);
-
-        mat2 diskRot = mat2(vec2(cr, -sr), vec2(sr, cr));
-
-        /* Apply shadow factor if the light casts shadows */
-
-        float shadow = 1.0;
-
-        if (light.shadow) {
-            switch (light.type) {
-            case LIGHT_DIR: shadow = ShadowDir(i, cNdotL, diskRot); break;
-            case LIGHT_SPOT: shadow = ShadowSpot(i, cNdotL, diskRot); break;
-            case LIGHT_OMNI: shadow = ShadowOmni(i, cNdotL, diskRot); break;
-            }
-        }
-
-        /* Apply attenuation based on the distance from the light */
-
-        if (light.type != LIGHT_DIR)
-        {
-            float dist = length(light.position - vPosition);
-            float atten = 1.0 - clamp(dist / light.range, 0.0, 1.0);
-            shadow *= atten * light.attenuation;
-        }
+    vec3 diffuse = vec3(0.0);
+    vec3 specular = vec3(0.0);
 
-        /* Apply spotlight effect if the light is a spotlight */
+    for (int i = 0; i < uShadowCount; i++) {
+        int index = uShadowIndices[i];
+        LightContribution(uLights[index], index, N, V, cNdotV, F0, roughness, metalness, diskRot, diffuse, specular);
+    }
 
-        if (light.type == LIGHT_SPOT)
-        {
-            float theta = dot(L, -light.direction);
-            float epsilon = (light.innerCutOff - light.outerCutOff);
-            shadow *= smoothstep(0.0, 1.0, (theta - light.outerCutOff) / epsilon);
-        }
+    /* Then the other lights assigned to the cluster of the fragment */
 
-        /* Accumulate the diffuse and specular lighting contributions */
+    uvec2 cluster = texelFetch(uTexLightClusters, GetClusterIndex()).rg;
 
-        diffuse += diffLight * shadow;
-        specular += specLight * shadow;
+    for (uint i = 0u; i < cluster.y; i++) {
+        int index = int(texelFetch(uTexLightIndices, int(cluster.x + i)).r);
+        LightContribution(uLights[index], -1, N, V, cNdotV, F0, roughness, metalness, diskRot, diffuse, specular);
     }
 
     /* Compute ambient - (IBL diffuse) */
@@ -332,7 +223,7 @@ void main()
         vec3 kD = (1.0 - kS) * (1.0 - metalness);
 
         vec3 Nr = M_Rotate3D(N, uQuatSkybox);
-        ambient = kD * texture(uCubeIrradiance, Nr).rgb;
+        ambient = kD * S_GetIrradiance(Nr);
         ambient *= uAmbientEnergy;
     }
     else {
@@ -355,5 +246,16 @@ void main()
 
     /* Compute the final fragment color */
 
-    FragColor = vec4(albedo.rgb * diffuse + specular + emission, albedo.a);
+    vec3 color = albedo.rgb * diffuse + specular + emission;
+
+    if (uWeightedOIT) {
+        // Weight of McGuire and Bavoil, favours the near and opaque layers
+        float depth = -(uView.view * vec4(vPosition, 1.0)).z;
+        float weight = albedo.a * clamp(10.0 / (1e-5 + pow(depth / 5.0, 2.0) + pow(depth / 200.0, 6.0)), 1e-2, 3e3);
+        FragColor = vec4(color * weight, albedo.a);
+        FragWeight = weight;
+        return;
+    }
+
+    FragColor = vec4(color, albedo.a);
 }
@@ -12,11 +12,12 @@
 
 #include "../include/blocks/view.glsl"
 #include "../include/billboard.glsl"
-#include "../include/light.glsl"
+#include "../include/instance.glsl"
+#include "../include/math.glsl"
 
 /* === Attributes === */
 
-layout(location = 0) in vec3 aPosition;
+layout(location = 0) in vec4 aPosition;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 2) in vec3 aNormal;
 layout(location = 3) in vec4 aColor;
@@ -26,12 +27,14 @@ layout(location = 6) in vec4 aWeights;
 
 layout(location = 10) in mat4 iMatModel;
 layout(location = 14) in vec4 iColor;
+layout(location = 15) in ivec2 iAnimation;    //< Baked animation index and time bits, see 'R3D_InstanceAnimation'
 
 /* === Uniforms === */
 
-uniform sampler1D uTexBoneMatrices;
+uniform samplerBuffer uTexBoneMatrices;
+uniform int uBoneOffset;       ///< First matrix of the pose in the bone palette
+uniform bool uBakedAnimation;  ///< Pose selected per instance in the baked library at 'uBoneOffset'
 
-uniform mat4 uMatLightVP[LIGHT_FORWARD_COUNT];
 uniform mat4 uMatNormal;
 uniform mat4 uMatModel;
 
@@ -39,10 +42,14 @@ uniform vec4 uAlbedoColor;
 uniform vec2 uTexCoordOffset;
 uniform vec2 uTexCoordScale;
 
-uniform bool uInstancing;
+uniform int uInstancing;       ///< Layout of the instance attributes, see INSTANCING_*
 uniform bool uSkinning;
 uniform int uBillboard;
 
+uniform bool uCompactVertex;   ///< Quantized attributes, see R3D_VERTEX_FORMAT_COMPACT
+uniform vec3 uPositionMin;
+uniform vec3 uPositionSize;
+
 /* === Varyings === */
 
 out vec3 vPosition;
@@ -50,46 +57,77 @@ out vec2 vTexCoord;
 out vec4 vColor;
 out mat3 vTBN;
 
-out vec4 vPosLightSpace[LIGHT_FORWARD_COUNT];
-
 /* === Helper Functions === */
 
-mat4 BoneMatrix(int boneID)
+int BakedPoseOffset(int animation, float time)
 {
-    int baseIndex = 4 * boneID;
+    // NOTE: The table layout must match 'R3D_BakeAnimationLib()', one texel per animation
+    //       after the bone count, holding the first matrix, frame count, frame rate and loop flag
+    int tableIndex = 4 * uBoneOffset;
+    int boneCount = int(texelFetch(uTexBoneMatrices, tableIndex).x);
+    vec4 anim = texelFetch(uTexBoneMatrices, tableIndex + 1 + animation);
+
+    int frameCount = int(anim.y);
+    int frame = max(int(time * anim.z + 0.5), 0);
+    frame = (anim.w > 0.5) ? frame % frameCount : min(frame, frameCount - 1);
 
-    vec4 row0 = texelFetch(uTexBoneMatrices, baseIndex + 0, 0);
-    vec4 row1 = texelFetch(uTexBoneMatrices, baseIndex + 1, 0);
-    vec4 row2 = texelFetch(uTexBoneMatrices, baseIndex + 2, 0);
-    vec4 row3 = texelFetch(uTexBoneMatrices, baseIndex + 3, 0);
+    return uBoneOffset + int(anim.x) + frame * boneCount;
+}
+
+mat4 BoneMatrix(int poseOffset, int boneID)
+{
+    int baseIndex = 4 * (poseOffset + boneID);
+
+    vec4 row0 = texelFetch(uTexBoneMatrices, baseIndex + 0);
+    vec4 row1 = texelFetch(uTexBoneMatrices, baseIndex + 1);
+    vec4 row2 = texelFetch(uTexBoneMatrices, baseIndex + 2);
+    vec4 row3 = texelFetch(uTexBoneMatrices, baseIndex + 3);
 
     return transpose(mat4(row0, row1, row2, row3));
 }
 
-mat4 SkinMatrix(ivec4 boneIDs, vec4 weights)
+mat4 SkinMatrix(int poseOffset, ivec4 boneIDs, vec4 weights)
 {
-    return weights.x * BoneMatrix(boneIDs.x) +
-           weights.y * BoneMatrix(boneIDs.y) +
-           weights.z * BoneMatrix(boneIDs.z) +
-           weights.w * BoneMatrix(boneIDs.w);
+    return weights.x * BoneMatrix(poseOffset, boneIDs.x) +
+           weights.y * BoneMatrix(poseOffset, boneIDs.y) +
+           weights.z * BoneMatrix(poseOffset, boneIDs.z) +
+           weights.w * BoneMatrix(poseOffset, boneIDs.w);
 }
 
 /* === Main program === */
 
 void main()
 {
+    vec3 localPosition = aPosition.xyz;
+    vec3 localNormal = aNormal;
+    vec4 localTangent = aTangent;
+
+    if (uCompactVertex) {
+        localPosition = uPositionMin + aPosition.xyz * uPositionSize;
+        localNormal = M_DecodeOctahedral(aNormal.xy);
+        localTangent = vec4(M_DecodeOctahedral(aTangent.xy), aPosition.w * 2.0 - 1.0);
+    }
+
     mat4 matModel = uMatModel;
     mat3 matNormal = mat3(uMatNormal);
 
     if (uSkinning) {
-        mat4 sMatModel = SkinMatrix(aBoneIDs, aWeights);
+        int poseOffset = uBoneOffset;
+        if (uBakedAnimation) {
+            poseOffset = BakedPoseOffset(iAnimation.x, intBitsToFloat(iAnimation.y));
+        }
+        mat4 sMatModel = SkinMatrix(poseOffset, aBoneIDs, aWeights);
         matModel = matModel * sMatModel;
         matNormal = matNormal * mat3(transpose(inverse(sMatModel)));
     }
 
-    if (uInstancing) {
-        matModel = transpose(iMatModel) * matModel;
-        matNormal = mat3(transpose(inverse(iMatModel))) * matNormal;
+    if (uInstancing != INSTANCING_NONE) {
+        localPosition = InstanceLocal(localPosition, iMatModel, uInstancing);
+        localNormal = InstanceLocal(localNormal, iMatModel, uInstancing);
+        localTangent.xyz = InstanceLocal(localTangent.xyz, iMatModel, uInstancing);
+        mat4 instanceModel = InstanceMatrix(iMatModel, uInstancing);
+        matModel = instanceModel * matModel;
+        matNormal = mat3(transpose(inverse(instanceModel))) * matNormal;
     }
 
     switch(uBillboard) {
@@ -103,18 +141,14 @@ void main()
         break;
     }
 
-    vec3 T = normalize(matNormal * aTangent.xyz);
-    vec3 N = normalize(matNormal * aNormal);
-    vec3 B = normalize(cross(N, T) * aTangent.w);
+    vec3 T = normalize(matNormal * localTangent.xyz);
+    vec3 N = normalize(matNormal * localNormal);
+    vec3 B = normalize(cross(N, T) * localTangent.w);
 
-    vPosition = vec3(matModel * vec4(aPosition, 1.0));
-    vTexCoord = uTexCoordOffset + aTexCoord * uTexCoordScale;
+    vPosition = vec3(matModel * vec4(localPosition, 1.0));
+    vTexCoord = uTexCoordOffset + InstanceTexCoord(aTexCoord, iMatModel, uInstancing) * uTexCoordScale;
     vColor = aColor * iColor * uAlbedoColor;
     vTBN = mat3(T, B, N);
 
-    for (int i = 0; i < LIGHT_FORWARD_COUNT; i++) {
-        vPosLightSpace[i] = uMatLightVP[i] * vec4(vPosition, 1.0);
-    }
-
     gl_Position = uView.viewProj * vec4(vPosition, 1.0);
 }
@@ -15,6 +15,8 @@
 /* === Varyings === */
 
 flat in vec3 vEmission;
+flat in vec4 vMaterial;
+flat in float vAlphaCutoff;
 in vec2 vTexCoord;
 in vec4 vColor;
 in mat3 vTBN;
@@ -26,12 +28,6 @@ uniform sampler2D uTexNormal;
 uniform sampler2D uTexEmission;
 uniform sampler2D uTexORM;
 
-uniform float uAlphaCutoff;
-uniform float uNormalScale;
-uniform float uOcclusion;
-uniform float uRoughness;
-uniform float uMetalness;
-
 /* === Fragments === */
 
 layout(location = 0) out vec3 FragAlbedo;
@@ -45,9 +41,9 @@ void main()
 {
     // Sample material properties into globals that custom shaders can modify
     vec4 ALBEDO = vColor * texture(uTexAlbedo, vTexCoord);
-    if (ALBEDO.a < uAlphaCutoff) discard;
+    if (ALBEDO.a < vAlphaCutoff) discard;
 
-    vec3 NORMAL = normalize(vTBN * M_NormalScale(texture(uTexNormal, vTexCoord).rgb * 2.0 - 1.0, uNormalScale));
+    vec3 NORMAL = normalize(vTBN * M_NormalScale(texture(uTexNormal, vTexCoord).rgb * 2.0 - 1.0, vMaterial.x));
     if (!gl_FrontFacing) NORMAL = -NORMAL; // Flip for back facing triangles with double sided meshes
 
     vec3 ORM = texture(uTexORM, vTexCoord).rgb;
@@ -59,7 +55,7 @@ void main()
     FragAlbedo = ALBEDO.rgb;
     FragEmission = EMISSION;
     FragNormal = M_EncodeOctahedral(NORMAL);
-    FragORM.r = uOcclusion * ORM.x;
-    FragORM.g = uRoughness * ORM.y;
-    FragORM.b = uMetalness * ORM.z;
+    FragORM.r = vMaterial.y * ORM.x;
+    FragORM.g = vMaterial.z * ORM.y;
+    FragORM.b = vMaterial.w * ORM.z;
 }
@@ -0,0 +1,39 @@
+/* oit_resolve.frag -- Weighted blended transparency resolve fragment shader
+ *
+ * Composes the transparent layers accumulated by 'forward.frag'
+ * over the scene, blended with (ONE_MINUS_SRC_ALPHA, SRC_ALPHA).
+ *
+ * Copyright (c) 2025 Victor Le Juez
+ *
+ * This software is distributed under the terms of the accompanying LICENSE file.
+ * It is provided "as-is", without any express or implied warranty.
+ */
+
+#version 330 core
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexAccum;    ///< Sum of the weighted colors in RGB, product of the transmittances in A
+uniform sampler2D uTexWeight;   ///< Sum of the weights
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragColor;
+
+/* === Main function === */
+
+void main()
+{
+    vec4 accum = texture(uTexAccum, vTexCoord);
+
+    // No transparent layer covers this pixel
+    if (accum.a >= 1.0) discard;
+
+    float weight = texture(uTexWeight, vTexCoord).r;
+
+    FragColor = vec4(accum.rgb / max(weight, 1e-5), accum.a);
+}
@@ -0,0 +1,73 @@
+/* reduced_compose.frag -- Composition of the reduced resolution forward draws
+ *
+ * Upsamples the reduced target with a bilateral filter, the texels whose
+ * depth differs from the full resolution depth are rejected, so that the
+ * effects don't bleed over the edges of the geometry in front of them.
+ * Blended over the scene with (ONE, SRC_ALPHA).
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#version 330 core
+
+/* === Includes === */
+
+#include "../include/blocks/view.glsl"
+
+/* === Varyings === */
+
+noperspective in vec2 vTexCoord;
+
+/* === Uniforms === */
+
+uniform sampler2D uTexColor;        //< Blended colors in RGB, product of the transmittances in A
+uniform sampler2D uTexDepth;        //< Full resolution depth buffer
+uniform sampler2D uTexReducedDepth; //< Depth used by the reduced draws, see 'depth_downsample.frag'
+
+/* === Fragments === */
+
+layout(location = 0) out vec4 FragColor;
+
+/* === Constants === */
+
+const float DEPTH_SENSITIVITY = 0.05;   //< Relative depth difference at which a texel weight is halved
+
+/* === Main program === */
+
+void main()
+{
+    ivec2 size = textureSize(uTexColor, 0);
+    vec2 coord = vTexCoord * vec2(size) - 0.5;
+    ivec2 base = ivec2(floor(coord));
+    vec2 f = fract(coord);
+
+    float depth = V_LinearizeDepth(texture(uTexDepth, vTexCoord).r);
+
+    // The rejected part of the bilinear weights is filled with an empty texel,
+    // a foreground thinner than a reduced texel then hides the effects behind it
+
+    vec4 result = vec4(0.0);
+    float total = 0.0;
+
+    for (int i = 0; i < 4; i++) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 p = clamp(base + offset, ivec2(0), size - 1);
+
+        vec2 b = mix(1.0 - f, f, vec2(offset));
+        float d = V_LinearizeDepth(texelFetch(uTexReducedDepth, p, 0).r);
+        float w = b.x * b.y / (1.0 + abs(d - depth) / (DEPTH_SENSITIVITY * depth));
+
+        result += texelFetch(uTexColor, p, 0) * w;
+        total += w;
+    }
+
+    result.a += 1.0 - total;
+
+    // No reduced draw covers this pixel, the additive ones only add color
+    if (result.a >= 1.0 && dot(result.rgb, vec3(1.0)) <= 0.0) discard;
+
+    FragColor = result;
+}
@@ -0,0 +1,445 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "./r3d_bvh.h"
+#include <raymath.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+/* === Internal functions === */
+
+static inline BoundingBox box_union(const BoundingBox* a, const BoundingBox* b)
+{
+    return (BoundingBox) {
+        Vector3Min(a->min, b->min),
+        Vector3Max(a->max, b->max)
+    };
+}
+
+static inline float box_perimeter(const BoundingBox* box)
+{
+    Vector3 d = Vector3Subtract(box->max, box->min);
+    return 2.0f * (d.x + d.y + d.z);
+}
+
+static inline bool box_contains(const BoundingBox* outer, const BoundingBox* inner)
+{
+    return outer->min.x <= inner->min.x && outer->min.y <= inner->min.y && outer->min.z <= inner->min.z
+        && outer->max.x >= inner->max.x && outer->max.y >= inner->max.y && outer->max.z >= inner->max.z;
+}
+
+static inline bool box_overlaps(const BoundingBox* a, const BoundingBox* b)
+{
+    return a->min.x <= b->max.x && a->max.x >= b->min.x
+        && a->min.y <= b->max.y && a->max.y >= b->min.y
+        && a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static inline bool is_leaf(const r3d_bvh_node_t* node)
+{
+    return node->child[0] < 0;
+}
+
+static BoundingBox fatten_box(const BoundingBox* box)
+{
+    Vector3 d = Vector3Subtract(box->max, box->min);
+    float margin = 0.5f * R3D_BVH_FAT_RATIO * fmaxf(d.x, fmaxf(d.y, d.z));
+    Vector3 m = {margin, margin, margin};
+
+    return (BoundingBox) {
+        Vector3Subtract(box->min, m),
+        Vector3Add(box->max, m)
+    };
+}
+
+static int allocate_node(r3d_bvh_t* bvh)
+{
+    if (bvh->freeList < 0) {
+        int newCapacity = 2 * bvh->capacity;
+        r3d_bvh_node_t* newNodes = RL_REALLOC(bvh->nodes, newCapacity * sizeof(*bvh->nodes));
+        if (newNodes == NULL) return -1;
+
+        for (int i = bvh->capacity; i < newCapacity; i++) {
+            newNodes[i].parent = (i + 1 < newCapacity) ? i + 1 : -1;
+            newNodes[i].height = -1;
+        }
+
+        bvh->freeList = bvh->capacity;
+        bvh->capacity = newCapacity;
+        bvh->nodes = newNodes;
+    }
+
+    int index = bvh->freeList;
+    r3d_bvh_node_t* node = &bvh->nodes[index];
+
+    bvh->freeList = node->parent;
+
+    node->parent = -1;
+    node->child[0] = -1;
+    node->child[1] = -1;
+    node->height = 0;
+    node->data = -1;
+
+    return index;
+}
+
+static void free_node(r3d_bvh_t* bvh, int index)
+{
+    bvh->nodes[index].parent = bvh->freeList;
+    bvh->nodes[index].height = -1;
+    bvh->freeList = index;
+}
+
+static void replace_child(r3d_bvh_t* bvh, int parent, int oldChild, int newChild)
+{
+    if (parent < 0) {
+        bvh->root = newChild;
+        return;
+    }
+
+    r3d_bvh_node_t* node = &bvh->nodes[parent];
+    node->child[node->child[0] == oldChild ? 0 : 1] = newChild;
+}
+
+/*
+ * Rotates the heavier grandchild of 'iA' above it if its children
+ * differ in height by more than one. Returns the new root of the subtree.
+ */
+static int balance(r3d_bvh_t* bvh, int iA)
+{
+    r3d_bvh_node_t* nodes = bvh->nodes;
+    r3d_bvh_node_t* A = &nodes[iA];
+
+    if (is_leaf(A) || A->height < 2) {
+        return iA;
+    }
+
+    int iB = A->child[0];
+    int iC = A->child[1];
+    r3d_bvh_node_t* B = &nodes[iB];
+    r3d_bvh_node_t* C = &nodes[iC];
+
+    int diff = C->height - B->height;
+    if (diff >= -1 && diff <= 1) {
+        return iA;
+    }
+
+    /* --- Select the side to raise, 'up' takes the place of A and A keeps 'other' --- */
+
+    int side = (diff > 1) ? 1 : 0;
+    int iUp = A->child[side];
+    r3d_bvh_node_t* up = &nodes[iUp];
+    r3d_bvh_node_t* other = &nodes[A->child[1 - side]];
+
+    int iF = up->child[0];
+    int iG = up->child[1];
+    if (nodes[iF].height < nodes[iG].height) {
+        int tmp = iF; iF = iG; iG = tmp;
+    }
+
+    /* --- Swap A and the raised node, the highest grandchild stays under it --- */
+
+    up->child[0] = iA;
+    up->child[1] = iF;
+    up->parent = A->parent;
+    A->parent = iUp;
+    replace_child(bvh, up->parent, iA, iUp);
+
+    A->child[side] = iG;
+    nodes[iG].parent = iA;
+
+    A->box = box_union(&other->box, &nodes[iG].box);
+    A->height = 1 + ((other->height > nodes[iG].height) ? other->height : nodes[iG].height);
+
+    up->box = box_union(&A->box, &nodes[iF].box);
+    up->height = 1 + ((A->height > nodes[iF].height) ? A->height : nodes[iF].height);
+
+    return iUp;
+}
+
+static void refit_ancestors(r3d_bvh_t* bvh, int index)
+{
+    while (index >= 0)
+    {
+        index = balance(bvh, index);
+
+        r3d_bvh_node_t* node = &bvh->nodes[index];
+        const r3d_bvh_node_t* c0 = &bvh->nodes[node->child[0]];
+        const r3d_bvh_node_t* c1 = &bvh->nodes[node->child[1]];
+
+        node->box = box_union(&c0->box, &c1->box);
+        node->height = 1 + ((c0->height > c1->height) ? c0->height : c1->height);
+
+        index = node->parent;
+    }
+}
+
+static bool insert_leaf(r3d_bvh_t* bvh, int leaf)
+{
+    if (bvh->root < 0) {
+        bvh->root = leaf;
+        bvh->nodes[leaf].parent = -1;
+        return true;
+    }
+
+    /* --- Descend towards the sibling with the smallest increase of perimeter --- */
+
+    BoundingBox leafBox = bvh->nodes[leaf].box;
+    int index = bvh->root;
+
+    while (!is_leaf(&bvh->nodes[index]))
+    {
+        const r3d_bvh_node_t* node = &bvh->nodes[index];
+
+        BoundingBox combined = box_union(&node->box, &leafBox);
+        float combinedPerimeter = box_perimeter(&combined);
+
+        // Cost of creating a new parent for this node and the leaf
+        float cost = 2.0f * combinedPerimeter;
+
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritance = 2.0f * (combinedPerimeter - box_perimeter(&node->box));
+
+        float childCost[2];
+        for (int i = 0; i < 2; i++) {
+            const r3d_bvh_node_t* child = &bvh->nodes[node->child[i]];
+            BoundingBox box = box_union(&child->box, &leafBox);
+            childCost[i] = box_perimeter(&box) + inheritance;
+            if (!is_leaf(child)) childCost[i] -= box_perimeter(&child->box);
+        }
+
+        if (cost < childCost[0] && cost < childCost[1]) {
+            break;
+        }
+
+        index = node->child[childCost[0] < childCost[1] ? 0 : 1];
+    }
+
+    /* --- Create a new parent for the sibling and the leaf --- */
+
+    int sibling = index;
+    int newParent = allocate_node(bvh);
+    if (newParent < 0) return false;
+
+    r3d_bvh_node_t* nodes = bvh->nodes;
+    int oldParent = nodes[sibling].parent;
+
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = box_union(&leafBox, &nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child[0] = sibling;
+    nodes[newParent].child[1] = leaf;
+
+    replace_child(bvh, oldParent, sibling, newParent);
+
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    refit_ancestors(bvh, newParent);
+
+    return true;
+}
+
+static void remove_leaf(r3d_bvh_t* bvh, int leaf)
+{
+    if (leaf == bvh->root) {
+        bvh->root = -1;
+        return;
+    }
+
+    r3d_bvh_node_t* nodes = bvh->nodes;
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child[nodes[parent].child[0] == leaf ? 1 : 0];
+
+    // The sibling takes the place of the parent, which is released
+    replace_child(bvh, grandParent, parent, sibling);
+    nodes[sibling].parent = grandParent;
+    free_node(bvh, parent);
+
+    refit_ancestors(bvh, grandParent);
+}
+
+/* === Public functions === */
+
+bool r3d_bvh_create(r3d_bvh_t* bvh, int capacity)
+{
+    if (capacity < 2) capacity = 2;
+
+    bvh->nodes = RL_MALLOC(capacity * sizeof(*bvh->nodes));
+    if (bvh->nodes == NULL) return false;
+
+    for (int i = 0; i < capacity; i++) {
+        bvh->nodes[i].parent = (i + 1 < capacity) ? i + 1 : -1;
+        bvh->nodes[i].height = -1;
+    }
+
+    bvh->capacity = capacity;
+    bvh->root = -1;
+    bvh->freeList = 0;
+    bvh->numLeaves = 0;
+
+    return true;
+}
+
+void r3d_bvh_destroy(r3d_bvh_t* bvh)
+{
+    RL_FREE(bvh->nodes);
+    bvh->nodes = NULL;
+    bvh->capacity = 0;
+    bvh->root = -1;
+    bvh->freeList = -1;
+    bvh->numLeaves = 0;
+}
+
+int r3d_bvh_insert(r3d_bvh_t* bvh, const BoundingBox* box, int32_t data)
+{
+    int leaf = allocate_node(bvh);
+    if (leaf < 0) return -1;
+
+    bvh->nodes[leaf].box = fatten_box(box);
+    bvh->nodes[leaf].data = data;
+
+    if (!insert_leaf(bvh, leaf)) {
+        free_node(bvh, leaf);
+        return -1;
+    }
+
+    bvh->numLeaves++;
+
+    return leaf;
+}
+
+void r3d_bvh_remove(r3d_bvh_t* bvh, int leaf)
+{
+    assert(leaf >= 0 && leaf < bvh->capacity && is_leaf(&bvh->nodes[leaf]));
+
+    remove_leaf(bvh, leaf);
+    free_node(bvh, leaf);
+
+    bvh->numLeaves--;
+}
+
+bool r3d_bvh_move(r3d_bvh_t* bvh, int leaf, const BoundingBox* box)
+{
+    assert(leaf >= 0 && leaf < bvh->capacity && is_leaf(&bvh->nodes[leaf]));
+
+    if (box_contains(&bvh->nodes[leaf].box, box)) {
+        return false;
+    }
+
+    remove_leaf(bvh, leaf);
+
+    bvh->nodes[leaf].box = fatten_box(box);
+
+    // Removing a leaf releases a node, so the reinsertion cannot fail
+    bool inserted = insert_leaf(bvh, leaf);
+    assert(inserted); (void)inserted;
+
+    return true;
+}
+
+void r3d_bvh_query_frustum(const r3d_bvh_t* bvh, const r3d_frustum_t* frustum, r3d_bvh_visit_fn visit, void* user)
+{
+    if (bvh->root < 0) return;
+
+    // Each entry keeps the planes its parent was not fully inside of
+    struct { int node; uint32_t planes; } stack[R3D_BVH_STACK_SIZE];
+    int count = 0;
+
+    stack[count].node = bvh->root;
+    stack[count].planes = frustum ? (1u << R3D_PLANE_COUNT) - 1 : 0;
+    count++;
+
+    while (count > 0)
+    {
+        count--;
+        int index = stack[count].node;
+        uint32_t planes = stack[count].planes;
+
+        const r3d_bvh_node_t* node = &bvh->nodes[index];
+
+        if (planes != 0)
+        {
+            Vector3 center = Vector3Scale(Vector3Add(node->box.min, node->box.max), 0.5f);
+            Vector3 extent = Vector3Scale(Vector3Subtract(node->box.max, node->box.min), 0.5f);
+
+            bool outside = false;
+            for (int i = 0; i < R3D_PLANE_COUNT; i++)
+            {
+                if ((planes & (1u << i)) == 0) continue;
+
+                const Vector4* plane = &frustum->planes[i];
+                float distance = plane->x * center.x + plane->y * center.y + plane->z * center.z + plane->w;
+                float radius = fabsf(plane->x) * extent.x + fabsf(plane->y) * extent.y + fabsf(plane->z) * extent.z;
+
+                if (distance + radius < 0.0f) { outside = true; break; }
+                if (distance - radius >= 0.0f) planes &= ~(1u << i);
+            }
+
+            if (outside) continue;
+        }
+
+        if (is_leaf(node)) {
+            visit(node->data, user);
+            continue;
+        }
+
+        assert(count + 2 <= R3D_BVH_STACK_SIZE);
+
+        stack[count].node = node->child[0];
+        stack[count].planes = planes;
+        count++;
+
+        stack[count].node = node->child[1];
+        stack[count].planes = planes;
+        count++;
+    }
+}
+
+void r3d_bvh_query_box(const r3d_bvh_t* bvh, const BoundingBox* box, r3d_bvh_visit_fn visit, void* user)
+{
+    if (bvh->root < 0) return;
+
+    int stack[R3D_BVH_STACK_SIZE];
+    int count = 0;
+
+    stack[count++] = bvh->root;
+
+    while (count > 0)
+    {
+        const r3d_bvh_node_t* node = &bvh->nodes[stack[--count]];
+
+        if (!box_overlaps(&node->box, box)) {
+            continue;
+        }
+
+        if (is_leaf(node)) {
+            visit(node->data, user);
+            continue;
+        }
+
+        assert(count + 2 <= R3D_BVH_STACK_SIZE);
+
+        stack[count++] = node->child[0];
+        stack[count++] = node->child[1];
+    }
+}
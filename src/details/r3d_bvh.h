@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef R3D_DETAILS_BVH_H
+#define R3D_DETAILS_BVH_H
+
+#include "./r3d_frustum.h"
+#include <raylib.h>
+#include <stdint.h>
+
+/* === Constants === */
+
+/* Fraction of the largest half extent added around leaf boxes, small moves stay inside */
+#define R3D_BVH_FAT_RATIO 0.1f
+
+/* Maximum depth of the traversal stack, the tree is kept balanced far below this */
+#define R3D_BVH_STACK_SIZE 256
+
+/* === Types === */
+
+/*
+ * Node of the tree, leaves hold a user value and an enlarged box.
+ * Free nodes are chained through their parent index.
+ */
+typedef struct {
+    BoundingBox box;
+    int parent;
+    int child[2];       //< Both -1 for leaves
+    int height;         //< Zero for leaves, -1 for free nodes
+    int32_t data;
+} r3d_bvh_node_t;
+
+/*
+ * Dynamic bounding volume hierarchy, balanced with tree rotations on insertion.
+ * Leaves keep their index for their whole lifetime, even when moved.
+ */
+typedef struct {
+    r3d_bvh_node_t* nodes;
+    int capacity;
+    int root;
+    int freeList;
+    int numLeaves;
+} r3d_bvh_t;
+
+/* Called for each leaf found by a query */
+typedef void (*r3d_bvh_visit_fn)(int32_t data, void* user);
+
+/* === Functions === */
+
+bool r3d_bvh_create(r3d_bvh_t* bvh, int capacity);
+void r3d_bvh_destroy(r3d_bvh_t* bvh);
+
+/*
+ * Inserts a leaf and returns its index, or -1 on allocation failure.
+ */
+int r3d_bvh_insert(r3d_bvh_t* bvh, const BoundingBox* box, int32_t data);
+
+/*
+ * Removes a leaf, its index may be returned again by a later insertion.
+ */
+void r3d_bvh_remove(r3d_bvh_t* bvh, int leaf);
+
+/*
+ * Updates the box of a leaf. The tree is only modified if the box leaves the
+ * enlarged box of the leaf, in which case the leaf is reinserted.
+ * Returns true if the leaf has been reinserted.
+ */
+bool r3d_bvh_move(r3d_bvh_t* bvh, int leaf, const BoundingBox* box);
+
+/*
+ * Visits the leaves whose box is at least partially inside the frustum.
+ * Subtrees fully inside are visited without further tests.
+ * A NULL frustum visits every leaf.
+ */
+void r3d_bvh_query_frustum(const r3d_bvh_t* bvh, const r3d_frustum_t* frustum, r3d_bvh_visit_fn visit, void* user);
+
+/*
+ * Visits the leaves whose box overlaps the given box.
+ */
+void r3d_bvh_query_box(const r3d_bvh_t* bvh, const BoundingBox* box, r3d_bvh_visit_fn visit, void* user);
+
+#endif // R3D_DETAILS_BVH_H
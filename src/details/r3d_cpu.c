@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "./r3d_cpu.h"
+
+#include <raylib.h>
+#include <tinycthread.h>
+
+#ifdef _WIN32
+#   define NOGDI
+#   define NOUSER
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#   undef near
+#   undef far
+#elif defined(__linux__) || defined(__APPLE__)
+#   include <unistd.h>
+#else
+#   error "Oops, platform not supported by R3D"
+#endif
+
+/* === Internal state === */
+
+static int g_numCPUs = 0;
+static _Thread_local bool g_isWorker = false;
+
+/* === Public functions === */
+
+int r3d_cpu_count(void)
+{
+    if (g_numCPUs > 0) return g_numCPUs;
+
+    #ifdef _WIN32
+        SYSTEM_INFO sysinfo;
+        GetSystemInfo(&sysinfo);
+        g_numCPUs = sysinfo.dwNumberOfProcessors;
+    #elif defined(__linux__) || defined(__APPLE__)
+        g_numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+    #endif
+
+    if (g_numCPUs < 1) {
+        TraceLog(LOG_WARNING, "R3D: Failed to detect CPU count, defaulting to 1 thread");
+        g_numCPUs = 1;
+    }
+
+    return g_numCPUs;
+}
+
+void r3d_cpu_set_worker(bool worker)
+{
+    g_isWorker = worker;
+}
+
+bool r3d_cpu_is_worker(void)
+{
+    return g_isWorker;
+}
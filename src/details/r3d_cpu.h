@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef R3D_DETAILS_CPU_H
+#define R3D_DETAILS_CPU_H
+
+#include <stdbool.h>
+
+/* === Functions === */
+
+/*
+ * Number of logical processors, detected once. Never less than one.
+ */
+int r3d_cpu_count(void);
+
+/*
+ * Marks the calling thread as one of the threads of a parallel job.
+ * The functions that spread their own work over threads stay serial on such a thread,
+ * so that nested pools never oversubscribe the processors.
+ */
+void r3d_cpu_set_worker(bool worker);
+
+/*
+ * Returns true if the calling thread has been marked with 'r3d_cpu_set_worker()'.
+ */
+bool r3d_cpu_is_worker(void);
+
+#endif // R3D_DETAILS_CPU_H
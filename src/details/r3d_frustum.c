@@ -21,8 +21,11 @@
 #include "raylib.h"
 
 #include <raymath.h>
+#include <string.h>
 #include <float.h>
 
+#include "./r3d_simd.h"
+
 /* === Internal functions === */
 
 static inline Vector4 r3d_frustum_normalize_plane(Vector4 plane)
@@ -44,6 +47,34 @@ static inline float r3d_frustum_distance_to_plane(const Vector4* plane, const Ve
     return plane->x * position->x + plane->y * position->y + plane->z * position->z + plane->w;
 }
 
+static void r3d_frustum_get_corners(Matrix matViewProjection, Vector3* corners)
+{
+    Matrix matInv = MatrixInvert(matViewProjection);
+
+    for (int i = 0; i < 8; i++) {
+        Vector4 p = { (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f };
+
+        float x = p.x * matInv.m0 + p.y * matInv.m4 + p.z * matInv.m8 + p.w * matInv.m12;
+        float y = p.x * matInv.m1 + p.y * matInv.m5 + p.z * matInv.m9 + p.w * matInv.m13;
+        float z = p.x * matInv.m2 + p.y * matInv.m6 + p.z * matInv.m10 + p.w * matInv.m14;
+        float w = p.x * matInv.m3 + p.y * matInv.m7 + p.z * matInv.m11 + p.w * matInv.m15;
+
+        corners[i] = (fabsf(w) > 1e-6f) ? (Vector3) { x / w, y / w, z / w } : (Vector3) { x, y, z };
+    }
+}
+
+static bool r3d_frustum_plane_contains(const Vector4* plane, const Vector3* corners)
+{
+    for (int i = 0; i < 8; i++) {
+        // The far corners are reconstructed with an error growing with their distance
+        float tolerance = 1e-4f * (1.0f + Vector3Length(corners[i]));
+        if (r3d_frustum_distance_to_plane(plane, &corners[i]) < -tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* === Public functions === */
 
 r3d_frustum_t r3d_frustum_create(Matrix matrixViewProjection)
@@ -95,6 +126,47 @@ r3d_frustum_t r3d_frustum_create(Matrix matrixViewProjection)
     return frustum;
 }
 
+r3d_frustum_t r3d_frustum_create_box(const BoundingBox* box)
+{
+    r3d_frustum_t frustum = { 0 };
+
+    frustum.planes[R3D_PLANE_RIGHT]  = (Vector4) {-1.0f,  0.0f,  0.0f, +box->max.x};
+    frustum.planes[R3D_PLANE_LEFT]   = (Vector4) {+1.0f,  0.0f,  0.0f, -box->min.x};
+    frustum.planes[R3D_PLANE_TOP]    = (Vector4) { 0.0f, -1.0f,  0.0f, +box->max.y};
+    frustum.planes[R3D_PLANE_BOTTOM] = (Vector4) { 0.0f, +1.0f,  0.0f, -box->min.y};
+    frustum.planes[R3D_PLANE_BACK]   = (Vector4) { 0.0f,  0.0f, -1.0f, +box->max.z};
+    frustum.planes[R3D_PLANE_FRONT]  = (Vector4) { 0.0f,  0.0f, +1.0f, -box->min.z};
+
+    return frustum;
+}
+
+r3d_frustum_t r3d_frustum_create_union(Matrix matViewProjectionA, Matrix matViewProjectionB)
+{
+    r3d_frustum_t a = r3d_frustum_create(matViewProjectionA);
+    r3d_frustum_t b = r3d_frustum_create(matViewProjectionB);
+
+    Vector3 cornersA[8], cornersB[8];
+    r3d_frustum_get_corners(matViewProjectionA, cornersA);
+    r3d_frustum_get_corners(matViewProjectionB, cornersB);
+
+    r3d_frustum_t frustum = { 0 };
+
+    for (int i = 0; i < R3D_PLANE_COUNT; i++) {
+        if (r3d_frustum_plane_contains(&a.planes[i], cornersB)) {
+            frustum.planes[i] = a.planes[i];
+        }
+        else if (r3d_frustum_plane_contains(&b.planes[i], cornersA)) {
+            frustum.planes[i] = b.planes[i];
+        }
+        else {
+            // Neither plane bounds both frustums, this side is left open
+            frustum.planes[i] = (Vector4) { 0.0f, 0.0f, 0.0f, 1.0f };
+        }
+    }
+
+    return frustum;
+}
+
 BoundingBox r3d_frustum_get_bounding_box(Matrix matViewProjection)
 {
     Matrix matInv = MatrixInvert(matViewProjection);
@@ -232,3 +304,196 @@ bool r3d_frustum_is_obb_in(const r3d_frustum_t* frustum, const BoundingBox* aabb
     // OBB is at least partially inside all planes
     return true;
 }
+
+void r3d_frustum_get_world_box(const BoundingBox* aabb, const Matrix* transform, Vector3* center, Vector3* extent)
+{
+    if (memcmp(aabb, &(BoundingBox){0}, sizeof(BoundingBox)) == 0) {
+        *center = (Vector3) {0};
+        *extent = (Vector3) {
+            R3D_FRUSTUM_INFINITE_EXTENT,
+            R3D_FRUSTUM_INFINITE_EXTENT,
+            R3D_FRUSTUM_INFINITE_EXTENT
+        };
+        return;
+    }
+
+    float xCenter = (aabb->min.x + aabb->max.x) * 0.5f;
+    float yCenter = (aabb->min.y + aabb->max.y) * 0.5f;
+    float zCenter = (aabb->min.z + aabb->max.z) * 0.5f;
+    float xExtent = (aabb->max.x - aabb->min.x) * 0.5f;
+    float yExtent = (aabb->max.y - aabb->min.y) * 0.5f;
+    float zExtent = (aabb->max.z - aabb->min.z) * 0.5f;
+
+    const Matrix* m = transform;
+
+    // The world box of a transformed box encloses it with the absolute basis
+    center->x = m->m0 * xCenter + m->m4 * yCenter + m->m8 * zCenter + m->m12;
+    center->y = m->m1 * xCenter + m->m5 * yCenter + m->m9 * zCenter + m->m13;
+    center->z = m->m2 * xCenter + m->m6 * yCenter + m->m10 * zCenter + m->m14;
+
+    extent->x = fabsf(m->m0) * xExtent + fabsf(m->m4) * yExtent + fabsf(m->m8) * zExtent;
+    extent->y = fabsf(m->m1) * xExtent + fabsf(m->m5) * yExtent + fabsf(m->m9) * zExtent;
+    extent->z = fabsf(m->m2) * xExtent + fabsf(m->m6) * yExtent + fabsf(m->m10) * zExtent;
+}
+
+void r3d_frustum_cull_boxes(const r3d_frustum_t* frustum, const r3d_frustum_boxes_t* boxes, int count, uint32_t* visibility)
+{
+    memset(visibility, 0, ((count + 31) / 32) * sizeof(uint32_t));
+
+    const float* cx = boxes->centerX;
+    const float* cy = boxes->centerY;
+    const float* cz = boxes->centerZ;
+    const float* ex = boxes->extentX;
+    const float* ey = boxes->extentY;
+    const float* ez = boxes->extentZ;
+
+    int i = 0;
+
+    /*
+     * For each plane, a box is outside if the distance of its center plus its extents
+     * projected on the absolute normal is negative. Batches always start on a multiple
+     * of their width, so each mask lands inside a single word of the bitset.
+     */
+
+#if defined(R3D_HAS_AVX)
+
+    const __m256 minDistance = _mm256_set1_ps(-EPSILON);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vcx = _mm256_loadu_ps(&cx[i]), vex = _mm256_loadu_ps(&ex[i]);
+        __m256 vcy = _mm256_loadu_ps(&cy[i]), vey = _mm256_loadu_ps(&ey[i]);
+        __m256 vcz = _mm256_loadu_ps(&cz[i]), vez = _mm256_loadu_ps(&ez[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+
+        for (int p = 0; p < R3D_PLANE_COUNT; p++)
+        {
+            const Vector4* plane = &frustum->planes[p];
+
+            __m256 nx = _mm256_set1_ps(plane->x);
+            __m256 ny = _mm256_set1_ps(plane->y);
+            __m256 nz = _mm256_set1_ps(plane->z);
+
+        #if defined(R3D_HAS_FMA_AVX)
+            __m256 d = _mm256_fmadd_ps(nx, vcx, _mm256_set1_ps(plane->w));
+            d = _mm256_fmadd_ps(ny, vcy, d);
+            d = _mm256_fmadd_ps(nz, vcz, d);
+            d = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, nx), vex, d);
+            d = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, ny), vey, d);
+            d = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, nz), vez, d);
+        #else
+            __m256 d = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(nx, vcx), _mm256_mul_ps(ny, vcy)),
+                _mm256_add_ps(_mm256_mul_ps(nz, vcz), _mm256_set1_ps(plane->w))
+            );
+            d = _mm256_add_ps(d, _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), vex), _mm256_mul_ps(_mm256_andnot_ps(signMask, ny), vey)),
+                _mm256_mul_ps(_mm256_andnot_ps(signMask, nz), vez)
+            ));
+        #endif
+
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, minDistance, _CMP_LT_OQ));
+        }
+
+        uint32_t mask = ~(uint32_t)_mm256_movemask_ps(outside) & 0xFF;
+        visibility[i >> 5] |= mask << (i & 31);
+    }
+
+#elif defined(R3D_HAS_SSE)
+
+    const __m128 minDistance = _mm_set1_ps(-EPSILON);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vcx = _mm_loadu_ps(&cx[i]), vex = _mm_loadu_ps(&ex[i]);
+        __m128 vcy = _mm_loadu_ps(&cy[i]), vey = _mm_loadu_ps(&ey[i]);
+        __m128 vcz = _mm_loadu_ps(&cz[i]), vez = _mm_loadu_ps(&ez[i]);
+
+        __m128 outside = _mm_setzero_ps();
+
+        for (int p = 0; p < R3D_PLANE_COUNT; p++)
+        {
+            const Vector4* plane = &frustum->planes[p];
+
+            __m128 nx = _mm_set1_ps(plane->x);
+            __m128 ny = _mm_set1_ps(plane->y);
+            __m128 nz = _mm_set1_ps(plane->z);
+
+            __m128 d = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, vcx), _mm_mul_ps(ny, vcy)),
+                _mm_add_ps(_mm_mul_ps(nz, vcz), _mm_set1_ps(plane->w))
+            );
+            d = _mm_add_ps(d, _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, nx), vex), _mm_mul_ps(_mm_andnot_ps(signMask, ny), vey)),
+                _mm_mul_ps(_mm_andnot_ps(signMask, nz), vez)
+            ));
+
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, minDistance));
+        }
+
+        uint32_t mask = ~(uint32_t)_mm_movemask_ps(outside) & 0xF;
+        visibility[i >> 5] |= mask << (i & 31);
+    }
+
+#elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+
+    const float32x4_t minDistance = vdupq_n_f32(-EPSILON);
+    const uint32x4_t laneBits = { 1, 2, 4, 8 };
+
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t vcx = vld1q_f32(&cx[i]), vex = vld1q_f32(&ex[i]);
+        float32x4_t vcy = vld1q_f32(&cy[i]), vey = vld1q_f32(&ey[i]);
+        float32x4_t vcz = vld1q_f32(&cz[i]), vez = vld1q_f32(&ez[i]);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+
+        for (int p = 0; p < R3D_PLANE_COUNT; p++)
+        {
+            const Vector4* plane = &frustum->planes[p];
+
+            float32x4_t d = vdupq_n_f32(plane->w);
+            d = vmlaq_n_f32(d, vcx, plane->x);
+            d = vmlaq_n_f32(d, vcy, plane->y);
+            d = vmlaq_n_f32(d, vcz, plane->z);
+            d = vmlaq_n_f32(d, vex, fabsf(plane->x));
+            d = vmlaq_n_f32(d, vey, fabsf(plane->y));
+            d = vmlaq_n_f32(d, vez, fabsf(plane->z));
+
+            outside = vorrq_u32(outside, vcltq_f32(d, minDistance));
+        }
+
+        uint32x4_t bits = vandq_u32(vmvnq_u32(outside), laneBits);
+        uint32x2_t sum = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+        uint32_t mask = vget_lane_u32(vpadd_u32(sum, sum), 0);
+
+        visibility[i >> 5] |= mask << (i & 31);
+    }
+
+#endif
+
+    /* --- Remaining boxes, or all of them without SIMD --- */
+
+    for (; i < count; i++)
+    {
+        bool inside = true;
+
+        for (int p = 0; p < R3D_PLANE_COUNT && inside; p++)
+        {
+            const Vector4* plane = &frustum->planes[p];
+
+            float distance =
+                plane->x * cx[i] + plane->y * cy[i] + plane->z * cz[i] + plane->w +
+                fabsf(plane->x) * ex[i] + fabsf(plane->y) * ey[i] + fabsf(plane->z) * ez[i];
+
+            inside = !(distance < -EPSILON);
+        }
+
+        if (inside) {
+            visibility[i >> 5] |= 1u << (i & 31);
+        }
+    }
+}
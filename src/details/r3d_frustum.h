@@ -21,6 +21,7 @@
 #define R3D_DETAILS_FRUSTUM_H
 
 #include <raylib.h>
+#include <stdint.h>
 
 /* === Types ===  */
 
@@ -38,9 +39,38 @@ typedef struct {
     Vector4 planes[R3D_PLANE_COUNT];
 } r3d_frustum_t;
 
+/*
+ * World-space boxes stored as structure of arrays, for batched tests.
+ * Each box is described by its center and half extents along the world axes.
+ */
+typedef struct {
+    float* centerX;
+    float* centerY;
+    float* centerZ;
+    float* extentX;
+    float* extentY;
+    float* extentZ;
+} r3d_frustum_boxes_t;
+
+/* Half extent given to boxes that must never be culled */
+#define R3D_FRUSTUM_INFINITE_EXTENT 1e30f
+
 /* === Functions === */
 
 r3d_frustum_t r3d_frustum_create(Matrix matrixViewProjection);
+
+/*
+ * Creates a frustum whose planes are the faces of a world-space box.
+ */
+r3d_frustum_t r3d_frustum_create_box(const BoundingBox* box);
+
+/*
+ * Creates a frustum enclosing two frustums, such as the eyes of a stereo view.
+ * Each plane is taken from the frustum whose plane also bounds the other one,
+ * a side bounded by neither is left open. The result may enclose more than the union.
+ */
+r3d_frustum_t r3d_frustum_create_union(Matrix matViewProjectionA, Matrix matViewProjectionB);
+
 BoundingBox r3d_frustum_get_bounding_box(Matrix matViewProjection);
 bool r3d_frustum_is_point_in(const r3d_frustum_t* frustum, const Vector3* position);
 bool r3d_frustum_is_points_in(const r3d_frustum_t* frustum, const Vector3* positions, int count);
@@ -48,4 +78,17 @@ bool r3d_frustum_is_sphere_in(const r3d_frustum_t* frustum, const Vector3* posit
 bool r3d_frustum_is_aabb_in(const r3d_frustum_t* frustum, const BoundingBox* aabb);
 bool r3d_frustum_is_obb_in(const r3d_frustum_t* frustum, const BoundingBox* aabb, const Matrix* transform);
 
+/*
+ * Computes the world-space box enclosing a transformed AABB, as a center and half extents.
+ * A zero AABB is considered unbounded and gets `R3D_FRUSTUM_INFINITE_EXTENT` extents.
+ */
+void r3d_frustum_get_world_box(const BoundingBox* aabb, const Matrix* transform, Vector3* center, Vector3* extent);
+
+/*
+ * Tests 'count' boxes against the frustum, several boxes at once when SIMD is available.
+ * Writes one bit per box in 'visibility', set when the box is at least partially inside.
+ * The bitset must hold at least (count + 31) / 32 words, its content is overwritten.
+ */
+void r3d_frustum_cull_boxes(const r3d_frustum_t* frustum, const r3d_frustum_boxes_t* boxes, int count, uint32_t* visibility);
+
 #endif // R3D_DETAILS_FRUSTUM_H
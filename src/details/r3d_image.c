@@ -3,6 +3,11 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <tinycthread.h>
+#include <string.h>
+#include <math.h>
+
+#include "./r3d_simd.h"
 
 Image r3d_compose_images_rgb(const Image* sources[3], Color defaultColor)
 {
@@ -118,3 +123,384 @@ Image r3d_compose_images_rgb(const Image* sources[3], Color defaultColor)
 
     return image;
 }
+
+/* === Block compression === */
+
+static uint16_t pack_565(const int color[3])
+{
+    int r = (color[0] * 31 + 127) / 255;
+    int g = (color[1] * 63 + 127) / 255;
+    int b = (color[2] * 31 + 127) / 255;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t value, int color[3])
+{
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+static void write_le(uint8_t* dst, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        dst[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static void encode_color_block(uint8_t* dst, const uint8_t block[64])
+{
+    int lo[3] = { 255, 255, 255 };
+    int hi[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) {
+            int v = block[4 * i + c];
+            lo[c] = (v < lo[c]) ? v : lo[c];
+            hi[c] = (v > hi[c]) ? v : hi[c];
+        }
+    }
+
+    // Insetting the box reduces the error of the pixels between the extremities
+    for (int c = 0; c < 3; c++) {
+        int inset = (hi[c] - lo[c]) >> 4;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    uint16_t c0 = pack_565(hi);
+    uint16_t c1 = pack_565(lo);
+
+    // The four colors mode requires c0 > c1
+    if (c0 < c1) {
+        uint16_t tmp = c0; c0 = c1; c1 = tmp;
+    }
+
+    int palette[4][3];
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    uint32_t indices = 0;
+
+    if (c0 != c1) {
+        for (int i = 0; i < 16; i++) {
+            int best = 0, bestError = INT32_MAX;
+            for (int j = 0; j < 4; j++) {
+                int dr = block[4 * i + 0] - palette[j][0];
+                int dg = block[4 * i + 1] - palette[j][1];
+                int db = block[4 * i + 2] - palette[j][2];
+                int error = dr * dr + dg * dg + db * db;
+                if (error < bestError) {
+                    bestError = error;
+                    best = j;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+        }
+    }
+
+    write_le(dst + 0, c0, 2);
+    write_le(dst + 2, c1, 2);
+    write_le(dst + 4, indices, 4);
+}
+
+static void encode_alpha_block(uint8_t* dst, const uint8_t block[64])
+{
+    int lo = 255, hi = 0;
+
+    for (int i = 0; i < 16; i++) {
+        int v = block[4 * i + 3];
+        lo = (v < lo) ? v : lo;
+        hi = (v > hi) ? v : hi;
+    }
+
+    // a0 > a1 selects the eight values mode, equal values give a constant block
+    int palette[8] = { hi, lo };
+    for (int j = 2; j < 8; j++) {
+        palette[j] = ((8 - j) * hi + (j - 1) * lo) / 7;
+    }
+
+    uint64_t indices = 0;
+
+    if (hi != lo) {
+        for (int i = 0; i < 16; i++) {
+            int v = block[4 * i + 3];
+            int best = 0, bestError = INT32_MAX;
+            for (int j = 0; j < 8; j++) {
+                int error = abs(v - palette[j]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = j;
+                }
+            }
+            indices |= (uint64_t)best << (3 * i);
+        }
+    }
+
+    dst[0] = (uint8_t)hi;
+    dst[1] = (uint8_t)lo;
+    write_le(dst + 2, indices, 6);
+}
+
+static uint8_t* encode_level(uint8_t* dst, const uint8_t* pixels, int w, int h, bool alpha)
+{
+    uint8_t block[64];
+
+    for (int by = 0; by < h; by += 4) {
+        for (int bx = 0; bx < w; bx += 4) {
+            for (int y = 0; y < 4; y++) {
+                const uint8_t* row = pixels + 4 * ((by + y) * w + bx);
+                for (int i = 0; i < 16; i++) {
+                    block[16 * y + i] = row[i];
+                }
+            }
+            if (alpha) {
+                encode_alpha_block(dst, block);
+                dst += 8;
+            }
+            encode_color_block(dst, block);
+            dst += 8;
+        }
+    }
+
+    return dst;
+}
+
+/* === Downsampling === */
+
+static float g_srgbToLinear[256];
+static uint8_t g_linearToSrgb[4096];
+static once_flag g_srgbTablesOnce = ONCE_FLAG_INIT;
+
+static void init_srgb_tables(void)
+{
+    for (int i = 0; i < 256; i++) {
+        float c = i / 255.0f;
+        g_srgbToLinear[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    for (int i = 0; i < 4096; i++) {
+        float l = i / 4095.0f;
+        float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+        g_linearToSrgb[i] = (uint8_t)(c * 255.0f + 0.5f);
+    }
+}
+
+static void downsample_linear_rgba(uint8_t* dst, const uint8_t* src, int w, int h)
+{
+    int dw = w / 2, dh = h / 2;
+
+    for (int y = 0; y < dh; y++) {
+        const uint8_t* r0 = src + 4 * (2 * y) * w;
+        const uint8_t* r1 = r0 + 4 * w;
+        uint8_t* out = dst + 4 * y * dw;
+        int x = 0;
+
+#if defined(R3D_HAS_SSE2)
+        // Two destination pixels per iteration, from four pixels of both source rows
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bias = _mm_set1_epi16(2);
+        for (; x + 2 <= dw; x += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(r0 + 8 * x));
+            __m128i b = _mm_loadu_si128((const __m128i*)(r1 + 8 * x));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), bias), 2);
+            _mm_storel_epi64((__m128i*)(out + 4 * x), _mm_packus_epi16(sum, zero));
+        }
+#endif
+
+        for (; x < dw; x++) {
+            const uint8_t* p0 = r0 + 8 * x;
+            const uint8_t* p1 = r1 + 8 * x;
+            for (int c = 0; c < 4; c++) {
+                out[4 * x + c] = (uint8_t)((p0[c] + p0[c + 4] + p1[c] + p1[c + 4] + 2) >> 2);
+            }
+        }
+    }
+}
+
+static void downsample(uint8_t* dst, const uint8_t* src, int w, int h, int channels, bool srgb)
+{
+    // Even RGBA levels take the fast path, the others clamp their odd edges
+    if (channels == 4 && !srgb && w % 2 == 0 && h % 2 == 0) {
+        downsample_linear_rgba(dst, src, w, h);
+        return;
+    }
+
+    int dw = (w > 1) ? w / 2 : 1;
+    int dh = (h > 1) ? h / 2 : 1;
+
+    // Alpha is never gamma encoded
+    int colorChannels = (channels >= 3) ? 3 : 1;
+
+    for (int y = 0; y < dh; y++) {
+        int y0 = (2 * y < h) ? 2 * y : h - 1;
+        int y1 = (2 * y + 1 < h) ? 2 * y + 1 : h - 1;
+        for (int x = 0; x < dw; x++) {
+            int x0 = (2 * x < w) ? 2 * x : w - 1;
+            int x1 = (2 * x + 1 < w) ? 2 * x + 1 : w - 1;
+            const uint8_t* p[4] = {
+                src + channels * (y0 * w + x0), src + channels * (y0 * w + x1),
+                src + channels * (y1 * w + x0), src + channels * (y1 * w + x1)
+            };
+            uint8_t* out = dst + channels * (y * dw + x);
+            for (int c = 0; c < channels; c++) {
+                if (srgb && c < colorChannels) {
+                    float l = g_srgbToLinear[p[0][c]] + g_srgbToLinear[p[1][c]]
+                            + g_srgbToLinear[p[2][c]] + g_srgbToLinear[p[3][c]];
+                    out[c] = g_linearToSrgb[(int)(l * (4095.0f / 4.0f) + 0.5f)];
+                }
+                else {
+                    out[c] = (uint8_t)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) >> 2);
+                }
+            }
+        }
+    }
+}
+
+Image r3d_image_gen_mipmaps(const Image* image, bool srgb)
+{
+    Image result = { 0 };
+
+    int channels = 0;
+    switch (image->format) {
+    case PIXELFORMAT_UNCOMPRESSED_GRAYSCALE: channels = 1; break;
+    case PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA: channels = 2; break;
+    case PIXELFORMAT_UNCOMPRESSED_R8G8B8: channels = 3; break;
+    case PIXELFORMAT_UNCOMPRESSED_R8G8B8A8: channels = 4; break;
+    default: return result;
+    }
+
+    if (image->data == NULL || image->width <= 0 || image->height <= 0) {
+        return result;
+    }
+
+    // Full chain down to 1x1, laid out one level after the other like raylib does
+    int levels = 1;
+    size_t size = (size_t)image->width * image->height * channels;
+    for (int w = image->width, h = image->height; w > 1 || h > 1; levels++) {
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+        size += (size_t)w * h * channels;
+    }
+
+    uint8_t* pixels = RL_MALLOC(size);
+    if (pixels == NULL) {
+        return result;
+    }
+
+    if (srgb) {
+        call_once(&g_srgbTablesOnce, init_srgb_tables);
+    }
+
+    // Only the first level of the source is used, its mipmaps would not be filtered the same way
+    memcpy(pixels, image->data, (size_t)image->width * image->height * channels);
+
+    uint8_t* src = pixels;
+    int w = image->width, h = image->height;
+    for (int level = 1; level < levels; level++) {
+        uint8_t* dst = src + (size_t)w * h * channels;
+        downsample(dst, src, w, h, channels, srgb);
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+        src = dst;
+    }
+
+    result.data = pixels;
+    result.width = image->width;
+    result.height = image->height;
+    result.mipmaps = levels;
+    result.format = image->format;
+
+    return result;
+}
+
+Image r3d_image_compress(const Image* image, r3d_image_codec_e codec, bool mipmaps)
+{
+    Image result = { 0 };
+
+    if (image->data == NULL || image->format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        return result;
+    }
+
+    if (image->width <= 0 || image->height <= 0 || image->width % 4 != 0 || image->height % 4 != 0) {
+        return result;
+    }
+
+    Image rgba = ImageFromImage(*image, (Rectangle) { 0, 0, (float)image->width, (float)image->height });
+    ImageFormat(&rgba, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (rgba.data == NULL || rgba.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+        UnloadImage(rgba);
+        return result;
+    }
+
+    uint8_t* pixels = rgba.data;
+    int pixelCount = rgba.width * rgba.height;
+
+    if (codec == R3D_IMAGE_CODEC_DXT5) {
+        bool opaque = true;
+        for (int i = 0; opaque && i < pixelCount; i++) {
+            opaque = (pixels[4 * i + 3] == 255);
+        }
+        if (opaque) codec = R3D_IMAGE_CODEC_DXT1;
+    }
+    else if (codec == R3D_IMAGE_CODEC_DXT5_NORMAL) {
+        // Red and blue are cleared so that the color endpoints only spend their precision on green
+        for (int i = 0; i < pixelCount; i++) {
+            pixels[4 * i + 3] = pixels[4 * i + 0];
+            pixels[4 * i + 0] = 0;
+            pixels[4 * i + 2] = 0;
+        }
+    }
+
+    bool alpha = (codec != R3D_IMAGE_CODEC_DXT1);
+    int blockSize = alpha ? 16 : 8;
+
+    // Levels remain multiples of 4, the sizes computed by raylib then match whole blocks
+    int levels = 1;
+    size_t size = (rgba.width / 4) * (rgba.height / 4) * blockSize;
+    if (mipmaps) {
+        for (int w = rgba.width, h = rgba.height; w % 8 == 0 && h % 8 == 0; levels++) {
+            w /= 2, h /= 2;
+            size += (w / 4) * (h / 4) * blockSize;
+        }
+    }
+
+    uint8_t* blocks = RL_MALLOC(size);
+    if (blocks == NULL) {
+        UnloadImage(rgba);
+        return result;
+    }
+
+    uint8_t* dst = blocks;
+    int w = rgba.width, h = rgba.height;
+
+    for (int level = 0; level < levels; level++) {
+        if (level > 0) {
+            // NOTE: Done in place, every destination pixel comes after its sources are read
+            downsample(pixels, pixels, w, h, 4, false);
+            w /= 2, h /= 2;
+        }
+        dst = encode_level(dst, pixels, w, h, alpha);
+    }
+
+    UnloadImage(rgba);
+
+    result.data = blocks;
+    result.width = image->width;
+    result.height = image->height;
+    result.mipmaps = levels;
+    result.format = alpha ? PIXELFORMAT_COMPRESSED_DXT5_RGBA : PIXELFORMAT_COMPRESSED_DXT1_RGB;
+
+    return result;
+}
@@ -3,6 +3,15 @@
 
 #include <raylib.h>
 
+/**
+ * @brief Block compression codecs supported by `r3d_image_compress()`.
+ */
+typedef enum {
+    R3D_IMAGE_CODEC_DXT1,           //< Opaque colors, 4 bits per pixel
+    R3D_IMAGE_CODEC_DXT5,           //< Colors with alpha, 8 bits per pixel, opaque images fall back to DXT1
+    R3D_IMAGE_CODEC_DXT5_NORMAL     //< Normal map with X in alpha and Y in green, 8 bits per pixel
+} r3d_image_codec_e;
+
 /**
  * @brief Composes an RGB image by mapping each source image to its corresponding color channel.
  * 
@@ -30,4 +39,36 @@
  */
 Image r3d_compose_images_rgb(const Image* sources[3], Color defaultColor);
 
+/**
+ * @brief Generates the full mipmap chain of an 8 bits per channel image.
+ *
+ * Each level is box filtered from the previous one, the odd edges are clamped.
+ * With 'srgb', the color channels are averaged in linear space, alpha always is.
+ * The source image is left untouched, only its first level is used.
+ *
+ * @param image Source image, grayscale, gray alpha, RGB or RGBA with 8 bits per channel.
+ * @param srgb True if the color channels are sRGB encoded.
+ *
+ * @return New image with all its levels, or an empty image if the format is not supported.
+ */
+Image r3d_image_gen_mipmaps(const Image* image, bool srgb);
+
+/**
+ * @brief Compresses an image into S3TC blocks, optionally with its mipmaps.
+ *
+ * The mipmaps are box filtered from the first level and stop at the last level whose
+ * dimensions are still multiples of 4, so that the size of every level matches whole blocks.
+ * The source image is left untouched, it can be in any uncompressed format.
+ *
+ * @param image Source image, its dimensions must be multiples of 4.
+ * @param codec Block format to produce.
+ * @param mipmaps True to generate and compress the mipmaps.
+ *
+ * @return New compressed image, or an empty image if the source cannot be compressed.
+ *
+ * @note The blocks are fitted on the bounding box of their pixels, which is fast
+ *       enough to run at load time but does not match the quality of offline encoders.
+ */
+Image r3d_image_compress(const Image* image, r3d_image_codec_e codec, bool mipmaps);
+
 #endif // R3D_DETAILS_IMAGE_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+
+#ifndef R3D_DETAILS_KEYFRAME_H
+#define R3D_DETAILS_KEYFRAME_H
+
+#include <raylib.h>
+#include <stdint.h>
+#include <math.h>
+
+/* === Constants === */
+
+// The three smallest components of a unit quaternion are within [-1/sqrt(2), 1/sqrt(2)]
+#define R3D_KEYFRAME_QUAT_RANGE 0.70710678f
+
+/* === Types === */
+
+/*
+ * Vector3 key normalized on 16 bits in the range of its track.
+ */
+typedef struct {
+    uint16_t v[3];
+} r3d_keyframe_vec3_t;
+
+/*
+ * Quaternion key in smallest-three form, the largest component is rebuilt from the
+ * three others, stored on 15 bits each. The index of the largest component is kept
+ * in the lowest bit of the first two words.
+ */
+typedef struct {
+    uint16_t v[3];
+} r3d_keyframe_quat_t;
+
+/* === Functions === */
+
+static inline r3d_keyframe_vec3_t r3d_keyframe_pack_vec3(Vector3 v, Vector3 min, Vector3 size)
+{
+    const float src[3] = { v.x - min.x, v.y - min.y, v.z - min.z };
+    const float range[3] = { size.x, size.y, size.z };
+
+    r3d_keyframe_vec3_t key;
+    for (int i = 0; i < 3; i++) {
+        float n = (range[i] > 0.0f) ? src[i] / range[i] : 0.0f;
+        n = (n < 0.0f) ? 0.0f : (n > 1.0f ? 1.0f : n);
+        key.v[i] = (uint16_t)(n * 65535.0f + 0.5f);
+    }
+
+    return key;
+}
+
+static inline Vector3 r3d_keyframe_unpack_vec3(r3d_keyframe_vec3_t key, Vector3 min, Vector3 size)
+{
+    const float scale = 1.0f / 65535.0f;
+
+    return (Vector3) {
+        min.x + key.v[0] * scale * size.x,
+        min.y + key.v[1] * scale * size.y,
+        min.z + key.v[2] * scale * size.z
+    };
+}
+
+static inline r3d_keyframe_quat_t r3d_keyframe_pack_quat(Quaternion q)
+{
+    float c[4] = { q.x, q.y, q.z, q.w };
+
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(c[i]) > fabsf(c[largest])) largest = i;
+    }
+
+    // The quaternion and its opposite are the same rotation, the largest component is kept positive
+    float sign = (c[largest] < 0.0f) ? -1.0f : 1.0f;
+
+    r3d_keyframe_quat_t key;
+    for (int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) continue;
+        float n = (sign * c[i] + R3D_KEYFRAME_QUAT_RANGE) / (2.0f * R3D_KEYFRAME_QUAT_RANGE);
+        n = (n < 0.0f) ? 0.0f : (n > 1.0f ? 1.0f : n);
+        key.v[j++] = (uint16_t)((uint16_t)(n * 32767.0f + 0.5f) << 1);
+    }
+
+    key.v[0] |= (uint16_t)(largest & 1);
+    key.v[1] |= (uint16_t)(largest >> 1);
+
+    return key;
+}
+
+static inline Quaternion r3d_keyframe_unpack_quat(r3d_keyframe_quat_t key)
+{
+    const float scale = 2.0f * R3D_KEYFRAME_QUAT_RANGE / 32767.0f;
+
+    int largest = (key.v[0] & 1) | ((key.v[1] & 1) << 1);
+
+    float c[4];
+    float sum = 0.0f;
+    for (int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) continue;
+        c[i] = (key.v[j++] >> 1) * scale - R3D_KEYFRAME_QUAT_RANGE;
+        sum += c[i] * c[i];
+    }
+
+    c[largest] = sqrtf(fmaxf(1.0f - sum, 0.0f));
+
+    return (Quaternion) { c[0], c[1], c[2], c[3] };
+}
+
+#endif // R3D_DETAILS_KEYFRAME_H
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "./r3d_mapped_file.h"
+
+#include <raylib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#   define NOGDI
+#   define NOUSER
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#   undef near
+#   undef far
+#elif defined(__linux__) || defined(__APPLE__)
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#else
+#   error "Oops, platform not supported by R3D"
+#endif
+
+/* === Internal functions === */
+
+static bool map_file(r3d_mapped_file_t* file, const char* path)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart <= 0) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // NOTE: The view keeps a reference on the mapping, which keeps one on the file
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL) return false;
+
+    file->data = view;
+    file->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    // NOTE: The mapping remains valid once the descriptor is closed
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return false;
+
+    file->data = view;
+    file->size = (size_t)st.st_size;
+#endif
+
+    file->handle = NULL;
+    file->mapped = true;
+
+    return true;
+}
+
+static void unmap_file(r3d_mapped_file_t* file)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(file->data);
+#else
+    munmap((void*)file->data, file->size);
+#endif
+}
+
+/* === Public functions === */
+
+bool r3d_mapped_file_open(r3d_mapped_file_t* file, const char* path)
+{
+    memset(file, 0, sizeof(*file));
+
+    if (path == NULL) return false;
+    if (map_file(file, path)) return true;
+
+    // Some file systems do not support mappings, the file is read instead
+    int size = 0;
+    unsigned char* buffer = LoadFileData(path, &size);
+    if (buffer == NULL || size <= 0) {
+        UnloadFileData(buffer);
+        return false;
+    }
+
+    file->data = buffer;
+    file->size = (size_t)size;
+    file->handle = buffer;
+    file->mapped = false;
+
+    return true;
+}
+
+void r3d_mapped_file_close(r3d_mapped_file_t* file)
+{
+    if (file->data == NULL) return;
+
+    if (file->mapped) unmap_file(file);
+    else UnloadFileData(file->handle);
+
+    memset(file, 0, sizeof(*file));
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef R3D_DETAILS_MAPPED_FILE_H
+#define R3D_DETAILS_MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* === Types === */
+
+typedef struct {
+    const void* data;       //< Read-only view of the whole file
+    size_t size;            //< Size of the file in bytes
+    void* handle;           //< Platform handle, or the buffer when the file had to be read
+    bool mapped;            //< False when the file was read into memory instead
+} r3d_mapped_file_t;
+
+/* === Functions === */
+
+/*
+ * Maps a whole file in memory, read-only. Falls back to reading it if the mapping fails.
+ * Returns false if the file cannot be opened or is empty.
+ */
+bool r3d_mapped_file_open(r3d_mapped_file_t* file, const char* path);
+
+/*
+ * Releases the view of the file, 'data' is no longer valid afterwards.
+ */
+void r3d_mapped_file_close(r3d_mapped_file_t* file);
+
+#endif // R3D_DETAILS_MAPPED_FILE_H
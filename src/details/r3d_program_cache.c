@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "./r3d_program_cache.h"
+
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* === Internal types === */
+
+#define PROGRAM_CACHE_MAGIC     0x50443352u     //< "R3DP"
+#define PROGRAM_CACHE_VERSION   1u
+#define PROGRAM_CACHE_MAX_SIZE  (64 << 20)      //< Larger files are considered corrupted
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;            //< Binary format returned by the driver
+    uint32_t length;            //< Size in bytes of the binary following the header
+} program_cache_header_t;
+
+/* === Internal functions === */
+
+static uint64_t hash_fnv1a(uint64_t hash, const char* str)
+{
+    if (str == NULL) return hash;
+
+    for (const unsigned char* c = (const unsigned char*)str; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001B3ull;
+    }
+
+    // Separates the strings, "ab" + "c" must not match "a" + "bc"
+    hash ^= 0xFF;
+    hash *= 0x100000001B3ull;
+
+    return hash;
+}
+
+static void get_file_path(char* dst, size_t size, const char* directory, uint64_t key)
+{
+    snprintf(dst, size, "%s/%016llx.r3dprog", directory, (unsigned long long)key);
+}
+
+/* === Public functions === */
+
+bool r3d_program_cache_supported(void)
+{
+    static int supported = -1;
+
+    if (supported < 0) {
+        supported = 0;
+        if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) {
+            GLint formats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = (formats > 0);
+        }
+    }
+
+    return supported;
+}
+
+uint64_t r3d_program_cache_key(const char* const sources[], int count)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    hash = hash_fnv1a(hash, (const char*)glGetString(GL_VENDOR));
+    hash = hash_fnv1a(hash, (const char*)glGetString(GL_RENDERER));
+    hash = hash_fnv1a(hash, (const char*)glGetString(GL_VERSION));
+
+    for (int i = 0; i < count; i++) {
+        hash = hash_fnv1a(hash, sources[i]);
+    }
+
+    return hash;
+}
+
+GLuint r3d_program_cache_load(const char* directory, uint64_t key)
+{
+    if (directory == NULL || directory[0] == '\0' || !r3d_program_cache_supported()) {
+        return 0;
+    }
+
+    char path[512];
+    get_file_path(path, sizeof(path), directory, key);
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return 0;
+
+    program_cache_header_t header;
+    void* binary = NULL;
+    bool valid =
+        fread(&header, sizeof(header), 1, file) == 1 &&
+        header.magic == PROGRAM_CACHE_MAGIC &&
+        header.version == PROGRAM_CACHE_VERSION &&
+        header.key == key &&
+        header.length > 0 && header.length <= PROGRAM_CACHE_MAX_SIZE;
+
+    if (valid) {
+        binary = RL_MALLOC(header.length);
+        valid = (binary != NULL) && fread(binary, header.length, 1, file) == 1;
+    }
+
+    fclose(file);
+
+    if (!valid) {
+        TraceLog(LOG_WARNING, "R3D: Ignoring invalid program binary '%s'", path);
+        RL_FREE(binary);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    if (program != 0) {
+        glProgramBinary(program, header.format, binary, (GLsizei)header.length);
+    }
+
+    RL_FREE(binary);
+
+    // Binaries are rejected after driver updates that keep the same version string
+    GLint success = GL_FALSE;
+    if (program != 0) {
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+    }
+
+    if (!success) {
+        TraceLog(LOG_INFO, "R3D: Program binary '%s' rejected by the driver, recompiling", path);
+        if (program != 0) glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+void r3d_program_cache_hint(GLuint program)
+{
+    if (r3d_program_cache_supported()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void r3d_program_cache_store(const char* directory, uint64_t key, GLuint program)
+{
+    if (directory == NULL || directory[0] == '\0' || !r3d_program_cache_supported()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || length > PROGRAM_CACHE_MAX_SIZE) {
+        return;
+    }
+
+    void* binary = RL_MALLOC(length);
+    if (binary == NULL) return;
+
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary);
+
+    program_cache_header_t header = {
+        .magic = PROGRAM_CACHE_MAGIC,
+        .version = PROGRAM_CACHE_VERSION,
+        .key = key,
+        .format = format,
+        .length = (uint32_t)length
+    };
+
+    char path[512];
+    get_file_path(path, sizeof(path), directory, key);
+
+    FILE* file = fopen(path, "wb");
+    bool written = (file != NULL) &&
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(binary, length, 1, file) == 1;
+
+    if (file != NULL && fclose(file) != 0) {
+        written = false;
+    }
+
+    // A partial file would only be rejected on the next load, better not to leave it
+    if (file != NULL && !written) {
+        remove(path);
+    }
+
+    if (!written) {
+        TraceLog(LOG_WARNING, "R3D: Failed to write program binary '%s'", path);
+    }
+
+    RL_FREE(binary);
+}
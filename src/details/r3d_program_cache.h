@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef R3D_DETAILS_PROGRAM_CACHE_H
+#define R3D_DETAILS_PROGRAM_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <glad.h>
+
+/* === Functions === */
+
+/*
+ * Returns true if the driver can save and restore the linked programs.
+ * Requires OpenGL 4.1 or ARB_get_program_binary, with at least one binary format.
+ */
+bool r3d_program_cache_supported(void);
+
+/*
+ * Hash of the final sources of a program (after the injection of the defines),
+ * combined with the vendor, renderer and version strings of the driver.
+ */
+uint64_t r3d_program_cache_key(const char* const sources[], int count);
+
+/*
+ * Creates a program from the binary stored for the key in 'directory'.
+ * Returns zero if there is no directory, no file, or if the driver rejects the binary,
+ * the caller must then compile the program from its sources.
+ */
+GLuint r3d_program_cache_load(const char* directory, uint64_t key);
+
+/*
+ * Asks the driver to keep the binary of a program, must be called before linking it.
+ */
+void r3d_program_cache_hint(GLuint program);
+
+/*
+ * Writes the binary of a linked program to 'directory', does nothing without a directory.
+ * NOTE: The directory is not created, failures are only reported as warnings.
+ */
+void r3d_program_cache_store(const char* directory, uint64_t key, GLuint program);
+
+#endif // R3D_DETAILS_PROGRAM_CACHE_H
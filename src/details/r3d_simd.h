@@ -18,6 +18,10 @@
  */
 
 #ifndef R3D_SIMD_H
+#define R3D_SIMD_H
+
+// Defining R3D_NO_SIMD forces the scalar paths, used as the reference of the SIMD ones
+#if !defined(R3D_NO_SIMD)
 
 #if defined(__FMA__) && defined(__AVX2__)
     #define R3D_HAS_FMA_AVX2
@@ -78,4 +82,6 @@
     #include <arm_neon.h>
 #endif
 
+#endif // R3D_NO_SIMD
+
 #endif // R3D_SIMD_H
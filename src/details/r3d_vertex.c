@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#include "./r3d_vertex.h"
+
+#include <raymath.h>
+#include <math.h>
+#include <glad.h>
+
+/* === Internal functions === */
+
+static uint16_t quantize_unorm16(float value)
+{
+    if (!(value > 0.0f)) return 0;
+    if (value >= 1.0f) return UINT16_MAX;
+    return (uint16_t)(value * UINT16_MAX + 0.5f);
+}
+
+static void encode_octahedral(Vector3 v, uint16_t out[2])
+{
+    // Project on the octahedron, same convention as M_DecodeOctahedral
+    float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+    if (l1 < 1e-8f) {
+        v = (Vector3) {0.0f, 0.0f, 1.0f};
+        l1 = 1.0f;
+    }
+
+    float x = v.x / l1;
+    float y = v.y / l1;
+
+    // Fold the lower hemisphere over the upper one
+    if (v.z < 0.0f) {
+        float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx, y = fy;
+    }
+
+    out[0] = quantize_unorm16(x * 0.5f + 0.5f);
+    out[1] = quantize_unorm16(y * 0.5f + 0.5f);
+}
+
+static Vector3 decode_octahedral(const uint16_t in[2])
+{
+    float x = in[0] * (2.0f / UINT16_MAX) - 1.0f;
+    float y = in[1] * (2.0f / UINT16_MAX) - 1.0f;
+    float z = 1.0f - fabsf(x) - fabsf(y);
+
+    // Unfold the lower hemisphere, same as M_DecodeOctahedral
+    if (z < 0.0f) {
+        float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx, y = fy;
+    }
+
+    return Vector3Normalize((Vector3) {x, y, z});
+}
+
+static void encode_weights(const float weights[4], uint8_t out[4])
+{
+    float sum = weights[0] + weights[1] + weights[2] + weights[3];
+    if (sum <= 0.0f) {
+        out[0] = out[1] = out[2] = out[3] = 0;
+        return;
+    }
+
+    // Round each weight, then give the rounding error to the largest one
+    int total = 0, largest = 0;
+    for (int i = 0; i < 4; i++) {
+        float w = fmaxf(weights[i], 0.0f) / sum;
+        out[i] = (uint8_t)fminf(w * 255.0f + 0.5f, 255.0f);
+        if (out[i] > out[largest]) largest = i;
+        total += out[i];
+    }
+
+    out[largest] = (uint8_t)(out[largest] + (255 - total));
+}
+
+static void encode_full(void* dst, r3d_vertex_stream_e stream, const R3D_Vertex* vertices, int count)
+{
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        for (int i = 0; i < count; i++) {
+            ((Vector3*)dst)[i] = vertices[i].position;
+        }
+        break;
+    case R3D_VERTEX_STREAM_SKIN:
+        for (int i = 0; i < count; i++) {
+            r3d_vertex_skin_t* out = &((r3d_vertex_skin_t*)dst)[i];
+            for (int j = 0; j < 4; j++) {
+                out->boneIds[j] = vertices[i].boneIds[j];
+                out->weights[j] = vertices[i].weights[j];
+            }
+        }
+        break;
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        for (int i = 0; i < count; i++) {
+            r3d_vertex_attribs_t* out = &((r3d_vertex_attribs_t*)dst)[i];
+            out->texcoord = vertices[i].texcoord;
+            out->normal = vertices[i].normal;
+            out->color = vertices[i].color;
+            out->tangent = vertices[i].tangent;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void encode_compact(void* dst, r3d_vertex_stream_e stream, const R3D_Vertex* vertices, int count, const BoundingBox* bounds)
+{
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        {
+            Vector3 size = Vector3Subtract(bounds->max, bounds->min);
+            Vector3 invSize = {
+                (size.x > 0.0f) ? 1.0f / size.x : 0.0f,
+                (size.y > 0.0f) ? 1.0f / size.y : 0.0f,
+                (size.z > 0.0f) ? 1.0f / size.z : 0.0f
+            };
+            for (int i = 0; i < count; i++) {
+                r3d_vertex_position_compact_t* out = &((r3d_vertex_position_compact_t*)dst)[i];
+                const R3D_Vertex* v = &vertices[i];
+                out->position[0] = quantize_unorm16((v->position.x - bounds->min.x) * invSize.x);
+                out->position[1] = quantize_unorm16((v->position.y - bounds->min.y) * invSize.y);
+                out->position[2] = quantize_unorm16((v->position.z - bounds->min.z) * invSize.z);
+                out->position[3] = (v->tangent.w < 0.0f) ? 0 : UINT16_MAX;
+            }
+        }
+        break;
+    case R3D_VERTEX_STREAM_SKIN:
+        for (int i = 0; i < count; i++) {
+            r3d_vertex_skin_compact_t* out = &((r3d_vertex_skin_compact_t*)dst)[i];
+            for (int j = 0; j < 4; j++) {
+                out->boneIds[j] = (uint8_t)vertices[i].boneIds[j];
+            }
+            encode_weights(vertices[i].weights, out->weights);
+        }
+        break;
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        for (int i = 0; i < count; i++) {
+            r3d_vertex_attribs_compact_t* out = &((r3d_vertex_attribs_compact_t*)dst)[i];
+            const R3D_Vertex* v = &vertices[i];
+            out->texcoord[0] = r3d_cvt_fh(v->texcoord.x);
+            out->texcoord[1] = r3d_cvt_fh(v->texcoord.y);
+            encode_octahedral(v->normal, out->normal);
+            encode_octahedral((Vector3) {v->tangent.x, v->tangent.y, v->tangent.z}, out->tangent);
+            out->color[0] = v->color.r;
+            out->color[1] = v->color.g;
+            out->color[2] = v->color.b;
+            out->color[3] = v->color.a;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void decode_full(R3D_Vertex* vertices, r3d_vertex_stream_e stream, const void* src, int count)
+{
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        for (int i = 0; i < count; i++) {
+            vertices[i].position = ((const Vector3*)src)[i];
+        }
+        break;
+    case R3D_VERTEX_STREAM_SKIN:
+        for (int i = 0; i < count; i++) {
+            const r3d_vertex_skin_t* in = &((const r3d_vertex_skin_t*)src)[i];
+            for (int j = 0; j < 4; j++) {
+                vertices[i].boneIds[j] = in->boneIds[j];
+                vertices[i].weights[j] = in->weights[j];
+            }
+        }
+        break;
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        for (int i = 0; i < count; i++) {
+            const r3d_vertex_attribs_t* in = &((const r3d_vertex_attribs_t*)src)[i];
+            vertices[i].texcoord = in->texcoord;
+            vertices[i].normal = in->normal;
+            vertices[i].color = in->color;
+            vertices[i].tangent = in->tangent;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void decode_compact(R3D_Vertex* vertices, r3d_vertex_stream_e stream, const void* src, int count, const BoundingBox* bounds)
+{
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        {
+            Vector3 size = Vector3Subtract(bounds->max, bounds->min);
+            for (int i = 0; i < count; i++) {
+                const r3d_vertex_position_compact_t* in = &((const r3d_vertex_position_compact_t*)src)[i];
+                vertices[i].position.x = bounds->min.x + in->position[0] * (size.x / UINT16_MAX);
+                vertices[i].position.y = bounds->min.y + in->position[1] * (size.y / UINT16_MAX);
+                vertices[i].position.z = bounds->min.z + in->position[2] * (size.z / UINT16_MAX);
+                vertices[i].tangent.w = (in->position[3] == 0) ? -1.0f : 1.0f;
+            }
+        }
+        break;
+    case R3D_VERTEX_STREAM_SKIN:
+        for (int i = 0; i < count; i++) {
+            const r3d_vertex_skin_compact_t* in = &((const r3d_vertex_skin_compact_t*)src)[i];
+            for (int j = 0; j < 4; j++) {
+                vertices[i].boneIds[j] = in->boneIds[j];
+                vertices[i].weights[j] = in->weights[j] * (1.0f / 255.0f);
+            }
+        }
+        break;
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        for (int i = 0; i < count; i++) {
+            const r3d_vertex_attribs_compact_t* in = &((const r3d_vertex_attribs_compact_t*)src)[i];
+            R3D_Vertex* v = &vertices[i];
+            v->texcoord.x = r3d_cvt_hf(in->texcoord[0]);
+            v->texcoord.y = r3d_cvt_hf(in->texcoord[1]);
+            v->normal = decode_octahedral(in->normal);
+            Vector3 tangent = decode_octahedral(in->tangent);
+            v->tangent.x = tangent.x;
+            v->tangent.y = tangent.y;
+            v->tangent.z = tangent.z;
+            v->color = (Color) {in->color[0], in->color[1], in->color[2], in->color[3]};
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* === Public functions === */
+
+size_t r3d_vertex_stride(R3D_VertexFormat format, r3d_vertex_stream_e stream)
+{
+    bool compact = (format == R3D_VERTEX_FORMAT_COMPACT);
+
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        return compact ? sizeof(r3d_vertex_position_compact_t) : sizeof(Vector3);
+    case R3D_VERTEX_STREAM_SKIN:
+        return compact ? sizeof(r3d_vertex_skin_compact_t) : sizeof(r3d_vertex_skin_t);
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        return compact ? sizeof(r3d_vertex_attribs_compact_t) : sizeof(r3d_vertex_attribs_t);
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+bool r3d_vertex_has_skin(const R3D_MeshData* data)
+{
+    for (int i = 0; i < data->vertexCount; i++) {
+        const float* w = data->vertices[i].weights;
+        if (w[0] != 0.0f || w[1] != 0.0f || w[2] != 0.0f || w[3] != 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool r3d_vertex_has_alpha(const R3D_MeshData* data)
+{
+    for (int i = 0; i < data->vertexCount; i++) {
+        if (data->vertices[i].color.a < 255) return true;
+    }
+    return false;
+}
+
+bool r3d_vertex_can_compact(const R3D_MeshData* data)
+{
+    for (int i = 0; i < data->vertexCount; i++) {
+        const int* ids = data->vertices[i].boneIds;
+        for (int j = 0; j < 4; j++) {
+            if (ids[j] < 0 || ids[j] > 255) return false;
+        }
+    }
+    return true;
+}
+
+void r3d_vertex_encode(void* dst, R3D_VertexFormat format, r3d_vertex_stream_e stream,
+                       const R3D_Vertex* vertices, int count, const BoundingBox* bounds)
+{
+    if (format == R3D_VERTEX_FORMAT_COMPACT) {
+        encode_compact(dst, stream, vertices, count, bounds);
+    }
+    else {
+        encode_full(dst, stream, vertices, count);
+    }
+}
+
+void r3d_vertex_decode(R3D_Vertex* vertices, R3D_VertexFormat format, r3d_vertex_stream_e stream,
+                       const void* src, int count, const BoundingBox* bounds)
+{
+    if (format == R3D_VERTEX_FORMAT_COMPACT) {
+        decode_compact(vertices, stream, src, count, bounds);
+    }
+    else {
+        decode_full(vertices, stream, src, count);
+    }
+}
+
+bool r3d_vertex_upload(R3D_VertexFormat format, r3d_vertex_stream_e stream, const R3D_Vertex* vertices,
+                       int count, int firstVertex, const BoundingBox* bounds, bool allocate, unsigned int glUsage)
+{
+    size_t stride = r3d_vertex_stride(format, stream);
+    size_t size = count * stride;
+
+    void* encoded = RL_MALLOC(size);
+    if (encoded == NULL) {
+        if (allocate) glBufferData(GL_ARRAY_BUFFER, size, NULL, glUsage);
+        return false;
+    }
+
+    r3d_vertex_encode(encoded, format, stream, vertices, count, bounds);
+
+    if (allocate) glBufferData(GL_ARRAY_BUFFER, size, encoded, glUsage);
+    else glBufferSubData(GL_ARRAY_BUFFER, firstVertex * stride, size, encoded);
+
+    RL_FREE(encoded);
+
+    return true;
+}
+
+void r3d_vertex_setup_stream(R3D_VertexFormat format, r3d_vertex_stream_e stream)
+{
+    GLsizei stride = (GLsizei)r3d_vertex_stride(format, stream);
+
+    if (format == R3D_VERTEX_FORMAT_COMPACT) {
+        switch (stream) {
+        case R3D_VERTEX_STREAM_POSITION:
+            // position (vec4, handedness in w)
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(r3d_vertex_position_compact_t, position));
+            break;
+        case R3D_VERTEX_STREAM_SKIN:
+            // boneIds (ivec4)
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(r3d_vertex_skin_compact_t, boneIds));
+            // weights (vec4)
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(r3d_vertex_skin_compact_t, weights));
+            break;
+        case R3D_VERTEX_STREAM_ATTRIBS:
+            // texcoord (vec2)
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_vertex_attribs_compact_t, texcoord));
+            // normal (vec2, octahedral)
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(r3d_vertex_attribs_compact_t, normal));
+            // color (vec4)
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(r3d_vertex_attribs_compact_t, color));
+            // tangent (vec2, octahedral)
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(r3d_vertex_attribs_compact_t, tangent));
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    switch (stream) {
+    case R3D_VERTEX_STREAM_POSITION:
+        // position (vec3)
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        break;
+    case R3D_VERTEX_STREAM_SKIN:
+        // boneIds (ivec4)
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, stride, (void*)offsetof(r3d_vertex_skin_t, boneIds));
+        // weights (vec4)
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_vertex_skin_t, weights));
+        break;
+    case R3D_VERTEX_STREAM_ATTRIBS:
+        // texcoord (vec2)
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_vertex_attribs_t, texcoord));
+        // normal (vec3)
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_vertex_attribs_t, normal));
+        // color (vec4)
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(r3d_vertex_attribs_t, color));
+        // tangent (vec4)
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_vertex_attribs_t, tangent));
+        break;
+    default:
+        break;
+    }
+}
+
+void r3d_vertex_setup_defaults(void)
+{
+    // Default skinning, read by meshes without bone weights (ivec4 + vec4)
+    glVertexAttribI4i(5, 0, 0, 0, 0);
+    glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+
+    // Default matrix instance (mat4)
+    glVertexAttrib4f(10, 1.0f, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(11, 0.0f, 1.0f, 0.0f, 0.0f);
+    glVertexAttrib4f(12, 0.0f, 0.0f, 1.0f, 0.0f);
+    glVertexAttrib4f(13, 0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Default color instance (vec4)
+    glVertexAttrib4f(14, 1.0f, 1.0f, 1.0f, 1.0f);
+}
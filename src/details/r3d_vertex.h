@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided "as-is", without any express or implied warranty. In no event
+ * will the authors be held liable for any damages arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose, including commercial
+ * applications, and to alter it and redistribute it freely, subject to the following restrictions:
+ *
+ *   1. The origin of this software must not be misrepresented; you must not claim that you
+ *   wrote the original software. If you use this software in a product, an acknowledgment
+ *   in the product documentation would be appreciated but is not required.
+ *
+ *   2. Altered source versions must be plainly marked as such, and must not be misrepresented
+ *   as being the original software.
+ *
+ *   3. This notice may not be removed or altered from any source distribution.
+ */
+
+#ifndef R3D_DETAILS_VERTEX_H
+#define R3D_DETAILS_VERTEX_H
+
+#include <r3d/r3d_mesh_data.h>
+#include <r3d/r3d_mesh.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "./r3d_half.h"
+
+/* === Types === */
+
+/*
+ * Vertices are split into separate buffers so that the depth passes
+ * only fetch the positions, and the skinning data of animated meshes.
+ */
+typedef enum {
+    R3D_VERTEX_STREAM_POSITION,     //< Location 0
+    R3D_VERTEX_STREAM_SKIN,         //< Locations 5 and 6, only created for meshes with bone weights
+    R3D_VERTEX_STREAM_ATTRIBS,      //< Locations 1 to 4
+    R3D_VERTEX_STREAM_COUNT
+} r3d_vertex_stream_e;
+
+typedef struct {
+    int boneIds[4];
+    float weights[4];
+} r3d_vertex_skin_t;
+
+typedef struct {
+    Vector2 texcoord;
+    Vector3 normal;
+    Color color;
+    Vector4 tangent;
+} r3d_vertex_attribs_t;
+
+typedef struct {
+    uint16_t position[4];       //< Normalized in the quantization bounds, tangent handedness in w
+} r3d_vertex_position_compact_t;
+
+typedef struct {
+    uint8_t boneIds[4];         //< Bone indices, limited to 255
+    uint8_t weights[4];         //< Normalized weights, summing to 255 when skinned
+} r3d_vertex_skin_compact_t;
+
+typedef struct {
+    r3d_half_t texcoord[2];     //< Half floats
+    uint16_t normal[2];         //< Normalized octahedral encoding
+    uint8_t color[4];           //< RGBA8, same as R3D_Vertex
+    uint16_t tangent[2];        //< Normalized octahedral encoding
+} r3d_vertex_attribs_compact_t;
+
+/* === Functions === */
+
+/*
+ * Size in bytes of one vertex of a stream.
+ */
+size_t r3d_vertex_stride(R3D_VertexFormat format, r3d_vertex_stream_e stream);
+
+/*
+ * Returns true if any vertex has a non-zero bone weight.
+ */
+bool r3d_vertex_has_skin(const R3D_MeshData* data);
+
+/*
+ * Returns true if any vertex color is translucent.
+ * The depth passes of such meshes need the color stream for alpha testing.
+ */
+bool r3d_vertex_has_alpha(const R3D_MeshData* data);
+
+/*
+ * Returns true if the bone indices fit in the compact format.
+ */
+bool r3d_vertex_can_compact(const R3D_MeshData* data);
+
+/*
+ * Writes one stream of the vertices to 'dst', which must hold 'count' elements of the stream stride.
+ * The bounds are only used by the compact position stream.
+ */
+void r3d_vertex_encode(void* dst, R3D_VertexFormat format, r3d_vertex_stream_e stream,
+                       const R3D_Vertex* vertices, int count, const BoundingBox* bounds);
+
+/*
+ * Reads one stream of 'count' vertices from 'src', the inverse of `r3d_vertex_encode()`.
+ * Only the members of the stream are written to 'vertices'.
+ */
+void r3d_vertex_decode(R3D_Vertex* vertices, R3D_VertexFormat format, r3d_vertex_stream_e stream,
+                       const void* src, int count, const BoundingBox* bounds);
+
+/*
+ * Encodes and uploads one stream into the buffer bound to GL_ARRAY_BUFFER, at the given vertex.
+ * The buffer storage is (re)allocated with the vertices when 'allocate' is true,
+ * 'firstVertex' must then be zero. Returns false on allocation failure.
+ */
+bool r3d_vertex_upload(R3D_VertexFormat format, r3d_vertex_stream_e stream, const R3D_Vertex* vertices,
+                       int count, int firstVertex, const BoundingBox* bounds, bool allocate, unsigned int glUsage);
+
+/*
+ * Declares the attributes of a stream for the bound VAO, read from the buffer bound to GL_ARRAY_BUFFER.
+ */
+void r3d_vertex_setup_stream(R3D_VertexFormat format, r3d_vertex_stream_e stream);
+
+/*
+ * Sets the values read by the shaders for the attributes without arrays:
+ * a null skinning for meshes without bone weights, and an identity instance.
+ * NOTE: These values are context state, not VAO state, but are set with each VAO for clarity.
+ */
+void r3d_vertex_setup_defaults(void);
+
+#endif // R3D_DETAILS_VERTEX_H
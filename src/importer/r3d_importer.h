@@ -72,6 +72,12 @@ typedef enum {
 
 typedef struct r3d_importer_texture_cache r3d_importer_texture_cache_t;
 
+// ========================================
+// MESH BATCH
+// ========================================
+
+typedef struct r3d_importer_mesh_batch r3d_importer_mesh_batch_t;
+
 // ========================================
 // PUBLIC FUNCTIONS
 // ========================================
@@ -86,8 +92,22 @@ int r3d_importer_get_bone_index(const r3d_importer_t* importer, const char* name
  * Create a texture cache that loads all textures for all materials
  * This will spawn worker threads to load images in parallel, then
  * progressively upload them to GPU as they become ready
+ * With 'compress', the uncompressed images are encoded to S3TC blocks by the worker threads
+ * With 'stream', only the coarse levels of the large mipmapped textures are uploaded, see `r3d_texture_load_streamed()`
+ */
+r3d_importer_texture_cache_t* r3d_importer_load_texture_cache(const r3d_importer_t* importer, TextureFilter filter, bool compress, bool stream);
+
+/**
+ * Staged version of `r3d_importer_load_texture_cache()`, for loadings spread over several frames
+ * Begin only spawns the decoding threads and can be called from any thread, the other ones
+ * must be called from the thread owning the OpenGL context
+ * Upload processes the next decoded image, it returns false if none is ready without 'wait', or once all are done
+ * End joins the threads and releases the images that were not uploaded, the cache remains valid
  */
-r3d_importer_texture_cache_t* r3d_importer_load_texture_cache(const r3d_importer_t* importer, TextureFilter filter);
+r3d_importer_texture_cache_t* r3d_importer_begin_texture_cache(const r3d_importer_t* importer, TextureFilter filter, bool compress, bool stream);
+bool r3d_importer_upload_next_texture(r3d_importer_texture_cache_t* cache, bool wait);
+int r3d_importer_get_pending_texture_count(const r3d_importer_texture_cache_t* cache);
+void r3d_importer_end_texture_cache(r3d_importer_texture_cache_t* cache);
 
 /**
  * Destroy the texture cache and free all unused resources
@@ -102,9 +122,24 @@ Texture2D* r3d_importer_get_loaded_texture(r3d_importer_texture_cache_t* cache,
 
 /**
  * Load all meshes from the importer into the model
+ * Up to 'lodCount' levels of detail are generated for each mesh
+ * The vertices of the meshes are stored on the GPU with the given format
  * Returns true on success, false on failure
  */
-bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model);
+bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model, int lodCount, R3D_VertexFormat format);
+
+/**
+ * Staged version of `r3d_importer_load_meshes()`, for loadings spread over several frames
+ * Begin allocates the meshes of the model and spawns the conversion threads, convert
+ * helps them and waits for all the meshes, both can be called from any thread
+ * Upload sends the next mesh to the GPU, converting it first if needed, it returns false once all are done
+ * End joins the threads and computes the bounds of the model, or unloads its meshes if one failed
+ */
+r3d_importer_mesh_batch_t* r3d_importer_begin_meshes(const r3d_importer_t* importer, R3D_Model* model, int lodCount);
+void r3d_importer_convert_meshes(r3d_importer_mesh_batch_t* batch);
+bool r3d_importer_upload_next_mesh(r3d_importer_mesh_batch_t* batch, R3D_Model* model, R3D_VertexFormat format);
+int r3d_importer_get_pending_mesh_count(const r3d_importer_mesh_batch_t* batch);
+bool r3d_importer_end_meshes(r3d_importer_mesh_batch_t* batch, R3D_Model* model);
 
 /**
  * Process and create a skeleton from the imported scene
@@ -121,10 +156,11 @@ bool r3d_importer_load_materials(const r3d_importer_t* importer, R3D_Model* mode
 
 /**
  * Load all animations from the imported scene
+ * With a positive tolerance, the tracks are reduced and quantized, see `R3D_SetAnimationCompression()`
  * Returns NULL if no animations are found or on error
  * The returned animation library must be freed by the caller
  */
-bool r3d_importer_load_animations(const r3d_importer_t* importer, R3D_AnimationLib* animationLib);
+bool r3d_importer_load_animations(const r3d_importer_t* importer, R3D_AnimationLib* animationLib, float tolerance);
 
 // ========================================
 // INLINE FUNCTIONS
@@ -9,9 +9,163 @@
 #include "./r3d_importer.h"
 
 #include <assimp/anim.h>
+#include <raymath.h>
 #include <raylib.h>
 #include <string.h>
 
+#include "../details/r3d_keyframe.h"
+
+// ========================================
+// TRACK COMPRESSION (INTERNAL)
+// ========================================
+
+static float quaternion_angle(Quaternion a, Quaternion b)
+{
+    float d = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+    return 2.0f * acosf(fminf(d, 1.0f));
+}
+
+/*
+ * Returns true if the keys between 'first' and 'last' are interpolated from
+ * these two keys within the tolerance, the same way the animation player samples them.
+ */
+static bool vector3_keys_fit(const float* times, const Vector3* values, int first, int last, float tolerance)
+{
+    float span = times[last] - times[first];
+
+    for (int i = first + 1; i < last; i++) {
+        float t = (span > 0.0f) ? (times[i] - times[first]) / span : 0.0f;
+        Vector3 v = Vector3Lerp(values[first], values[last], t);
+        if (Vector3Distance(v, values[i]) > tolerance) return false;
+    }
+
+    return true;
+}
+
+static bool quaternion_keys_fit(const float* times, const Quaternion* values, int first, int last, float tolerance)
+{
+    float span = times[last] - times[first];
+
+    for (int i = first + 1; i < last; i++) {
+        float t = (span > 0.0f) ? (times[i] - times[first]) / span : 0.0f;
+        Quaternion q = QuaternionSlerp(values[first], values[last], t);
+        if (quaternion_angle(q, values[i]) > tolerance) return false;
+    }
+
+    return true;
+}
+
+/*
+ * Removes in place the keys interpolated from their neighbors within the tolerance.
+ * A key is only dropped if the next key still interpolates all the keys since the last one kept,
+ * constant tracks are reduced to a single key. Returns the new number of keys.
+ */
+static int reduce_vector3_keys(float* times, Vector3* values, int count, float tolerance)
+{
+    if (count < 2) return count;
+
+    int kept = 1, last = 0;
+    for (int i = 1; i < count - 1; i++) {
+        if (!vector3_keys_fit(times, values, last, i + 1, tolerance)) {
+            times[kept] = times[i];
+            values[kept] = values[i];
+            last = i, kept++;
+        }
+    }
+
+    times[kept] = times[count - 1];
+    values[kept] = values[count - 1];
+    kept++;
+
+    if (kept == 2 && Vector3Distance(values[0], values[1]) <= tolerance) {
+        kept = 1;
+    }
+
+    return kept;
+}
+
+static int reduce_quaternion_keys(float* times, Quaternion* values, int count, float tolerance)
+{
+    if (count < 2) return count;
+
+    int kept = 1, last = 0;
+    for (int i = 1; i < count - 1; i++) {
+        if (!quaternion_keys_fit(times, values, last, i + 1, tolerance)) {
+            times[kept] = times[i];
+            values[kept] = values[i];
+            last = i, kept++;
+        }
+    }
+
+    times[kept] = times[count - 1];
+    values[kept] = values[count - 1];
+    kept++;
+
+    if (kept == 2 && quaternion_angle(values[0], values[1]) <= tolerance) {
+        kept = 1;
+    }
+
+    return kept;
+}
+
+static bool compress_vector3_track(R3D_AnimationTrack* track, float tolerance)
+{
+    float* times = (float*)track->times;
+    Vector3* values = (Vector3*)track->values;
+
+    track->count = reduce_vector3_keys(times, values, track->count, tolerance);
+
+    Vector3 min = values[0], max = values[0];
+    for (int i = 1; i < track->count; i++) {
+        min = Vector3Min(min, values[i]);
+        max = Vector3Max(max, values[i]);
+    }
+
+    r3d_keyframe_vec3_t* packed = RL_MALLOC(sizeof(r3d_keyframe_vec3_t) * track->count);
+    if (!packed) return false;
+
+    Vector3 size = Vector3Subtract(max, min);
+    for (int i = 0; i < track->count; i++) {
+        packed[i] = r3d_keyframe_pack_vec3(values[i], min, size);
+    }
+
+    RL_FREE(values);
+
+    // Shrinking the times can hardly fail, the full array is kept if it does
+    float* shrunk = RL_REALLOC(times, sizeof(float) * track->count);
+    track->times = shrunk ? shrunk : times;
+    track->values = packed;
+    track->quantized = true;
+    track->rangeMin = min;
+    track->rangeSize = size;
+
+    return true;
+}
+
+static bool compress_quaternion_track(R3D_AnimationTrack* track, float tolerance)
+{
+    float* times = (float*)track->times;
+    Quaternion* values = (Quaternion*)track->values;
+
+    track->count = reduce_quaternion_keys(times, values, track->count, tolerance);
+
+    r3d_keyframe_quat_t* packed = RL_MALLOC(sizeof(r3d_keyframe_quat_t) * track->count);
+    if (!packed) return false;
+
+    for (int i = 0; i < track->count; i++) {
+        packed[i] = r3d_keyframe_pack_quat(QuaternionNormalize(values[i]));
+    }
+
+    RL_FREE(values);
+
+    float* shrunk = RL_REALLOC(times, sizeof(float) * track->count);
+    track->times = shrunk ? shrunk : times;
+    track->values = packed;
+    track->quantized = true;
+
+    return true;
+}
+
 // ========================================
 // CHANNEL LOADING (INTERNAL)
 // ========================================
@@ -72,7 +226,7 @@ static bool load_quaternion_track(R3D_AnimationTrack* track, unsigned int count,
     return true;
 }
 
-static bool load_channel(R3D_AnimationChannel* channel, const r3d_importer_t* importer, const struct aiNodeAnim* aiChannel)
+static bool load_channel(R3D_AnimationChannel* channel, const r3d_importer_t* importer, const struct aiNodeAnim* aiChannel, float tolerance)
 {
     if (!aiChannel) {
         TraceLog(LOG_ERROR, "RENDER: Invalid animation channel");
@@ -101,6 +255,14 @@ static bool load_channel(R3D_AnimationChannel* channel, const r3d_importer_t* im
         goto fail;
     }
 
+    if (tolerance > 0.0f) {
+        if ((channel->translation.count > 0 && !compress_vector3_track(&channel->translation, tolerance)) ||
+            (channel->rotation.count > 0 && !compress_quaternion_track(&channel->rotation, tolerance)) ||
+            (channel->scale.count > 0 && !compress_vector3_track(&channel->scale, tolerance))) {
+            goto fail;
+        }
+    }
+
     return true;
 
 fail:
@@ -118,7 +280,7 @@ fail:
 // ANIMATION LOADING (INTERNAL)
 // ========================================
 
-static bool load_animation(R3D_Animation* animation, const r3d_importer_t* importer, const struct aiAnimation* aiAnim)
+static bool load_animation(R3D_Animation* animation, const r3d_importer_t* importer, const struct aiAnimation* aiAnim, float tolerance)
 {
     // Basic validation
     if (!aiAnim || aiAnim->mNumChannels == 0) {
@@ -159,7 +321,7 @@ static bool load_animation(R3D_Animation* animation, const r3d_importer_t* impor
     // Load each channel
     int successChannels = 0;
     for (unsigned int i = 0; i < aiAnim->mNumChannels; i++) {
-        if (load_channel(&animation->channels[successChannels], importer, aiAnim->mChannels[i])) {
+        if (load_channel(&animation->channels[successChannels], importer, aiAnim->mChannels[i], tolerance)) {
             successChannels++;
         } else {
             TraceLog(LOG_WARNING, "RENDER: Failed to load channel %u", i);
@@ -194,7 +356,7 @@ static bool load_animation(R3D_Animation* animation, const r3d_importer_t* impor
 // PUBLIC FUNCTIONS
 // ========================================
 
-bool r3d_importer_load_animations(const r3d_importer_t* importer, R3D_AnimationLib* animLib)
+bool r3d_importer_load_animations(const r3d_importer_t* importer, R3D_AnimationLib* animLib, float tolerance)
 {
     if (!importer || !r3d_importer_is_valid(importer)) {
         TraceLog(LOG_ERROR, "RENDER: Invalid importer for animation loading");
@@ -218,7 +380,7 @@ bool r3d_importer_load_animations(const r3d_importer_t* importer, R3D_AnimationL
     int successCount = 0;
     for (int i = 0; i < animCount; i++) {
         const struct aiAnimation* aiAnim = r3d_importer_get_animation(importer, i);
-        if (load_animation(&animations[successCount], importer, aiAnim)) {
+        if (load_animation(&animations[successCount], importer, aiAnim, tolerance)) {
             successCount++;
         } else {
             TraceLog(LOG_ERROR, "RENDER: Failed to process animation %d", i);
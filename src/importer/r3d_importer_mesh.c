@@ -13,10 +13,13 @@
 #include <raylib.h>
 
 #include <assimp/mesh.h>
+#include <tinycthread.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <float.h>
 
 #include "../details/r3d_math.h"
+#include "../details/r3d_cpu.h"
 
 // ========================================
 // CONSTANTS
@@ -25,6 +28,11 @@
 #define MAX_BONE_WEIGHTS 4
 #define MIN_BONE_WEIGHT_THRESHOLD 1e-3f
 
+#define LOD_MIN_INDEX_COUNT 384         // Meshes with fewer indices get no levels of detail
+#define LOD_TARGET_ERROR 0.02f          // Maximum simplification error, relative to the mesh size
+#define LOD_MIN_REDUCTION 0.8f          // Levels keeping more indices than this ratio of the previous one are dropped
+#define LOD_FIRST_SCREEN_SIZE 0.5f      // Screen size of the first level, halved for each following level
+
 // ========================================
 // VERTEX PROCESSING (INTERNAL)
 // ========================================
@@ -219,16 +227,85 @@ static bool process_bones(const struct aiMesh* aiMesh, R3D_MeshData* data, int v
 }
 
 // ========================================
-// MESH LOADING (INTERNAL)
+// INTERNAL STRUCTURES
+// ========================================
+
+/*
+ * Conversion of one assimp mesh, done by any thread and uploaded by the main thread.
+ * Meshes referenced by several nodes are converted with the transform of the last one.
+ */
+typedef struct {
+    const struct aiMesh* aiMesh;
+    Matrix transform;
+    bool referenced;                    // False for meshes no node references, they stay empty
+    bool valid;                         // Set once the conversion succeeded
+    R3D_MeshData data;
+    BoundingBox aabb;
+    uint32_t* lodIndices;               // Indices of all the levels, one after the other
+    int lodCounts[R3D_MESH_MAX_LODS];
+    int numLods;
+    atomic_bool ready;                  // Set once the job is done, whatever its result
+} mesh_job_t;
+
+typedef struct r3d_importer_mesh_batch {
+    mesh_job_t* jobs;                   // One job per mesh of the scene
+    int totalJobs;
+    int lodCount;
+    atomic_int nextJob;
+    thrd_t* threads;
+    int numThreads;
+    int nextUpload;                     // Only used by the uploading thread
+    bool failed;
+} loader_context_t;
+
+// ========================================
+// LOD GENERATION (INTERNAL)
 // ========================================
 
-static bool load_mesh_internal(
-    R3D_Mesh* outMesh,
-    const struct aiMesh* aiMesh,
-    Matrix transform,
-    bool hasBones)
+static void generate_mesh_lods(mesh_job_t* job, int lodCount)
 {
-    // Validate input
+    const R3D_MeshData* data = &job->data;
+
+    if (data->indexCount < LOD_MIN_INDEX_COUNT) {
+        return;
+    }
+
+    if (lodCount > R3D_MESH_MAX_LODS) {
+        lodCount = R3D_MESH_MAX_LODS;
+    }
+
+    // Each level is at most as large as the whole mesh
+    job->lodIndices = RL_MALLOC((size_t)lodCount * data->indexCount * sizeof(uint32_t));
+    if (!job->lodIndices) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate LOD indices; The mesh will be loaded without levels of detail");
+        return;
+    }
+
+    // Each level is simplified from the previous one
+    R3D_MeshData level = *data;
+    uint32_t* indices = job->lodIndices;
+
+    for (int i = 0; i < lodCount; i++) {
+        int targetCount = (level.indexCount / 6) * 3;
+        int count = R3D_SimplifyMeshData(&level, indices, targetCount, LOD_TARGET_ERROR, NULL);
+        if (count == 0 || count > level.indexCount * LOD_MIN_REDUCTION) {
+            break;
+        }
+        job->lodCounts[job->numLods++] = count;
+        level.indices = indices;
+        level.indexCount = count;
+        indices += count;
+    }
+}
+
+// ========================================
+// MESH CONVERSION (INTERNAL)
+// ========================================
+
+static bool convert_mesh(mesh_job_t* job, int lodCount)
+{
+    const struct aiMesh* aiMesh = job->aiMesh;
+
     if (!aiMesh) {
         TraceLog(LOG_ERROR, "R3D: Invalid parameters during assimp mesh processing");
         return false;
@@ -239,6 +316,8 @@ static bool load_mesh_internal(
         return false;
     }
 
+    bool hasBones = aiMesh->mNumBones > 0;
+
     // Allocate mesh data
     int vertexCount = aiMesh->mNumVertices;
     int indexCount = 3 * aiMesh->mNumFaces;
@@ -257,13 +336,13 @@ static bool load_mesh_internal(
     // Pre-compute normal matrix for non-bone meshes
     Matrix normalMatrix = {0};
     if (!hasBones) {
-        normalMatrix = r3d_matrix_normal(&transform);
+        normalMatrix = r3d_matrix_normal(&job->transform);
     }
 
     // Process all vertex attributes
     for (int i = 0; i < vertexCount; i++) {
         R3D_Vertex* vertex = &data.vertices[i];
-        process_vertex_position(&vertex->position, &aiMesh->mVertices[i], &transform, hasBones, &aabb);
+        process_vertex_position(&vertex->position, &aiMesh->mVertices[i], &job->transform, hasBones, &aabb);
         process_vertex_texcoord(&vertex->texcoord, aiMesh, i);
         process_vertex_normal(&vertex->normal, aiMesh, i, &normalMatrix, hasBones);
         process_vertex_tangent(vertex, aiMesh, i, &normalMatrix, hasBones);
@@ -273,60 +352,118 @@ static bool load_mesh_internal(
     // Process indices
     process_indices(aiMesh, &data);
 
+    // Assimp leaves the tangents out when it fails to compute them, e.g. on degenerate UVs
+    if (aiMesh->mTextureCoords[0] && !aiMesh->mTangents) {
+        R3D_GenMeshDataTangents(&data);
+    }
+
     // Process bone data
     if (!process_bones(aiMesh, &data, vertexCount)) {
         R3D_UnloadMeshData(&data);
         return false;
     }
 
-    // Upload the mesh
-    *outMesh = R3D_LoadMesh(R3D_PRIMITIVE_TRIANGLES, &data, &aabb, R3D_STATIC_MESH);
-    R3D_UnloadMeshData(&data);
+    // Reorder for the vertex cache, overdraw and vertex fetch
+    R3D_OptimizeMeshData(&data);
+
+    job->data = data;
+    job->aabb = aabb;
+
+    // Simplify the levels of detail from the optimized data
+    if (lodCount > 0) {
+        generate_mesh_lods(job, lodCount);
+    }
+
+    return true;
+}
+
+// Converts the next pending mesh, returns false once all of them have been claimed
+static bool run_next_job(loader_context_t* ctx)
+{
+    int jobIndex = atomic_fetch_add(&ctx->nextJob, 1);
+    if (jobIndex >= ctx->totalJobs) {
+        return false;
+    }
+
+    mesh_job_t* job = &ctx->jobs[jobIndex];
+    if (job->referenced) {
+        job->valid = convert_mesh(job, ctx->lodCount);
+    }
+
+    atomic_store(&job->ready, true);
 
     return true;
 }
 
+static int worker_thread(void* arg)
+{
+    loader_context_t* ctx = (loader_context_t*)arg;
+    r3d_cpu_set_worker(true);
+    while (run_next_job(ctx)) { }
+    return 0;
+}
+
+// ========================================
+// MESH UPLOAD (INTERNAL)
+// ========================================
+
+static void upload_mesh(R3D_Mesh* outMesh, const mesh_job_t* job, R3D_VertexFormat format)
+{
+    *outMesh = R3D_LoadMeshEx(R3D_PRIMITIVE_TRIANGLES, &job->data, &job->aabb, R3D_STATIC_MESH, format);
+
+    const uint32_t* indices = job->lodIndices;
+    float screenSize = LOD_FIRST_SCREEN_SIZE;
+
+    for (int i = 0; i < job->numLods; i++) {
+        if (!R3D_AddMeshLod(outMesh, indices, job->lodCounts[i], screenSize)) {
+            break;
+        }
+        indices += job->lodCounts[i];
+        screenSize *= 0.5f;
+    }
+}
+
+static void release_job(mesh_job_t* job)
+{
+    R3D_UnloadMeshData(&job->data);
+    if (job->lodIndices) {
+        RL_FREE(job->lodIndices);
+        job->lodIndices = NULL;
+    }
+}
+
 // ========================================
-// RECURSIVE LOADING
+// RECURSIVE TRAVERSAL
 // ========================================
 
-static bool load_recursive(const r3d_importer_t* importer, R3D_Model* model, const struct aiNode* node, const Matrix* parentTransform)
+static void collect_recursive(const r3d_importer_t* importer, mesh_job_t* jobs, const struct aiNode* node, const Matrix* parentTransform)
 {
     Matrix localTransform = r3d_importer_cast(node->mTransformation);
     Matrix globalTransform = r3d_matrix_multiply(&localTransform, parentTransform);
 
-    // Process all meshes in this node
+    // Record the transform of all meshes in this node
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
         uint32_t meshIndex = node->mMeshes[i];
-        const struct aiMesh* mesh = r3d_importer_get_mesh(importer, meshIndex);
-
-        if (!load_mesh_internal(&model->meshes[meshIndex], mesh, globalTransform, mesh->mNumBones > 0)) {
-            TraceLog(LOG_ERROR, "R3D: Unable to load mesh [%u]; The model will be invalid", meshIndex);
-            return false;
-        }
-
-        model->meshMaterials[meshIndex] = mesh->mMaterialIndex;
+        jobs[meshIndex].aiMesh = r3d_importer_get_mesh(importer, meshIndex);
+        jobs[meshIndex].transform = globalTransform;
+        jobs[meshIndex].referenced = true;
     }
 
     // Process all children recursively
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
-        if (!load_recursive(importer, model, node->mChildren[i], &globalTransform)) {
-            return false;
-        }
+        collect_recursive(importer, jobs, node->mChildren[i], &globalTransform);
     }
-
-    return true;
 }
 
 // ========================================
 // PUBLIC FUNCTIONS
 // ========================================
 
-bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model)
+r3d_importer_mesh_batch_t* r3d_importer_begin_meshes(const r3d_importer_t* importer, R3D_Model* model, int lodCount)
 {
     if (!model || !importer || !r3d_importer_is_valid(importer)) {
         TraceLog(LOG_ERROR, "R3D: Invalid parameters for mesh loading");
-        return false;
+        return NULL;
     }
 
     const struct aiScene* scene = r3d_importer_get_scene(importer);
@@ -335,20 +472,130 @@ bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model)
     model->meshes = RL_CALLOC(model->meshCount, sizeof(R3D_Mesh));
     model->meshMaterials = RL_CALLOC(model->meshCount, sizeof(int));
 
-    if (!model->meshes || !model->meshMaterials) {
+    // Setup conversion context
+    loader_context_t* ctx = RL_CALLOC(1, sizeof(loader_context_t));
+    if (ctx) {
+        ctx->jobs = RL_CALLOC(model->meshCount, sizeof(mesh_job_t));
+        ctx->totalJobs = model->meshCount;
+        ctx->lodCount = lodCount;
+        atomic_init(&ctx->nextJob, 0);
+    }
+
+    if (!model->meshes || !model->meshMaterials || !ctx || !ctx->jobs) {
         TraceLog(LOG_ERROR, "R3D: Unable to allocate memory for meshes");
         if (model->meshMaterials) RL_FREE(model->meshMaterials);
         if (model->meshes) RL_FREE(model->meshes);
+        if (ctx) RL_FREE(ctx->jobs);
+        RL_FREE(ctx);
+        model->meshMaterials = NULL;
+        model->meshes = NULL;
+        model->meshCount = 0;
+        return NULL;
+    }
+
+    for (int i = 0; i < ctx->totalJobs; i++) {
+        atomic_init(&ctx->jobs[i].ready, false);
+    }
+
+    collect_recursive(importer, ctx->jobs, r3d_importer_get_root(importer), &R3D_MATRIX_IDENTITY);
+
+    // Determine thread count, the calling thread converts too when it would wait
+    int numThreads = r3d_cpu_count() - 1;
+    if (numThreads > ctx->totalJobs - 1) {
+        numThreads = ctx->totalJobs - 1;
+    }
+
+    if (numThreads > 0 && (ctx->threads = RL_MALLOC(numThreads * sizeof(thrd_t))) != NULL) {
+        for (int i = 0; i < numThreads; i++) {
+            if (thrd_create(&ctx->threads[ctx->numThreads], worker_thread, ctx) == thrd_success) {
+                ctx->numThreads++;
+            }
+        }
+    }
+
+    TraceLog(LOG_INFO, "R3D: Converting %d meshes with %d worker threads", ctx->totalJobs, ctx->numThreads + 1);
+
+    return ctx;
+}
+
+void r3d_importer_convert_meshes(r3d_importer_mesh_batch_t* batch)
+{
+    // The meshes are already converted in parallel, their tangent frames are generated serially
+    r3d_cpu_set_worker(batch->numThreads > 0);
+    while (run_next_job(batch)) { }
+    r3d_cpu_set_worker(false);
+
+    for (int i = 0; i < batch->numThreads; i++) {
+        thrd_join(batch->threads[i], NULL);
+    }
+    batch->numThreads = 0;
+}
+
+bool r3d_importer_upload_next_mesh(r3d_importer_mesh_batch_t* batch, R3D_Model* model, R3D_VertexFormat format)
+{
+    if (batch->nextUpload >= batch->totalJobs) {
         return false;
     }
 
-    // Load all meshes recursively
-    if (!load_recursive(importer, model, r3d_importer_get_root(importer), &R3D_MATRIX_IDENTITY)) {
+    // The meshes are uploaded in order, as they become ready
+    int index = batch->nextUpload++;
+    mesh_job_t* job = &batch->jobs[index];
+
+    while (!atomic_load(&job->ready)) {
+        if (!run_next_job(batch)) thrd_yield();
+    }
+
+    if (!job->referenced) {
+        return true;
+    }
+
+    if (!batch->failed && job->valid) {
+        upload_mesh(&model->meshes[index], job, format);
+        model->meshMaterials[index] = job->aiMesh->mMaterialIndex;
+    }
+    else if (!batch->failed) {
+        TraceLog(LOG_ERROR, "R3D: Unable to load mesh [%d]; The model will be invalid", index);
+        batch->failed = true;
+    }
+
+    release_job(job);
+
+    return true;
+}
+
+int r3d_importer_get_pending_mesh_count(const r3d_importer_mesh_batch_t* batch)
+{
+    return batch->totalJobs - batch->nextUpload;
+}
+
+bool r3d_importer_end_meshes(r3d_importer_mesh_batch_t* batch, R3D_Model* model)
+{
+    // Jobs not claimed yet are dropped, the workers only finish their current one
+    atomic_store(&batch->nextJob, batch->totalJobs);
+
+    for (int i = 0; i < batch->numThreads; i++) {
+        thrd_join(batch->threads[i], NULL);
+    }
+
+    // Releases the conversions of the meshes that were not uploaded
+    bool success = !batch->failed && (batch->nextUpload >= batch->totalJobs);
+    for (int i = batch->nextUpload; i < batch->totalJobs; i++) {
+        release_job(&batch->jobs[i]);
+    }
+
+    if (batch->threads) RL_FREE(batch->threads);
+    RL_FREE(batch->jobs);
+    RL_FREE(batch);
+
+    if (!success) {
         for (int i = 0; i < model->meshCount; i++) {
             R3D_UnloadMesh(&model->meshes[i]);
         }
         RL_FREE(model->meshMaterials);
         RL_FREE(model->meshes);
+        model->meshMaterials = NULL;
+        model->meshes = NULL;
+        model->meshCount = 0;
         return false;
     }
 
@@ -362,3 +609,14 @@ bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model)
 
     return true;
 }
+
+bool r3d_importer_load_meshes(const r3d_importer_t* importer, R3D_Model* model, int lodCount, R3D_VertexFormat format)
+{
+    r3d_importer_mesh_batch_t* batch = r3d_importer_begin_meshes(importer, model, lodCount);
+    if (batch == NULL) return false;
+
+    // Upload the meshes in order on the main thread, as they become ready
+    while (r3d_importer_upload_next_mesh(batch, model, format)) { }
+
+    return r3d_importer_end_meshes(batch, model);
+}
@@ -14,6 +14,7 @@
 #include <glad.h>
 
 #include "../details/r3d_math.h"
+#include "../modules/r3d_skin.h"
 
 // ========================================
 // INTERNAL CONTEXT
@@ -66,18 +67,19 @@ static void build_skeleton_recursive(
 }
 
 // ========================================
-// BIND POSE TEXTURE UPLOAD
+// BIND POSE UPLOAD
 // ========================================
 
-static void upload_skeleton_bind_pose(R3D_Skeleton* skeleton)
+static bool upload_skeleton_bind_pose(R3D_Skeleton* skeleton)
 {
-    glGenTextures(1, &skeleton->texBindPose);
-    glBindTexture(GL_TEXTURE_1D, skeleton->texBindPose);
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA32F, 4 * skeleton->boneCount, 0, GL_RGBA, GL_FLOAT, skeleton->bindPose);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_1D, 0);
+    skeleton->bindPoseOffset = r3d_skin_alloc(skeleton->boneCount);
+    if (skeleton->bindPoseOffset < 0) {
+        return false;
+    }
+
+    r3d_skin_write(skeleton->bindPoseOffset, skeleton->bindPose, skeleton->boneCount);
+
+    return true;
 }
 
 // ========================================
@@ -144,7 +146,16 @@ bool r3d_importer_load_skeleton(const r3d_importer_t* importer, R3D_Skeleton* sk
     };
 
     build_skeleton_recursive(&ctx, r3d_importer_get_root(importer), -1, R3D_MATRIX_IDENTITY);
-    upload_skeleton_bind_pose(skeleton);
+
+    if (!upload_skeleton_bind_pose(skeleton)) {
+        TraceLog(LOG_ERROR, "RENDER: Failed to upload the bind pose of the skeleton");
+        RL_FREE(skeleton->bones);
+        RL_FREE(skeleton->boneOffsets);
+        RL_FREE(skeleton->bindLocal);
+        RL_FREE(skeleton->bindPose);
+        skeleton->boneCount = 0;
+        return false;
+    }
 
     TraceLog(LOG_INFO, "RENDER: Loaded skeleton with %d bones", boneCount);
 
@@ -12,24 +12,16 @@
 #include <assimp/material.h>
 #include <assimp/texture.h>
 
-#ifdef _WIN32
-#   define NOGDI
-#   define NOUSER
-#   define WIN32_LEAN_AND_MEAN
-#   include <windows.h>
-#   undef near
-#   undef far
-#elif defined(__linux__) || defined(__APPLE__)
-#   include <unistd.h>
-#else
-#   error "Oops, platform not supported by R3D"
-#endif
-
 #include <tinycthread.h>
 #include <stdatomic.h>
 #include <stdlib.h>
+#include <string.h>
+#include <rlgl.h>
+#include <glad.h>
 
+#include "../modules/r3d_texture.h"
 #include "../details/r3d_image.h"
+#include "../details/r3d_cpu.h"
 
 // ========================================
 // INTERNAL STRUCTURES
@@ -39,6 +31,9 @@ typedef struct {
     enum aiTextureMapMode wrap[2];
     Image image;
     bool owned;
+    bool normalXY;                      // Normal map stored in alpha and green, see R3D_IMAGE_CODEC_DXT5_NORMAL
+    uint64_t key;                       // Key of the sources in the shared textures, 0 without source
+    bool shared;                        // Already loaded by another model, nothing to decode
 } loaded_image_t;
 
 typedef struct {
@@ -46,10 +41,12 @@ typedef struct {
     bool used;
 } loaded_material_t;
 
-struct r3d_importer_texture_cache {
-    loaded_material_t* materials;
-    int materialCount;
-};
+#define UPLOAD_BUFFER_COUNT 4
+
+typedef struct {
+    GLuint buffers[UPLOAD_BUFFER_COUNT];    // Created on the first upload
+    int next;
+} upload_pool_t;
 
 typedef struct {
     const r3d_importer_t* importer;
@@ -57,64 +54,169 @@ typedef struct {
     int materialCount;
     atomic_int nextJob;
     int totalJobs;
+    bool compress;                      // Compress the uncompressed images on the worker threads
+    bool mipmaps;                       // Generate the mipmaps on the worker threads
+    bool stream;                        // Upload the finer levels of the large textures on demand
 
-    // Ring buffer for ready jobs
+    // Ring buffer for ready jobs, the uploading thread sleeps on 'readyCond' while it is empty
     int* readyJobs;                     // Array of job indices
     int readyCapacity;
-    atomic_int readyHead;               // Write position
-    atomic_int readyTail;               // Read position
-    atomic_bool allJobsSubmitted;
+    int readyHead;                      // Write position, guarded by 'readyLock'
+    int readyTail;                      // Read position, only used by the uploading thread
+    mtx_t readyLock;
+    cnd_t readyCond;
+
+    // Upload state, only used by the uploading thread
+    thrd_t* threads;
+    int numThreads;
+    upload_pool_t uploadPool;
+    TextureFilter filter;
+    int processedCount;                 // Jobs popped from the ring buffer
+    int uploadedCount;                  // Textures actually created
 } loader_context_t;
 
+struct r3d_importer_texture_cache {
+    loaded_material_t* materials;
+    int materialCount;
+    loader_context_t* loader;           // Loading state, NULL once the loading ended
+};
+
 // ========================================
-// GLOBAL CACHE
+// RING BUFFER HELPERS
 // ========================================
 
-static int g_numCPUs = 0;
-
-static int get_cpu_count(void)
+static void ring_push(loader_context_t* ctx, int jobIndex)
 {
-    if (g_numCPUs > 0) return g_numCPUs;
-
-    #ifdef _WIN32
-        SYSTEM_INFO sysinfo;
-        GetSystemInfo(&sysinfo);
-        g_numCPUs = sysinfo.dwNumberOfProcessors;
-    #elif defined(__linux__) || defined(__APPLE__)
-        g_numCPUs = sysconf(_SC_NPROCESSORS_ONLN);
-    #endif
+    mtx_lock(&ctx->readyLock);
+    ctx->readyJobs[ctx->readyHead % ctx->readyCapacity] = jobIndex;
+    ctx->readyHead++;
+    cnd_signal(&ctx->readyCond);
+    mtx_unlock(&ctx->readyLock);
+}
 
-    if (g_numCPUs < 1) {
-        TraceLog(LOG_WARNING, "R3D: Failed to detect CPU count, defaulting to 1 thread");
-        g_numCPUs = 1;
+static bool ring_pop(loader_context_t* ctx, int* jobIndex, bool wait)
+{
+    mtx_lock(&ctx->readyLock);
+    while (wait && ctx->readyTail >= ctx->readyHead) {
+        cnd_wait(&ctx->readyCond, &ctx->readyLock);
     }
+    bool ready = (ctx->readyTail < ctx->readyHead);
+    if (ready) {
+        *jobIndex = ctx->readyJobs[ctx->readyTail % ctx->readyCapacity];
+        ctx->readyTail++;
+    }
+    mtx_unlock(&ctx->readyLock);
 
-    return g_numCPUs;
+    return ready;
 }
 
 // ========================================
-// RING BUFFER HELPERS
+// PIXEL BUFFER UPLOADS
 // ========================================
 
-static void ring_push(loader_context_t* ctx, int jobIndex)
+// Same swizzles as raylib for the single and dual channel formats, applied to the bound texture
+static void setup_gray_swizzle(int format)
 {
-    int head = atomic_load(&ctx->readyHead);
-    ctx->readyJobs[head % ctx->readyCapacity] = jobIndex;
-    atomic_store(&ctx->readyHead, head + 1);
+    if (format == PIXELFORMAT_UNCOMPRESSED_GRAYSCALE) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    else if (format == PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
 }
 
-static bool ring_pop(loader_context_t* ctx, int* jobIndex)
+static Texture2D upload_texture(upload_pool_t* pool, const Image* image)
 {
-    int tail = atomic_load(&ctx->readyTail);
-    int head = atomic_load(&ctx->readyHead);
-    
-    if (tail >= head) {
-        return false;
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    if (image->format < PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        rlGetGlTextureFormats(image->format, &glInternalFormat, &glFormat, &glType);
     }
-    
-    *jobIndex = ctx->readyJobs[tail % ctx->readyCapacity];
-    atomic_store(&ctx->readyTail, tail + 1);
-    return true;
+
+    // Compressed images are small enough to go through raylib, along with their mipmaps
+    if (glInternalFormat == 0) {
+        return LoadTextureFromImage(*image);
+    }
+
+    size_t size = 0;
+    for (int i = 0, w = image->width, h = image->height; i < image->mipmaps; i++) {
+        size += GetPixelDataSize(w, h, image->format);
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+
+    if (pool->buffers[0] == 0) {
+        glGenBuffers(UPLOAD_BUFFER_COUNT, pool->buffers);
+    }
+
+    GLuint pbo = pool->buffers[pool->next];
+    pool->next = (pool->next + 1) % UPLOAD_BUFFER_COUNT;
+
+    // Orphaning gives a fresh storage, the transfers of the previous uses can still be in flight
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+
+    void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst == NULL) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return LoadTextureFromImage(*image);
+    }
+
+    memcpy(dst, image->data, size);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    Texture2D texture = {
+        .width = image->width,
+        .height = image->height,
+        .mipmaps = image->mipmaps,
+        .format = image->format
+    };
+
+    glGenTextures(1, &texture.id);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+
+    // The rows of the small levels are not aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // The copies from the buffer are done by the driver, the calls return without waiting for them
+    size_t offset = 0;
+    for (int i = 0, w = image->width, h = image->height; i < image->mipmaps; i++) {
+        glTexImage2D(GL_TEXTURE_2D, i, glInternalFormat, w, h, 0, glFormat, glType, (const void*)offset);
+        offset += GetPixelDataSize(w, h, image->format);
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+    }
+
+    // NOTE: Single level textures may still get their mipmaps from the GPU
+    if (image->mipmaps > 1) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image->mipmaps - 1);
+    }
+
+    setup_gray_swizzle(image->format);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return texture;
+}
+
+// Only the coarse levels are uploaded, the texture module keeps the image to stream the others
+static Texture2D upload_streamed_texture(loaded_image_t* image)
+{
+    Texture2D texture = r3d_texture_load_streamed(image->image);
+    if (texture.id == 0) {
+        return texture;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    setup_gray_swizzle(texture.format);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    image->owned = false;
+    image->image.data = NULL;
+
+    return texture;
 }
 
 // ========================================
@@ -248,6 +350,23 @@ static bool load_image_orm(
         return false;
     }
 
+    // Compressed sources cannot be sampled, the channels packed into the ORM map are lost
+    loaded_image_t* channels[3] = { &imOcclusion, &imRoughness, &imMetalness };
+    bool* loaded[3] = { &retOcclusion, &retRoughness, &retMetalness };
+    for (int i = 0; i < 3; i++) {
+        if (*loaded[i] && channels[i]->image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+            TraceLog(LOG_WARNING, "R3D: Compressed occlusion, roughness or metalness maps cannot be packed; The map is ignored");
+            *loaded[i] = false;
+        }
+    }
+
+    if (!retOcclusion && !retRoughness && !retMetalness) {
+        if (imOcclusion.owned) UnloadImage(imOcclusion.image);
+        if (imRoughness.owned) UnloadImage(imRoughness.image);
+        if (imMetalness.owned && imMetalness.image.data != imRoughness.image.data) UnloadImage(imMetalness.image);
+        return false;
+    }
+
     // Compose ORM map
     const Image* sources[3] = {
         retOcclusion ? &imOcclusion.image : NULL,
@@ -311,6 +430,147 @@ static bool load_image_for_map(
     }
 }
 
+// ========================================
+// SHARED TEXTURE KEYS
+// ========================================
+
+#define MAX_MAP_SOURCES 6
+
+// Every texture of the material that can contribute to a map, see 'load_image_for_map()'
+static const enum aiTextureType MAP_SOURCES[R3D_MAP_COUNT][MAX_MAP_SOURCES] = {
+    [R3D_MAP_ALBEDO] = { aiTextureType_BASE_COLOR, aiTextureType_DIFFUSE },
+    [R3D_MAP_EMISSION] = { aiTextureType_EMISSIVE },
+    [R3D_MAP_ORM] = {
+        aiTextureType_AMBIENT_OCCLUSION, aiTextureType_LIGHTMAP,
+        aiTextureType_DIFFUSE_ROUGHNESS, aiTextureType_SHININESS,
+        aiTextureType_METALNESS, aiTextureType_UNKNOWN  // glTF metallic-roughness
+    },
+    [R3D_MAP_NORMAL] = { aiTextureType_NORMALS },
+};
+
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    // FNV-1a
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t compute_texture_key(
+    const r3d_importer_t* importer,
+    const struct aiMaterial* material,
+    r3d_importer_texture_map_t map,
+    const loader_context_t* ctx)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    bool hasSource = false;
+
+    // The same settings are needed to reuse a texture
+    int settings[3] = { map, ctx->compress, ctx->filter };
+    hash = hash_bytes(hash, settings, sizeof(settings));
+
+    for (int i = 0; i < MAX_MAP_SOURCES; i++) {
+        enum aiTextureType type = MAP_SOURCES[map][i];
+        if (type == aiTextureType_NONE) break;
+
+        struct aiString path = {0};
+        enum aiTextureMapMode wrap[2] = {0};
+        if (aiGetMaterialTexture(material, type, 0, &path, NULL, NULL, NULL, NULL, wrap, NULL) != AI_SUCCESS) {
+            continue;
+        }
+
+        hash = hash_bytes(hash, &type, sizeof(type));
+        hash = hash_bytes(hash, wrap, sizeof(wrap));
+
+        // Embedded textures are identified by their content, the files by their path
+        if (path.data[0] == '*') {
+            const struct aiTexture* aiTex = r3d_importer_get_texture(importer, atoi(&path.data[1]));
+            size_t size = (aiTex->mHeight == 0) ? aiTex->mWidth : (size_t)aiTex->mWidth * aiTex->mHeight * sizeof(struct aiTexel);
+            hash = hash_bytes(hash, &aiTex->mHeight, sizeof(aiTex->mHeight));
+            hash = hash_bytes(hash, aiTex->pcData, size);
+        }
+        else {
+            hash = hash_bytes(hash, path.data, path.length);
+        }
+
+        hasSource = true;
+    }
+
+    // Zero is kept for the maps without texture
+    return (hasSource && hash != 0) ? hash : 0;
+}
+
+// ========================================
+// COMPRESSION HELPERS
+// ========================================
+
+static void compress_image(loaded_image_t* image, r3d_importer_texture_map_t map, bool mipmaps)
+{
+    // Images loaded from DDS or KTX files may already be compressed
+    if (image->image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        return;
+    }
+
+    r3d_image_codec_e codec = R3D_IMAGE_CODEC_DXT1;
+    if (map == R3D_MAP_ALBEDO) codec = R3D_IMAGE_CODEC_DXT5;
+    else if (map == R3D_MAP_NORMAL) codec = R3D_IMAGE_CODEC_DXT5_NORMAL;
+
+    Image compressed = r3d_image_compress(&image->image, codec, mipmaps);
+    if (compressed.data == NULL) {
+        return;
+    }
+
+    if (image->owned) {
+        UnloadImage(image->image);
+    }
+
+    image->image = compressed;
+    image->owned = true;
+    image->normalXY = (codec == R3D_IMAGE_CODEC_DXT5_NORMAL);
+}
+
+static void setup_compressed_texture(const Texture2D* texture, bool normalXY)
+{
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+
+    // The mipmap chain of the compressed images stops before the blocks become partial
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture->mipmaps - 1);
+
+    // The shaders reconstruct Z from the red and green channels
+    if (normalXY) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_ALPHA);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_GREEN);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_ZERO);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, GL_ONE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// ========================================
+// MIPMAP HELPERS
+// ========================================
+
+static void gen_image_mipmaps(loaded_image_t* image, r3d_importer_texture_map_t map)
+{
+    // Color maps are sRGB encoded, the mipmaps are filtered in linear space
+    bool srgb = (map == R3D_MAP_ALBEDO || map == R3D_MAP_EMISSION);
+
+    Image mipmapped = r3d_image_gen_mipmaps(&image->image, srgb);
+    if (mipmapped.data == NULL) {
+        return;
+    }
+
+    if (image->owned) {
+        UnloadImage(image->image);
+    }
+
+    image->image = mipmapped;
+    image->owned = true;
+}
+
 // ========================================
 // WORKER THREAD
 // ========================================
@@ -333,8 +593,22 @@ static int worker_thread(void* arg)
         const struct aiMaterial* material = r3d_importer_get_material(ctx->importer, materialIdx);
         loaded_image_t* image = &ctx->images[jobIndex];
 
+        if (image->shared) {
+            ring_push(ctx, jobIndex);
+            continue;
+        }
+
         load_image_for_map(image, ctx->importer, material, (r3d_importer_texture_map_t)mapIdx);
 
+        if (ctx->compress && image->image.data != NULL) {
+            compress_image(image, (r3d_importer_texture_map_t)mapIdx, ctx->mipmaps);
+        }
+
+        // The compressed images already have their mipmaps
+        if (ctx->mipmaps && image->image.data != NULL && image->image.format < PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+            gen_image_mipmaps(image, (r3d_importer_texture_map_t)mapIdx);
+        }
+
         // Push to ready queue
         ring_push(ctx, jobIndex);
     }
@@ -346,7 +620,7 @@ static int worker_thread(void* arg)
 // PUBLIC FUNCTIONS
 // ========================================
 
-r3d_importer_texture_cache_t* r3d_importer_load_texture_cache(const r3d_importer_t* importer, TextureFilter filter)
+r3d_importer_texture_cache_t* r3d_importer_begin_texture_cache(const r3d_importer_t* importer, TextureFilter filter, bool compress, bool stream)
 {
     if (!importer || !r3d_importer_is_valid(importer)) {
         TraceLog(LOG_ERROR, "R3D: Invalid importer for texture loading");
@@ -354,94 +628,188 @@ r3d_importer_texture_cache_t* r3d_importer_load_texture_cache(const r3d_importer
     }
 
     // Allocate cache
-    r3d_importer_texture_cache_t* cache = RL_MALLOC(sizeof(r3d_importer_texture_cache_t));
+    r3d_importer_texture_cache_t* cache = RL_CALLOC(1, sizeof(r3d_importer_texture_cache_t));
+    loader_context_t* ctx = RL_CALLOC(1, sizeof(loader_context_t));
+    if (!cache || !ctx) {
+        RL_FREE(cache);
+        RL_FREE(ctx);
+        return NULL;
+    }
+
     cache->materialCount = r3d_importer_get_material_count(importer);
     cache->materials = RL_CALLOC(cache->materialCount, sizeof(loaded_material_t));
+    cache->loader = ctx;
 
     // Setup loading context
-    loader_context_t ctx = {0};
-    ctx.importer = importer;
-    ctx.materialCount = cache->materialCount;
-    ctx.totalJobs = cache->materialCount * R3D_MAP_COUNT;
-    atomic_init(&ctx.nextJob, 0);
-    atomic_init(&ctx.allJobsSubmitted, false);
+    ctx->importer = importer;
+    ctx->materialCount = cache->materialCount;
+    ctx->totalJobs = cache->materialCount * R3D_MAP_COUNT;
+    ctx->filter = filter;
+    atomic_init(&ctx->nextJob, 0);
+
+    // S3TC is an extension, although available on virtually every desktop driver
+    ctx->compress = compress && GLAD_GL_EXT_texture_compression_s3tc;
+    ctx->mipmaps = (filter >= TEXTURE_FILTER_TRILINEAR);
+
+    // The base level is raised while the finer levels are missing, the filter must sample the mipmaps
+    ctx->stream = stream && ctx->mipmaps;
+    if (compress && !ctx->compress) {
+        TraceLog(LOG_WARNING, "R3D: S3TC texture compression is not supported; Textures are loaded uncompressed");
+    }
 
     // Allocate image storage (single flat array)
-    ctx.images = RL_CALLOC(ctx.totalJobs, sizeof(loaded_image_t));
+    ctx->images = RL_CALLOC(ctx->totalJobs, sizeof(loaded_image_t));
 
     // Allocate ring buffer for ready jobs
-    ctx.readyCapacity = ctx.totalJobs;
-    ctx.readyJobs = RL_MALLOC(ctx.readyCapacity * sizeof(int));
-    atomic_init(&ctx.readyHead, 0);
-    atomic_init(&ctx.readyTail, 0);
+    ctx->readyCapacity = ctx->totalJobs;
+    ctx->readyJobs = RL_MALLOC(ctx->readyCapacity * sizeof(int));
+    mtx_init(&ctx->readyLock, mtx_plain);
+    cnd_init(&ctx->readyCond);
+
+    // Textures already loaded by other models are referenced instead of being decoded again
+    int sharedCount = 0;
+    for (int i = 0; i < ctx->totalJobs; i++) {
+        int materialIdx = i / R3D_MAP_COUNT;
+        int mapIdx = i % R3D_MAP_COUNT;
+
+        const struct aiMaterial* material = r3d_importer_get_material(importer, materialIdx);
+        loaded_image_t* image = &ctx->images[i];
+
+        image->key = compute_texture_key(importer, material, (r3d_importer_texture_map_t)mapIdx, ctx);
+        if (image->key != 0 && r3d_texture_acquire_shared(image->key, &cache->materials[materialIdx].textures[mapIdx])) {
+            image->shared = true;
+            sharedCount++;
+        }
+    }
+
+    if (sharedCount > 0) {
+        TraceLog(LOG_INFO, "R3D: Reusing %d textures already loaded", sharedCount);
+    }
 
     // Determine thread count
-    int numThreads = get_cpu_count();
-    if (numThreads > ctx.totalJobs) {
-        numThreads = ctx.totalJobs;
+    int numThreads = r3d_cpu_count();
+    if (numThreads > ctx->totalJobs) {
+        numThreads = ctx->totalJobs;
     }
 
     TraceLog(LOG_INFO, "R3D: Loading textures with %d worker threads", numThreads);
 
     // Launch worker threads
-    thrd_t* threads = RL_MALLOC(numThreads * sizeof(thrd_t));
+    ctx->threads = RL_MALLOC(numThreads * sizeof(thrd_t));
     for (int i = 0; i < numThreads; i++) {
-        thrd_create(&threads[i], worker_thread, &ctx);
+        thrd_create(&ctx->threads[i], worker_thread, ctx);
     }
+    ctx->numThreads = numThreads;
 
-    // Progressive upload loop on main thread
-    int uploadedCount = 0;
-    bool generateMipmaps = (filter >= TEXTURE_FILTER_TRILINEAR);
-
-    while (uploadedCount < ctx.totalJobs) {
-        int jobIndex;
-
-        // Try to get a ready job from ring buffer
-        if (ring_pop(&ctx, &jobIndex)) {
-            int materialIdx = jobIndex / R3D_MAP_COUNT;
-            int mapIdx = jobIndex % R3D_MAP_COUNT;
-
-            loaded_image_t* img = &ctx.images[jobIndex];
-
-            // Upload texture to GPU
-            if (img->image.data) {
-                Texture2D* texture = &cache->materials[materialIdx].textures[mapIdx];
-                *texture = LoadTextureFromImage(img->image);
-
-                if (texture->id != 0) {
-                    if (generateMipmaps) {
-                        GenTextureMipmaps(texture);
-                    }
-                    SetTextureWrap(*texture, get_wrap_mode(img->wrap[0]));
-                    SetTextureFilter(*texture, filter);
-                }
-
-                // Free image data
-                if (img->owned) {
-                    UnloadImage(img->image);
-                    img->image.data = NULL;
-                }
-            }
+    return cache;
+}
+
+bool r3d_importer_upload_next_texture(r3d_importer_texture_cache_t* cache, bool wait)
+{
+    loader_context_t* ctx = cache->loader;
+    if (ctx == NULL || ctx->processedCount >= ctx->totalJobs) {
+        return false;
+    }
+
+    // Every job is pushed once, even if its image failed to load
+    int jobIndex = 0;
+    if (!ring_pop(ctx, &jobIndex, wait)) {
+        return false;
+    }
+
+    ctx->processedCount++;
+
+    int materialIdx = jobIndex / R3D_MAP_COUNT;
+    int mapIdx = jobIndex % R3D_MAP_COUNT;
 
-            uploadedCount++;
+    loaded_image_t* img = &ctx->images[jobIndex];
+    if (img->image.data == NULL) {
+        return true;
+    }
+
+    // Upload texture to GPU
+    Texture2D* texture = &cache->materials[materialIdx].textures[mapIdx];
+    *texture = (Texture2D){0};
+    if (ctx->stream && img->owned && img->image.mipmaps > 1) {
+        *texture = upload_streamed_texture(img);
+    }
+    if (texture->id == 0) {
+        *texture = upload_texture(&ctx->uploadPool, &img->image);
+    }
+
+    if (texture->id != 0) {
+        // Mipmaps are generated by the workers, only the formats they cannot filter remain
+        if (img->image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+            setup_compressed_texture(texture, img->normalXY);
         }
-        else {
-            // No job ready yet, yield CPU
-            thrd_yield();
+        else if (ctx->mipmaps && texture->mipmaps == 1) {
+            GenTextureMipmaps(texture);
+        }
+        SetTextureWrap(*texture, get_wrap_mode(img->wrap[0]));
+        SetTextureFilter(*texture, ctx->filter);
+        ctx->uploadedCount++;
+
+        if (img->key != 0) {
+            *texture = r3d_texture_share(img->key, *texture);
         }
     }
 
-    // Join threads
-    for (int i = 0; i < numThreads; i++) {
-        thrd_join(threads[i], NULL);
+    // Free image data
+    if (img->owned) {
+        UnloadImage(img->image);
+        img->image.data = NULL;
+    }
+
+    return true;
+}
+
+int r3d_importer_get_pending_texture_count(const r3d_importer_texture_cache_t* cache)
+{
+    const loader_context_t* ctx = cache->loader;
+    return (ctx != NULL) ? ctx->totalJobs - ctx->processedCount : 0;
+}
+
+void r3d_importer_end_texture_cache(r3d_importer_texture_cache_t* cache)
+{
+    loader_context_t* ctx = cache->loader;
+    if (ctx == NULL) return;
+
+    // Join threads, the images that were not uploaded are released
+    for (int i = 0; i < ctx->numThreads; i++) {
+        thrd_join(ctx->threads[i], NULL);
     }
 
+    for (int i = 0; i < ctx->totalJobs; i++) {
+        if (ctx->images[i].owned) {
+            UnloadImage(ctx->images[i].image);
+        }
+    }
+
+    if (ctx->uploadPool.buffers[0] != 0) {
+        glDeleteBuffers(UPLOAD_BUFFER_COUNT, ctx->uploadPool.buffers);
+    }
+
+    TraceLog(LOG_INFO, "R3D: Loaded %d textures successfully", ctx->uploadedCount);
+
     // Cleanup
-    RL_FREE(threads);
-    RL_FREE(ctx.readyJobs);
-    RL_FREE(ctx.images);
+    RL_FREE(ctx->threads);
+    RL_FREE(ctx->readyJobs);
+    cnd_destroy(&ctx->readyCond);
+    mtx_destroy(&ctx->readyLock);
+    RL_FREE(ctx->images);
+    RL_FREE(ctx);
+
+    cache->loader = NULL;
+}
 
-    TraceLog(LOG_INFO, "R3D: Loaded %d textures successfully", uploadedCount);
+r3d_importer_texture_cache_t* r3d_importer_load_texture_cache(const r3d_importer_t* importer, TextureFilter filter, bool compress, bool stream)
+{
+    r3d_importer_texture_cache_t* cache = r3d_importer_begin_texture_cache(importer, filter, compress, stream);
+    if (cache == NULL) return NULL;
+
+    // Progressive upload loop on main thread
+    while (r3d_importer_upload_next_texture(cache, true)) { }
+    r3d_importer_end_texture_cache(cache);
 
     return cache;
 }
@@ -450,10 +818,12 @@ void r3d_importer_unload_texture_cache(r3d_importer_texture_cache_t* cache)
 {
     if (!cache) return;
 
+    r3d_importer_end_texture_cache(cache);
+
     for (int i = 0; i < cache->materialCount; i++) {
         if (!cache->materials[i].used) {
             for (int j = 0; j < R3D_MAP_COUNT; j++) {
-                UnloadTexture(cache->materials[i].textures[j]);
+                r3d_texture_release(cache->materials[i].textures[j].id);
             }
         }
     }
@@ -0,0 +1,453 @@
+/* r3d_arena.c -- Internal R3D mesh arena module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_arena.h"
+#include "../details/r3d_vertex.h"
+#include "./r3d_state.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <glad.h>
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_arena R3D_MOD_ARENA;
+
+// ========================================
+// INTERNAL FREE LIST FUNCTIONS
+// ========================================
+
+static bool free_list_reserve(r3d_arena_free_list_t* list, int count)
+{
+    if (count <= list->capacity) {
+        return true;
+    }
+
+    int newCapacity = (list->capacity > 0) ? 2 * list->capacity : 16;
+    while (newCapacity < count) newCapacity *= 2;
+
+    void* ranges = RL_REALLOC(list->ranges, newCapacity * sizeof(*list->ranges));
+    if (ranges == NULL) return false;
+
+    list->ranges = ranges;
+    list->capacity = newCapacity;
+
+    return true;
+}
+
+static bool free_list_init(r3d_arena_free_list_t* list, int count)
+{
+    memset(list, 0, sizeof(*list));
+    if (!free_list_reserve(list, 1)) return false;
+
+    list->ranges[0] = (r3d_arena_range_t) {0, count};
+    list->numRanges = 1;
+
+    return true;
+}
+
+static void free_list_release(r3d_arena_free_list_t* list)
+{
+    RL_FREE(list->ranges);
+    memset(list, 0, sizeof(*list));
+}
+
+static int free_list_alloc(r3d_arena_free_list_t* list, int count)
+{
+    // First fit, ranges are few since freed neighbours are merged
+    for (int i = 0; i < list->numRanges; i++) {
+        r3d_arena_range_t* range = &list->ranges[i];
+        if (range->count < count) continue;
+
+        int offset = range->offset;
+        range->offset += count;
+        range->count -= count;
+
+        if (range->count == 0) {
+            memmove(range, range + 1, (list->numRanges - i - 1) * sizeof(*range));
+            list->numRanges--;
+        }
+
+        return offset;
+    }
+
+    return -1;
+}
+
+static void free_list_free(r3d_arena_free_list_t* list, int offset, int count)
+{
+    if (count <= 0) return;
+
+    int index = 0;
+    while (index < list->numRanges && list->ranges[index].offset < offset) {
+        index++;
+    }
+
+    bool mergePrev = (index > 0) && (list->ranges[index - 1].offset + list->ranges[index - 1].count == offset);
+    bool mergeNext = (index < list->numRanges) && (offset + count == list->ranges[index].offset);
+
+    if (mergePrev && mergeNext) {
+        list->ranges[index - 1].count += count + list->ranges[index].count;
+        memmove(&list->ranges[index], &list->ranges[index + 1], (list->numRanges - index - 1) * sizeof(*list->ranges));
+        list->numRanges--;
+    }
+    else if (mergePrev) {
+        list->ranges[index - 1].count += count;
+    }
+    else if (mergeNext) {
+        list->ranges[index].offset = offset;
+        list->ranges[index].count += count;
+    }
+    else {
+        if (!free_list_reserve(list, list->numRanges + 1)) {
+            TraceLog(LOG_WARNING, "R3D: Bad alloc on mesh arena free; %i elements are lost", count);
+            return;
+        }
+        memmove(&list->ranges[index + 1], &list->ranges[index], (list->numRanges - index) * sizeof(*list->ranges));
+        list->ranges[index] = (r3d_arena_range_t) {offset, count};
+        list->numRanges++;
+    }
+}
+
+// ========================================
+// INTERNAL CHUNK FUNCTIONS
+// ========================================
+
+static void setup_vertex_array(const r3d_arena_chunk_t* chunk, GLuint vao, bool depthOnly)
+{
+    r3d_state_bind_vao(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    r3d_vertex_setup_stream(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_POSITION);
+
+    if (!depthOnly) {
+        glBindBuffer(GL_ARRAY_BUFFER, chunk->attribVbo);
+        r3d_vertex_setup_stream(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS);
+    }
+
+    r3d_vertex_setup_defaults();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->ebo);
+
+    r3d_state_bind_vao(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static void chunk_release(r3d_arena_chunk_t* chunk)
+{
+    if (chunk->vao != 0) glDeleteVertexArrays(1, &chunk->vao);
+    if (chunk->depthVao != 0) glDeleteVertexArrays(1, &chunk->depthVao);
+    if (chunk->vbo != 0) glDeleteBuffers(1, &chunk->vbo);
+    if (chunk->attribVbo != 0) glDeleteBuffers(1, &chunk->attribVbo);
+    if (chunk->ebo != 0) glDeleteBuffers(1, &chunk->ebo);
+
+    free_list_release(&chunk->vertices);
+    free_list_release(&chunk->indices);
+
+    memset(chunk, 0, sizeof(*chunk));
+}
+
+static r3d_arena_chunk_t* chunk_create(void)
+{
+    if (R3D_MOD_ARENA.numChunks >= R3D_ARENA_MAX_CHUNKS) {
+        return NULL;
+    }
+
+    r3d_arena_chunk_t* chunk = &R3D_MOD_ARENA.chunks[R3D_MOD_ARENA.numChunks];
+    memset(chunk, 0, sizeof(*chunk));
+
+    if (!free_list_init(&chunk->vertices, R3D_ARENA_CHUNK_VERTICES) ||
+        !free_list_init(&chunk->indices, R3D_ARENA_CHUNK_INDICES)) {
+        chunk_release(chunk);
+        return NULL;
+    }
+
+    glGenBuffers(1, &chunk->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    glBufferData(GL_ARRAY_BUFFER, R3D_ARENA_CHUNK_VERTICES * r3d_vertex_stride(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_POSITION), NULL, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &chunk->attribVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->attribVbo);
+    glBufferData(GL_ARRAY_BUFFER, R3D_ARENA_CHUNK_VERTICES * r3d_vertex_stride(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS), NULL, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &chunk->ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, R3D_ARENA_CHUNK_INDICES * sizeof(uint32_t), NULL, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glGenVertexArrays(1, &chunk->vao);
+    glGenVertexArrays(1, &chunk->depthVao);
+    setup_vertex_array(chunk, chunk->vao, false);
+    setup_vertex_array(chunk, chunk->depthVao, true);
+
+    R3D_MOD_ARENA.numChunks++;
+
+    return chunk;
+}
+
+static r3d_arena_chunk_t* chunk_find(uint32_t vao)
+{
+    if (vao == 0) return NULL;
+
+    for (int i = 0; i < R3D_MOD_ARENA.numChunks; i++) {
+        if (R3D_MOD_ARENA.chunks[i].vao == vao) {
+            return &R3D_MOD_ARENA.chunks[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool chunk_alloc(r3d_arena_chunk_t* chunk, int vertexCount, int indexCount, int* baseVertex, int* firstIndex)
+{
+    int vertexOffset = free_list_alloc(&chunk->vertices, vertexCount);
+    if (vertexOffset < 0) return false;
+
+    int indexOffset = free_list_alloc(&chunk->indices, indexCount);
+    if (indexOffset < 0) {
+        free_list_free(&chunk->vertices, vertexOffset, vertexCount);
+        return false;
+    }
+
+    *baseVertex = vertexOffset;
+    *firstIndex = indexOffset;
+
+    return true;
+}
+
+static void chunk_upload_indices(const r3d_arena_chunk_t* chunk, int firstIndex, const uint32_t* indices, int indexCount)
+{
+    // NOTE: The element buffer binding is part of the VAO state, we don't want to alter the bound VAO
+    r3d_state_bind_vao(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, chunk->ebo);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static void chunk_upload(const r3d_arena_chunk_t* chunk, int baseVertex, int firstIndex, const R3D_MeshData* data)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    r3d_vertex_upload(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_POSITION, data->vertices, data->vertexCount, baseVertex, NULL, false, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->attribVbo);
+    r3d_vertex_upload(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS, data->vertices, data->vertexCount, baseVertex, NULL, false, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunk_upload_indices(chunk, firstIndex, data->indices, data->indexCount);
+}
+
+static r3d_arena_chunk_t* chunk_find_room(int vertexCount, int indexCount, int* baseVertex, int* firstIndex)
+{
+    for (int i = 0; i < R3D_MOD_ARENA.numChunks; i++) {
+        if (chunk_alloc(&R3D_MOD_ARENA.chunks[i], vertexCount, indexCount, baseVertex, firstIndex)) {
+            return &R3D_MOD_ARENA.chunks[i];
+        }
+    }
+
+    r3d_arena_chunk_t* chunk = chunk_create();
+    if (chunk == NULL || !chunk_alloc(chunk, vertexCount, indexCount, baseVertex, firstIndex)) {
+        return NULL;
+    }
+
+    return chunk;
+}
+
+static void assign_range(R3D_Mesh* mesh, const r3d_arena_chunk_t* chunk, int baseVertex, int firstIndex,
+                         int vertexCount, int indexCount, bool hasAlpha)
+{
+    mesh->vao = chunk->vao;
+    mesh->depthVao = hasAlpha ? 0 : chunk->depthVao;
+    mesh->vbo = chunk->vbo;
+    mesh->attribVbo = chunk->attribVbo;
+    mesh->ebo = chunk->ebo;
+    mesh->baseVertex = baseVertex;
+    mesh->firstIndex = firstIndex;
+    mesh->allocVertexCount = vertexCount;
+    mesh->allocIndexCount = indexCount;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_arena_init(void)
+{
+    memset(&R3D_MOD_ARENA, 0, sizeof(R3D_MOD_ARENA));
+    return true;
+}
+
+void r3d_arena_quit(void)
+{
+    for (int i = 0; i < R3D_MOD_ARENA.numChunks; i++) {
+        chunk_release(&R3D_MOD_ARENA.chunks[i]);
+    }
+    R3D_MOD_ARENA.numChunks = 0;
+}
+
+bool r3d_arena_is_supported(void)
+{
+    return GLAD_GL_VERSION_4_3 || (GLAD_GL_VERSION_4_2 && GLAD_GL_ARB_multi_draw_indirect);
+}
+
+bool r3d_arena_alloc(R3D_Mesh* mesh, const R3D_MeshData* data)
+{
+    if (!r3d_arena_is_supported()) {
+        return false;
+    }
+
+    if (data->indexCount <= 0 || data->indices == NULL) {
+        return false;
+    }
+
+    if (data->vertexCount > R3D_ARENA_CHUNK_VERTICES || data->indexCount > R3D_ARENA_CHUNK_INDICES) {
+        return false;
+    }
+
+    // Chunks have no skinning stream, it would be fetched by the depth passes of every mesh
+    if (r3d_vertex_has_skin(data)) {
+        return false;
+    }
+
+    int baseVertex = 0, firstIndex = 0;
+    r3d_arena_chunk_t* chunk = chunk_find_room(data->vertexCount, data->indexCount, &baseVertex, &firstIndex);
+    if (chunk == NULL) return false;
+
+    chunk_upload(chunk, baseVertex, firstIndex, data);
+    assign_range(mesh, chunk, baseVertex, firstIndex, data->vertexCount, data->indexCount, r3d_vertex_has_alpha(data));
+
+    return true;
+}
+
+bool r3d_arena_alloc_encoded(R3D_Mesh* mesh, const void* positions, const void* attribs, int vertexCount,
+                             const uint32_t* indices, int indexCount, bool hasAlpha)
+{
+    if (!r3d_arena_is_supported() || indexCount <= 0 || indices == NULL) {
+        return false;
+    }
+
+    if (vertexCount > R3D_ARENA_CHUNK_VERTICES || indexCount > R3D_ARENA_CHUNK_INDICES) {
+        return false;
+    }
+
+    int baseVertex = 0, firstIndex = 0;
+    r3d_arena_chunk_t* chunk = chunk_find_room(vertexCount, indexCount, &baseVertex, &firstIndex);
+    if (chunk == NULL) return false;
+
+    size_t positionStride = r3d_vertex_stride(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_POSITION);
+    size_t attribStride = r3d_vertex_stride(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS);
+
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, baseVertex * positionStride, vertexCount * positionStride, positions);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->attribVbo);
+    glBufferSubData(GL_ARRAY_BUFFER, baseVertex * attribStride, vertexCount * attribStride, attribs);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    chunk_upload_indices(chunk, firstIndex, indices, indexCount);
+    assign_range(mesh, chunk, baseVertex, firstIndex, vertexCount, indexCount, hasAlpha);
+
+    return true;
+}
+
+bool r3d_arena_update(R3D_Mesh* mesh, const R3D_MeshData* data)
+{
+    r3d_arena_chunk_t* chunk = chunk_find(mesh->vao);
+    if (chunk == NULL) return false;
+
+    if (data->indexCount <= 0 || data->indices == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Meshes allocated from the arena require indices");
+        return false;
+    }
+
+    if (r3d_vertex_has_skin(data)) {
+        TraceLog(LOG_WARNING, "R3D: Meshes allocated from the arena cannot receive bone weights");
+        return false;
+    }
+
+    if (data->vertexCount <= mesh->allocVertexCount && data->indexCount <= mesh->allocIndexCount) {
+        chunk_upload(chunk, mesh->baseVertex, mesh->firstIndex, data);
+        mesh->depthVao = r3d_vertex_has_alpha(data) ? 0 : chunk->depthVao;
+        return true;
+    }
+
+    // Allocate the new range before releasing the old one, the mesh remains valid on failure
+    R3D_Mesh moved = *mesh;
+    if (!r3d_arena_alloc(&moved, data)) {
+        TraceLog(LOG_WARNING, "R3D: Failed to grow a mesh allocated from the arena");
+        return false;
+    }
+
+    r3d_arena_free(mesh);
+    *mesh = moved;
+
+    return true;
+}
+
+bool r3d_arena_update_vertices(const R3D_Mesh* mesh, int firstVertex, const R3D_Vertex* vertices, int vertexCount)
+{
+    r3d_arena_chunk_t* chunk = chunk_find(mesh->vao);
+    if (chunk == NULL) return false;
+
+    int baseVertex = mesh->baseVertex + firstVertex;
+
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->vbo);
+    r3d_vertex_upload(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_POSITION, vertices, vertexCount, baseVertex, NULL, false, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk->attribVbo);
+    r3d_vertex_upload(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS, vertices, vertexCount, baseVertex, NULL, false, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+int r3d_arena_alloc_indices(const R3D_Mesh* mesh, const uint32_t* indices, int indexCount)
+{
+    r3d_arena_chunk_t* chunk = chunk_find(mesh->vao);
+    if (chunk == NULL) return -1;
+
+    int firstIndex = free_list_alloc(&chunk->indices, indexCount);
+    if (firstIndex < 0) return -1;
+
+    chunk_upload_indices(chunk, firstIndex, indices, indexCount);
+
+    return firstIndex;
+}
+
+void r3d_arena_free_indices(const R3D_Mesh* mesh, int firstIndex, int indexCount)
+{
+    r3d_arena_chunk_t* chunk = chunk_find(mesh->vao);
+    if (chunk == NULL) return;
+
+    free_list_free(&chunk->indices, firstIndex, indexCount);
+}
+
+void r3d_arena_free(R3D_Mesh* mesh)
+{
+    r3d_arena_chunk_t* chunk = chunk_find(mesh->vao);
+    if (chunk == NULL) return;
+
+    free_list_free(&chunk->vertices, mesh->baseVertex, mesh->allocVertexCount);
+    free_list_free(&chunk->indices, mesh->firstIndex, mesh->allocIndexCount);
+
+    for (int i = 0; i < mesh->lodCount; i++) {
+        free_list_free(&chunk->indices, mesh->lods[i].firstIndex, mesh->lods[i].indexCount);
+    }
+
+    mesh->vao = mesh->depthVao = 0;
+    mesh->vbo = mesh->attribVbo = mesh->ebo = 0;
+    mesh->baseVertex = mesh->firstIndex = 0;
+    mesh->lodCount = 0;
+}
+
+bool r3d_arena_owns(uint32_t vao)
+{
+    return chunk_find(vao) != NULL;
+}
@@ -0,0 +1,141 @@
+/* r3d_arena.h -- Internal R3D mesh arena module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_ARENA_H
+#define R3D_MODULE_ARENA_H
+
+#include <r3d/r3d_mesh_data.h>
+#include <r3d/r3d_mesh.h>
+#include <stdint.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_ARENA_MAX_CHUNKS        16          //< Maximum number of shared buffer chunks
+#define R3D_ARENA_CHUNK_VERTICES    (1 << 18)   //< Number of vertices stored per chunk
+#define R3D_ARENA_CHUNK_INDICES     (1 << 20)   //< Number of indices stored per chunk
+
+// ========================================
+// ARENA STRUCTURES
+// ========================================
+
+/*
+ * Range of free elements inside a chunk buffer.
+ */
+typedef struct {
+    int offset;                         //< First free element
+    int count;                          //< Number of free elements
+} r3d_arena_range_t;
+
+/*
+ * List of free ranges, sorted by offset and never adjacent.
+ */
+typedef struct {
+    r3d_arena_range_t* ranges;          //< Array of free ranges
+    int numRanges;                      //< Number of active ranges
+    int capacity;                       //< Allocated capacity of the array
+} r3d_arena_free_list_t;
+
+/*
+ * Shared vertex and index buffers with their own VAO.
+ * Every mesh sub-allocated from the same chunk can be drawn in a single multi-draw.
+ */
+typedef struct {
+    uint32_t vao, depthVao;             //< Vertex arrays of all the attributes and of the positions only
+    uint32_t vbo, attribVbo, ebo;       //< Position, attribute and index buffers shared by all meshes of the chunk
+    r3d_arena_free_list_t vertices;     //< Free ranges of the vertex buffer
+    r3d_arena_free_list_t indices;      //< Free ranges of the index buffer
+} r3d_arena_chunk_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the arena module.
+ * Chunks are created on demand and never moved, the handles stored in meshes stay valid.
+ */
+extern struct r3d_arena {
+    r3d_arena_chunk_t chunks[R3D_ARENA_MAX_CHUNKS];     //< Chunks created so far
+    int numChunks;                                      //< Number of active chunks
+} R3D_MOD_ARENA;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_arena_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_arena_quit(void);
+
+/*
+ * Returns true if meshes can be sub-allocated from the arena.
+ * The arena only exists to feed `glMultiDrawElementsIndirect` with a non-zero base instance,
+ * so it requires OpenGL 4.3, or `GL_ARB_multi_draw_indirect` on a 4.2 context.
+ */
+bool r3d_arena_is_supported(void);
+
+/*
+ * Sub-allocates and uploads the vertices and indices of a mesh.
+ * Sets the OpenGL handles and the offsets of the mesh on success.
+ * Returns false if the arena is not supported, the data does not fit in a chunk
+ * or has bone weights, the mesh is then left untouched.
+ */
+bool r3d_arena_alloc(R3D_Mesh* mesh, const R3D_MeshData* data);
+
+/*
+ * Same as `r3d_arena_alloc()` with vertex streams already encoded in the full format.
+ * Used by the model cache, whose streams are stored exactly as they are on the GPU.
+ */
+bool r3d_arena_alloc_encoded(R3D_Mesh* mesh, const void* positions, const void* attribs, int vertexCount,
+                             const uint32_t* indices, int indexCount, bool hasAlpha);
+
+/*
+ * Rewrites the content of a mesh previously allocated from the arena.
+ * The mesh is moved to a new range if its allocation is too small.
+ */
+bool r3d_arena_update(R3D_Mesh* mesh, const R3D_MeshData* data);
+
+/*
+ * Rewrites a range of vertices of a mesh previously allocated from the arena.
+ * The range must lie within the vertices of the mesh.
+ */
+bool r3d_arena_update_vertices(const R3D_Mesh* mesh, int firstVertex, const R3D_Vertex* vertices, int vertexCount);
+
+/*
+ * Sub-allocates and uploads an extra index range in the chunk of a mesh allocated from the arena.
+ * Used for the levels of detail, which share the vertices of the mesh.
+ * Returns the first index of the range, or -1 if the chunk has no room left.
+ */
+int r3d_arena_alloc_indices(const R3D_Mesh* mesh, const uint32_t* indices, int indexCount);
+
+/*
+ * Releases an index range previously returned by `r3d_arena_alloc_indices()`.
+ */
+void r3d_arena_free_indices(const R3D_Mesh* mesh, int firstIndex, int indexCount);
+
+/*
+ * Releases the ranges used by a mesh allocated from the arena, including its levels of detail.
+ */
+void r3d_arena_free(R3D_Mesh* mesh);
+
+/*
+ * Returns true if the VAO belongs to one of the arena chunks.
+ */
+bool r3d_arena_owns(uint32_t vao);
+
+#endif // R3D_MODULE_ARENA_H
@@ -15,6 +15,7 @@
 #include <glad.h>
 
 #include "../details/r3d_math.h"
+#include "./r3d_stream.h"
 
 // ========================================
 // MODULE STATE
@@ -36,8 +37,13 @@ typedef struct {
     alignas(4) float aspect;
     alignas(4) float near;
     alignas(4) float far;
+    alignas(8) Vector2 uvScale;
 } uniform_view_state_t;
 
+typedef struct {
+    alignas(16) Vector4 irradianceSH[9];
+} uniform_sky_state_t;
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -54,21 +60,25 @@ bool r3d_cache_init(R3D_Flags flags)
     R3D_MOD_CACHE.environment = R3D_ENVIRONMENT_BASE;
 
     R3D_MOD_CACHE.textureFilter = TEXTURE_FILTER_TRILINEAR;
+    R3D_MOD_CACHE.modelLodCount = 0;
+    R3D_MOD_CACHE.modelCompactVertices = false;
+    R3D_MOD_CACHE.modelCompressTextures = false;
+    R3D_MOD_CACHE.modelStreamTextures = false;
+    R3D_MOD_CACHE.animationTolerance = 0.0f;
+    R3D_MOD_CACHE.programCacheDir[0] = '\0';
     R3D_MOD_CACHE.layers = R3D_LAYER_ALL;
+    R3D_MOD_CACHE.lodBias = 1.0f;
+    R3D_MOD_CACHE.shadowLodBias = 0.5f;
     R3D_MOD_CACHE.state = flags;
 
-    glGenBuffers(R3D_CACHE_UNIFORM_COUNT, R3D_MOD_CACHE.uniformBuffers);
-
-    glBindBuffer(GL_UNIFORM_BUFFER, R3D_MOD_CACHE.uniformBuffers[R3D_CACHE_UNIFORM_VIEW_STATE]);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(uniform_view_state_t), NULL, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    R3D_MOD_CACHE.viewState.uvScale = (Vector2) {1.0f, 1.0f};
+    R3D_MOD_CACHE.temporal.prevUvScale = (Vector2) {1.0f, 1.0f};
 
     return true;
 }
 
 void r3d_cache_quit(void)
 {
-    glDeleteBuffers(R3D_CACHE_UNIFORM_COUNT, R3D_MOD_CACHE.uniformBuffers);
 }
 
 void r3d_cache_update_view_state(Camera3D camera, double aspect, double near, double far)
@@ -84,26 +94,46 @@ void r3d_cache_update_view_state(Camera3D camera, double aspect, double near, do
         proj = MatrixOrtho(-right, right, -top, top, near, far);
     }
 
+    r3d_cache_set_view_state(view, proj, aspect, near, far);
+}
+
+void r3d_cache_set_view_state(Matrix view, Matrix proj, double aspect, double near, double far)
+{
     Matrix viewProj = r3d_matrix_multiply(&view, &proj);
+    Matrix invView = MatrixInvert(view);
 
     R3D_MOD_CACHE.viewState.frustum = r3d_frustum_create(viewProj);
-    R3D_MOD_CACHE.viewState.viewPosition = camera.position;
+    R3D_MOD_CACHE.viewState.viewPosition = (Vector3) { invView.m12, invView.m13, invView.m14 };
 
     R3D_MOD_CACHE.viewState.view = view;
     R3D_MOD_CACHE.viewState.proj = proj;
-    R3D_MOD_CACHE.viewState.invView = MatrixInvert(view);
+    R3D_MOD_CACHE.viewState.invView = invView;
     R3D_MOD_CACHE.viewState.invProj = MatrixInvert(proj);
     R3D_MOD_CACHE.viewState.viewProj = viewProj;
+    R3D_MOD_CACHE.viewState.viewProjNoJitter = viewProj;
 
     R3D_MOD_CACHE.viewState.aspect = aspect;
     R3D_MOD_CACHE.viewState.near = near;
     R3D_MOD_CACHE.viewState.far = far;
 }
 
-void r3d_cache_bind_view_state(int slot)
+void r3d_cache_jitter_view_state(Vector2 offset)
 {
-    GLuint ubo = R3D_MOD_CACHE.uniformBuffers[R3D_CACHE_UNIFORM_VIEW_STATE];
+    Matrix proj = R3D_MOD_CACHE.viewState.proj;
+
+    // Adds the offset times W to the clip X and Y, valid for both perspective and orthographic projections
+    proj.m0 += offset.x * proj.m3;  proj.m1 += offset.y * proj.m3;
+    proj.m4 += offset.x * proj.m7;  proj.m5 += offset.y * proj.m7;
+    proj.m8 += offset.x * proj.m11; proj.m9 += offset.y * proj.m11;
+    proj.m12 += offset.x * proj.m15; proj.m13 += offset.y * proj.m15;
+
+    R3D_MOD_CACHE.viewState.proj = proj;
+    R3D_MOD_CACHE.viewState.invProj = MatrixInvert(proj);
+    R3D_MOD_CACHE.viewState.viewProj = r3d_matrix_multiply(&R3D_MOD_CACHE.viewState.view, &proj);
+}
 
+void r3d_cache_bind_view_state(int slot)
+{
     uniform_view_state_t uViewState = {0};
     uViewState.viewPosition = R3D_MOD_CACHE.viewState.viewPosition;
     uViewState.view = r3d_matrix_transpose(&R3D_MOD_CACHE.viewState.view);
@@ -114,8 +144,20 @@ void r3d_cache_bind_view_state(int slot)
     uViewState.aspect = R3D_MOD_CACHE.viewState.aspect;
     uViewState.near = R3D_MOD_CACHE.viewState.near;
     uViewState.far = R3D_MOD_CACHE.viewState.far;
+    uViewState.uvScale = R3D_MOD_CACHE.viewState.uvScale;
+
+    // Each bind gets its own range of the stream, no stall on the draws still reading the previous one
+    r3d_stream_bind_uniform(slot, &uViewState, sizeof(uniform_view_state_t));
+}
+
+void r3d_cache_bind_sky_state(int slot)
+{
+    uniform_sky_state_t uSkyState = {0};
+
+    const Vector3* sh = R3D_MOD_CACHE.environment.background.sky.irradianceSH;
+    for (int i = 0; i < 9; i++) {
+        uSkyState.irradianceSH[i] = (Vector4) { sh[i].x, sh[i].y, sh[i].z, 0.0f };
+    }
 
-    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniform_view_state_t), &uViewState);
-    glBindBufferBase(GL_UNIFORM_BUFFER, slot, ubo);
+    r3d_stream_bind_uniform(slot, &uSkyState, sizeof(uniform_sky_state_t));
 }
@@ -11,6 +11,7 @@
 
 #include <r3d/r3d_environment.h>
 #include <r3d/r3d_core.h>
+#include <stdint.h>
 #include <glad.h>
 
 #include "../details/r3d_frustum.h"
@@ -57,11 +58,6 @@
 // MODULE STATE
 // ========================================
 
-typedef enum {
-    R3D_CACHE_UNIFORM_VIEW_STATE,
-    R3D_CACHE_UNIFORM_COUNT
-} r3d_cache_uniform_enum_t;
-
 /*
  * Current view state including view frustum and transforms.
  */
@@ -71,22 +67,45 @@ typedef struct {
     Matrix view, invView;           //< View matrix and its inverse
     Matrix proj, invProj;           //< Projection matrix and its inverse
     Matrix viewProj;                //< Combined view-projection matrix
+    Matrix viewProjNoJitter;        //< View-projection matrix without the TAA jitter, used for the reprojections
     float aspect;                   //< Projection aspect
     float near;                     //< Near cull distance
     float far;                      //< Far cull distance
+    Vector2 uvScale;                //< Fraction of the render targets covered by the rendered area
 } r3d_view_state_t;
 
+/*
+ * State kept from one frame to the next for the temporal effects.
+ * Only the frames rendered from the main view update it, probe captures are ignored.
+ */
+typedef struct {
+    Matrix prevViewProj;            //< View-projection matrix of the previous frame
+    Vector2 prevUvScale;            //< Rendered area of the previous frame, the histories are not rescaled
+    uint32_t frameIndex;            //< Frame counter, rotates the sample patterns and the history targets
+    bool ssaoHistory;               //< The SSAO history holds the occlusion of the previous frame
+    bool ssilHistory;               //< The SSIL history holds the lighting of the previous frame
+    bool taaHistory;                //< The TAA history holds the output of the previous frame
+} r3d_temporal_state_t;
+
 /*
  * Global cache for frequently accessed renderer state.
  * Reduces parameter passing and provides centralized access to common data.
  */
 extern struct r3d_cache {
-    GLuint uniformBuffers[R3D_CACHE_UNIFORM_COUNT]; //< Current view state uniform buffer
     R3D_Environment environment;                    //< Current environment settings
     r3d_view_state_t viewState;                     //< Current view state
+    r3d_temporal_state_t temporal;                  //< History of the previous frame
     TextureFilter textureFilter;                    //< Default texture filter for model loading
+    int modelLodCount;                              //< Number of levels of detail generated for model loading
+    bool modelCompactVertices;                      //< Use the compact vertex format for model loading
+    bool modelCompressTextures;                     //< Compress the textures to S3TC blocks for model loading
+    bool modelStreamTextures;                       //< Upload the finer mipmaps of the model textures on demand
+    float animationTolerance;                       //< Error tolerated by the animation compression, 0 if disabled
+    char programCacheDir[256];                      //< Directory of the program binaries, empty if disabled
     Matrix matCubeViews[6];                         //< Pre-computed view matrices for cubemap faces
     R3D_Layer layers;                               //< Active rendering layers
+    float lodBias;                                  //< Multiplier of the projected size used to select the levels of detail
+    float shadowLodBias;                            //< Same as 'lodBias' for the shadow passes
     R3D_Flags state;                                //< Renderer state flags
 } R3D_MOD_CACHE;
 
@@ -108,6 +127,20 @@ void r3d_cache_quit(void);
 
 void r3d_cache_update_view_state(Camera3D camera, double aspect, double near, double far);
 
+/*
+ * Sets the view state from explicit matrices, such as the eye poses given by a VR runtime.
+ * The view position is taken from the inverse view matrix.
+ */
+void r3d_cache_set_view_state(Matrix view, Matrix proj, double aspect, double near, double far);
+
+/*
+ * Offsets the projection by a sub-pixel amount in NDC, for the temporal anti-aliasing.
+ * The frustum and 'viewProjNoJitter' are left untouched.
+ */
+void r3d_cache_jitter_view_state(Vector2 offset);
+
 void r3d_cache_bind_view_state(int slot);
 
+void r3d_cache_bind_sky_state(int slot);
+
 #endif // R3D_MODULE_CACHE_H
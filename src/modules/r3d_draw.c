@@ -9,6 +9,7 @@
 #include "./r3d_draw.h"
 #include <raymath.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -18,6 +19,16 @@
 
 #include "../details/r3d_frustum.h"
 #include "../details/r3d_math.h"
+#include "./r3d_shader.h"
+#include "./r3d_arena.h"
+#include "./r3d_cache.h"
+#include "./r3d_occlusion.h"
+#include "./r3d_preskin.h"
+#include "./r3d_profile.h"
+#include "./r3d_scene.h"
+#include "./r3d_texture.h"
+#include "./r3d_state.h"
+#include "./r3d_stream.h"
 
 // ========================================
 // MODULE STATE
@@ -30,11 +41,11 @@ struct r3d_draw R3D_MOD_DRAW;
 // ========================================
 
 #define IS_CALL_PREPASS(call)                                           \
-    ((call)->material.transparencyMode == R3D_TRANSPARENCY_PREPASS)
+    ((call)->material->transparencyMode == R3D_TRANSPARENCY_PREPASS)
 
 #define IS_CALL_FORWARD(call)                                           \
-    ((call)->material.transparencyMode == R3D_TRANSPARENCY_ALPHA ||     \
-     (call)->material.blendMode != R3D_BLEND_MIX)
+    ((call)->material->transparencyMode == R3D_TRANSPARENCY_ALPHA ||    \
+     (call)->material->blendMode != R3D_BLEND_MIX)
 
 // ========================================
 // INTERNAL ARRAY FUNCTIONS
@@ -59,41 +70,191 @@ static inline r3d_draw_group_t* get_last_group(void)
     return &R3D_MOD_DRAW.groups[groupIndex];
 }
 
-static bool growth_arrays(void)
+/*
+ * All the arrays indexed by draw calls or groups live in a single block, carved in this order.
+ * The counts are reset by 'r3d_draw_clear()' and the block is only replaced when it must grow,
+ * so a frame never allocates once the capacity has settled.
+ */
+#define DRAW_ARRAYS(X)                                                  \
+    X(calls) X(groups) X(sortKeys) X(sortKeysTmp) X(sortValuesTmp)      \
+    X(callIndices) X(groupIndices)                                      \
+    X(groupBoxes.centerX) X(groupBoxes.centerY) X(groupBoxes.centerZ)   \
+    X(groupBoxes.extentX) X(groupBoxes.extentY) X(groupBoxes.extentZ)   \
+    X(batch.calls) X(batch.transforms) X(batch.commands) X(batch.materials)   \
+    X(bucket.calls) X(bucket.transforms)
+
+static size_t layout_array(size_t* offset, size_t elemSize, int count)
+{
+    // Each array starts on its own cache line
+    size_t start = (*offset + 63) & ~(size_t)63;
+    *offset = start + elemSize * count;
+    return start;
+}
+
+static bool reserve_arrays(int newCapacity)
 {
-    #define GROW_AND_ASSIGN(field) do { \
-        void* _p = RL_REALLOC(R3D_MOD_DRAW.field, newCapacity * sizeof(*R3D_MOD_DRAW.field)); \
-        if (_p == NULL) return false; \
-        R3D_MOD_DRAW.field = _p; \
-    } while (0)
+    int oldCapacity = R3D_MOD_DRAW.capacity;
+
+    // The visibility is a bitset, one word covers 32 groups
+    int oldWords = (oldCapacity + 31) / 32;
+    int newWords = (newCapacity + 31) / 32;
+
+    /* --- Measure the block --- */
+
+    size_t size = 0;
+
+    #define MEASURE(field) layout_array(&size, sizeof(*R3D_MOD_DRAW.field), newCapacity);
+    DRAW_ARRAYS(MEASURE)
+    #undef MEASURE
+
+    for (int i = 0; i < R3D_DRAW_LIST_COUNT; i++) {
+        layout_array(&size, sizeof(*R3D_MOD_DRAW.list[i].calls), newCapacity);
+    }
+    layout_array(&size, sizeof(uint32_t), newWords);
+
+    uint8_t* block = RL_MALLOC(size);
+    if (block == NULL) return false;
+
+    /* --- Move the arrays into the new block --- */
+
+    size_t offset = 0;
 
-    int newCapacity = 2 * R3D_MOD_DRAW.capacity;
+    #define MOVE(field, count, oldCount) do {                                   \
+        void* _p = block + layout_array(&offset, sizeof(*R3D_MOD_DRAW.field), count); \
+        if (R3D_MOD_DRAW.field != NULL) {                                       \
+            memcpy(_p, R3D_MOD_DRAW.field, (oldCount) * sizeof(*R3D_MOD_DRAW.field)); \
+        }                                                                       \
+        R3D_MOD_DRAW.field = _p;                                                \
+    } while (0);
 
-    GROW_AND_ASSIGN(calls);
-    GROW_AND_ASSIGN(groups);
-    GROW_AND_ASSIGN(cacheDists);
-    GROW_AND_ASSIGN(callIndices);
-    GROW_AND_ASSIGN(groupIndices);
-    GROW_AND_ASSIGN(visibleGroups);
+    #define MOVE_ARRAY(field) MOVE(field, newCapacity, oldCapacity)
+    DRAW_ARRAYS(MOVE_ARRAY)
+    #undef MOVE_ARRAY
 
-    for (int i = 0; i < R3D_DRAW_LIST_COUNT; ++i) {
-        GROW_AND_ASSIGN(list[i].calls);
+    for (int i = 0; i < R3D_DRAW_LIST_COUNT; i++) {
+        MOVE(list[i].calls, newCapacity, oldCapacity)
     }
+    MOVE(visibleGroups, newWords, oldWords)
 
-    #undef GROW_AND_ASSIGN
+    #undef MOVE
 
+    RL_FREE(R3D_MOD_DRAW.arrays);
+    R3D_MOD_DRAW.arrays = block;
     R3D_MOD_DRAW.capacity = newCapacity;
 
     return true;
 }
 
+static bool growth_arrays(void)
+{
+    return reserve_arrays(2 * R3D_MOD_DRAW.capacity);
+}
+
+// ========================================
+// INTERNAL MATERIAL FUNCTIONS
+// ========================================
+
+static inline int get_material_cache_slot(const R3D_Material* material)
+{
+    uintptr_t address = (uintptr_t)material;
+    return (int)((address >> 4) ^ (address >> 12)) & (R3D_DRAW_MATERIAL_CACHE_SIZE - 1);
+}
+
+static inline R3D_Material* get_interned_material(int index)
+{
+    return &R3D_MOD_DRAW.materials.blocks[index / R3D_DRAW_MATERIAL_BLOCK_SIZE][index % R3D_DRAW_MATERIAL_BLOCK_SIZE];
+}
+
+static const R3D_Material* intern_material(const R3D_Material* material)
+{
+    /* --- Reuse the material last interned from the same address if unchanged --- */
+
+    int slot = get_material_cache_slot(material);
+    int cached = R3D_MOD_DRAW.materials.cache[slot];
+
+    if (cached < R3D_MOD_DRAW.materials.count) {
+        const R3D_Material* interned = get_interned_material(cached);
+        if (memcmp(interned, material, sizeof(R3D_Material)) == 0) {
+            return interned;
+        }
+    }
+
+    /* --- Otherwise copy it, allocating a new block if needed --- */
+
+    int index = R3D_MOD_DRAW.materials.count;
+    int block = index / R3D_DRAW_MATERIAL_BLOCK_SIZE;
+
+    if (block >= R3D_MOD_DRAW.materials.numBlocks) {
+        R3D_Material** blocks = RL_REALLOC(R3D_MOD_DRAW.materials.blocks, (block + 1) * sizeof(*blocks));
+        if (blocks == NULL) return NULL;
+        R3D_MOD_DRAW.materials.blocks = blocks;
+
+        blocks[block] = RL_MALLOC(R3D_DRAW_MATERIAL_BLOCK_SIZE * sizeof(R3D_Material));
+        if (blocks[block] == NULL) return NULL;
+        R3D_MOD_DRAW.materials.numBlocks++;
+    }
+
+    R3D_Material* interned = get_interned_material(index);
+    *interned = *material;
+
+    R3D_MOD_DRAW.materials.cache[slot] = index;
+    R3D_MOD_DRAW.materials.count++;
+
+    return interned;
+}
+
 // ========================================
 // INTERNAL SORTING FUNCTIONS
 // ========================================
 
-static Vector3 G_sortViewPosition = {0};
+/*
+ * Sort keys are packed on 64 bits, the most significant bits being sorted first.
+ *
+ * State sorted keys (opaque):
+ *   [63..56] shader | [55..40] textures | [39..24] vao | [23..0] depth
+ *
+ * Depth sorted keys (transparent):
+ *   [63..32] depth | [31..24] shader | [23..8] textures | [7..0] vao
+ *
+ * The depth is the squared distance to the camera, the bit pattern of a positive
+ * float being monotonic, it can be quantized by simply dropping low mantissa bits.
+ */
+
+static inline uint32_t hash_u32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint32_t get_shader_bits(const r3d_draw_call_t* call)
+{
+    // NOTE: Zero is reserved for the built-in shaders
+    uint64_t shader = (uint64_t)(uintptr_t)call->material->shader;
+    if (shader == 0) return 0;
+    return 1 + hash_u32((uint32_t)(shader ^ (shader >> 32))) % 255;
+}
 
-static float calculate_max_distance_to_camera(const r3d_draw_call_t* call)
+static inline uint32_t get_texture_bits(const r3d_draw_call_t* call)
+{
+    uint32_t h = hash_u32(call->material->albedo.texture.id);
+    h = hash_u32(h ^ call->material->normal.texture.id);
+    h = hash_u32(h ^ call->material->orm.texture.id);
+    h = hash_u32(h ^ call->material->emission.texture.id);
+    return h & 0xFFFF;
+}
+
+static inline uint32_t get_depth_bits(float distSq)
+{
+    uint32_t bits;
+    memcpy(&bits, &distSq, sizeof(bits));
+    return bits;
+}
+
+static float calculate_max_distance_to_camera(const r3d_draw_call_t* call, Vector3 viewPosition)
 {
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
     const Vector3* min = &call->mesh.aabb.min;
@@ -108,15 +269,15 @@ static float calculate_max_distance_to_camera(const r3d_draw_call_t* call)
             (i & 4) ? max->z : min->z
         };
 
-        corner = Vector3Transform(corner, group->transform);
-        float distSq = Vector3DistanceSqr(G_sortViewPosition, corner);
+        corner = r3d_vector3_transform(corner, &group->transform);
+        float distSq = Vector3DistanceSqr(viewPosition, corner);
         maxDistSq = (distSq > maxDistSq) ? distSq : maxDistSq;
     }
 
     return maxDistSq;
 }
 
-static float calculate_center_distance_to_camera(const r3d_draw_call_t* call)
+static float calculate_center_distance_to_camera(const r3d_draw_call_t* call, Vector3 viewPosition)
 {
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
 
@@ -125,37 +286,326 @@ static float calculate_center_distance_to_camera(const r3d_draw_call_t* call)
         (call->mesh.aabb.min.y + call->mesh.aabb.max.y) * 0.5f,
         (call->mesh.aabb.min.z + call->mesh.aabb.max.z) * 0.5f
     };
-    center = Vector3Transform(center, group->transform);
+    center = r3d_vector3_transform(center, &group->transform);
 
-    return Vector3DistanceSqr(G_sortViewPosition, center);
+    return Vector3DistanceSqr(viewPosition, center);
 }
 
-static int compare_back_to_front(const void* a, const void* b)
+static uint64_t build_sort_key(const r3d_draw_call_t* call, Vector3 viewPosition, r3d_draw_sort_enum_t mode)
 {
-    int indexA = *(int*)a;
-    int indexB = *(int*)b;
-    
-    float distA = R3D_MOD_DRAW.cacheDists[indexA];
-    float distB = R3D_MOD_DRAW.cacheDists[indexB];
+    uint64_t shader = get_shader_bits(call);
+    uint64_t textures = get_texture_bits(call);
+    uint64_t vao = call->mesh.vao & 0xFFFF;
+
+    switch (mode) {
+    case R3D_DRAW_SORT_FRONT_TO_BACK: {
+        uint64_t depth = get_depth_bits(calculate_center_distance_to_camera(call, viewPosition)) >> 8;
+        return (shader << 56) | (textures << 40) | (vao << 24) | depth;
+    }
+    case R3D_DRAW_SORT_BACK_TO_FRONT: {
+        uint64_t depth = ~get_depth_bits(calculate_max_distance_to_camera(call, viewPosition));
+        return ((depth & 0xFFFFFFFF) << 32) | (shader << 24) | (textures << 8) | (vao & 0xFF);
+    }
+    case R3D_DRAW_SORT_STATE:
+        return (shader << 56) | (textures << 40) | (vao << 24);
+    default:
+        break;
+    }
 
-    return (distA < distB) - (distA > distB);
+    assert(false);
+    return 0;
 }
 
-static int compare_front_to_back(const void* a, const void* b)
+/*
+ * Stable LSD radix sort of values by their 64 bits keys, 8 bits per pass.
+ * Passes where every key shares the same digit are skipped, which is
+ * frequent for the high bits of the depth or the shader bucket.
+ * The scratch arrays must be able to hold 'count' elements.
+ */
+static void radix_sort(uint64_t* keys, int* values, uint64_t* tmpKeys, int* tmpValues, int count)
 {
-    int indexA = *(int*)a;
-    int indexB = *(int*)b;
-    
-    float distA = R3D_MOD_DRAW.cacheDists[indexA];
-    float distB = R3D_MOD_DRAW.cacheDists[indexB];
+    uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (int i = 0; i < count; i++) {
+        uint64_t key = keys[i];
+        for (int pass = 0; pass < 8; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    uint64_t* srcKeys = keys;
+    int* srcValues = values;
+
+    for (int pass = 0; pass < 8; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        int shift = pass * 8;
 
-    return (distA > distB) - (distA < distB);
+        if (histogram[(srcKeys[0] >> shift) & 0xFF] == (uint32_t)count) {
+            continue;
+        }
+
+        uint32_t sum = 0;
+        for (int i = 0; i < 256; i++) {
+            uint32_t c = histogram[i];
+            histogram[i] = sum;
+            sum += c;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint32_t dst = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+            tmpKeys[dst] = srcKeys[i];
+            tmpValues[dst] = srcValues[i];
+        }
+
+        uint64_t* swapKeys = srcKeys; srcKeys = tmpKeys; tmpKeys = swapKeys;
+        int* swapValues = srcValues; srcValues = tmpValues; tmpValues = swapValues;
+    }
+
+    // After an odd number of passes the result lives in the scratch arrays
+    if (srcValues != values) {
+        memcpy(values, srcValues, count * sizeof(*values));
+    }
+}
+
+// ========================================
+// INTERNAL INSTANCE STREAM FUNCTIONS
+// ========================================
+
+static bool instance_stream_reserve(size_t size)
+{
+    return r3d_stream_reserve(size);
+}
+
+// Keep the attribute offsets aligned on 16 bytes
+static size_t instance_stream_write(const void* data, size_t stride, size_t elemSize, int count)
+{
+    R3D_PROFILE_COUNT(instanceBytes, count * elemSize);
+    return r3d_stream_write(data, stride, elemSize, count, 16);
+}
+
+static bool is_group_uploaded(const r3d_draw_group_t* group)
+{
+    // The arrays must be written again if the stream has been replaced since
+    return group->stream.generation == R3D_MOD_STREAM.generation;
+}
+
+static void upload_group_instances(r3d_draw_group_t* group)
+{
+    if (is_group_uploaded(group)) {
+        return;
+    }
+
+    int count = group->instanced.count;
+
+    // Particle records interleave the transform and the color, they are copied as is
+    if (group->instanced.particles) {
+        if (!instance_stream_reserve(count * sizeof(R3D_ParticleInstance) + 16)) {
+            return;
+        }
+        size_t offset = instance_stream_write(group->instanced.particles, sizeof(R3D_ParticleInstance), sizeof(R3D_ParticleInstance), count);
+        group->stream.transOffset = offset;
+        group->stream.colOffset = offset + offsetof(R3D_ParticleInstance, color);
+        group->stream.generation = R3D_MOD_STREAM.generation;
+        return;
+    }
+
+    // Same for the sprite records
+    if (group->instanced.sprites) {
+        if (!instance_stream_reserve(count * sizeof(R3D_Sprite) + 16)) {
+            return;
+        }
+        size_t offset = instance_stream_write(group->instanced.sprites, sizeof(R3D_Sprite), sizeof(R3D_Sprite), count);
+        group->stream.transOffset = offset;
+        group->stream.colOffset = offset + offsetof(R3D_Sprite, color);
+        group->stream.generation = R3D_MOD_STREAM.generation;
+        return;
+    }
+
+    size_t colSize = group->instanced.colors ? count * sizeof(Color) : 0;
+    size_t transSize = count * sizeof(Matrix);
+
+    if (!instance_stream_reserve(transSize + colSize + 32)) {
+        return;
+    }
+
+    size_t transStride = (group->instanced.transStride == 0) ? sizeof(Matrix) : group->instanced.transStride;
+    group->stream.transOffset = instance_stream_write(group->instanced.transforms, transStride, sizeof(Matrix), count);
+
+    if (group->instanced.colors) {
+        size_t colStride = (group->instanced.colStride == 0) ? sizeof(Color) : group->instanced.colStride;
+        group->stream.colOffset = instance_stream_write(group->instanced.colors, colStride, sizeof(Color), count);
+    }
+
+    group->stream.generation = R3D_MOD_STREAM.generation;
+}
+
+// ========================================
+// INTERNAL GPU CULLING FUNCTIONS
+// ========================================
+
+#define INSTANCE_CULL_MIN_COUNT     128
+#define CULL_OUTPUT_INITIAL_SIZE    (1024 * 1024)
+
+static bool cull_output_reserve(size_t size)
+{
+    if (R3D_MOD_DRAW.cullOutput.head + size <= R3D_MOD_DRAW.cullOutput.capacity) {
+        return true;
+    }
+
+    size_t newCapacity = R3D_MOD_DRAW.cullOutput.capacity;
+    if (newCapacity == 0) newCapacity = CULL_OUTPUT_INITIAL_SIZE;
+    while (newCapacity < size) newCapacity *= 2;
+
+    if (R3D_MOD_DRAW.cullOutput.buffer == 0) {
+        glGenBuffers(1, &R3D_MOD_DRAW.cullOutput.buffer);
+        if (R3D_MOD_DRAW.cullOutput.buffer == 0) return false;
+    }
+
+    // Orphaning the storage keeps the ranges read by the commands already submitted alive
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, R3D_MOD_DRAW.cullOutput.buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, newCapacity, NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    R3D_MOD_DRAW.cullOutput.capacity = newCapacity;
+    R3D_MOD_DRAW.cullOutput.head = 0;
+
+    return true;
+}
+
+static size_t cull_output_alloc(size_t size)
+{
+    // NOTE: Space must have been reserved with 'cull_output_reserve()'
+    size_t offset = R3D_MOD_DRAW.cullOutput.head;
+    R3D_MOD_DRAW.cullOutput.head += (size + 15) & ~(size_t)15;
+    return offset;
+}
+
+static void cull_output_release(void)
+{
+    if (R3D_MOD_DRAW.cullOutput.buffer != 0) {
+        glDeleteBuffers(1, &R3D_MOD_DRAW.cullOutput.buffer);
+    }
+    memset(&R3D_MOD_DRAW.cullOutput, 0, sizeof(R3D_MOD_DRAW.cullOutput));
+}
+
+static bool should_cull_instances(const r3d_draw_call_t* call, const r3d_draw_group_t* group)
+{
+    if (!R3D_MOD_DRAW.gpuCulling || R3D_MOD_DRAW.cullFrustum == NULL) {
+        return false;
+    }
+
+    // The culling shader cannot expand the sprite records
+    if (group->instanced.sprites != NULL) {
+        return false;
+    }
+
+    if (group->instanced.count < INSTANCE_CULL_MIN_COUNT) {
+        return false;
+    }
+
+    // Meshes without bounds are always considered visible
+    return memcmp(&call->mesh.aabb, &(BoundingBox){0}, sizeof(BoundingBox)) != 0;
+}
+
+/*
+ * Dispatches the culling of all the instances of a draw call against the current frustum.
+ * Visible instances are compacted into the cull output, along with an indirect command
+ * whose instance count is accumulated by the compute shader.
+ * All offsets are in bytes, the colors and animations are only processed if their buffer is not zero.
+ * Particle records are read from the transform buffer and compacted with their color.
+ */
+static bool cull_instances(const r3d_draw_call_t* call, const r3d_draw_group_t* group,
+                           GLuint vboTransforms, size_t transOffset, GLuint vboColors, size_t colOffset,
+                           GLuint vboAnimations, size_t animOffset,
+                           size_t* outTransOffset, size_t* outColOffset, size_t* outAnimOffset, size_t* outCmdOffset)
+{
+    int count = group->instanced.count;
+    bool particles = (group->instanced.particles != NULL);
+    size_t transSize = count * (particles ? sizeof(R3D_ParticleInstance) : sizeof(Matrix));
+    size_t colSize = (vboColors && !particles) ? count * sizeof(Color) : 0;
+    size_t animSize = vboAnimations ? count * sizeof(R3D_InstanceAnimation) : 0;
+
+    if (!cull_output_reserve(transSize + colSize + animSize + 80)) {
+        return false;
+    }
+
+    *outCmdOffset = cull_output_alloc(sizeof(r3d_draw_indirect_t));
+    *outTransOffset = cull_output_alloc(transSize);
+    *outColOffset = colSize ? cull_output_alloc(colSize) : 0;
+    *outAnimOffset = vboAnimations ? cull_output_alloc(animSize) : 0;
+
+    // The instance count is the second word of both indexed and non-indexed commands
+    r3d_draw_indirect_t command = {0};
+    if (call->mesh.ebo != 0) {
+        command.count = (uint32_t)call->mesh.indexCount;
+        command.firstIndex = (uint32_t)call->mesh.firstIndex;
+        command.baseVertex = call->mesh.baseVertex;
+    }
+    else {
+        command.count = (uint32_t)call->mesh.vertexCount;
+        command.firstIndex = (uint32_t)call->mesh.baseVertex;
+    }
+
+    GLuint output = R3D_MOD_DRAW.cullOutput.buffer;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, output);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, *outCmdOffset, sizeof(command), &command);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // The culling is done in the middle of a pass, the raster program must be restored
+    GLuint program = R3D_MOD_STATE.program;
+    if (program == R3D_STATE_UNKNOWN) {
+        glGetIntegerv(GL_CURRENT_PROGRAM, (GLint*)&program);
+    }
+
+    R3D_SHADER_USE(prepare.instanceCull);
+
+    R3D_SHADER_SET_MAT4(prepare.instanceCull, uMatModel, group->transform);
+    for (int i = 0; i < R3D_PLANE_COUNT; i++) {
+        R3D_SHADER_SET_VEC4(prepare.instanceCull, uPlanes[i], R3D_MOD_DRAW.cullFrustum->planes[i]);
+    }
+    R3D_SHADER_SET_VEC3(prepare.instanceCull, uAabbMin, call->mesh.aabb.min);
+    R3D_SHADER_SET_VEC3(prepare.instanceCull, uAabbMax, call->mesh.aabb.max);
+
+    R3D_SHADER_SET_INT(prepare.instanceCull, uInstanceCount, count);
+    R3D_SHADER_SET_INT(prepare.instanceCull, uInTransformOffset, (int)(transOffset / sizeof(Vector4)));
+    R3D_SHADER_SET_INT(prepare.instanceCull, uInColorOffset, colSize ? (int)(colOffset / sizeof(Color)) : -1);
+    R3D_SHADER_SET_INT(prepare.instanceCull, uOutTransformOffset, (int)(*outTransOffset / sizeof(Vector4)));
+    R3D_SHADER_SET_INT(prepare.instanceCull, uOutColorOffset, (int)(*outColOffset / sizeof(Color)));
+    R3D_SHADER_SET_INT(prepare.instanceCull, uInAnimationOffset, vboAnimations ? (int)(animOffset / sizeof(uint32_t)) : -1);
+    R3D_SHADER_SET_INT(prepare.instanceCull, uOutAnimationOffset, (int)(*outAnimOffset / sizeof(uint32_t)));
+    R3D_SHADER_SET_INT(prepare.instanceCull, uCommandOffset, (int)(*outCmdOffset / sizeof(uint32_t)) + 1);
+    R3D_SHADER_SET_INT(prepare.instanceCull, uParticles, particles);
+
+    // NOTE: The color and animation bindings must reference a valid buffer even when unused
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, vboTransforms);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, vboColors ? vboColors : vboTransforms);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, output);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, output);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, vboAnimations ? vboAnimations : vboTransforms);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, vboTransforms);
+
+    glDispatchCompute((count + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    for (int i = 0; i < 6; i++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+
+    r3d_state_use_program(program);
+
+    return true;
 }
 
 // ========================================
 // INTERNAL DRAW FUNCTIONS
 // ========================================
 
+// NOTE: Must match the location of 'iAnimation' in the skinned vertex shaders
+#define INSTANCE_ANIMATION_LOCATION 15
+
 static inline const BoundingBox* get_group_aabb(const r3d_draw_group_t* group)
 {
     return r3d_draw_has_instances(group) ? &group->instanced.allAabb : &group->aabb;
@@ -177,39 +627,556 @@ static GLenum get_opengl_primitive(R3D_PrimitiveType primitive)
     return GL_TRIANGLES; // consider an error...
 }
 
+static inline const void* get_index_offset(const R3D_Mesh* mesh)
+{
+    return (const void*)((uintptr_t)mesh->firstIndex * sizeof(uint32_t));
+}
+
+static inline void get_call_indices(const r3d_draw_call_t* call, int* firstIndex, int* indexCount)
+{
+    int lod = R3D_MOD_DRAW.shadowLods ? call->shadowLod : call->lod;
+
+    if (lod == 0) {
+        *firstIndex = call->mesh.firstIndex;
+        *indexCount = call->mesh.indexCount;
+        return;
+    }
+
+    *firstIndex = call->mesh.lods[lod - 1].firstIndex;
+    *indexCount = call->mesh.lods[lod - 1].indexCount;
+}
+
+static int get_triangle_count(R3D_PrimitiveType primitive, int count)
+{
+    switch (primitive) {
+    case R3D_PRIMITIVE_TRIANGLES:       return count / 3;
+    case R3D_PRIMITIVE_TRIANGLE_STRIP:
+    case R3D_PRIMITIVE_TRIANGLE_FAN:    return (count > 2) ? count - 2 : 0;
+    default: break;
+    }
+
+    return 0;
+}
+
+static void count_draw(const r3d_draw_call_t* call, int count, int instances)
+{
+    R3D_PROFILE_COUNT(drawCommands, 1);
+    R3D_PROFILE_COUNT(instancesDrawn, instances);
+    R3D_PROFILE_COUNT(trianglesSubmitted, (int64_t)get_triangle_count(call->mesh.primitiveType, count) * instances);
+}
+
+static bool has_alpha_channel(int format)
+{
+    switch (format) {
+    case PIXELFORMAT_UNCOMPRESSED_GRAYSCALE:
+    case PIXELFORMAT_UNCOMPRESSED_R5G6B5:
+    case PIXELFORMAT_UNCOMPRESSED_R8G8B8:
+    case PIXELFORMAT_UNCOMPRESSED_R32:
+    case PIXELFORMAT_UNCOMPRESSED_R32G32B32:
+    case PIXELFORMAT_UNCOMPRESSED_R16:
+    case PIXELFORMAT_UNCOMPRESSED_R16G16B16:
+    case PIXELFORMAT_COMPRESSED_DXT1_RGB:
+    case PIXELFORMAT_COMPRESSED_ETC1_RGB:
+    case PIXELFORMAT_COMPRESSED_ETC2_RGB:
+    case PIXELFORMAT_COMPRESSED_PVRT_RGB:
+        return false;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+static bool is_same_batch_material(const R3D_Material* a, const R3D_Material* b)
+{
+    // NOTE: Only the state that can't vary within a multi-draw is compared,
+    //       the other parameters are read per draw, see 'get_batch_material()'
+    return
+        a->albedo.texture.id == b->albedo.texture.id &&
+        a->normal.texture.id == b->normal.texture.id &&
+        a->emission.texture.id == b->emission.texture.id &&
+        a->orm.texture.id == b->orm.texture.id &&
+        a->cullMode == b->cullMode;
+}
+
+static r3d_draw_batch_material_t get_batch_material(const R3D_Material* material)
+{
+    Vector4 albedo = ColorNormalize(material->albedo.color);
+    Vector4 emission = ColorNormalize(material->emission.color);
+    float energy = material->emission.energy;
+
+    return (r3d_draw_batch_material_t) {
+        .albedo = albedo,
+        .emission = {emission.x * energy, emission.y * energy, emission.z * energy, material->alphaCutoff},
+        .params = {material->normal.scale, material->orm.occlusion, material->orm.roughness, material->orm.metalness},
+        .texCoord = {material->uvOffset.x, material->uvOffset.y, material->uvScale.x, material->uvScale.y}
+    };
+}
+
+static void draw(const r3d_draw_call_t* call, GLuint vao)
+{
+    GLenum primitive = get_opengl_primitive(call->mesh.primitiveType);
+
+    r3d_state_bind_vao(vao);
+    if (call->mesh.ebo == 0) {
+        glDrawArrays(primitive, call->mesh.baseVertex, call->mesh.vertexCount);
+        count_draw(call, call->mesh.vertexCount, 1);
+    }
+    else {
+        int firstIndex = 0, indexCount = 0;
+        get_call_indices(call, &firstIndex, &indexCount);
+        const void* offset = (const void*)((uintptr_t)firstIndex * sizeof(uint32_t));
+        glDrawElementsBaseVertex(primitive, indexCount, GL_UNSIGNED_INT, offset, call->mesh.baseVertex);
+        count_draw(call, indexCount, 1);
+    }
+}
+
+static void draw_instanced(const r3d_draw_call_t* call, GLuint vao, int locInstanceModel, int locInstanceColor)
+{
+    r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+
+    GLuint vboTransforms = 0, vboColors = 0, vboAnimations = 0;
+    size_t transOffset = 0, colOffset = 0, animOffset = 0;
+
+    if (group->instanced.buffer != NULL) {
+        const R3D_InstanceBuffer* buffer = group->instanced.buffer;
+        vboTransforms = buffer->vboTransforms;
+        vboColors = buffer->vboColors;
+        transOffset = (size_t)buffer->segment * buffer->capacity * sizeof(Matrix);
+        colOffset = (size_t)buffer->segment * buffer->capacity * sizeof(Color);
+        if (r3d_draw_has_baked_animation(group)) {
+            vboAnimations = buffer->vboAnimations;
+            animOffset = (size_t)buffer->segment * buffer->capacity * sizeof(R3D_InstanceAnimation);
+        }
+    }
+    else {
+        upload_group_instances(group);
+        if (!is_group_uploaded(group)) return;
+        vboTransforms = R3D_MOD_STREAM.buffer;
+        vboColors = (group->instanced.colors || group->instanced.particles || group->instanced.sprites) ? vboTransforms : 0;
+        transOffset = group->stream.transOffset;
+        colOffset = group->stream.colOffset;
+    }
+
+    // Replace the instance source by the visible instances compacted on the GPU
+    bool indirect = false;
+    size_t cmdOffset = 0;
+
+    if (locInstanceColor < 0) {
+        vboColors = 0;
+    }
+
+    if (should_cull_instances(call, group)) {
+        size_t culledTransOffset = 0, culledColOffset = 0, culledAnimOffset = 0;
+        indirect = cull_instances(
+            call, group, vboTransforms, transOffset, vboColors, colOffset, vboAnimations, animOffset,
+            &culledTransOffset, &culledColOffset, &culledAnimOffset, &cmdOffset
+        );
+        if (indirect) {
+            vboTransforms = R3D_MOD_DRAW.cullOutput.buffer;
+            vboColors = vboColors ? vboTransforms : 0;
+            vboAnimations = vboAnimations ? vboTransforms : 0;
+            transOffset = culledTransOffset;
+            colOffset = group->instanced.particles ? culledTransOffset + offsetof(R3D_ParticleInstance, color) : culledColOffset;
+            animOffset = culledAnimOffset;
+        }
+    }
+
+    r3d_state_bind_vao(vao);
+
+    // Particle and sprite records only fill the first three columns of the matrix attribute,
+    // they are expanded into a matrix by the vertex shader
+    bool particles = (group->instanced.particles != NULL);
+    bool sprites = (group->instanced.sprites != NULL);
+    int numModelColumns = (particles || sprites) ? 3 : 4;
+
+    // Enable the attribute for the transformation matrix (decomposed into 4 vec4 vectors)
+    if (locInstanceModel >= 0 && vboTransforms != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, vboTransforms);
+        if (particles) {
+            GLsizei stride = sizeof(R3D_ParticleInstance);
+            glVertexAttribPointer(locInstanceModel + 0, 3, GL_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_ParticleInstance, position)));
+            glVertexAttribPointer(locInstanceModel + 1, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_ParticleInstance, rotation)));
+            glVertexAttribPointer(locInstanceModel + 2, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_ParticleInstance, scale)));
+        }
+        else if (sprites) {
+            GLsizei stride = sizeof(R3D_Sprite);
+            glVertexAttribPointer(locInstanceModel + 0, 4, GL_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_Sprite, position)));
+            glVertexAttribPointer(locInstanceModel + 1, 2, GL_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_Sprite, size)));
+            glVertexAttribPointer(locInstanceModel + 2, 4, GL_FLOAT, GL_FALSE, stride, (void*)(transOffset + offsetof(R3D_Sprite, uvRect)));
+        }
+        else {
+            for (int i = 0; i < 4; i++) {
+                glVertexAttribPointer(locInstanceModel + i, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix), (void*)(transOffset + i * sizeof(Vector4)));
+            }
+        }
+        for (int i = 0; i < numModelColumns; i++) {
+            glEnableVertexAttribArray(locInstanceModel + i);
+            glVertexAttribDivisor(locInstanceModel + i, 1);
+        }
+    }
+
+    // Handle per-instance colors if available
+    if (locInstanceColor >= 0 && vboColors != 0) {
+        GLsizei stride = particles ? sizeof(R3D_ParticleInstance) : sprites ? sizeof(R3D_Sprite) : sizeof(Color);
+        glBindBuffer(GL_ARRAY_BUFFER, vboColors);
+        glEnableVertexAttribArray(locInstanceColor);
+        glVertexAttribPointer(locInstanceColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)colOffset);
+        glVertexAttribDivisor(locInstanceColor, 1);
+    }
+
+    // Handle per-instance baked animations, the time is read back from its bits in the shaders
+    if (vboAnimations != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, vboAnimations);
+        glEnableVertexAttribArray(INSTANCE_ANIMATION_LOCATION);
+        glVertexAttribIPointer(INSTANCE_ANIMATION_LOCATION, 2, GL_INT, sizeof(R3D_InstanceAnimation), (void*)animOffset);
+        glVertexAttribDivisor(INSTANCE_ANIMATION_LOCATION, 1);
+    }
+
+    // Draw the geometry, the instances culled on the GPU are unknown here
+    int vertexCount = (call->mesh.ebo == 0) ? call->mesh.vertexCount : call->mesh.indexCount;
+    count_draw(call, vertexCount, (int)group->instanced.count);
+
+    if (indirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, R3D_MOD_DRAW.cullOutput.buffer);
+        if (call->mesh.ebo == 0) {
+            glDrawArraysIndirect(get_opengl_primitive(call->mesh.primitiveType), (void*)cmdOffset);
+        }
+        else {
+            glDrawElementsIndirect(get_opengl_primitive(call->mesh.primitiveType), GL_UNSIGNED_INT, (void*)cmdOffset);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else if (call->mesh.ebo == 0) {
+        glDrawArraysInstanced(
+            get_opengl_primitive(call->mesh.primitiveType),
+            call->mesh.baseVertex, call->mesh.vertexCount, (int)group->instanced.count
+        );
+    }
+    else {
+        glDrawElementsInstancedBaseVertex(
+            get_opengl_primitive(call->mesh.primitiveType),
+            call->mesh.indexCount, GL_UNSIGNED_INT, get_index_offset(&call->mesh),
+            (int)group->instanced.count, call->mesh.baseVertex
+        );
+    }
+
+    // Clean up instanced data
+    if (locInstanceModel >= 0 && vboTransforms != 0) {
+        for (int i = 0; i < numModelColumns; i++) {
+            glDisableVertexAttribArray(locInstanceModel + i);
+            glVertexAttribDivisor(locInstanceModel + i, 0);
+        }
+    }
+    if (locInstanceColor >= 0 && vboColors != 0) {
+        glDisableVertexAttribArray(locInstanceColor);
+        glVertexAttribDivisor(locInstanceColor, 0);
+    }
+    if (vboAnimations != 0) {
+        glDisableVertexAttribArray(INSTANCE_ANIMATION_LOCATION);
+        glVertexAttribDivisor(INSTANCE_ANIMATION_LOCATION, 0);
+    }
+
+    // NOTE: The vertex array stays bound, consecutive draws of the same mesh don't rebind it
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 // ========================================
-// MODULE FUNCTIONS
+// INTERNAL VISIBILITY FUNCTIONS
 // ========================================
 
-bool r3d_draw_init(void)
+static inline bool is_group_visible(int groupIndex)
 {
-    const int DRAW_RESERVE_COUNT = 1024;
+    return (R3D_MOD_DRAW.visibleGroups[groupIndex >> 5] >> (groupIndex & 31)) & 1u;
+}
 
-    #define ALLOC_AND_ASSIGN(field, logfmt, ...)  do { \
-        void* _p = RL_MALLOC(DRAW_RESERVE_COUNT * sizeof(*R3D_MOD_DRAW.field)); \
-        if (_p == NULL) { \
-            TraceLog(LOG_FATAL, "R3D: Failed to init draw module; " logfmt, ##__VA_ARGS__); \
-            goto fail; \
-        } \
-        R3D_MOD_DRAW.field = _p; \
-    } while (0)
+static inline void hide_group(int groupIndex)
+{
+    R3D_MOD_DRAW.visibleGroups[groupIndex >> 5] &= ~(1u << (groupIndex & 31));
+}
 
-    memset(&R3D_MOD_DRAW, 0, sizeof(R3D_MOD_DRAW));
+static void store_group_box(int groupIndex, Vector3 center, Vector3 extent)
+{
+    r3d_frustum_boxes_t* boxes = &R3D_MOD_DRAW.groupBoxes;
+
+    boxes->centerX[groupIndex] = center.x;
+    boxes->centerY[groupIndex] = center.y;
+    boxes->centerZ[groupIndex] = center.z;
+    boxes->extentX[groupIndex] = extent.x;
+    boxes->extentY[groupIndex] = extent.y;
+    boxes->extentZ[groupIndex] = extent.z;
+}
 
-    ALLOC_AND_ASSIGN(calls, "Draw call array allocation failed");
-    ALLOC_AND_ASSIGN(groups, "Draw group array allocation failed");
-    ALLOC_AND_ASSIGN(callIndices, "Draw call indices array allocation failed");
-    ALLOC_AND_ASSIGN(groupIndices, "Draw group indices array allocation failed");
-    ALLOC_AND_ASSIGN(visibleGroups, "Visible group array allocation failed");
-    ALLOC_AND_ASSIGN(cacheDists, "Distance cache array allocation failed");
+/*
+ * Returns the height of the world box of a group projected by the camera of the frame,
+ * as a fraction of the screen height. Unbounded groups and groups containing the camera
+ * get an infinite size so that they always use the full mesh.
+ */
+static float get_group_screen_size(int groupIndex)
+{
+    const r3d_frustum_boxes_t* boxes = &R3D_MOD_DRAW.groupBoxes;
 
-    for (int i = 0; i < R3D_DRAW_LIST_COUNT; i++) {
-        ALLOC_AND_ASSIGN(list[i].calls, "Draw call array %i allocation failed", i);
+    Vector3 extent = {boxes->extentX[groupIndex], boxes->extentY[groupIndex], boxes->extentZ[groupIndex]};
+    if (extent.x >= R3D_FRUSTUM_INFINITE_EXTENT) {
+        return FLT_MAX;
     }
 
-    #undef ALLOC_AND_ASSIGN
+    const r3d_view_state_t* view = &R3D_CACHE_GET(viewState);
+    float radius = Vector3Length(extent);
 
-    R3D_MOD_DRAW.capacity = DRAW_RESERVE_COUNT;
+    // Orthographic projections don't depend on the distance
+    if (view->proj.m15 == 1.0f) {
+        return radius * view->proj.m5;
+    }
+
+    Vector3 center = {boxes->centerX[groupIndex], boxes->centerY[groupIndex], boxes->centerZ[groupIndex]};
+    float distance = Vector3Distance(center, view->viewPosition);
+    if (distance <= radius) {
+        return FLT_MAX;
+    }
+
+    return radius * view->proj.m5 / distance;
+}
+
+static bool is_call_visible(const r3d_draw_call_t* call, const r3d_frustum_t* frustum)
+{
+    int callIndex = get_draw_call_index(call);
+    int groupIndex = R3D_MOD_DRAW.groupIndices[callIndex];
+    if (!is_group_visible(groupIndex)) return false;
+
+    // If the number of calls to this group is 1, then the object has already been tested
+    if (R3D_MOD_DRAW.callIndices[groupIndex].numCall == 1) {
+        return true;
+    }
+
+    const r3d_draw_group_t* group = &R3D_MOD_DRAW.groups[groupIndex];
+    const BoundingBox* aabb = get_group_aabb(group);
+
+    // If the AABB is 'zero', the object is considered visible
+    if (memcmp(aabb, &(BoundingBox){0}, sizeof(BoundingBox)) == 0) {
+        return true;
+    }
+
+    if (r3d_matrix_is_identity(&group->transform)) {
+        return r3d_frustum_is_aabb_in(frustum, aabb);
+    }
+
+    return r3d_frustum_is_obb_in(frustum, aabb, &group->transform);
+}
+
+static int select_mesh_lod(const R3D_Mesh* mesh, float screenSize)
+{
+    int lod = 0;
+    while (lod < mesh->lodCount && screenSize < mesh->lods[lod].screenSize) {
+        lod++;
+    }
+    return lod;
+}
+
+// ========================================
+// INTERNAL DECAL FUNCTIONS
+// ========================================
+
+#define DECAL_TILE_COUNT (R3D_SHADER_DECAL_TILE_X * R3D_SHADER_DECAL_TILE_Y)
+
+static bool decal_buffers_create(void)
+{
+    glGenBuffers(1, &R3D_MOD_DRAW.decals.paramBuffer);
+    glGenBuffers(1, &R3D_MOD_DRAW.decals.tileBuffer);
+    glGenBuffers(1, &R3D_MOD_DRAW.decals.indexBuffer);
+    glGenTextures(1, &R3D_MOD_DRAW.decals.paramTexture);
+    glGenTextures(1, &R3D_MOD_DRAW.decals.tileTexture);
+    glGenTextures(1, &R3D_MOD_DRAW.decals.indexTexture);
+
+    const struct { uint32_t buffer, texture; GLenum format; } views[3] = {
+        { R3D_MOD_DRAW.decals.paramBuffer, R3D_MOD_DRAW.decals.paramTexture, GL_RGBA32F },
+        { R3D_MOD_DRAW.decals.tileBuffer, R3D_MOD_DRAW.decals.tileTexture, GL_RG32UI },
+        { R3D_MOD_DRAW.decals.indexBuffer, R3D_MOD_DRAW.decals.indexTexture, GL_R32UI },
+    };
+
+    for (int i = 0; i < 3; i++) {
+        glBindBuffer(GL_TEXTURE_BUFFER, views[i].buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, views[i].texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, views[i].format, views[i].buffer);
+    }
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return R3D_MOD_DRAW.decals.paramBuffer != 0;
+}
+
+static void decal_buffers_release(void)
+{
+    if (R3D_MOD_DRAW.decals.paramBuffer != 0) {
+        glDeleteBuffers(1, &R3D_MOD_DRAW.decals.paramBuffer);
+        glDeleteBuffers(1, &R3D_MOD_DRAW.decals.tileBuffer);
+        glDeleteBuffers(1, &R3D_MOD_DRAW.decals.indexBuffer);
+        glDeleteTextures(1, &R3D_MOD_DRAW.decals.paramTexture);
+        glDeleteTextures(1, &R3D_MOD_DRAW.decals.tileTexture);
+        glDeleteTextures(1, &R3D_MOD_DRAW.decals.indexTexture);
+    }
+
+    RL_FREE(R3D_MOD_DRAW.decals.params);
+    RL_FREE(R3D_MOD_DRAW.decals.tiles);
+    RL_FREE(R3D_MOD_DRAW.decals.indices);
+}
+
+static bool decal_reserve(int count)
+{
+    if (count <= R3D_MOD_DRAW.decals.capacity) {
+        return true;
+    }
+
+    int newCapacity = (R3D_MOD_DRAW.decals.capacity > 0) ? R3D_MOD_DRAW.decals.capacity : 256;
+    while (newCapacity < count) newCapacity *= 2;
+
+    float* params = RL_REALLOC(R3D_MOD_DRAW.decals.params, newCapacity * R3D_DRAW_DECAL_TEXELS * 4 * sizeof(float));
+    if (params == NULL) return false;
+    R3D_MOD_DRAW.decals.params = params;
+
+    int* tiles = RL_REALLOC(R3D_MOD_DRAW.decals.tiles, newCapacity * 4 * sizeof(int));
+    if (tiles == NULL) return false;
+    R3D_MOD_DRAW.decals.tiles = tiles;
+
+    R3D_MOD_DRAW.decals.capacity = newCapacity;
+
+    return true;
+}
+
+static bool decal_reserve_indices(uint32_t count)
+{
+    if (count <= (uint32_t)R3D_MOD_DRAW.decals.indexCapacity) {
+        return true;
+    }
+
+    uint32_t newCapacity = (R3D_MOD_DRAW.decals.indexCapacity > 0) ? R3D_MOD_DRAW.decals.indexCapacity : 1024;
+    while (newCapacity < count) newCapacity *= 2;
+
+    uint32_t* indices = RL_REALLOC(R3D_MOD_DRAW.decals.indices, newCapacity * sizeof(uint32_t));
+    if (indices == NULL) return false;
+
+    R3D_MOD_DRAW.decals.indices = indices;
+    R3D_MOD_DRAW.decals.indexCapacity = newCapacity;
+
+    return true;
+}
+
+/*
+ * Returns the batch whose textures are those of the material, or -1 if there is none.
+ * The normal map is not read by the decals, it is ignored.
+ */
+static int find_decal_batch(const R3D_Material* material, int numBatches)
+{
+    for (int i = 0; i < numBatches; i++) {
+        const R3D_Material* other = R3D_MOD_DRAW.decals.batches[i].material;
+        if (other->albedo.texture.id == material->albedo.texture.id &&
+            other->emission.texture.id == material->emission.texture.id &&
+            other->orm.texture.id == material->orm.texture.id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int get_decal_count(const r3d_draw_call_t* call)
+{
+    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+    return r3d_draw_has_instances(group) ? group->instanced.count : 1;
+}
+
+static int get_decal_tile(float ndc, int count)
+{
+    int t = (int)floorf((ndc * 0.5f + 0.5f) * count);
+    return (t < 0) ? 0 : (t >= count) ? count - 1 : t;
+}
+
+/*
+ * Appends a decal to its batch, with the parameters read by the clustered decal shader.
+ * Returns false if the decal box is off screen, the decal is then skipped.
+ */
+static bool push_decal(r3d_draw_decal_batch_t* batch, const R3D_Material* material,
+                       const Matrix* transform, Color tint, const Matrix* viewProj)
+{
+    /* --- Compute the tiles covered by the projected box --- */
+
+    Matrix mvp = r3d_matrix_multiply(transform, viewProj);
+
+    Vector2 minNDC = {+FLT_MAX, +FLT_MAX};
+    Vector2 maxNDC = {-FLT_MAX, -FLT_MAX};
+    bool allInFront = true;
+
+    for (int i = 0; i < 8; i++) {
+        Vector4 corner = {(i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f, 1.0f};
+        Vector4 clip = r3d_vector4_transform(corner, &mvp);
+        if (clip.w <= 0.0f) {
+            allInFront = false;
+            break;
+        }
+        Vector2 ndc = Vector2Scale((Vector2){clip.x, clip.y}, 1.0f / clip.w);
+        minNDC = Vector2Min(minNDC, ndc);
+        maxNDC = Vector2Max(maxNDC, ndc);
+    }
+
+    // Boxes crossing the camera plane cover the whole screen
+    int tiles[4] = {0, 0, R3D_SHADER_DECAL_TILE_X - 1, R3D_SHADER_DECAL_TILE_Y - 1};
+
+    if (allInFront) {
+        if (maxNDC.x < -1.0f || maxNDC.y < -1.0f || minNDC.x > 1.0f || minNDC.y > 1.0f) {
+            return false;
+        }
+        tiles[0] = get_decal_tile(minNDC.x, R3D_SHADER_DECAL_TILE_X);
+        tiles[1] = get_decal_tile(minNDC.y, R3D_SHADER_DECAL_TILE_Y);
+        tiles[2] = get_decal_tile(maxNDC.x, R3D_SHADER_DECAL_TILE_X);
+        tiles[3] = get_decal_tile(maxNDC.y, R3D_SHADER_DECAL_TILE_Y);
+    }
+
+    int index = batch->firstDecal + batch->numDecals++;
+    memcpy(&R3D_MOD_DRAW.decals.tiles[4 * index], tiles, sizeof(tiles));
+
+    if (tiles[0] < batch->tileMin[0]) batch->tileMin[0] = tiles[0];
+    if (tiles[1] < batch->tileMin[1]) batch->tileMin[1] = tiles[1];
+    if (tiles[2] > batch->tileMax[0]) batch->tileMax[0] = tiles[2];
+    if (tiles[3] > batch->tileMax[1]) batch->tileMax[1] = tiles[3];
+
+    /* --- Store the parameters, see 'decal_clustered.frag' --- */
+
+    Matrix inv = MatrixInvert(*transform);
+    Vector4 albedo = ColorNormalize(material->albedo.color);
+    Vector4 color = ColorNormalize(tint);
+    Vector4 emission = ColorNormalize(material->emission.color);
+    float energy = material->emission.energy;
+
+    const float params[R3D_DRAW_DECAL_TEXELS * 4] = {
+        inv.m0, inv.m4, inv.m8, inv.m12,
+        inv.m1, inv.m5, inv.m9, inv.m13,
+        inv.m2, inv.m6, inv.m10, inv.m14,
+        albedo.x * color.x, albedo.y * color.y, albedo.z * color.z, albedo.w * color.w,
+        emission.x * energy, emission.y * energy, emission.z * energy, material->alphaCutoff,
+        material->uvOffset.x, material->uvOffset.y, material->uvScale.x, material->uvScale.y,
+        material->orm.occlusion, material->orm.roughness, material->orm.metalness, 0.0f,
+    };
+
+    memcpy(&R3D_MOD_DRAW.decals.params[index * R3D_DRAW_DECAL_TEXELS * 4], params, sizeof(params));
+
+    return true;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_draw_init(void)
+{
+    const int DRAW_RESERVE_COUNT = 1024;
+
+    memset(&R3D_MOD_DRAW, 0, sizeof(R3D_MOD_DRAW));
+
+    if (!reserve_arrays(DRAW_RESERVE_COUNT)) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init draw module; Draw array allocation failed");
+        goto fail;
+    }
 
     return true;
 
@@ -220,15 +1187,20 @@ fail:
 
 void r3d_draw_quit(void)
 {
-    for (int i = 0; i < R3D_DRAW_LIST_COUNT; i++) {
-        RL_FREE(R3D_MOD_DRAW.list[i].calls);
+    cull_output_release();
+    decal_buffers_release();
+
+    for (int i = 0; i < R3D_MOD_DRAW.materials.numBlocks; i++) {
+        RL_FREE(R3D_MOD_DRAW.materials.blocks[i]);
     }
-    RL_FREE(R3D_MOD_DRAW.visibleGroups);
-    RL_FREE(R3D_MOD_DRAW.groupIndices);
-    RL_FREE(R3D_MOD_DRAW.callIndices);
-    RL_FREE(R3D_MOD_DRAW.cacheDists);
-    RL_FREE(R3D_MOD_DRAW.groups);
-    RL_FREE(R3D_MOD_DRAW.calls);
+    RL_FREE(R3D_MOD_DRAW.materials.blocks);
+
+    while (R3D_MOD_DRAW.buffers.count > 0) {
+        r3d_draw_buffer_destroy(R3D_MOD_DRAW.buffers.list[R3D_MOD_DRAW.buffers.count - 1]);
+    }
+    RL_FREE(R3D_MOD_DRAW.buffers.list);
+
+    RL_FREE(R3D_MOD_DRAW.arrays);
 }
 
 void r3d_draw_clear(void)
@@ -236,11 +1208,22 @@ void r3d_draw_clear(void)
     for (int i = 0; i < R3D_DRAW_LIST_COUNT; i++) {
         R3D_MOD_DRAW.list[i].numCalls = 0;
     }
+    R3D_MOD_DRAW.batch.numCalls = 0;
+    R3D_MOD_DRAW.bucket.numCalls = 0;
+    R3D_MOD_DRAW.materials.count = 0;
+    R3D_MOD_DRAW.cullFrustum = NULL;
     R3D_MOD_DRAW.numGroups = 0;
     R3D_MOD_DRAW.numCalls = 0;
 }
 
 void r3d_draw_group_push(const r3d_draw_group_t* group)
+{
+    Vector3 center, extent;
+    r3d_frustum_get_world_box(&group->aabb, &group->transform, &center, &extent);
+    r3d_draw_group_push_bounded(group, center, extent);
+}
+
+void r3d_draw_group_push_bounded(const r3d_draw_group_t* group, Vector3 center, Vector3 extent)
 {
     if (R3D_MOD_DRAW.numGroups >= R3D_MOD_DRAW.capacity) {
         if (!growth_arrays()) {
@@ -252,9 +1235,29 @@ void r3d_draw_group_push(const r3d_draw_group_t* group)
     int groupIndex = R3D_MOD_DRAW.numGroups++;
     R3D_MOD_DRAW.callIndices[groupIndex] = (r3d_draw_indices_t) {0};
     R3D_MOD_DRAW.groups[groupIndex] = *group;
+
+    store_group_box(groupIndex, center, extent);
 }
 
-void r3d_draw_call_push(const r3d_draw_call_t* call, bool decal)
+void r3d_draw_call_push(const r3d_draw_call_t* call, const R3D_Material* material, bool decal)
+{
+    // Intern the material first, the call is dropped if it fails
+    R3D_Material defaultMaterial;
+    if (material == NULL) {
+        defaultMaterial = R3D_GetDefaultMaterial();
+        material = &defaultMaterial;
+    }
+
+    const R3D_Material* interned = intern_material(material);
+    if (interned == NULL) {
+        TraceLog(LOG_FATAL, "R3D: Bad alloc on draw call material interning");
+        return;
+    }
+
+    r3d_draw_call_push_retained(call, interned, decal);
+}
+
+void r3d_draw_call_push_retained(const r3d_draw_call_t* call, const R3D_Material* material, bool decal)
 {
     if (R3D_MOD_DRAW.numCalls >= R3D_MOD_DRAW.capacity) {
         if (!growth_arrays()) {
@@ -278,113 +1281,293 @@ void r3d_draw_call_push(const r3d_draw_call_t* call, bool decal)
     // Set group index for this draw call
     R3D_MOD_DRAW.groupIndices[callIndex] = groupIndex;
 
+    // Copy the draw call with its material reference
+    r3d_draw_call_t* drawCall = &R3D_MOD_DRAW.calls[callIndex];
+    drawCall->mesh = call->mesh;
+    drawCall->material = material;
+    drawCall->lod = 0;
+    drawCall->shadowLod = 0;
+    drawCall->preSkinned = false;
+
+    // Instanced draws are spread over many places, they always use the full mesh
+    if (call->mesh.lodCount > 0 && !r3d_draw_has_instances(group)) {
+        float screenSize = get_group_screen_size(groupIndex);
+        drawCall->lod = select_mesh_lod(&call->mesh, screenSize * R3D_CACHE_GET(lodBias));
+        drawCall->shadowLod = select_mesh_lod(&call->mesh, screenSize * R3D_CACHE_GET(shadowLodBias));
+    }
+
     // Determine the draw call list
     r3d_draw_list_enum_t list = R3D_DRAW_DEFERRED;
     if (decal) list = R3D_DRAW_DECAL;
-    else if (IS_CALL_PREPASS(call)) list = R3D_DRAW_PREPASS;
-    else if (IS_CALL_FORWARD(call)) list = R3D_DRAW_FORWARD;
+    else if (IS_CALL_PREPASS(drawCall)) list = R3D_DRAW_PREPASS;
+    else if (IS_CALL_FORWARD(drawCall)) list = R3D_DRAW_FORWARD;
     if (r3d_draw_has_instances(group)) list += 4;
 
-    // Push the draw call and its index to the list
-    R3D_MOD_DRAW.calls[callIndex] = *call;
+    // Push the draw call index to the list
     int listIndex = R3D_MOD_DRAW.list[list].numCalls++;
     R3D_MOD_DRAW.list[list].calls[listIndex] = callIndex;
 }
 
+R3D_DrawBuffer* r3d_draw_buffer_create(void)
+{
+    if (R3D_MOD_DRAW.buffers.count >= R3D_MOD_DRAW.buffers.capacity) {
+        int newCapacity = R3D_MOD_DRAW.buffers.capacity ? 2 * R3D_MOD_DRAW.buffers.capacity : 8;
+        R3D_DrawBuffer** newList = RL_REALLOC(R3D_MOD_DRAW.buffers.list, newCapacity * sizeof(*newList));
+        if (newList == NULL) return NULL;
+        R3D_MOD_DRAW.buffers.list = newList;
+        R3D_MOD_DRAW.buffers.capacity = newCapacity;
+    }
+
+    R3D_DrawBuffer* buffer = RL_CALLOC(1, sizeof(*buffer));
+    if (buffer == NULL) return NULL;
+
+    R3D_MOD_DRAW.buffers.list[R3D_MOD_DRAW.buffers.count++] = buffer;
+
+    return buffer;
+}
+
+void r3d_draw_buffer_destroy(R3D_DrawBuffer* buffer)
+{
+    for (int i = 0; i < R3D_MOD_DRAW.buffers.count; i++) {
+        if (R3D_MOD_DRAW.buffers.list[i] != buffer) continue;
+        int numToMove = R3D_MOD_DRAW.buffers.count - i - 1;
+        if (numToMove > 0) {
+            memmove(
+                &R3D_MOD_DRAW.buffers.list[i],
+                &R3D_MOD_DRAW.buffers.list[i + 1],
+                numToMove * sizeof(R3D_MOD_DRAW.buffers.list[0])
+            );
+        }
+        R3D_MOD_DRAW.buffers.count--;
+        break;
+    }
+
+    RL_FREE(buffer->groups);
+    RL_FREE(buffer->calls);
+    RL_FREE(buffer);
+}
+
+bool r3d_draw_buffer_push_group(R3D_DrawBuffer* buffer, const r3d_draw_group_t* group)
+{
+    if (buffer->numGroups >= buffer->capacityGroups) {
+        int newCapacity = buffer->capacityGroups ? 2 * buffer->capacityGroups : 64;
+        r3d_draw_buffer_group_t* newGroups = RL_REALLOC(buffer->groups, newCapacity * sizeof(*newGroups));
+        if (newGroups == NULL) return false;
+        buffer->groups = newGroups;
+        buffer->capacityGroups = newCapacity;
+    }
+
+    r3d_draw_buffer_group_t* entry = &buffer->groups[buffer->numGroups++];
+
+    entry->group = *group;
+    entry->firstCall = buffer->numCalls;
+    entry->numCalls = 0;
+
+    r3d_frustum_get_world_box(&group->aabb, &group->transform, &entry->center, &entry->extent);
+
+    return true;
+}
+
+bool r3d_draw_buffer_push_call(R3D_DrawBuffer* buffer, const R3D_Mesh* mesh, const R3D_Material* material)
+{
+    assert(buffer->numGroups > 0);
+
+    if (buffer->numCalls >= buffer->capacityCalls) {
+        int newCapacity = buffer->capacityCalls ? 2 * buffer->capacityCalls : 64;
+        r3d_draw_buffer_call_t* newCalls = RL_REALLOC(buffer->calls, newCapacity * sizeof(*newCalls));
+        if (newCalls == NULL) return false;
+        buffer->calls = newCalls;
+        buffer->capacityCalls = newCapacity;
+    }
+
+    r3d_draw_buffer_call_t* entry = &buffer->calls[buffer->numCalls++];
+
+    entry->mesh = *mesh;
+    entry->defaultMaterial = (material == NULL);
+    if (material != NULL) entry->material = *material;
+
+    buffer->groups[buffer->numGroups - 1].numCalls++;
+
+    return true;
+}
+
 r3d_draw_group_t* r3d_draw_get_call_group(const r3d_draw_call_t* call)
 {
     int callIndex = get_draw_call_index(call);
     int groupIndex = R3D_MOD_DRAW.groupIndices[callIndex];
     r3d_draw_group_t* group = &R3D_MOD_DRAW.groups[groupIndex];
 
-    return group;
+    return group;
+}
+
+void r3d_draw_get_call_world_box(const r3d_draw_call_t* call, Vector3* center, Vector3* extent)
+{
+    int callIndex = get_draw_call_index(call);
+    int groupIndex = R3D_MOD_DRAW.groupIndices[callIndex];
+    const r3d_frustum_boxes_t* boxes = &R3D_MOD_DRAW.groupBoxes;
+
+    *center = (Vector3) {boxes->centerX[groupIndex], boxes->centerY[groupIndex], boxes->centerZ[groupIndex]};
+    *extent = (Vector3) {boxes->extentX[groupIndex], boxes->extentY[groupIndex], boxes->extentZ[groupIndex]};
+}
+
+void r3d_draw_compute_visible_groups(const r3d_frustum_t* frustum)
+{
+    R3D_MOD_DRAW.cullFrustum = frustum;
+
+    // Groups of the retained scene are pushed last and culled through its BVH
+    int numGroups = R3D_MOD_DRAW.numGroups - R3D_MOD_SCENE.numGroups;
+
+    r3d_frustum_cull_boxes(
+        frustum, &R3D_MOD_DRAW.groupBoxes,
+        numGroups, R3D_MOD_DRAW.visibleGroups
+    );
+
+    int firstWord = (numGroups + 31) / 32;
+    int numWords = (R3D_MOD_DRAW.numGroups + 31) / 32;
+    if (numWords > firstWord) {
+        memset(&R3D_MOD_DRAW.visibleGroups[firstWord], 0, (numWords - firstWord) * sizeof(uint32_t));
+    }
+
+    r3d_scene_cull_groups(frustum, R3D_MOD_DRAW.visibleGroups);
 }
 
-void r3d_draw_compute_visible_groups(const r3d_frustum_t* frustum)
+void r3d_draw_cull_occluded_groups(void)
 {
     for (int i = 0; i < R3D_MOD_DRAW.numGroups; i++)
     {
+        if (!is_group_visible(i)) continue;
+
         const r3d_draw_group_t* group = &R3D_MOD_DRAW.groups[i];
         const BoundingBox* aabb = get_group_aabb(group);
 
+        // Objects without AABB can't be tested, they are always considered visible
         if (memcmp(aabb, &(BoundingBox){0}, sizeof(BoundingBox)) == 0) {
-            R3D_MOD_DRAW.visibleGroups[i] = true;
+            continue;
         }
-        else if (r3d_matrix_is_identity(&group->transform)) {
-            R3D_MOD_DRAW.visibleGroups[i] = r3d_frustum_is_aabb_in(frustum, aabb);
+
+        if (r3d_occlusion_is_group_occluded(aabb, &group->transform)) {
+            hide_group(i);
         }
-        else {
-            R3D_MOD_DRAW.visibleGroups[i] = r3d_frustum_is_obb_in(frustum, aabb, &group->transform);
+    }
+}
+
+void r3d_draw_record_animation_lods(bool culled)
+{
+    uint32_t frame = R3D_MOD_DRAW.frameIndex;
+
+    for (int i = 0; i < R3D_MOD_DRAW.numGroups; i++)
+    {
+        R3D_AnimationPlayer* player = R3D_MOD_DRAW.groups[i].player;
+        if (player == NULL || (culled && !is_group_visible(i))) continue;
+
+        // A player can be drawn by several groups, the largest one is kept
+        float screenSize = get_group_screen_size(i);
+        if (player->lodFrame != frame || player->lodScreenSize < screenSize) {
+            player->lodScreenSize = screenSize;
         }
+        player->lodFrame = frame;
+    }
+}
+
+void r3d_draw_preskin_calls(void)
+{
+    for (int i = 0; i < R3D_MOD_DRAW.numCalls; i++)
+    {
+        r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[i];
+        const r3d_draw_group_t* group = &R3D_MOD_DRAW.groups[R3D_MOD_DRAW.groupIndices[i]];
+
+        // The poses of baked animations are selected per instance by the vertex shaders
+        if (r3d_draw_has_baked_animation(group) || !r3d_preskin_is_supported(&call->mesh)) continue;
+        if (group->player == NULL && !R3D_IsSkeletonValid(&group->skeleton)) continue;
+
+        int poseOffset = group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset;
+        call->preSkinned = r3d_preskin_apply(&call->mesh, poseOffset);
+    }
+}
+
+void r3d_draw_request_texture_levels(float viewHeight)
+{
+    for (int i = 0; i < R3D_MOD_DRAW.numCalls; i++)
+    {
+        const r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[i];
+        const R3D_Material* material = call->material;
+
+        // The texture repeats 'uvScale' times over the height of the group
+        float screenSize = get_group_screen_size(R3D_MOD_DRAW.groupIndices[i]);
+        float uvScale = fmaxf(fabsf(material->uvScale.x), fabsf(material->uvScale.y));
+        float pixels = (screenSize < FLT_MAX) ? screenSize * viewHeight / fmaxf(uvScale, 1e-3f) : FLT_MAX;
+
+        r3d_texture_stream_request(material->albedo.texture.id, pixels);
+        r3d_texture_stream_request(material->emission.texture.id, pixels);
+        r3d_texture_stream_request(material->normal.texture.id, pixels);
+        r3d_texture_stream_request(material->orm.texture.id, pixels);
     }
 }
 
 bool r3d_draw_call_is_visible(const r3d_draw_call_t* call, const r3d_frustum_t* frustum)
 {
+    if (is_call_visible(call, frustum)) {
+        return true;
+    }
+
+    if (R3D_MOD_DRAW.shadowLods) R3D_PROFILE_COUNT(shadowCulledCalls, 1);
+    else R3D_PROFILE_COUNT(viewCulledCalls, 1);
+
+    return false;
+}
+
+uint32_t r3d_draw_call_get_view_mask(const r3d_draw_call_t* call, const r3d_frustum_t* frustums, int count)
+{
+    assert(count <= 32);
+
     int callIndex = get_draw_call_index(call);
     int groupIndex = R3D_MOD_DRAW.groupIndices[callIndex];
-    if (!R3D_MOD_DRAW.visibleGroups[groupIndex]) return false;
-
-    // If the number of calls to this group is 1, then the object has already been tested
-    if (R3D_MOD_DRAW.callIndices[groupIndex].numCall == 1) {
-        return true;
+    if (!is_group_visible(groupIndex)) {
+        R3D_PROFILE_COUNT(shadowCulledCalls, 1);
+        return 0;
     }
 
+    uint32_t allViews = (count == 32) ? ~0u : (1u << count) - 1;
+
     const r3d_draw_group_t* group = &R3D_MOD_DRAW.groups[groupIndex];
     const BoundingBox* aabb = get_group_aabb(group);
 
     // If the AABB is 'zero', the object is considered visible
     if (memcmp(aabb, &(BoundingBox){0}, sizeof(BoundingBox)) == 0) {
-        return true;
+        return allViews;
     }
 
-    if (r3d_matrix_is_identity(&group->transform)) {
-        return r3d_frustum_is_aabb_in(frustum, aabb);
+    // The world box is tested against each frustum, rather than the OBB for each of them
+    Vector3 center, extent;
+    r3d_frustum_get_world_box(aabb, &group->transform, &center, &extent);
+    BoundingBox worldBox = {Vector3Subtract(center, extent), Vector3Add(center, extent)};
+
+    uint32_t mask = 0;
+    for (int i = 0; i < count; i++) {
+        if (r3d_frustum_is_aabb_in(&frustums[i], &worldBox)) mask |= (1u << i);
     }
 
-    return r3d_frustum_is_obb_in(frustum, aabb, &group->transform);
+    if (mask == 0) {
+        R3D_PROFILE_COUNT(shadowCulledCalls, 1);
+    }
+
+    return mask;
 }
 
 void r3d_draw_sort_list(r3d_draw_list_enum_t list, Vector3 viewPosition, r3d_draw_sort_enum_t mode)
 {
-    G_sortViewPosition = viewPosition;
-
     r3d_draw_list_t* drawList = &R3D_MOD_DRAW.list[list];
+    if (drawList->numCalls <= 1) return;
 
-    if (mode == R3D_DRAW_SORT_BACK_TO_FRONT) {
-        for (int i = 0; i < drawList->numCalls; i++) {
-            int callIndex = drawList->calls[i];
-            const r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[callIndex];
-            R3D_MOD_DRAW.cacheDists[callIndex] = calculate_max_distance_to_camera(call);
-        }
-    }
-    else {
-        for (int i = 0; i < drawList->numCalls; i++) {
-            int callIndex = drawList->calls[i];
-            const r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[callIndex];
-            R3D_MOD_DRAW.cacheDists[callIndex] = calculate_center_distance_to_camera(call);
-        }
-    }
-
-    int (*compare_func)(const void *a, const void *b) = NULL;
-
-    switch (mode) {
-    case R3D_DRAW_SORT_FRONT_TO_BACK:
-        compare_func = compare_front_to_back;
-        break;
-    case R3D_DRAW_SORT_BACK_TO_FRONT:
-        compare_func = compare_back_to_front;
-        break;
-    default:
-        assert(false);
-        return;
+    for (int i = 0; i < drawList->numCalls; i++) {
+        const r3d_draw_call_t* call = &R3D_MOD_DRAW.calls[drawList->calls[i]];
+        R3D_MOD_DRAW.sortKeys[i] = build_sort_key(call, viewPosition, mode);
     }
 
-    qsort(
-        drawList->calls,
-        drawList->numCalls,
-        sizeof(*drawList->calls),
-        compare_func
+    radix_sort(
+        R3D_MOD_DRAW.sortKeys, drawList->calls,
+        R3D_MOD_DRAW.sortKeysTmp, R3D_MOD_DRAW.sortValuesTmp,
+        drawList->numCalls
     );
 }
 
@@ -392,15 +1575,15 @@ void r3d_draw_apply_cull_mode(R3D_CullMode mode)
 {
     switch (mode) {
     case R3D_CULL_NONE:
-        glDisable(GL_CULL_FACE);
+        r3d_state_disable(GL_CULL_FACE);
         break;
     case R3D_CULL_BACK:
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
+        r3d_state_enable(GL_CULL_FACE);
+        r3d_state_cull_face(GL_BACK);
         break;
     case R3D_CULL_FRONT:
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);
+        r3d_state_enable(GL_CULL_FACE);
+        r3d_state_cull_face(GL_FRONT);
         break;
     }
 }
@@ -409,21 +1592,43 @@ void r3d_draw_apply_blend_mode(R3D_BlendMode blend, R3D_TransparencyMode transpa
 {
     switch (blend) {
     case R3D_BLEND_MIX:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        r3d_state_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         break;
     case R3D_BLEND_ADDITIVE:
         if (transparency == R3D_TRANSPARENCY_DISABLED) {
-            glBlendFunc(GL_ONE, GL_ONE);
+            r3d_state_blend_func(GL_ONE, GL_ONE);
         }
         else {
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+            r3d_state_blend_func(GL_SRC_ALPHA, GL_ONE);
         }
         break;
     case R3D_BLEND_MULTIPLY:
-        glBlendFunc(GL_DST_COLOR, GL_ZERO);
+        r3d_state_blend_func(GL_DST_COLOR, GL_ZERO);
+        break;
+    case R3D_BLEND_PREMULTIPLIED_ALPHA:
+        r3d_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    default:
+        break;
+    }
+}
+
+void r3d_draw_apply_reduced_blend_mode(R3D_BlendMode blend, R3D_TransparencyMode transparency)
+{
+    switch (blend) {
+    case R3D_BLEND_MIX:
+        r3d_state_blend_func_separate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case R3D_BLEND_ADDITIVE:
+        if (transparency == R3D_TRANSPARENCY_DISABLED) {
+            r3d_state_blend_func_separate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+        }
+        else {
+            r3d_state_blend_func_separate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
+        }
         break;
     case R3D_BLEND_PREMULTIPLIED_ALPHA:
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        r3d_state_blend_func_separate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
         break;
     default:
         break;
@@ -440,19 +1645,19 @@ void r3d_draw_apply_shadow_cast_mode(R3D_ShadowCastMode castMode, R3D_CullMode c
 
     case R3D_SHADOW_CAST_ON_DOUBLE_SIDED:
     case R3D_SHADOW_CAST_ONLY_DOUBLE_SIDED:
-        glDisable(GL_CULL_FACE);
+        r3d_state_disable(GL_CULL_FACE);
         break;
 
     case R3D_SHADOW_CAST_ON_FRONT_SIDE:
     case R3D_SHADOW_CAST_ONLY_FRONT_SIDE:
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
+        r3d_state_enable(GL_CULL_FACE);
+        r3d_state_cull_face(GL_BACK);
         break;
 
     case R3D_SHADOW_CAST_ON_BACK_SIDE:
     case R3D_SHADOW_CAST_ONLY_BACK_SIDE:
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_FRONT);
+        r3d_state_enable(GL_CULL_FACE);
+        r3d_state_cull_face(GL_FRONT);
         break;
 
     case R3D_SHADOW_CAST_DISABLED:
@@ -464,82 +1669,435 @@ void r3d_draw_apply_shadow_cast_mode(R3D_ShadowCastMode castMode, R3D_CullMode c
 
 void r3d_draw(const r3d_draw_call_t* call)
 {
-    GLenum primitive = get_opengl_primitive(call->mesh.primitiveType);
-
-    glBindVertexArray(call->mesh.vao);
-    if (call->mesh.ebo == 0) glDrawArrays(primitive, 0, call->mesh.vertexCount);
-    else glDrawElements(primitive, call->mesh.indexCount, GL_UNSIGNED_INT, NULL);
-    glBindVertexArray(0);
+    draw(call, call->mesh.vao);
 }
 
 void r3d_draw_instanced(const r3d_draw_call_t* call, int locInstanceModel, int locInstanceColor)
 {
-    // NOTE: All this mess here will be reviewed with the instance buffers
+    draw_instanced(call, call->mesh.vao, locInstanceModel, locInstanceColor);
+}
+
+bool r3d_draw_call_is_depth_only(const r3d_draw_call_t* call, float alphaCutoff)
+{
+    if (call->mesh.depthVao == 0) {
+        return false;
+    }
+
+    if (alphaCutoff <= 0.0f) {
+        return true;
+    }
+
+    // Without texcoords and vertex colors, the alpha only comes from the material color
+    const R3D_Material* material = call->material;
+    if ((float)material->albedo.color.a / 255 < alphaCutoff) {
+        return false;
+    }
+
+    return (material->albedo.texture.id == 0) || !has_alpha_channel(material->albedo.texture.format);
+}
+
+void r3d_draw_depth(const r3d_draw_call_t* call)
+{
+    draw(call, call->mesh.depthVao);
+}
+
+void r3d_draw_depth_instanced(const r3d_draw_call_t* call, int locInstanceModel)
+{
+    draw_instanced(call, call->mesh.depthVao, locInstanceModel, -1);
+}
+
+bool r3d_draw_call_is_batchable(const r3d_draw_call_t* call)
+{
+    if (call->material->shader != NULL || call->material->billboardMode != R3D_BILLBOARD_DISABLED) {
+        return false;
+    }
+
+    if (call->mesh.primitiveType != R3D_PRIMITIVE_TRIANGLES || call->mesh.ebo == 0) {
+        return false;
+    }
 
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+    if (r3d_draw_has_instances(group) || group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
+        return false;
+    }
 
-    glBindVertexArray(call->mesh.vao);
+    return r3d_arena_owns(call->mesh.vao);
+}
 
-    unsigned int vboTransforms = 0;
-    unsigned int vboColors = 0;
+bool r3d_draw_batch_accepts(const r3d_draw_call_t* call)
+{
+    if (!r3d_draw_call_is_batchable(call)) {
+        return false;
+    }
 
-    // Enable the attribute for the transformation matrix (decomposed into 4 vec4 vectors)
-    if (locInstanceModel >= 0 && group->instanced.transforms) {
-        size_t stride = (group->instanced.transStride == 0) ? sizeof(Matrix) : group->instanced.transStride;
+    if (R3D_MOD_DRAW.batch.numCalls == 0) {
+        return true;
+    }
 
-        // Create and bind VBO for transforms
-        glGenBuffers(1, &vboTransforms);
-        glBindBuffer(GL_ARRAY_BUFFER, vboTransforms);
-        glBufferData(GL_ARRAY_BUFFER, group->instanced.count * stride, group->instanced.transforms, GL_DYNAMIC_DRAW);
+    const r3d_draw_call_t* first = R3D_MOD_DRAW.batch.calls[0];
+
+    return (first->mesh.vao == call->mesh.vao) && is_same_batch_material(first->material, call->material);
+}
+
+void r3d_draw_batch_push(const r3d_draw_call_t* call)
+{
+    // NOTE: Can't overflow, there are never more pending calls than pushed calls
+    R3D_MOD_DRAW.batch.calls[R3D_MOD_DRAW.batch.numCalls++] = call;
+}
+
+void r3d_draw_batch_multi(int locInstanceModel, int locInstanceColor, int locInstanceMaterial)
+{
+    int count = R3D_MOD_DRAW.batch.numCalls;
+    if (count == 0) return;
+
+    bool perDrawMaterial = (locInstanceMaterial >= 0);
+    int64_t triangles = 0;
+
+    for (int i = 0; i < count; i++) {
+        const r3d_draw_call_t* call = R3D_MOD_DRAW.batch.calls[i];
+        int firstIndex = 0, indexCount = 0;
+        get_call_indices(call, &firstIndex, &indexCount);
+        triangles += indexCount / 3;
+        R3D_MOD_DRAW.batch.transforms[i] = r3d_draw_get_call_group(call)->transform;
+        R3D_MOD_DRAW.batch.commands[i] = (r3d_draw_indirect_t) {
+            .count = (uint32_t)indexCount,
+            .instanceCount = 1,
+            .firstIndex = (uint32_t)firstIndex,
+            .baseVertex = call->mesh.baseVertex,
+            .baseInstance = (uint32_t)i
+        };
+        if (perDrawMaterial) {
+            R3D_MOD_DRAW.batch.materials[i] = get_batch_material(call->material);
+        }
+    }
+
+    size_t transSize = count * sizeof(Matrix);
+    size_t cmdSize = count * sizeof(r3d_draw_indirect_t);
+    size_t matSize = perDrawMaterial ? count * sizeof(r3d_draw_batch_material_t) : 0;
+
+    if (!instance_stream_reserve(transSize + cmdSize + matSize + 48)) {
+        return;
+    }
+
+    size_t transOffset = instance_stream_write(R3D_MOD_DRAW.batch.transforms, sizeof(Matrix), sizeof(Matrix), count);
+    size_t cmdOffset = instance_stream_write(R3D_MOD_DRAW.batch.commands, sizeof(r3d_draw_indirect_t), sizeof(r3d_draw_indirect_t), count);
+
+    size_t matOffset = 0;
+    if (perDrawMaterial) {
+        matOffset = instance_stream_write(R3D_MOD_DRAW.batch.materials, sizeof(r3d_draw_batch_material_t), sizeof(r3d_draw_batch_material_t), count);
+    }
+
+    GLuint buffer = R3D_MOD_STREAM.buffer;
+
+    r3d_state_bind_vao(R3D_MOD_DRAW.batch.calls[0]->mesh.vao);
+
+    // The base instance of each command selects its transform and material
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (int i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(locInstanceModel + i);
+        glVertexAttribPointer(locInstanceModel + i, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix), (void*)(transOffset + i * sizeof(Vector4)));
+        glVertexAttribDivisor(locInstanceModel + i, 1);
+    }
 
+    // The albedo goes through the instance color, the other vectors follow it in the material layout
+    if (perDrawMaterial) {
         for (int i = 0; i < 4; i++) {
-            glEnableVertexAttribArray(locInstanceModel + i);
-            glVertexAttribPointer(locInstanceModel + i, 4, GL_FLOAT, GL_FALSE, (int)stride, (void*)(i * sizeof(Vector4)));
-            glVertexAttribDivisor(locInstanceModel + i, 1);
+            GLuint loc = (i == 0) ? locInstanceColor : locInstanceMaterial + i - 1;
+            glEnableVertexAttribArray(loc);
+            glVertexAttribPointer(loc, 4, GL_FLOAT, GL_FALSE, sizeof(r3d_draw_batch_material_t), (void*)(matOffset + i * sizeof(Vector4)));
+            glVertexAttribDivisor(loc, 1);
         }
     }
 
-    // Handle per-instance colors if available
-    if (locInstanceColor >= 0 && group->instanced.colors) {
-        size_t stride = (group->instanced.colStride == 0) ? sizeof(Color) : group->instanced.colStride;
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)cmdOffset, count, 0);
+    R3D_PROFILE_COUNT(drawCommands, 1);
+    R3D_PROFILE_COUNT(instancesDrawn, count);
+    R3D_PROFILE_COUNT(trianglesSubmitted, triangles);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 
-        // Create and bind VBO for colors
-        glGenBuffers(1, &vboColors);
-        glBindBuffer(GL_ARRAY_BUFFER, vboColors);
-        glBufferData(GL_ARRAY_BUFFER, group->instanced.count * stride, group->instanced.colors, GL_DYNAMIC_DRAW);
+    for (int i = 0; i < 4; i++) {
+        glDisableVertexAttribArray(locInstanceModel + i);
+        glVertexAttribDivisor(locInstanceModel + i, 0);
+    }
 
-        glEnableVertexAttribArray(locInstanceColor);
-        glVertexAttribPointer(locInstanceColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, (int)stride, (void*)0);
-        glVertexAttribDivisor(locInstanceColor, 1);
+    if (perDrawMaterial) {
+        for (int i = 0; i < 4; i++) {
+            GLuint loc = (i == 0) ? locInstanceColor : locInstanceMaterial + i - 1;
+            glDisableVertexAttribArray(loc);
+            glVertexAttribDivisor(loc, 0);
+        }
     }
 
-    // Draw the geometry
-    if (call->mesh.ebo == 0) {
-        glDrawArraysInstanced(
-            get_opengl_primitive(call->mesh.primitiveType),
-            0, call->mesh.vertexCount, (int)group->instanced.count
-        );
+    // NOTE: The vertex array stays bound, consecutive draws of the same mesh don't rebind it
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void r3d_draw_batch_clear(void)
+{
+    R3D_MOD_DRAW.batch.numCalls = 0;
+}
+
+bool r3d_draw_call_is_instanceable(const r3d_draw_call_t* call)
+{
+    if (call->material->shader != NULL || call->material->billboardMode != R3D_BILLBOARD_DISABLED) {
+        return false;
+    }
+
+    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+
+    return !r3d_draw_has_instances(group) && !r3d_draw_has_baked_animation(group) &&
+           group->player == NULL && !R3D_IsSkeletonValid(&group->skeleton);
+}
+
+bool r3d_draw_bucket_accepts(const r3d_draw_call_t* call)
+{
+    if (!R3D_MOD_DRAW.autoInstancing || !r3d_draw_call_is_instanceable(call)) {
+        return false;
+    }
+
+    if (R3D_MOD_DRAW.bucket.numCalls == 0) {
+        return true;
+    }
+
+    const r3d_draw_call_t* first = R3D_MOD_DRAW.bucket.calls[0];
+
+    // Interned materials are shared by all the calls using the same unchanged material
+    if (first->material != call->material || first->mesh.vao != call->mesh.vao) {
+        return false;
+    }
+
+    // Meshes of the arena share their vertex array, the ranges tell them apart
+    int firstIndexA = 0, indexCountA = 0;
+    int firstIndexB = 0, indexCountB = 0;
+    get_call_indices(first, &firstIndexA, &indexCountA);
+    get_call_indices(call, &firstIndexB, &indexCountB);
+
+    return
+        firstIndexA == firstIndexB && indexCountA == indexCountB &&
+        first->mesh.baseVertex == call->mesh.baseVertex &&
+        first->mesh.vertexCount == call->mesh.vertexCount &&
+        first->mesh.depthVao == call->mesh.depthVao &&
+        first->mesh.shadowCastMode == call->mesh.shadowCastMode;
+}
+
+void r3d_draw_bucket_push(const r3d_draw_call_t* call)
+{
+    // NOTE: Can't overflow, there are never more pending calls than pushed calls
+    R3D_MOD_DRAW.bucket.calls[R3D_MOD_DRAW.bucket.numCalls++] = call;
+}
+
+bool r3d_draw_call_is_bucketed(const r3d_draw_call_t* call)
+{
+    return R3D_MOD_DRAW.bucket.numCalls > 1 && R3D_MOD_DRAW.bucket.calls[0] == call;
+}
+
+void r3d_draw_bucket_instanced(int locInstanceModel, bool depthOnly)
+{
+    int count = R3D_MOD_DRAW.bucket.numCalls;
+    if (count == 0) return;
+
+    const r3d_draw_call_t* first = R3D_MOD_DRAW.bucket.calls[0];
+
+    for (int i = 0; i < count; i++) {
+        R3D_MOD_DRAW.bucket.transforms[i] = r3d_draw_get_call_group(R3D_MOD_DRAW.bucket.calls[i])->transform;
+    }
+
+    if (!instance_stream_reserve(count * sizeof(Matrix) + 16)) {
+        return;
+    }
+
+    size_t transOffset = instance_stream_write(R3D_MOD_DRAW.bucket.transforms, sizeof(Matrix), sizeof(Matrix), count);
+
+    r3d_state_bind_vao(depthOnly ? first->mesh.depthVao : first->mesh.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, R3D_MOD_STREAM.buffer);
+    for (int i = 0; i < 4; i++) {
+        glEnableVertexAttribArray(locInstanceModel + i);
+        glVertexAttribPointer(locInstanceModel + i, 4, GL_FLOAT, GL_FALSE, sizeof(Matrix), (void*)(transOffset + i * sizeof(Vector4)));
+        glVertexAttribDivisor(locInstanceModel + i, 1);
+    }
+
+    GLenum primitive = get_opengl_primitive(first->mesh.primitiveType);
+
+    if (first->mesh.ebo == 0) {
+        glDrawArraysInstanced(primitive, first->mesh.baseVertex, first->mesh.vertexCount, count);
+        count_draw(first, first->mesh.vertexCount, count);
     }
     else {
-        glDrawElementsInstanced(
-            get_opengl_primitive(call->mesh.primitiveType),
-            call->mesh.indexCount, GL_UNSIGNED_INT, NULL, (int)group->instanced.count
-        );
+        int firstIndex = 0, indexCount = 0;
+        get_call_indices(first, &firstIndex, &indexCount);
+        const void* offset = (const void*)((uintptr_t)firstIndex * sizeof(uint32_t));
+        glDrawElementsInstancedBaseVertex(primitive, indexCount, GL_UNSIGNED_INT, offset, count, first->mesh.baseVertex);
+        count_draw(first, indexCount, count);
     }
 
-    // Clean up instanced data
-    if (vboTransforms > 0) {
-        for (int i = 0; i < 4; i++) {
-            glDisableVertexAttribArray(locInstanceModel + i);
-            glVertexAttribDivisor(locInstanceModel + i, 0);
+    for (int i = 0; i < 4; i++) {
+        glDisableVertexAttribArray(locInstanceModel + i);
+        glVertexAttribDivisor(locInstanceModel + i, 0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void r3d_draw_bucket_clear(void)
+{
+    R3D_MOD_DRAW.bucket.numCalls = 0;
+}
+
+bool r3d_draw_decal_is_clusterable(const r3d_draw_call_t* call)
+{
+    if (call->material->blendMode != R3D_BLEND_MIX) {
+        return false;
+    }
+
+    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+
+    return !r3d_draw_has_instances(group) ||
+        (group->instanced.transforms != NULL && group->instanced.buffer == NULL && group->instanced.particles == NULL);
+}
+
+int r3d_draw_build_decal_clusters(const r3d_frustum_t* frustum, const Matrix* viewProj)
+{
+    static uint32_t ranges[R3D_DRAW_DECAL_MAX_BATCHES * DECAL_TILE_COUNT][2];
+
+    r3d_draw_decal_batch_t* batches = R3D_MOD_DRAW.decals.batches;
+    R3D_MOD_DRAW.decals.numBatches = 0;
+
+    /* --- Gather the decals into batches sharing the same textures --- */
+
+    int numBatches = 0;
+    int total = 0;
+
+    R3D_DRAW_FOR_EACH(call, r3d_draw_decal_is_clusterable(call), frustum, R3D_DRAW_DECAL_INST, R3D_DRAW_DECAL)
+    {
+        int b = find_decal_batch(call->material, numBatches);
+        if (b < 0) {
+            if (numBatches == R3D_DRAW_DECAL_MAX_BATCHES) continue;
+            b = numBatches++;
+            batches[b] = (r3d_draw_decal_batch_t) {.material = call->material};
         }
-        glDeleteBuffers(1, &vboTransforms);
+        int count = get_decal_count(call);
+        batches[b].numDecals += count;
+        total += count;
     }
-    if (vboColors > 0) {
-        glDisableVertexAttribArray(locInstanceColor);
-        glVertexAttribDivisor(locInstanceColor, 0);
-        glDeleteBuffers(1, &vboColors);
+
+    if (total < R3D_DRAW_DECAL_CLUSTER_MIN) {
+        return 0;
+    }
+
+    if (R3D_MOD_DRAW.decals.paramBuffer == 0 && !decal_buffers_create()) {
+        TraceLog(LOG_WARNING, "R3D: Failed to create the clustered decal buffers");
+        return 0;
+    }
+
+    if (!decal_reserve(total)) {
+        TraceLog(LOG_WARNING, "R3D: Bad alloc on clustered decals, the decals are drawn one by one");
+        return 0;
+    }
+
+    for (int b = 0, first = 0; b < numBatches; b++) {
+        batches[b].firstDecal = first;
+        first += batches[b].numDecals;
+        batches[b].numDecals = 0;
+        batches[b].tileMin[0] = R3D_SHADER_DECAL_TILE_X;
+        batches[b].tileMin[1] = R3D_SHADER_DECAL_TILE_Y;
+        batches[b].tileMax[0] = -1;
+        batches[b].tileMax[1] = -1;
+    }
+
+    /* --- Store the decals on screen, instances included, in submission order --- */
+
+    R3D_DRAW_FOR_EACH(call, r3d_draw_decal_is_clusterable(call), frustum, R3D_DRAW_DECAL_INST, R3D_DRAW_DECAL)
+    {
+        int b = find_decal_batch(call->material, numBatches);
+        if (b < 0) continue;
+
+        const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+
+        if (!r3d_draw_has_instances(group)) {
+            push_decal(&batches[b], call->material, &group->transform, WHITE, viewProj);
+            continue;
+        }
+
+        size_t transStride = group->instanced.transStride ? group->instanced.transStride : sizeof(Matrix);
+        size_t colStride = group->instanced.colStride ? group->instanced.colStride : sizeof(Color);
+
+        for (int i = 0; i < group->instanced.count; i++) {
+            const Matrix* instance = (const Matrix*)((const uint8_t*)group->instanced.transforms + i * transStride);
+            Color tint = group->instanced.colors ? *(const Color*)((const uint8_t*)group->instanced.colors + i * colStride) : WHITE;
+            Matrix transform = r3d_matrix_multiply(&group->transform, instance);
+            push_decal(&batches[b], call->material, &transform, tint, viewProj);
+        }
+    }
+
+    /* --- Count the decals of each tile then fill the decal indices --- */
+
+    int numRanges = numBatches * DECAL_TILE_COUNT;
+
+    for (int i = 0; i < numRanges; i++) {
+        ranges[i][1] = 0;
+    }
+
+    for (int b = 0; b < numBatches; b++) {
+        uint32_t (*batchRanges)[2] = &ranges[b * DECAL_TILE_COUNT];
+        for (int i = batches[b].firstDecal; i < batches[b].firstDecal + batches[b].numDecals; i++) {
+            const int* t = &R3D_MOD_DRAW.decals.tiles[4 * i];
+            for (int y = t[1]; y <= t[3]; y++) {
+                for (int x = t[0]; x <= t[2]; x++) {
+                    batchRanges[y * R3D_SHADER_DECAL_TILE_X + x][1]++;
+                }
+            }
+        }
     }
 
-    glBindVertexArray(0);
+    uint32_t numIndices = 0;
+    for (int i = 0; i < numRanges; i++) {
+        ranges[i][0] = numIndices;
+        numIndices += ranges[i][1];
+        ranges[i][1] = 0;
+    }
+
+    if (!decal_reserve_indices(numIndices)) {
+        TraceLog(LOG_WARNING, "R3D: Bad alloc on clustered decals, the decals are drawn one by one");
+        return 0;
+    }
+
+    uint32_t* indices = R3D_MOD_DRAW.decals.indices;
+
+    for (int b = 0; b < numBatches; b++) {
+        uint32_t (*batchRanges)[2] = &ranges[b * DECAL_TILE_COUNT];
+        for (int i = batches[b].firstDecal; i < batches[b].firstDecal + batches[b].numDecals; i++) {
+            const int* t = &R3D_MOD_DRAW.decals.tiles[4 * i];
+            for (int y = t[1]; y <= t[3]; y++) {
+                for (int x = t[0]; x <= t[2]; x++) {
+                    uint32_t* range = batchRanges[y * R3D_SHADER_DECAL_TILE_X + x];
+                    indices[range[0] + range[1]++] = (uint32_t)i;
+                }
+            }
+        }
+    }
+
+    /* --- Upload the decals and their tiles --- */
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_DRAW.decals.paramBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, total * R3D_DRAW_DECAL_TEXELS * 4 * sizeof(float), R3D_MOD_DRAW.decals.params, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_DRAW.decals.tileBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, numRanges * sizeof(ranges[0]), ranges, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_DRAW.decals.indexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, ((numIndices > 0) ? numIndices : 1) * sizeof(uint32_t), indices, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    R3D_MOD_DRAW.decals.numBatches = numBatches;
+
+    return numBatches;
+}
+
+bool r3d_draw_decal_is_clustered(const r3d_draw_call_t* call)
+{
+    return R3D_MOD_DRAW.decals.numBatches > 0 && r3d_draw_decal_is_clusterable(call) &&
+           find_decal_batch(call->material, R3D_MOD_DRAW.decals.numBatches) >= 0;
 }
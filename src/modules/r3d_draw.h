@@ -10,11 +10,25 @@
 #define R3D_MODULE_DRAW_H
 
 #include <r3d/r3d_animation.h>
+#include <r3d/r3d_draw.h>
+#include <r3d/r3d_instance.h>
+#include <r3d/r3d_particles.h>
 #include <r3d/r3d_material.h>
 #include <r3d/r3d_skeleton.h>
 #include <r3d/r3d_mesh.h>
 
 #include "../details/r3d_frustum.h"
+#include <stdint.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_DRAW_MATERIAL_BLOCK_SIZE    256     //< Number of interned materials per storage block
+#define R3D_DRAW_MATERIAL_CACHE_SIZE    64      //< Number of slots used to find already interned materials (power of two)
+#define R3D_DRAW_DECAL_MAX_BATCHES      8       //< Maximum number of texture sets applied by the clustered decal pass
+#define R3D_DRAW_DECAL_CLUSTER_MIN      8       //< Minimum number of visible decals to apply them from the screen tiles
+#define R3D_DRAW_DECAL_TEXELS           7       //< Number of RGBA32F texels storing the parameters of a clustered decal
 
 // ========================================
 // HELPER MACROS
@@ -49,10 +63,12 @@
 /*
  * Sorting modes applied to draw lists.
  * Used to control draw order for depth testing efficiency or visual correctness.
+ * Opaque modes group draw calls by shader, textures and VAO to limit state changes.
  */
 typedef enum {
-    R3D_DRAW_SORT_FRONT_TO_BACK,    //< Typically used for opaque geometry
-    R3D_DRAW_SORT_BACK_TO_FRONT,    //< Typically used for transparent geometry
+    R3D_DRAW_SORT_FRONT_TO_BACK,    //< State buckets, front to back inside each bucket (opaque geometry)
+    R3D_DRAW_SORT_BACK_TO_FRONT,    //< Strictly back to front, state only breaks ties (transparent geometry)
+    R3D_DRAW_SORT_STATE,            //< State buckets only, submission order is kept inside each bucket
 } r3d_draw_sort_enum_t;
 
 // ========================================
@@ -68,17 +84,28 @@ typedef struct {
     BoundingBox aabb;                   //< AABB of the model
     Matrix transform;                   //< World transform matrix
     R3D_Skeleton skeleton;              //< Skeleton containing the bind pose (if any)
-    const R3D_AnimationPlayer* player;  //< Animation player (may be NULL)
+    R3D_AnimationPlayer* player;        //< Animation player, its level of detail is recorded by the frame (may be NULL)
+    const R3D_BakedAnimationLib* baked; //< Baked animations selected per instance (may be NULL)
+    bool staticCaster;                  //< Shadow kept in the static cache of the lights, see 'R3D_SetSceneObjectStatic()'
 
     struct {
-        const Matrix* transforms;       //< Per-instance model matrices
-        const Color* colors;            //< Optional per-instance colors
-        BoundingBox allAabb;            //< World-space AABB covering all instances
-        int transStride;                //< Byte stride between instance transforms (0 = sizeof(Matrix))
-        int colStride;                  //< Byte stride between instance colors (0 = sizeof(Color))
-        int count;                      //< Number of instances
+        const R3D_InstanceBuffer* buffer;   //< Instance buffer used instead of the arrays below (may be NULL)
+        const Matrix* transforms;           //< Per-instance model matrices
+        const Color* colors;                //< Optional per-instance colors
+        const R3D_ParticleInstance* particles; //< Compact particle records used instead of the transforms and colors (may be NULL)
+        const R3D_Sprite* sprites;          //< Compact sprite records used instead of the transforms and colors (may be NULL)
+        BoundingBox allAabb;                //< World-space AABB covering all instances
+        int transStride;                    //< Byte stride between instance transforms (0 = sizeof(Matrix))
+        int colStride;                      //< Byte stride between instance colors (0 = sizeof(Color))
+        int count;                          //< Number of instances
     } instanced;
 
+    struct {
+        size_t transOffset;             //< Byte offset of the transforms in the instance stream
+        size_t colOffset;               //< Byte offset of the colors in the instance stream
+        uint32_t generation;            //< Generation of the stream holding the arrays, 0 if not uploaded yet
+    } stream;
+
 } r3d_draw_group_t;
 
 /*
@@ -94,13 +121,100 @@ typedef struct {
 /*
  * Internal representation of a single draw call.
  * Contains all data required to issue a draw, including geometry and material.
+ * The material is not stored inline, it is interned once per frame and shared by all calls using it.
  * Transform and animation data are stored in the parent draw group.
+ * Levels of detail are selected on push from the camera of the frame.
  */
 typedef struct {
-    R3D_Material material;              //< Material used for rendering
     R3D_Mesh mesh;                      //< Mesh geometry and GPU buffers
+    const R3D_Material* material;       //< Interned material, valid until the next `r3d_draw_clear()`
+    int lod;                            //< Level of detail of the camera passes, 0 for the mesh itself
+    int shadowLod;                      //< Level of detail of the shadow passes, 0 for the mesh itself
+    bool preSkinned;                    //< The vertex arrays of the mesh read the vertices skinned this frame, see `r3d_draw_preskin_calls()`
 } r3d_draw_call_t;
 
+/*
+ * Group recorded into a draw buffer, with its world box computed by the recording thread.
+ */
+typedef struct {
+    r3d_draw_group_t group;             //< Group pushed on merge
+    Vector3 center;                     //< Center of the world box
+    Vector3 extent;                     //< Half extents of the world box
+    int firstCall;                      //< Index of the first recorded call of the group
+    int numCalls;                       //< Number of recorded calls of the group
+} r3d_draw_buffer_group_t;
+
+/*
+ * Call recorded into a draw buffer, the material is copied so that the
+ * merge can reference it directly instead of interning it.
+ */
+typedef struct {
+    R3D_Mesh mesh;                      //< Mesh geometry and GPU buffers
+    R3D_Material material;              //< Copy of the material, ignored if 'defaultMaterial' is set
+    bool defaultMaterial;               //< Resolved on merge, the default material needs the GL thread
+} r3d_draw_buffer_call_t;
+
+/*
+ * Per-thread storage of recorded draws, merged by `R3D_End()`.
+ * Only touched by its recording thread until the merge.
+ */
+struct R3D_DrawBuffer {
+    r3d_draw_buffer_group_t* groups;    //< Recorded groups
+    int numGroups;                      //< Number of recorded groups
+    int capacityGroups;                 //< Allocated capacity of the groups
+    r3d_draw_buffer_call_t* calls;      //< Recorded calls
+    int numCalls;                       //< Number of recorded calls
+    int capacityCalls;                  //< Allocated capacity of the calls
+};
+
+/*
+ * Indirect command layout read by `glMultiDrawElementsIndirect`.
+ * The base instance selects the transform of the draw in the instance stream.
+ */
+typedef struct {
+    uint32_t count;                     //< Number of indices
+    uint32_t instanceCount;             //< Always 1, batched draws are not instanced
+    uint32_t firstIndex;                //< First index in the shared element buffer
+    int32_t baseVertex;                 //< First vertex in the shared vertex buffer
+    uint32_t baseInstance;              //< Index of the draw transform
+} r3d_draw_indirect_t;
+
+/*
+ * Material parameters of one batched draw, read through instance attributes with the same base instance as the transform.
+ * Only the textures and the cull mode must be shared by the batched calls, everything else varies per draw.
+ */
+typedef struct {
+    Vector4 albedo;                     //< Albedo color
+    Vector4 emission;                   //< Emission color premultiplied by the energy, alpha cutoff in w
+    Vector4 params;                     //< Normal scale, occlusion, roughness and metalness
+    Vector4 texCoord;                   //< UV offset in xy, UV scale in zw
+} r3d_draw_batch_material_t;
+
+/*
+ * Clustered decals sharing the same textures, applied by a single scissored screen pass.
+ * The decals of a batch are stored contiguously in the decal parameter buffer.
+ */
+typedef struct {
+    const R3D_Material* material;       //< Material of the first decal, its textures are shared by the batch
+    int firstDecal;                     //< Index of the first decal of the batch
+    int numDecals;                      //< Number of decals on screen, instances included
+    int tileMin[2];                     //< First tile covered by the decals
+    int tileMax[2];                     //< Last tile covered by the decals, included
+} r3d_draw_decal_batch_t;
+
+/*
+ * View rendered by `R3D_End()` in a multi-view or stereo frame.
+ * The matrices are resolved when the frame begins, the view state is restored from them for each view.
+ */
+typedef struct {
+    Matrix view;                        //< View matrix
+    Matrix proj;                        //< Projection matrix
+    float aspect;                       //< Aspect ratio of the projection
+    float near;                         //< Near plane distance
+    float far;                          //< Far plane distance
+    RenderTexture target;               //< Render target of the view
+} r3d_draw_view_t;
+
 // ========================================
 // MODULE STATE
 // ========================================
@@ -141,13 +255,80 @@ extern struct r3d_draw {
     r3d_draw_list_t list[R3D_DRAW_LIST_COUNT];  //< Lists of draw call indices organized by rendering category
     r3d_draw_indices_t* callIndices;            //< Array of draw call index ranges for each draw group (automatically managed)
     r3d_draw_group_t* groups;                   //< Array of draw groups (shared data across draw calls)
-    bool* visibleGroups;                        //< Array of bool for each group (indicating if they are visible)
+    uint32_t* visibleGroups;                    //< Bitset of the groups found visible by the last frustum test
+    r3d_frustum_boxes_t groupBoxes;             //< World-space bounds of each group, computed on push
     r3d_draw_call_t* calls;                     //< Array of draw calls
     int* groupIndices;                          //< Array of group indices for each draw call (automatically managed)
-    float* cacheDists;                          //< Array of distances between draw calls and the camera for sorting
+    uint64_t* sortKeys;                         //< Array of sort keys, indexed by position in the list being sorted
+    uint64_t* sortKeysTmp;                      //< Scratch keys used by the radix sort
+    int* sortValuesTmp;                         //< Scratch call indices used by the radix sort
     int numGroups;                              //< Number of active draw groups
     int numCalls;                               //< Number of active draw calls
     int capacity;                               //< Allocated capacity for all arrays
+    void* arrays;                               //< Single block holding all the arrays above and the call lists
+
+    struct {
+        uint32_t buffer;                        //< Compacted instances and indirect commands written by the GPU
+        size_t capacity;                        //< Size of the buffer in bytes
+        size_t head;                            //< Write position, the storage is orphaned when full
+    } cullOutput;
+
+    const r3d_frustum_t* cullFrustum;           //< Frustum given to the last `r3d_draw_compute_visible_groups()`
+    bool gpuCulling;                            //< Enables the per-instance GPU culling of large instanced draws
+    bool shadowLods;                            //< Draws the shadow levels of detail instead of the camera ones
+    bool autoInstancing;                        //< Merges the consecutive identical calls into instanced draws, see `r3d_draw_bucket_accepts()`
+
+    struct {
+        const r3d_draw_call_t** calls;          //< Calls merged into the pending multi-draw
+        Matrix* transforms;                     //< Scratch transforms gathered from the groups
+        r3d_draw_indirect_t* commands;          //< Scratch indirect commands
+        r3d_draw_batch_material_t* materials;   //< Scratch material parameters gathered from the calls
+        int numCalls;                           //< Number of pending calls
+    } batch;
+
+    struct {
+        const r3d_draw_call_t** calls;          //< Identical calls merged into the pending instanced draw
+        Matrix* transforms;                     //< Scratch transforms gathered from the groups
+        int numCalls;                           //< Number of pending calls
+    } bucket;
+
+    struct {
+        R3D_Material** blocks;                  //< Fixed-size storage blocks, never moved so that calls can point into them
+        int numBlocks;                          //< Number of allocated blocks
+        int count;                              //< Number of materials interned since the last clear
+        int cache[R3D_DRAW_MATERIAL_CACHE_SIZE];//< Index of the last material interned for each source address slot
+    } materials;
+
+    struct {
+        R3D_DrawBuffer** list;                  //< Draw buffers merged by `R3D_End()`, in creation order
+        int count;                              //< Number of draw buffers
+        int capacity;                           //< Allocated capacity of the list
+    } buffers;
+
+    struct {
+        r3d_draw_view_t list[R3D_MAX_VIEWS];    //< View state and render target of each view
+        int count;                              //< Number of views of a multi-view or stereo frame, zero for a single view
+        bool stereo;                            //< The views are the eyes of `R3D_BeginStereo()`, culled and sorted together
+    } views;
+
+    struct {
+        r3d_draw_decal_batch_t batches[R3D_DRAW_DECAL_MAX_BATCHES]; //< Texture sets of the clustered decals
+        int numBatches;                         //< Number of batches, zero if the decals are drawn one by one
+        float* params;                          //< Parameters of each decal, `R3D_DRAW_DECAL_TEXELS` vec4 each
+        int* tiles;                             //< First and last tiles covered by each decal, four integers each
+        uint32_t* indices;                      //< Decal indices of each tile, batch after batch
+        int capacity;                           //< Allocated capacity in decals
+        int indexCapacity;                      //< Allocated capacity in indices
+        uint32_t paramBuffer;                   //< Parameters of the decals
+        uint32_t tileBuffer;                    //< Offset and count in the index buffer of each tile of each batch
+        uint32_t indexBuffer;                   //< Decal indices of the tiles
+        uint32_t paramTexture;                  //< Buffer texture of 'paramBuffer'
+        uint32_t tileTexture;                   //< Buffer texture of 'tileBuffer'
+        uint32_t indexTexture;                  //< Buffer texture of 'indexBuffer'
+    } decals;
+
+    uint32_t frameIndex;                        //< Incremented at the end of each `R3D_End()`
+
 } R3D_MOD_DRAW;
 
 // ========================================
@@ -177,12 +358,49 @@ void r3d_draw_clear(void);
  */
 void r3d_draw_group_push(const r3d_draw_group_t* group);
 
+/*
+ * Same as `r3d_draw_group_push()` but with a world box already computed by the caller.
+ * Used by the retained scene, whose boxes only change when an object is moved.
+ */
+void r3d_draw_group_push_bounded(const r3d_draw_group_t* group, Vector3 center, Vector3 extent);
+
 /*
  * Push a new draw call to the appropriate draw list.
- * The draw call data is copied internally.
+ * The mesh of the draw call is copied internally, its material pointer is ignored.
+ * The given material is interned instead, a material already pushed with the same
+ * address and content is shared. The default material is used if NULL.
  * Inherits the group previously pushed.
  */
-void r3d_draw_call_push(const r3d_draw_call_t* call, bool decal);
+void r3d_draw_call_push(const r3d_draw_call_t* call, const R3D_Material* material, bool decal);
+
+/*
+ * Same as `r3d_draw_call_push()` but the material is referenced instead of interned.
+ * The material must stay valid and unchanged until the draw lists are cleared.
+ */
+void r3d_draw_call_push_retained(const r3d_draw_call_t* call, const R3D_Material* material, bool decal);
+
+/*
+ * Allocates a draw buffer and registers it for merging.
+ * Returns NULL on allocation failure.
+ */
+R3D_DrawBuffer* r3d_draw_buffer_create(void);
+
+/*
+ * Unregisters and releases a draw buffer.
+ */
+void r3d_draw_buffer_destroy(R3D_DrawBuffer* buffer);
+
+/*
+ * Records a group into a draw buffer and computes its world box.
+ * Safe to call from any thread owning the buffer, returns false on allocation failure.
+ */
+bool r3d_draw_buffer_push_group(R3D_DrawBuffer* buffer, const r3d_draw_group_t* group);
+
+/*
+ * Records a call into the last group of a draw buffer, the default material is used if NULL.
+ * Safe to call from any thread owning the buffer, returns false on allocation failure.
+ */
+bool r3d_draw_buffer_push_call(R3D_DrawBuffer* buffer, const R3D_Mesh* mesh, const R3D_Material* material);
 
 /*
  * Retrieve the draw group associated with a given draw call.
@@ -190,12 +408,49 @@ void r3d_draw_call_push(const r3d_draw_call_t* call, bool decal);
  */
 r3d_draw_group_t* r3d_draw_get_call_group(const r3d_draw_call_t* call);
 
+/*
+ * Retrieve the world-space bounds of the group of a draw call, computed when the group was pushed.
+ * Unbounded groups get `R3D_FRUSTUM_INFINITE_EXTENT` extents.
+ */
+void r3d_draw_get_call_world_box(const r3d_draw_call_t* call, Vector3* center, Vector3* extent);
+
 /*
  * Builds the list of groups that are visible inside the given frustum.
  * Must be called before issuing visibility tests with the same frustum.
+ * The frustum is also kept for the per-instance culling of the instanced draws that follow.
  */
 void r3d_draw_compute_visible_groups(const r3d_frustum_t* frustum);
 
+/*
+ * Hides the visible groups that are occluded by the depth pyramid of the occlusion module.
+ * Must be called after `r3d_draw_compute_visible_groups()` with the camera frustum,
+ * the groups hidden here are also skipped by the passes that follow.
+ */
+void r3d_draw_cull_occluded_groups(void);
+
+/*
+ * Records the screen size of the animation players drawn by the visible groups,
+ * read back by their next update, see 'R3D_AnimationLod'.
+ * Must be called once the camera culling is done, all the groups are considered
+ * visible if 'culled' is false.
+ */
+void r3d_draw_record_animation_lods(bool culled);
+
+/*
+ * Skins the meshes of the calls animated by a player or a skeleton once with the compute shader
+ * of the pre-skinning module, and makes the calls draw the skinned vertices as static meshes.
+ * Calls of baked animations, compact meshes or without OpenGL 4.3 keep skinning in each pass.
+ * Must be called between `r3d_preskin_begin()` and `r3d_preskin_end()`, once all calls are pushed.
+ */
+void r3d_draw_preskin_calls(void);
+
+/*
+ * Requests the mipmap levels of the streamed textures used by the calls, from the screen size
+ * of their groups in a view of 'viewHeight' pixels and the UV scale of their materials.
+ * Must be called once all calls are pushed, before `r3d_texture_stream_update()`.
+ */
+void r3d_draw_request_texture_levels(float viewHeight);
+
 /*
  * Returns true if the draw call is visible within the given frustum.
  * Uses both per-call culling and the results produced by `r3d_draw_compute_visible_groups()`
@@ -203,8 +458,16 @@ void r3d_draw_compute_visible_groups(const r3d_frustum_t* frustum);
  */
 bool r3d_draw_call_is_visible(const r3d_draw_call_t* call, const r3d_frustum_t* frustum);
 
+/*
+ * Returns one bit per frustum in which the draw call is visible, among up to 32 frustums.
+ * The groups must have been computed with a frustum enclosing all of them, see `r3d_draw_compute_visible_groups()`.
+ * Used to render several views of a light with a single submission of each call.
+ */
+uint32_t r3d_draw_call_get_view_mask(const r3d_draw_call_t* call, const r3d_frustum_t* frustums, int count);
+
 /*
  * Sort a draw list according to the given mode and camera position.
+ * Each call gets a packed 64 bits key which is then sorted with a stable radix sort.
  */
 void r3d_draw_sort_list(r3d_draw_list_enum_t list, Vector3 viewPosition, r3d_draw_sort_enum_t mode);
 
@@ -220,6 +483,13 @@ void r3d_draw_apply_cull_mode(R3D_CullMode mode);
  */
 void r3d_draw_apply_blend_mode(R3D_BlendMode blend, R3D_TransparencyMode transparency);
 
+/*
+ * Applies the blend function of a draw call into a reduced resolution target.
+ * Same colors as `r3d_draw_apply_blend_mode()`, the alpha keeps the product of the transmittances.
+ * Only MIX, ADDITIVE and PREMULTIPLIED_ALPHA can be drawn at reduced resolution.
+ */
+void r3d_draw_apply_reduced_blend_mode(R3D_BlendMode blend, R3D_TransparencyMode transparency);
+
 /*
  * Configure face culling for shadow rendering depending on shadow casting mode.
  */
@@ -232,22 +502,138 @@ void r3d_draw(const r3d_draw_call_t* call);
 
 /*
  * Issue an instanced draw call.
- * Instance data is uploaded and bound internally.
+ * Instance arrays are uploaded once per frame into the instance stream,
+ * then every pass of the frame reuses that same upload.
+ * Groups using an instance buffer are bound directly without any upload.
+ * When `gpuCulling` is set, large instance sets are first culled by a compute shader
+ * against the frustum of the current pass, and drawn with an indirect command.
  */
 void r3d_draw_instanced(const r3d_draw_call_t* call, int locInstanceModel, int locInstanceColor);
 
+/*
+ * Returns true if the depth passes can draw the call with the position-only vertex array of its mesh.
+ * Without texcoords and vertex colors, no fragment may fall below the given alpha cutoff,
+ * so the material color must be opaque enough and its albedo texture must have no alpha channel.
+ */
+bool r3d_draw_call_is_depth_only(const r3d_draw_call_t* call, float alphaCutoff);
+
+/*
+ * Same as `r3d_draw()` and `r3d_draw_instanced()` with the position-only vertex array.
+ * The call must have been accepted by `r3d_draw_call_is_depth_only()`.
+ */
+void r3d_draw_depth(const r3d_draw_call_t* call);
+void r3d_draw_depth_instanced(const r3d_draw_call_t* call, int locInstanceModel);
+
+/*
+ * Returns true if the draw call can be merged into a multi-draw.
+ * Only non-instanced, non-skinned indexed triangles from the mesh arena,
+ * using a built-in shader without billboarding, are eligible.
+ */
+bool r3d_draw_call_is_batchable(const r3d_draw_call_t* call);
+
+/*
+ * Returns true if the draw call can join the pending batch.
+ * The call must be batchable and share its buffers, textures and cull mode with the pending calls.
+ */
+bool r3d_draw_batch_accepts(const r3d_draw_call_t* call);
+
+/*
+ * Appends a draw call to the pending batch.
+ * The call must have been accepted by `r3d_draw_batch_accepts()`
+ */
+void r3d_draw_batch_push(const r3d_draw_call_t* call);
+
+/*
+ * Issues all the pending calls with a single `glMultiDrawElementsIndirect`.
+ * Transforms are written to the instance stream and read through the instance matrix attribute.
+ * When 'locInstanceMaterial' is non-negative, the parameters of each material are read through
+ * the instance color attribute for the albedo, and three vec4 attributes from 'locInstanceMaterial'
+ * in the order of `r3d_draw_batch_material_t`. Otherwise the material of the first call must be
+ * applied beforehand. In both cases the textures of the first call must be bound. The batch is not cleared.
+ */
+void r3d_draw_batch_multi(int locInstanceModel, int locInstanceColor, int locInstanceMaterial);
+
+/*
+ * Discards the pending calls of the batch.
+ */
+void r3d_draw_batch_clear(void);
+
+/*
+ * Returns true if the draw call can be merged with identical calls into an instanced draw.
+ * Only non-instanced and non-skinned calls, using a built-in shader without billboarding, are eligible.
+ */
+bool r3d_draw_call_is_instanceable(const r3d_draw_call_t* call);
+
+/*
+ * Returns true if the draw call can join the pending bucket, always false if the automatic instancing is disabled.
+ * The call must be instanceable and share its mesh, level of detail and material with the pending calls.
+ */
+bool r3d_draw_bucket_accepts(const r3d_draw_call_t* call);
+
+/*
+ * Appends a draw call to the pending bucket.
+ * The call must have been accepted by `r3d_draw_bucket_accepts()`
+ */
+void r3d_draw_bucket_push(const r3d_draw_call_t* call);
+
+/*
+ * Returns true if the call is the first of a pending bucket holding several calls.
+ * Its state is applied for the whole bucket, which is drawn by `r3d_draw_bucket_instanced()`.
+ */
+bool r3d_draw_call_is_bucketed(const r3d_draw_call_t* call);
+
+/*
+ * Issues all the pending calls with a single instanced draw of the first one.
+ * The transforms of the calls are written to the instance stream and read through the instance
+ * matrix attribute, the model matrix uniform must be the identity. The bucket is not cleared.
+ */
+void r3d_draw_bucket_instanced(int locInstanceModel, bool depthOnly);
+
+/*
+ * Discards the pending calls of the bucket.
+ */
+void r3d_draw_bucket_clear(void);
+
+/*
+ * Returns true if the decal can be applied from the screen tiles by the clustered decal pass.
+ * Only decals with the MIX blend mode, drawn alone or with instance arrays, are eligible.
+ */
+bool r3d_draw_decal_is_clusterable(const r3d_draw_call_t* call);
+
+/*
+ * Gathers the visible clusterable decals into batches sharing the same textures,
+ * assigns them to the screen tiles they cover then uploads the decal buffers.
+ * No batch is built with fewer than `R3D_DRAW_DECAL_CLUSTER_MIN` decals. Returns the number of batches.
+ */
+int r3d_draw_build_decal_clusters(const r3d_frustum_t* frustum, const Matrix* viewProj);
+
+/*
+ * Returns true if the decal is applied by the batches of the last `r3d_draw_build_decal_clusters()`.
+ */
+bool r3d_draw_decal_is_clustered(const r3d_draw_call_t* call);
+
 // ----------------------------------------
 // INLINE QUERIES
 // ----------------------------------------
 
 /*
  * Check whether a draw group has valid instancing data.
- * Returns true if the draw call contains a non-null instance transform array
- * and a positive instance count.
+ * Returns true if the draw call contains a non-null instance transform array,
+ * particle records or an instance buffer, and a positive instance count.
  */
 static inline bool r3d_draw_has_instances(const r3d_draw_group_t* group)
 {
-    return group->instanced.transforms && group->instanced.count > 0;
+    return (group->instanced.transforms || group->instanced.buffer || group->instanced.particles || group->instanced.sprites) && group->instanced.count > 0;
+}
+
+/*
+ * Check whether the instances of a draw group select their pose in a baked animation library.
+ * Only instance buffers created with `R3D_INSTANCE_ANIMATION` hold the animation of each instance.
+ */
+static inline bool r3d_draw_has_baked_animation(const r3d_draw_group_t* group)
+{
+    return group->baked != NULL && R3D_IsBakedAnimationLibValid(group->baked) &&
+           group->instanced.buffer != NULL && group->instanced.buffer->vboAnimations != 0;
 }
 
 /*
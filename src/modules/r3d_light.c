@@ -8,17 +8,77 @@
 
 #include "./r3d_light.h"
 #include <raymath.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <float.h>
 
+#include "./r3d_occlusion.h"
+#include "./r3d_shader.h"
+#include "./r3d_state.h"
+
 // ========================================
 // MODULE STATE
 // ========================================
 
 struct r3d_light R3D_MOD_LIGHT;
 
+// ========================================
+// INTERNAL UNIFORM BUFFER STRUCTS
+// ========================================
+
+typedef struct {
+    alignas(16) Vector3 color;
+    alignas(4) float specular;
+    alignas(16) Vector3 position;
+    alignas(4) float energy;
+    alignas(16) Vector3 direction;
+    alignas(4) float range;
+    alignas(4) float attenuation;
+    alignas(4) float innerCutOff;
+    alignas(4) float outerCutOff;
+    alignas(4) int type;
+} uniform_light_t;
+
+typedef struct {
+    alignas(16) Matrix matVP[R3D_LIGHT_SHADOW_CASCADES];
+    alignas(16) Vector4 tiles[6];
+    alignas(4) float near;
+    alignas(4) float far;
+    alignas(4) float softness;
+    alignas(4) float texelSize;
+    alignas(4) float depthBias;
+    alignas(4) float slopeBias;
+    alignas(4) int cascades;
+    alignas(4) int samples;
+} uniform_light_shadow_t;
+
+/*
+ * Both blocks share the same buffer, bound as two ranges.
+ * The size of the lights array is a multiple of 256 bytes, which satisfies the offset alignment.
+ */
+typedef struct {
+    uniform_light_t lights[R3D_SHADER_FORWARD_BLOCK_LIGHTS];
+    uniform_light_shadow_t shadows[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+} uniform_light_block_t;
+
+// Filtered taps per pixel of each shadow quality, see 'S_DiskTap()' in 'shadow.glsl'
+static const int SHADOW_QUALITY_SAMPLES[] = {
+    [R3D_SHADOW_QUALITY_LOW] = 1,
+    [R3D_SHADOW_QUALITY_MEDIUM] = 4,
+    [R3D_SHADOW_QUALITY_HIGH] = 8,
+};
+
+// ========================================
+// INTERNAL CLUSTER CONSTANTS
+// ========================================
+
+#define CLUSTER_COUNT (R3D_SHADER_FORWARD_CLUSTER_X * R3D_SHADER_FORWARD_CLUSTER_Y * R3D_SHADER_FORWARD_CLUSTER_Z)
+#define CLUSTER_MAX_INDICES (CLUSTER_COUNT * R3D_SHADER_FORWARD_BLOCK_LIGHTS)
+
 // ========================================
 // INTERNAL LIGHT FUNCTIONS
 // ========================================
@@ -47,12 +107,17 @@ static void init_light(r3d_light_t* light, R3D_LightType type)
     light->type = type;
     light->enabled = false;
 
+    light->gridEntry = -1;
+    light->shadowSlot = -1;
+    light->fade = 1.0f;
+
     /* --- Set common shadow config --- */
 
     light->state.shadowUpdate = R3D_SHADOW_UPDATE_INTERVAL;
     light->state.shadowShouldBeUpdated = true;
     light->state.shadowFrequencySec = 0.016f;
     light->state.shadowTimerSec = 0.0f;
+    light->shadowQuality = R3D_SHADOW_QUALITY_HIGH;
 
     /* --- Set specific shadow config --- */
 
@@ -60,6 +125,9 @@ static void init_light(r3d_light_t* light, R3D_LightType type)
     case R3D_LIGHT_DIR:
         light->shadowDepthBias = 0.0002f;
         light->shadowSlopeBias = 0.002f;
+        light->shadowCascadeSplit = 0.75f;
+        light->shadowCascades = R3D_LIGHT_SHADOW_CASCADES;
+        light->state.cascadeInterval = 1;
         break;
     case R3D_LIGHT_SPOT:
         light->shadowDepthBias = 0.00002f;
@@ -92,10 +160,46 @@ void update_light_shadow_state(r3d_light_t* light)
     }
 }
 
-static void update_light_dir_matrix(r3d_light_t* light, Vector3 viewPosition)
+/*
+ * Selects the cascades rendered with this shadow update, the near one is always rendered.
+ * The far cascades are rendered once every 'cascadeInterval' updates, on different updates.
+ */
+static void update_light_dir_cascade_mask(r3d_light_t* light)
+{
+    r3d_light_state_t* state = &light->state;
+
+    int interval = state->cascadeInterval;
+    int counter = state->cascadeCounter++;
+
+    if (state->cascadesShouldBeUpdated || interval <= 1) {
+        state->viewMask = (1 << light->shadowCascades) - 1;
+        state->cascadesShouldBeUpdated = false;
+        return;
+    }
+
+    state->viewMask = 1;
+    for (int i = 1; i < light->shadowCascades; i++) {
+        if ((counter + i) % interval == 0) state->viewMask |= (1 << i);
+    }
+}
+
+/*
+ * Practical split scheme, blend of the uniform and logarithmic splits of the view depth.
+ */
+static float get_light_dir_cascade_split(const r3d_light_t* light, int index, float near, float far)
+{
+    float t = (float)index / light->shadowCascades;
+
+    float uniformSplit = near + (far - near) * t;
+    float logSplit = near * powf(far / near, t);
+
+    return Lerp(uniformSplit, logSplit, light->shadowCascadeSplit);
+}
+
+static void update_light_dir_cascades(r3d_light_t* light, const Matrix* invViewProjs, int numViews, float near, float far)
 {
     Vector3 lightDir = light->direction;
-    float extent = light->range;
+    float depthExtent = light->range;
 
     /* --- Create an orthonormal basis for light --- */
 
@@ -103,38 +207,93 @@ static void update_light_dir_matrix(r3d_light_t* light, Vector3 viewPosition)
     Vector3 lightRight = Vector3Normalize(Vector3CrossProduct(up, lightDir));
     Vector3 lightUp = Vector3CrossProduct(lightDir, lightRight);
 
-    /* --- Project the camera's position into light space --- */
+    /* --- Get the corners of the view frustums, the cascades cover them up to the light range --- */
+
+    Vector3 nearCorners[4 * R3D_MAX_VIEWS], farCorners[4 * R3D_MAX_VIEWS];
+    for (int i = 0; i < 4 * numViews; i++) {
+        Vector2 ndc = {(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f};
+        Vector4 n = r3d_vector4_transform((Vector4) {ndc.x, ndc.y, -1.0f, 1.0f}, &invViewProjs[i / 4]);
+        Vector4 f = r3d_vector4_transform((Vector4) {ndc.x, ndc.y, +1.0f, 1.0f}, &invViewProjs[i / 4]);
+        nearCorners[i] = Vector3Scale((Vector3) {n.x, n.y, n.z}, 1.0f / n.w);
+        farCorners[i] = Vector3Scale((Vector3) {f.x, f.y, f.z}, 1.0f / f.w);
+    }
+
+    float shadowFar = fminf(far, near + light->range);
+
+    /* --- Fit the cascades rendered with this update --- */
+
+    update_light_dir_cascade_mask(light);
 
-    float camX = Vector3DotProduct(viewPosition, lightRight);
-    float camY = Vector3DotProduct(viewPosition, lightUp);
-    float camZ = Vector3DotProduct(viewPosition, lightDir);
+    for (int iCascade = 0; iCascade < light->shadowCascades; iCascade++)
+    {
+        if (!r3d_light_is_shadow_view_updated(light, iCascade)) {
+            continue;
+        }
+
+        float splitNear = get_light_dir_cascade_split(light, iCascade, near, shadowFar);
+        float splitFar = get_light_dir_cascade_split(light, iCascade + 1, near, shadowFar);
+
+        // The depth is linear along the edges of the frustums
+        Vector3 corners[8 * R3D_MAX_VIEWS];
+        Vector3 center = {0};
+        for (int i = 0; i < 4 * numViews; i++) {
+            Vector3 edge = Vector3Subtract(farCorners[i], nearCorners[i]);
+            corners[2 * i + 0] = Vector3Add(nearCorners[i], Vector3Scale(edge, (splitNear - near) / (far - near)));
+            corners[2 * i + 1] = Vector3Add(nearCorners[i], Vector3Scale(edge, (splitFar - near) / (far - near)));
+            center = Vector3Add(center, Vector3Add(corners[2 * i + 0], corners[2 * i + 1]));
+        }
+        center = Vector3Scale(center, 1.0f / (8 * numViews));
 
-    /* --- Snap to the texel grid --- */
+        /* --- Bounding sphere of the slices, its radius does not change with the view orientation --- */
 
-    float shadowMapSize = light->shadowMap.resolution;
-    float worldUnitsPerTexel = (2.0f * extent) / shadowMapSize;
+        float radius = 0.0f;
+        for (int i = 0; i < 8 * numViews; i++) {
+            radius = fmaxf(radius, Vector3Distance(center, corners[i]));
+        }
+        radius = ceilf(radius * 16.0f) / 16.0f;
 
-    float snappedX = floorf(camX / worldUnitsPerTexel) * worldUnitsPerTexel;
-    float snappedY = floorf(camY / worldUnitsPerTexel) * worldUnitsPerTexel;
+        /* --- Project the center into light space --- */
 
-    /* --- Reconstruct the snapped world space position --- */
+        float camX = Vector3DotProduct(center, lightRight);
+        float camY = Vector3DotProduct(center, lightUp);
+        float camZ = Vector3DotProduct(center, lightDir);
 
-    Vector3 lightPosition;
-    lightPosition.x = lightRight.x * snappedX + lightUp.x * snappedY + lightDir.x * camZ;
-    lightPosition.y = lightRight.y * snappedX + lightUp.y * snappedY + lightDir.y * camZ;
-    lightPosition.z = lightRight.z * snappedX + lightUp.z * snappedY + lightDir.z * camZ;
+        /* --- Snap to the texel grid --- */
 
-    /* --- Construct view projection --- */
+        float shadowMapSize = (light->shadowMap.tileSize > 0) ? light->shadowMap.tileSize : light->shadowMap.resolution;
+        float worldUnitsPerTexel = (2.0f * radius) / shadowMapSize;
 
-    Matrix view = MatrixLookAt(lightPosition, Vector3Add(lightPosition, lightDir), lightUp);
-    Matrix proj = MatrixOrtho(-extent, extent, -extent, extent, -extent, extent);
+        float snappedX = floorf(camX / worldUnitsPerTexel) * worldUnitsPerTexel;
+        float snappedY = floorf(camY / worldUnitsPerTexel) * worldUnitsPerTexel;
 
-    light->matVP[0] = MatrixMultiply(view, proj);
+        /* --- Reconstruct the snapped world space position --- */
+
+        Vector3 lightPosition;
+        lightPosition.x = lightRight.x * snappedX + lightUp.x * snappedY + lightDir.x * camZ;
+        lightPosition.y = lightRight.y * snappedX + lightUp.y * snappedY + lightDir.y * camZ;
+        lightPosition.z = lightRight.z * snappedX + lightUp.z * snappedY + lightDir.z * camZ;
+
+        /* --- Construct view projection, the casters up to the light range toward the light are kept --- */
+
+        Matrix view = MatrixLookAt(lightPosition, Vector3Add(lightPosition, lightDir), lightUp);
+        Matrix proj = MatrixOrtho(-radius, radius, -radius, radius, -depthExtent, radius);
+
+        Matrix matVP = MatrixMultiply(view, proj);
+
+        // The snapping keeps the projection of a still view, and its cached static casters
+        if (memcmp(&matVP, &light->matVP[iCascade], sizeof(Matrix)) != 0) {
+            light->shadowMap.cacheMask &= ~(1 << iCascade);
+            light->shadowMap.movedMask |= 1 << iCascade;
+        }
+
+        light->matVP[iCascade] = matVP;
+        light->frustum[iCascade] = r3d_frustum_create(light->matVP[iCascade]);
+    }
 
     /* --- Keep near / far --- */
 
-    light->near = -extent;  // Save near plane (can be used in shaders)
-    light->far = extent;    // Save far plane (can be used in shaders)
+    light->near = -depthExtent;     // Save near plane (can be used in shaders)
+    light->far = depthExtent;       // Save far plane (can be used in shaders)
 }
 
 static void update_light_spot_matrix(r3d_light_t* light)
@@ -181,11 +340,11 @@ static void update_light_omni_matrix(r3d_light_t* light)
     }
 }
 
-static void update_light_matrix(r3d_light_t* light, Vector3 viewPosition)
+static void update_light_matrix(r3d_light_t* light)
 {
     switch (light->type) {
     case R3D_LIGHT_DIR:
-        update_light_dir_matrix(light, viewPosition);
+        assert(false);
         break;
     case R3D_LIGHT_SPOT:
         update_light_spot_matrix(light);
@@ -198,11 +357,71 @@ static void update_light_matrix(r3d_light_t* light, Vector3 viewPosition)
 
 static void update_light_frustum(r3d_light_t* light)
 {
-    int n = (light->type == R3D_LIGHT_OMNI) ? 6 : 1;
+    int n = r3d_light_get_shadow_views(light);
 
     for (int i = 0; i < n; i++) {
         light->frustum[i] = r3d_frustum_create(light->matVP[i]);
     }
+
+    if (light->type == R3D_LIGHT_OMNI) {
+        light->volumeFrustum = r3d_frustum_create_box(&light->aabb);
+    }
+}
+
+/*
+ * Crops the frustum culling the casters of a shadow view to the projection of the view frustum.
+ * A caster shadows a receiver along the projection ray of the light, so the casters outside of the
+ * projection of the view, or behind its farthest point from the light, can't shadow anything visible.
+ * The crop only holds for the current views, the shadows kept between frames use the whole light frustum.
+ * With several views, the crop encloses the projections of all of them.
+ */
+static void update_light_caster_frustum(r3d_light_t* light, int view, const Vector3* viewCorners, int numCorners)
+{
+    light->casterFrustum[view] = light->frustum[view];
+
+    bool renderedEveryFrame =
+        (light->state.shadowUpdate == R3D_SHADOW_UPDATE_CONTINUOUS) &&
+        (light->type != R3D_LIGHT_DIR || view == 0 || light->state.cascadeInterval <= 1);
+
+    if (!renderedEveryFrame) {
+        return;
+    }
+
+    /* --- Get the bounds of the view frustum in the clip space of the light --- */
+
+    Vector3 ndcMin = {+FLT_MAX, +FLT_MAX, +FLT_MAX};
+    Vector3 ndcMax = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    for (int i = 0; i < numCorners; i++) {
+        Vector4 clip = r3d_vector4_transform((Vector4) {viewCorners[i].x, viewCorners[i].y, viewCorners[i].z, 1.0f}, &light->matVP[view]);
+        // The view crosses the plane of the spot light, its projection is unbounded
+        if (clip.w <= 1e-4f) return;
+        Vector3 ndc = Vector3Scale((Vector3) {clip.x, clip.y, clip.z}, 1.0f / clip.w);
+        ndcMin = Vector3Min(ndcMin, ndc);
+        ndcMax = Vector3Max(ndcMax, ndc);
+    }
+
+    // The filtering reads the texels around the projection of the receivers
+    float margin = 2.0f * (light->shadowSoftness + 1.0f / light->shadowMap.tileSize);
+
+    float minX = fmaxf(ndcMin.x - margin, -1.0f);
+    float minY = fmaxf(ndcMin.y - margin, -1.0f);
+    float maxX = fmaxf(fminf(ndcMax.x + margin, 1.0f), minX + 1e-4f);
+    float maxY = fmaxf(fminf(ndcMax.y + margin, 1.0f), minY + 1e-4f);
+    float maxZ = fmaxf(fminf(ndcMax.z + 1e-3f, 1.0f), -1.0f + 1e-4f);
+
+    /* --- Scale the cropped range of the clip space to cover [-1, 1], the near plane is kept --- */
+
+    Matrix crop = {0};
+    crop.m0 = 2.0f / (maxX - minX);
+    crop.m12 = -(maxX + minX) / (maxX - minX);
+    crop.m5 = 2.0f / (maxY - minY);
+    crop.m13 = -(maxY + minY) / (maxY - minY);
+    crop.m10 = 2.0f / (maxZ + 1.0f);
+    crop.m14 = (1.0f - maxZ) / (maxZ + 1.0f);
+    crop.m15 = 1.0f;
+
+    light->casterFrustum[view] = r3d_frustum_create(MatrixMultiply(light->matVP[view], crop));
 }
 
 static void update_light_bounding_box(r3d_light_t* light)
@@ -228,241 +447,274 @@ static void update_light_bounding_box(r3d_light_t* light)
 }
 
 // ========================================
-// INTERNAL SHADOW MAP FUNCTIONS
+// INTERNAL SHADOW ATLAS FUNCTIONS
 // ========================================
 
-static r3d_light_shadow_map_t alloc_shadow_map_2d(int resolution)
-{
-    r3d_light_shadow_map_t shadowMap = {0};
-    shadowMap.resolution = resolution;
+enum {
+    ATLAS_NODE_FREE,
+    ATLAS_NODE_SPLIT,
+    ATLAS_NODE_USED
+};
 
-    if (shadowMap.fbo == 0) {
-        glGenFramebuffers(1, &shadowMap.fbo);
-        glGenTextures(1, &shadowMap.tex);
-    }
+static bool create_shadow_depth_target(GLuint* fbo, GLuint* tex, int size, const char* name)
+{
+    glGenFramebuffers(1, fbo);
+    glGenTextures(1, tex);
 
-    glBindTexture(GL_TEXTURE_2D, shadowMap.tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, *tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT16, size, size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadowMap.tex, 0);
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, *fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *tex, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        TraceLog(LOG_ERROR, "R3D: Framebuffer creation error for the 2D shadow map");
+    bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        TraceLog(LOG_ERROR, "R3D: Framebuffer creation error for the %s", name);
+        glDeleteFramebuffers(1, fbo);
+        glDeleteTextures(1, tex);
+        *fbo = 0;
+        *tex = 0;
+        return false;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    return shadowMap;
+    return true;
 }
 
-static r3d_light_shadow_map_t alloc_shadow_map_cube(int resolution)
+static bool create_shadow_atlas(void)
 {
-    r3d_light_shadow_map_t shadowMap = { 0 };
-    shadowMap.resolution = resolution;
+    int maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
 
-    if (shadowMap.fbo == 0) {
-        glGenFramebuffers(1, &shadowMap.fbo);
-        glGenTextures(1, &shadowMap.tex);
-    }
+    int size = R3D_LIGHT_SHADOW_ATLAS_SIZE;
+    while (size > maxSize) size /= 2;
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, shadowMap.tex);
-    for (int i = 0; i < 6; ++i) {
-        glTexImage2D(
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT16,
-            resolution, resolution, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, NULL
-        );
+    if (!create_shadow_depth_target(&R3D_MOD_LIGHT.shadowAtlasFbo, &R3D_MOD_LIGHT.shadowAtlasTex, size, "shadow atlas")) {
+        return false;
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, shadowMap.fbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X, shadowMap.tex, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
+    // Sampled as 'sampler2DShadow', each fetch compares and filters the 4 nearest texels
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_LIGHT.shadowAtlasTex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        TraceLog(LOG_ERROR, "R3D: Framebuffer creation error for the Cube shadow map");
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    R3D_MOD_LIGHT.shadowAtlasSize = size;
 
-    return shadowMap;
+    return true;
 }
 
-// ========================================
-// INTERNAL ARRAY FUNCTIONS
-// ========================================
-
-bool growth_arrays(void)
+/*
+ * The cache mirrors the atlas so that a tile is copied at the same place, without any conversion.
+ */
+static bool create_shadow_cache(void)
 {
-    int newCapacity = 2 * R3D_MOD_LIGHT.capacityLights;
-
-    r3d_light_t* newLights = RL_REALLOC(R3D_MOD_LIGHT.lights, newCapacity * sizeof(*R3D_MOD_LIGHT.lights));
-    if (newLights == NULL) return false;
+    return create_shadow_depth_target(
+        &R3D_MOD_LIGHT.shadowCacheFbo, &R3D_MOD_LIGHT.shadowCacheTex,
+        R3D_MOD_LIGHT.shadowAtlasSize, "static shadow cache"
+    );
+}
 
-    R3D_MOD_LIGHT.capacityLights = newCapacity;
-    R3D_MOD_LIGHT.lights = newLights;
+static int get_atlas_node(int level, int x, int y)
+{
+    return ((1 << (2 * level)) - 1) / 3 + y * (1 << level) + x;
+}
 
-    for (int i = 0; i < R3D_LIGHT_ARRAY_COUNT; i++) {
-        R3D_Light** oldPtr = &R3D_MOD_LIGHT.arrays[i].lights;
-        R3D_Light* newPtr = RL_REALLOC(*oldPtr, newCapacity * sizeof(**oldPtr));
-        if (newPtr == NULL) return false;
-        *oldPtr = newPtr;
+static void get_atlas_node_coord(int node, int* level, int* x, int* y)
+{
+    *level = 0;
+    while (*level + 1 < R3D_LIGHT_SHADOW_ATLAS_LEVELS && get_atlas_node(*level + 1, 0, 0) <= node) {
+        (*level)++;
     }
 
-    return true;
+    int index = node - get_atlas_node(*level, 0, 0);
+    *x = index % (1 << *level);
+    *y = index / (1 << *level);
 }
 
-// ========================================
-// MODULE STATE
-// ========================================
+static int get_atlas_level(int tileSize)
+{
+    int level = 0;
+    while ((R3D_MOD_LIGHT.shadowAtlasSize >> level) > tileSize) level++;
+    return level;
+}
 
-bool r3d_light_init(void)
+/*
+ * Finds a free node at the given level, depth first so that the tiles stay packed.
+ * A free node is marked as split on the way down, its children are free so the search must succeed.
+ */
+static int alloc_atlas_node(int level, int nodeLevel, int x, int y)
 {
-    memset(&R3D_MOD_LIGHT, 0, sizeof(R3D_MOD_LIGHT));
+    uint8_t* state = &R3D_MOD_LIGHT.shadowAtlasNodes[get_atlas_node(nodeLevel, x, y)];
 
-    const int LIGHT_RESERVE_COUNT = 32;
+    if (*state == ATLAS_NODE_USED) {
+        return -1;
+    }
 
-    R3D_MOD_LIGHT.lights = RL_MALLOC(LIGHT_RESERVE_COUNT * sizeof(*R3D_MOD_LIGHT.lights));
-    R3D_MOD_LIGHT.capacityLights = LIGHT_RESERVE_COUNT;
-    if (!R3D_MOD_LIGHT.lights) {
-        TraceLog(LOG_FATAL, "R3D: Failed to init light module; Main light array allocation failed");
-        return false;
+    if (nodeLevel == level) {
+        if (*state != ATLAS_NODE_FREE) return -1;
+        *state = ATLAS_NODE_USED;
+        return get_atlas_node(level, x, y);
     }
 
-    for (int i = 0; i < R3D_LIGHT_ARRAY_COUNT; i++) {
-        R3D_MOD_LIGHT.arrays[i].lights = RL_MALLOC(LIGHT_RESERVE_COUNT * sizeof(*R3D_MOD_LIGHT.arrays[i].lights));
-        if (R3D_MOD_LIGHT.arrays[i].lights == NULL) {
-            TraceLog(LOG_FATAL, "R3D: Failed to init light module; Light array %i allocation failed", i);
-            for (int j = 0; j <= i; j++) RL_FREE(R3D_MOD_LIGHT.arrays[j].lights);
-            return false;
-        }
+    *state = ATLAS_NODE_SPLIT;
+
+    for (int i = 0; i < 4; i++) {
+        int node = alloc_atlas_node(level, nodeLevel + 1, 2 * x + (i & 1), 2 * y + (i >> 1));
+        if (node >= 0) return node;
     }
 
-    return true;
+    return -1;
 }
 
-void r3d_light_quit(void)
+/*
+ * Marks an exact node as used, fails if the node or one of its parents is used.
+ */
+static bool reserve_atlas_node(int node)
 {
-    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
-    r3d_light_array_t* freeLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_FREE];
+    int level, x, y;
+    get_atlas_node_coord(node, &level, &x, &y);
 
-    for (int i = 0; i < validLights->count; i++) {
-        r3d_light_t* light = &R3D_MOD_LIGHT.lights[validLights->lights[i]];
-        if (light->shadowMap.fbo != 0) {
-            glDeleteFramebuffers(1, &light->shadowMap.fbo);
-            glDeleteTextures(1, &light->shadowMap.tex);
-        }
+    uint8_t* nodes = R3D_MOD_LIGHT.shadowAtlasNodes;
+
+    if (nodes[node] != ATLAS_NODE_FREE) {
+        return false;
     }
 
-    for (int i = 0; i < freeLights->count; i++) {
-        r3d_light_t* light = &R3D_MOD_LIGHT.lights[freeLights->lights[i]];
-        if (light->shadowMap.fbo != 0) {
-            glDeleteFramebuffers(1, &light->shadowMap.fbo);
-            glDeleteTextures(1, &light->shadowMap.tex);
+    for (int l = 0; l < level; l++) {
+        if (nodes[get_atlas_node(l, x >> (level - l), y >> (level - l))] == ATLAS_NODE_USED) {
+            return false;
         }
     }
 
-    for (int i = 0; i < R3D_LIGHT_ARRAY_COUNT; i++) {
-        RL_FREE(R3D_MOD_LIGHT.arrays[i].lights);
+    for (int l = 0; l < level; l++) {
+        nodes[get_atlas_node(l, x >> (level - l), y >> (level - l))] = ATLAS_NODE_SPLIT;
     }
 
-    RL_FREE(R3D_MOD_LIGHT.lights);
+    nodes[node] = ATLAS_NODE_USED;
+
+    return true;
 }
 
-R3D_Light r3d_light_new(R3D_LightType type)
+/*
+ * Reserves the tiles the light had last frame, if it still wants tiles of the same size.
+ * Their content is then still valid and only updated with the light shadow update mode.
+ */
+static bool keep_shadow_tiles(r3d_light_t* light, int tileSize)
 {
-    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
-    r3d_light_array_t* freeLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_FREE];
-
-    R3D_Light index = validLights->count;
-
-    if (freeLights->count == 0) {
-        validLights->lights[validLights->count++] = index;
-    }
-    else {
-        index = freeLights->lights[--freeLights->count];
+    r3d_light_shadow_map_t* map = &light->shadowMap;
+    if (map->tileSize == 0 || map->tileSize != tileSize) {
+        return false;
     }
 
-    if (index >= R3D_MOD_LIGHT.capacityLights) {
-        if (!growth_arrays()) {
-            TraceLog(LOG_FATAL, "R3D: Bad alloc on light creation");
-            return -1;
+    int numTiles = r3d_light_get_shadow_views(light);
+    for (int i = 0; i < numTiles; i++) {
+        if (!reserve_atlas_node(map->tiles[i])) {
+            for (int j = 0; j < i; j++) R3D_MOD_LIGHT.shadowAtlasNodes[map->tiles[j]] = ATLAS_NODE_FREE;
+            return false;
         }
     }
 
-    init_light(&R3D_MOD_LIGHT.lights[index], type);
-
-    return index;
+    return true;
 }
 
-void r3d_light_delete(R3D_Light index)
+/*
+ * Allocates new tiles for the light, halving their size until they fit.
+ * The shadow must then be rendered again.
+ */
+static bool alloc_shadow_tiles(r3d_light_t* light, int tileSize)
 {
-    if (index < 0) return;
-
-    bool lightFound = false;
-
-    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
-    for (int i = 0; i < validLights->count; i++) {
-        if (index == validLights->lights[i]) {
-            int numToMove = validLights->count - i - 1;
-            if (numToMove > 0) {
-                memmove(
-                    &validLights->lights[i],
-                    &validLights->lights[i + 1],
-                    numToMove * sizeof(validLights->lights[0])
-                );
-            }
-            validLights->count--;
-            lightFound = true;
-            break;
+    r3d_light_shadow_map_t* map = &light->shadowMap;
+    int numTiles = r3d_light_get_shadow_views(light);
+    int minTileSize = R3D_MOD_LIGHT.shadowAtlasSize >> (R3D_LIGHT_SHADOW_ATLAS_LEVELS - 1);
+
+    for (; tileSize >= minTileSize; tileSize /= 2) {
+        int level = get_atlas_level(tileSize);
+        int count = 0;
+        for (; count < numTiles; count++) {
+            int node = alloc_atlas_node(level, 0, 0, 0);
+            if (node < 0) break;
+            map->tiles[count] = node;
+        }
+        if (count == numTiles) {
+            map->tileSize = tileSize;
+            map->cacheMask = 0;
+            light->state.shadowShouldBeUpdated = true;
+            light->state.cascadesShouldBeUpdated = true;
+            light->state.shadowIsEmpty = true;
+            light->state.pendingViews = 0;
+            return true;
+        }
+        for (int i = 0; i < count; i++) {
+            R3D_MOD_LIGHT.shadowAtlasNodes[map->tiles[i]] = ATLAS_NODE_FREE;
         }
     }
 
-    if (!lightFound) {
-        return;
-    }
+    map->tileSize = 0;
 
-    r3d_light_array_t* freeLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_FREE];
-    freeLights->lights[freeLights->count++] = index;
+    return false;
 }
 
-bool r3d_light_is_valid(R3D_Light index)
+/*
+ * Size of the tiles wanted by the light: the requested resolution scaled by the square root of its screen coverage.
+ * The previous size is kept while the wanted one stays close, so that the tiles are not reallocated every frame.
+ */
+static int get_shadow_tile_size(const r3d_light_t* light)
 {
-    if (index < 0) return false;
+    const r3d_light_shadow_map_t* map = &light->shadowMap;
 
-    const r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
-    for (int i = 0; i < validLights->count; i++) {
-        if (index == validLights->lights[i]) {
-            return true;
-        }
+    int maxTileSize = R3D_MOD_LIGHT.shadowAtlasSize / ((r3d_light_get_shadow_views(light) > 1) ? 4 : 2);
+    int minTileSize = R3D_MOD_LIGHT.shadowAtlasSize >> (R3D_LIGHT_SHADOW_ATLAS_LEVELS - 1);
+
+    float wanted = map->resolution * sqrtf(map->coverage);
+
+    if (map->tileSize > 0 && wanted > 0.35f * map->tileSize && wanted < 1.4f * map->tileSize) {
+        return map->tileSize;
     }
 
-    return false;
+    int tileSize = minTileSize;
+    while (tileSize < wanted && 2 * tileSize <= maxTileSize && 2 * tileSize <= map->resolution) {
+        tileSize *= 2;
+    }
+
+    return tileSize;
 }
 
-r3d_light_t* r3d_light_get(R3D_Light index)
+static float get_light_coverage(const r3d_light_t* light, const Matrix* viewProj)
 {
-    if (r3d_light_is_valid(index)) {
-        return &R3D_MOD_LIGHT.lights[index];
+    if (light->type == R3D_LIGHT_DIR) {
+        return 1.0f;
     }
 
-    return NULL;
+    const int SIZE = 1024;
+    r3d_rect_t rect = r3d_light_get_screen_rect(light, viewProj, SIZE, SIZE);
+
+    return (float)(rect.w * rect.h) / (SIZE * SIZE);
 }
 
-r3d_rect_t r3d_light_get_screen_rect(const r3d_light_t* light, const Matrix* viewProj, int w, int h)
+// ========================================
+// INTERNAL LIGHT BUDGET FUNCTIONS
+// ========================================
+
+/*
+ * Fraction of the screen covered by the projected bounds of the light, one if they cross the camera plane.
+ * Unlike 'r3d_light_get_screen_rect()', this is not rounded to pixels so that it varies continuously.
+ */
+static float get_light_screen_area(const r3d_light_t* light, const Matrix* viewProj)
 {
-    assert(light->type != R3D_LIGHT_DIR);
+    if (light->type == R3D_LIGHT_DIR) {
+        return 1.0f;
+    }
 
     Vector3 min = light->aabb.min;
     Vector3 max = light->aabb.max;
@@ -470,108 +722,1145 @@ r3d_rect_t r3d_light_get_screen_rect(const r3d_light_t* light, const Matrix* vie
     Vector2 minNDC = {+FLT_MAX, +FLT_MAX};
     Vector2 maxNDC = {-FLT_MAX, -FLT_MAX};
 
-    bool allInside = true;
     for (int i = 0; i < 8; i++) {
         Vector4 corner = {(i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f};
         Vector4 clip = r3d_vector4_transform(corner, viewProj);
-        if (clip.w <= 0.0f) { allInside = false; break; }
+        if (clip.w <= 0.0f) return 1.0f;
 
         Vector2 ndc = Vector2Scale((Vector2){clip.x, clip.y}, 1.0f / clip.w);
         minNDC = Vector2Min(minNDC, ndc);
         maxNDC = Vector2Max(maxNDC, ndc);
     }
 
-    int x = 0;
-    int y = 0;
-
-    if (allInside) {
-        x = (int)fmaxf((minNDC.x * 0.5f + 0.5f) * w, 0.0f);
-        y = (int)fmaxf((minNDC.y * 0.5f + 0.5f) * h, 0.0f);
-        w = (int)fminf((maxNDC.x * 0.5f + 0.5f) * w, (float)w) - x;
-        h = (int)fminf((maxNDC.y * 0.5f + 0.5f) * h, (float)h) - y;
-        assert(w > 0 && h > 0); // This should never happen if the upstream frustum culling of the lights is correct.
-    }
+    float w = Clamp(maxNDC.x, -1.0f, 1.0f) - Clamp(minNDC.x, -1.0f, 1.0f);
+    float h = Clamp(maxNDC.y, -1.0f, 1.0f) - Clamp(minNDC.y, -1.0f, 1.0f);
 
-    return (r3d_rect_t) {x, y, w, h};
+    return 0.25f * w * h;
 }
 
-bool r3d_light_iter(r3d_light_t** light, int array_type)
+static int compare_light_importance(const void* a, const void* b)
 {
-    static int index = 0;
-
-    index = (*light == NULL) ? 0 : index + 1;
-    if (index >= R3D_MOD_LIGHT.arrays[array_type].count) return false;
-    *light = &R3D_MOD_LIGHT.lights[R3D_MOD_LIGHT.arrays[array_type].lights[index]];
+    float ia = R3D_MOD_LIGHT.lights[*(const R3D_Light*)a].importance;
+    float ib = R3D_MOD_LIGHT.lights[*(const R3D_Light*)b].importance;
 
-    return true;
+    return (ia < ib) - (ia > ib);
 }
 
-void r3d_light_update_matrix(r3d_light_t* light)
+/*
+ * Keeps the most important visible lights within the budget and above the threshold.
+ * The importance is the energy of the light, its attenuation factor and its brightest channel,
+ * times its screen coverage which already falls off with the square of the distance. Dir lights are always kept.
+ * The kept lights fade from full energy at twice the cut to zero at the cut, the cut being the highest of
+ * the threshold and the importance of the first light left out, so lights leave the budget without popping.
+ */
+static void apply_light_budget(const Matrix* viewProjs, int numViews)
 {
-    light->state.matrixShouldBeUpdated = true;
-}
+    r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
 
-void r3d_light_enable_shadows(r3d_light_t* light, int resolution)
-{
-    if (light->shadowMap.fbo == 0 || light->shadowMap.resolution == resolution) {
-        switch (light->type) {
-        case R3D_LIGHT_DIR:
-        case R3D_LIGHT_SPOT:
-            light->shadowMap = alloc_shadow_map_2d(resolution);
-            break;
-        case R3D_LIGHT_OMNI:
-            light->shadowMap = alloc_shadow_map_cube(resolution);
-            break;
-        }
-    }
+    int budget = R3D_MOD_LIGHT.lightBudget;
+    float threshold = R3D_MOD_LIGHT.lightThreshold;
 
-    light->shadow = true;
-    light->state.shadowShouldBeUpdated = true;
-    light->shadowTexelSize = 1.0f / resolution;
-    light->shadowSoftness = 4.0f * light->shadowTexelSize;
-}
+    for (int i = 0; i < visibleLights->count; i++) {
+        R3D_MOD_LIGHT.lights[visibleLights->lights[i]].fade = 1.0f;
+    }
 
-void r3d_light_update_and_cull(const r3d_frustum_t* viewFrustum, Vector3 viewPosition)
-{
-    r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
-    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
+    if ((budget <= 0 || visibleLights->count <= budget) && threshold <= 0.0f) {
+        return;
+    }
 
-    visibleLights->count = 0;
+    /* --- Sort the visible lights by decreasing importance --- */
 
-    for (int i = 0; i < validLights->count; i++)
+    for (int i = 0; i < visibleLights->count; i++)
     {
-        R3D_Light index = validLights->lights[i];
-        r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[visibleLights->lights[i]];
 
-        if (!light->enabled) continue;
+        if (light->type == R3D_LIGHT_DIR) {
+            light->importance = FLT_MAX;
+            continue;
+        }
 
-        if (light->shadow) {
-            update_light_shadow_state(light);
+        float coverage = 0.0f;
+        for (int iView = 0; iView < numViews; iView++) {
+            coverage = fmaxf(coverage, get_light_screen_area(light, &viewProjs[iView]));
         }
 
-        bool isDirectional = (light->type == R3D_LIGHT_DIR);
-        bool shouldUpdateMatrix = isDirectional 
-            ? light->state.shadowShouldBeUpdated
-            : light->state.matrixShouldBeUpdated;
+        float brightness = fmaxf(light->color.x, fmaxf(light->color.y, light->color.z));
+        light->importance = light->energy * light->attenuation * brightness * coverage;
+    }
 
-        if (shouldUpdateMatrix) {
-            update_light_matrix(light, viewPosition);
-            if (light->shadow) update_light_frustum(light);
-            if (!isDirectional) update_light_bounding_box(light);
-            light->state.matrixShouldBeUpdated = false;
-        }
+    qsort(visibleLights->lights, visibleLights->count, sizeof(R3D_Light), compare_light_importance);
 
-        if (r3d_frustum_is_aabb_in(viewFrustum, &light->aabb)) {
-            visibleLights->lights[visibleLights->count++] = index;
+    /* --- Cut the least important lights, fade the ones close to the cut --- */
+
+    float cut = threshold;
+    if (budget > 0 && visibleLights->count > budget) {
+        cut = fmaxf(cut, R3D_MOD_LIGHT.lights[visibleLights->lights[budget]].importance);
+    }
+
+    // Only the lights above the cut remain, which is at most the budget except for dir lights
+    int keptCount = visibleLights->count;
+    while (keptCount > 0) {
+        const r3d_light_t* last = &R3D_MOD_LIGHT.lights[visibleLights->lights[keptCount - 1]];
+        if (last->type == R3D_LIGHT_DIR || last->importance > cut) break;
+        keptCount--;
+    }
+
+    for (int i = 0; i < visibleLights->count; i++) {
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[visibleLights->lights[i]];
+        if (i >= keptCount) {
+            light->shadowMap.tileSize = 0;
+        }
+        else if (light->type != R3D_LIGHT_DIR && cut > 0.0f) {
+            light->fade = Clamp((light->importance - cut) / cut, 0.0f, 1.0f);
         }
     }
+
+    visibleLights->count = keptCount;
+}
+
+static void update_shadow_atlas(const Matrix* viewProjs, int numViews)
+{
+    r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
+
+    memset(R3D_MOD_LIGHT.shadowAtlasNodes, 0, sizeof(R3D_MOD_LIGHT.shadowAtlasNodes));
+
+    /* --- Move the shadowed lights first, sorted by screen coverage --- */
+
+    int shadowCount = 0;
+    for (int i = 0; i < visibleLights->count; i++) {
+        R3D_Light index = visibleLights->lights[i];
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+        if (!light->shadow || R3D_MOD_LIGHT.shadowAtlasFbo == 0) {
+            light->shadowMap.tileSize = 0;
+            continue;
+        }
+        // The tiles follow the view where the light covers the most of the screen
+        light->shadowMap.coverage = 0.0f;
+        for (int iView = 0; iView < numViews; iView++) {
+            light->shadowMap.coverage = fmaxf(light->shadowMap.coverage, get_light_coverage(light, &viewProjs[iView]));
+        }
+        visibleLights->lights[i] = visibleLights->lights[shadowCount];
+        visibleLights->lights[shadowCount++] = index;
+    }
+
+    for (int i = 1; i < shadowCount; i++) {
+        R3D_Light index = visibleLights->lights[i];
+        float coverage = R3D_MOD_LIGHT.lights[index].shadowMap.coverage;
+        int j = i;
+        for (; j > 0 && R3D_MOD_LIGHT.lights[visibleLights->lights[j - 1]].shadowMap.coverage < coverage; j--) {
+            visibleLights->lights[j] = visibleLights->lights[j - 1];
+        }
+        visibleLights->lights[j] = index;
+    }
+
+    if (shadowCount > R3D_SHADER_FORWARD_BLOCK_SHADOWS) {
+        for (int i = R3D_SHADER_FORWARD_BLOCK_SHADOWS; i < shadowCount; i++) {
+            R3D_MOD_LIGHT.lights[visibleLights->lights[i]].shadowMap.tileSize = 0;
+        }
+        shadowCount = R3D_SHADER_FORWARD_BLOCK_SHADOWS;
+    }
+
+    /* --- Keep the tiles of the previous frame first, then allocate the others --- */
+
+    static int tileSizes[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+    static bool kept[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+
+    for (int i = 0; i < shadowCount; i++) {
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[visibleLights->lights[i]];
+        tileSizes[i] = get_shadow_tile_size(light);
+        kept[i] = keep_shadow_tiles(light, tileSizes[i]);
+    }
+
+    for (int i = 0; i < shadowCount; i++) {
+        if (!kept[i]) alloc_shadow_tiles(&R3D_MOD_LIGHT.lights[visibleLights->lights[i]], tileSizes[i]);
+    }
+
+    /* --- Keep the lights that got tiles first, see 'r3d_light_bind_visible()' --- */
+
+    int tiledCount = 0;
+    for (int i = 0; i < shadowCount; i++) {
+        R3D_Light index = visibleLights->lights[i];
+        if (r3d_light_has_shadow_tiles(&R3D_MOD_LIGHT.lights[index])) {
+            memmove(&visibleLights->lights[tiledCount + 1], &visibleLights->lights[tiledCount], (i - tiledCount) * sizeof(R3D_Light));
+            visibleLights->lights[tiledCount++] = index;
+        }
+    }
+}
+
+/*
+ * Number of shadow views rendered by an update, the cascades of dir lights are all counted.
+ */
+static int get_shadow_update_cost(const r3d_light_t* light)
+{
+    switch (light->type) {
+    case R3D_LIGHT_DIR: return light->shadowCascades;
+    case R3D_LIGHT_OMNI: {
+        int count = 0;
+        for (int i = 0; i < 6; i++) count += (light->state.pendingViews >> i) & 1;
+        return count;
+    }
+    default: break;
+    }
+    return 1;
+}
+
+/*
+ * Renders the given views of the current update this frame, or only its first 'maxViews' omni faces.
+ * The cascades of dir lights are selected when they are fitted.
+ */
+static void schedule_shadow_update(r3d_light_t* light, int maxViews)
+{
+    r3d_light_state_t* state = &light->state;
+
+    if (light->type == R3D_LIGHT_OMNI) {
+        for (int i = 0; i < 6 && maxViews > 0; i++) {
+            if (state->pendingViews & (1 << i)) {
+                state->viewMask |= 1 << i;
+                maxViews--;
+            }
+        }
+        state->pendingViews &= ~state->viewMask;
+    }
+    else if (light->type == R3D_LIGHT_SPOT) {
+        state->viewMask = 1;
+    }
+
+    state->shadowWaitFrames = 0;
+    state->shadowIsEmpty = false;
+}
+
+/*
+ * Selects the pending shadow updates rendered this frame, within the budget of views.
+ * The new tiles are always rendered, the other updates by decreasing screen coverage
+ * weighted by the frames they waited, so that the small lights are postponed but never starved.
+ */
+static void schedule_shadow_updates(void)
+{
+    r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
+
+    static r3d_light_t* candidates[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+    static float priorities[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+
+    int budget = R3D_MOD_LIGHT.shadowUpdateBudget;
+    int used = 0;
+    int count = 0;
+
+    /* --- Schedule the updates that can't wait and gather the others --- */
+
+    // The lights with tiles come first in the visible array
+    for (int i = 0; i < visibleLights->count; i++)
+    {
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[visibleLights->lights[i]];
+        if (!r3d_light_has_shadow_tiles(light)) break;
+
+        r3d_light_state_t* state = &light->state;
+        state->viewMask = 0;
+        state->shadowDeferred = false;
+
+        if (!state->shadowShouldBeUpdated) {
+            continue;
+        }
+
+        if (light->type == R3D_LIGHT_OMNI && (state->pendingViews == 0 || state->shadowIsEmpty)) {
+            state->pendingViews = 0x3F;
+        }
+
+        if (budget <= 0 || state->shadowIsEmpty) {
+            used += get_shadow_update_cost(light);
+            schedule_shadow_update(light, 6);
+            continue;
+        }
+
+        float priority = (light->shadowMap.coverage + 1e-3f) * (1 + state->shadowWaitFrames);
+
+        int j = count++;
+        for (; j > 0 && priorities[j - 1] < priority; j--) {
+            candidates[j] = candidates[j - 1];
+            priorities[j] = priorities[j - 1];
+        }
+        candidates[j] = light;
+        priorities[j] = priority;
+    }
+
+    /* --- Spend the rest of the budget by priority, the omni faces can be spread over several frames --- */
+
+    int remaining = budget - used;
+
+    for (int i = 0; i < count; i++)
+    {
+        r3d_light_t* light = candidates[i];
+        int cost = get_shadow_update_cost(light);
+
+        if (cost <= remaining) {
+            schedule_shadow_update(light, 6);
+            remaining -= cost;
+        }
+        else if (light->type == R3D_LIGHT_OMNI && remaining > 0) {
+            schedule_shadow_update(light, remaining);
+            remaining = 0;
+        }
+        else {
+            light->state.shadowDeferred = true;
+            light->state.shadowWaitFrames++;
+        }
+    }
+}
+
+// ========================================
+// INTERNAL ARRAY FUNCTIONS
+// ========================================
+
+// The lights and the index arrays share a single block, replaced as a whole when it grows
+static bool reserve_arrays(int newCapacity)
+{
+    int oldCapacity = R3D_MOD_LIGHT.capacityLights;
+
+    size_t lightsSize = newCapacity * sizeof(*R3D_MOD_LIGHT.lights);
+    size_t arraySize = newCapacity * sizeof(*R3D_MOD_LIGHT.arrays[0].lights);
+
+    uint8_t* block = RL_MALLOC(lightsSize + R3D_LIGHT_ARRAY_COUNT * arraySize);
+    if (block == NULL) return false;
+
+    r3d_light_t* lights = (r3d_light_t*)block;
+    if (oldCapacity > 0) {
+        memcpy(lights, R3D_MOD_LIGHT.lights, oldCapacity * sizeof(*lights));
+    }
+    R3D_MOD_LIGHT.lights = lights;
+
+    for (int i = 0; i < R3D_LIGHT_ARRAY_COUNT; i++) {
+        R3D_Light* indices = (R3D_Light*)(block + lightsSize + i * arraySize);
+        if (oldCapacity > 0) {
+            memcpy(indices, R3D_MOD_LIGHT.arrays[i].lights, oldCapacity * sizeof(*indices));
+        }
+        R3D_MOD_LIGHT.arrays[i].lights = indices;
+    }
+
+    RL_FREE(R3D_MOD_LIGHT.arrayBlock);
+    R3D_MOD_LIGHT.arrayBlock = block;
+    R3D_MOD_LIGHT.capacityLights = newCapacity;
+
+    return true;
+}
+
+static bool growth_arrays(void)
+{
+    return reserve_arrays(2 * R3D_MOD_LIGHT.capacityLights);
+}
+
+// ========================================
+// INTERNAL LIGHT GRID FUNCTIONS
+// ========================================
+
+#if R3D_SHADER_FORWARD_BLOCK_SHADOWS > 32
+#   error "The shadow masks of the light grid hold up to 32 shadowed lights"
+#endif
+
+#define GRID_LARGE_BUCKET R3D_LIGHT_GRID_BUCKETS
+
+static int grid_hash(int x, int y, int z)
+{
+    uint32_t h = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+    return (int)(h & (R3D_LIGHT_GRID_BUCKETS - 1));
+}
+
+// Returns false if the box covers more than 'R3D_LIGHT_GRID_MAX_CELLS' cells
+static bool grid_get_cells(const BoundingBox* box, int min[3], int max[3])
+{
+    const float invCellSize = 1.0f / R3D_LIGHT_GRID_CELL_SIZE;
+
+    float boxMin[3] = {box->min.x, box->min.y, box->min.z};
+    float boxMax[3] = {box->max.x, box->max.y, box->max.z};
+
+    int numCells = 1;
+    for (int i = 0; i < 3; i++) {
+        float lo = floorf(boxMin[i] * invCellSize);
+        float hi = floorf(boxMax[i] * invCellSize);
+        if (hi - lo >= R3D_LIGHT_GRID_MAX_CELLS) return false;
+        min[i] = (int)lo;
+        max[i] = (int)hi;
+        numCells *= max[i] - min[i] + 1;
+    }
+
+    return numCells <= R3D_LIGHT_GRID_MAX_CELLS;
+}
+
+static bool grid_push_entry(R3D_Light index, int bucket)
+{
+    r3d_light_grid_t* grid = &R3D_MOD_LIGHT.grid;
+    r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+
+    int entry = grid->freeEntry;
+
+    if (entry >= 0) {
+        grid->freeEntry = grid->entries[entry].next;
+    }
+    else {
+        if (grid->count == grid->capacity) {
+            int newCapacity = grid->capacity ? 2 * grid->capacity : 256;
+            r3d_light_grid_entry_t* newEntries = RL_REALLOC(grid->entries, newCapacity * sizeof(*newEntries));
+            if (newEntries == NULL) return false;
+            grid->entries = newEntries;
+            grid->capacity = newCapacity;
+        }
+        entry = grid->count++;
+    }
+
+    r3d_light_grid_entry_t* e = &grid->entries[entry];
+    e->light = index;
+    e->bucket = bucket;
+    e->next = grid->buckets[bucket];
+    e->nextOfLight = light->gridEntry;
+
+    grid->buckets[bucket] = entry;
+    light->gridEntry = entry;
+
+    return true;
+}
+
+static void grid_remove(R3D_Light index)
+{
+    r3d_light_grid_t* grid = &R3D_MOD_LIGHT.grid;
+    r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+
+    int entry = light->gridEntry;
+
+    while (entry >= 0)
+    {
+        r3d_light_grid_entry_t* e = &grid->entries[entry];
+
+        // Buckets only hold a few entries, finding the previous one is cheap
+        int* link = &grid->buckets[e->bucket];
+        while (*link != entry) link = &grid->entries[*link].next;
+        *link = e->next;
+
+        int next = e->nextOfLight;
+        e->next = grid->freeEntry;
+        grid->freeEntry = entry;
+        entry = next;
+    }
+
+    light->gridEntry = -1;
+}
+
+// Bins the light again in the cells covered by its volume, large or unbounded volumes go in the large bucket
+static void grid_insert(R3D_Light index)
+{
+    grid_remove(index);
+
+    const r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+
+    int min[3], max[3];
+    bool binned = grid_get_cells(&light->aabb, min, max);
+
+    for (int z = min[2]; binned && z <= max[2]; z++) {
+        for (int y = min[1]; binned && y <= max[1]; y++) {
+            for (int x = min[0]; binned && x <= max[0]; x++) {
+                binned = grid_push_entry(index, grid_hash(x, y, z));
+            }
+        }
+    }
+
+    if (!binned) {
+        grid_remove(index);
+        if (!grid_push_entry(index, GRID_LARGE_BUCKET)) {
+            TraceLog(LOG_WARNING, "R3D: Bad alloc on light grid update; The light will not cast shadows on forward objects");
+        }
+    }
+}
+
+static uint32_t grid_collect_shadows(int bucket, const BoundingBox* box, uint32_t mask)
+{
+    const r3d_light_grid_t* grid = &R3D_MOD_LIGHT.grid;
+
+    for (int entry = grid->buckets[bucket]; entry >= 0; entry = grid->entries[entry].next)
+    {
+        const r3d_light_t* light = &R3D_MOD_LIGHT.lights[grid->entries[entry].light];
+
+        // A light covering several cells is met once per cell
+        int slot = light->shadowSlot;
+        if (slot < 0 || (mask & (1u << slot))) {
+            continue;
+        }
+
+        if (light->type == R3D_LIGHT_DIR || CheckCollisionBoxes(light->aabb, *box)) {
+            mask |= 1u << slot;
+        }
+    }
+
+    return mask;
+}
+
+// ========================================
+// INTERNAL CLUSTER FUNCTIONS
+// ========================================
+
+static int get_cluster_slice(float depth, Vector2 slice)
+{
+    int z = (int)floorf(logf(fmaxf(depth, 1e-4f)) * slice.x + slice.y);
+    return (z < 0) ? 0 : (z >= R3D_SHADER_FORWARD_CLUSTER_Z) ? R3D_SHADER_FORWARD_CLUSTER_Z - 1 : z;
+}
+
+static int get_cluster_tile(float ndc, int count)
+{
+    int t = (int)floorf((ndc * 0.5f + 0.5f) * count);
+    return (t < 0) ? 0 : (t >= count) ? count - 1 : t;
+}
+
+/*
+ * Computes the range of clusters covered by the light AABB, bounds included.
+ * Directional lights cover the whole grid, as well as lights behind the camera on the XY axes.
+ */
+static void get_light_clusters(const r3d_light_t* light, const Matrix* view, const Matrix* viewProj,
+                               Vector2 slice, int min[3], int max[3])
+{
+    min[0] = min[1] = min[2] = 0;
+    max[0] = R3D_SHADER_FORWARD_CLUSTER_X - 1;
+    max[1] = R3D_SHADER_FORWARD_CLUSTER_Y - 1;
+    max[2] = R3D_SHADER_FORWARD_CLUSTER_Z - 1;
+
+    if (light->type == R3D_LIGHT_DIR) {
+        return;
+    }
+
+    Vector3 aabbMin = light->aabb.min;
+    Vector3 aabbMax = light->aabb.max;
+
+    Vector2 minNDC = {+FLT_MAX, +FLT_MAX};
+    Vector2 maxNDC = {-FLT_MAX, -FLT_MAX};
+    float minDepth = +FLT_MAX;
+    float maxDepth = -FLT_MAX;
+
+    bool allInFront = true;
+    for (int i = 0; i < 8; i++) {
+        Vector4 corner = {(i & 1) ? aabbMax.x : aabbMin.x, (i & 2) ? aabbMax.y : aabbMin.y, (i & 4) ? aabbMax.z : aabbMin.z, 1.0f};
+
+        float depth = -r3d_vector4_transform(corner, view).z;
+        minDepth = fminf(minDepth, depth);
+        maxDepth = fmaxf(maxDepth, depth);
+
+        Vector4 clip = r3d_vector4_transform(corner, viewProj);
+        if (clip.w <= 0.0f) {
+            allInFront = false;
+            continue;
+        }
+
+        Vector2 ndc = Vector2Scale((Vector2){clip.x, clip.y}, 1.0f / clip.w);
+        minNDC = Vector2Min(minNDC, ndc);
+        maxNDC = Vector2Max(maxNDC, ndc);
+    }
+
+    if (allInFront) {
+        min[0] = get_cluster_tile(minNDC.x, R3D_SHADER_FORWARD_CLUSTER_X);
+        min[1] = get_cluster_tile(minNDC.y, R3D_SHADER_FORWARD_CLUSTER_Y);
+        max[0] = get_cluster_tile(maxNDC.x, R3D_SHADER_FORWARD_CLUSTER_X);
+        max[1] = get_cluster_tile(maxNDC.y, R3D_SHADER_FORWARD_CLUSTER_Y);
+    }
+
+    min[2] = get_cluster_slice(minDepth, slice);
+    max[2] = get_cluster_slice(maxDepth, slice);
+}
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+bool r3d_light_init(void)
+{
+    memset(&R3D_MOD_LIGHT, 0, sizeof(R3D_MOD_LIGHT));
+
+    const int LIGHT_RESERVE_COUNT = 32;
+
+    if (!reserve_arrays(LIGHT_RESERVE_COUNT)) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init light module; Light array allocation failed");
+        return false;
+    }
+
+    for (int i = 0; i <= R3D_LIGHT_GRID_BUCKETS; i++) {
+        R3D_MOD_LIGHT.grid.buckets[i] = -1;
+    }
+    R3D_MOD_LIGHT.grid.freeEntry = -1;
+
+    R3D_MOD_LIGHT.clusterIndices = RL_MALLOC(CLUSTER_MAX_INDICES);
+    if (R3D_MOD_LIGHT.clusterIndices == NULL) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init light module; Cluster index array allocation failed");
+        RL_FREE(R3D_MOD_LIGHT.arrayBlock);
+        return false;
+    }
+
+    glGenBuffers(1, &R3D_MOD_LIGHT.uniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, R3D_MOD_LIGHT.uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(uniform_light_block_t), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glGenBuffers(1, &R3D_MOD_LIGHT.clusterRangeBuffer);
+    glGenBuffers(1, &R3D_MOD_LIGHT.clusterIndexBuffer);
+    glGenTextures(1, &R3D_MOD_LIGHT.clusterRangeTexture);
+    glGenTextures(1, &R3D_MOD_LIGHT.clusterIndexTexture);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterRangeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, CLUSTER_COUNT * 2 * sizeof(uint32_t), NULL, GL_STREAM_DRAW);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterRangeTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, R3D_MOD_LIGHT.clusterRangeBuffer);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 1, NULL, GL_STREAM_DRAW);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterIndexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R8UI, R3D_MOD_LIGHT.clusterIndexBuffer);
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return true;
+}
+
+void r3d_light_quit(void)
+{
+    if (R3D_MOD_LIGHT.shadowAtlasFbo != 0) {
+        glDeleteFramebuffers(1, &R3D_MOD_LIGHT.shadowAtlasFbo);
+        glDeleteTextures(1, &R3D_MOD_LIGHT.shadowAtlasTex);
+    }
+
+    if (R3D_MOD_LIGHT.shadowCacheFbo != 0) {
+        glDeleteFramebuffers(1, &R3D_MOD_LIGHT.shadowCacheFbo);
+        glDeleteTextures(1, &R3D_MOD_LIGHT.shadowCacheTex);
+    }
+
+    RL_FREE(R3D_MOD_LIGHT.arrayBlock);
+
+    RL_FREE(R3D_MOD_LIGHT.clusterIndices);
+    RL_FREE(R3D_MOD_LIGHT.grid.entries);
+
+    glDeleteBuffers(1, &R3D_MOD_LIGHT.uniformBuffer);
+    glDeleteBuffers(1, &R3D_MOD_LIGHT.clusterRangeBuffer);
+    glDeleteBuffers(1, &R3D_MOD_LIGHT.clusterIndexBuffer);
+    glDeleteTextures(1, &R3D_MOD_LIGHT.clusterRangeTexture);
+    glDeleteTextures(1, &R3D_MOD_LIGHT.clusterIndexTexture);
+}
+
+R3D_Light r3d_light_new(R3D_LightType type)
+{
+    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
+    r3d_light_array_t* freeLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_FREE];
+
+    R3D_Light index = validLights->count;
+
+    if (freeLights->count == 0) {
+        validLights->lights[validLights->count++] = index;
+    }
+    else {
+        index = freeLights->lights[--freeLights->count];
+    }
+
+    if (index >= R3D_MOD_LIGHT.capacityLights) {
+        if (!growth_arrays()) {
+            TraceLog(LOG_FATAL, "R3D: Bad alloc on light creation");
+            return -1;
+        }
+    }
+
+    init_light(&R3D_MOD_LIGHT.lights[index], type);
+    grid_insert(index);
+
+    return index;
+}
+
+void r3d_light_delete(R3D_Light index)
+{
+    if (index < 0) return;
+
+    bool lightFound = false;
+
+    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
+    for (int i = 0; i < validLights->count; i++) {
+        if (index == validLights->lights[i]) {
+            int numToMove = validLights->count - i - 1;
+            if (numToMove > 0) {
+                memmove(
+                    &validLights->lights[i],
+                    &validLights->lights[i + 1],
+                    numToMove * sizeof(validLights->lights[0])
+                );
+            }
+            validLights->count--;
+            lightFound = true;
+            break;
+        }
+    }
+
+    if (!lightFound) {
+        return;
+    }
+
+    grid_remove(index);
+
+    r3d_light_array_t* freeLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_FREE];
+    freeLights->lights[freeLights->count++] = index;
+}
+
+bool r3d_light_is_valid(R3D_Light index)
+{
+    if (index < 0) return false;
+
+    const r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
+    for (int i = 0; i < validLights->count; i++) {
+        if (index == validLights->lights[i]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+r3d_light_t* r3d_light_get(R3D_Light index)
+{
+    if (r3d_light_is_valid(index)) {
+        return &R3D_MOD_LIGHT.lights[index];
+    }
+
+    return NULL;
+}
+
+r3d_rect_t r3d_light_get_screen_rect(const r3d_light_t* light, const Matrix* viewProj, int w, int h)
+{
+    assert(light->type != R3D_LIGHT_DIR);
+
+    Vector3 min = light->aabb.min;
+    Vector3 max = light->aabb.max;
+
+    Vector2 minNDC = {+FLT_MAX, +FLT_MAX};
+    Vector2 maxNDC = {-FLT_MAX, -FLT_MAX};
+
+    bool allInside = true;
+    for (int i = 0; i < 8; i++) {
+        Vector4 corner = {(i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z, 1.0f};
+        Vector4 clip = r3d_vector4_transform(corner, viewProj);
+        if (clip.w <= 0.0f) { allInside = false; break; }
+
+        Vector2 ndc = Vector2Scale((Vector2){clip.x, clip.y}, 1.0f / clip.w);
+        minNDC = Vector2Min(minNDC, ndc);
+        maxNDC = Vector2Max(maxNDC, ndc);
+    }
+
+    int x = 0;
+    int y = 0;
+
+    if (allInside) {
+        x = (int)fmaxf((minNDC.x * 0.5f + 0.5f) * w, 0.0f);
+        y = (int)fmaxf((minNDC.y * 0.5f + 0.5f) * h, 0.0f);
+        w = (int)fminf((maxNDC.x * 0.5f + 0.5f) * w, (float)w) - x;
+        h = (int)fminf((maxNDC.y * 0.5f + 0.5f) * h, (float)h) - y;
+        assert(w > 0 && h > 0); // This should never happen if the upstream frustum culling of the lights is correct.
+    }
+
+    return (r3d_rect_t) {x, y, w, h};
+}
+
+r3d_rect_t r3d_light_get_shadow_tile(const r3d_light_t* light, int view)
+{
+    assert(r3d_light_has_shadow_tiles(light));
+    assert(view < r3d_light_get_shadow_views(light));
+
+    int node = light->shadowMap.tiles[view];
+
+    int level, x, y;
+    get_atlas_node_coord(node, &level, &x, &y);
+
+    int size = R3D_MOD_LIGHT.shadowAtlasSize >> level;
+
+    return (r3d_rect_t) {x * size, y * size, size, size};
+}
+
+bool r3d_light_iter(r3d_light_t** light, int array_type)
+{
+    static int index = 0;
+
+    index = (*light == NULL) ? 0 : index + 1;
+    if (index >= R3D_MOD_LIGHT.arrays[array_type].count) return false;
+    *light = &R3D_MOD_LIGHT.lights[R3D_MOD_LIGHT.arrays[array_type].lights[index]];
+
+    return true;
+}
+
+void r3d_light_update_matrix(r3d_light_t* light)
+{
+    light->state.matrixShouldBeUpdated = true;
+}
+
+void r3d_light_enable_shadows(r3d_light_t* light, int resolution)
+{
+    if (R3D_MOD_LIGHT.shadowAtlasFbo == 0 && !create_shadow_atlas()) {
+        return;
+    }
+
+    light->shadowMap.resolution = resolution;
+    light->shadowMap.tileSize = 0;
+
+    light->shadow = true;
+    light->state.shadowShouldBeUpdated = true;
+    light->state.matrixShouldBeUpdated = true;
+    light->shadowTexelSize = 1.0f / resolution;
+    light->shadowSoftness = 4.0f * light->shadowTexelSize;
+}
+
+void r3d_light_set_shadow_cascades(r3d_light_t* light, int count)
+{
+    light->shadowCascades = Clamp(count, 1, R3D_LIGHT_SHADOW_CASCADES);
+    light->shadowMap.tileSize = 0;
+}
+
+void r3d_light_update_and_cull(const r3d_frustum_t* viewFrustums, const Matrix* viewProjs, int numViews, float near, float far, bool occlusionCulling)
+{
+    assert(numViews >= 1 && numViews <= R3D_MAX_VIEWS);
+
+    r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
+    r3d_light_array_t* validLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VALID];
+
+    visibleLights->count = 0;
+
+    for (int i = 0; i < validLights->count; i++)
+    {
+        R3D_Light index = validLights->lights[i];
+        r3d_light_t* light = &R3D_MOD_LIGHT.lights[index];
+
+        light->shadowMap.movedMask = 0;
+        light->shadowSlot = -1;
+
+        // The tiles of the lights not visible are given to the others
+        if (!light->enabled) {
+            light->shadowMap.tileSize = 0;
+            continue;
+        }
+
+        if (light->shadow) {
+            update_light_shadow_state(light);
+        }
+
+        // The cascades of dir lights follow the view, they are fitted once the tiles are allocated
+        if (light->type == R3D_LIGHT_DIR) {
+            if (light->state.matrixShouldBeUpdated) {
+                light->state.cascadesShouldBeUpdated = true;
+                light->state.matrixShouldBeUpdated = false;
+            }
+        }
+        else if (light->state.matrixShouldBeUpdated) {
+            update_light_matrix(light);
+            update_light_bounding_box(light);
+            grid_insert(index);
+            if (light->shadow) update_light_frustum(light);
+            light->shadowMap.cacheMask = 0;
+            light->shadowMap.movedMask = 0x3F;
+            light->state.pendingViews = 0;
+            light->state.matrixShouldBeUpdated = false;
+        }
+
+        bool visible = false;
+        for (int iView = 0; iView < numViews && !visible; iView++) {
+            visible = r3d_frustum_is_aabb_in(&viewFrustums[iView], &light->aabb);
+        }
+
+        // The pyramid is one frame late, a light is only culled once hidden for several frames
+        // but is shown again as soon as any part of its volume is uncovered
+        if (visible && occlusionCulling && light->type != R3D_LIGHT_DIR) {
+            static const Matrix identity = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+            if (r3d_occlusion_is_obb_occluded(&light->aabb, &identity)) light->state.occludedFrames++;
+            else light->state.occludedFrames = 0;
+            visible = (light->state.occludedFrames < R3D_LIGHT_OCCLUSION_FRAMES);
+        }
+        else {
+            light->state.occludedFrames = 0;
+        }
+
+        if (visible) {
+            visibleLights->lights[visibleLights->count++] = index;
+        }
+        else {
+            light->shadowMap.tileSize = 0;
+        }
+    }
+
+    /* --- Keep the most important lights, then give the shadow atlas tiles to them --- */
+
+    apply_light_budget(viewProjs, numViews);
+
+    update_shadow_atlas(viewProjs, numViews);
+
+    schedule_shadow_updates();
+
+    /* --- Fit the cascades of the dir shadows rendered this frame, to the size of their tiles --- */
+
+    Matrix invViewProjs[R3D_MAX_VIEWS];
+    Vector3 viewCorners[8 * R3D_MAX_VIEWS];
+    bool hasViewCorners = false;
+
+    R3D_LIGHT_FOR_EACH_VISIBLE(light)
+    {
+        if (light->type == R3D_LIGHT_OMNI || !r3d_light_has_shadow_tiles(light) || !r3d_light_shadow_should_be_upadted(light, false)) {
+            continue;
+        }
+
+        if (!hasViewCorners) {
+            for (int iView = 0; iView < numViews; iView++) {
+                invViewProjs[iView] = MatrixInvert(viewProjs[iView]);
+                for (int i = 0; i < 8; i++) {
+                    Vector4 ndc = {(i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f};
+                    Vector4 corner = r3d_vector4_transform(ndc, &invViewProjs[iView]);
+                    viewCorners[8 * iView + i] = Vector3Scale((Vector3) {corner.x, corner.y, corner.z}, 1.0f / corner.w);
+                }
+            }
+            hasViewCorners = true;
+        }
+
+        if (light->type == R3D_LIGHT_DIR) {
+            update_light_dir_cascades(light, invViewProjs, numViews, near, far);
+        }
+
+        /* --- Crop the caster culling of the views rendered this frame to the views --- */
+
+        int numViews = r3d_light_get_shadow_views(light);
+        for (int iView = 0; iView < numViews; iView++) {
+            if (r3d_light_is_shadow_view_updated(light, iView)) {
+                update_light_caster_frustum(light, iView, viewCorners, 8 * numViews);
+            }
+        }
+    }
+}
+
+void r3d_light_update_shadow_caches(uint32_t staticRevision, bool hasStaticCasters)
+{
+    bool useCache = hasStaticCasters && R3D_MOD_LIGHT.shadowAtlasFbo != 0;
+
+    if (useCache && R3D_MOD_LIGHT.shadowCacheFbo == 0) {
+        useCache = create_shadow_cache();
+    }
+
+    R3D_LIGHT_FOR_EACH_VISIBLE(light)
+    {
+        r3d_light_shadow_map_t* map = &light->shadowMap;
+        map->cacheRebuildMask = 0;
+
+        if (!useCache || !r3d_light_has_shadow_tiles(light)) {
+            map->cacheMask = 0;
+            continue;
+        }
+
+        if (map->cacheRevision != staticRevision) {
+            map->cacheRevision = staticRevision;
+            map->cacheMask = 0;
+        }
+
+        if (!r3d_light_shadow_should_be_upadted(light, false)) {
+            continue;
+        }
+
+        // The views rendered this frame without a valid cache rebuild it first, unless they are moving
+        uint8_t rebuildMask = ~(map->cacheMask | map->movedMask);
+
+        int numViews = r3d_light_get_shadow_views(light);
+        for (int iView = 0; iView < numViews; iView++) {
+            if (r3d_light_is_shadow_view_updated(light, iView) && (rebuildMask & (1 << iView))) {
+                map->cacheRebuildMask |= 1 << iView;
+            }
+        }
+
+        map->cacheMask |= map->cacheRebuildMask;
+    }
+}
+
+void r3d_light_bind_visible(int lightSlot, int shadowSlot)
+{
+    static uniform_light_block_t uBlock;
+
+    int lightCount = 0;
+    int shadowCount = 0;
+
+    float invAtlasSize = 1.0f / R3D_MOD_LIGHT.shadowAtlasSize;
+
+    R3D_LIGHT_FOR_EACH_VISIBLE(light)
+    {
+        if (lightCount == R3D_SHADER_FORWARD_BLOCK_LIGHTS) {
+            break;
+        }
+
+        light->shadowSlot = -1;
+
+        if (r3d_light_has_shadow_tiles(light) && lightCount < R3D_SHADER_FORWARD_BLOCK_SHADOWS) {
+            light->shadowSlot = shadowCount;
+            uniform_light_shadow_t* uShadow = &uBlock.shadows[shadowCount++];
+            int numViews = r3d_light_get_shadow_views(light);
+            for (int i = 0; i < numViews; i++) {
+                if (light->type != R3D_LIGHT_OMNI) {
+                    uShadow->matVP[i] = r3d_matrix_transpose(&light->matVP[i]);
+                }
+                r3d_rect_t tile = r3d_light_get_shadow_tile(light, i);
+                uShadow->tiles[i] = (Vector4) {
+                    tile.x * invAtlasSize, tile.y * invAtlasSize,
+                    tile.w * invAtlasSize, tile.h * invAtlasSize
+                };
+            }
+            uShadow->near = light->near;
+            uShadow->far = light->far;
+            uShadow->softness = light->shadowSoftness;
+            uShadow->texelSize = 1.0f / light->shadowMap.tileSize;
+            uShadow->depthBias = light->shadowDepthBias;
+            uShadow->slopeBias = light->shadowSlopeBias;
+            uShadow->cascades = light->shadowCascades;
+            uShadow->samples = SHADOW_QUALITY_SAMPLES[light->shadowQuality];
+        }
+
+        uniform_light_t* uLight = &uBlock.lights[lightCount++];
+        uLight->color = light->color;
+        uLight->specular = light->specular;
+        uLight->position = light->position;
+        uLight->energy = light->energy * light->fade;
+        uLight->direction = light->direction;
+        uLight->range = light->range;
+        uLight->attenuation = light->attenuation;
+        uLight->innerCutOff = light->innerCutOff;
+        uLight->outerCutOff = light->outerCutOff;
+        uLight->type = light->type;
+    }
+
+    R3D_MOD_LIGHT.blockLightCount = lightCount;
+    R3D_MOD_LIGHT.blockShadowCount = shadowCount;
+
+    GLuint buffer = R3D_MOD_LIGHT.uniformBuffer;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    if (lightCount > 0) {
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(uniform_light_block_t, lights), lightCount * sizeof(uniform_light_t), uBlock.lights);
+    }
+    if (shadowCount > 0) {
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(uniform_light_block_t, shadows), shadowCount * sizeof(uniform_light_shadow_t), uBlock.shadows);
+    }
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, lightSlot, buffer, offsetof(uniform_light_block_t, lights), sizeof(uBlock.lights));
+    glBindBufferRange(GL_UNIFORM_BUFFER, shadowSlot, buffer, offsetof(uniform_light_block_t, shadows), sizeof(uBlock.shadows));
+}
+
+uint32_t r3d_light_get_shadow_mask(Vector3 center, Vector3 extent)
+{
+    int shadowCount = R3D_MOD_LIGHT.blockShadowCount;
+    if (shadowCount == 0) {
+        return 0;
+    }
+
+    BoundingBox box = {Vector3Subtract(center, extent), Vector3Add(center, extent)};
+    uint32_t mask = 0;
+
+    int min[3], max[3];
+    if (!grid_get_cells(&box, min, max)) {
+        const r3d_light_array_t* visibleLights = &R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE];
+        for (int i = 0; i < shadowCount; i++) {
+            const r3d_light_t* light = &R3D_MOD_LIGHT.lights[visibleLights->lights[i]];
+            if (light->shadowSlot >= 0 && (light->type == R3D_LIGHT_DIR || CheckCollisionBoxes(light->aabb, box))) {
+                mask |= 1u << light->shadowSlot;
+            }
+        }
+        return mask;
+    }
+
+    mask = grid_collect_shadows(GRID_LARGE_BUCKET, &box, mask);
+
+    for (int z = min[2]; z <= max[2]; z++) {
+        for (int y = min[1]; y <= max[1]; y++) {
+            for (int x = min[0]; x <= max[0]; x++) {
+                mask = grid_collect_shadows(grid_hash(x, y, z), &box, mask);
+            }
+        }
+    }
+
+    return mask;
+}
+
+void r3d_light_build_clusters(const Matrix* view, const Matrix* viewProj, float near, float far)
+{
+    static uint32_t ranges[CLUSTER_COUNT][2];
+    static int bounds[R3D_SHADER_FORWARD_BLOCK_LIGHTS][6];
+
+    /* --- Exponential depth slices, so that the clusters keep about the same shape along the view --- */
+
+    Vector2 slice;
+    slice.x = R3D_SHADER_FORWARD_CLUSTER_Z / logf(far / near);
+    slice.y = -logf(near) * slice.x;
+
+    R3D_MOD_LIGHT.clusterSlice = slice;
+
+    /* --- Compute the clusters covered by each light and count the lights per cluster --- */
+
+    // The shadowed lights at the start of the block are sent with the draw calls
+    int first = R3D_MOD_LIGHT.blockShadowCount;
+    int count = 0;
+
+    for (int i = 0; i < CLUSTER_COUNT; i++) {
+        ranges[i][1] = 0;
+    }
+
+    R3D_LIGHT_FOR_EACH_VISIBLE(light)
+    {
+        if (count == R3D_SHADER_FORWARD_BLOCK_LIGHTS) {
+            break;
+        }
+
+        int* b = bounds[count];
+        if (count++ < first) {
+            continue;
+        }
+
+        get_light_clusters(light, view, viewProj, slice, &b[0], &b[3]);
+
+        for (int z = b[2]; z <= b[5]; z++) {
+            for (int y = b[1]; y <= b[4]; y++) {
+                for (int x = b[0]; x <= b[3]; x++) {
+                    ranges[(z * R3D_SHADER_FORWARD_CLUSTER_Y + y) * R3D_SHADER_FORWARD_CLUSTER_X + x][1]++;
+                }
+            }
+        }
+    }
+
+    /* --- Compute the offset of each cluster then fill the light indices --- */
+
+    uint32_t total = 0;
+    for (int i = 0; i < CLUSTER_COUNT; i++) {
+        ranges[i][0] = total;
+        total += ranges[i][1];
+        ranges[i][1] = 0;
+    }
+
+    uint8_t* indices = R3D_MOD_LIGHT.clusterIndices;
+
+    for (int i = first; i < count; i++) {
+        const int* b = bounds[i];
+        for (int z = b[2]; z <= b[5]; z++) {
+            for (int y = b[1]; y <= b[4]; y++) {
+                for (int x = b[0]; x <= b[3]; x++) {
+                    uint32_t* range = ranges[(z * R3D_SHADER_FORWARD_CLUSTER_Y + y) * R3D_SHADER_FORWARD_CLUSTER_X + x];
+                    indices[range[0] + range[1]++] = (uint8_t)i;
+                }
+            }
+        }
+    }
+
+    /* --- Upload the clusters --- */
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterRangeBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(ranges), ranges, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_LIGHT.clusterIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (total > 0) ? total : 1, indices, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
 bool r3d_light_shadow_should_be_upadted(r3d_light_t* light, bool willBeUpdated)
 {
+    if (light->state.shadowDeferred) {
+        return false;
+    }
+
     bool shadowShouldBeUpdated = light->state.shadowShouldBeUpdated;
 
-    if (willBeUpdated) {
+    // The omni faces left by the budget keep the update pending
+    if (willBeUpdated && light->state.pendingViews == 0) {
         switch (light->state.shadowUpdate) {
         case R3D_SHADOW_UPDATE_MANUAL:
             light->state.shadowShouldBeUpdated = false;
@@ -10,12 +10,30 @@
 #define R3D_MODULE_LIGHT_H
 
 #include <r3d/r3d_lighting.h>
+#include <r3d/r3d_draw.h>
 #include <raylib.h>
+#include <stdint.h>
 #include <glad.h>
 
 #include "../details/r3d_frustum.h"
 #include "../details/r3d_math.h"
 
+// ========================================
+// MODULE CONSTANTS
+// ========================================
+
+#define R3D_LIGHT_SHADOW_ATLAS_SIZE     8192    //< Reduced to the max texture size if needed
+#define R3D_LIGHT_SHADOW_ATLAS_LEVELS   7       //< Depth of the atlas quadtree, the smallest tiles are 1/64 of the atlas
+#define R3D_LIGHT_SHADOW_ATLAS_NODES    (((1 << (2 * R3D_LIGHT_SHADOW_ATLAS_LEVELS)) - 1) / 3)
+
+#define R3D_LIGHT_SHADOW_CASCADES       4       //< Maximum number of cascades of dir lights, see 'SHADOW_CASCADES' in the shaders
+
+#define R3D_LIGHT_GRID_CELL_SIZE        16.0f   //< Edge of the cells of the light grid, in world units
+#define R3D_LIGHT_GRID_BUCKETS          1024    //< Number of hashed cells of the light grid, must be a power of two
+#define R3D_LIGHT_GRID_MAX_CELLS        64      //< Volumes covering more cells are kept in a single bucket visited by every query
+
+#define R3D_LIGHT_OCCLUSION_FRAMES      4       //< Consecutive frames a light volume must be occluded before the light is culled
+
 // ========================================
 // HELPER MACROS
 // ========================================
@@ -32,22 +50,64 @@ typedef struct {
     R3D_ShadowUpdateMode shadowUpdate;
     float shadowFrequencySec;
     float shadowTimerSec;
+    int cascadeInterval;                    //< Number of shadow updates between two renders of the far cascades
+    int cascadeCounter;                     //< Shadow updates since the light was created, staggers the far cascades
+    uint8_t viewMask;                       //< Views rendered this frame, the cascades of dir lights or the faces of omni lights
+    uint8_t pendingViews;                   //< Faces of the current omni shadow update left to the next frames by the budget
+    int shadowWaitFrames;                   //< Frames the current shadow update has been postponed by the budget
+    int occludedFrames;                     //< Consecutive frames the light volume was hidden by the depth pyramid
+    bool cascadesShouldBeUpdated;           //< Renders all the cascades with the next shadow update
+    bool shadowIsEmpty;                     //< The tiles have not been rendered yet, they are rendered whatever the budget
+    bool shadowDeferred;                    //< The shadow update is postponed to a later frame by the budget
     bool shadowShouldBeUpdated;
     bool matrixShouldBeUpdated;
 } r3d_light_state_t;
 
 typedef struct {
-    GLuint fbo, tex;
-    int resolution;
+    int resolution;                         //< Requested size of the tiles, the allocated ones can be smaller
+    int tileSize;                           //< Size of the tiles allocated this frame, zero without tiles
+    int tiles[6];                           //< Quadtree nodes of the tiles in the shadow atlas, one per shadow view
+    float coverage;                         //< Fraction of the screen covered by the light, used to size and sort the tiles
+    uint32_t cacheRevision;                 //< Revision of the static scene objects held by the cache tiles
+    uint8_t cacheMask;                      //< Views whose static casters are in the cache once this frame is rendered
+    uint8_t cacheRebuildMask;               //< Views whose static casters are rendered in the cache this frame
+    uint8_t movedMask;                      //< Views whose projection changed this frame, not cached until they are still
 } r3d_light_shadow_map_t;
 
+/*
+ * Entry of a light in a cell of the light grid, a light has one entry per cell its volume covers.
+ */
 typedef struct {
-    Matrix matVP[6];                        //< View/projection matrix of the light (only [0] for dir/spot, 6 for omni lights)
-    r3d_frustum_t frustum[6];               //< Frustum of the light (only [0] for dir/spot, 6 for omni lights) (calculated only if shadows are enabled)
+    int light;                              //< Index of the light
+    int bucket;                             //< Bucket holding the entry
+    int next;                               //< Next entry of the bucket, or of the free list, -1 at the end
+    int nextOfLight;                        //< Next entry of the same light, -1 at the end
+} r3d_light_grid_entry_t;
+
+/*
+ * Uniform grid of the light volumes, hashed into a fixed number of buckets.
+ * A light is binned again only when its volume changes, see 'r3d_light_get_shadow_mask()'.
+ */
+typedef struct {
+    int buckets[R3D_LIGHT_GRID_BUCKETS + 1];    //< First entry of each bucket, the last one holds the volumes too large to be binned
+    r3d_light_grid_entry_t* entries;
+    int capacity;
+    int count;
+    int freeEntry;                          //< First entry of the free list, -1 if empty
+} r3d_light_grid_t;
+
+typedef struct {
+    Matrix matVP[6];                        //< View/projection matrix of the light (one per cascade for dir, only [0] for spot, 6 for omni lights)
+    r3d_frustum_t frustum[6];               //< Frustum of the light (one per cascade for dir, only [0] for spot, 6 for omni lights) (calculated only if shadows are enabled)
+    r3d_frustum_t volumeFrustum;            //< Frustum of the AABB, culls the casters of all the faces at once (omni lights with shadows)
+    r3d_frustum_t casterFrustum[R3D_LIGHT_SHADOW_CASCADES]; //< Frustum of the light cropped to the receivers in view, culls the casters (spot/dir)
     BoundingBox aabb;                       //< AABB in world space of the light volume
     r3d_light_state_t state;                //< Light update config
-    r3d_light_shadow_map_t shadowMap;       //< 2D or Cube shadow map
-    GLuint shadowCubemap;                   //< Cube shadow map used for omni-directional shadow projection
+    r3d_light_shadow_map_t shadowMap;       //< Tiles of the light in the shadow atlas
+    int gridEntry;                          //< First entry of the light in the light grid, -1 if not binned
+    float importance;                       //< Energy times the screen coverage of the light this frame, see 'lightBudget'
+    float fade;                             //< Scale of the energy this frame, the least important lights kept by the budget fade out
+    int shadowSlot;                         //< Index of the light in the shadow block this frame, -1 without
     Vector3 color;                          //< Light color modulation tint
     Vector3 position;                       //< Light position (spot/omni)
     Vector3 direction;                      //< Light direction (spot/dir)
@@ -61,9 +121,12 @@ typedef struct {
     float innerCutOff;                      //< Spot light inner cutoff angle
     float outerCutOff;                      //< Spot light outer cutoff angle
     float shadowSoftness;                   //< Softness factor to simulate a penumbra
-    float shadowTexelSize;                  //< Size of a texel in the 2D shadow map
+    float shadowTexelSize;                  //< Size of a texel at the requested shadow map resolution
     float shadowDepthBias;                  //< Constant depth bias applied to shadow mapping to reduce shadow acne
     float shadowSlopeBias;                  //< Additional bias scaled by surface slope to reduce artifacts on angled geometry
+    float shadowCascadeSplit;               //< Blend between uniform (0) and logarithmic (1) cascade splits (dir)
+    int shadowCascades;                     //< Number of shadow cascades (dir)
+    R3D_ShadowQuality shadowQuality;        //< Number of filtered taps of the shadow per pixel
     R3D_LightType type;                     //< Light type (dir/spot/omni)
     bool enabled;                           //< Indicates whether the light is on
     bool shadow;                            //< Indicates whether the light generates shadows
@@ -89,6 +152,26 @@ extern struct r3d_light {
     r3d_light_array_t arrays[R3D_LIGHT_ARRAY_COUNT];
     r3d_light_t* lights;
     int capacityLights;
+    void* arrayBlock;               //< Single allocation holding 'lights' and the arrays above
+    GLuint uniformBuffer;           //< Visible lights uniform buffer, see 'r3d_light_bind_visible()'
+    int blockLightCount;            //< Number of lights in the uniform buffer
+    int blockShadowCount;           //< Number of shadowed lights at the start of the uniform buffer
+    GLuint clusterRangeBuffer;      //< Offset and count in the index buffer of each cluster
+    GLuint clusterIndexBuffer;      //< Light indices in the uniform buffer of each cluster
+    GLuint clusterRangeTexture;     //< Buffer texture of 'clusterRangeBuffer'
+    GLuint clusterIndexTexture;     //< Buffer texture of 'clusterIndexBuffer'
+    uint8_t* clusterIndices;        //< CPU copy of the cluster light indices
+    Vector2 clusterSlice;           //< Scale and bias applied to log(depth) to get the cluster slice
+    GLuint shadowAtlasFbo;          //< Framebuffer of the shadow atlas, created with the first shadow
+    GLuint shadowAtlasTex;          //< Depth texture shared by the shadows of all the lights
+    int shadowAtlasSize;            //< Width and height of the shadow atlas
+    int shadowUpdateBudget;         //< Shadow views rendered per frame at most, zero without limit
+    int lightBudget;                //< Visible lights kept per frame at most, by importance, zero without limit
+    float lightThreshold;           //< Importance below which the visible lights are skipped, zero to keep them all
+    GLuint shadowCacheFbo;          //< Framebuffer of the static shadow cache, created with the first static casters
+    GLuint shadowCacheTex;          //< Depth texture with the layout of the atlas, holding only the static casters
+    uint8_t shadowAtlasNodes[R3D_LIGHT_SHADOW_ATLAS_NODES]; //< State of each quadtree node, rebuilt every frame
+    r3d_light_grid_t grid;          //< Volumes of all the lights, binned when they change
 } R3D_MOD_LIGHT;
 
 // ========================================
@@ -150,19 +233,74 @@ void r3d_light_update_matrix(r3d_light_t* light);
 
 /*
  * Enable shadows for a light and configure shadow parameters.
- * Creates or resizes the shadow map if necessary.
+ * Creates the shadow atlas with the first shadow, the resolution is the largest tile allowed.
  */
 void r3d_light_enable_shadows(r3d_light_t* light, int resolution);
 
+/*
+ * Set the number of shadow cascades of a dir light, clamped to 'R3D_LIGHT_SHADOW_CASCADES'.
+ * The tiles of the light are reallocated and all its cascades rendered with the next update.
+ */
+void r3d_light_set_shadow_cascades(r3d_light_t* light, int count);
+
 /*
  * Update all lights, recompute state, and collect visible lights.
  * Performs frustum culling and shadow updates when needed.
+ * The tiles of the shadow atlas are then given to the visible shadowed lights covering the most
+ * of the screen, a light keeping its tiles and their size keeps its shadow until its next update.
+ * The lights with tiles come first in the visible array, up to 'R3D_SHADER_FORWARD_BLOCK_SHADOWS'.
+ * With a light budget or threshold, only the most important visible lights are kept, the last ones kept
+ * fade out as their importance approaches the one of the first light left out, see 'fade'.
+ * The cascades of the dir lights are fitted to the view between 'near' and the light range.
+ * The pending shadow updates are then scheduled within 'shadowUpdateBudget', by coverage and waiting time,
+ * the postponed ones are kept for the next frames and the faces of omni lights can be spread over several frames.
+ * The casters of the spot and dir shadows rendered this frame are culled with the light frustum
+ * cropped to the projection of the view frustum, see 'casterFrustum'.
+ * With several views the shadows are rendered once for all of them: the lights visible in any view
+ * are collected, the coverage is the largest of the views, and the cascades and crops enclose every view.
+ * With 'occlusionCulling', the spot and omni lights whose volume is hidden by the depth pyramid of the
+ * occlusion module for `R3D_LIGHT_OCCLUSION_FRAMES` frames in a row are culled, shadows included.
+ */
+void r3d_light_update_and_cull(const r3d_frustum_t* viewFrustums, const Matrix* viewProjs, int numViews, float near, float far, bool occlusionCulling);
+
+/*
+ * Update the static caches of the visible shadows, must be called after 'r3d_light_update_and_cull()'.
+ * Each tile of the atlas has a tile at the same place in the cache, holding the depth of the static casters only.
+ * A cache is dropped when its tiles or its projections change, or when the revision of the static casters differs.
+ * The views whose projection changes this frame are rendered without cache, to not rebuild it every frame.
+ * The cache is not used, nor created, while there are no static casters.
  */
-void r3d_light_update_and_cull(const r3d_frustum_t* viewFrustum, Vector3 viewPosition);
+void r3d_light_update_shadow_caches(uint32_t staticRevision, bool hasStaticCasters);
 
 /*
- * Indicate whether the shadow map should be rendered.
- * The internal update state can be reset after the query.
+ * Get the rectangle in texels of the tile of a shadow view of the light in the shadow atlas.
+ */
+r3d_rect_t r3d_light_get_shadow_tile(const r3d_light_t* light, int view);
+
+/*
+ * Upload the visible lights to the light uniform buffer and bind it to the given slots.
+ * A light is stored at its index in the visible array, up to 'R3D_SHADER_FORWARD_BLOCK_LIGHTS'.
+ * The lights with shadow tiles come first, their shadows are stored at the same index in the shadow block.
+ * Must be called after the shadow passes so that the light matrices are up to date.
+ */
+void r3d_light_bind_visible(int lightSlot, int shadowSlot);
+
+/*
+ * Returns one bit per light of the shadow block whose volume touches the given box, dir lights always do.
+ * The candidates are taken from the cells of the light grid covered by the box, large or unbounded
+ * boxes test every shadowed light instead. Must be called after 'r3d_light_bind_visible()'.
+ */
+uint32_t r3d_light_get_shadow_mask(Vector3 center, Vector3 extent);
+
+/*
+ * Assign the lights of the uniform buffer without shadow parameters to the clusters of the view frustum,
+ * then upload the cluster buffers. Must be called after 'r3d_light_bind_visible()'.
+ */
+void r3d_light_build_clusters(const Matrix* view, const Matrix* viewProj, float near, float far);
+
+/*
+ * Indicate whether the shadow map should be rendered this frame, false if the budget postponed it.
+ * The internal update state can be reset after the query, once all the views of the update are rendered.
  */
 bool r3d_light_shadow_should_be_upadted(r3d_light_t* light, bool willBeUpdated);
 
@@ -175,4 +313,48 @@ static inline bool r3d_light_has_visible(void)
     return R3D_MOD_LIGHT.arrays[R3D_LIGHT_ARRAY_VISIBLE].count > 0;
 }
 
+static inline bool r3d_light_has_shadow_tiles(const r3d_light_t* light)
+{
+    return light->shadowMap.tileSize > 0;
+}
+
+/*
+ * Number of views rendered for the shadow: the cube faces of omni lights, the cascades of dir lights.
+ */
+static inline int r3d_light_get_shadow_views(const r3d_light_t* light)
+{
+    switch (light->type) {
+    case R3D_LIGHT_DIR: return light->shadowCascades;
+    case R3D_LIGHT_OMNI: return 6;
+    default: break;
+    }
+    return 1;
+}
+
+/*
+ * Indicate whether a shadow view is rendered with the current shadow update.
+ * The far cascades of dir lights can be rendered less often than the near one,
+ * and the faces of omni lights can be spread over several frames by the budget.
+ */
+static inline bool r3d_light_is_shadow_view_updated(const r3d_light_t* light, int view)
+{
+    return light->state.viewMask & (1 << view);
+}
+
+/*
+ * Indicate whether the static casters of a shadow view are copied from the cache when it is rendered.
+ */
+static inline bool r3d_light_has_shadow_cache(const r3d_light_t* light, int view)
+{
+    return light->shadowMap.cacheMask & (1 << view);
+}
+
+/*
+ * Indicate whether the static casters of a shadow view are rendered in the cache this frame.
+ */
+static inline bool r3d_light_rebuilds_shadow_cache(const r3d_light_t* light, int view)
+{
+    return light->shadowMap.cacheRebuildMask & (1 << view);
+}
+
 #endif // R3D_MODULE_LIGHT_H
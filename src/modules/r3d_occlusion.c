@@ -0,0 +1,473 @@
+/* r3d_occlusion.c -- Internal R3D occlusion culling module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_occlusion.h"
+
+#include <raymath.h>
+#include <string.h>
+#include <float.h>
+#include <glad.h>
+
+#include "../details/r3d_math.h"
+#include "./r3d_primitive.h"
+#include "./r3d_shader.h"
+#include "./r3d_target.h"
+#include "./r3d_state.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_occlusion R3D_MOD_OCCLUSION;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static inline int level_size(int size, int level)
+{
+    size >>= level;
+    return (size > 0) ? size : 1;
+}
+
+static void release_readback(r3d_occlusion_readback_t* readback)
+{
+    if (readback->fence != NULL) {
+        glDeleteSync((GLsync)readback->fence);
+        readback->fence = NULL;
+    }
+    readback->pending = false;
+}
+
+static void release_pyramid_texture(void)
+{
+    if (R3D_MOD_OCCLUSION.texture != 0) {
+        glDeleteTextures(1, &R3D_MOD_OCCLUSION.texture);
+        R3D_MOD_OCCLUSION.texture = 0;
+        // The pyramid is resized during the frame, its name may be reused while still cached as bound
+        r3d_state_invalidate();
+    }
+
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++) {
+        release_readback(&R3D_MOD_OCCLUSION.readback[i]);
+    }
+
+    R3D_MOD_OCCLUSION.width = 0;
+    R3D_MOD_OCCLUSION.height = 0;
+    R3D_MOD_OCCLUSION.numLevels = 0;
+}
+
+static void ensure_pyramid_texture(int resW, int resH)
+{
+    int w = (resW > 1) ? resW / 2 : 1;
+    int h = (resH > 1) ? resH / 2 : 1;
+
+    if (R3D_MOD_OCCLUSION.texture != 0 && R3D_MOD_OCCLUSION.width == w && R3D_MOD_OCCLUSION.height == h) {
+        return;
+    }
+
+    release_pyramid_texture();
+
+    int numLevels = 1;
+    while (numLevels < R3D_OCCLUSION_MAX_LEVELS && (level_size(w, numLevels - 1) > 1 || level_size(h, numLevels - 1) > 1)) {
+        numLevels++;
+    }
+
+    /* --- Allocate every level of the pyramid --- */
+
+    glGenTextures(1, &R3D_MOD_OCCLUSION.texture);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_OCCLUSION.texture);
+
+    for (int i = 0; i < numLevels; i++) {
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RG32F, level_size(w, i), level_size(h, i), 0, GL_RG, GL_FLOAT, NULL);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
+
+    /* --- Select the level read back on the CPU --- */
+
+    int readLevel = 0;
+    while (readLevel < numLevels - 1 && level_size(w, readLevel) > R3D_OCCLUSION_READBACK_SIZE) {
+        readLevel++;
+    }
+
+    /* --- Resize the pixel buffers to the new level size --- */
+
+    size_t readSize = (size_t)level_size(w, readLevel) * level_size(h, readLevel) * sizeof(float);
+
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, R3D_MOD_OCCLUSION.readback[i].pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, readSize, NULL, GL_STREAM_READ);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    R3D_MOD_OCCLUSION.width = w;
+    R3D_MOD_OCCLUSION.height = h;
+    R3D_MOD_OCCLUSION.numLevels = numLevels;
+    R3D_MOD_OCCLUSION.readLevel = readLevel;
+}
+
+static bool resize_cpu_level(int level, int w, int h)
+{
+    r3d_occlusion_pyramid_t* pyramid = &R3D_MOD_OCCLUSION.pyramid;
+
+    if (pyramid->levels[level] != NULL && pyramid->width[level] == w && pyramid->height[level] == h) {
+        return true;
+    }
+
+    float* data = RL_REALLOC(pyramid->levels[level], (size_t)w * h * sizeof(float));
+    if (data == NULL) return false;
+
+    pyramid->levels[level] = data;
+    pyramid->width[level] = w;
+    pyramid->height[level] = h;
+
+    return true;
+}
+
+static void reduce_cpu_level(int level)
+{
+    r3d_occlusion_pyramid_t* pyramid = &R3D_MOD_OCCLUSION.pyramid;
+
+    const float* src = pyramid->levels[level - 1];
+    int srcW = pyramid->width[level - 1];
+    int srcH = pyramid->height[level - 1];
+
+    float* dst = pyramid->levels[level];
+    int dstW = pyramid->width[level];
+    int dstH = pyramid->height[level];
+
+    /*
+     * Same reduction as the GPU one, the last column/row
+     * also covers the texel left over by odd sizes.
+     */
+
+    for (int y = 0; y < dstH; y++) {
+        int y0 = 2 * y;
+        int y1 = (y == dstH - 1) ? srcH - 1 : y0 + 1;
+        if (y1 >= srcH) y1 = srcH - 1;
+
+        for (int x = 0; x < dstW; x++) {
+            int x0 = 2 * x;
+            int x1 = (x == dstW - 1) ? srcW - 1 : x0 + 1;
+            if (x1 >= srcW) x1 = srcW - 1;
+
+            float depth = 0.0f;
+            for (int sy = y0; sy <= y1; sy++) {
+                for (int sx = x0; sx <= x1; sx++) {
+                    float value = src[sy * srcW + sx];
+                    if (value > depth) depth = value;
+                }
+            }
+
+            dst[y * dstW + x] = depth;
+        }
+    }
+}
+
+static void consume_readback(r3d_occlusion_readback_t* readback)
+{
+    r3d_occlusion_pyramid_t* pyramid = &R3D_MOD_OCCLUSION.pyramid;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+
+    size_t size = (size_t)readback->width * readback->height * sizeof(float);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+    if (data == NULL || !resize_cpu_level(0, readback->width, readback->height)) {
+        if (data != NULL) glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return;
+    }
+
+    memcpy(pyramid->levels[0], data, size);
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    /* --- Rebuild the coarser levels on the CPU --- */
+
+    int numLevels = 1;
+
+    while (numLevels < R3D_OCCLUSION_MAX_LEVELS) {
+        int w = pyramid->width[numLevels - 1];
+        int h = pyramid->height[numLevels - 1];
+        if (w == 1 && h == 1) break;
+
+        w = (w > 1) ? w / 2 : 1;
+        h = (h > 1) ? h / 2 : 1;
+
+        if (!resize_cpu_level(numLevels, w, h)) break;
+        reduce_cpu_level(numLevels++);
+    }
+
+    pyramid->numLevels = numLevels;
+    pyramid->viewProj = readback->viewProj;
+    pyramid->uvScale = readback->uvScale;
+}
+
+// Tests a transformed box against the CPU pyramid, which must have been received
+static bool is_obb_occluded(const r3d_occlusion_pyramid_t* pyramid, const BoundingBox* aabb, const Matrix* transform)
+{
+    /* --- Reproject the box with the view projection of the pyramid --- */
+
+    Matrix mvp = r3d_matrix_multiply(transform, &pyramid->viewProj);
+
+    float minX = FLT_MAX, minY = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float minDepth = FLT_MAX;
+
+    for (int i = 0; i < 8; i++)
+    {
+        Vector4 corner = {
+            (i & 1) ? aabb->max.x : aabb->min.x,
+            (i & 2) ? aabb->max.y : aabb->min.y,
+            (i & 4) ? aabb->max.z : aabb->min.z,
+            1.0f
+        };
+
+        Vector4 clip = r3d_vector4_transform(corner, &mvp);
+
+        // The box crosses the near plane, its screen bounds are unknown
+        if (clip.w <= 1e-6f) return false;
+
+        float invW = 1.0f / clip.w;
+        float x = clip.x * invW;
+        float y = clip.y * invW;
+        float z = clip.z * invW * 0.5f + 0.5f;
+
+        if (x < minX) minX = x;
+        if (y < minY) minY = y;
+        if (x > maxX) maxX = x;
+        if (y > maxY) maxY = y;
+        if (z < minDepth) minDepth = z;
+    }
+
+    if (minDepth <= 0.0f) return false;
+
+    /* --- Compute the covered texels of the first level --- */
+
+    float baseW = pyramid->width[0] * pyramid->uvScale.x;
+    float baseH = pyramid->height[0] * pyramid->uvScale.y;
+
+    minX = Clamp(minX * 0.5f + 0.5f, 0.0f, 1.0f) * baseW;
+    maxX = Clamp(maxX * 0.5f + 0.5f, 0.0f, 1.0f) * baseW;
+    minY = Clamp(minY * 0.5f + 0.5f, 0.0f, 1.0f) * baseH;
+    maxY = Clamp(maxY * 0.5f + 0.5f, 0.0f, 1.0f) * baseH;
+
+    int x0 = (int)minX, x1 = (int)maxX;
+    int y0 = (int)minY, y1 = (int)maxY;
+
+    if (x1 >= pyramid->width[0]) x1 = pyramid->width[0] - 1;
+    if (y1 >= pyramid->height[0]) y1 = pyramid->height[0] - 1;
+
+    /* --- Select the level where the box covers at most two texels per axis --- */
+
+    int level = 0;
+    while (level < pyramid->numLevels - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        level++;
+    }
+
+    int w = pyramid->width[level];
+    int h = pyramid->height[level];
+    const float* depth = pyramid->levels[level];
+
+    int lx0 = x0 >> level, lx1 = x1 >> level;
+    int ly0 = y0 >> level, ly1 = y1 >> level;
+
+    // The last column/row of a level also covers the odd texels of the previous one
+    if (lx0 >= w) lx0 = w - 1;
+    if (lx1 >= w) lx1 = w - 1;
+    if (ly0 >= h) ly0 = h - 1;
+    if (ly1 >= h) ly1 = h - 1;
+
+    float maxDepth = 0.0f;
+    for (int y = ly0; y <= ly1; y++) {
+        for (int x = lx0; x <= lx1; x++) {
+            float value = depth[y * w + x];
+            if (value > maxDepth) maxDepth = value;
+        }
+    }
+
+    return (minDepth > maxDepth);
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_occlusion_init(void)
+{
+    memset(&R3D_MOD_OCCLUSION, 0, sizeof(R3D_MOD_OCCLUSION));
+
+    glGenFramebuffers(1, &R3D_MOD_OCCLUSION.fbo);
+
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++) {
+        glGenBuffers(1, &R3D_MOD_OCCLUSION.readback[i].pbo);
+    }
+
+    return true;
+}
+
+void r3d_occlusion_quit(void)
+{
+    release_pyramid_texture();
+
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++) {
+        glDeleteBuffers(1, &R3D_MOD_OCCLUSION.readback[i].pbo);
+    }
+
+    for (int i = 0; i < R3D_OCCLUSION_MAX_LEVELS; i++) {
+        RL_FREE(R3D_MOD_OCCLUSION.pyramid.levels[i]);
+    }
+
+    glDeleteFramebuffers(1, &R3D_MOD_OCCLUSION.fbo);
+}
+
+void r3d_occlusion_reset(void)
+{
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++) {
+        release_readback(&R3D_MOD_OCCLUSION.readback[i]);
+    }
+
+    R3D_MOD_OCCLUSION.pyramid.numLevels = 0;
+    R3D_MOD_OCCLUSION.testedGroups = 0;
+    R3D_MOD_OCCLUSION.culledGroups = 0;
+}
+
+void r3d_occlusion_update(void)
+{
+    R3D_MOD_OCCLUSION.testedGroups = 0;
+    R3D_MOD_OCCLUSION.culledGroups = 0;
+
+    /* --- Visit the readbacks from the oldest to the most recent --- */
+
+    for (int i = 0; i < R3D_OCCLUSION_READBACK_COUNT; i++)
+    {
+        int index = (R3D_MOD_OCCLUSION.readIndex + i) % R3D_OCCLUSION_READBACK_COUNT;
+        r3d_occlusion_readback_t* readback = &R3D_MOD_OCCLUSION.readback[index];
+        if (!readback->pending) continue;
+
+        GLenum status = glClientWaitSync((GLsync)readback->fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            continue;
+        }
+
+        consume_readback(readback);
+        release_readback(readback);
+    }
+}
+
+void r3d_occlusion_build_pyramid(void)
+{
+    // The pyramid covers the whole targets, the area outside of the rendered one is cleared to the far plane
+    ensure_pyramid_texture(R3D_TARGET_ALLOC_WIDTH, R3D_TARGET_ALLOC_HEIGHT);
+
+    /* --- Setup the pyramid framebuffer --- */
+
+    /*
+     * NOTE: Our own framebuffer is bound here, the cache of
+     *       the target module must be reset for the next bind.
+     */
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_OCCLUSION.fbo);
+    R3D_MOD_TARGET.currentFbo = -1;
+
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
+
+    R3D_SHADER_USE(prepare.hizDown);
+
+    /* --- Reduce the depth buffer, then each level into the next one --- */
+
+    GLuint pyramidId = R3D_MOD_OCCLUSION.texture;
+
+    for (int level = 0; level < R3D_MOD_OCCLUSION.numLevels; level++)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pyramidId, level);
+        glViewport(0, 0, level_size(R3D_MOD_OCCLUSION.width, level), level_size(R3D_MOD_OCCLUSION.height, level));
+
+        R3D_SHADER_SET_INT(prepare.hizDown, uFirstLevel, level == 0);
+
+        if (level == 0) {
+            R3D_SHADER_BIND_SAMPLER_2D(prepare.hizDown, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+        }
+        else {
+            // Restricts the sampled levels to the source, avoiding any feedback loop
+            R3D_SHADER_BIND_SAMPLER_2D(prepare.hizDown, uTexDepth, pyramidId);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        }
+
+        R3D_PRIMITIVE_DRAW_SCREEN();
+    }
+
+    R3D_SHADER_BIND_SAMPLER_2D(prepare.hizDown, uTexDepth, pyramidId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, R3D_MOD_OCCLUSION.numLevels - 1);
+    R3D_SHADER_UNBIND_SAMPLER_2D(prepare.hizDown, uTexDepth);
+}
+
+void r3d_occlusion_start_readback(const Matrix* viewProj)
+{
+    if (R3D_MOD_OCCLUSION.texture == 0) {
+        return;
+    }
+
+    GLuint pyramidId = R3D_MOD_OCCLUSION.texture;
+
+    r3d_occlusion_readback_t* readback = &R3D_MOD_OCCLUSION.readback[R3D_MOD_OCCLUSION.readIndex];
+    R3D_MOD_OCCLUSION.readIndex = (R3D_MOD_OCCLUSION.readIndex + 1) % R3D_OCCLUSION_READBACK_COUNT;
+
+    // A readback never consumed is simply overwritten
+    release_readback(readback);
+
+    readback->width = level_size(R3D_MOD_OCCLUSION.width, R3D_MOD_OCCLUSION.readLevel);
+    readback->height = level_size(R3D_MOD_OCCLUSION.height, R3D_MOD_OCCLUSION.readLevel);
+    readback->viewProj = *viewProj;
+    readback->uvScale = r3d_target_get_uv_scale();
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, pyramidId);
+    glGetTexImage(GL_TEXTURE_2D, R3D_MOD_OCCLUSION.readLevel, GL_RED, GL_FLOAT, NULL);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback->pending = true;
+}
+
+bool r3d_occlusion_is_obb_occluded(const BoundingBox* aabb, const Matrix* transform)
+{
+    const r3d_occlusion_pyramid_t* pyramid = &R3D_MOD_OCCLUSION.pyramid;
+    if (pyramid->numLevels == 0) return false;
+
+    return is_obb_occluded(pyramid, aabb, transform);
+}
+
+bool r3d_occlusion_is_group_occluded(const BoundingBox* aabb, const Matrix* transform)
+{
+    const r3d_occlusion_pyramid_t* pyramid = &R3D_MOD_OCCLUSION.pyramid;
+    if (pyramid->numLevels == 0) return false;
+
+    R3D_MOD_OCCLUSION.testedGroups++;
+
+    bool occluded = is_obb_occluded(pyramid, aabb, transform);
+    if (occluded) R3D_MOD_OCCLUSION.culledGroups++;
+
+    return occluded;
+}
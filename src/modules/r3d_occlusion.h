@@ -0,0 +1,135 @@
+/* r3d_occlusion.h -- Internal R3D occlusion culling module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_OCCLUSION_H
+#define R3D_MODULE_OCCLUSION_H
+
+#include <raylib.h>
+#include <stdint.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_OCCLUSION_MAX_LEVELS        16      //< Maximum number of levels of the depth pyramid
+#define R3D_OCCLUSION_READBACK_SIZE     256     //< Maximum width of the level read back on the CPU
+#define R3D_OCCLUSION_READBACK_COUNT    2       //< Number of readbacks that can be in flight
+
+// ========================================
+// OCCLUSION STRUCTURES
+// ========================================
+
+/*
+ * Asynchronous copy of one level of the depth pyramid.
+ * The view projection is kept to reproject the objects tested against it.
+ */
+typedef struct {
+    uint32_t pbo;                               //< Pixel pack buffer receiving the level
+    void* fence;                                //< Sync object signaled once the copy is done
+    Matrix viewProj;                            //< View projection of the frame that produced the depth
+    Vector2 uvScale;                            //< Fraction of the level covered by the rendered area
+    int width, height;                          //< Size of the level copied
+    bool pending;                               //< True while the copy has not been consumed
+} r3d_occlusion_readback_t;
+
+/*
+ * Max-reduced depth pyramid available on the CPU.
+ * Each level stores the farthest depth covered by its texels.
+ */
+typedef struct {
+    float* levels[R3D_OCCLUSION_MAX_LEVELS];    //< Depth values of each level
+    int width[R3D_OCCLUSION_MAX_LEVELS];        //< Width of each level
+    int height[R3D_OCCLUSION_MAX_LEVELS];       //< Height of each level
+    int numLevels;                              //< Number of levels, zero if no pyramid has been received yet
+    Matrix viewProj;                            //< View projection of the frame that produced the depth
+    Vector2 uvScale;                            //< Fraction of the levels covered by the rendered area
+} r3d_occlusion_pyramid_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the occlusion module.
+ * The GPU pyramid is built from the depth of a frame, a small level is read back
+ * asynchronously and the objects of the following frames are tested against it.
+ */
+extern struct r3d_occlusion {
+
+    uint32_t fbo;                                                   //< Framebuffer used to write the levels of the pyramid
+    uint32_t texture;                                               //< Depth pyramid, RG32F with mipmaps, R: max depth, G: min depth
+    int width, height;                                              //< Size of the first level, half the internal resolution
+    int numLevels;                                                  //< Number of levels of the texture
+    int readLevel;                                                  //< Level of the texture read back on the CPU
+
+    r3d_occlusion_readback_t readback[R3D_OCCLUSION_READBACK_COUNT];  //< Readbacks in flight
+    int readIndex;                                                  //< Readback written by the next build
+
+    r3d_occlusion_pyramid_t pyramid;                                //< Most recent pyramid received on the CPU
+
+    int testedGroups;                                               //< Number of groups tested during the last frame
+    int culledGroups;                                               //< Number of groups culled during the last frame
+
+} R3D_MOD_OCCLUSION;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_occlusion_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_occlusion_quit(void);
+
+/*
+ * Drops the pyramid and all readbacks in flight.
+ * Called when occlusion culling is disabled so that an outdated pyramid is never used again.
+ */
+void r3d_occlusion_reset(void);
+
+/*
+ * Collects the readbacks that have completed and rebuilds the CPU pyramid from the most recent one.
+ * Never waits for the GPU, the previous pyramid is kept if nothing is ready.
+ * Also resets the statistics of the frame.
+ */
+void r3d_occlusion_update(void);
+
+/*
+ * Builds the depth pyramid from `R3D_TARGET_DEPTH`.
+ * The max depth is used by the occlusion culling, the min depth by the screen space reflections.
+ * Binds its own framebuffer, so the FBO cache of the target module is invalidated.
+ */
+void r3d_occlusion_build_pyramid(void);
+
+/*
+ * Starts the readback of the pyramid built during the frame, only its max depth is read.
+ * The view projection must be the one used to render the depth.
+ */
+void r3d_occlusion_start_readback(const Matrix* viewProj);
+
+/*
+ * Returns true if the transformed bounding box is hidden behind the depth of the CPU pyramid.
+ * Objects crossing the near plane of the reprojection, or tested before any pyramid
+ * has been received, are always considered visible.
+ */
+bool r3d_occlusion_is_obb_occluded(const BoundingBox* aabb, const Matrix* transform);
+
+/*
+ * Same test as 'r3d_occlusion_is_obb_occluded()' for a draw group,
+ * counted in the statistics of the frame reported by 'R3D_GetOcclusionStats()'.
+ */
+bool r3d_occlusion_is_group_occluded(const BoundingBox* aabb, const Matrix* transform);
+
+#endif // R3D_MODULE_OCCLUSION_H
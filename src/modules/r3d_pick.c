@@ -0,0 +1,290 @@
+/* r3d_pick.c -- Internal R3D picking module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_pick.h"
+
+#include <raymath.h>
+#include <string.h>
+#include <math.h>
+#include <glad.h>
+
+#include "../details/r3d_math.h"
+#include "./r3d_target.h"
+#include "./r3d_cache.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_pick R3D_MOD_PICK;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static void release_slot(r3d_pick_slot_t* slot)
+{
+    if (slot->fence != NULL) {
+        glDeleteSync((GLsync)slot->fence);
+        slot->fence = NULL;
+    }
+    slot->state = R3D_PICK_FREE;
+}
+
+// Same decoding as 'M_DecodeOctahedral()' in the shaders
+static Vector3 decode_octahedral(float x, float y)
+{
+    x = x * 2.0f - 1.0f;
+    y = y * 2.0f - 1.0f;
+
+    Vector3 normal = {x, y, 1.0f - fabsf(x) - fabsf(y)};
+
+    if (normal.z < 0.0f) {
+        normal.x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        normal.y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return Vector3Normalize(normal);
+}
+
+// Converts the area requested to the rendered pixels, centered on the request if larger than allowed
+static void compute_read_area(r3d_pick_slot_t* slot)
+{
+    Vector2 p0 = r3d_target_output_to_render((Vector2) {slot->area.x, slot->area.y + slot->area.height});
+    Vector2 p1 = r3d_target_output_to_render((Vector2) {slot->area.x + slot->area.width, slot->area.y});
+
+    int x0 = (int)floorf(p0.x), y0 = (int)floorf(p0.y);
+    int x1 = (int)ceilf(p1.x), y1 = (int)ceilf(p1.y);
+
+    // An empty area picks the pixel under its position
+    if (x1 <= x0) x1 = x0 + 1;
+    if (y1 <= y0) y1 = y0 + 1;
+
+    if (x1 - x0 > R3D_PICK_MAX_SIZE) {
+        x0 = (x0 + x1 - R3D_PICK_MAX_SIZE) / 2;
+        x1 = x0 + R3D_PICK_MAX_SIZE;
+    }
+    if (y1 - y0 > R3D_PICK_MAX_SIZE) {
+        y0 = (y0 + y1 - R3D_PICK_MAX_SIZE) / 2;
+        y1 = y0 + R3D_PICK_MAX_SIZE;
+    }
+
+    x0 = (x0 > 0) ? x0 : 0;
+    y0 = (y0 > 0) ? y0 : 0;
+    x1 = (x1 < slot->resW) ? x1 : slot->resW;
+    y1 = (y1 < slot->resH) ? y1 : slot->resH;
+
+    slot->x = x0;
+    slot->y = y0;
+    slot->width = (x1 > x0 && y1 > y0) ? x1 - x0 : 0;
+    slot->height = (x1 > x0 && y1 > y0) ? y1 - y0 : 0;
+}
+
+static void read_result(const r3d_pick_slot_t* slot, const float* depth, const float* normals, R3D_PickResult* result)
+{
+    /* --- Find the nearest pixel of the area, the background keeps the far plane depth --- */
+
+    int nearest = -1;
+    float nearestDepth = 1.0f;
+
+    for (int i = 0; i < slot->width * slot->height; i++) {
+        if (depth[i] < nearestDepth) {
+            nearestDepth = depth[i];
+            nearest = i;
+        }
+    }
+
+    if (nearest < 0) {
+        return;
+    }
+
+    /* --- Reconstruct the world position with the matrices of the frame --- */
+
+    int px = slot->x + nearest % slot->width;
+    int py = slot->y + nearest / slot->width;
+
+    Vector4 ndc = {
+        2.0f * (px + 0.5f) / slot->resW - 1.0f,
+        2.0f * (py + 0.5f) / slot->resH - 1.0f,
+        2.0f * nearestDepth - 1.0f,
+        1.0f
+    };
+
+    Vector4 view = r3d_vector4_transform(ndc, &slot->invProj);
+    Vector3 viewPos = {view.x / view.w, view.y / view.w, view.z / view.w};
+    Vector3 cameraPos = {slot->invView.m12, slot->invView.m13, slot->invView.m14};
+
+    result->hit = true;
+    result->position = r3d_vector3_transform(viewPos, &slot->invView);
+    result->distance = Vector3Distance(cameraPos, result->position);
+
+    if (slot->hasNormals) {
+        result->normal = decode_octahedral(normals[2 * nearest], normals[2 * nearest + 1]);
+    }
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_pick_init(void)
+{
+    memset(&R3D_MOD_PICK, 0, sizeof(R3D_MOD_PICK));
+
+    // Depth and the two channels of the normals, as floats
+    size_t size = R3D_PICK_MAX_SIZE * R3D_PICK_MAX_SIZE * 3 * sizeof(float);
+
+    for (int i = 0; i < R3D_PICK_MAX_REQUESTS; i++) {
+        glGenBuffers(1, &R3D_MOD_PICK.slots[i].pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, R3D_MOD_PICK.slots[i].pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return true;
+}
+
+void r3d_pick_quit(void)
+{
+    for (int i = 0; i < R3D_PICK_MAX_REQUESTS; i++) {
+        release_slot(&R3D_MOD_PICK.slots[i]);
+        glDeleteBuffers(1, &R3D_MOD_PICK.slots[i].pbo);
+    }
+}
+
+bool r3d_pick_request(Rectangle area, int tag)
+{
+    if (R3D_MOD_PICK.count == R3D_PICK_MAX_REQUESTS) {
+        return false;
+    }
+
+    r3d_pick_slot_t* slot = &R3D_MOD_PICK.slots[R3D_MOD_PICK.head];
+    R3D_MOD_PICK.head = (R3D_MOD_PICK.head + 1) % R3D_PICK_MAX_REQUESTS;
+    R3D_MOD_PICK.count++;
+    R3D_MOD_PICK.numRequested++;
+
+    slot->area = area;
+    slot->tag = tag;
+    slot->state = R3D_PICK_REQUESTED;
+
+    return true;
+}
+
+void r3d_pick_flush(bool hasNormals)
+{
+    if (R3D_MOD_PICK.numRequested == 0) {
+        return;
+    }
+
+    /*
+     * NOTE: The frame has been blitted, the FBO cache of the
+     *       target module is reset again once the copies are recorded.
+     */
+    r3d_target_bind((r3d_target_t[]) {R3D_TARGET_NORMAL, R3D_TARGET_DEPTH}, 2);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    int resW = 0, resH = 0;
+    r3d_target_get_resolution(&resW, &resH, 0);
+
+    /* --- Record the copies of the requested slots, from the oldest --- */
+
+    for (int i = 0; i < R3D_MOD_PICK.count; i++)
+    {
+        int index = (R3D_MOD_PICK.head - R3D_MOD_PICK.count + i + R3D_PICK_MAX_REQUESTS) % R3D_PICK_MAX_REQUESTS;
+        r3d_pick_slot_t* slot = &R3D_MOD_PICK.slots[index];
+        if (slot->state != R3D_PICK_REQUESTED) continue;
+
+        slot->invView = R3D_CACHE_GET(viewState.invView);
+        slot->invProj = R3D_CACHE_GET(viewState.invProj);
+        slot->resW = resW;
+        slot->resH = resH;
+        slot->hasNormals = hasNormals;
+        slot->state = R3D_PICK_IN_FLIGHT;
+
+        compute_read_area(slot);
+        if (slot->width == 0) continue;
+
+        // The pixels are copied into the buffer by the GPU, glReadPixels returns without waiting for the frame
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+        glReadPixels(slot->x, slot->y, slot->width, slot->height, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+
+        if (hasNormals) {
+            size_t offset = (size_t)slot->width * slot->height * sizeof(float);
+            glReadPixels(slot->x, slot->y, slot->width, slot->height, GL_RG, GL_FLOAT, (void*)offset);
+        }
+
+        slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    R3D_MOD_TARGET.currentFbo = -1;
+
+    // Flushed now so that the fences can signal before the next frame is submitted
+    glFlush();
+
+    R3D_MOD_PICK.numRequested = 0;
+}
+
+bool r3d_pick_poll(R3D_PickResult* result, bool wait)
+{
+    if (R3D_MOD_PICK.count == 0) {
+        return false;
+    }
+
+    int index = (R3D_MOD_PICK.head - R3D_MOD_PICK.count + R3D_PICK_MAX_REQUESTS) % R3D_PICK_MAX_REQUESTS;
+    r3d_pick_slot_t* slot = &R3D_MOD_PICK.slots[index];
+
+    // Waiting can't help, the frame that copies the area has not been rendered yet
+    if (slot->state != R3D_PICK_IN_FLIGHT) {
+        return false;
+    }
+
+    GLenum status = GL_ALREADY_SIGNALED;
+
+    if (slot->fence != NULL) {
+        status = glClientWaitSync((GLsync)slot->fence, 0, 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync((GLsync)slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+    }
+
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    *result = (R3D_PickResult) {0};
+    result->tag = slot->tag;
+
+    if (status == GL_WAIT_FAILED) {
+        TraceLog(LOG_WARNING, "R3D: Failed to wait for a pick");
+    }
+    else if (slot->width > 0) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+
+        size_t count = (size_t)slot->width * slot->height;
+        size_t size = count * (slot->hasNormals ? 3 : 1) * sizeof(float);
+
+        const float* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (data != NULL) {
+            read_result(slot, data, data + count, result);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        else {
+            TraceLog(LOG_WARNING, "R3D: Failed to map the pixels of a pick");
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    release_slot(slot);
+    R3D_MOD_PICK.count--;
+
+    return true;
+}
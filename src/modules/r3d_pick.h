@@ -0,0 +1,103 @@
+/* r3d_pick.h -- Internal R3D picking module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_PICK_H
+#define R3D_MODULE_PICK_H
+
+#include <r3d/r3d_readback.h>
+#include <raylib.h>
+#include <stdint.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_PICK_MAX_SIZE       8       //< Maximum width and height of a picked area, in rendered pixels
+#define R3D_PICK_MAX_REQUESTS   8       //< Number of picks requested or in flight
+
+// ========================================
+// PICK STRUCTURES
+// ========================================
+
+typedef enum {
+    R3D_PICK_FREE,                      //< The slot can receive a request
+    R3D_PICK_REQUESTED,                 //< Waiting for the end of the next frame
+    R3D_PICK_IN_FLIGHT                  //< Copied at the end of a frame, waiting to be polled
+} r3d_pick_state_t;
+
+/*
+ * Asynchronous copy of the depth and normals of a small area of the G-buffer.
+ * The matrices of the frame are kept to reconstruct the world position of the pixels.
+ */
+typedef struct {
+    uint32_t pbo;                       //< Pixel pack buffer receiving the depth then the encoded normals
+    void* fence;                        //< Sync object signaled once the copy is done
+    Rectangle area;                     //< Area requested, in pixels of the output
+    Matrix invView, invProj;            //< Matrices of the frame that produced the depth
+    int x, y, width, height;            //< Area copied, in pixels of the rendered area, zero if outside of it
+    int resW, resH;                     //< Rendered resolution of the frame
+    bool hasNormals;                    //< False if the normals were not written during the frame
+    r3d_pick_state_t state;
+    int tag;
+} r3d_pick_slot_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the picking module.
+ * The requests form a queue, they are copied in order at the end of the frames
+ * and polled in the same order once the GPU is done with them.
+ */
+extern struct r3d_pick {
+
+    r3d_pick_slot_t slots[R3D_PICK_MAX_REQUESTS];
+    int head;                           //< Next slot written by 'r3d_pick_request()'
+    int count;                          //< Slots requested or in flight
+    int numRequested;                   //< Slots waiting for the end of a frame
+
+} R3D_MOD_PICK;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_pick_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_pick_quit(void);
+
+/*
+ * Queues a pick of the given area, in pixels of the output from the top left.
+ * Returns false if the queue is full.
+ */
+bool r3d_pick_request(Rectangle area, int tag);
+
+/*
+ * Copies the requested areas of the depth and normal targets into the pixel buffers.
+ * Called at the end of a frame rendered from a single view, before the blit screen changes.
+ * The normals are only read if the deferred geometry pass has written them.
+ */
+void r3d_pick_flush(bool hasNormals);
+
+/*
+ * Retrieves the result of the oldest pick once its copy is complete.
+ * Returns false if the queue is empty, if the oldest pick was not copied yet,
+ * or if it is still in flight and 'wait' is false.
+ */
+bool r3d_pick_poll(R3D_PickResult* result, bool wait);
+
+#endif // R3D_MODULE_PICK_H
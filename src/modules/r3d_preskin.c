@@ -0,0 +1,247 @@
+/* r3d_preskin.c -- Internal R3D pre-skinning module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_preskin.h"
+
+#include <raylib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../details/r3d_vertex.h"
+#include "./r3d_shader.h"
+#include "./r3d_state.h"
+#include "./r3d_skin.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_preskin R3D_MOD_PRESKIN;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+#define PRESKIN_INITIAL_CAPACITY 16
+
+static void release_entry(r3d_preskin_entry_t* entry)
+{
+    if (entry->vao != 0) glDeleteVertexArrays(1, &entry->vao);
+    if (entry->depthVao != 0) glDeleteVertexArrays(1, &entry->depthVao);
+    if (entry->buffer != 0) glDeleteBuffers(1, &entry->buffer);
+}
+
+static void remove_entry(int index)
+{
+    release_entry(&R3D_MOD_PRESKIN.entries[index]);
+    R3D_MOD_PRESKIN.entries[index] = R3D_MOD_PRESKIN.entries[--R3D_MOD_PRESKIN.count];
+}
+
+static r3d_preskin_entry_t* find_entry(GLuint srcVbo, int poseOffset)
+{
+    for (int i = 0; i < R3D_MOD_PRESKIN.count; i++) {
+        r3d_preskin_entry_t* entry = &R3D_MOD_PRESKIN.entries[i];
+        if (entry->srcVbo == srcVbo && entry->poseOffset == poseOffset) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static r3d_preskin_entry_t* add_entry(GLuint srcVbo, int poseOffset)
+{
+    if (R3D_MOD_PRESKIN.count == R3D_MOD_PRESKIN.capacity) {
+        int capacity = (R3D_MOD_PRESKIN.capacity > 0) ? 2 * R3D_MOD_PRESKIN.capacity : PRESKIN_INITIAL_CAPACITY;
+        r3d_preskin_entry_t* entries = RL_REALLOC(R3D_MOD_PRESKIN.entries, capacity * sizeof(*entries));
+        if (entries == NULL) {
+            TraceLog(LOG_WARNING, "R3D: Failed to grow the pre-skinned poses, the mesh is skinned by each pass");
+            return NULL;
+        }
+        R3D_MOD_PRESKIN.entries = entries;
+        R3D_MOD_PRESKIN.capacity = capacity;
+    }
+
+    r3d_preskin_entry_t* entry = &R3D_MOD_PRESKIN.entries[R3D_MOD_PRESKIN.count++];
+    memset(entry, 0, sizeof(*entry));
+
+    entry->srcVbo = srcVbo;
+    entry->poseOffset = poseOffset;
+    entry->frame = R3D_MOD_PRESKIN.frame - 1;
+
+    return entry;
+}
+
+// NOTE: The skinned vertices replace the position stream and the normals and tangents of the attribute stream
+static void setup_vertex_array(const r3d_preskin_entry_t* entry, const R3D_Mesh* mesh, GLuint vao, bool depthOnly)
+{
+    GLsizei stride = sizeof(r3d_preskin_vertex_t);
+
+    r3d_state_bind_vao(vao);
+
+    if (!depthOnly) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->attribVbo);
+        r3d_vertex_setup_stream(R3D_VERTEX_FORMAT_FULL, R3D_VERTEX_STREAM_ATTRIBS);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, entry->buffer);
+
+    // position (vec4)
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_preskin_vertex_t, position));
+
+    if (!depthOnly) {
+        // normal (vec3)
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_preskin_vertex_t, normal));
+        // tangent (vec4)
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(r3d_preskin_vertex_t, tangent));
+    }
+
+    // Null skinning, the vertices are drawn as a static mesh
+    r3d_vertex_setup_defaults();
+
+    if (mesh->ebo != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    }
+
+    r3d_state_bind_vao(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+// (Re)creates the buffers of an entry for the current layout of the mesh
+static void setup_entry(r3d_preskin_entry_t* entry, const R3D_Mesh* mesh)
+{
+    release_entry(entry);
+
+    entry->vertexCount = mesh->vertexCount;
+    entry->buffer = 0;
+    entry->vao = 0;
+    entry->depthVao = 0;
+
+    glGenBuffers(1, &entry->buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, entry->buffer);
+    glBufferData(GL_ARRAY_BUFFER, mesh->vertexCount * sizeof(r3d_preskin_vertex_t), NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenVertexArrays(1, &entry->vao);
+    setup_vertex_array(entry, mesh, entry->vao, false);
+
+    // Same as the mesh, translucent vertex colors make the depth passes use the full VAO
+    if (mesh->depthVao != 0) {
+        glGenVertexArrays(1, &entry->depthVao);
+        setup_vertex_array(entry, mesh, entry->depthVao, true);
+    }
+
+    // Forces the skinning of the new storage
+    entry->frame = R3D_MOD_PRESKIN.frame - 1;
+}
+
+static void skin_entry(const r3d_preskin_entry_t* entry, const R3D_Mesh* mesh)
+{
+    R3D_SHADER_USE(prepare.preskin);
+
+    R3D_SHADER_BIND_SAMPLER_BUFFER(prepare.preskin, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+    R3D_SHADER_SET_INT(prepare.preskin, uBoneOffset, entry->poseOffset);
+    R3D_SHADER_SET_INT(prepare.preskin, uVertexCount, entry->vertexCount);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, mesh->vbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, mesh->skinVbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, mesh->attribVbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, entry->buffer);
+
+    glDispatchCompute((entry->vertexCount + 63) / 64, 1, 1);
+
+    R3D_MOD_PRESKIN.pending = true;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_preskin_init(void)
+{
+    memset(&R3D_MOD_PRESKIN, 0, sizeof(R3D_MOD_PRESKIN));
+    return true;
+}
+
+void r3d_preskin_quit(void)
+{
+    for (int i = 0; i < R3D_MOD_PRESKIN.count; i++) {
+        release_entry(&R3D_MOD_PRESKIN.entries[i]);
+    }
+
+    RL_FREE(R3D_MOD_PRESKIN.entries);
+
+    memset(&R3D_MOD_PRESKIN, 0, sizeof(R3D_MOD_PRESKIN));
+}
+
+void r3d_preskin_begin(void)
+{
+    R3D_MOD_PRESKIN.frame++;
+
+    for (int i = R3D_MOD_PRESKIN.count - 1; i >= 0; i--) {
+        if (R3D_MOD_PRESKIN.frame - R3D_MOD_PRESKIN.entries[i].frame > R3D_PRESKIN_MAX_IDLE_FRAMES) {
+            remove_entry(i);
+        }
+    }
+}
+
+void r3d_preskin_end(void)
+{
+    if (!R3D_MOD_PRESKIN.pending) {
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    R3D_MOD_PRESKIN.pending = false;
+}
+
+bool r3d_preskin_is_supported(const R3D_Mesh* mesh)
+{
+    return GLAD_GL_VERSION_4_3 && mesh->skinVbo != 0 && mesh->vertexCount > 0 &&
+           mesh->vertexFormat == R3D_VERTEX_FORMAT_FULL;
+}
+
+bool r3d_preskin_apply(R3D_Mesh* mesh, int poseOffset)
+{
+    r3d_preskin_entry_t* entry = find_entry(mesh->vbo, poseOffset);
+
+    if (entry == NULL) {
+        entry = add_entry(mesh->vbo, poseOffset);
+        if (entry == NULL) return false;
+    }
+
+    // The mesh may have been updated with another vertex count or translucency since the last frame
+    if (entry->buffer == 0 || entry->vertexCount != mesh->vertexCount || (entry->depthVao != 0) != (mesh->depthVao != 0)) {
+        setup_entry(entry, mesh);
+    }
+
+    if (entry->frame != R3D_MOD_PRESKIN.frame) {
+        skin_entry(entry, mesh);
+        entry->frame = R3D_MOD_PRESKIN.frame;
+    }
+
+    mesh->vao = entry->vao;
+    mesh->depthVao = entry->depthVao;
+
+    return true;
+}
+
+void r3d_preskin_release(const R3D_Mesh* mesh)
+{
+    for (int i = R3D_MOD_PRESKIN.count - 1; i >= 0; i--) {
+        if (R3D_MOD_PRESKIN.entries[i].srcVbo == mesh->vbo) {
+            remove_entry(i);
+        }
+    }
+}
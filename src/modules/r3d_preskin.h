@@ -0,0 +1,112 @@
+/* r3d_preskin.h -- Internal R3D pre-skinning module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_PRESKIN_H
+#define R3D_MODULE_PRESKIN_H
+
+#include <r3d/r3d_mesh.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <glad.h>
+
+// ========================================
+// MODULE CONSTANTS
+// ========================================
+
+#define R3D_PRESKIN_MAX_IDLE_FRAMES     60      //< Frames without use after which the buffers of a pose are released
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Skinned vertex written by 'preskin.comp', read with the attributes of the mesh.
+ */
+typedef struct {
+    float position[4];
+    float normal[4];
+    float tangent[4];
+} r3d_preskin_vertex_t;
+
+/*
+ * Vertices of one mesh skinned with one pose, with the vertex arrays drawing them.
+ */
+typedef struct {
+    GLuint srcVbo;                      //< Position stream of the skinned mesh
+    int poseOffset;                     //< First matrix of the pose in the bone palette
+    int vertexCount;                    //< Vertices allocated in 'buffer'
+    GLuint buffer;                      //< Skinned vertices, see 'r3d_preskin_vertex_t'
+    GLuint vao;                         //< Skinned vertices with the texcoords and colors of the mesh
+    GLuint depthVao;                    //< Skinned positions only, zero if the mesh has no depth VAO
+    uint32_t frame;                     //< Last frame the vertices were skinned
+} r3d_preskin_entry_t;
+
+/*
+ * Global internal state of the pre-skinning module.
+ * Skinned meshes are skinned once per frame by a compute shader into a buffer owned by
+ * the pair of mesh and pose, then every pass draws that buffer as a static mesh instead
+ * of skinning the vertices again in each shadow face, prepass and geometry pass.
+ */
+extern struct r3d_preskin {
+
+    r3d_preskin_entry_t* entries;       //< Skinned poses, kept between frames to reuse their buffers
+    int count;
+    int capacity;
+
+    uint32_t frame;                     //< Incremented by `r3d_preskin_begin()`
+    bool pending;                       //< Vertices were written since the last barrier
+
+} R3D_MOD_PRESKIN;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_preskin_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_preskin_quit(void);
+
+/*
+ * Starts a new frame of pre-skinning, all the poses will be skinned again on their first use.
+ * Releases the buffers of the poses that have not been drawn for `R3D_PRESKIN_MAX_IDLE_FRAMES` frames.
+ */
+void r3d_preskin_begin(void);
+
+/*
+ * Makes the vertices skinned since `r3d_preskin_begin()` visible to the vertex attributes.
+ * Must be called before the first pass drawing them.
+ */
+void r3d_preskin_end(void);
+
+/*
+ * Returns true if the mesh can be pre-skinned.
+ * Requires OpenGL 4.3, bone weights, and the full vertex format.
+ */
+bool r3d_preskin_is_supported(const R3D_Mesh* mesh);
+
+/*
+ * Skins the mesh with the pose at 'poseOffset' in the bone palette, unless it was already done this frame,
+ * then replaces the vertex arrays of the mesh by the ones of the skinned vertices.
+ * The mesh must be supported, returns false if the pose could not be recorded.
+ */
+bool r3d_preskin_apply(R3D_Mesh* mesh, int poseOffset);
+
+/*
+ * Releases the skinned poses of a mesh, called when the mesh is unloaded.
+ */
+void r3d_preskin_release(const R3D_Mesh* mesh);
+
+#endif // R3D_MODULE_PRESKIN_H
@@ -9,10 +9,14 @@
 #include "./r3d_primitive.h"
 
 #include <r3d/r3d_mesh_data.h>
+#include <raymath.h>
 #include <stddef.h>
 #include <string.h>
+#include <math.h>
 #include <glad.h>
 
+#include "./r3d_state.h"
+
 // ========================================
 // MODULE STATE
 // ========================================
@@ -54,7 +58,7 @@ static void load_mesh(primitive_buffer_t* buf, const R3D_Vertex* verts, int vert
     glGenBuffers(1, &buf->vbo);
     glGenBuffers(1, &buf->ebo);
     
-    glBindVertexArray(buf->vao);
+    r3d_state_bind_vao(buf->vao);
     
     glBindBuffer(GL_ARRAY_BUFFER, buf->vbo);
     glBufferData(GL_ARRAY_BUFFER, vertCount * sizeof(R3D_Vertex), verts, GL_STATIC_DRAW);
@@ -76,11 +80,15 @@ typedef void (*primitive_loader_func)(primitive_buffer_t*);
 static void load_dummy(primitive_buffer_t* dummy);
 static void load_quad(primitive_buffer_t* quad);
 static void load_cube(primitive_buffer_t* cube);
+static void load_sphere(primitive_buffer_t* sphere);
+static void load_cone(primitive_buffer_t* cone);
 
 static const primitive_loader_func LOADERS[] = {
     [R3D_PRIMITIVE_DUMMY] = load_dummy,
     [R3D_PRIMITIVE_QUAD] = load_quad,
     [R3D_PRIMITIVE_CUBE] = load_cube,
+    [R3D_PRIMITIVE_SPHERE] = load_sphere,
+    [R3D_PRIMITIVE_CONE] = load_cone,
 };
 
 void load_dummy(primitive_buffer_t* buf)
@@ -144,6 +152,123 @@ void load_cube(primitive_buffer_t* buf)
     load_mesh(buf, VERTS, 24, INDICES, 36);
 }
 
+void load_sphere(primitive_buffer_t* buf)
+{
+    // NOTE: Used as a light volume, so only the positions are set and
+    //       the faces are pushed out until they enclose the unit sphere
+
+    enum { STACKS = 8, SLICES = 12 };
+    enum { VERT_COUNT = 2 + (STACKS - 1) * SLICES };
+    enum { IDX_COUNT = 6 * SLICES * (STACKS - 1) };
+
+    R3D_Vertex verts[VERT_COUNT] = {0};
+    GLubyte indices[IDX_COUNT];
+
+    /* --- Generate the poles and the rings --- */
+
+    const int south = VERT_COUNT - 1;
+
+    verts[0].position = (Vector3) {0, 1, 0};
+    verts[south].position = (Vector3) {0, -1, 0};
+
+    for (int i = 1; i < STACKS; i++) {
+        float phi = PI * (float)i / STACKS;
+        for (int j = 0; j < SLICES; j++) {
+            float theta = 2.0f * PI * (float)j / SLICES;
+            verts[1 + (i - 1) * SLICES + j].position = (Vector3) {
+                sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)
+            };
+        }
+    }
+
+    /* --- Triangulate, counter-clockwise seen from the outside --- */
+
+    int idx = 0;
+
+    for (int j = 0; j < SLICES; j++) {
+        int j1 = (j + 1) % SLICES;
+        indices[idx++] = 0;
+        indices[idx++] = 1 + j1;
+        indices[idx++] = 1 + j;
+        indices[idx++] = south;
+        indices[idx++] = 1 + (STACKS - 2) * SLICES + j;
+        indices[idx++] = 1 + (STACKS - 2) * SLICES + j1;
+    }
+
+    for (int i = 0; i < STACKS - 2; i++) {
+        int r0 = 1 + i * SLICES, r1 = r0 + SLICES;
+        for (int j = 0; j < SLICES; j++) {
+            int j1 = (j + 1) % SLICES;
+            indices[idx++] = r0 + j;
+            indices[idx++] = r0 + j1;
+            indices[idx++] = r1 + j;
+            indices[idx++] = r1 + j;
+            indices[idx++] = r0 + j1;
+            indices[idx++] = r1 + j1;
+        }
+    }
+
+    /* --- Scale by the smallest distance of a face to the center --- */
+
+    float minDist = 1.0f;
+
+    for (int i = 0; i < IDX_COUNT; i += 3) {
+        Vector3 a = verts[indices[i + 0]].position;
+        Vector3 b = verts[indices[i + 1]].position;
+        Vector3 c = verts[indices[i + 2]].position;
+        Vector3 n = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(b, a), Vector3Subtract(c, a)));
+        minDist = fminf(minDist, Vector3DotProduct(n, a));
+    }
+
+    for (int i = 0; i < VERT_COUNT; i++) {
+        verts[i].position = Vector3Scale(verts[i].position, 1.0f / minDist);
+    }
+
+    load_mesh(buf, verts, VERT_COUNT, indices, IDX_COUNT);
+}
+
+void load_cone(primitive_buffer_t* buf)
+{
+    // NOTE: Used as a light volume, so only the positions are set.
+    //       The side faces are planar, so the polygon radius is enough to enclose the unit cone
+
+    enum { SLICES = 16 };
+    enum { VERT_COUNT = 2 + SLICES };
+    enum { IDX_COUNT = 6 * SLICES };
+
+    R3D_Vertex verts[VERT_COUNT] = {0};
+    GLubyte indices[IDX_COUNT];
+
+    /* --- Generate the apex, the base center and the base ring --- */
+
+    const int center = VERT_COUNT - 1;
+    const float radius = 1.0f / cosf(PI / SLICES);
+
+    verts[0].position = (Vector3) {0, 0, 0};
+    verts[center].position = (Vector3) {0, 0, 1};
+
+    for (int j = 0; j < SLICES; j++) {
+        float theta = 2.0f * PI * (float)j / SLICES;
+        verts[1 + j].position = (Vector3) {radius * cosf(theta), radius * sinf(theta), 1};
+    }
+
+    /* --- Triangulate, counter-clockwise seen from the outside --- */
+
+    int idx = 0;
+
+    for (int j = 0; j < SLICES; j++) {
+        int j1 = (j + 1) % SLICES;
+        indices[idx++] = 0;
+        indices[idx++] = 1 + j1;
+        indices[idx++] = 1 + j;
+        indices[idx++] = center;
+        indices[idx++] = 1 + j;
+        indices[idx++] = 1 + j1;
+    }
+
+    load_mesh(buf, verts, VERT_COUNT, indices, IDX_COUNT);
+}
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -170,7 +295,7 @@ void r3d_primitive_draw(r3d_primitive_t primitive)
 
     // NOTE: The loader leaves the vao bound
     if (buf->vao == 0) LOADERS[primitive](buf);
-    else glBindVertexArray(buf->vao);
+    else r3d_state_bind_vao(buf->vao);
 
     if (buf->indexCount > 0) {
         glDrawElements(GL_TRIANGLES, buf->indexCount, GL_UNSIGNED_BYTE, 0);
@@ -190,7 +315,7 @@ void r3d_primitive_draw_instanced(r3d_primitive_t primitive, const void* transfo
 
     // NOTE: The loader leaves the vao bound
     if (buf->vao == 0) LOADERS[primitive](buf);
-    else glBindVertexArray(buf->vao);
+    else r3d_state_bind_vao(buf->vao);
 
     unsigned int vboTransforms = 0;
     unsigned int vboColors = 0;
@@ -246,6 +371,4 @@ void r3d_primitive_draw_instanced(r3d_primitive_t primitive, const void* transfo
         glVertexAttribDivisor(locInstanceColor, 0);
         glDeleteBuffers(1, &vboColors);
     }
-
-    glBindVertexArray(0);
 }
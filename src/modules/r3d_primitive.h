@@ -20,6 +20,8 @@ typedef enum {
     R3D_PRIMITIVE_DUMMY,        //< Calls glDrawArrays with 3 vertices without an attached VBO/EBO
     R3D_PRIMITIVE_QUAD,         //< Draws a quad with dimensions 1.0 (-0.5 .. +0.5)
     R3D_PRIMITIVE_CUBE,         //< Draws a cube with dimensions 1.0 (-0.5 .. +0.5)
+    R3D_PRIMITIVE_SPHERE,       //< Draws a low poly sphere enclosing the unit sphere, positions only
+    R3D_PRIMITIVE_CONE,         //< Draws a low poly cone enclosing the unit cone, apex at the origin, base at Z+1
     R3D_PRIMITIVE_COUNT
 } r3d_primitive_t;
 
@@ -39,6 +41,14 @@ typedef enum {
     r3d_primitive_draw(R3D_PRIMITIVE_CUBE);     \
 } while(0)
 
+#define R3D_PRIMITIVE_DRAW_SPHERE() do {        \
+    r3d_primitive_draw(R3D_PRIMITIVE_SPHERE);   \
+} while(0)
+
+#define R3D_PRIMITIVE_DRAW_CONE() do {          \
+    r3d_primitive_draw(R3D_PRIMITIVE_CONE);     \
+} while(0)
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -0,0 +1,462 @@
+/* r3d_probe.c -- Internal R3D reflection probe module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_probe.h"
+
+#include <raymath.h>
+#include <string.h>
+#include <rlgl.h>
+#include <glad.h>
+
+#include "./r3d_primitive.h"
+#include "./r3d_shader.h"
+#include "./r3d_cache.h"
+#include "./r3d_state.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_probe R3D_MOD_PROBE;
+
+// ========================================
+// UNIFORM BLOCK
+// ========================================
+
+// NOTE: Must match the 'ProbeBlock' of 'probe.glsl' (std140)
+typedef struct {
+    Vector4 position;           //< w: Intensity
+    Vector4 boxMin;             //< w: Blend distance
+    Vector4 boxMax;             //< w: Index of the cubemap in the array
+} uniform_probe_t;
+
+typedef struct {
+    uniform_probe_t probes[R3D_PROBE_MAX_VISIBLE];
+    int32_t count;
+    int32_t padding[3];
+} uniform_probe_block_t;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static bool ensure_textures(void)
+{
+    if (R3D_MOD_PROBE.arrayTex != 0) {
+        return true;
+    }
+
+    glGenTextures(1, &R3D_MOD_PROBE.arrayTex);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, R3D_MOD_PROBE.arrayTex);
+    for (int level = 0; level < R3D_PROBE_LEVELS; level++) {
+        int size = R3D_PROBE_SIZE >> level;
+        glTexImage3D(
+            GL_TEXTURE_CUBE_MAP_ARRAY, level, GL_RGB16F,
+            size, size, 6 * R3D_PROBE_MAX_COUNT, 0, GL_RGB, GL_HALF_FLOAT, NULL
+        );
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAX_LEVEL, R3D_PROBE_LEVELS - 1);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    glGenTextures(1, &R3D_MOD_PROBE.captureTex);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, R3D_MOD_PROBE.captureTex);
+    for (int face = 0; face < 6; face++) {
+        glTexImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB16F,
+            R3D_PROBE_CAPTURE_SIZE, R3D_PROBE_CAPTURE_SIZE, 0, GL_RGB, GL_HALF_FLOAT, NULL
+        );
+    }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
+
+    return true;
+}
+
+static int schedule_capture(Vector3 viewPosition)
+{
+    int best = -1;
+    float bestScore = 0.0f;
+
+    for (int i = 0; i < R3D_PROBE_MAX_COUNT; i++)
+    {
+        const r3d_probe_t* probe = &R3D_MOD_PROBE.probes[i];
+        if (!probe->used || !probe->enabled || !probe->pending) {
+            continue;
+        }
+
+        // Important probes close to the view first, the waiting ones catch up over time
+        float distance = Vector3Distance(viewPosition, probe->position);
+        float score = probe->importance * (1.0f + probe->waitFrames) / (1.0f + distance);
+
+        // Probes never captured come before all the others, they would reflect nothing
+        bool better = (best < 0)
+            || (!probe->captured && R3D_MOD_PROBE.probes[best].captured)
+            || (probe->captured == R3D_MOD_PROBE.probes[best].captured && score > bestScore);
+
+        if (better) {
+            best = i;
+            bestScore = score;
+        }
+    }
+
+    for (int i = 0; i < R3D_PROBE_MAX_COUNT; i++) {
+        r3d_probe_t* probe = &R3D_MOD_PROBE.probes[i];
+        if (probe->used && probe->pending) {
+            probe->waitFrames = (i == best) ? 0 : probe->waitFrames + 1;
+        }
+    }
+
+    return best;
+}
+
+static void prefilter_capture(int index)
+{
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, R3D_MOD_PROBE.captureTex);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
+
+    const Matrix matProj = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+
+    R3D_SHADER_USE(prepare.cubemapPrefilter);
+    R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatProj, matProj);
+    R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uResolution, (float)R3D_PROBE_CAPTURE_SIZE);
+    R3D_SHADER_BIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap, R3D_MOD_PROBE.captureTex);
+
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_PROBE.fbo);
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_disable(GL_CULL_FACE);
+    r3d_state_disable(GL_BLEND);
+
+    // Same roughness per level as the prefiltered skyboxes
+    for (int mip = 0; mip < R3D_PROBE_LEVELS; mip++)
+    {
+        int mipSize = R3D_PROBE_SIZE >> mip;
+        glViewport(0, 0, mipSize, mipSize);
+
+        float roughness = (float)mip / (float)(R3D_PROBE_LEVELS - 1);
+        R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uRoughness, roughness);
+
+        for (int face = 0; face < 6; face++) {
+            R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatView, R3D_CACHE_GET(matCubeViews[face]));
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, R3D_MOD_PROBE.arrayTex, mip, 6 * index + face);
+            R3D_PRIMITIVE_DRAW_CUBE();
+        }
+    }
+
+    R3D_SHADER_UNBIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap);
+
+    r3d_state_enable(GL_CULL_FACE);
+}
+
+static float get_box_volume(const BoundingBox* box)
+{
+    Vector3 size = Vector3Subtract(box->max, box->min);
+    return size.x * size.y * size.z;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_probe_init(void)
+{
+    memset(&R3D_MOD_PROBE, 0, sizeof(R3D_MOD_PROBE));
+
+    R3D_MOD_PROBE.captureProbe = -1;
+    R3D_MOD_PROBE.capturing = -1;
+
+    // NOTE: The ambient shader only requests the extension, a 4.0 context alone is not enough
+    R3D_MOD_PROBE.supported = GLAD_GL_ARB_texture_cube_map_array;
+    if (!R3D_MOD_PROBE.supported) {
+        return true;
+    }
+
+    glGenFramebuffers(1, &R3D_MOD_PROBE.fbo);
+
+    glGenBuffers(1, &R3D_MOD_PROBE.uniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, R3D_MOD_PROBE.uniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(uniform_probe_block_t), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    return true;
+}
+
+void r3d_probe_quit(void)
+{
+    if (R3D_MOD_PROBE.arrayTex != 0) glDeleteTextures(1, &R3D_MOD_PROBE.arrayTex);
+    if (R3D_MOD_PROBE.captureTex != 0) glDeleteTextures(1, &R3D_MOD_PROBE.captureTex);
+    if (R3D_MOD_PROBE.fbo != 0) glDeleteFramebuffers(1, &R3D_MOD_PROBE.fbo);
+    if (R3D_MOD_PROBE.uniformBuffer != 0) glDeleteBuffers(1, &R3D_MOD_PROBE.uniformBuffer);
+}
+
+R3D_ReflectionProbe r3d_probe_new(BoundingBox bounds)
+{
+    if (!R3D_MOD_PROBE.supported) {
+        TraceLog(LOG_WARNING, "R3D: Reflection probes require 'GL_ARB_texture_cube_map_array'");
+        return -1;
+    }
+
+    int index = -1;
+    for (int i = 0; i < R3D_PROBE_MAX_COUNT && index < 0; i++) {
+        if (!R3D_MOD_PROBE.probes[i].used) index = i;
+    }
+
+    if (index < 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot create more than %i reflection probes", R3D_PROBE_MAX_COUNT);
+        return -1;
+    }
+
+    if (!ensure_textures()) {
+        return -1;
+    }
+
+    r3d_probe_t* probe = &R3D_MOD_PROBE.probes[index];
+    memset(probe, 0, sizeof(*probe));
+
+    probe->bounds = bounds;
+    probe->position = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5f);
+    probe->blendDistance = 1.0f;
+    probe->intensity = 1.0f;
+    probe->importance = 1.0f;
+    probe->updateMode = R3D_PROBE_UPDATE_ONCE;
+    probe->used = true;
+    probe->enabled = true;
+    probe->pending = true;
+
+    return index;
+}
+
+void r3d_probe_delete(R3D_ReflectionProbe id)
+{
+    if (!r3d_probe_is_valid(id)) return;
+
+    R3D_MOD_PROBE.probes[id].used = false;
+
+    if (R3D_MOD_PROBE.captureProbe == id) {
+        R3D_MOD_PROBE.captureProbe = -1;
+    }
+}
+
+bool r3d_probe_is_valid(R3D_ReflectionProbe id)
+{
+    return id >= 0 && id < R3D_PROBE_MAX_COUNT && R3D_MOD_PROBE.probes[id].used;
+}
+
+r3d_probe_t* r3d_probe_get(R3D_ReflectionProbe id)
+{
+    return r3d_probe_is_valid(id) ? &R3D_MOD_PROBE.probes[id] : NULL;
+}
+
+bool r3d_probe_begin_capture(Vector3 viewPosition, Camera3D* camera)
+{
+    // NOTE: Must match the cube views of the cache module
+    static const Vector3 DIRECTIONS[6] = {
+        { 1.0f,  0.0f,  0.0f}, {-1.0f,  0.0f,  0.0f},
+        { 0.0f,  1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f},
+        { 0.0f,  0.0f,  1.0f}, { 0.0f,  0.0f, -1.0f}
+    };
+    static const Vector3 UPS[6] = {
+        { 0.0f, -1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f},
+        { 0.0f,  0.0f,  1.0f}, { 0.0f,  0.0f, -1.0f},
+        { 0.0f, -1.0f,  0.0f}, { 0.0f, -1.0f,  0.0f}
+    };
+
+    int index = R3D_MOD_PROBE.captureProbe;
+
+    // The faces of a probe are captured one after the other, so its cubemap is consistent
+    if (index < 0 || !R3D_MOD_PROBE.probes[index].used || !R3D_MOD_PROBE.probes[index].enabled) {
+        index = schedule_capture(viewPosition);
+        if (index < 0) return false;
+        R3D_MOD_PROBE.captureProbe = index;
+        R3D_MOD_PROBE.captureFace = 0;
+    }
+
+    const r3d_probe_t* probe = &R3D_MOD_PROBE.probes[index];
+    int face = R3D_MOD_PROBE.captureFace;
+
+    *camera = (Camera3D) {
+        .position = probe->position,
+        .target = Vector3Add(probe->position, DIRECTIONS[face]),
+        .up = UPS[face],
+        .fovy = 90.0f,
+        .projection = CAMERA_PERSPECTIVE
+    };
+
+    R3D_MOD_PROBE.capturing = index;
+
+    return true;
+}
+
+void r3d_probe_end_capture(r3d_target_t sceneTarget)
+{
+    int index = R3D_MOD_PROBE.capturing;
+    R3D_MOD_PROBE.capturing = -1;
+
+    // The probe may have been destroyed since the beginning of the capture
+    if (index < 0 || R3D_MOD_PROBE.captureProbe != index) {
+        return;
+    }
+
+    int face = R3D_MOD_PROBE.captureFace++;
+
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_PROBE.fbo);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_CUBE_MAP_POSITIVE_X + face,
+        R3D_MOD_PROBE.captureTex, 0
+    );
+
+    r3d_target_blit_color(sceneTarget, R3D_MOD_PROBE.fbo, R3D_PROBE_CAPTURE_SIZE, R3D_PROBE_CAPTURE_SIZE);
+
+    if (R3D_MOD_PROBE.captureFace == 6) {
+        prefilter_capture(index);
+
+        r3d_probe_t* probe = &R3D_MOD_PROBE.probes[index];
+        probe->captured = true;
+        probe->pending = (probe->updateMode == R3D_PROBE_UPDATE_ALWAYS);
+
+        R3D_MOD_PROBE.captureProbe = -1;
+    }
+
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+}
+
+void r3d_probe_bind_visible(int slot, const r3d_frustum_t* frustum)
+{
+    R3D_MOD_PROBE.visibleCount = 0;
+
+    if (!R3D_MOD_PROBE.supported || r3d_probe_is_capturing()) {
+        return;
+    }
+
+    /* --- Collect the visible probes, sorted from the smallest to the largest --- */
+
+    int visible[R3D_PROBE_MAX_COUNT];
+    int count = 0;
+
+    for (int i = 0; i < R3D_PROBE_MAX_COUNT; i++)
+    {
+        const r3d_probe_t* probe = &R3D_MOD_PROBE.probes[i];
+        if (!probe->used || !probe->enabled || !probe->captured) continue;
+        if (!r3d_frustum_is_aabb_in(frustum, &probe->bounds)) continue;
+
+        float volume = get_box_volume(&probe->bounds);
+
+        int j = count++;
+        while (j > 0 && get_box_volume(&R3D_MOD_PROBE.probes[visible[j - 1]].bounds) > volume) {
+            visible[j] = visible[j - 1];
+            j--;
+        }
+        visible[j] = i;
+    }
+
+    if (count > R3D_PROBE_MAX_VISIBLE) {
+        count = R3D_PROBE_MAX_VISIBLE;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    /* --- Upload and bind the uniform block --- */
+
+    uniform_probe_block_t block = {0};
+
+    for (int i = 0; i < count; i++) {
+        const r3d_probe_t* probe = &R3D_MOD_PROBE.probes[visible[i]];
+        block.probes[i].position = (Vector4) { probe->position.x, probe->position.y, probe->position.z, probe->intensity };
+        block.probes[i].boxMin = (Vector4) { probe->bounds.min.x, probe->bounds.min.y, probe->bounds.min.z, probe->blendDistance };
+        block.probes[i].boxMax = (Vector4) { probe->bounds.max.x, probe->bounds.max.y, probe->bounds.max.z, (float)visible[i] };
+    }
+
+    block.count = count;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, R3D_MOD_PROBE.uniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    glBindBufferBase(GL_UNIFORM_BUFFER, slot, R3D_MOD_PROBE.uniformBuffer);
+
+    R3D_MOD_PROBE.visibleCount = count;
+}
+
+size_t r3d_probe_get_data_size(void)
+{
+    size_t total = 0;
+    for (int level = 0; level < R3D_PROBE_LEVELS; level++) {
+        int size = R3D_PROBE_SIZE >> level;
+        total += 6 * (size_t)size * size * 3 * sizeof(uint16_t);
+    }
+    return total;
+}
+
+bool r3d_probe_read(R3D_ReflectionProbe id, unsigned char* dst)
+{
+    if (!r3d_probe_is_valid(id)) return false;
+
+    // Levels one after the other, each with its faces in the order +X, -X, +Y, -Y, +Z, -Z
+    size_t arraySize = 6 * (size_t)R3D_PROBE_SIZE * R3D_PROBE_SIZE * 3 * sizeof(uint16_t) * R3D_PROBE_MAX_COUNT;
+    unsigned char* level = RL_MALLOC(arraySize);
+    if (level == NULL) return false;
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, R3D_MOD_PROBE.arrayTex);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // NOTE: Sub-image reads require GL 4.5, the whole level of the array is read instead
+    for (int i = 0; i < R3D_PROBE_LEVELS; i++) {
+        int size = R3D_PROBE_SIZE >> i;
+        size_t cubeSize = 6 * (size_t)size * size * 3 * sizeof(uint16_t);
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_ARRAY, i, GL_RGB, GL_HALF_FLOAT, level);
+        memcpy(dst, level + id * cubeSize, cubeSize);
+        dst += cubeSize;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    RL_FREE(level);
+
+    return true;
+}
+
+bool r3d_probe_write(R3D_ReflectionProbe id, const unsigned char* src)
+{
+    r3d_probe_t* probe = r3d_probe_get(id);
+    if (probe == NULL) return false;
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, R3D_MOD_PROBE.arrayTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int i = 0; i < R3D_PROBE_LEVELS; i++) {
+        int size = R3D_PROBE_SIZE >> i;
+        glTexSubImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, i, 0, 0, 6 * id, size, size, 6, GL_RGB, GL_HALF_FLOAT, src);
+        src += 6 * (size_t)size * size * 3 * sizeof(uint16_t);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    // A loaded probe replaces any capture in progress
+    if (R3D_MOD_PROBE.captureProbe == id) {
+        R3D_MOD_PROBE.captureProbe = -1;
+    }
+
+    probe->captured = true;
+    probe->pending = (probe->updateMode == R3D_PROBE_UPDATE_ALWAYS);
+
+    return true;
+}
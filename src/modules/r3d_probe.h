@@ -0,0 +1,156 @@
+/* r3d_probe.h -- Internal R3D reflection probe module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_PROBE_H
+#define R3D_MODULE_PROBE_H
+
+#include <r3d/r3d_probe.h>
+#include <raylib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <glad.h>
+
+#include "../details/r3d_frustum.h"
+#include "./r3d_target.h"
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_PROBE_MAX_COUNT         16      //< Number of cubemaps in the probe array
+#define R3D_PROBE_MAX_VISIBLE       8       //< Probes blended per frame at most, see 'PROBE_BLOCK_COUNT' in the shaders
+#define R3D_PROBE_CAPTURE_SIZE      256     //< Size of the faces rendered from the scene
+#define R3D_PROBE_SIZE              128     //< Size of the prefiltered cubemaps, same as the skyboxes
+#define R3D_PROBE_LEVELS            8       //< 1 + (int)floor(log2(R3D_PROBE_SIZE))
+
+// ========================================
+// PROBE STRUCTURES
+// ========================================
+
+typedef struct {
+    BoundingBox bounds;                     //< Volume influenced by the probe, also used for the parallax correction
+    Vector3 position;                       //< Capture position, inside the bounds
+    float blendDistance;                    //< Distance from the bounds over which the probe fades out
+    float intensity;                        //< Multiplier of the captured radiance
+    float importance;                       //< Scheduling priority of the captures
+    R3D_ProbeUpdateMode updateMode;         //< When the probe is captured again
+    int waitFrames;                         //< Frames the pending capture has waited for its turn
+    bool used;                              //< The slot holds a probe
+    bool enabled;                           //< The probe is blended when visible
+    bool captured;                          //< The cubemap holds a complete capture
+    bool pending;                           //< A capture is requested
+} r3d_probe_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the probe module.
+ * Each probe owns one cubemap of the array, its faces are rendered one per capture
+ * into a scratch cubemap, which is prefiltered into the array once complete.
+ */
+extern struct r3d_probe {
+
+    r3d_probe_t probes[R3D_PROBE_MAX_COUNT];    //< Probe slots, the index is the cubemap in the array
+
+    GLuint arrayTex;                        //< Prefiltered cubemaps of all the probes, created with the first probe
+    GLuint captureTex;                      //< Faces of the capture in progress, with mipmaps for the prefiltering
+    GLuint fbo;                             //< Framebuffer used to write the faces
+    GLuint uniformBuffer;                   //< Visible probes uniform buffer, see 'r3d_probe_bind_visible()'
+
+    int captureProbe;                       //< Probe whose faces are in the scratch cubemap, -1 if none
+    int captureFace;                        //< Next face of the capture in progress
+    int capturing;                          //< Probe rendered by the current frame, -1 outside of a capture
+
+    int visibleCount;                       //< Number of probes in the uniform buffer
+    bool supported;                         //< Cubemap arrays are available
+
+} R3D_MOD_PROBE;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_probe_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_probe_quit(void);
+
+/*
+ * Creates a probe and requests its first capture.
+ * Returns -1 if all the slots are used or if cubemap arrays are not supported.
+ */
+R3D_ReflectionProbe r3d_probe_new(BoundingBox bounds);
+
+void r3d_probe_delete(R3D_ReflectionProbe id);
+
+bool r3d_probe_is_valid(R3D_ReflectionProbe id);
+
+r3d_probe_t* r3d_probe_get(R3D_ReflectionProbe id);
+
+/*
+ * Picks the next face to capture, the faces of a probe are captured one after the other
+ * and the probes by importance, distance to the view and waiting time.
+ * Fills the camera of the face and marks the frame as a capture.
+ * Returns false if no capture is pending.
+ */
+bool r3d_probe_begin_capture(Vector3 viewPosition, Camera3D* camera);
+
+/*
+ * Returns true if the current frame renders a probe face.
+ */
+static inline bool r3d_probe_is_capturing(void)
+{
+    return R3D_MOD_PROBE.capturing >= 0;
+}
+
+/*
+ * Stores the scene target as the face being captured and ends the capture.
+ * Once the six faces are stored, the cubemap of the probe is prefiltered.
+ */
+void r3d_probe_end_capture(r3d_target_t sceneTarget);
+
+/*
+ * Uploads and binds the enabled and captured probes intersecting the frustum, smallest first.
+ * No probe is bound during a capture, the captures only reflect the sky.
+ */
+void r3d_probe_bind_visible(int slot, const r3d_frustum_t* frustum);
+
+/*
+ * Returns true if the last call to 'r3d_probe_bind_visible()' bound any probe.
+ */
+static inline bool r3d_probe_has_visible(void)
+{
+    return R3D_MOD_PROBE.visibleCount > 0;
+}
+
+/*
+ * Size in bytes of the prefiltered cubemap of a probe, all levels included.
+ * The data is stored as RGB half floats, level after level, with six faces per level.
+ */
+size_t r3d_probe_get_data_size(void);
+
+/*
+ * Copies the prefiltered cubemap of a probe, see 'r3d_probe_get_data_size()'.
+ */
+bool r3d_probe_read(R3D_ReflectionProbe id, unsigned char* dst);
+
+/*
+ * Replaces the prefiltered cubemap of a probe and marks it as captured.
+ */
+bool r3d_probe_write(R3D_ReflectionProbe id, const unsigned char* src);
+
+#endif // R3D_MODULE_PROBE_H
@@ -0,0 +1,213 @@
+/* r3d_profile.c -- Internal R3D profiling module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_profile.h"
+
+#include <string.h>
+#include <glad.h>
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_profile R3D_MOD_PROFILE;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static const char* PASS_NAMES[R3D_PROFILE_PASS_COUNT] = {
+    [R3D_PROFILE_SHADOWS]       = "Shadows",
+    [R3D_PROFILE_GEOMETRY]      = "Geometry",
+    [R3D_PROFILE_DEPTH_PYRAMID] = "Depth Pyramid",
+    [R3D_PROFILE_DECALS]        = "Decals",
+    [R3D_PROFILE_SSAO]          = "SSAO",
+    [R3D_PROFILE_LIGHTING]      = "Lighting",
+    [R3D_PROFILE_SSIL]          = "SSIL",
+    [R3D_PROFILE_SSR]           = "SSR",
+    [R3D_PROFILE_AMBIENT]       = "Ambient",
+    [R3D_PROFILE_BACKGROUND]    = "Background",
+    [R3D_PROFILE_FORWARD]       = "Forward",
+    [R3D_PROFILE_FOG]           = "Fog",
+    [R3D_PROFILE_DOF]           = "DoF",
+    [R3D_PROFILE_BLOOM]         = "Bloom",
+    [R3D_PROFILE_OUTPUT]        = "Output",
+    [R3D_PROFILE_ANTI_ALIASING] = "Anti-Aliasing",
+};
+
+static float elapsed_ms(GLuint begin, GLuint end)
+{
+    GLuint64 t0 = 0, t1 = 0;
+    glGetQueryObjectui64v(begin, GL_QUERY_RESULT, &t0);
+    glGetQueryObjectui64v(end, GL_QUERY_RESULT, &t1);
+    return (t1 > t0) ? (float)((double)(t1 - t0) * 1e-6) : 0.0f;
+}
+
+/*
+ * Reads back a frame whose last query is available, the earlier ones are then available too.
+ * Returns false if the frame is still in flight.
+ */
+static bool read_frame(r3d_profile_frame_t* frame)
+{
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame->frameEnd, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    R3D_FrameProfile* result = &R3D_MOD_PROFILE.result;
+
+    for (int i = 0; i < R3D_PROFILE_PASS_COUNT; i++) {
+        result->passTime[i] = frame->executed[i] ? elapsed_ms(frame->begin[i], frame->end[i]) : 0.0f;
+    }
+
+    result->totalTime = elapsed_ms(frame->frameBegin, frame->frameEnd);
+    result->frame = frame->frame;
+    result->valid = true;
+
+    frame->pending = false;
+
+    return true;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_profile_init(void)
+{
+    memset(&R3D_MOD_PROFILE, 0, sizeof(R3D_MOD_PROFILE));
+    R3D_MOD_PROFILE.debugGroups = GLAD_GL_VERSION_4_3;
+
+    return true;
+}
+
+void r3d_profile_quit(void)
+{
+    if (!R3D_MOD_PROFILE.created) {
+        return;
+    }
+
+    for (int i = 0; i < R3D_PROFILE_FRAMES; i++) {
+        r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[i];
+        glDeleteQueries(R3D_PROFILE_PASS_COUNT, frame->begin);
+        glDeleteQueries(R3D_PROFILE_PASS_COUNT, frame->end);
+        glDeleteQueries(1, &frame->frameBegin);
+        glDeleteQueries(1, &frame->frameEnd);
+    }
+}
+
+void r3d_profile_begin_frame(bool enabled)
+{
+    uint32_t counter = R3D_MOD_PROFILE.frameCounter++;
+
+    R3D_MOD_PROFILE.measuring = false;
+
+    if (!enabled) {
+        return;
+    }
+
+    if (!R3D_MOD_PROFILE.created) {
+        for (int i = 0; i < R3D_PROFILE_FRAMES; i++) {
+            r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[i];
+            glGenQueries(R3D_PROFILE_PASS_COUNT, frame->begin);
+            glGenQueries(R3D_PROFILE_PASS_COUNT, frame->end);
+            glGenQueries(1, &frame->frameBegin);
+            glGenQueries(1, &frame->frameEnd);
+        }
+        R3D_MOD_PROFILE.created = true;
+    }
+
+    /* --- Read back the completed frames, oldest first --- */
+
+    for (int i = 1; i <= R3D_PROFILE_FRAMES; i++) {
+        r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[(R3D_MOD_PROFILE.frameIndex + i) % R3D_PROFILE_FRAMES];
+        if (frame->pending && !read_frame(frame)) break;
+    }
+
+    /* --- Measure the current frame if its queries are free --- */
+
+    R3D_MOD_PROFILE.frameIndex = (R3D_MOD_PROFILE.frameIndex + 1) % R3D_PROFILE_FRAMES;
+    r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[R3D_MOD_PROFILE.frameIndex];
+
+    if (frame->pending) {
+        return;
+    }
+
+    memset(frame->executed, 0, sizeof(frame->executed));
+    frame->frame = counter;
+
+    glQueryCounter(frame->frameBegin, GL_TIMESTAMP);
+    R3D_MOD_PROFILE.measuring = true;
+}
+
+void r3d_profile_end_frame(bool publish)
+{
+    if (publish) {
+        R3D_MOD_PROFILE.lastStats = R3D_MOD_PROFILE.stats;
+        memset(&R3D_MOD_PROFILE.stats, 0, sizeof(R3D_MOD_PROFILE.stats));
+    }
+
+    if (!R3D_MOD_PROFILE.measuring) {
+        return;
+    }
+
+    r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[R3D_MOD_PROFILE.frameIndex];
+
+    glQueryCounter(frame->frameEnd, GL_TIMESTAMP);
+    frame->pending = true;
+
+    R3D_MOD_PROFILE.measuring = false;
+}
+
+void r3d_profile_begin(R3D_ProfilePass pass)
+{
+    R3D_MOD_PROFILE.passStart[pass] = GetTime();
+
+    if (!R3D_MOD_PROFILE.measuring) {
+        return;
+    }
+
+    r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[R3D_MOD_PROFILE.frameIndex];
+    if (frame->executed[pass]) {
+        return;
+    }
+
+    if (R3D_MOD_PROFILE.debugGroups) {
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, (GLuint)pass, -1, PASS_NAMES[pass]);
+    }
+
+    glQueryCounter(frame->begin[pass], GL_TIMESTAMP);
+}
+
+void r3d_profile_end(R3D_ProfilePass pass)
+{
+    R3D_MOD_PROFILE.stats.passTime[pass] += r3d_profile_elapsed_ms(R3D_MOD_PROFILE.passStart[pass]);
+
+    if (!R3D_MOD_PROFILE.measuring) {
+        return;
+    }
+
+    r3d_profile_frame_t* frame = &R3D_MOD_PROFILE.frames[R3D_MOD_PROFILE.frameIndex];
+    if (frame->executed[pass]) {
+        return;
+    }
+
+    glQueryCounter(frame->end[pass], GL_TIMESTAMP);
+    frame->executed[pass] = true;
+
+    if (R3D_MOD_PROFILE.debugGroups) {
+        glPopDebugGroup();
+    }
+}
+
+const char* r3d_profile_get_pass_name(R3D_ProfilePass pass)
+{
+    if (pass < 0 || pass >= R3D_PROFILE_PASS_COUNT) {
+        return "Unknown";
+    }
+    return PASS_NAMES[pass];
+}
@@ -0,0 +1,132 @@
+/* r3d_profile.h -- Internal R3D profiling module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_PROFILE_H
+#define R3D_MODULE_PROFILE_H
+
+#include <r3d/r3d_profile.h>
+#include <raylib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <glad.h>
+
+// ========================================
+// HELPER MACROS
+// ========================================
+
+/*
+ * Adds to a counter of the frame being rendered, see 'R3D_FrameStats'.
+ */
+#define R3D_PROFILE_COUNT(counter, n) \
+    (R3D_MOD_PROFILE.stats.counter += (n))
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_PROFILE_FRAMES  3   //< Frames that can be in flight, the queries of a frame still pending are not reused
+
+// ========================================
+// PROFILE STRUCTURES
+// ========================================
+
+/*
+ * Timestamp queries of one frame.
+ * Each pass has a begin and an end query, only the passes executed are read back.
+ */
+typedef struct {
+    GLuint begin[R3D_PROFILE_PASS_COUNT];
+    GLuint end[R3D_PROFILE_PASS_COUNT];
+    GLuint frameBegin, frameEnd;
+    bool executed[R3D_PROFILE_PASS_COUNT];  //< The pass has been measured during the frame
+    uint32_t frame;                         //< Index of the frame measured
+    bool pending;                           //< The queries have been issued and not read back yet
+} r3d_profile_frame_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the profiling module.
+ * The queries are created on the first frame profiled.
+ */
+extern struct r3d_profile {
+
+    r3d_profile_frame_t frames[R3D_PROFILE_FRAMES]; //< Ring of frames in flight
+    int frameIndex;                                 //< Frame of the ring written by the current frame
+    uint32_t frameCounter;                          //< Frames begun since the initialization
+
+    R3D_FrameProfile result;                        //< Timings of the last frame read back
+
+    R3D_FrameStats stats;                           //< Counters of the frame being rendered
+    R3D_FrameStats lastStats;                       //< Counters of the last frame rendered
+    double passStart[R3D_PROFILE_PASS_COUNT];       //< CPU time at the beginning of each pass, in seconds
+
+    bool created;                                   //< The queries exist
+    bool measuring;                                 //< The current frame is measured
+    bool debugGroups;                               //< Debug groups are available (OpenGL 4.3)
+
+} R3D_MOD_PROFILE;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_profile_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_profile_quit(void);
+
+/*
+ * Reads back the frames completed, then starts measuring the current one if enabled.
+ * The frame is skipped when its queries are still in flight, the GPU is never waited for.
+ */
+void r3d_profile_begin_frame(bool enabled);
+
+/*
+ * Ends the GPU measure of the frame.
+ * The counters are kept as the last frame and reset if 'publish' is true,
+ * otherwise they keep accumulating into the next frame.
+ */
+void r3d_profile_end_frame(bool publish);
+
+/*
+ * Measures the CPU time of a pass, then measures it on the GPU and labels it as a debug group.
+ * The CPU time is always recorded, the GPU is measured at most once per pass and per frame,
+ * and not at all when the frame is not measured.
+ */
+void r3d_profile_begin(R3D_ProfilePass pass);
+
+void r3d_profile_end(R3D_ProfilePass pass);
+
+/*
+ * Returns the name of a pass, also used as its debug group label.
+ */
+const char* r3d_profile_get_pass_name(R3D_ProfilePass pass);
+
+// ========================================
+// INLINE FUNCTIONS
+// ========================================
+
+/*
+ * Returns the CPU time elapsed since 'start', given by `GetTime()`, in milliseconds.
+ */
+static inline float r3d_profile_elapsed_ms(double start)
+{
+    return (float)((GetTime() - start) * 1000.0);
+}
+
+#endif // R3D_MODULE_PROFILE_H
@@ -0,0 +1,479 @@
+/* r3d_scene.c -- Internal R3D scene module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_scene.h"
+#include <r3d/r3d_material.h>
+#include <raymath.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./r3d_cache.h"
+#include "./r3d_light.h"
+#include "./r3d_draw.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_scene R3D_MOD_SCENE;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static bool growth_arrays(void)
+{
+    int newCapacity = 2 * R3D_MOD_SCENE.capacity;
+
+    r3d_scene_object_t* newObjects = RL_REALLOC(R3D_MOD_SCENE.objects, newCapacity * sizeof(*R3D_MOD_SCENE.objects));
+    if (newObjects == NULL) return false;
+    R3D_MOD_SCENE.objects = newObjects;
+
+    R3D_SceneObject* newFree = RL_REALLOC(R3D_MOD_SCENE.freeObjects, newCapacity * sizeof(*R3D_MOD_SCENE.freeObjects));
+    if (newFree == NULL) return false;
+    R3D_MOD_SCENE.freeObjects = newFree;
+
+    R3D_SceneObject* newUnbounded = RL_REALLOC(R3D_MOD_SCENE.unboundedObjects, newCapacity * sizeof(*R3D_MOD_SCENE.unboundedObjects));
+    if (newUnbounded == NULL) return false;
+    R3D_MOD_SCENE.unboundedObjects = newUnbounded;
+
+    R3D_MOD_SCENE.capacity = newCapacity;
+
+    return true;
+}
+
+static const BoundingBox* get_object_aabb(const r3d_scene_object_t* object)
+{
+    return object->model ? &object->model->aabb : &object->mesh->aabb;
+}
+
+static inline R3D_SceneObject get_object_id(const r3d_scene_object_t* object)
+{
+    return (R3D_SceneObject)(object - R3D_MOD_SCENE.objects);
+}
+
+static inline bool is_object_bounded(const r3d_scene_object_t* object)
+{
+    return object->extent.x < R3D_FRUSTUM_INFINITE_EXTENT;
+}
+
+static inline BoundingBox get_object_world_box(const r3d_scene_object_t* object)
+{
+    return (BoundingBox) {
+        Vector3Subtract(object->center, object->extent),
+        Vector3Add(object->center, object->extent)
+    };
+}
+
+static bool link_object(r3d_scene_object_t* object)
+{
+    if (!is_object_bounded(object)) {
+        object->unboundedIndex = R3D_MOD_SCENE.numUnbounded++;
+        R3D_MOD_SCENE.unboundedObjects[object->unboundedIndex] = get_object_id(object);
+        return true;
+    }
+
+    BoundingBox box = get_object_world_box(object);
+    object->leaf = r3d_bvh_insert(&R3D_MOD_SCENE.bvh, &box, get_object_id(object));
+
+    return object->leaf >= 0;
+}
+
+static void unlink_object(r3d_scene_object_t* object)
+{
+    if (object->leaf >= 0) {
+        r3d_bvh_remove(&R3D_MOD_SCENE.bvh, object->leaf);
+        object->leaf = -1;
+        return;
+    }
+
+    if (object->unboundedIndex < 0) {
+        return;
+    }
+
+    // Swap the last unbounded object in the removed slot
+    int lastIndex = --R3D_MOD_SCENE.numUnbounded;
+    if (object->unboundedIndex != lastIndex) {
+        R3D_SceneObject lastId = R3D_MOD_SCENE.unboundedObjects[lastIndex];
+        R3D_MOD_SCENE.unboundedObjects[object->unboundedIndex] = lastId;
+        R3D_MOD_SCENE.objects[lastId].unboundedIndex = object->unboundedIndex;
+    }
+
+    object->unboundedIndex = -1;
+}
+
+static void submit_model(const r3d_scene_object_t* object)
+{
+    const R3D_Model* model = object->model;
+
+    r3d_draw_group_t drawGroup = {0};
+
+    drawGroup.aabb = model->aabb;
+    drawGroup.transform = object->transform;
+    drawGroup.skeleton = model->skeleton;
+    drawGroup.player = model->player;
+    drawGroup.staticCaster = object->isStatic;
+
+    r3d_draw_group_push_bounded(&drawGroup, object->center, object->extent);
+
+    for (int i = 0; i < model->meshCount; i++)
+    {
+        const R3D_Mesh* mesh = &model->meshes[i];
+
+        if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+            continue;
+        }
+
+        r3d_draw_call_t drawCall = {0};
+        drawCall.mesh = *mesh;
+
+        const R3D_Material* material = object->overrideMaterial
+            ? &object->material : &model->materials[model->meshMaterials[i]];
+
+        r3d_draw_call_push_retained(&drawCall, material, false);
+    }
+}
+
+static void submit_mesh(const r3d_scene_object_t* object)
+{
+    const R3D_Mesh* mesh = object->mesh;
+
+    if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+        return;
+    }
+
+    r3d_draw_group_t drawGroup = {0};
+
+    drawGroup.aabb = mesh->aabb;
+    drawGroup.transform = object->transform;
+    drawGroup.staticCaster = object->isStatic;
+
+    r3d_draw_group_push_bounded(&drawGroup, object->center, object->extent);
+
+    r3d_draw_call_t drawCall = {0};
+    drawCall.mesh = *mesh;
+
+    r3d_draw_call_push_retained(&drawCall, &object->material, false);
+}
+
+static void submit_object(int32_t id, void* user)
+{
+    r3d_scene_object_t* object = &R3D_MOD_SCENE.objects[id];
+
+    // The shadow views keeping their static cache only need the dynamic objects
+    bool dynamicOnly = (user != NULL) && *(const bool*)user;
+    if (dynamicOnly && object->isStatic) {
+        return;
+    }
+
+    // Objects found in several frustums are only pushed once
+    if (object->frame == R3D_MOD_SCENE.frame) {
+        return;
+    }
+
+    int groupIndex = R3D_MOD_DRAW.numGroups;
+
+    if (object->model) submit_model(object);
+    else submit_mesh(object);
+
+    object->frame = R3D_MOD_SCENE.frame;
+    object->groupIndex = (R3D_MOD_DRAW.numGroups > groupIndex) ? groupIndex : -1;
+}
+
+/*
+ * True if the static casters of all the given views are copied from the cache, without being rendered.
+ */
+static bool is_shadow_view_cached(const r3d_light_t* light, uint8_t viewMask)
+{
+    const r3d_light_shadow_map_t* map = &light->shadowMap;
+    return (map->cacheMask & viewMask) == viewMask && (map->cacheRebuildMask & viewMask) == 0;
+}
+
+static void set_group_visible(int32_t id, void* user)
+{
+    uint32_t* visibility = user;
+
+    const r3d_scene_object_t* object = &R3D_MOD_SCENE.objects[id];
+
+    if (object->frame == R3D_MOD_SCENE.frame && object->groupIndex >= 0) {
+        visibility[object->groupIndex >> 5] |= 1u << (object->groupIndex & 31);
+    }
+}
+
+typedef struct {
+    R3D_SceneObject* objects;
+    int maxObjects;
+    int count;
+} r3d_scene_query_t;
+
+static void gather_object(int32_t id, void* user)
+{
+    r3d_scene_query_t* query = user;
+
+    if (query->count < query->maxObjects) {
+        query->objects[query->count] = id;
+    }
+
+    query->count++;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_scene_init(void)
+{
+    memset(&R3D_MOD_SCENE, 0, sizeof(R3D_MOD_SCENE));
+
+    const int SCENE_RESERVE_COUNT = 64;
+
+    R3D_MOD_SCENE.objects = RL_MALLOC(SCENE_RESERVE_COUNT * sizeof(*R3D_MOD_SCENE.objects));
+    R3D_MOD_SCENE.freeObjects = RL_MALLOC(SCENE_RESERVE_COUNT * sizeof(*R3D_MOD_SCENE.freeObjects));
+    R3D_MOD_SCENE.unboundedObjects = RL_MALLOC(SCENE_RESERVE_COUNT * sizeof(*R3D_MOD_SCENE.unboundedObjects));
+
+    if (!R3D_MOD_SCENE.objects || !R3D_MOD_SCENE.freeObjects || !R3D_MOD_SCENE.unboundedObjects) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init scene module; Object arrays allocation failed");
+        RL_FREE(R3D_MOD_SCENE.objects);
+        RL_FREE(R3D_MOD_SCENE.freeObjects);
+        RL_FREE(R3D_MOD_SCENE.unboundedObjects);
+        return false;
+    }
+
+    if (!r3d_bvh_create(&R3D_MOD_SCENE.bvh, 2 * SCENE_RESERVE_COUNT)) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init scene module; BVH allocation failed");
+        RL_FREE(R3D_MOD_SCENE.objects);
+        RL_FREE(R3D_MOD_SCENE.freeObjects);
+        RL_FREE(R3D_MOD_SCENE.unboundedObjects);
+        return false;
+    }
+
+    R3D_MOD_SCENE.capacity = SCENE_RESERVE_COUNT;
+
+    return true;
+}
+
+void r3d_scene_quit(void)
+{
+    RL_FREE(R3D_MOD_SCENE.objects);
+    RL_FREE(R3D_MOD_SCENE.freeObjects);
+    RL_FREE(R3D_MOD_SCENE.unboundedObjects);
+
+    r3d_bvh_destroy(&R3D_MOD_SCENE.bvh);
+}
+
+R3D_SceneObject r3d_scene_new(const R3D_Model* model, const R3D_Mesh* mesh, Matrix transform)
+{
+    R3D_SceneObject id;
+
+    if (R3D_MOD_SCENE.numFree > 0) {
+        id = R3D_MOD_SCENE.freeObjects[--R3D_MOD_SCENE.numFree];
+    }
+    else {
+        if (R3D_MOD_SCENE.numObjects >= R3D_MOD_SCENE.capacity) {
+            if (!growth_arrays()) {
+                TraceLog(LOG_FATAL, "R3D: Bad alloc on scene object creation");
+                return -1;
+            }
+        }
+        id = R3D_MOD_SCENE.numObjects++;
+    }
+
+    r3d_scene_object_t* object = &R3D_MOD_SCENE.objects[id];
+    memset(object, 0, sizeof(*object));
+
+    object->model = model;
+    object->mesh = mesh;
+    object->material = R3D_GetDefaultMaterial();
+    object->leaf = -1;
+    object->unboundedIndex = -1;
+    object->groupIndex = -1;
+    object->frame = R3D_MOD_SCENE.frame - 1;
+    object->valid = true;
+
+    r3d_scene_set_transform(object, transform);
+    r3d_scene_set_active(object, true);
+
+    return id;
+}
+
+void r3d_scene_delete(R3D_SceneObject id)
+{
+    r3d_scene_object_t* object = r3d_scene_get(id);
+    if (object == NULL) return;
+
+    r3d_scene_set_active(object, false);
+    r3d_scene_set_static(object, false);
+    object->valid = false;
+
+    R3D_MOD_SCENE.freeObjects[R3D_MOD_SCENE.numFree++] = id;
+}
+
+r3d_scene_object_t* r3d_scene_get(R3D_SceneObject id)
+{
+    if (id < 0 || id >= R3D_MOD_SCENE.numObjects) {
+        return NULL;
+    }
+
+    r3d_scene_object_t* object = &R3D_MOD_SCENE.objects[id];
+
+    return object->valid ? object : NULL;
+}
+
+void r3d_scene_set_active(r3d_scene_object_t* object, bool active)
+{
+    if (active == object->active) {
+        return;
+    }
+
+    if (object->isStatic) {
+        R3D_MOD_SCENE.staticRevision++;
+    }
+
+    if (!active) {
+        unlink_object(object);
+        object->active = false;
+        return;
+    }
+
+    if (!link_object(object)) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on scene object activation");
+        return;
+    }
+
+    object->active = true;
+}
+
+void r3d_scene_set_static(r3d_scene_object_t* object, bool isStatic)
+{
+    if (isStatic == object->isStatic) {
+        return;
+    }
+
+    // The caches hold the object until it is no longer static
+    R3D_MOD_SCENE.staticRevision++;
+    R3D_MOD_SCENE.numStatic += isStatic ? 1 : -1;
+
+    object->isStatic = isStatic;
+}
+
+void r3d_scene_touch_static(const r3d_scene_object_t* object)
+{
+    if (object->isStatic && object->active) {
+        R3D_MOD_SCENE.staticRevision++;
+    }
+}
+
+void r3d_scene_set_transform(r3d_scene_object_t* object, Matrix transform)
+{
+    bool wasBounded = is_object_bounded(object);
+
+    object->transform = transform;
+
+    r3d_frustum_get_world_box(
+        get_object_aabb(object), &transform,
+        &object->center, &object->extent
+    );
+
+    if (!object->active) {
+        return;
+    }
+
+    r3d_scene_touch_static(object);
+
+    /* --- Refit the leaf in place, or move the object between the BVH and the unbounded list --- */
+
+    if (wasBounded && is_object_bounded(object)) {
+        BoundingBox box = get_object_world_box(object);
+        r3d_bvh_move(&R3D_MOD_SCENE.bvh, object->leaf, &box);
+        return;
+    }
+
+    unlink_object(object);
+
+    if (!link_object(object)) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on scene object transform update");
+        object->active = false;
+    }
+}
+
+void r3d_scene_submit(const r3d_frustum_t* viewFrustums, int numViews)
+{
+    R3D_MOD_SCENE.frame++;
+    R3D_MOD_SCENE.firstGroup = R3D_MOD_DRAW.numGroups;
+
+    /* --- Objects without bounds are always submitted --- */
+
+    for (int i = 0; i < R3D_MOD_SCENE.numUnbounded; i++) {
+        submit_object(R3D_MOD_SCENE.unboundedObjects[i], NULL);
+    }
+
+    /* --- Submit the objects seen by the cameras and by the shadows rendered this frame --- */
+
+    if (viewFrustums == NULL) {
+        r3d_bvh_query_frustum(&R3D_MOD_SCENE.bvh, NULL, submit_object, NULL);
+    }
+    else {
+        for (int i = 0; i < numViews; i++) {
+            r3d_bvh_query_frustum(&R3D_MOD_SCENE.bvh, &viewFrustums[i], submit_object, NULL);
+        }
+
+        R3D_LIGHT_FOR_EACH_VISIBLE(light)
+        {
+            if (!r3d_light_has_shadow_tiles(light) || !r3d_light_shadow_should_be_upadted(light, false)) {
+                continue;
+            }
+
+            // The faces of omni lights are rendered in a single pass, culled within the light volume
+            if (light->type == R3D_LIGHT_OMNI) {
+                bool dynamicOnly = is_shadow_view_cached(light, light->state.viewMask);
+                r3d_bvh_query_frustum(&R3D_MOD_SCENE.bvh, &light->volumeFrustum, submit_object, &dynamicOnly);
+                continue;
+            }
+
+            int numShadowViews = r3d_light_get_shadow_views(light);
+            for (int iView = 0; iView < numShadowViews; iView++) {
+                if (!r3d_light_is_shadow_view_updated(light, iView)) {
+                    continue;
+                }
+                // The static casters rendered in the cache are not cropped to the view, the cache outlives it
+                bool dynamicOnly = is_shadow_view_cached(light, 1 << iView);
+                const r3d_frustum_t* frustum = r3d_light_rebuilds_shadow_cache(light, iView)
+                    ? &light->frustum[iView] : &light->casterFrustum[iView];
+                r3d_bvh_query_frustum(&R3D_MOD_SCENE.bvh, frustum, submit_object, &dynamicOnly);
+            }
+        }
+    }
+
+    R3D_MOD_SCENE.numGroups = R3D_MOD_DRAW.numGroups - R3D_MOD_SCENE.firstGroup;
+}
+
+void r3d_scene_cull_groups(const r3d_frustum_t* frustum, uint32_t* visibility)
+{
+    if (R3D_MOD_SCENE.numGroups == 0) {
+        return;
+    }
+
+    for (int i = 0; i < R3D_MOD_SCENE.numUnbounded; i++) {
+        set_group_visible(R3D_MOD_SCENE.unboundedObjects[i], visibility);
+    }
+
+    r3d_bvh_query_frustum(&R3D_MOD_SCENE.bvh, frustum, set_group_visible, visibility);
+}
+
+int r3d_scene_query_box(const BoundingBox* box, R3D_SceneObject* objects, int maxObjects)
+{
+    r3d_scene_query_t query = {
+        .objects = objects,
+        .maxObjects = (objects != NULL) ? maxObjects : 0,
+        .count = 0
+    };
+
+    r3d_bvh_query_box(&R3D_MOD_SCENE.bvh, box, gather_object, &query);
+
+    return query.count;
+}
@@ -0,0 +1,151 @@
+/* r3d_scene.h -- Internal R3D scene module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_SCENE_H
+#define R3D_MODULE_SCENE_H
+
+#include <r3d/r3d_scene.h>
+#include <raylib.h>
+#include <stdint.h>
+
+#include "../details/r3d_frustum.h"
+#include "../details/r3d_bvh.h"
+
+// ========================================
+// SCENE STRUCTURES
+// ========================================
+
+/*
+ * Retained object, either a referenced model or a referenced mesh.
+ * The world box is computed when the transform changes and reused every frame.
+ * Active objects with bounds live in the BVH, the others in the unbounded list.
+ */
+typedef struct {
+    const R3D_Model* model;             //< Model drawn by the object, NULL for a mesh object
+    const R3D_Mesh* mesh;               //< Mesh drawn by the object, NULL for a model object
+    R3D_Material material;              //< Material of a mesh object, or override of a model object
+    bool overrideMaterial;              //< True if the material replaces the materials of the model
+    Matrix transform;                   //< World transform of the object
+    Vector3 center;                     //< Center of the world box
+    Vector3 extent;                     //< Half extents of the world box
+    int leaf;                           //< Leaf of the object in the BVH, negative if not inserted
+    int unboundedIndex;                 //< Index in the unbounded list, negative if not listed
+    int groupIndex;                     //< Draw group pushed for the object, valid if 'frame' is current
+    uint32_t frame;                     //< Last frame the object has been submitted
+    bool active;                        //< True if the object is submitted by `R3D_End()`
+    bool isStatic;                      //< True if the shadow of the object is cached by the lights
+    bool valid;                         //< False once the object has been destroyed
+} r3d_scene_object_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the scene module.
+ * Destroyed slots are recycled through the free list. Only the active objects
+ * are indexed, so the submission never visits hidden ones, and only the objects
+ * found in the view or in a shadow frustum are pushed to the draw module.
+ */
+extern struct r3d_scene {
+
+    r3d_scene_object_t* objects;        //< Pool of objects, indexed by their ID
+    int numObjects;                     //< Number of slots ever used in the pool
+    int capacity;                       //< Allocated capacity of all arrays
+
+    R3D_SceneObject* freeObjects;       //< IDs of destroyed objects available for reuse
+    int numFree;                        //< Number of IDs in the free list
+
+    r3d_bvh_t bvh;                      //< Hierarchy over the world boxes of the active bounded objects
+    R3D_SceneObject* unboundedObjects;  //< Active objects without bounds, always submitted
+    int numUnbounded;                   //< Number of active objects without bounds
+
+    int numStatic;                      //< Number of existing static objects, the shadow caches are only used with some
+    uint32_t staticRevision;            //< Incremented whenever a static object changes, invalidates the shadow caches
+
+    uint32_t frame;                     //< Incremented by each submission
+    int firstGroup;                     //< First draw group pushed by the last submission
+    int numGroups;                      //< Number of draw groups pushed by the last submission
+
+} R3D_MOD_SCENE;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_scene_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_scene_quit(void);
+
+/*
+ * Allocates a new active object, returns a negative ID on failure.
+ * Exactly one of the model or the mesh must be given.
+ */
+R3D_SceneObject r3d_scene_new(const R3D_Model* model, const R3D_Mesh* mesh, Matrix transform);
+
+/*
+ * Releases an object, its ID may be returned again by a later creation.
+ */
+void r3d_scene_delete(R3D_SceneObject id);
+
+/*
+ * Returns the object of a valid ID, or NULL.
+ */
+r3d_scene_object_t* r3d_scene_get(R3D_SceneObject id);
+
+/*
+ * Adds or removes an object from the spatial index.
+ */
+void r3d_scene_set_active(r3d_scene_object_t* object, bool active);
+
+/*
+ * Sets the transform of an object, recomputes its world box and refits the BVH.
+ */
+void r3d_scene_set_transform(r3d_scene_object_t* object, Matrix transform);
+
+/*
+ * Marks an object as static or dynamic. The shadows of static objects are cached by the lights.
+ */
+void r3d_scene_set_static(r3d_scene_object_t* object, bool isStatic);
+
+/*
+ * Invalidates the cached shadows if the object is static and active, must be called when its drawing changes.
+ */
+void r3d_scene_touch_static(const r3d_scene_object_t* object);
+
+/*
+ * Pushes the groups and calls of the active objects to the draw module.
+ * Only the objects inside one of the 'numViews' view frustums, or inside the frustum of a shadow
+ * updated this frame, are pushed. NULL view frustums push all active objects.
+ * The static objects are not pushed for the shadow views whose static cache is kept.
+ * Called by `R3D_End()` once the lights have been updated, after the immediate draws.
+ */
+void r3d_scene_submit(const r3d_frustum_t* viewFrustums, int numViews);
+
+/*
+ * Sets the visibility bits of the groups pushed by the last submission
+ * that are inside the frustum, using the BVH instead of testing every group.
+ * The bits of these groups must have been cleared by the caller.
+ */
+void r3d_scene_cull_groups(const r3d_frustum_t* frustum, uint32_t* visibility);
+
+/*
+ * Gathers up to 'maxObjects' active objects whose world box overlaps the given box.
+ * Returns the total number of overlapping objects, which can exceed 'maxObjects'.
+ */
+int r3d_scene_query_box(const BoundingBox* box, R3D_SceneObject* objects, int maxObjects);
+
+#endif // R3D_MODULE_SCENE_H
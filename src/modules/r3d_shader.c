@@ -7,12 +7,16 @@
  */
 
 #include "./r3d_shader.h"
+#include "./r3d_cache.h"
+#include <r3d/r3d_lighting.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
 #include <rlgl.h>
 
+#include "../details/r3d_program_cache.h"
+
 // ========================================
 // SHADER CODE INCLUDES
 // ========================================
@@ -21,34 +25,48 @@
 #include <shaders/screen.vert.h>
 #include <shaders/cubemap.vert.h>
 #include <shaders/bilateral_blur.frag.h>
+#include <shaders/bilateral_blur.comp.h>
 #include <shaders/ssao.frag.h>
+#include <shaders/ssao_temporal.frag.h>
 #include <shaders/ssil.frag.h>
+#include <shaders/ssil_temporal.frag.h>
 #include <shaders/ssr.frag.h>
 #include <shaders/bloom_down.frag.h>
+#include <shaders/bloom_down.comp.h>
 #include <shaders/bloom_up.frag.h>
 #include <shaders/cubemap_from_equirectangular.frag.h>
-#include <shaders/cubemap_irradiance.frag.h>
 #include <shaders/cubemap_prefilter.frag.h>
+#include <shaders/instance_cull.comp.h>
+#include <shaders/particle_update.comp.h>
+#include <shaders/preskin.comp.h>
+#include <shaders/hiz_down.frag.h>
 #include <shaders/geometry.vert.h>
 #include <shaders/geometry.frag.h>
 #include <shaders/forward.vert.h>
 #include <shaders/forward.frag.h>
+#include <shaders/oit_resolve.frag.h>
+#include <shaders/depth_downsample.frag.h>
+#include <shaders/reduced_compose.frag.h>
 #include <shaders/skybox.vert.h>
 #include <shaders/skybox.frag.h>
 #include <shaders/depth.vert.h>
 #include <shaders/depth.frag.h>
 #include <shaders/depth_cube.vert.h>
+#include <shaders/depth_cube.geom.h>
 #include <shaders/depth_cube.frag.h>
 #include <shaders/decal.vert.h>
 #include <shaders/decal.frag.h>
+#include <shaders/decal_clustered.frag.h>
 #include <shaders/ambient.frag.h>
+#include <shaders/lighting.vert.h>
 #include <shaders/lighting.frag.h>
+#include <shaders/lighting_clustered.frag.h>
 #include <shaders/compose.frag.h>
-#include <shaders/bloom.frag.h>
 #include <shaders/fog.frag.h>
 #include <shaders/dof.frag.h>
 #include <shaders/output.frag.h>
 #include <shaders/fxaa.frag.h>
+#include <shaders/taa.frag.h>
 
 // ========================================
 // MODULE STATE
@@ -60,17 +78,36 @@ struct r3d_shader R3D_MOD_SHADER;
 // INTERNAL MACROS
 // ========================================
 
-#define LOAD_SHADER(shader_name, vsCode, fsCode) do {                           \
-    R3D_MOD_SHADER.shader_name.id = load_shader(vsCode, fsCode);                \
+/*
+ * Returns from the loader if the program is not loaded.
+ * During the precompilation, the program is only submitted and the loader is called again once it is ready.
+ */
+#define CHECK_SHADER(shader_name) do {                                          \
     if (R3D_MOD_SHADER.shader_name.id == 0) {                                   \
+        if (R3D_MOD_SHADER.precompile.active) return;                           \
         TraceLog(LOG_ERROR, "R3D: Failed to load shader '" #shader_name "'");   \
         assert(false);                                                          \
         return;                                                                 \
     }                                                                           \
 } while(0)
 
+#define LOAD_SHADER(shader_name, vsCode, fsCode) do {                           \
+    R3D_MOD_SHADER.shader_name.id = load_shader(vsCode, fsCode);                \
+    CHECK_SHADER(shader_name);                                                  \
+} while(0)
+
+#define LOAD_SHADER_GEOMETRY(shader_name, vsCode, gsCode, fsCode) do {          \
+    R3D_MOD_SHADER.shader_name.id = load_shader_geometry(vsCode, gsCode, fsCode);\
+    CHECK_SHADER(shader_name);                                                  \
+} while(0)
+
+#define LOAD_COMPUTE_SHADER(shader_name, csCode) do {                           \
+    R3D_MOD_SHADER.shader_name.id = load_compute_shader(csCode);                \
+    CHECK_SHADER(shader_name);                                                  \
+} while(0)
+
 #define USE_SHADER(shader_name) do {                                            \
-    glUseProgram(R3D_MOD_SHADER.shader_name.id);                                \
+    r3d_state_use_program(R3D_MOD_SHADER.shader_name.id);                       \
 } while(0)                                                                      \
 
 #define GET_LOCATION(shader_name, uniform) do {                                 \
@@ -124,10 +161,28 @@ struct r3d_shader R3D_MOD_SHADER;
     );                                                                          \
 } while(0)
 
+#define SET_SAMPLER_BUFFER(shader_name, uniform, value) do {                    \
+    R3D_MOD_SHADER.shader_name.uniform.slotBuffer = (value);                    \
+    glUniform1i(                                                                \
+        R3D_MOD_SHADER.shader_name.uniform.loc,                                 \
+        R3D_MOD_SHADER.shader_name.uniform.slotBuffer                           \
+    );                                                                          \
+} while(0)
+
+#define SET_SAMPLER_CUBE_ARRAY(shader_name, uniform, value) do {                \
+    R3D_MOD_SHADER.shader_name.uniform.slotCubeArray = (value);                 \
+    glUniform1i(                                                                \
+        R3D_MOD_SHADER.shader_name.uniform.loc,                                 \
+        R3D_MOD_SHADER.shader_name.uniform.slotCubeArray                        \
+    );                                                                          \
+} while(0)
+
 #define SET_UNIFORM_BUFFER(shader_name, uniform, slot) do {                     \
     GLuint idx = glGetUniformBlockIndex(R3D_MOD_SHADER.shader_name.id, #uniform);\
-    glUniformBlockBinding(R3D_MOD_SHADER.shader_name.id, idx, slot);            \
-} while(0)                                                                      \
+    if (idx != GL_INVALID_INDEX) {                                              \
+        glUniformBlockBinding(R3D_MOD_SHADER.shader_name.id, idx, slot);        \
+    }                                                                           \
+} while(0)
 
 #define UNLOAD_SHADER(shader_name) do {                                         \
     if (R3D_MOD_SHADER.shader_name.id != 0) {                                   \
@@ -145,6 +200,13 @@ static char* inject_defines_to_shader_code(const char* code, const char* defines
 // SHADER COMPLING / LINKING FUNCTIONS
 // ========================================
 
+static const char* shader_type_str(GLenum shaderType)
+{
+    return (shaderType == GL_VERTEX_SHADER) ? "vertex"
+        : (shaderType == GL_GEOMETRY_SHADER) ? "geometry"
+        : (shaderType == GL_COMPUTE_SHADER) ? "compute" : "fragment";
+}
+
 static GLuint compile_shader(const char* source, GLenum shaderType)
 {
     GLuint shader = glCreateShader(shaderType);
@@ -161,8 +223,7 @@ static GLuint compile_shader(const char* source, GLenum shaderType)
     if (!success) {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        const char* type_str = (shaderType == GL_VERTEX_SHADER) ? "vertex" : "fragment";
-        TraceLog(LOG_ERROR, "R3D: %s shader compilation failed: %s", type_str, infoLog);
+        TraceLog(LOG_ERROR, "R3D: %s shader compilation failed: %s", shader_type_str(shaderType), infoLog);
         glDeleteShader(shader);
         return 0;
     }
@@ -170,53 +231,160 @@ static GLuint compile_shader(const char* source, GLenum shaderType)
     return shader;
 }
 
-static GLuint link_shader(GLuint vertShader, GLuint fragShader)
+/*
+ * Checks the link status of a program and releases its shaders.
+ * Also reports the compilation errors of the shaders, which are not checked by the precompilation.
+ */
+static GLuint finish_program(GLuint program, const GLuint shaders[], const GLenum types[], int count)
 {
-    GLuint program = glCreateProgram();
-    if (program == 0) {
-        TraceLog(LOG_ERROR, "R3D: Failed to create shader program");
-        return 0;
-    }
-
-    glAttachShader(program, vertShader);
-    glAttachShader(program, fragShader);
-    glLinkProgram(program);
-
     int success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
+
     if (!success) {
         char infoLog[512];
+        for (int i = 0; i < count; i++) {
+            int compiled;
+            glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+            if (!compiled) {
+                glGetShaderInfoLog(shaders[i], 512, NULL, infoLog);
+                TraceLog(LOG_ERROR, "R3D: %s shader compilation failed: %s", shader_type_str(types[i]), infoLog);
+            }
+        }
         glGetProgramInfoLog(program, 512, NULL, infoLog);
         TraceLog(LOG_ERROR, "R3D: Shader program linking failed: %s", infoLog);
         glDeleteProgram(program);
-        return 0;
+        program = 0;
     }
 
-    glDetachShader(program, vertShader);
-    glDetachShader(program, fragShader);
+    for (int i = 0; i < count; i++) {
+        if (program != 0) glDetachShader(program, shaders[i]);
+        glDeleteShader(shaders[i]);
+    }
 
     return program;
 }
 
-GLuint load_shader(const char* vsCode, const char* fsCode)
+/*
+ * Submits the compilation and the link of a program without waiting for them.
+ * With GL_KHR_parallel_shader_compile, the driver compiles it in the background
+ * until `finish_program()` or the completion status is queried.
+ */
+static bool submit_program(uint64_t key, const char* sources[], const GLenum types[], int count)
 {
-    GLuint vs = compile_shader(vsCode, GL_VERTEX_SHADER);
-    if (vs == 0) return 0;
+    if (R3D_MOD_SHADER.precompile.count >= R3D_SHADER_MAX_PRECOMPILE) {
+        return false;
+    }
+
+    r3d_shader_precompile_entry_t* entry = &R3D_MOD_SHADER.precompile.entries[R3D_MOD_SHADER.precompile.count];
+
+    GLuint program = glCreateProgram();
+    if (program == 0) return false;
+
+    for (int i = 0; i < count; i++) {
+        entry->shaders[i] = glCreateShader(types[i]);
+        entry->types[i] = types[i];
+        glShaderSource(entry->shaders[i], 1, &sources[i], NULL);
+        glCompileShader(entry->shaders[i]);
+        glAttachShader(program, entry->shaders[i]);
+    }
+
+    r3d_program_cache_hint(program);
+    glLinkProgram(program);
+
+    entry->key = key;
+    entry->program = program;
+    entry->shaderCount = count;
+    entry->loader = R3D_MOD_SHADER.precompile.loader;
+
+    R3D_MOD_SHADER.precompile.count++;
+
+    return true;
+}
+
+static GLuint load_program(const char* sources[], const GLenum types[], int count)
+{
+    uint64_t key = r3d_program_cache_key(sources, count);
+    GLuint program = 0;
+
+    /* --- Takes the program submitted by the precompilation --- */
+
+    for (int i = 0; i < R3D_MOD_SHADER.precompile.count; i++) {
+        r3d_shader_precompile_entry_t entry = R3D_MOD_SHADER.precompile.entries[i];
+        if (entry.key != key) continue;
+
+        R3D_MOD_SHADER.precompile.entries[i] = R3D_MOD_SHADER.precompile.entries[--R3D_MOD_SHADER.precompile.count];
+
+        program = finish_program(entry.program, entry.shaders, entry.types, entry.shaderCount);
+        if (program != 0) {
+            r3d_program_cache_store(R3D_MOD_CACHE.programCacheDir, key, program);
+        }
+
+        return program;
+    }
+
+    /* --- Loads the binary saved by a previous run --- */
 
-    GLuint fs = compile_shader(fsCode, GL_FRAGMENT_SHADER);
-    if (fs == 0) {
-        glDeleteShader(vs);
+    program = r3d_program_cache_load(R3D_MOD_CACHE.programCacheDir, key);
+    if (program != 0) return program;
+
+    /* --- Compiles the program, in the background during the precompilation --- */
+
+    if (R3D_MOD_SHADER.precompile.active && submit_program(key, sources, types, count)) {
         return 0;
     }
 
-    GLuint program = link_shader(vs, fs);
+    GLuint shaders[3] = { 0 };
+    for (int i = 0; i < count; i++) {
+        shaders[i] = compile_shader(sources[i], types[i]);
+        if (shaders[i] == 0) {
+            for (int j = 0; j < i; j++) glDeleteShader(shaders[j]);
+            return 0;
+        }
+    }
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    program = glCreateProgram();
+    if (program == 0) {
+        TraceLog(LOG_ERROR, "R3D: Failed to create shader program");
+        for (int i = 0; i < count; i++) glDeleteShader(shaders[i]);
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        glAttachShader(program, shaders[i]);
+    }
+
+    r3d_program_cache_hint(program);
+    glLinkProgram(program);
+
+    program = finish_program(program, shaders, types, count);
+    if (program != 0) {
+        r3d_program_cache_store(R3D_MOD_CACHE.programCacheDir, key, program);
+    }
 
     return program;
 }
 
+static GLuint load_shader(const char* vsCode, const char* fsCode)
+{
+    const char* sources[] = { vsCode, fsCode };
+    const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    return load_program(sources, types, 2);
+}
+
+static GLuint load_shader_geometry(const char* vsCode, const char* gsCode, const char* fsCode)
+{
+    const char* sources[] = { vsCode, gsCode, fsCode };
+    const GLenum types[] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+    return load_program(sources, types, 3);
+}
+
+static GLuint load_compute_shader(const char* csCode)
+{
+    const char* sources[] = { csCode };
+    const GLenum types[] = { GL_COMPUTE_SHADER };
+    return load_program(sources, types, 1);
+}
+
 // ========================================
 // SHADER LOADING FUNCTIONS
 // ========================================
@@ -234,6 +402,7 @@ void r3d_shader_load_prepare_ssao(void)
     GET_LOCATION(prepare.ssao, uBias);
     GET_LOCATION(prepare.ssao, uIntensity);
     GET_LOCATION(prepare.ssao, uPower);
+    GET_LOCATION(prepare.ssao, uFrameIndex);
 
     USE_SHADER(prepare.ssao);
 
@@ -245,8 +414,9 @@ void r3d_shader_load_prepare_ssao_blur(void)
 {
     const char* defines[] = {"SSAO"};
     char* fsCode = inject_defines_to_shader_code(BILATERAL_BLUR_FRAG, defines, 1);
-    LOAD_SHADER(prepare.ssaoBlur, SCREEN_VERT, fsCode);
+    R3D_MOD_SHADER.prepare.ssaoBlur.id = load_shader(SCREEN_VERT, fsCode);
     RL_FREE(fsCode);
+    CHECK_SHADER(prepare.ssaoBlur);
 
     SET_UNIFORM_BUFFER(prepare.ssaoBlur, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
 
@@ -262,6 +432,47 @@ void r3d_shader_load_prepare_ssao_blur(void)
     SET_SAMPLER_2D(prepare.ssaoBlur, uTexDepth, 2);
 }
 
+void r3d_shader_load_prepare_ssao_blur_compute(void)
+{
+    const char* defines[] = {"SSAO"};
+    char* csCode = inject_defines_to_shader_code(BILATERAL_BLUR_COMP, defines, 1);
+    R3D_MOD_SHADER.prepare.ssaoBlurCompute.id = load_compute_shader(csCode);
+    RL_FREE(csCode);
+    CHECK_SHADER(prepare.ssaoBlurCompute);
+
+    SET_UNIFORM_BUFFER(prepare.ssaoBlurCompute, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(prepare.ssaoBlurCompute, uTexSource);
+    GET_LOCATION(prepare.ssaoBlurCompute, uTexNormal);
+    GET_LOCATION(prepare.ssaoBlurCompute, uTexDepth);
+
+    USE_SHADER(prepare.ssaoBlurCompute);
+
+    SET_SAMPLER_2D(prepare.ssaoBlurCompute, uTexSource, 0);
+    SET_SAMPLER_2D(prepare.ssaoBlurCompute, uTexNormal, 1);
+    SET_SAMPLER_2D(prepare.ssaoBlurCompute, uTexDepth, 2);
+}
+
+void r3d_shader_load_prepare_ssao_temporal(void)
+{
+    LOAD_SHADER(prepare.ssaoTemporal, SCREEN_VERT, SSAO_TEMPORAL_FRAG);
+
+    SET_UNIFORM_BUFFER(prepare.ssaoTemporal, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(prepare.ssaoTemporal, uTexSource);
+    GET_LOCATION(prepare.ssaoTemporal, uTexHistory);
+    GET_LOCATION(prepare.ssaoTemporal, uTexDepth);
+    GET_LOCATION(prepare.ssaoTemporal, uMatPrevViewProj);
+    GET_LOCATION(prepare.ssaoTemporal, uPrevUvScale);
+    GET_LOCATION(prepare.ssaoTemporal, uHistoryWeight);
+
+    USE_SHADER(prepare.ssaoTemporal);
+
+    SET_SAMPLER_2D(prepare.ssaoTemporal, uTexSource, 0);
+    SET_SAMPLER_2D(prepare.ssaoTemporal, uTexHistory, 1);
+    SET_SAMPLER_2D(prepare.ssaoTemporal, uTexDepth, 2);
+}
+
 void r3d_shader_load_prepare_ssil(void)
 {
     LOAD_SHADER(prepare.ssil, SCREEN_VERT, SSIL_FRAG);
@@ -277,6 +488,9 @@ void r3d_shader_load_prepare_ssil(void)
     GET_LOCATION(prepare.ssil, uHitThickness);
     GET_LOCATION(prepare.ssil, uAoPower);
     GET_LOCATION(prepare.ssil, uEnergy);
+    GET_LOCATION(prepare.ssil, uFrameIndex);
+    GET_LOCATION(prepare.ssil, uPixelOffset);
+    GET_LOCATION(prepare.ssil, uTexelSize);
 
     USE_SHADER(prepare.ssil);
 
@@ -285,12 +499,38 @@ void r3d_shader_load_prepare_ssil(void)
     SET_SAMPLER_2D(prepare.ssil, uTexLight, 2);
 }
 
+void r3d_shader_load_prepare_ssil_temporal(void)
+{
+    LOAD_SHADER(prepare.ssilTemporal, SCREEN_VERT, SSIL_TEMPORAL_FRAG);
+
+    SET_UNIFORM_BUFFER(prepare.ssilTemporal, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(prepare.ssilTemporal, uTexSparse);
+    GET_LOCATION(prepare.ssilTemporal, uTexHistory);
+    GET_LOCATION(prepare.ssilTemporal, uTexHistoryGeometry);
+    GET_LOCATION(prepare.ssilTemporal, uTexDepth);
+    GET_LOCATION(prepare.ssilTemporal, uTexNormal);
+    GET_LOCATION(prepare.ssilTemporal, uMatPrevViewProj);
+    GET_LOCATION(prepare.ssilTemporal, uPrevUvScale);
+    GET_LOCATION(prepare.ssilTemporal, uPixelOffset);
+    GET_LOCATION(prepare.ssilTemporal, uConvergence);
+
+    USE_SHADER(prepare.ssilTemporal);
+
+    SET_SAMPLER_2D(prepare.ssilTemporal, uTexSparse, 0);
+    SET_SAMPLER_2D(prepare.ssilTemporal, uTexHistory, 1);
+    SET_SAMPLER_2D(prepare.ssilTemporal, uTexHistoryGeometry, 2);
+    SET_SAMPLER_2D(prepare.ssilTemporal, uTexDepth, 3);
+    SET_SAMPLER_2D(prepare.ssilTemporal, uTexNormal, 4);
+}
+
 void r3d_shader_load_prepare_ssil_blur(void)
 {
     const char* defines[] = {"SSIL"};
     char* fsCode = inject_defines_to_shader_code(BILATERAL_BLUR_FRAG, defines, 1);
-    LOAD_SHADER(prepare.ssilBlur, SCREEN_VERT, fsCode);
+    R3D_MOD_SHADER.prepare.ssilBlur.id = load_shader(SCREEN_VERT, fsCode);
     RL_FREE(fsCode);
+    CHECK_SHADER(prepare.ssilBlur);
 
     SET_UNIFORM_BUFFER(prepare.ssilBlur, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
 
@@ -306,6 +546,27 @@ void r3d_shader_load_prepare_ssil_blur(void)
     SET_SAMPLER_2D(prepare.ssilBlur, uTexDepth, 2);
 }
 
+void r3d_shader_load_prepare_ssil_blur_compute(void)
+{
+    const char* defines[] = {"SSIL"};
+    char* csCode = inject_defines_to_shader_code(BILATERAL_BLUR_COMP, defines, 1);
+    R3D_MOD_SHADER.prepare.ssilBlurCompute.id = load_compute_shader(csCode);
+    RL_FREE(csCode);
+    CHECK_SHADER(prepare.ssilBlurCompute);
+
+    SET_UNIFORM_BUFFER(prepare.ssilBlurCompute, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(prepare.ssilBlurCompute, uTexSource);
+    GET_LOCATION(prepare.ssilBlurCompute, uTexNormal);
+    GET_LOCATION(prepare.ssilBlurCompute, uTexDepth);
+
+    USE_SHADER(prepare.ssilBlurCompute);
+
+    SET_SAMPLER_2D(prepare.ssilBlurCompute, uTexSource, 0);
+    SET_SAMPLER_2D(prepare.ssilBlurCompute, uTexNormal, 1);
+    SET_SAMPLER_2D(prepare.ssilBlurCompute, uTexDepth, 2);
+}
+
 void r3d_shader_load_prepare_ssr(void)
 {
     LOAD_SHADER(prepare.ssr, SCREEN_VERT, SSR_FRAG);
@@ -317,6 +578,8 @@ void r3d_shader_load_prepare_ssr(void)
     GET_LOCATION(prepare.ssr, uTexNormal);
     GET_LOCATION(prepare.ssr, uTexORM);
     GET_LOCATION(prepare.ssr, uTexDepth);
+    GET_LOCATION(prepare.ssr, uTexHiZ);
+    GET_LOCATION(prepare.ssr, uHiZMaxLevel);
     GET_LOCATION(prepare.ssr, uMaxRaySteps);
     GET_LOCATION(prepare.ssr, uBinarySearchSteps);
     GET_LOCATION(prepare.ssr, uRayMarchLength);
@@ -324,6 +587,7 @@ void r3d_shader_load_prepare_ssr(void)
     GET_LOCATION(prepare.ssr, uDepthTolerance);
     GET_LOCATION(prepare.ssr, uEdgeFadeStart);
     GET_LOCATION(prepare.ssr, uEdgeFadeEnd);
+    GET_LOCATION(prepare.ssr, uRoughnessCutoff);
     GET_LOCATION(prepare.ssr, uAmbientColor);
     GET_LOCATION(prepare.ssr, uAmbientEnergy);
 
@@ -334,12 +598,15 @@ void r3d_shader_load_prepare_ssr(void)
     SET_SAMPLER_2D(prepare.ssr, uTexNormal, 2);
     SET_SAMPLER_2D(prepare.ssr, uTexORM, 3);
     SET_SAMPLER_2D(prepare.ssr, uTexDepth, 4);
+    SET_SAMPLER_2D(prepare.ssr, uTexHiZ, 5);
 }
 
 void r3d_shader_load_prepare_bloom_down(void)
 {
     LOAD_SHADER(prepare.bloomDown, SCREEN_VERT, BLOOM_DOWN_FRAG);
 
+    SET_UNIFORM_BUFFER(prepare.bloomDown, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
     GET_LOCATION(prepare.bloomDown, uTexture);
     GET_LOCATION(prepare.bloomDown, uTexelSize);
     GET_LOCATION(prepare.bloomDown, uPrefilter);
@@ -350,10 +617,25 @@ void r3d_shader_load_prepare_bloom_down(void)
     SET_SAMPLER_2D(prepare.bloomDown, uTexture, 0);
 }
 
+void r3d_shader_load_prepare_bloom_down_compute(void)
+{
+    LOAD_COMPUTE_SHADER(prepare.bloomDownCompute, BLOOM_DOWN_COMP);
+
+    GET_LOCATION(prepare.bloomDownCompute, uTexSource);
+    GET_LOCATION(prepare.bloomDownCompute, uPrefilter);
+    GET_LOCATION(prepare.bloomDownCompute, uLevelCount);
+
+    USE_SHADER(prepare.bloomDownCompute);
+
+    SET_SAMPLER_2D(prepare.bloomDownCompute, uTexSource, 0);
+}
+
 void r3d_shader_load_prepare_bloom_up(void)
 {
     LOAD_SHADER(prepare.bloomUp, SCREEN_VERT, BLOOM_UP_FRAG);
 
+    SET_UNIFORM_BUFFER(prepare.bloomUp, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
     GET_LOCATION(prepare.bloomUp, uTexture);
     GET_LOCATION(prepare.bloomUp, uFilterRadius);
     GET_LOCATION(prepare.bloomUp, uSrcLevel);
@@ -376,19 +658,6 @@ void r3d_shader_load_prepare_cubemap_from_equirectangular(void)
     SET_SAMPLER_2D(prepare.cubemapFromEquirectangular, uTexEquirectangular, 0);
 }
 
-void r3d_shader_load_prepare_cubemap_irradiance(void)
-{
-    LOAD_SHADER(prepare.cubemapIrradiance, CUBEMAP_VERT, CUBEMAP_IRRADIANCE_FRAG);
-
-    GET_LOCATION(prepare.cubemapIrradiance, uMatProj);
-    GET_LOCATION(prepare.cubemapIrradiance, uMatView);
-    GET_LOCATION(prepare.cubemapIrradiance, uCubemap);
-
-    USE_SHADER(prepare.cubemapIrradiance);
-
-    SET_SAMPLER_CUBE(prepare.cubemapIrradiance, uCubemap, 0);
-}
-
 void r3d_shader_load_prepare_cubemap_prefilter(void)
 {
     LOAD_SHADER(prepare.cubemapPrefilter, CUBEMAP_VERT, CUBEMAP_PREFILTER_FRAG);
@@ -404,6 +673,94 @@ void r3d_shader_load_prepare_cubemap_prefilter(void)
     SET_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap, 0);
 }
 
+void r3d_shader_load_prepare_instance_cull(void)
+{
+    LOAD_COMPUTE_SHADER(prepare.instanceCull, INSTANCE_CULL_COMP);
+
+    GET_LOCATION(prepare.instanceCull, uMatModel);
+    GET_LOCATION(prepare.instanceCull, uAabbMin);
+    GET_LOCATION(prepare.instanceCull, uAabbMax);
+    GET_LOCATION(prepare.instanceCull, uInstanceCount);
+    GET_LOCATION(prepare.instanceCull, uInTransformOffset);
+    GET_LOCATION(prepare.instanceCull, uInColorOffset);
+    GET_LOCATION(prepare.instanceCull, uOutTransformOffset);
+    GET_LOCATION(prepare.instanceCull, uOutColorOffset);
+    GET_LOCATION(prepare.instanceCull, uInAnimationOffset);
+    GET_LOCATION(prepare.instanceCull, uOutAnimationOffset);
+    GET_LOCATION(prepare.instanceCull, uCommandOffset);
+    GET_LOCATION(prepare.instanceCull, uParticles);
+
+    for (int i = 0; i < 6; i++) {
+        GET_LOCATION_ARRAY(prepare.instanceCull, uPlanes, i);
+    }
+}
+
+void r3d_shader_load_prepare_particle_update(void)
+{
+    LOAD_COMPUTE_SHADER(prepare.particleUpdate, PARTICLE_UPDATE_COMP);
+
+    GET_LOCATION(prepare.particleUpdate, uDeltaTime);
+    GET_LOCATION(prepare.particleUpdate, uParticleCount);
+    GET_LOCATION(prepare.particleUpdate, uEmitCount);
+    GET_LOCATION(prepare.particleUpdate, uSeed);
+    GET_LOCATION(prepare.particleUpdate, uPosition);
+    GET_LOCATION(prepare.particleUpdate, uGravity);
+    GET_LOCATION(prepare.particleUpdate, uInitialScale);
+    GET_LOCATION(prepare.particleUpdate, uScaleVariance);
+    GET_LOCATION(prepare.particleUpdate, uInitialRotation);
+    GET_LOCATION(prepare.particleUpdate, uRotationVariance);
+    GET_LOCATION(prepare.particleUpdate, uInitialColor);
+    GET_LOCATION(prepare.particleUpdate, uColorVariance);
+    GET_LOCATION(prepare.particleUpdate, uInitialVelocity);
+    GET_LOCATION(prepare.particleUpdate, uVelocityVariance);
+    GET_LOCATION(prepare.particleUpdate, uInitialAngularVelocity);
+    GET_LOCATION(prepare.particleUpdate, uAngularVelocityVariance);
+    GET_LOCATION(prepare.particleUpdate, uLifetime);
+    GET_LOCATION(prepare.particleUpdate, uLifetimeVariance);
+    GET_LOCATION(prepare.particleUpdate, uSpreadAngle);
+    GET_LOCATION(prepare.particleUpdate, uCurveMask);
+    GET_LOCATION(prepare.particleUpdate, uCurveTextureMask);
+    GET_LOCATION(prepare.particleUpdate, uCurves);
+    GET_LOCATION(prepare.particleUpdate, uTexScaleCurve);
+    GET_LOCATION(prepare.particleUpdate, uTexSpeedCurve);
+    GET_LOCATION(prepare.particleUpdate, uTexOpacityCurve);
+    GET_LOCATION(prepare.particleUpdate, uTexAngularVelocityCurve);
+
+    USE_SHADER(prepare.particleUpdate);
+
+    SET_SAMPLER_1D(prepare.particleUpdate, uTexScaleCurve, 0);
+    SET_SAMPLER_1D(prepare.particleUpdate, uTexSpeedCurve, 1);
+    SET_SAMPLER_1D(prepare.particleUpdate, uTexOpacityCurve, 2);
+    SET_SAMPLER_1D(prepare.particleUpdate, uTexAngularVelocityCurve, 3);
+}
+
+void r3d_shader_load_prepare_preskin(void)
+{
+    LOAD_COMPUTE_SHADER(prepare.preskin, PRESKIN_COMP);
+
+    GET_LOCATION(prepare.preskin, uTexBoneMatrices);
+    GET_LOCATION(prepare.preskin, uBoneOffset);
+    GET_LOCATION(prepare.preskin, uVertexCount);
+
+    USE_SHADER(prepare.preskin);
+
+    SET_SAMPLER_BUFFER(prepare.preskin, uTexBoneMatrices, 0);
+}
+
+void r3d_shader_load_prepare_hiz_down(void)
+{
+    LOAD_SHADER(prepare.hizDown, SCREEN_VERT, HIZ_DOWN_FRAG);
+
+    SET_UNIFORM_BUFFER(prepare.hizDown, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(prepare.hizDown, uTexDepth);
+    GET_LOCATION(prepare.hizDown, uFirstLevel);
+
+    USE_SHADER(prepare.hizDown);
+
+    SET_SAMPLER_2D(prepare.hizDown, uTexDepth, 0);
+}
+
 void r3d_shader_load_scene_geometry(void)
 {
     LOAD_SHADER(scene.geometry, GEOMETRY_VERT, GEOMETRY_FRAG);
@@ -420,7 +777,13 @@ void r3d_shader_load_scene_geometry(void)
     GET_LOCATION(scene.geometry, uTexCoordScale);
     GET_LOCATION(scene.geometry, uInstancing);
     GET_LOCATION(scene.geometry, uSkinning);
+    GET_LOCATION(scene.geometry, uBoneOffset);
+    GET_LOCATION(scene.geometry, uBakedAnimation);
     GET_LOCATION(scene.geometry, uBillboard);
+    GET_LOCATION(scene.geometry, uBatchMaterial);
+    GET_LOCATION(scene.geometry, uCompactVertex);
+    GET_LOCATION(scene.geometry, uPositionMin);
+    GET_LOCATION(scene.geometry, uPositionSize);
     GET_LOCATION(scene.geometry, uTexAlbedo);
     GET_LOCATION(scene.geometry, uTexNormal);
     GET_LOCATION(scene.geometry, uTexEmission);
@@ -433,7 +796,7 @@ void r3d_shader_load_scene_geometry(void)
 
     USE_SHADER(scene.geometry);
 
-    SET_SAMPLER_1D(scene.geometry, uTexBoneMatrices, 0);
+    SET_SAMPLER_BUFFER(scene.geometry, uTexBoneMatrices, 0);
     SET_SAMPLER_2D(scene.geometry, uTexAlbedo, 1);
     SET_SAMPLER_2D(scene.geometry, uTexNormal, 2);
     SET_SAMPLER_2D(scene.geometry, uTexEmission, 3);
@@ -445,6 +808,9 @@ void r3d_shader_load_scene_forward(void)
     LOAD_SHADER(scene.forward, FORWARD_VERT, FORWARD_FRAG);
 
     SET_UNIFORM_BUFFER(scene.forward, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+    SET_UNIFORM_BUFFER(scene.forward, LightBlock, R3D_SHADER_UBO_LIGHT_SLOT);
+    SET_UNIFORM_BUFFER(scene.forward, ShadowBlock, R3D_SHADER_UBO_SHADOW_SLOT);
+    SET_UNIFORM_BUFFER(scene.forward, SkyBlock, R3D_SHADER_UBO_SKY_SLOT);
 
     GET_LOCATION(scene.forward, uTexBoneMatrices);
     GET_LOCATION(scene.forward, uMatNormal);
@@ -454,11 +820,17 @@ void r3d_shader_load_scene_forward(void)
     GET_LOCATION(scene.forward, uTexCoordScale);
     GET_LOCATION(scene.forward, uInstancing);
     GET_LOCATION(scene.forward, uSkinning);
+    GET_LOCATION(scene.forward, uBoneOffset);
+    GET_LOCATION(scene.forward, uBakedAnimation);
     GET_LOCATION(scene.forward, uBillboard);
+    GET_LOCATION(scene.forward, uCompactVertex);
+    GET_LOCATION(scene.forward, uPositionMin);
+    GET_LOCATION(scene.forward, uPositionSize);
     GET_LOCATION(scene.forward, uTexAlbedo);
     GET_LOCATION(scene.forward, uTexEmission);
     GET_LOCATION(scene.forward, uTexNormal);
     GET_LOCATION(scene.forward, uTexORM);
+    GET_LOCATION(scene.forward, uTexShadowAtlas);
     GET_LOCATION(scene.forward, uEmissionEnergy);
     GET_LOCATION(scene.forward, uNormalScale);
     GET_LOCATION(scene.forward, uOcclusion);
@@ -466,61 +838,90 @@ void r3d_shader_load_scene_forward(void)
     GET_LOCATION(scene.forward, uMetalness);
     GET_LOCATION(scene.forward, uAmbientColor);
     GET_LOCATION(scene.forward, uEmissionColor);
-    GET_LOCATION(scene.forward, uCubeIrradiance);
     GET_LOCATION(scene.forward, uCubePrefilter);
     GET_LOCATION(scene.forward, uTexBrdfLut);
     GET_LOCATION(scene.forward, uQuatSkybox);
     GET_LOCATION(scene.forward, uHasSkybox);
     GET_LOCATION(scene.forward, uAmbientEnergy);
     GET_LOCATION(scene.forward, uReflectEnergy);
+    GET_LOCATION(scene.forward, uShadowCount);
+    GET_LOCATION(scene.forward, uTexLightClusters);
+    GET_LOCATION(scene.forward, uTexLightIndices);
+    GET_LOCATION(scene.forward, uClusterTileScale);
+    GET_LOCATION(scene.forward, uClusterSlice);
     GET_LOCATION(scene.forward, uAlphaCutoff);
     GET_LOCATION(scene.forward, uViewPosition);
+    GET_LOCATION(scene.forward, uWeightedOIT);
 
     USE_SHADER(scene.forward);
 
-    SET_SAMPLER_1D(scene.forward, uTexBoneMatrices, 0);
+    SET_SAMPLER_BUFFER(scene.forward, uTexBoneMatrices, 0);
     SET_SAMPLER_2D(scene.forward, uTexAlbedo, 1);
     SET_SAMPLER_2D(scene.forward, uTexEmission, 2);
     SET_SAMPLER_2D(scene.forward, uTexNormal, 3);
     SET_SAMPLER_2D(scene.forward, uTexORM, 4);
-    SET_SAMPLER_CUBE(scene.forward, uCubeIrradiance, 5);
     SET_SAMPLER_CUBE(scene.forward, uCubePrefilter, 6);
     SET_SAMPLER_2D(scene.forward, uTexBrdfLut, 7);
+    SET_SAMPLER_BUFFER(scene.forward, uTexLightClusters, 8);
+    SET_SAMPLER_BUFFER(scene.forward, uTexLightIndices, 9);
+    SET_SAMPLER_2D(scene.forward, uTexShadowAtlas, 10);
 
-    int shadowMapSlot = 10;
-    for (int i = 0; i < R3D_SHADER_FORWARD_NUM_LIGHTS; i++)
-    {
-        GET_LOCATION_ARRAY(scene.forward, uMatLightVP, i);
-        GET_LOCATION_ARRAY(scene.forward, uShadowMapCube, i);
-        GET_LOCATION_ARRAY(scene.forward, uShadowMap2D, i);
-
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, color);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, position);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, direction);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, specular);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, energy);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, range);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, near);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, far);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, attenuation);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, innerCutOff);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, outerCutOff);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, shadowSoftness);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, shadowTexelSize);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, shadowDepthBias);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, shadowSlopeBias);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, type);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, enabled);
-        GET_LOCATION_ARRAY_STRUCT(scene.forward, uLights, i, shadow);
-
-        SET_SAMPLER_CUBE(scene.forward, uShadowMapCube[i], shadowMapSlot++);
-        SET_SAMPLER_2D(scene.forward, uShadowMap2D[i], shadowMapSlot++);
+    for (int i = 0; i < R3D_SHADER_FORWARD_BLOCK_SHADOWS; i++) {
+        GET_LOCATION_ARRAY(scene.forward, uShadowIndices, i);
     }
 }
 
+void r3d_shader_load_scene_oit_resolve(void)
+{
+    LOAD_SHADER(scene.oitResolve, SCREEN_VERT, OIT_RESOLVE_FRAG);
+
+    SET_UNIFORM_BUFFER(scene.oitResolve, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(scene.oitResolve, uTexAccum);
+    GET_LOCATION(scene.oitResolve, uTexWeight);
+
+    USE_SHADER(scene.oitResolve);
+
+    SET_SAMPLER_2D(scene.oitResolve, uTexAccum, 0);
+    SET_SAMPLER_2D(scene.oitResolve, uTexWeight, 1);
+}
+
+void r3d_shader_load_scene_depth_downsample(void)
+{
+    LOAD_SHADER(scene.depthDownsample, SCREEN_VERT, DEPTH_DOWNSAMPLE_FRAG);
+
+    SET_UNIFORM_BUFFER(scene.depthDownsample, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(scene.depthDownsample, uTexDepth);
+    GET_LOCATION(scene.depthDownsample, uFactor);
+
+    USE_SHADER(scene.depthDownsample);
+
+    SET_SAMPLER_2D(scene.depthDownsample, uTexDepth, 0);
+}
+
+void r3d_shader_load_scene_reduced_compose(void)
+{
+    LOAD_SHADER(scene.reducedCompose, SCREEN_VERT, REDUCED_COMPOSE_FRAG);
+
+    SET_UNIFORM_BUFFER(scene.reducedCompose, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(scene.reducedCompose, uTexColor);
+    GET_LOCATION(scene.reducedCompose, uTexDepth);
+    GET_LOCATION(scene.reducedCompose, uTexReducedDepth);
+
+    USE_SHADER(scene.reducedCompose);
+
+    SET_SAMPLER_2D(scene.reducedCompose, uTexColor, 0);
+    SET_SAMPLER_2D(scene.reducedCompose, uTexDepth, 1);
+    SET_SAMPLER_2D(scene.reducedCompose, uTexReducedDepth, 2);
+}
+
 void r3d_shader_load_scene_background(void)
 {
     LOAD_SHADER(scene.background, SCREEN_VERT, COLOR_FRAG);
+
+    SET_UNIFORM_BUFFER(scene.background, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
     GET_LOCATION(scene.background, uColor);
 }
 
@@ -552,30 +953,44 @@ void r3d_shader_load_scene_depth(void)
     GET_LOCATION(scene.depth, uAlpha);
     GET_LOCATION(scene.depth, uInstancing);
     GET_LOCATION(scene.depth, uSkinning);
+    GET_LOCATION(scene.depth, uBoneOffset);
+    GET_LOCATION(scene.depth, uBakedAnimation);
     GET_LOCATION(scene.depth, uBillboard);
+    GET_LOCATION(scene.depth, uCompactVertex);
+    GET_LOCATION(scene.depth, uPositionMin);
+    GET_LOCATION(scene.depth, uPositionSize);
     GET_LOCATION(scene.depth, uTexAlbedo);
     GET_LOCATION(scene.depth, uAlphaCutoff);
 
     USE_SHADER(scene.depth);
 
-    SET_SAMPLER_1D(scene.depth, uTexBoneMatrices, 0);
+    SET_SAMPLER_BUFFER(scene.depth, uTexBoneMatrices, 0);
     SET_SAMPLER_2D(scene.depth, uTexAlbedo, 1);
 }
 
 void r3d_shader_load_scene_depth_cube(void)
 {
-    LOAD_SHADER(scene.depthCube, DEPTH_CUBE_VERT, DEPTH_CUBE_FRAG);
+    LOAD_SHADER_GEOMETRY(scene.depthCube, DEPTH_CUBE_VERT, DEPTH_CUBE_GEOM, DEPTH_CUBE_FRAG);
 
     GET_LOCATION(scene.depthCube, uTexBoneMatrices);
     GET_LOCATION(scene.depthCube, uMatInvView);
     GET_LOCATION(scene.depthCube, uMatModel);
-    GET_LOCATION(scene.depthCube, uMatVP);
+    for (int i = 0; i < 6; i++) {
+        GET_LOCATION_ARRAY(scene.depthCube, uMatFaceVP, i);
+        GET_LOCATION_ARRAY(scene.depthCube, uFaceTiles, i);
+    }
+    GET_LOCATION(scene.depthCube, uFaceMask);
     GET_LOCATION(scene.depthCube, uTexCoordOffset);
     GET_LOCATION(scene.depthCube, uTexCoordScale);
     GET_LOCATION(scene.depthCube, uAlpha);
     GET_LOCATION(scene.depthCube, uInstancing);
     GET_LOCATION(scene.depthCube, uSkinning);
+    GET_LOCATION(scene.depthCube, uBoneOffset);
+    GET_LOCATION(scene.depthCube, uBakedAnimation);
     GET_LOCATION(scene.depthCube, uBillboard);
+    GET_LOCATION(scene.depthCube, uCompactVertex);
+    GET_LOCATION(scene.depthCube, uPositionMin);
+    GET_LOCATION(scene.depthCube, uPositionSize);
     GET_LOCATION(scene.depthCube, uTexAlbedo);
     GET_LOCATION(scene.depthCube, uAlphaCutoff);
     GET_LOCATION(scene.depthCube, uViewPosition);
@@ -583,7 +998,7 @@ void r3d_shader_load_scene_depth_cube(void)
 
     USE_SHADER(scene.depthCube);
 
-    SET_SAMPLER_1D(scene.depthCube, uTexBoneMatrices, 0);
+    SET_SAMPLER_BUFFER(scene.depthCube, uTexBoneMatrices, 0);
     SET_SAMPLER_2D(scene.depthCube, uTexAlbedo, 1);
 }
 
@@ -621,14 +1036,43 @@ void r3d_shader_load_scene_decal(void)
     SET_SAMPLER_2D(scene.decal, uTexDepth, 4);
 }
 
+void r3d_shader_load_scene_decal_clustered(void)
+{
+    LOAD_SHADER(scene.decalClustered, SCREEN_VERT, DECAL_CLUSTERED_FRAG);
+
+    SET_UNIFORM_BUFFER(scene.decalClustered, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(scene.decalClustered, uTexAlbedo);
+    GET_LOCATION(scene.decalClustered, uTexEmission);
+    GET_LOCATION(scene.decalClustered, uTexORM);
+    GET_LOCATION(scene.decalClustered, uTexDepth);
+    GET_LOCATION(scene.decalClustered, uTexDecals);
+    GET_LOCATION(scene.decalClustered, uTexDecalTiles);
+    GET_LOCATION(scene.decalClustered, uTexDecalIndices);
+    GET_LOCATION(scene.decalClustered, uTileScale);
+    GET_LOCATION(scene.decalClustered, uTileOffset);
+
+    USE_SHADER(scene.decalClustered);
+
+    SET_SAMPLER_2D(scene.decalClustered, uTexAlbedo, 0);
+    SET_SAMPLER_2D(scene.decalClustered, uTexEmission, 1);
+    SET_SAMPLER_2D(scene.decalClustered, uTexORM, 2);
+    SET_SAMPLER_2D(scene.decalClustered, uTexDepth, 3);
+    SET_SAMPLER_BUFFER(scene.decalClustered, uTexDecals, 4);
+    SET_SAMPLER_BUFFER(scene.decalClustered, uTexDecalTiles, 5);
+    SET_SAMPLER_BUFFER(scene.decalClustered, uTexDecalIndices, 6);
+}
+
 void r3d_shader_load_deferred_ambient_ibl(void)
 {
     const char* defines[] = {"IBL"};
     char* fsCode = inject_defines_to_shader_code(AMBIENT_FRAG, defines, 1);
-    LOAD_SHADER(deferred.ambientIbl, SCREEN_VERT, fsCode);
+    R3D_MOD_SHADER.deferred.ambientIbl.id = load_shader(SCREEN_VERT, fsCode);
     RL_FREE(fsCode);
+    CHECK_SHADER(deferred.ambientIbl);
 
     SET_UNIFORM_BUFFER(deferred.ambientIbl, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+    SET_UNIFORM_BUFFER(deferred.ambientIbl, SkyBlock, R3D_SHADER_UBO_SKY_SLOT);
 
     GET_LOCATION(deferred.ambientIbl, uTexAlbedo);
     GET_LOCATION(deferred.ambientIbl, uTexNormal);
@@ -637,7 +1081,6 @@ void r3d_shader_load_deferred_ambient_ibl(void)
     GET_LOCATION(deferred.ambientIbl, uTexSSIL);
     GET_LOCATION(deferred.ambientIbl, uTexSSR);
     GET_LOCATION(deferred.ambientIbl, uTexORM);
-    GET_LOCATION(deferred.ambientIbl, uCubeIrradiance);
     GET_LOCATION(deferred.ambientIbl, uCubePrefilter);
     GET_LOCATION(deferred.ambientIbl, uTexBrdfLut);
     GET_LOCATION(deferred.ambientIbl, uAmbientEnergy);
@@ -655,15 +1098,58 @@ void r3d_shader_load_deferred_ambient_ibl(void)
     SET_SAMPLER_2D(deferred.ambientIbl, uTexSSR, 5);
     SET_SAMPLER_2D(deferred.ambientIbl, uTexORM, 6);
 
-    SET_SAMPLER_CUBE(deferred.ambientIbl, uCubeIrradiance, 7);
     SET_SAMPLER_CUBE(deferred.ambientIbl, uCubePrefilter, 8);
     SET_SAMPLER_2D(deferred.ambientIbl, uTexBrdfLut, 9);
 }
 
+void r3d_shader_load_deferred_ambient_probes(void)
+{
+    const char* defines[] = {"IBL", "PROBES"};
+    char* fsCode = inject_defines_to_shader_code(AMBIENT_FRAG, defines, 2);
+    R3D_MOD_SHADER.deferred.ambientProbes.id = load_shader(SCREEN_VERT, fsCode);
+    RL_FREE(fsCode);
+    CHECK_SHADER(deferred.ambientProbes);
+
+    SET_UNIFORM_BUFFER(deferred.ambientProbes, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+    SET_UNIFORM_BUFFER(deferred.ambientProbes, SkyBlock, R3D_SHADER_UBO_SKY_SLOT);
+    SET_UNIFORM_BUFFER(deferred.ambientProbes, ProbeBlock, R3D_SHADER_UBO_PROBE_SLOT);
+
+    GET_LOCATION(deferred.ambientProbes, uTexAlbedo);
+    GET_LOCATION(deferred.ambientProbes, uTexNormal);
+    GET_LOCATION(deferred.ambientProbes, uTexDepth);
+    GET_LOCATION(deferred.ambientProbes, uTexSSAO);
+    GET_LOCATION(deferred.ambientProbes, uTexSSIL);
+    GET_LOCATION(deferred.ambientProbes, uTexSSR);
+    GET_LOCATION(deferred.ambientProbes, uTexORM);
+    GET_LOCATION(deferred.ambientProbes, uCubePrefilter);
+    GET_LOCATION(deferred.ambientProbes, uTexBrdfLut);
+    GET_LOCATION(deferred.ambientProbes, uCubeProbes);
+    GET_LOCATION(deferred.ambientProbes, uAmbientEnergy);
+    GET_LOCATION(deferred.ambientProbes, uReflectEnergy);
+    GET_LOCATION(deferred.ambientProbes, uMipCountSSR);
+    GET_LOCATION(deferred.ambientProbes, uQuatSkybox);
+
+    USE_SHADER(deferred.ambientProbes);
+
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexAlbedo, 0);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexNormal, 1);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexDepth, 2);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexSSAO, 3);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexSSIL, 4);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexSSR, 5);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexORM, 6);
+
+    SET_SAMPLER_CUBE(deferred.ambientProbes, uCubePrefilter, 8);
+    SET_SAMPLER_2D(deferred.ambientProbes, uTexBrdfLut, 9);
+    SET_SAMPLER_CUBE_ARRAY(deferred.ambientProbes, uCubeProbes, 10);
+}
+
 void r3d_shader_load_deferred_ambient(void)
 {
     LOAD_SHADER(deferred.ambient, SCREEN_VERT, AMBIENT_FRAG);
 
+    SET_UNIFORM_BUFFER(deferred.ambient, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
     GET_LOCATION(deferred.ambient, uTexAlbedo);
     GET_LOCATION(deferred.ambient, uTexSSAO);
     GET_LOCATION(deferred.ambient, uTexSSIL);
@@ -682,56 +1168,118 @@ void r3d_shader_load_deferred_ambient(void)
     SET_SAMPLER_2D(deferred.ambient, uTexORM, 4);
 }
 
-void r3d_shader_load_deferred_lighting(void)
-{
-    LOAD_SHADER(deferred.lighting, SCREEN_VERT, LIGHTING_FRAG);
-
-    SET_UNIFORM_BUFFER(deferred.lighting, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
-
-    GET_LOCATION(deferred.lighting, uTexAlbedo);
-    GET_LOCATION(deferred.lighting, uTexNormal);
-    GET_LOCATION(deferred.lighting, uTexDepth);
-    GET_LOCATION(deferred.lighting, uTexSSAO);
-    GET_LOCATION(deferred.lighting, uTexORM);
-    GET_LOCATION(deferred.lighting, uSSAOLightAffect);
-
-    GET_LOCATION(deferred.lighting, uLight.matVP);
-    GET_LOCATION(deferred.lighting, uLight.shadowMap);
-    GET_LOCATION(deferred.lighting, uLight.shadowCubemap);
-    GET_LOCATION(deferred.lighting, uLight.color);
-    GET_LOCATION(deferred.lighting, uLight.position);
-    GET_LOCATION(deferred.lighting, uLight.direction);
-    GET_LOCATION(deferred.lighting, uLight.specular);
-    GET_LOCATION(deferred.lighting, uLight.energy);
-    GET_LOCATION(deferred.lighting, uLight.range);
-    GET_LOCATION(deferred.lighting, uLight.near);
-    GET_LOCATION(deferred.lighting, uLight.far);
-    GET_LOCATION(deferred.lighting, uLight.attenuation);
-    GET_LOCATION(deferred.lighting, uLight.innerCutOff);
-    GET_LOCATION(deferred.lighting, uLight.outerCutOff);
-    GET_LOCATION(deferred.lighting, uLight.shadowSoftness);
-    GET_LOCATION(deferred.lighting, uLight.shadowTexelSize);
-    GET_LOCATION(deferred.lighting, uLight.shadowDepthBias);
-    GET_LOCATION(deferred.lighting, uLight.shadowSlopeBias);
-    GET_LOCATION(deferred.lighting, uLight.type);
-    GET_LOCATION(deferred.lighting, uLight.shadow);
-
-    USE_SHADER(deferred.lighting);
-
-    SET_SAMPLER_2D(deferred.lighting, uTexAlbedo, 0);
-    SET_SAMPLER_2D(deferred.lighting, uTexNormal, 1);
-    SET_SAMPLER_2D(deferred.lighting, uTexDepth, 2);
-    SET_SAMPLER_2D(deferred.lighting, uTexSSAO, 3);
-    SET_SAMPLER_2D(deferred.lighting, uTexORM, 4);
-
-    SET_SAMPLER_2D(deferred.lighting, uLight.shadowMap, 5);
-    SET_SAMPLER_CUBE(deferred.lighting, uLight.shadowCubemap, 6);
+static void load_deferred_lighting(int variant)
+{
+    static const char* lightTypes[] = {
+        "LIGHT_TYPE LIGHT_DIR", "LIGHT_TYPE LIGHT_SPOT", "LIGHT_TYPE LIGHT_OMNI"
+    };
+
+    bool shadow = (variant % 2 != 0);
+    const char* defines[] = {lightTypes[variant / 2], "SHADOW"};
+    char* fsCode = inject_defines_to_shader_code(LIGHTING_FRAG, defines, shadow ? 2 : 1);
+    R3D_MOD_SHADER.deferred.lighting[variant].id = load_shader(LIGHTING_VERT, fsCode);
+    RL_FREE(fsCode);
+    CHECK_SHADER(deferred.lighting[variant]);
+
+    SET_UNIFORM_BUFFER(deferred.lighting[variant], ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+    if (shadow) SET_UNIFORM_BUFFER(deferred.lighting[variant], ShadowBlock, R3D_SHADER_UBO_SHADOW_SLOT);
+
+    GET_LOCATION(deferred.lighting[variant], uTexAlbedo);
+    GET_LOCATION(deferred.lighting[variant], uTexNormal);
+    GET_LOCATION(deferred.lighting[variant], uTexDepth);
+    GET_LOCATION(deferred.lighting[variant], uTexSSAO);
+    GET_LOCATION(deferred.lighting[variant], uTexORM);
+    GET_LOCATION(deferred.lighting[variant], uTexShadowAtlas);
+    GET_LOCATION(deferred.lighting[variant], uSSAOLightAffect);
+    GET_LOCATION(deferred.lighting[variant], uMatModel);
+    GET_LOCATION(deferred.lighting[variant], uVolume);
+
+    GET_LOCATION(deferred.lighting[variant], uLight.color);
+    GET_LOCATION(deferred.lighting[variant], uLight.position);
+    GET_LOCATION(deferred.lighting[variant], uLight.direction);
+    GET_LOCATION(deferred.lighting[variant], uLight.specular);
+    GET_LOCATION(deferred.lighting[variant], uLight.energy);
+    GET_LOCATION(deferred.lighting[variant], uLight.range);
+    GET_LOCATION(deferred.lighting[variant], uLight.attenuation);
+    GET_LOCATION(deferred.lighting[variant], uLight.innerCutOff);
+    GET_LOCATION(deferred.lighting[variant], uLight.outerCutOff);
+    GET_LOCATION(deferred.lighting[variant], uLight.shadowIndex);
+
+    USE_SHADER(deferred.lighting[variant]);
+
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexAlbedo, 0);
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexNormal, 1);
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexDepth, 2);
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexSSAO, 3);
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexORM, 4);
+    SET_SAMPLER_2D(deferred.lighting[variant], uTexShadowAtlas, 5);
+}
+
+void r3d_shader_load_deferred_lighting_dir(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_DIR, false));
+}
+
+void r3d_shader_load_deferred_lighting_dir_shadow(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_DIR, true));
+}
+
+void r3d_shader_load_deferred_lighting_spot(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_SPOT, false));
+}
+
+void r3d_shader_load_deferred_lighting_spot_shadow(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_SPOT, true));
+}
+
+void r3d_shader_load_deferred_lighting_omni(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_OMNI, false));
+}
+
+void r3d_shader_load_deferred_lighting_omni_shadow(void)
+{
+    load_deferred_lighting(R3D_SHADER_LIGHTING_VARIANT(R3D_LIGHT_OMNI, true));
+}
+
+void r3d_shader_load_deferred_lighting_clustered(void)
+{
+    LOAD_SHADER(deferred.lightingClustered, SCREEN_VERT, LIGHTING_CLUSTERED_FRAG);
+
+    SET_UNIFORM_BUFFER(deferred.lightingClustered, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+    SET_UNIFORM_BUFFER(deferred.lightingClustered, LightBlock, R3D_SHADER_UBO_LIGHT_SLOT);
+
+    GET_LOCATION(deferred.lightingClustered, uTexAlbedo);
+    GET_LOCATION(deferred.lightingClustered, uTexNormal);
+    GET_LOCATION(deferred.lightingClustered, uTexDepth);
+    GET_LOCATION(deferred.lightingClustered, uTexSSAO);
+    GET_LOCATION(deferred.lightingClustered, uTexORM);
+    GET_LOCATION(deferred.lightingClustered, uTexLightClusters);
+    GET_LOCATION(deferred.lightingClustered, uTexLightIndices);
+    GET_LOCATION(deferred.lightingClustered, uClusterTileScale);
+    GET_LOCATION(deferred.lightingClustered, uClusterSlice);
+    GET_LOCATION(deferred.lightingClustered, uSSAOLightAffect);
+
+    USE_SHADER(deferred.lightingClustered);
+
+    SET_SAMPLER_2D(deferred.lightingClustered, uTexAlbedo, 0);
+    SET_SAMPLER_2D(deferred.lightingClustered, uTexNormal, 1);
+    SET_SAMPLER_2D(deferred.lightingClustered, uTexDepth, 2);
+    SET_SAMPLER_2D(deferred.lightingClustered, uTexSSAO, 3);
+    SET_SAMPLER_2D(deferred.lightingClustered, uTexORM, 4);
+    SET_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightClusters, 5);
+    SET_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightIndices, 6);
 }
 
 void r3d_shader_load_deferred_compose(void)
 {
     LOAD_SHADER(deferred.compose, SCREEN_VERT, COMPOSE_FRAG);
 
+    SET_UNIFORM_BUFFER(deferred.compose, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
     GET_LOCATION(deferred.compose, uTexDiffuse);
     GET_LOCATION(deferred.compose, uTexSpecular);
 
@@ -741,21 +1289,6 @@ void r3d_shader_load_deferred_compose(void)
     SET_SAMPLER_2D(deferred.compose, uTexSpecular, 1);
 }
 
-void r3d_shader_load_post_bloom(void)
-{
-    LOAD_SHADER(post.bloom, SCREEN_VERT, BLOOM_FRAG);
-
-    GET_LOCATION(post.bloom, uTexColor);
-    GET_LOCATION(post.bloom, uTexBloomBlur);
-    GET_LOCATION(post.bloom, uBloomMode);
-    GET_LOCATION(post.bloom, uBloomIntensity);
-
-    USE_SHADER(post.bloom);
-
-    SET_SAMPLER_2D(post.bloom, uTexColor, 0);
-    SET_SAMPLER_2D(post.bloom, uTexBloomBlur, 1);
-}
-
 void r3d_shader_load_post_fog(void)
 {
     LOAD_SHADER(post.fog, SCREEN_VERT, FOG_FRAG);
@@ -796,27 +1329,77 @@ void r3d_shader_load_post_dof(void)
     SET_SAMPLER_2D(post.dof, uTexDepth, 1);
 }
 
+static void load_post_output(int variant)
+{
+    bool fog = (variant & 1) != 0;
+    bool bloom = (variant & 2) != 0;
+
+    const char* defines[2];
+    int defineCount = 0;
+    if (fog) defines[defineCount++] = "FOG";
+    if (bloom) defines[defineCount++] = "BLOOM";
+
+    char* fsCode = inject_defines_to_shader_code(OUTPUT_FRAG, defines, defineCount);
+    R3D_MOD_SHADER.post.output[variant].id = load_shader(SCREEN_VERT, fsCode);
+    RL_FREE(fsCode);
+    CHECK_SHADER(post.output[variant]);
+
+    SET_UNIFORM_BUFFER(post.output[variant], ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(post.output[variant], uTexColor);
+    GET_LOCATION(post.output[variant], uTonemapExposure);
+    GET_LOCATION(post.output[variant], uTonemapWhite);
+    GET_LOCATION(post.output[variant], uTonemapMode);
+    GET_LOCATION(post.output[variant], uBrightness);
+    GET_LOCATION(post.output[variant], uContrast);
+    GET_LOCATION(post.output[variant], uSaturation);
+
+    GET_LOCATION(post.output[variant], uTexDepth);
+    GET_LOCATION(post.output[variant], uFogMode);
+    GET_LOCATION(post.output[variant], uFogColor);
+    GET_LOCATION(post.output[variant], uFogStart);
+    GET_LOCATION(post.output[variant], uFogEnd);
+    GET_LOCATION(post.output[variant], uFogDensity);
+    GET_LOCATION(post.output[variant], uSkyAffect);
+
+    GET_LOCATION(post.output[variant], uTexBloomBlur);
+    GET_LOCATION(post.output[variant], uFilterRadius);
+    GET_LOCATION(post.output[variant], uBloomMode);
+    GET_LOCATION(post.output[variant], uBloomIntensity);
+
+    USE_SHADER(post.output[variant]);
+
+    SET_SAMPLER_2D(post.output[variant], uTexColor, 0);
+    SET_SAMPLER_2D(post.output[variant], uTexDepth, 1);
+    SET_SAMPLER_2D(post.output[variant], uTexBloomBlur, 2);
+}
+
 void r3d_shader_load_post_output(void)
 {
-    LOAD_SHADER(post.output, SCREEN_VERT, OUTPUT_FRAG);
+    load_post_output(R3D_SHADER_OUTPUT_VARIANT(false, false));
+}
 
-    GET_LOCATION(post.output, uTexColor);
-    GET_LOCATION(post.output, uTonemapExposure);
-    GET_LOCATION(post.output, uTonemapWhite);
-    GET_LOCATION(post.output, uTonemapMode);
-    GET_LOCATION(post.output, uBrightness);
-    GET_LOCATION(post.output, uContrast);
-    GET_LOCATION(post.output, uSaturation);
+void r3d_shader_load_post_output_fog(void)
+{
+    load_post_output(R3D_SHADER_OUTPUT_VARIANT(true, false));
+}
 
-    USE_SHADER(post.output);
+void r3d_shader_load_post_output_bloom(void)
+{
+    load_post_output(R3D_SHADER_OUTPUT_VARIANT(false, true));
+}
 
-    SET_SAMPLER_2D(post.output, uTexColor, 0);
+void r3d_shader_load_post_output_fog_bloom(void)
+{
+    load_post_output(R3D_SHADER_OUTPUT_VARIANT(true, true));
 }
 
 void r3d_shader_load_post_fxaa(void)
 {
     LOAD_SHADER(post.fxaa, SCREEN_VERT, FXAA_FRAG);
 
+    SET_UNIFORM_BUFFER(post.fxaa, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
     GET_LOCATION(post.fxaa, uTexture);
     GET_LOCATION(post.fxaa, uTexelSize);
 
@@ -825,6 +1408,152 @@ void r3d_shader_load_post_fxaa(void)
     SET_SAMPLER_2D(post.fxaa, uTexture, 0);
 }
 
+void r3d_shader_load_post_taa(void)
+{
+    LOAD_SHADER(post.taa, SCREEN_VERT, TAA_FRAG);
+
+    SET_UNIFORM_BUFFER(post.taa, ViewBlock, R3D_SHADER_UBO_VIEW_SLOT);
+
+    GET_LOCATION(post.taa, uTexColor);
+    GET_LOCATION(post.taa, uTexDepth);
+    GET_LOCATION(post.taa, uTexHistory);
+    GET_LOCATION(post.taa, uMatPrevViewProj);
+    GET_LOCATION(post.taa, uJitter);
+    GET_LOCATION(post.taa, uHistoryWeight);
+
+    USE_SHADER(post.taa);
+
+    SET_SAMPLER_2D(post.taa, uTexColor, 0);
+    SET_SAMPLER_2D(post.taa, uTexDepth, 1);
+    SET_SAMPLER_2D(post.taa, uTexHistory, 2);
+}
+
+// ========================================
+// PRECOMPILATION
+// ========================================
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#   define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static const struct {
+    r3d_shader_loader_func load;
+    const unsigned int* id;
+    bool compute;               //< Requires OpenGL 4.3
+} PRECOMPILE_LIST[] = {
+    { r3d_shader_load_prepare_ssao, &R3D_MOD_SHADER.prepare.ssao.id, false },
+    { r3d_shader_load_prepare_ssao_blur, &R3D_MOD_SHADER.prepare.ssaoBlur.id, false },
+    { r3d_shader_load_prepare_ssao_blur_compute, &R3D_MOD_SHADER.prepare.ssaoBlurCompute.id, true },
+    { r3d_shader_load_prepare_ssao_temporal, &R3D_MOD_SHADER.prepare.ssaoTemporal.id, false },
+    { r3d_shader_load_prepare_ssil, &R3D_MOD_SHADER.prepare.ssil.id, false },
+    { r3d_shader_load_prepare_ssil_temporal, &R3D_MOD_SHADER.prepare.ssilTemporal.id, false },
+    { r3d_shader_load_prepare_ssil_blur, &R3D_MOD_SHADER.prepare.ssilBlur.id, false },
+    { r3d_shader_load_prepare_ssil_blur_compute, &R3D_MOD_SHADER.prepare.ssilBlurCompute.id, true },
+    { r3d_shader_load_prepare_ssr, &R3D_MOD_SHADER.prepare.ssr.id, false },
+    { r3d_shader_load_prepare_bloom_down, &R3D_MOD_SHADER.prepare.bloomDown.id, false },
+    { r3d_shader_load_prepare_bloom_down_compute, &R3D_MOD_SHADER.prepare.bloomDownCompute.id, true },
+    { r3d_shader_load_prepare_bloom_up, &R3D_MOD_SHADER.prepare.bloomUp.id, false },
+    { r3d_shader_load_prepare_cubemap_from_equirectangular, &R3D_MOD_SHADER.prepare.cubemapFromEquirectangular.id, false },
+    { r3d_shader_load_prepare_cubemap_prefilter, &R3D_MOD_SHADER.prepare.cubemapPrefilter.id, false },
+    { r3d_shader_load_prepare_instance_cull, &R3D_MOD_SHADER.prepare.instanceCull.id, true },
+    { r3d_shader_load_prepare_particle_update, &R3D_MOD_SHADER.prepare.particleUpdate.id, true },
+    { r3d_shader_load_prepare_preskin, &R3D_MOD_SHADER.prepare.preskin.id, true },
+    { r3d_shader_load_prepare_hiz_down, &R3D_MOD_SHADER.prepare.hizDown.id, false },
+    { r3d_shader_load_scene_geometry, &R3D_MOD_SHADER.scene.geometry.id, false },
+    { r3d_shader_load_scene_forward, &R3D_MOD_SHADER.scene.forward.id, false },
+    { r3d_shader_load_scene_oit_resolve, &R3D_MOD_SHADER.scene.oitResolve.id, false },
+    { r3d_shader_load_scene_depth_downsample, &R3D_MOD_SHADER.scene.depthDownsample.id, false },
+    { r3d_shader_load_scene_reduced_compose, &R3D_MOD_SHADER.scene.reducedCompose.id, false },
+    { r3d_shader_load_scene_background, &R3D_MOD_SHADER.scene.background.id, false },
+    { r3d_shader_load_scene_skybox, &R3D_MOD_SHADER.scene.skybox.id, false },
+    { r3d_shader_load_scene_depth, &R3D_MOD_SHADER.scene.depth.id, false },
+    { r3d_shader_load_scene_depth_cube, &R3D_MOD_SHADER.scene.depthCube.id, false },
+    { r3d_shader_load_scene_decal, &R3D_MOD_SHADER.scene.decal.id, false },
+    { r3d_shader_load_scene_decal_clustered, &R3D_MOD_SHADER.scene.decalClustered.id, false },
+    { r3d_shader_load_deferred_ambient_ibl, &R3D_MOD_SHADER.deferred.ambientIbl.id, false },
+    { r3d_shader_load_deferred_ambient, &R3D_MOD_SHADER.deferred.ambient.id, false },
+    { r3d_shader_load_deferred_lighting_dir, &R3D_MOD_SHADER.deferred.lighting[0].id, false },
+    { r3d_shader_load_deferred_lighting_dir_shadow, &R3D_MOD_SHADER.deferred.lighting[1].id, false },
+    { r3d_shader_load_deferred_lighting_spot, &R3D_MOD_SHADER.deferred.lighting[2].id, false },
+    { r3d_shader_load_deferred_lighting_spot_shadow, &R3D_MOD_SHADER.deferred.lighting[3].id, false },
+    { r3d_shader_load_deferred_lighting_omni, &R3D_MOD_SHADER.deferred.lighting[4].id, false },
+    { r3d_shader_load_deferred_lighting_omni_shadow, &R3D_MOD_SHADER.deferred.lighting[5].id, false },
+    { r3d_shader_load_deferred_lighting_clustered, &R3D_MOD_SHADER.deferred.lightingClustered.id, false },
+    { r3d_shader_load_deferred_compose, &R3D_MOD_SHADER.deferred.compose.id, false },
+    { r3d_shader_load_post_fog, &R3D_MOD_SHADER.post.fog.id, false },
+    { r3d_shader_load_post_output, &R3D_MOD_SHADER.post.output[0].id, false },
+    { r3d_shader_load_post_output_fog, &R3D_MOD_SHADER.post.output[1].id, false },
+    { r3d_shader_load_post_output_bloom, &R3D_MOD_SHADER.post.output[2].id, false },
+    { r3d_shader_load_post_output_fog_bloom, &R3D_MOD_SHADER.post.output[3].id, false },
+    { r3d_shader_load_post_fxaa, &R3D_MOD_SHADER.post.fxaa.id, false },
+    { r3d_shader_load_post_taa, &R3D_MOD_SHADER.post.taa.id, false },
+    { r3d_shader_load_post_dof, &R3D_MOD_SHADER.post.dof.id, false },
+};
+
+static bool has_parallel_compile(void)
+{
+    static int supported = -1;
+
+    if (supported < 0) {
+        supported = 0;
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count && !supported; i++) {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            supported = ext && (strcmp(ext, "GL_KHR_parallel_shader_compile") == 0 ||
+                                strcmp(ext, "GL_ARB_parallel_shader_compile") == 0);
+        }
+    }
+
+    return supported;
+}
+
+void r3d_shader_precompile(void)
+{
+    R3D_MOD_SHADER.precompile.active = true;
+
+    int count = sizeof(PRECOMPILE_LIST) / sizeof(*PRECOMPILE_LIST);
+    for (int i = 0; i < count; i++) {
+        if (*PRECOMPILE_LIST[i].id != 0) continue;
+        if (PRECOMPILE_LIST[i].compute && !GLAD_GL_VERSION_4_3) continue;
+
+        R3D_MOD_SHADER.precompile.loader = PRECOMPILE_LIST[i].load;
+        PRECOMPILE_LIST[i].load();
+    }
+
+    R3D_MOD_SHADER.precompile.loader = NULL;
+    R3D_MOD_SHADER.precompile.active = false;
+}
+
+int r3d_shader_precompile_poll(void)
+{
+    bool parallel = has_parallel_compile();
+
+    for (int i = 0; i < R3D_MOD_SHADER.precompile.count;) {
+        r3d_shader_precompile_entry_t* entry = &R3D_MOD_SHADER.precompile.entries[i];
+
+        if (parallel) {
+            GLint done = GL_FALSE;
+            glGetProgramiv(entry->program, GL_COMPLETION_STATUS_KHR, &done);
+            if (!done) { i++; continue; }
+        }
+
+        // The loader takes the entry back from its key and removes it
+        int count = R3D_MOD_SHADER.precompile.count;
+        entry->loader();
+
+        if (R3D_MOD_SHADER.precompile.count == count) {
+            glDeleteProgram(entry->program);
+            for (int j = 0; j < entry->shaderCount; j++) glDeleteShader(entry->shaders[j]);
+            *entry = R3D_MOD_SHADER.precompile.entries[--R3D_MOD_SHADER.precompile.count];
+        }
+
+        if (!parallel) break;
+    }
+
+    return R3D_MOD_SHADER.precompile.count;
+}
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -837,35 +1566,59 @@ bool r3d_shader_init()
 
 void r3d_shader_quit()
 {
+    for (int i = 0; i < R3D_MOD_SHADER.precompile.count; i++) {
+        r3d_shader_precompile_entry_t* entry = &R3D_MOD_SHADER.precompile.entries[i];
+        glDeleteProgram(entry->program);
+        for (int j = 0; j < entry->shaderCount; j++) glDeleteShader(entry->shaders[j]);
+    }
+
     UNLOAD_SHADER(prepare.ssao);
     UNLOAD_SHADER(prepare.ssaoBlur);
+    UNLOAD_SHADER(prepare.ssaoBlurCompute);
+    UNLOAD_SHADER(prepare.ssaoTemporal);
     UNLOAD_SHADER(prepare.ssil);
+    UNLOAD_SHADER(prepare.ssilTemporal);
     UNLOAD_SHADER(prepare.ssilBlur);
+    UNLOAD_SHADER(prepare.ssilBlurCompute);
     UNLOAD_SHADER(prepare.ssr);
     UNLOAD_SHADER(prepare.bloomDown);
+    UNLOAD_SHADER(prepare.bloomDownCompute);
     UNLOAD_SHADER(prepare.bloomUp);
     UNLOAD_SHADER(prepare.cubemapFromEquirectangular);
-    UNLOAD_SHADER(prepare.cubemapIrradiance);
     UNLOAD_SHADER(prepare.cubemapPrefilter);
+    UNLOAD_SHADER(prepare.instanceCull);
+    UNLOAD_SHADER(prepare.particleUpdate);
+    UNLOAD_SHADER(prepare.preskin);
+    UNLOAD_SHADER(prepare.hizDown);
 
     UNLOAD_SHADER(scene.geometry);
     UNLOAD_SHADER(scene.forward);
+    UNLOAD_SHADER(scene.oitResolve);
+    UNLOAD_SHADER(scene.depthDownsample);
+    UNLOAD_SHADER(scene.reducedCompose);
     UNLOAD_SHADER(scene.background);
     UNLOAD_SHADER(scene.skybox);
     UNLOAD_SHADER(scene.depth);
     UNLOAD_SHADER(scene.depthCube);
     UNLOAD_SHADER(scene.decal);
+    UNLOAD_SHADER(scene.decalClustered);
 
     UNLOAD_SHADER(deferred.ambientIbl);
+    UNLOAD_SHADER(deferred.ambientProbes);
     UNLOAD_SHADER(deferred.ambient);
-    UNLOAD_SHADER(deferred.lighting);
+    for (int i = 0; i < R3D_SHADER_LIGHTING_VARIANTS; i++) {
+        UNLOAD_SHADER(deferred.lighting[i]);
+    }
+    UNLOAD_SHADER(deferred.lightingClustered);
     UNLOAD_SHADER(deferred.compose);
 
-    UNLOAD_SHADER(post.bloom);
     UNLOAD_SHADER(post.fog);
     UNLOAD_SHADER(post.dof);
-    UNLOAD_SHADER(post.output);
+    for (int i = 0; i < R3D_SHADER_OUTPUT_VARIANTS; i++) {
+        UNLOAD_SHADER(post.output[i]);
+    }
     UNLOAD_SHADER(post.fxaa);
+    UNLOAD_SHADER(post.taa);
 }
 
 // ========================================
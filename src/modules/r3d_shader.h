@@ -10,8 +10,13 @@
 #define R3D_MODULE_SHADER_H
 
 #include <raylib.h>
+#include <stdint.h>
+#include <string.h>
 #include <glad.h>
 
+#include "./r3d_state.h"
+#include "./r3d_profile.h"
+
 // ========================================
 // SHADER MANAGEMENT MACROS
 // ========================================
@@ -20,7 +25,7 @@
     if (R3D_MOD_SHADER.shader_name.id == 0) {                                                       \
         R3D_MOD_SHADER_LOADER.shader_name();                                                        \
     }                                                                                               \
-    glUseProgram(R3D_MOD_SHADER.shader_name.id);                                                    \
+    r3d_state_use_program(R3D_MOD_SHADER.shader_name.id);                                           \
 } while(0)
 
 #define R3D_SHADER_SLOT_SAMPLER_1D(shader_name, uniform)                                            \
@@ -32,39 +37,56 @@
 #define R3D_SHADER_SLOT_SAMPLER_CUBE(shader_name, uniform)                                          \
     R3D_MOD_SHADER.shader_name.uniform.slotCube                                                     \
 
+#define R3D_SHADER_SLOT_SAMPLER_BUFFER(shader_name, uniform)                                        \
+    R3D_MOD_SHADER.shader_name.uniform.slotBuffer                                                   \
+
+#define R3D_SHADER_SLOT_SAMPLER_CUBE_ARRAY(shader_name, uniform)                                    \
+    R3D_MOD_SHADER.shader_name.uniform.slotCubeArray                                                \
+
 #define R3D_SHADER_BIND_SAMPLER_1D(shader_name, uniform, texId) do {                                \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slot1D);                       \
-    glBindTexture(GL_TEXTURE_1D, (texId));                                                          \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slot1D, GL_TEXTURE_1D, (texId));      \
 } while(0)
 
 #define R3D_SHADER_BIND_SAMPLER_2D(shader_name, uniform, texId) do {                                \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slot2D);                       \
-    glBindTexture(GL_TEXTURE_2D, (texId));                                                          \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slot2D, GL_TEXTURE_2D, (texId));      \
 } while(0)
 
 #define R3D_SHADER_BIND_SAMPLER_CUBE(shader_name, uniform, texId) do {                              \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slotCube);                     \
-    glBindTexture(GL_TEXTURE_CUBE_MAP, (texId));                                                    \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotCube, GL_TEXTURE_CUBE_MAP, (texId));\
+} while(0)
+
+#define R3D_SHADER_BIND_SAMPLER_BUFFER(shader_name, uniform, texId) do {                            \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotBuffer, GL_TEXTURE_BUFFER, (texId));\
+} while(0)
+
+#define R3D_SHADER_BIND_SAMPLER_CUBE_ARRAY(shader_name, uniform, texId) do {                        \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotCubeArray, GL_TEXTURE_CUBE_MAP_ARRAY, (texId));\
 } while(0)
 
 #define R3D_SHADER_UNBIND_SAMPLER_1D(shader_name, uniform) do {                                     \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slot1D);                       \
-    glBindTexture(GL_TEXTURE_1D, 0);                                                                \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slot1D, GL_TEXTURE_1D, 0);            \
 } while(0)
 
 #define R3D_SHADER_UNBIND_SAMPLER_2D(shader_name, uniform) do {                                     \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slot2D);                       \
-    glBindTexture(GL_TEXTURE_2D, 0);                                                                \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slot2D, GL_TEXTURE_2D, 0);            \
 } while(0)
 
 #define R3D_SHADER_UNBIND_SAMPLER_CUBE(shader_name, uniform) do {                                   \
-    glActiveTexture(GL_TEXTURE0 + R3D_MOD_SHADER.shader_name.uniform.slotCube);                     \
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);                                                          \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotCube, GL_TEXTURE_CUBE_MAP, 0);    \
+} while(0)
+
+#define R3D_SHADER_UNBIND_SAMPLER_BUFFER(shader_name, uniform) do {                                 \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotBuffer, GL_TEXTURE_BUFFER, 0);    \
+} while(0)
+
+#define R3D_SHADER_UNBIND_SAMPLER_CUBE_ARRAY(shader_name, uniform) do {                             \
+    r3d_state_bind_texture(R3D_MOD_SHADER.shader_name.uniform.slotCubeArray, GL_TEXTURE_CUBE_MAP_ARRAY, 0);\
 } while(0)
 
 #define R3D_SHADER_SET_INT(shader_name, uniform, value) do {                                        \
     if (R3D_MOD_SHADER.shader_name.uniform.val != (value)) {                                        \
         R3D_MOD_SHADER.shader_name.uniform.val = (value);                                           \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform1i(                                                                                \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             R3D_MOD_SHADER.shader_name.uniform.val                                                  \
@@ -75,6 +97,7 @@
 #define R3D_SHADER_SET_FLOAT(shader_name, uniform, value) do {                                      \
     if (R3D_MOD_SHADER.shader_name.uniform.val != (value)) {                                        \
         R3D_MOD_SHADER.shader_name.uniform.val = (value);                                           \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform1f(                                                                                \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             R3D_MOD_SHADER.shader_name.uniform.val                                                  \
@@ -86,6 +109,7 @@
     const Vector2 tmp = (__VA_ARGS__);                                                              \
     if (!Vector2Equals(R3D_MOD_SHADER.shader_name.uniform.val, tmp)) {                              \
         R3D_MOD_SHADER.shader_name.uniform.val = tmp;                                               \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform2fv(                                                                               \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             1, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                                    \
@@ -97,6 +121,7 @@
     const Vector3 tmp = (__VA_ARGS__);                                                              \
     if (!Vector3Equals(R3D_MOD_SHADER.shader_name.uniform.val, tmp)) {                              \
         R3D_MOD_SHADER.shader_name.uniform.val = tmp;                                               \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform3fv(                                                                               \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             1, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                                    \
@@ -108,6 +133,7 @@
     const Vector4 tmp = (__VA_ARGS__);                                                              \
     if (!Vector4Equals(R3D_MOD_SHADER.shader_name.uniform.val, tmp)) {                              \
         R3D_MOD_SHADER.shader_name.uniform.val = tmp;                                               \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform4fv(                                                                               \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             1, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                                    \
@@ -123,6 +149,7 @@
     };                                                                                              \
     if (!Vector3Equals(R3D_MOD_SHADER.shader_name.uniform.val, v)) {                                \
         R3D_MOD_SHADER.shader_name.uniform.val = v;                                                 \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform3fv(                                                                               \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             1, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                                    \
@@ -139,6 +166,7 @@
     };                                                                                              \
     if (!Vector4Equals(R3D_MOD_SHADER.shader_name.uniform.val, v)) {                                \
         R3D_MOD_SHADER.shader_name.uniform.val = v;                                                 \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
         glUniform4fv(                                                                               \
             R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
             1, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                                    \
@@ -147,19 +175,62 @@
 } while(0)
 
 #define R3D_SHADER_SET_MAT4(shader_name, uniform, value) do {                                       \
-    glUniformMatrix4fv(R3D_MOD_SHADER.shader_name.uniform.loc, 1, GL_TRUE, (float*)(&(value)));     \
+    const Matrix tmp = (value);                                                                     \
+    if (memcmp(&R3D_MOD_SHADER.shader_name.uniform.val, &tmp, sizeof(Matrix)) != 0) {               \
+        R3D_MOD_SHADER.shader_name.uniform.val = tmp;                                               \
+        R3D_PROFILE_COUNT(uniformUploads, 1);                                                       \
+        glUniformMatrix4fv(                                                                         \
+            R3D_MOD_SHADER.shader_name.uniform.loc,                                                 \
+            1, GL_TRUE, (float*)(&R3D_MOD_SHADER.shader_name.uniform.val)                           \
+        );                                                                                          \
+    }                                                                                               \
 } while(0)
 
 #define R3D_SHADER_SET_MAT4_V(shader_name, uniform, array, count) do {                              \
+    R3D_PROFILE_COUNT(uniformUploads, 1);                                                           \
     glUniformMatrix4fv(R3D_MOD_SHADER.shader_name.uniform.loc, (count), GL_TRUE, (float*)(array));  \
 } while(0)
 
+#define R3D_SHADER_SET_FLOAT_V(shader_name, uniform, array, count) do {                             \
+    R3D_PROFILE_COUNT(uniformUploads, 1);                                                           \
+    glUniform1fv(R3D_MOD_SHADER.shader_name.uniform.loc, (count), (const float*)(array));           \
+} while(0)
+
 // ========================================
 // MODULE CONSTANTS
 // ========================================
 
-#define R3D_SHADER_FORWARD_NUM_LIGHTS   8
+#define R3D_SHADER_FORWARD_BLOCK_LIGHTS 192
+#define R3D_SHADER_FORWARD_BLOCK_SHADOWS 32
+#define R3D_SHADER_FORWARD_CLUSTER_X    16
+#define R3D_SHADER_FORWARD_CLUSTER_Y    9
+#define R3D_SHADER_FORWARD_CLUSTER_Z    24
+#define R3D_SHADER_DECAL_TILE_X         32
+#define R3D_SHADER_DECAL_TILE_Y         18
 #define R3D_SHADER_UBO_VIEW_SLOT        0
+#define R3D_SHADER_UBO_LIGHT_SLOT       1
+#define R3D_SHADER_UBO_SHADOW_SLOT      2
+#define R3D_SHADER_UBO_SKY_SLOT         3
+#define R3D_SHADER_UBO_PROBE_SLOT       4
+#define R3D_SHADER_MAX_PRECOMPILE       48
+#define R3D_SHADER_LIGHTING_VARIANTS    6
+#define R3D_SHADER_OUTPUT_VARIANTS      4
+
+// NOTE: Values of the 'uInstancing' uniform of the scene shaders, must match 'instance.glsl'
+#define R3D_SHADER_INSTANCING_NONE      0
+#define R3D_SHADER_INSTANCING_MATRIX    1
+#define R3D_SHADER_INSTANCING_PARTICLE  2
+#define R3D_SHADER_INSTANCING_SPRITE    3
+
+/*
+ * Index of the deferred lighting program specialized for a light type, with or without shadows.
+ */
+#define R3D_SHADER_LIGHTING_VARIANT(type, shadow) (2 * (int)(type) + ((shadow) ? 1 : 0))
+
+/*
+ * Index of the output program with the fog and the bloom composition fused in or not.
+ */
+#define R3D_SHADER_OUTPUT_VARIANT(fog, bloom) (((fog) ? 1 : 0) | ((bloom) ? 2 : 0))
 
 // ========================================
 // UNIFORMS TYPES
@@ -168,6 +239,8 @@
 typedef struct { int slot1D; int loc; } r3d_shader_uniform_sampler1D_t;
 typedef struct { int slot2D; int loc; } r3d_shader_uniform_sampler2D_t;
 typedef struct { int slotCube; int loc; } r3d_shader_uniform_samplerCube_t;
+typedef struct { int slotBuffer; int loc; } r3d_shader_uniform_samplerBuffer_t;
+typedef struct { int slotCubeArray; int loc; } r3d_shader_uniform_samplerCubeArray_t;
 
 typedef struct { int val; int loc; } r3d_shader_uniform_int_t;
 typedef struct { float val; int loc; } r3d_shader_uniform_float_t;
@@ -175,7 +248,7 @@ typedef struct { Vector2 val; int loc; } r3d_shader_uniform_vec2_t;
 typedef struct { Vector3 val; int loc; } r3d_shader_uniform_vec3_t;
 typedef struct { Vector4 val; int loc; } r3d_shader_uniform_vec4_t;
 
-typedef struct { int loc; } r3d_shader_uniform_mat4_t;
+typedef struct { Matrix val; int loc; } r3d_shader_uniform_mat4_t;
 
 // ========================================
 // SHADER STRUCTURES DECLARATIONS
@@ -190,8 +263,19 @@ typedef struct {
     r3d_shader_uniform_float_t uBias;
     r3d_shader_uniform_float_t uIntensity;
     r3d_shader_uniform_float_t uPower;
+    r3d_shader_uniform_int_t uFrameIndex;
 } r3d_shader_prepare_ssao_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexSource;
+    r3d_shader_uniform_sampler2D_t uTexHistory;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_mat4_t uMatPrevViewProj;
+    r3d_shader_uniform_vec2_t uPrevUvScale;
+    r3d_shader_uniform_float_t uHistoryWeight;
+} r3d_shader_prepare_ssao_temporal_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexSource;
@@ -200,6 +284,13 @@ typedef struct {
     r3d_shader_uniform_vec2_t uDirection;
 } r3d_shader_prepare_ssao_blur_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexSource;
+    r3d_shader_uniform_sampler2D_t uTexNormal;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+} r3d_shader_prepare_ssao_blur_compute_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexDepth;
@@ -211,8 +302,24 @@ typedef struct {
     r3d_shader_uniform_float_t uHitThickness;
     r3d_shader_uniform_float_t uAoPower;
     r3d_shader_uniform_float_t uEnergy;
+    r3d_shader_uniform_int_t uFrameIndex;
+    r3d_shader_uniform_vec2_t uPixelOffset;
+    r3d_shader_uniform_vec2_t uTexelSize;
 } r3d_shader_prepare_ssil_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexSparse;
+    r3d_shader_uniform_sampler2D_t uTexHistory;
+    r3d_shader_uniform_sampler2D_t uTexHistoryGeometry;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexNormal;
+    r3d_shader_uniform_mat4_t uMatPrevViewProj;
+    r3d_shader_uniform_vec2_t uPrevUvScale;
+    r3d_shader_uniform_vec2_t uPixelOffset;
+    r3d_shader_uniform_float_t uConvergence;
+} r3d_shader_prepare_ssil_temporal_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexSource;
@@ -221,6 +328,13 @@ typedef struct {
     r3d_shader_uniform_vec2_t uDirection;
 } r3d_shader_prepare_ssil_blur_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexSource;
+    r3d_shader_uniform_sampler2D_t uTexNormal;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+} r3d_shader_prepare_ssil_blur_compute_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexColor;
@@ -228,6 +342,8 @@ typedef struct {
     r3d_shader_uniform_sampler2D_t uTexNormal;
     r3d_shader_uniform_sampler2D_t uTexORM;
     r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexHiZ;
+    r3d_shader_uniform_int_t uHiZMaxLevel;
     r3d_shader_uniform_int_t uMaxRaySteps;
     r3d_shader_uniform_int_t uBinarySearchSteps;
     r3d_shader_uniform_float_t uRayMarchLength;
@@ -235,6 +351,7 @@ typedef struct {
     r3d_shader_uniform_float_t uDepthTolerance;
     r3d_shader_uniform_float_t uEdgeFadeStart;
     r3d_shader_uniform_float_t uEdgeFadeEnd;
+    r3d_shader_uniform_float_t uRoughnessCutoff;
     r3d_shader_uniform_vec3_t uAmbientColor;
     r3d_shader_uniform_float_t uAmbientEnergy;
 } r3d_shader_prepare_ssr_t;
@@ -247,6 +364,13 @@ typedef struct {
     r3d_shader_uniform_int_t uDstLevel;
 } r3d_shader_prepare_bloom_down_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexSource;
+    r3d_shader_uniform_vec4_t uPrefilter;
+    r3d_shader_uniform_int_t uLevelCount;
+} r3d_shader_prepare_bloom_down_compute_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexture;
@@ -261,13 +385,6 @@ typedef struct {
     r3d_shader_uniform_sampler2D_t uTexEquirectangular;
 } r3d_shader_prepare_cubemap_from_equirectangular_t;
 
-typedef struct {
-    unsigned int id;
-    r3d_shader_uniform_mat4_t uMatProj;
-    r3d_shader_uniform_mat4_t uMatView;
-    r3d_shader_uniform_samplerCube_t uCubemap;
-} r3d_shader_prepare_cubemap_irradiance_t;
-
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_mat4_t uMatProj;
@@ -279,7 +396,67 @@ typedef struct {
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler1D_t uTexBoneMatrices;
+    r3d_shader_uniform_mat4_t uMatModel;
+    r3d_shader_uniform_vec4_t uPlanes[6];
+    r3d_shader_uniform_vec3_t uAabbMin;
+    r3d_shader_uniform_vec3_t uAabbMax;
+    r3d_shader_uniform_int_t uInstanceCount;
+    r3d_shader_uniform_int_t uInTransformOffset;
+    r3d_shader_uniform_int_t uInColorOffset;
+    r3d_shader_uniform_int_t uOutTransformOffset;
+    r3d_shader_uniform_int_t uOutColorOffset;
+    r3d_shader_uniform_int_t uInAnimationOffset;
+    r3d_shader_uniform_int_t uOutAnimationOffset;
+    r3d_shader_uniform_int_t uCommandOffset;
+    r3d_shader_uniform_int_t uParticles;
+} r3d_shader_prepare_instance_cull_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_samplerBuffer_t uTexBoneMatrices;
+    r3d_shader_uniform_int_t uBoneOffset;
+    r3d_shader_uniform_int_t uVertexCount;
+} r3d_shader_prepare_preskin_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_float_t uDeltaTime;
+    r3d_shader_uniform_int_t uParticleCount;
+    r3d_shader_uniform_int_t uEmitCount;
+    r3d_shader_uniform_int_t uSeed;
+    r3d_shader_uniform_vec3_t uPosition;
+    r3d_shader_uniform_vec3_t uGravity;
+    r3d_shader_uniform_vec3_t uInitialScale;
+    r3d_shader_uniform_float_t uScaleVariance;
+    r3d_shader_uniform_vec3_t uInitialRotation;
+    r3d_shader_uniform_vec3_t uRotationVariance;
+    r3d_shader_uniform_vec4_t uInitialColor;
+    r3d_shader_uniform_vec4_t uColorVariance;
+    r3d_shader_uniform_vec3_t uInitialVelocity;
+    r3d_shader_uniform_vec3_t uVelocityVariance;
+    r3d_shader_uniform_vec3_t uInitialAngularVelocity;
+    r3d_shader_uniform_vec3_t uAngularVelocityVariance;
+    r3d_shader_uniform_float_t uLifetime;
+    r3d_shader_uniform_float_t uLifetimeVariance;
+    r3d_shader_uniform_float_t uSpreadAngle;
+    r3d_shader_uniform_int_t uCurveMask;
+    r3d_shader_uniform_int_t uCurveTextureMask;
+    r3d_shader_uniform_float_t uCurves;
+    r3d_shader_uniform_sampler1D_t uTexScaleCurve;
+    r3d_shader_uniform_sampler1D_t uTexSpeedCurve;
+    r3d_shader_uniform_sampler1D_t uTexOpacityCurve;
+    r3d_shader_uniform_sampler1D_t uTexAngularVelocityCurve;
+} r3d_shader_prepare_particle_update_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_int_t uFirstLevel;
+} r3d_shader_prepare_hiz_down_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_samplerBuffer_t uTexBoneMatrices;
     r3d_shader_uniform_mat4_t uMatNormal;
     r3d_shader_uniform_mat4_t uMatModel;
     r3d_shader_uniform_vec4_t uAlbedoColor;
@@ -289,7 +466,13 @@ typedef struct {
     r3d_shader_uniform_vec2_t uTexCoordScale;
     r3d_shader_uniform_int_t uInstancing;
     r3d_shader_uniform_int_t uSkinning;
+    r3d_shader_uniform_int_t uBoneOffset;
+    r3d_shader_uniform_int_t uBakedAnimation;
     r3d_shader_uniform_int_t uBillboard;
+    r3d_shader_uniform_int_t uBatchMaterial;
+    r3d_shader_uniform_int_t uCompactVertex;
+    r3d_shader_uniform_vec3_t uPositionMin;
+    r3d_shader_uniform_vec3_t uPositionSize;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
     r3d_shader_uniform_sampler2D_t uTexNormal;
     r3d_shader_uniform_sampler2D_t uTexEmission;
@@ -303,7 +486,7 @@ typedef struct {
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler1D_t uTexBoneMatrices;
+    r3d_shader_uniform_samplerBuffer_t uTexBoneMatrices;
     r3d_shader_uniform_mat4_t uMatInvView;
     r3d_shader_uniform_mat4_t uMatModel;
     r3d_shader_uniform_mat4_t uMatVP;
@@ -312,23 +495,35 @@ typedef struct {
     r3d_shader_uniform_float_t uAlpha;
     r3d_shader_uniform_int_t uInstancing;
     r3d_shader_uniform_int_t uSkinning;
+    r3d_shader_uniform_int_t uBoneOffset;
+    r3d_shader_uniform_int_t uBakedAnimation;
     r3d_shader_uniform_int_t uBillboard;
+    r3d_shader_uniform_int_t uCompactVertex;
+    r3d_shader_uniform_vec3_t uPositionMin;
+    r3d_shader_uniform_vec3_t uPositionSize;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
     r3d_shader_uniform_float_t uAlphaCutoff;
 } r3d_shader_scene_depth_t;
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler1D_t uTexBoneMatrices;
+    r3d_shader_uniform_samplerBuffer_t uTexBoneMatrices;
     r3d_shader_uniform_mat4_t uMatInvView;
     r3d_shader_uniform_mat4_t uMatModel;
-    r3d_shader_uniform_mat4_t uMatVP;
+    r3d_shader_uniform_mat4_t uMatFaceVP[6];
+    r3d_shader_uniform_vec4_t uFaceTiles[6];
+    r3d_shader_uniform_int_t uFaceMask;
     r3d_shader_uniform_vec2_t uTexCoordOffset;
     r3d_shader_uniform_vec2_t uTexCoordScale;
     r3d_shader_uniform_float_t uAlpha;
     r3d_shader_uniform_int_t uInstancing;
     r3d_shader_uniform_int_t uSkinning;
+    r3d_shader_uniform_int_t uBoneOffset;
+    r3d_shader_uniform_int_t uBakedAnimation;
     r3d_shader_uniform_int_t uBillboard;
+    r3d_shader_uniform_int_t uCompactVertex;
+    r3d_shader_uniform_vec3_t uPositionMin;
+    r3d_shader_uniform_vec3_t uPositionSize;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
     r3d_shader_uniform_float_t uAlphaCutoff;
     r3d_shader_uniform_vec3_t uViewPosition;
@@ -337,8 +532,7 @@ typedef struct {
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler1D_t uTexBoneMatrices;
-    r3d_shader_uniform_mat4_t uMatLightVP[R3D_SHADER_FORWARD_NUM_LIGHTS];
+    r3d_shader_uniform_samplerBuffer_t uTexBoneMatrices;
     r3d_shader_uniform_mat4_t uMatNormal;
     r3d_shader_uniform_mat4_t uMatModel;
     r3d_shader_uniform_vec4_t uAlbedoColor;
@@ -346,13 +540,17 @@ typedef struct {
     r3d_shader_uniform_vec2_t uTexCoordScale;
     r3d_shader_uniform_int_t uInstancing;
     r3d_shader_uniform_int_t uSkinning;
+    r3d_shader_uniform_int_t uBoneOffset;
+    r3d_shader_uniform_int_t uBakedAnimation;
     r3d_shader_uniform_int_t uBillboard;
+    r3d_shader_uniform_int_t uCompactVertex;
+    r3d_shader_uniform_vec3_t uPositionMin;
+    r3d_shader_uniform_vec3_t uPositionSize;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
     r3d_shader_uniform_sampler2D_t uTexEmission;
     r3d_shader_uniform_sampler2D_t uTexNormal;
     r3d_shader_uniform_sampler2D_t uTexORM;
-    r3d_shader_uniform_samplerCube_t uShadowMapCube[R3D_SHADER_FORWARD_NUM_LIGHTS];
-    r3d_shader_uniform_sampler2D_t uShadowMap2D[R3D_SHADER_FORWARD_NUM_LIGHTS];
+    r3d_shader_uniform_sampler2D_t uTexShadowAtlas;
     r3d_shader_uniform_float_t uEmissionEnergy;
     r3d_shader_uniform_float_t uNormalScale;
     r3d_shader_uniform_float_t uOcclusion;
@@ -360,37 +558,42 @@ typedef struct {
     r3d_shader_uniform_float_t uMetalness;
     r3d_shader_uniform_vec3_t uAmbientColor;
     r3d_shader_uniform_vec3_t uEmissionColor;
-    r3d_shader_uniform_samplerCube_t uCubeIrradiance;
     r3d_shader_uniform_samplerCube_t uCubePrefilter;
     r3d_shader_uniform_sampler2D_t uTexBrdfLut;
     r3d_shader_uniform_vec4_t uQuatSkybox;
     r3d_shader_uniform_int_t uHasSkybox;
     r3d_shader_uniform_float_t uAmbientEnergy;
     r3d_shader_uniform_float_t uReflectEnergy;
-    struct {
-        r3d_shader_uniform_vec3_t color;
-        r3d_shader_uniform_vec3_t position;
-        r3d_shader_uniform_vec3_t direction;
-        r3d_shader_uniform_float_t specular;
-        r3d_shader_uniform_float_t energy;
-        r3d_shader_uniform_float_t range;
-        r3d_shader_uniform_float_t near;
-        r3d_shader_uniform_float_t far;
-        r3d_shader_uniform_float_t attenuation;
-        r3d_shader_uniform_float_t innerCutOff;
-        r3d_shader_uniform_float_t outerCutOff;
-        r3d_shader_uniform_float_t shadowSoftness;
-        r3d_shader_uniform_float_t shadowTexelSize;
-        r3d_shader_uniform_float_t shadowDepthBias;
-        r3d_shader_uniform_float_t shadowSlopeBias;
-        r3d_shader_uniform_int_t type;
-        r3d_shader_uniform_int_t enabled;
-        r3d_shader_uniform_int_t shadow;
-    } uLights[R3D_SHADER_FORWARD_NUM_LIGHTS];
+    r3d_shader_uniform_int_t uShadowIndices[R3D_SHADER_FORWARD_BLOCK_SHADOWS];
+    r3d_shader_uniform_int_t uShadowCount;
+    r3d_shader_uniform_samplerBuffer_t uTexLightClusters;
+    r3d_shader_uniform_samplerBuffer_t uTexLightIndices;
+    r3d_shader_uniform_vec2_t uClusterTileScale;
+    r3d_shader_uniform_vec2_t uClusterSlice;
     r3d_shader_uniform_float_t uAlphaCutoff;
     r3d_shader_uniform_vec3_t uViewPosition;
+    r3d_shader_uniform_int_t uWeightedOIT;
 } r3d_shader_scene_forward_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexAccum;
+    r3d_shader_uniform_sampler2D_t uTexWeight;
+} r3d_shader_scene_oit_resolve_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_int_t uFactor;
+} r3d_shader_scene_depth_downsample_t;
+
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexColor;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexReducedDepth;
+} r3d_shader_scene_reduced_compose_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_mat4_t uMatNormal;
@@ -413,6 +616,19 @@ typedef struct {
     r3d_shader_uniform_float_t uMetalness;
 } r3d_shader_scene_decal_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexAlbedo;
+    r3d_shader_uniform_sampler2D_t uTexEmission;
+    r3d_shader_uniform_sampler2D_t uTexORM;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_samplerBuffer_t uTexDecals;
+    r3d_shader_uniform_samplerBuffer_t uTexDecalTiles;
+    r3d_shader_uniform_samplerBuffer_t uTexDecalIndices;
+    r3d_shader_uniform_vec2_t uTileScale;
+    r3d_shader_uniform_int_t uTileOffset;
+} r3d_shader_scene_decal_clustered_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_vec4_t uColor;
@@ -434,7 +650,6 @@ typedef struct {
     r3d_shader_uniform_sampler2D_t uTexSSIL;
     r3d_shader_uniform_sampler2D_t uTexSSR;
     r3d_shader_uniform_sampler2D_t uTexORM;
-    r3d_shader_uniform_samplerCube_t uCubeIrradiance;
     r3d_shader_uniform_samplerCube_t uCubePrefilter;
     r3d_shader_uniform_sampler2D_t uTexBrdfLut;
     r3d_shader_uniform_float_t uAmbientEnergy;
@@ -443,6 +658,24 @@ typedef struct {
     r3d_shader_uniform_vec4_t uQuatSkybox;
 } r3d_shader_deferred_ambient_ibl_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexAlbedo;
+    r3d_shader_uniform_sampler2D_t uTexNormal;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexSSAO;
+    r3d_shader_uniform_sampler2D_t uTexSSIL;
+    r3d_shader_uniform_sampler2D_t uTexSSR;
+    r3d_shader_uniform_sampler2D_t uTexORM;
+    r3d_shader_uniform_samplerCube_t uCubePrefilter;
+    r3d_shader_uniform_sampler2D_t uTexBrdfLut;
+    r3d_shader_uniform_samplerCubeArray_t uCubeProbes;
+    r3d_shader_uniform_float_t uAmbientEnergy;
+    r3d_shader_uniform_float_t uReflectEnergy;
+    r3d_shader_uniform_float_t uMipCountSSR;
+    r3d_shader_uniform_vec4_t uQuatSkybox;
+} r3d_shader_deferred_ambient_probes_t;
+
 typedef struct {
     unsigned int id;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
@@ -458,48 +691,47 @@ typedef struct {
 typedef struct {
     unsigned int id;
     struct {
-        r3d_shader_uniform_mat4_t matVP;
-        r3d_shader_uniform_sampler2D_t shadowMap;
-        r3d_shader_uniform_samplerCube_t shadowCubemap;
         r3d_shader_uniform_vec3_t color;
         r3d_shader_uniform_vec3_t position;
         r3d_shader_uniform_vec3_t direction;
         r3d_shader_uniform_float_t specular;
         r3d_shader_uniform_float_t energy;
         r3d_shader_uniform_float_t range;
-        r3d_shader_uniform_float_t near;
-        r3d_shader_uniform_float_t far;
         r3d_shader_uniform_float_t attenuation;
         r3d_shader_uniform_float_t innerCutOff;
         r3d_shader_uniform_float_t outerCutOff;
-        r3d_shader_uniform_float_t shadowSoftness;
-        r3d_shader_uniform_float_t shadowTexelSize;
-        r3d_shader_uniform_float_t shadowDepthBias;
-        r3d_shader_uniform_float_t shadowSlopeBias;
-        r3d_shader_uniform_int_t type;
-        r3d_shader_uniform_int_t shadow;
+        r3d_shader_uniform_int_t shadowIndex;
     } uLight;
     r3d_shader_uniform_sampler2D_t uTexAlbedo;
     r3d_shader_uniform_sampler2D_t uTexNormal;
     r3d_shader_uniform_sampler2D_t uTexDepth;
     r3d_shader_uniform_sampler2D_t uTexSSAO;
     r3d_shader_uniform_sampler2D_t uTexORM;
+    r3d_shader_uniform_sampler2D_t uTexShadowAtlas;
     r3d_shader_uniform_float_t uSSAOLightAffect;
+    r3d_shader_uniform_mat4_t uMatModel;
+    r3d_shader_uniform_int_t uVolume;
 } r3d_shader_deferred_lighting_t;
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler2D_t uTexDiffuse;
-    r3d_shader_uniform_sampler2D_t uTexSpecular;
-} r3d_shader_deferred_compose_t;
+    r3d_shader_uniform_sampler2D_t uTexAlbedo;
+    r3d_shader_uniform_sampler2D_t uTexNormal;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexSSAO;
+    r3d_shader_uniform_sampler2D_t uTexORM;
+    r3d_shader_uniform_samplerBuffer_t uTexLightClusters;
+    r3d_shader_uniform_samplerBuffer_t uTexLightIndices;
+    r3d_shader_uniform_vec2_t uClusterTileScale;
+    r3d_shader_uniform_vec2_t uClusterSlice;
+    r3d_shader_uniform_float_t uSSAOLightAffect;
+} r3d_shader_deferred_lighting_clustered_t;
 
 typedef struct {
     unsigned int id;
-    r3d_shader_uniform_sampler2D_t uTexColor;
-    r3d_shader_uniform_sampler2D_t uTexBloomBlur;
-    r3d_shader_uniform_int_t uBloomMode;
-    r3d_shader_uniform_float_t uBloomIntensity;
-} r3d_shader_post_bloom_t;
+    r3d_shader_uniform_sampler2D_t uTexDiffuse;
+    r3d_shader_uniform_sampler2D_t uTexSpecular;
+} r3d_shader_deferred_compose_t;
 
 typedef struct {
     unsigned int id;
@@ -532,6 +764,17 @@ typedef struct {
     r3d_shader_uniform_float_t uBrightness;
     r3d_shader_uniform_float_t uContrast;
     r3d_shader_uniform_float_t uSaturation;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_int_t uFogMode;
+    r3d_shader_uniform_vec3_t uFogColor;
+    r3d_shader_uniform_float_t uFogStart;
+    r3d_shader_uniform_float_t uFogEnd;
+    r3d_shader_uniform_float_t uFogDensity;
+    r3d_shader_uniform_float_t uSkyAffect;
+    r3d_shader_uniform_sampler2D_t uTexBloomBlur;
+    r3d_shader_uniform_vec2_t uFilterRadius;
+    r3d_shader_uniform_int_t uBloomMode;
+    r3d_shader_uniform_float_t uBloomIntensity;
 } r3d_shader_post_output_t;
 
 typedef struct {
@@ -540,6 +783,31 @@ typedef struct {
     r3d_shader_uniform_vec2_t uTexelSize;
 } r3d_shader_post_fxaa_t;
 
+typedef struct {
+    unsigned int id;
+    r3d_shader_uniform_sampler2D_t uTexColor;
+    r3d_shader_uniform_sampler2D_t uTexDepth;
+    r3d_shader_uniform_sampler2D_t uTexHistory;
+    r3d_shader_uniform_mat4_t uMatPrevViewProj;
+    r3d_shader_uniform_vec2_t uJitter;
+    r3d_shader_uniform_float_t uHistoryWeight;
+} r3d_shader_post_taa_t;
+
+// ========================================
+// PRECOMPILATION
+// ========================================
+
+typedef void (*r3d_shader_loader_func)(void);
+
+typedef struct {
+    uint64_t key;                       //< Key of the sources, see `r3d_program_cache_key()`
+    GLuint program;                     //< Program submitted for linking
+    GLuint shaders[3];                  //< Shaders attached to the program, released once linked
+    GLenum types[3];
+    int shaderCount;
+    r3d_shader_loader_func loader;      //< Loader to call again once the program is linked
+} r3d_shader_precompile_entry_t;
+
 // ========================================
 // MODULE STATE
 // ========================================
@@ -550,78 +818,120 @@ extern struct r3d_shader {
     struct {
         r3d_shader_prepare_ssao_t ssao;
         r3d_shader_prepare_ssao_blur_t ssaoBlur;
+        r3d_shader_prepare_ssao_blur_compute_t ssaoBlurCompute;
+        r3d_shader_prepare_ssao_temporal_t ssaoTemporal;
         r3d_shader_prepare_ssil_t ssil;
+        r3d_shader_prepare_ssil_temporal_t ssilTemporal;
         r3d_shader_prepare_ssil_blur_t ssilBlur;
+        r3d_shader_prepare_ssil_blur_compute_t ssilBlurCompute;
         r3d_shader_prepare_ssr_t ssr;
         r3d_shader_prepare_bloom_down_t bloomDown;
+        r3d_shader_prepare_bloom_down_compute_t bloomDownCompute;
         r3d_shader_prepare_bloom_up_t bloomUp;
         r3d_shader_prepare_cubemap_from_equirectangular_t cubemapFromEquirectangular;
-        r3d_shader_prepare_cubemap_irradiance_t cubemapIrradiance;
         r3d_shader_prepare_cubemap_prefilter_t cubemapPrefilter;
+        r3d_shader_prepare_instance_cull_t instanceCull;
+        r3d_shader_prepare_particle_update_t particleUpdate;
+        r3d_shader_prepare_preskin_t preskin;
+        r3d_shader_prepare_hiz_down_t hizDown;
     } prepare;
 
     // Scene shaders
     struct {
         r3d_shader_scene_geometry_t geometry;
         r3d_shader_scene_forward_t forward;
+        r3d_shader_scene_oit_resolve_t oitResolve;
+        r3d_shader_scene_depth_downsample_t depthDownsample;
+        r3d_shader_scene_reduced_compose_t reducedCompose;
         r3d_shader_scene_background_t background;
         r3d_shader_scene_skybox_t skybox;
         r3d_shader_scene_depth_t depth;
         r3d_shader_scene_depth_cube_t depthCube;
         r3d_shader_scene_decal_t decal;
+        r3d_shader_scene_decal_clustered_t decalClustered;
     } scene;
 
     // Deferred shaders
     struct {
         r3d_shader_deferred_ambient_ibl_t ambientIbl;
+        r3d_shader_deferred_ambient_probes_t ambientProbes;
         r3d_shader_deferred_ambient_t ambient;
-        r3d_shader_deferred_lighting_t lighting;
+        r3d_shader_deferred_lighting_t lighting[R3D_SHADER_LIGHTING_VARIANTS];
+        r3d_shader_deferred_lighting_clustered_t lightingClustered;
         r3d_shader_deferred_compose_t compose;
     } deferred;
 
     // Post shaders
     struct {
-        r3d_shader_post_bloom_t bloom;
         r3d_shader_post_fog_t fog;
         r3d_shader_post_dof_t dof;
-        r3d_shader_post_output_t output;
+        r3d_shader_post_output_t output[R3D_SHADER_OUTPUT_VARIANTS];
         r3d_shader_post_fxaa_t fxaa;
+        r3d_shader_post_taa_t taa;
     } post;
 
+    // Programs compiled in the background
+    struct {
+        r3d_shader_precompile_entry_t entries[R3D_SHADER_MAX_PRECOMPILE];
+        r3d_shader_loader_func loader;  //< Loader being called by `r3d_shader_precompile()`
+        int count;                      //< Number of programs not linked yet
+        bool active;                    //< True while the loaders only submit their programs
+    } precompile;
+
 } R3D_MOD_SHADER;
 
 // ========================================
 // BUILT-IN SHADER LOADER
 // ========================================
 
-typedef void (*r3d_shader_loader_func)(void);
-
 void r3d_shader_load_prepare_ssao(void);
 void r3d_shader_load_prepare_ssao_blur(void);
+void r3d_shader_load_prepare_ssao_blur_compute(void);
+void r3d_shader_load_prepare_ssao_temporal(void);
 void r3d_shader_load_prepare_ssil(void);
+void r3d_shader_load_prepare_ssil_temporal(void);
 void r3d_shader_load_prepare_ssil_blur(void);
+void r3d_shader_load_prepare_ssil_blur_compute(void);
 void r3d_shader_load_prepare_ssr(void);
 void r3d_shader_load_prepare_bloom_down(void);
+void r3d_shader_load_prepare_bloom_down_compute(void);
 void r3d_shader_load_prepare_bloom_up(void);
 void r3d_shader_load_prepare_cubemap_from_equirectangular(void);
-void r3d_shader_load_prepare_cubemap_irradiance(void);
 void r3d_shader_load_prepare_cubemap_prefilter(void);
+void r3d_shader_load_prepare_instance_cull(void);
+void r3d_shader_load_prepare_particle_update(void);
+void r3d_shader_load_prepare_preskin(void);
+void r3d_shader_load_prepare_hiz_down(void);
 void r3d_shader_load_scene_geometry(void);
 void r3d_shader_load_scene_forward(void);
+void r3d_shader_load_scene_oit_resolve(void);
+void r3d_shader_load_scene_depth_downsample(void);
+void r3d_shader_load_scene_reduced_compose(void);
 void r3d_shader_load_scene_background(void);
 void r3d_shader_load_scene_skybox(void);
 void r3d_shader_load_scene_depth(void);
 void r3d_shader_load_scene_depth_cube(void);
 void r3d_shader_load_scene_decal(void);
+void r3d_shader_load_scene_decal_clustered(void);
 void r3d_shader_load_deferred_ambient_ibl(void);
+void r3d_shader_load_deferred_ambient_probes(void);
 void r3d_shader_load_deferred_ambient(void);
-void r3d_shader_load_deferred_lighting(void);
+void r3d_shader_load_deferred_lighting_dir(void);
+void r3d_shader_load_deferred_lighting_dir_shadow(void);
+void r3d_shader_load_deferred_lighting_spot(void);
+void r3d_shader_load_deferred_lighting_spot_shadow(void);
+void r3d_shader_load_deferred_lighting_omni(void);
+void r3d_shader_load_deferred_lighting_omni_shadow(void);
+void r3d_shader_load_deferred_lighting_clustered(void);
 void r3d_shader_load_deferred_compose(void);
-void r3d_shader_load_post_bloom(void);
 void r3d_shader_load_post_fog(void);
 void r3d_shader_load_post_dof(void);
 void r3d_shader_load_post_output(void);
+void r3d_shader_load_post_output_fog(void);
+void r3d_shader_load_post_output_bloom(void);
+void r3d_shader_load_post_output_fog_bloom(void);
 void r3d_shader_load_post_fxaa(void);
+void r3d_shader_load_post_taa(void);
 
 static const struct r3d_shader_loader {
 
@@ -629,42 +939,56 @@ static const struct r3d_shader_loader {
     struct {
         r3d_shader_loader_func ssao;
         r3d_shader_loader_func ssaoBlur;
+        r3d_shader_loader_func ssaoBlurCompute;
+        r3d_shader_loader_func ssaoTemporal;
         r3d_shader_loader_func ssil;
+        r3d_shader_loader_func ssilTemporal;
         r3d_shader_loader_func ssilBlur;
+        r3d_shader_loader_func ssilBlurCompute;
         r3d_shader_loader_func ssr;
         r3d_shader_loader_func bloomDown;
+        r3d_shader_loader_func bloomDownCompute;
         r3d_shader_loader_func bloomUp;
         r3d_shader_loader_func cubemapFromEquirectangular;
-        r3d_shader_loader_func cubemapIrradiance;
         r3d_shader_loader_func cubemapPrefilter;
+        r3d_shader_loader_func instanceCull;
+        r3d_shader_loader_func particleUpdate;
+        r3d_shader_loader_func preskin;
+        r3d_shader_loader_func hizDown;
     } prepare;
 
     // Scene shaders
     struct {
         r3d_shader_loader_func geometry;
         r3d_shader_loader_func forward;
+        r3d_shader_loader_func oitResolve;
+        r3d_shader_loader_func depthDownsample;
+        r3d_shader_loader_func reducedCompose;
         r3d_shader_loader_func background;
         r3d_shader_loader_func skybox;
         r3d_shader_loader_func depth;
         r3d_shader_loader_func depthCube;
         r3d_shader_loader_func decal;
+        r3d_shader_loader_func decalClustered;
     } scene;
 
     // Deferred shaders
     struct {
         r3d_shader_loader_func ambientIbl;
+        r3d_shader_loader_func ambientProbes;
         r3d_shader_loader_func ambient;
-        r3d_shader_loader_func lighting;
+        r3d_shader_loader_func lighting[R3D_SHADER_LIGHTING_VARIANTS];
+        r3d_shader_loader_func lightingClustered;
         r3d_shader_loader_func compose;
     } deferred;
 
     // Post shaders
     struct {
-        r3d_shader_loader_func bloom;
         r3d_shader_loader_func fog;
         r3d_shader_loader_func dof;
-        r3d_shader_loader_func output;
+        r3d_shader_loader_func output[R3D_SHADER_OUTPUT_VARIANTS];
         r3d_shader_loader_func fxaa;
+        r3d_shader_loader_func taa;
     } post;
 
 } R3D_MOD_SHADER_LOADER = {
@@ -672,38 +996,64 @@ static const struct r3d_shader_loader {
     .prepare = {
         .ssao = r3d_shader_load_prepare_ssao,
         .ssaoBlur = r3d_shader_load_prepare_ssao_blur,
+        .ssaoBlurCompute = r3d_shader_load_prepare_ssao_blur_compute,
+        .ssaoTemporal = r3d_shader_load_prepare_ssao_temporal,
         .ssil = r3d_shader_load_prepare_ssil,
+        .ssilTemporal = r3d_shader_load_prepare_ssil_temporal,
         .ssilBlur = r3d_shader_load_prepare_ssil_blur,
+        .ssilBlurCompute = r3d_shader_load_prepare_ssil_blur_compute,
         .ssr = r3d_shader_load_prepare_ssr,
         .bloomDown = r3d_shader_load_prepare_bloom_down,
+        .bloomDownCompute = r3d_shader_load_prepare_bloom_down_compute,
         .bloomUp = r3d_shader_load_prepare_bloom_up,
         .cubemapFromEquirectangular = r3d_shader_load_prepare_cubemap_from_equirectangular,
-        .cubemapIrradiance = r3d_shader_load_prepare_cubemap_irradiance,
         .cubemapPrefilter = r3d_shader_load_prepare_cubemap_prefilter,
+        .instanceCull = r3d_shader_load_prepare_instance_cull,
+        .particleUpdate = r3d_shader_load_prepare_particle_update,
+        .preskin = r3d_shader_load_prepare_preskin,
+        .hizDown = r3d_shader_load_prepare_hiz_down,
     },
 
     .scene = {
         .geometry = r3d_shader_load_scene_geometry,
         .forward = r3d_shader_load_scene_forward,
+        .oitResolve = r3d_shader_load_scene_oit_resolve,
+        .depthDownsample = r3d_shader_load_scene_depth_downsample,
+        .reducedCompose = r3d_shader_load_scene_reduced_compose,
         .background = r3d_shader_load_scene_background,
         .skybox = r3d_shader_load_scene_skybox,
         .depth = r3d_shader_load_scene_depth,
         .depthCube = r3d_shader_load_scene_depth_cube,
         .decal = r3d_shader_load_scene_decal,
+        .decalClustered = r3d_shader_load_scene_decal_clustered,
     },
 
     .deferred = {
         .ambientIbl = r3d_shader_load_deferred_ambient_ibl,
+        .ambientProbes = r3d_shader_load_deferred_ambient_probes,
         .ambient = r3d_shader_load_deferred_ambient,
-        .lighting = r3d_shader_load_deferred_lighting,
+        .lighting = {
+            r3d_shader_load_deferred_lighting_dir,
+            r3d_shader_load_deferred_lighting_dir_shadow,
+            r3d_shader_load_deferred_lighting_spot,
+            r3d_shader_load_deferred_lighting_spot_shadow,
+            r3d_shader_load_deferred_lighting_omni,
+            r3d_shader_load_deferred_lighting_omni_shadow,
+        },
+        .lightingClustered = r3d_shader_load_deferred_lighting_clustered,
         .compose = r3d_shader_load_deferred_compose,
     },
 
     .post = {
-        .bloom = r3d_shader_load_post_bloom,
         .fog = r3d_shader_load_post_fog,
-        .output = r3d_shader_load_post_output,
+        .output = {
+            r3d_shader_load_post_output,
+            r3d_shader_load_post_output_fog,
+            r3d_shader_load_post_output_bloom,
+            r3d_shader_load_post_output_fog_bloom,
+        },
         .fxaa = r3d_shader_load_post_fxaa,
+        .taa = r3d_shader_load_post_taa,
         .dof = r3d_shader_load_post_dof,
     },
 
@@ -725,4 +1075,18 @@ bool r3d_shader_init();
  */
 void r3d_shader_quit();
 
+/*
+ * Submits the compilation of all the built-in programs not loaded yet, without waiting for them.
+ * The programs found in the binary cache are loaded immediately.
+ */
+void r3d_shader_precompile(void);
+
+/*
+ * Finishes the loading of the submitted programs that are linked.
+ * Without GL_KHR_parallel_shader_compile the link status cannot be polled,
+ * a single program is then finished per call, so that the waits are spread over frames.
+ * Returns the number of programs still pending.
+ */
+int r3d_shader_precompile_poll(void);
+
 #endif // R3D_MODULE_SHADER_H
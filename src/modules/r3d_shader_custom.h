@@ -29,7 +29,12 @@ void R3D_CustomShaderSetTexCoordOffset(const R3D_Shader* shader, float x, float
 void R3D_CustomShaderSetTexCoordScale(const R3D_Shader* shader, float x, float y);
 void R3D_CustomShaderSetInstancing(const R3D_Shader* shader, int value);
 void R3D_CustomShaderSetSkinning(const R3D_Shader* shader, int value);
+void R3D_CustomShaderSetBoneOffset(const R3D_Shader* shader, int value);
+void R3D_CustomShaderSetBakedAnimation(const R3D_Shader* shader, int value);
 void R3D_CustomShaderSetBillboard(const R3D_Shader* shader, int value);
+void R3D_CustomShaderSetCompactVertex(const R3D_Shader* shader, int value);
+void R3D_CustomShaderSetPositionMin(const R3D_Shader* shader, float x, float y, float z);
+void R3D_CustomShaderSetPositionSize(const R3D_Shader* shader, float x, float y, float z);
 void R3D_CustomShaderSetAlphaCutoff(const R3D_Shader* shader, float value);
 void R3D_CustomShaderSetNormalScale(const R3D_Shader* shader, float value);
 void R3D_CustomShaderSetOcclusion(const R3D_Shader* shader, float value);
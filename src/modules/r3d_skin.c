@@ -0,0 +1,251 @@
+/* r3d_skin.c -- Internal R3D bone palette module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_skin.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "./r3d_profile.h"
+#include "./r3d_state.h"
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_skin R3D_MOD_SKIN;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static bool grow_palette(int required)
+{
+    int capacity = R3D_MOD_SKIN.capacity;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+
+    if (capacity > R3D_MOD_SKIN.maxCapacity) {
+        capacity = R3D_MOD_SKIN.maxCapacity;
+    }
+
+    if (capacity < required) {
+        TraceLog(LOG_WARNING, "R3D: The bone palette is limited to %d matrices, %d requested", R3D_MOD_SKIN.maxCapacity, required);
+        return false;
+    }
+
+    Matrix* matrices = RL_REALLOC(R3D_MOD_SKIN.matrices, capacity * sizeof(Matrix));
+    if (matrices == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Failed to grow the bone palette to %d matrices", capacity);
+        return false;
+    }
+
+    R3D_MOD_SKIN.matrices = matrices;
+    R3D_MOD_SKIN.capacity = capacity;
+    R3D_MOD_SKIN.resized = true;
+
+    return true;
+}
+
+static void remove_free_range(int index)
+{
+    memmove(&R3D_MOD_SKIN.freeRanges[index], &R3D_MOD_SKIN.freeRanges[index + 1],
+            (R3D_MOD_SKIN.freeCount - index - 1) * sizeof(r3d_skin_range_t));
+    R3D_MOD_SKIN.freeCount--;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_skin_init(void)
+{
+    memset(&R3D_MOD_SKIN, 0, sizeof(R3D_MOD_SKIN));
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    R3D_MOD_SKIN.maxCapacity = maxTexels / 4;
+
+    R3D_MOD_SKIN.capacity = R3D_SKIN_INITIAL_CAPACITY;
+    if (R3D_MOD_SKIN.capacity > R3D_MOD_SKIN.maxCapacity) {
+        R3D_MOD_SKIN.capacity = R3D_MOD_SKIN.maxCapacity;
+    }
+
+    R3D_MOD_SKIN.matrices = RL_MALLOC(R3D_MOD_SKIN.capacity * sizeof(Matrix));
+    if (R3D_MOD_SKIN.matrices == NULL) {
+        TraceLog(LOG_FATAL, "R3D: Failed to allocate the bone palette");
+        return false;
+    }
+
+    R3D_MOD_SKIN.dirtyBegin = INT_MAX;
+
+    glGenBuffers(1, &R3D_MOD_SKIN.buffer);
+    glGenTextures(1, &R3D_MOD_SKIN.texture);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_SKIN.buffer);
+    glBufferData(GL_TEXTURE_BUFFER, R3D_MOD_SKIN.capacity * sizeof(Matrix), NULL, GL_DYNAMIC_DRAW);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, R3D_MOD_SKIN.texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, R3D_MOD_SKIN.buffer);
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    return true;
+}
+
+void r3d_skin_quit(void)
+{
+    glDeleteBuffers(1, &R3D_MOD_SKIN.buffer);
+    glDeleteTextures(1, &R3D_MOD_SKIN.texture);
+
+    RL_FREE(R3D_MOD_SKIN.matrices);
+    RL_FREE(R3D_MOD_SKIN.freeRanges);
+
+    memset(&R3D_MOD_SKIN, 0, sizeof(R3D_MOD_SKIN));
+}
+
+int r3d_skin_alloc(int count)
+{
+    if (count <= 0) {
+        return -1;
+    }
+
+    /* --- Reuse the first released range large enough --- */
+
+    for (int i = 0; i < R3D_MOD_SKIN.freeCount; i++) {
+        r3d_skin_range_t* range = &R3D_MOD_SKIN.freeRanges[i];
+        if (range->count >= count) {
+            int offset = range->offset;
+            range->offset += count;
+            range->count -= count;
+            if (range->count == 0) {
+                remove_free_range(i);
+            }
+            return offset;
+        }
+    }
+
+    /* --- Otherwise allocate after the last range --- */
+
+    int required = R3D_MOD_SKIN.used + count;
+    if (required > R3D_MOD_SKIN.capacity && !grow_palette(required)) {
+        return -1;
+    }
+
+    int offset = R3D_MOD_SKIN.used;
+    R3D_MOD_SKIN.used = required;
+
+    return offset;
+}
+
+void r3d_skin_free(int offset, int count)
+{
+    if (offset < 0 || count <= 0 || R3D_MOD_SKIN.matrices == NULL) {
+        return;
+    }
+
+    /* --- Ranges ending the palette are given back to it --- */
+
+    if (offset + count == R3D_MOD_SKIN.used) {
+        R3D_MOD_SKIN.used = offset;
+        int last = R3D_MOD_SKIN.freeCount - 1;
+        if (last >= 0) {
+            r3d_skin_range_t* range = &R3D_MOD_SKIN.freeRanges[last];
+            if (range->offset + range->count == R3D_MOD_SKIN.used) {
+                R3D_MOD_SKIN.used = range->offset;
+                R3D_MOD_SKIN.freeCount--;
+            }
+        }
+        return;
+    }
+
+    /* --- Otherwise insert the range sorted, merged with its neighbors --- */
+
+    int index = 0;
+    while (index < R3D_MOD_SKIN.freeCount && R3D_MOD_SKIN.freeRanges[index].offset < offset) {
+        index++;
+    }
+
+    r3d_skin_range_t* prev = (index > 0) ? &R3D_MOD_SKIN.freeRanges[index - 1] : NULL;
+    r3d_skin_range_t* next = (index < R3D_MOD_SKIN.freeCount) ? &R3D_MOD_SKIN.freeRanges[index] : NULL;
+
+    bool mergePrev = (prev && prev->offset + prev->count == offset);
+    bool mergeNext = (next && offset + count == next->offset);
+
+    if (mergePrev && mergeNext) {
+        prev->count += count + next->count;
+        remove_free_range(index);
+        return;
+    }
+    if (mergePrev) {
+        prev->count += count;
+        return;
+    }
+    if (mergeNext) {
+        next->offset = offset;
+        next->count += count;
+        return;
+    }
+
+    if (R3D_MOD_SKIN.freeCount == R3D_MOD_SKIN.freeCapacity) {
+        int capacity = (R3D_MOD_SKIN.freeCapacity > 0) ? 2 * R3D_MOD_SKIN.freeCapacity : 16;
+        r3d_skin_range_t* ranges = RL_REALLOC(R3D_MOD_SKIN.freeRanges, capacity * sizeof(r3d_skin_range_t));
+        if (ranges == NULL) {
+            return; // The range is lost until the module is reinitialized
+        }
+        R3D_MOD_SKIN.freeRanges = ranges;
+        R3D_MOD_SKIN.freeCapacity = capacity;
+    }
+
+    memmove(&R3D_MOD_SKIN.freeRanges[index + 1], &R3D_MOD_SKIN.freeRanges[index],
+            (R3D_MOD_SKIN.freeCount - index) * sizeof(r3d_skin_range_t));
+
+    R3D_MOD_SKIN.freeRanges[index] = (r3d_skin_range_t) {offset, count};
+    R3D_MOD_SKIN.freeCount++;
+}
+
+void r3d_skin_write(int offset, const Matrix* matrices, int count)
+{
+    if (offset < 0 || count <= 0) {
+        return;
+    }
+
+    memcpy(&R3D_MOD_SKIN.matrices[offset], matrices, count * sizeof(Matrix));
+
+    if (offset < R3D_MOD_SKIN.dirtyBegin) R3D_MOD_SKIN.dirtyBegin = offset;
+    if (offset + count > R3D_MOD_SKIN.dirtyEnd) R3D_MOD_SKIN.dirtyEnd = offset + count;
+}
+
+void r3d_skin_upload(void)
+{
+    if (!R3D_MOD_SKIN.resized && R3D_MOD_SKIN.dirtyEnd == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, R3D_MOD_SKIN.buffer);
+
+    // The buffer texture keeps referencing the buffer when its storage is reallocated
+    if (R3D_MOD_SKIN.resized) {
+        glBufferData(GL_TEXTURE_BUFFER, R3D_MOD_SKIN.capacity * sizeof(Matrix), R3D_MOD_SKIN.matrices, GL_DYNAMIC_DRAW);
+        R3D_PROFILE_COUNT(boneBytes, R3D_MOD_SKIN.capacity * sizeof(Matrix));
+        R3D_MOD_SKIN.resized = false;
+    }
+    else {
+        int begin = R3D_MOD_SKIN.dirtyBegin;
+        int count = R3D_MOD_SKIN.dirtyEnd - begin;
+        glBufferSubData(GL_TEXTURE_BUFFER, begin * sizeof(Matrix), count * sizeof(Matrix), &R3D_MOD_SKIN.matrices[begin]);
+        R3D_PROFILE_COUNT(boneBytes, count * sizeof(Matrix));
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    R3D_MOD_SKIN.dirtyBegin = INT_MAX;
+    R3D_MOD_SKIN.dirtyEnd = 0;
+}
@@ -0,0 +1,95 @@
+/* r3d_skin.h -- Internal R3D bone palette module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_SKIN_H
+#define R3D_MODULE_SKIN_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include <glad.h>
+
+// ========================================
+// MODULE CONSTANTS
+// ========================================
+
+#define R3D_SKIN_INITIAL_CAPACITY   1024    //< Matrices allocated with the module, doubled when exceeded
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+typedef struct {
+    int offset;
+    int count;
+} r3d_skin_range_t;
+
+/*
+ * Global internal state of the bone palette.
+ * The poses of all the skeletons and animation players are stored in a single buffer texture,
+ * each one holding the offset of its first matrix. The matrices are written to a CPU copy
+ * and the modified range is uploaded once per frame, at the beginning of `R3D_End()`.
+ */
+extern struct r3d_skin {
+
+    GLuint buffer;                      //< Buffer holding the matrices of all the poses
+    GLuint texture;                     //< Buffer texture of 'buffer', RGBA32F, four texels per matrix
+
+    Matrix* matrices;                   //< CPU copy of the palette
+    int capacity;                       //< Matrices allocated in 'matrices' and 'buffer'
+    int maxCapacity;                    //< Matrices allowed by GL_MAX_TEXTURE_BUFFER_SIZE
+    int used;                           //< End of the last allocated range
+
+    r3d_skin_range_t* freeRanges;       //< Released ranges below 'used', sorted by offset and never adjacent
+    int freeCount;
+    int freeCapacity;
+
+    int dirtyBegin;                     //< First matrix written since the last upload
+    int dirtyEnd;                       //< End of the matrices written since the last upload, zero if none
+    bool resized;                       //< The buffer storage must be reallocated by the next upload
+
+} R3D_MOD_SKIN;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_skin_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_skin_quit(void);
+
+/*
+ * Reserves 'count' consecutive matrices in the palette and returns the offset of the first one.
+ * Returns -1 if the palette cannot hold them.
+ */
+int r3d_skin_alloc(int count);
+
+/*
+ * Releases a range returned by `r3d_skin_alloc()`.
+ */
+void r3d_skin_free(int offset, int count);
+
+/*
+ * Copies matrices into the palette, they are visible to the shaders after the next upload.
+ */
+void r3d_skin_write(int offset, const Matrix* matrices, int count);
+
+/*
+ * Uploads the matrices written since the last upload.
+ * Called at the beginning of `R3D_End()`
+ */
+void r3d_skin_upload(void);
+
+#endif // R3D_MODULE_SKIN_H
@@ -0,0 +1,70 @@
+/* r3d_state.c -- Internal R3D OpenGL state cache module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_state.h"
+
+#include <string.h>
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_state R3D_MOD_STATE;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_state_init(void)
+{
+    memset(&R3D_MOD_STATE, 0, sizeof(R3D_MOD_STATE));
+    r3d_state_invalidate();
+    return true;
+}
+
+void r3d_state_quit(void)
+{
+    R3D_MOD_STATE.active = false;
+}
+
+void r3d_state_invalidate(void)
+{
+    R3D_MOD_STATE.program = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.vao = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.drawFbo = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.readFbo = R3D_STATE_UNKNOWN;
+
+    R3D_MOD_STATE.activeUnit = R3D_STATE_UNKNOWN;
+    memset(R3D_MOD_STATE.textures, 0xFF, sizeof(R3D_MOD_STATE.textures));
+
+    memset(R3D_MOD_STATE.caps, 0xFF, sizeof(R3D_MOD_STATE.caps));
+    R3D_MOD_STATE.cullFace = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.depthFunc = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.depthMask = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.blendSrc = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.blendDst = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.blendSrcAlpha = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.blendDstAlpha = R3D_STATE_UNKNOWN;
+    R3D_MOD_STATE.blendEquation = R3D_STATE_UNKNOWN;
+}
+
+void r3d_state_begin(void)
+{
+    r3d_state_invalidate();
+
+    R3D_MOD_STATE.issuedCalls = 0;
+    R3D_MOD_STATE.filteredCalls = 0;
+    R3D_MOD_STATE.active = true;
+}
+
+void r3d_state_end(void)
+{
+    R3D_MOD_STATE.lastIssuedCalls = R3D_MOD_STATE.issuedCalls;
+    R3D_MOD_STATE.lastFilteredCalls = R3D_MOD_STATE.filteredCalls;
+    R3D_MOD_STATE.active = false;
+}
@@ -0,0 +1,284 @@
+/* r3d_state.h -- Internal R3D OpenGL state cache module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_STATE_H
+#define R3D_MODULE_STATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <glad.h>
+
+#include "./r3d_profile.h"
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_STATE_TEXTURE_UNITS     32                              //< Number of texture units tracked, higher units are never filtered
+#define R3D_STATE_UPLOAD_UNIT       (R3D_STATE_TEXTURE_UNITS - 1)   //< Unit used to bind the textures being created or updated
+#define R3D_STATE_UNKNOWN           0xFFFFFFFFu                     //< Value of a state not known by the cache
+
+// ========================================
+// STATE ENUMS
+// ========================================
+
+typedef enum {
+    R3D_STATE_CAP_BLEND,
+    R3D_STATE_CAP_CULL_FACE,
+    R3D_STATE_CAP_DEPTH_TEST,
+    R3D_STATE_CAP_DEPTH_CLAMP,
+    R3D_STATE_CAP_SCISSOR_TEST,
+    R3D_STATE_CAP_COUNT
+} r3d_state_cap_t;
+
+typedef enum {
+    R3D_STATE_TEXTURE_1D,
+    R3D_STATE_TEXTURE_2D,
+    R3D_STATE_TEXTURE_CUBE,
+    R3D_STATE_TEXTURE_BUFFER,
+    R3D_STATE_TEXTURE_COUNT
+} r3d_state_texture_t;
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the OpenGL state cache.
+ * Redundant calls are only filtered during `R3D_End()`, between `r3d_state_begin()` and `r3d_state_end()`,
+ * raylib and the application are free to change the context outside of it.
+ * All the values are `R3D_STATE_UNKNOWN` after an invalidation.
+ */
+extern struct r3d_state {
+
+    uint32_t program;                                                   //< Program in use
+    uint32_t vao;                                                       //< Vertex array bound
+    uint32_t drawFbo;                                                   //< Framebuffer bound to GL_DRAW_FRAMEBUFFER
+    uint32_t readFbo;                                                   //< Framebuffer bound to GL_READ_FRAMEBUFFER
+
+    uint32_t activeUnit;                                                //< Active texture unit
+    uint32_t textures[R3D_STATE_TEXTURE_UNITS][R3D_STATE_TEXTURE_COUNT];//< Texture bound to each target of each unit
+
+    uint32_t caps[R3D_STATE_CAP_COUNT];                                 //< Capabilities enabled, zero or one
+    uint32_t cullFace;                                                  //< Faces culled
+    uint32_t depthFunc;                                                 //< Depth comparison function
+    uint32_t depthMask;                                                 //< Depth writes enabled, zero or one
+    uint32_t blendSrc, blendDst;                                        //< Blend factors of the color
+    uint32_t blendSrcAlpha, blendDstAlpha;                              //< Blend factors of the alpha
+    uint32_t blendEquation;                                             //< Blend equation
+
+    int issuedCalls;                                                    //< State calls sent to the driver during the current frame
+    int filteredCalls;                                                  //< Redundant state calls dropped during the current frame
+    int lastIssuedCalls;                                                //< Same as 'issuedCalls' for the last rendered frame
+    int lastFilteredCalls;                                              //< Same as 'filteredCalls' for the last rendered frame
+
+    bool active;                                                        //< True while the redundant calls are filtered
+
+} R3D_MOD_STATE;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_state_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_state_quit(void);
+
+/*
+ * Forgets all the cached values, the next call of each state is always sent.
+ * Must be called after the state has been changed without the cache,
+ * or after deleting an object that may be bound while the cache is active.
+ */
+void r3d_state_invalidate(void);
+
+/*
+ * Invalidates the cache, resets the counters and starts filtering the redundant calls.
+ * Called at the beginning of `R3D_End()`
+ */
+void r3d_state_begin(void);
+
+/*
+ * Stops filtering the redundant calls and keeps the counters of the frame.
+ * Called at the end of `R3D_End()`, once the state expected by raylib has been restored.
+ */
+void r3d_state_end(void);
+
+// ========================================
+// INLINE FUNCTIONS
+// ========================================
+
+/*
+ * Returns true if the call can be dropped, and updates the counters.
+ * Otherwise the caller must store the new value and issue the call.
+ */
+static inline bool r3d_state_filter(bool redundant)
+{
+    if (R3D_MOD_STATE.active && redundant) {
+        R3D_MOD_STATE.filteredCalls++;
+        return true;
+    }
+
+    R3D_MOD_STATE.issuedCalls++;
+
+    return false;
+}
+
+static inline void r3d_state_use_program(GLuint program)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.program == program)) return;
+    R3D_MOD_STATE.program = program;
+    R3D_PROFILE_COUNT(programBinds, 1);
+    glUseProgram(program);
+}
+
+static inline void r3d_state_bind_vao(GLuint vao)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.vao == vao)) return;
+    R3D_MOD_STATE.vao = vao;
+    R3D_PROFILE_COUNT(vaoBinds, 1);
+    glBindVertexArray(vao);
+}
+
+/*
+ * Binds a framebuffer to GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER.
+ */
+static inline void r3d_state_bind_framebuffer(GLenum target, GLuint fbo)
+{
+    bool draw = (target != GL_READ_FRAMEBUFFER);
+    bool read = (target != GL_DRAW_FRAMEBUFFER);
+
+    bool redundant =
+        (!draw || R3D_MOD_STATE.drawFbo == fbo) &&
+        (!read || R3D_MOD_STATE.readFbo == fbo);
+
+    if (r3d_state_filter(redundant)) return;
+
+    if (draw) R3D_MOD_STATE.drawFbo = fbo;
+    if (read) R3D_MOD_STATE.readFbo = fbo;
+
+    glBindFramebuffer(target, fbo);
+}
+
+/*
+ * Binds a texture to a unit, the unit becomes the active one.
+ * Targets other than 1D, 2D, cube maps and buffers, and the units above the tracked ones, are always sent.
+ */
+static inline void r3d_state_bind_texture(int unit, GLenum target, GLuint texture)
+{
+    if (!r3d_state_filter(R3D_MOD_STATE.activeUnit == (uint32_t)unit)) {
+        R3D_MOD_STATE.activeUnit = (uint32_t)unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    uint32_t* cached = NULL;
+    if (unit < R3D_STATE_TEXTURE_UNITS) {
+        switch (target) {
+        case GL_TEXTURE_1D: cached = &R3D_MOD_STATE.textures[unit][R3D_STATE_TEXTURE_1D]; break;
+        case GL_TEXTURE_2D: cached = &R3D_MOD_STATE.textures[unit][R3D_STATE_TEXTURE_2D]; break;
+        case GL_TEXTURE_CUBE_MAP: cached = &R3D_MOD_STATE.textures[unit][R3D_STATE_TEXTURE_CUBE]; break;
+        case GL_TEXTURE_BUFFER: cached = &R3D_MOD_STATE.textures[unit][R3D_STATE_TEXTURE_BUFFER]; break;
+        default: break;
+        }
+    }
+
+    if (r3d_state_filter(cached != NULL && *cached == texture)) return;
+    if (cached != NULL) *cached = texture;
+    R3D_PROFILE_COUNT(textureBinds, 1);
+    glBindTexture(target, texture);
+}
+
+/*
+ * Enables or disables a capability, the capabilities not tracked are always sent.
+ */
+static inline void r3d_state_set_enabled(GLenum cap, bool enabled)
+{
+    uint32_t* cached = NULL;
+    switch (cap) {
+    case GL_BLEND: cached = &R3D_MOD_STATE.caps[R3D_STATE_CAP_BLEND]; break;
+    case GL_CULL_FACE: cached = &R3D_MOD_STATE.caps[R3D_STATE_CAP_CULL_FACE]; break;
+    case GL_DEPTH_TEST: cached = &R3D_MOD_STATE.caps[R3D_STATE_CAP_DEPTH_TEST]; break;
+    case GL_DEPTH_CLAMP: cached = &R3D_MOD_STATE.caps[R3D_STATE_CAP_DEPTH_CLAMP]; break;
+    case GL_SCISSOR_TEST: cached = &R3D_MOD_STATE.caps[R3D_STATE_CAP_SCISSOR_TEST]; break;
+    default: break;
+    }
+
+    if (r3d_state_filter(cached != NULL && *cached == (uint32_t)enabled)) return;
+    if (cached != NULL) *cached = enabled;
+
+    if (enabled) glEnable(cap);
+    else glDisable(cap);
+}
+
+static inline void r3d_state_enable(GLenum cap)
+{
+    r3d_state_set_enabled(cap, true);
+}
+
+static inline void r3d_state_disable(GLenum cap)
+{
+    r3d_state_set_enabled(cap, false);
+}
+
+static inline void r3d_state_cull_face(GLenum mode)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.cullFace == mode)) return;
+    R3D_MOD_STATE.cullFace = mode;
+    glCullFace(mode);
+}
+
+static inline void r3d_state_depth_func(GLenum func)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.depthFunc == func)) return;
+    R3D_MOD_STATE.depthFunc = func;
+    glDepthFunc(func);
+}
+
+static inline void r3d_state_depth_mask(bool enabled)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.depthMask == (uint32_t)enabled)) return;
+    R3D_MOD_STATE.depthMask = enabled;
+    glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+static inline void r3d_state_blend_func(GLenum src, GLenum dst)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.blendSrc == src && R3D_MOD_STATE.blendDst == dst &&
+                         R3D_MOD_STATE.blendSrcAlpha == src && R3D_MOD_STATE.blendDstAlpha == dst)) return;
+    R3D_MOD_STATE.blendSrc = R3D_MOD_STATE.blendSrcAlpha = src;
+    R3D_MOD_STATE.blendDst = R3D_MOD_STATE.blendDstAlpha = dst;
+    glBlendFunc(src, dst);
+}
+
+static inline void r3d_state_blend_func_separate(GLenum src, GLenum dst, GLenum srcAlpha, GLenum dstAlpha)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.blendSrc == src && R3D_MOD_STATE.blendDst == dst &&
+                         R3D_MOD_STATE.blendSrcAlpha == srcAlpha && R3D_MOD_STATE.blendDstAlpha == dstAlpha)) return;
+    R3D_MOD_STATE.blendSrc = src;
+    R3D_MOD_STATE.blendDst = dst;
+    R3D_MOD_STATE.blendSrcAlpha = srcAlpha;
+    R3D_MOD_STATE.blendDstAlpha = dstAlpha;
+    glBlendFuncSeparate(src, dst, srcAlpha, dstAlpha);
+}
+
+static inline void r3d_state_blend_equation(GLenum mode)
+{
+    if (r3d_state_filter(R3D_MOD_STATE.blendEquation == mode)) return;
+    R3D_MOD_STATE.blendEquation = mode;
+    glBlendEquation(mode);
+}
+
+#endif // R3D_MODULE_STATE_H
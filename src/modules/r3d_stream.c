@@ -0,0 +1,260 @@
+/* r3d_stream.c -- Internal R3D transient stream module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include "./r3d_stream.h"
+
+#include <raylib.h>
+#include <string.h>
+#include <glad.h>
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+struct r3d_stream R3D_MOD_STREAM;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+#define STREAM_INITIAL_SIZE (1024 * 1024)
+
+static inline size_t align_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void wait_and_delete_fence(void** fence)
+{
+    if (*fence == NULL) return;
+
+    GLenum result = glClientWaitSync((GLsync)*fence, 0, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync((GLsync)*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    glDeleteSync((GLsync)*fence);
+    *fence = NULL;
+}
+
+static void release_fences(void)
+{
+    for (int i = 0; i < R3D_STREAM_FRAME_COUNT; i++) {
+        if (R3D_MOD_STREAM.fences[i]) {
+            glDeleteSync((GLsync)R3D_MOD_STREAM.fences[i]);
+            R3D_MOD_STREAM.fences[i] = NULL;
+        }
+    }
+}
+
+// Keeps the current buffer alive until the commands issued so far have completed
+static void retire_buffer(void)
+{
+    if (R3D_MOD_STREAM.buffer == 0) return;
+
+    // Too many buffers in flight, the oldest one is waited for
+    if (R3D_MOD_STREAM.numRetired == R3D_STREAM_MAX_RETIRED) {
+        wait_and_delete_fence(&R3D_MOD_STREAM.retired[0].fence);
+        glDeleteBuffers(1, &R3D_MOD_STREAM.retired[0].buffer);
+        memmove(&R3D_MOD_STREAM.retired[0], &R3D_MOD_STREAM.retired[1],
+                (R3D_STREAM_MAX_RETIRED - 1) * sizeof(R3D_MOD_STREAM.retired[0]));
+        R3D_MOD_STREAM.numRetired--;
+    }
+
+    int index = R3D_MOD_STREAM.numRetired++;
+    R3D_MOD_STREAM.retired[index].buffer = R3D_MOD_STREAM.buffer;
+    R3D_MOD_STREAM.retired[index].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    // The fences of the segments only guarded the old storage
+    release_fences();
+
+    R3D_MOD_STREAM.buffer = 0;
+    R3D_MOD_STREAM.mapped = NULL;
+}
+
+static void collect_retired(void)
+{
+    int count = 0;
+
+    for (int i = 0; i < R3D_MOD_STREAM.numRetired; i++) {
+        GLenum result = glClientWaitSync((GLsync)R3D_MOD_STREAM.retired[i].fence, 0, 0);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            glDeleteSync((GLsync)R3D_MOD_STREAM.retired[i].fence);
+            glDeleteBuffers(1, &R3D_MOD_STREAM.retired[i].buffer);
+        }
+        else {
+            R3D_MOD_STREAM.retired[count++] = R3D_MOD_STREAM.retired[i];
+        }
+    }
+
+    R3D_MOD_STREAM.numRetired = count;
+}
+
+static bool allocate_buffer(size_t segmentSize)
+{
+    retire_buffer();
+
+    GLsizeiptr totalSize = (GLsizeiptr)(segmentSize * R3D_STREAM_FRAME_COUNT);
+
+    glGenBuffers(1, &R3D_MOD_STREAM.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, R3D_MOD_STREAM.buffer);
+
+    if (GLAD_GL_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, totalSize, NULL, flags);
+        R3D_MOD_STREAM.mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, totalSize, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (GLAD_GL_ARB_buffer_storage && R3D_MOD_STREAM.mapped == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Failed to map the stream buffer");
+        glDeleteBuffers(1, &R3D_MOD_STREAM.buffer);
+        R3D_MOD_STREAM.buffer = 0;
+        return false;
+    }
+
+    R3D_MOD_STREAM.capacity = segmentSize;
+    R3D_MOD_STREAM.segment = 0;
+    R3D_MOD_STREAM.head = 0;
+
+    // Zero is kept for the data that has never been written
+    if (++R3D_MOD_STREAM.generation == 0) {
+        R3D_MOD_STREAM.generation = 1;
+    }
+
+    return true;
+}
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+bool r3d_stream_init(void)
+{
+    memset(&R3D_MOD_STREAM, 0, sizeof(R3D_MOD_STREAM));
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    R3D_MOD_STREAM.uniformAlignment = (alignment > 16) ? alignment : 16;
+
+    if (!allocate_buffer(STREAM_INITIAL_SIZE)) {
+        TraceLog(LOG_FATAL, "R3D: Failed to init stream module; Buffer allocation failed");
+        return false;
+    }
+
+    return true;
+}
+
+void r3d_stream_quit(void)
+{
+    release_fences();
+
+    for (int i = 0; i < R3D_MOD_STREAM.numRetired; i++) {
+        glDeleteSync((GLsync)R3D_MOD_STREAM.retired[i].fence);
+        glDeleteBuffers(1, &R3D_MOD_STREAM.retired[i].buffer);
+    }
+
+    // NOTE: Deleting the buffer implicitly unmaps it
+    if (R3D_MOD_STREAM.buffer != 0) {
+        glDeleteBuffers(1, &R3D_MOD_STREAM.buffer);
+    }
+
+    memset(&R3D_MOD_STREAM, 0, sizeof(R3D_MOD_STREAM));
+}
+
+void r3d_stream_next_frame(void)
+{
+    collect_retired();
+
+    if (R3D_MOD_STREAM.buffer == 0) {
+        return;
+    }
+
+    int segment = R3D_MOD_STREAM.segment;
+    R3D_MOD_STREAM.fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    segment = (segment + 1) % R3D_STREAM_FRAME_COUNT;
+    wait_and_delete_fence(&R3D_MOD_STREAM.fences[segment]);
+
+    R3D_MOD_STREAM.segment = segment;
+    R3D_MOD_STREAM.head = 0;
+}
+
+bool r3d_stream_reserve(size_t size)
+{
+    if (R3D_MOD_STREAM.buffer != 0 && R3D_MOD_STREAM.head + size <= R3D_MOD_STREAM.capacity) {
+        return true;
+    }
+
+    size_t newCapacity = R3D_MOD_STREAM.capacity;
+    if (newCapacity == 0) newCapacity = STREAM_INITIAL_SIZE;
+    while (newCapacity < R3D_MOD_STREAM.head + size) {
+        newCapacity *= 2;
+    }
+
+    return allocate_buffer(newCapacity);
+}
+
+size_t r3d_stream_write(const void* data, size_t stride, size_t elemSize, int count, size_t alignment)
+{
+    // NOTE: Space must have been reserved with 'r3d_stream_reserve()'
+    R3D_MOD_STREAM.head = align_up(R3D_MOD_STREAM.head, alignment);
+
+    size_t size = count * elemSize;
+    size_t offset = R3D_MOD_STREAM.segment * R3D_MOD_STREAM.capacity;
+    offset += R3D_MOD_STREAM.head;
+
+    uint8_t* dst = NULL;
+    if (R3D_MOD_STREAM.mapped) {
+        dst = (uint8_t*)R3D_MOD_STREAM.mapped + offset;
+    }
+    else {
+        // The ring guarantees this range is not read by the GPU, no need to synchronize
+        glBindBuffer(GL_ARRAY_BUFFER, R3D_MOD_STREAM.buffer);
+        dst = glMapBufferRange(
+            GL_ARRAY_BUFFER, offset, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        );
+    }
+
+    if (dst != NULL) {
+        if (stride == elemSize) {
+            memcpy(dst, data, size);
+        }
+        else {
+            const uint8_t* src = data;
+            for (int i = 0; i < count; i++) {
+                memcpy(dst + i * elemSize, src + i * stride, elemSize);
+            }
+        }
+    }
+
+    if (!R3D_MOD_STREAM.mapped) {
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+
+    R3D_MOD_STREAM.head += size;
+
+    return offset;
+}
+
+bool r3d_stream_bind_uniform(int slot, const void* data, size_t size)
+{
+    if (!r3d_stream_reserve(size + R3D_MOD_STREAM.uniformAlignment)) {
+        return false;
+    }
+
+    size_t offset = r3d_stream_write(data, size, size, 1, R3D_MOD_STREAM.uniformAlignment);
+    glBindBufferRange(GL_UNIFORM_BUFFER, slot, R3D_MOD_STREAM.buffer, offset, size);
+
+    return true;
+}
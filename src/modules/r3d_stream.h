@@ -0,0 +1,98 @@
+/* r3d_stream.h -- Internal R3D transient stream module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#ifndef R3D_MODULE_STREAM_H
+#define R3D_MODULE_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+#define R3D_STREAM_FRAME_COUNT      3       //< Number of frames in flight, each one writes its own segment
+#define R3D_STREAM_MAX_RETIRED      8       //< Number of replaced buffers that can wait for the GPU
+
+// ========================================
+// MODULE STATE
+// ========================================
+
+/*
+ * Global internal state of the stream module.
+ * A single buffer split into one segment per frame in flight receives all the data
+ * rewritten every frame (instance arrays, indirect commands, view uniforms).
+ * Each segment is guarded by a fence, so a segment is only rewritten once the GPU
+ * has consumed the frame that used it, and never needs to be orphaned or synchronized.
+ */
+extern struct r3d_stream {
+
+    uint32_t buffer;                                //< Ring buffer shared by all the transient data
+    void* mapped;                                   //< Persistently mapped storage (NULL if not supported)
+    void* fences[R3D_STREAM_FRAME_COUNT];           //< Sync objects guarding each segment
+    size_t capacity;                                //< Size of one segment in bytes
+    size_t head;                                    //< Write position in the current segment
+    int segment;                                    //< Segment written by the current frame
+    uint32_t generation;                            //< Incremented each time the buffer is replaced, never zero
+
+    struct {
+        uint32_t buffer;                            //< Buffer replaced by a larger one, possibly still read by the GPU
+        void* fence;                                //< Sync object signaled once the buffer can be deleted
+    } retired[R3D_STREAM_MAX_RETIRED];
+    int numRetired;                                 //< Number of buffers waiting for deletion
+
+    int uniformAlignment;                           //< Offset alignment required to bind a uniform range
+
+} R3D_MOD_STREAM;
+
+// ========================================
+// MODULE FUNCTIONS
+// ========================================
+
+/*
+ * Module initialization function.
+ * Called once during `R3D_Init()`
+ */
+bool r3d_stream_init(void);
+
+/*
+ * Module deinitialization function.
+ * Called once during `R3D_Close()`
+ */
+void r3d_stream_quit(void);
+
+/*
+ * Fences the segment of the frame and moves to the next one, waiting for the GPU
+ * only if it is still reading it. Also deletes the retired buffers that are no longer used.
+ * Called once at the end of `R3D_End()`
+ */
+void r3d_stream_next_frame(void);
+
+/*
+ * Ensures that 'size' bytes can be written in the current segment, padding included.
+ * The buffer is replaced by a larger one if needed, which increments the generation:
+ * the offsets returned before are then relative to the old buffer and must be written again.
+ * The old buffer is kept alive until the GPU is done with it, so ranges already bound stay valid.
+ */
+bool r3d_stream_reserve(size_t size);
+
+/*
+ * Copies 'count' elements of 'elemSize' bytes spaced by 'stride' in the current segment.
+ * The data is placed at the given alignment (a power of two), space must have been reserved.
+ * Returns the byte offset of the data in the stream buffer.
+ */
+size_t r3d_stream_write(const void* data, size_t stride, size_t elemSize, int count, size_t alignment);
+
+/*
+ * Writes a uniform block in the stream and binds it to the given slot.
+ * Returns false if the stream could not grow, the slot is then left untouched.
+ */
+bool r3d_stream_bind_uniform(int slot, const void* data, size_t size);
+
+#endif // R3D_MODULE_STREAM_H
@@ -7,11 +7,14 @@
  */
 
 #include "./r3d_target.h"
+
 #include <stddef.h>
 #include <string.h>
 #include <assert.h>
 #include <math.h>
 
+#include "./r3d_state.h"
+
 // ========================================
 // MODULE STATE
 // ========================================
@@ -40,38 +43,66 @@ typedef struct {
 } target_config_t;
 
 static const target_config_t TARGET_CONFIG[] = {
-    [R3D_TARGET_ALBEDO]     = { GL_RGB8,              GL_RGB,             GL_UNSIGNED_BYTE,  1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_NORMAL]     = { GL_RG16F,             GL_RG,              GL_HALF_FLOAT,     1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_ORM]        = { GL_RGB8,              GL_RGB,             GL_UNSIGNED_BYTE,  1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_DIFFUSE]    = { GL_RGBA16F,           GL_RGB,             GL_HALF_FLOAT,     1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_SPECULAR]   = { GL_RGBA16F,           GL_RGB,             GL_HALF_FLOAT,     1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_SSAO_0]     = { GL_R8,                GL_RED,             GL_UNSIGNED_BYTE,  0.5f, GL_LINEAR,               GL_LINEAR,  false },
-    [R3D_TARGET_SSAO_1]     = { GL_R8,                GL_RED,             GL_UNSIGNED_BYTE,  0.5f, GL_LINEAR,               GL_LINEAR,  false },
-    [R3D_TARGET_SSIL_0]     = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,     0.5f, GL_LINEAR,               GL_LINEAR,  false },
-    [R3D_TARGET_SSIL_1]     = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,     0.5f, GL_LINEAR,               GL_LINEAR,  false },
-    [R3D_TARGET_SSR]        = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,     0.5f, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,  true },
-    [R3D_TARGET_BLOOM]      = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,     1.0f, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,  true  },
-    [R3D_TARGET_SCENE_0]    = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,     1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_SCENE_1]    = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,     1.0f, GL_NEAREST,              GL_NEAREST, false },
-    [R3D_TARGET_DEPTH]      = { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,   1.0f, GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_ALBEDO]          = { GL_RGB8,              GL_RGB,             GL_UNSIGNED_BYTE, 1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_NORMAL]          = { GL_RG16F,             GL_RG,              GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_ORM]             = { GL_RGB8,              GL_RGB,             GL_UNSIGNED_BYTE, 1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_DIFFUSE]         = { GL_RGBA16F,           GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_SPECULAR]        = { GL_RGBA16F,           GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_SSAO_0]          = { GL_R8,                GL_RED,             GL_UNSIGNED_BYTE, 0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSAO_1]          = { GL_R8,                GL_RED,             GL_UNSIGNED_BYTE, 0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSAO_HISTORY_0]  = { GL_RG16F,             GL_RG,              GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSAO_HISTORY_1]  = { GL_RG16F,             GL_RG,              GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_0]          = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_1]          = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_SPARSE]     = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.25f, GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_SSIL_HISTORY_0]  = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_HISTORY_1]  = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_GEOMETRY_0] = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSIL_GEOMETRY_1] = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    0.5f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_SSR]             = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,  true },
+    [R3D_TARGET_BLOOM]           = { GL_RGBA16F,           GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,  true },
+    [R3D_TARGET_SCENE_0]         = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_SCENE_1]         = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_TAA_HISTORY_0]   = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_TAA_HISTORY_1]   = { GL_RGB16F,            GL_RGB,             GL_HALF_FLOAT,    1.0f,  GL_LINEAR,               GL_LINEAR,  false },
+    [R3D_TARGET_OIT_ACCUM]       = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_OIT_WEIGHT]      = { GL_R16F,              GL_RED,             GL_HALF_FLOAT,    1.0f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_REDUCED_HALF]    = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.5f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_REDUCED_QUARTER] = { GL_RGBA16F,           GL_RGBA,            GL_HALF_FLOAT,    0.25f, GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_DEPTH_HALF]      = { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,  0.5f,  GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_DEPTH_QUARTER]   = { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,  0.25f, GL_NEAREST,              GL_NEAREST, false },
+    [R3D_TARGET_DEPTH]           = { GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT,  1.0f,  GL_NEAREST,              GL_NEAREST, false },
 };
 
+static bool is_depth_target(r3d_target_t target)
+{
+    return TARGET_CONFIG[target].format == GL_DEPTH_COMPONENT;
+}
+
 static void target_load(r3d_target_t target)
 {
     const target_config_t* config = &TARGET_CONFIG[target];
     GLuint* id = &R3D_MOD_TARGET.targets[target];
 
-    int w = (int)((float)R3D_MOD_TARGET.resW * config->resolutionFactor);
-    int h = (int)((float)R3D_MOD_TARGET.resH * config->resolutionFactor);
+    int w = (int)((float)R3D_MOD_TARGET.allocW * config->resolutionFactor);
+    int h = (int)((float)R3D_MOD_TARGET.allocH * config->resolutionFactor);
 
-    glBindTexture(GL_TEXTURE_2D, *id);
-    glTexImage2D(GL_TEXTURE_2D, 0, config->internalFormat, w, h, 0, config->format, config->type, NULL);
+    // The compact layout halves the bandwidth of the light accumulation, blended by every light
+    GLenum internalFormat = config->internalFormat;
+    if (R3D_MOD_TARGET.compact && (target == R3D_TARGET_DIFFUSE || target == R3D_TARGET_SPECULAR)) {
+        internalFormat = GL_R11F_G11F_B10F;
+    }
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, *id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, config->format, config->type, NULL);
     if (config->mipmaps) {
-        int wLevel = 0, hLevel = 0;
         int levels = get_mip_count(w, h);
         for (int i = 1; i < levels; ++i) {
-            r3d_target_get_resolution(&wLevel, &hLevel, i);
-            glTexImage2D(GL_TEXTURE_2D, i, config->internalFormat, wLevel, hLevel, 0, config->format, config->type, NULL);
+            int wLevel = R3D_MOD_TARGET.allocW >> i;
+            int hLevel = R3D_MOD_TARGET.allocH >> i;
+            wLevel = wLevel > 1 ? wLevel : 1;
+            hLevel = hLevel > 1 ? hLevel : 1;
+            glTexImage2D(GL_TEXTURE_2D, i, internalFormat, wLevel, hLevel, 0, config->format, config->type, NULL);
         }
     }
 
@@ -79,11 +110,52 @@ static void target_load(r3d_target_t target)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, config->magFilter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
 
     R3D_MOD_TARGET.targetLoaded[target] = true;
 }
 
+/*
+ * Frees the memory of a target, it is loaded again on its next use.
+ * The texture gets a new name, the framebuffers referencing the old one are removed from the cache.
+ */
+static void target_release(r3d_target_t target)
+{
+    glDeleteTextures(1, &R3D_MOD_TARGET.targets[target]);
+    glGenTextures(1, &R3D_MOD_TARGET.targets[target]);
+    R3D_MOD_TARGET.targetLoaded[target] = false;
+
+    for (int i = R3D_MOD_TARGET.fboCount - 1; i >= 0; i--)
+    {
+        r3d_target_fbo_t* fbo = &R3D_MOD_TARGET.fbo[i];
+
+        bool referenced = false;
+        for (int j = 0; j < fbo->count; j++) {
+            referenced |= (fbo->targets[j] == target);
+        }
+
+        if (referenced) {
+            glDeleteFramebuffers(1, &fbo->id);
+            *fbo = R3D_MOD_TARGET.fbo[--R3D_MOD_TARGET.fboCount];
+        }
+    }
+
+    R3D_MOD_TARGET.currentFbo = -1;
+}
+
+/*
+ * Loads the targets released or never used, and records their use for this frame.
+ */
+static void use_targets(const r3d_target_t* targets, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (!R3D_MOD_TARGET.targetLoaded[targets[i]]) {
+            target_load(targets[i]);
+        }
+        R3D_MOD_TARGET.targetLastUse[targets[i]] = R3D_MOD_TARGET.frameIndex;
+    }
+}
+
 /*
  * Returns the index of the FBO in the cache.
  * If the combination doesn't exist, creates a new FBO and caches it.
@@ -92,6 +164,8 @@ static int get_or_create_fbo(const r3d_target_t* targets, int count)
 {
     assert(count < R3D_TARGET_MAX_ATTACHMENTS);
 
+    use_targets(targets, count);
+
     /* --- Search if the combination is already cached --- */
 
     for (int i = 0; i < R3D_MOD_TARGET.fboCount; i++) {
@@ -108,21 +182,17 @@ static int get_or_create_fbo(const r3d_target_t* targets, int count)
     r3d_target_fbo_t* fbo = &R3D_MOD_TARGET.fbo[newIndex];
 
     glGenFramebuffers(1, &fbo->id);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo->id);
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, fbo->id);
 
     GLenum glColor[R3D_TARGET_MAX_ATTACHMENTS];
     int locCount = 0;
 
     for (int i = 0; i < count; ++i)
     {
-        if (!R3D_MOD_TARGET.targetLoaded[targets[i]]) {
-            target_load(targets[i]);
-        }
-
         GLuint texture = R3D_MOD_TARGET.targets[targets[i]];
         fbo->targets[i] = targets[i];
 
-        if (targets[i] != R3D_TARGET_DEPTH) {
+        if (!is_depth_target(targets[i])) {
             GLenum attachment = GL_COLOR_ATTACHMENT0 + locCount;
             glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
             glColor[locCount++] = attachment;
@@ -159,6 +229,35 @@ static void set_viewport(r3d_target_t target)
     glViewport(0, 0, vpW, vpH);
 }
 
+// Size of the screen or RenderTexture of the blit, and the area covered by the rendered image, from the bottom left
+static void get_blit_area(int* outW, int* outH, int* dstX, int* dstY, int* dstW, int* dstH)
+{
+    if (R3D_MOD_TARGET.screen.id != 0) {
+        *outW = R3D_MOD_TARGET.screen.texture.width;
+        *outH = R3D_MOD_TARGET.screen.texture.height;
+    }
+    else {
+        *outW = GetRenderWidth();
+        *outH = GetRenderHeight();
+    }
+
+    *dstX = 0, *dstY = 0;
+    *dstW = *outW, *dstH = *outH;
+
+    if (R3D_MOD_TARGET.keepAspect) {
+        float srcRatio = (float)R3D_MOD_TARGET.allocW / R3D_MOD_TARGET.allocH;
+        float dstRatio = (float)*outW / *outH;
+        if (srcRatio > dstRatio) {
+            *dstH = (int)(*outW / srcRatio + 0.5f);
+            *dstY = (*outH - *dstH) / 2;
+        }
+        else {
+            *dstW = (int)(*outH * srcRatio + 0.5f);
+            *dstX = (*outW - *dstW) / 2;
+        }
+    }
+}
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -171,12 +270,16 @@ bool r3d_target_init(int resW, int resH)
 
     R3D_MOD_TARGET.currentFbo = -1;
 
-    R3D_MOD_TARGET.resW = resW;
-    R3D_MOD_TARGET.resH = resH;
+    R3D_MOD_TARGET.resW = R3D_MOD_TARGET.allocW = resW;
+    R3D_MOD_TARGET.resH = R3D_MOD_TARGET.allocH = resH;
 
     R3D_MOD_TARGET.txlW = 1.0f / resW;
     R3D_MOD_TARGET.txlH = 1.0f / resH;
 
+    R3D_MOD_TARGET.dynamic.minScale = 0.5f;
+    R3D_MOD_TARGET.dynamic.maxScale = 1.0f;
+    R3D_MOD_TARGET.dynamic.scale = 1.0f;
+
     return true;
 }
 
@@ -184,6 +287,14 @@ void r3d_target_quit(void)
 {
     glDeleteTextures(R3D_TARGET_COUNT, R3D_MOD_TARGET.targets);
 
+    if (R3D_MOD_TARGET.mipCounter != 0) {
+        glDeleteBuffers(1, &R3D_MOD_TARGET.mipCounter);
+    }
+
+    if (R3D_MOD_TARGET.dynamic.queries[0] != 0) {
+        glDeleteQueries(R3D_TARGET_TIMER_QUERIES, R3D_MOD_TARGET.dynamic.queries);
+    }
+
     for (int i = 0; i < R3D_MOD_TARGET.fboCount; i++) {
         glDeleteFramebuffers(1, &R3D_MOD_TARGET.fbo[i].id);
     }
@@ -193,19 +304,16 @@ void r3d_target_resize(int resW, int resH)
 {
     assert(resW > 0 && resH > 0);
 
-    if (R3D_MOD_TARGET.resW == resW && R3D_MOD_TARGET.resH == resH) {
+    if (R3D_MOD_TARGET.allocW == resW && R3D_MOD_TARGET.allocH == resH) {
         return;
     }
 
-    R3D_MOD_TARGET.resW = resW;
-    R3D_MOD_TARGET.resH = resH;
+    R3D_MOD_TARGET.resW = R3D_MOD_TARGET.allocW = resW;
+    R3D_MOD_TARGET.resH = R3D_MOD_TARGET.allocH = resH;
 
     R3D_MOD_TARGET.txlW = 1.0f / resW;
     R3D_MOD_TARGET.txlH = 1.0f / resH;
 
-    // TODO: Avoid reallocating targets if the new dimensions
-    //       are smaller than the allocated dimensions?
-
     for (int i = 0; i < R3D_TARGET_COUNT; i++) {
         if (R3D_MOD_TARGET.targetLoaded[i]) {
             target_load(i);
@@ -213,6 +321,140 @@ void r3d_target_resize(int resW, int resH)
     }
 }
 
+void r3d_target_set_compact(bool compact)
+{
+    if (R3D_MOD_TARGET.compact == compact) {
+        return;
+    }
+
+    R3D_MOD_TARGET.compact = compact;
+
+    // The textures keep their names, the framebuffers they are attached to remain valid
+    static const r3d_target_t LIGHT_TARGETS[] = { R3D_TARGET_DIFFUSE, R3D_TARGET_SPECULAR };
+    for (int i = 0; i < 2; i++) {
+        if (R3D_MOD_TARGET.targetLoaded[LIGHT_TARGETS[i]]) {
+            target_load(LIGHT_TARGETS[i]);
+        }
+    }
+}
+
+void r3d_target_set_render_scale(float scale)
+{
+    scale = fminf(fmaxf(scale, 0.0f), 1.0f);
+
+    int resW = (int)((float)R3D_MOD_TARGET.allocW * scale + 0.5f);
+    int resH = (int)((float)R3D_MOD_TARGET.allocH * scale + 0.5f);
+
+    R3D_MOD_TARGET.resW = resW > 1 ? resW : 1;
+    R3D_MOD_TARGET.resH = resH > 1 ? resH : 1;
+
+    // The viewports are only set when the FBO changes
+    R3D_MOD_TARGET.currentFbo = -1;
+}
+
+Vector2 r3d_target_get_uv_scale(void)
+{
+    return (Vector2) {
+        (float)R3D_MOD_TARGET.resW / R3D_MOD_TARGET.allocW,
+        (float)R3D_MOD_TARGET.resH / R3D_MOD_TARGET.allocH
+    };
+}
+
+void r3d_target_set_dynamic_resolution(float targetTime, float minScale)
+{
+    r3d_target_dynamic_t* dynamic = &R3D_MOD_TARGET.dynamic;
+
+    dynamic->targetTime = fmaxf(targetTime, 0.0f);
+    dynamic->minScale = fminf(fmaxf(minScale, 0.1f), 1.0f);
+    dynamic->scale = dynamic->maxScale;
+}
+
+void r3d_target_set_max_render_scale(float scale)
+{
+    r3d_target_dynamic_t* dynamic = &R3D_MOD_TARGET.dynamic;
+
+    dynamic->maxScale = fminf(fmaxf(scale, 0.1f), 1.0f);
+    dynamic->scale = fminf(dynamic->scale, dynamic->maxScale);
+}
+
+float r3d_target_update_dynamic_scale(void)
+{
+    r3d_target_dynamic_t* dynamic = &R3D_MOD_TARGET.dynamic;
+
+    float minScale = fminf(dynamic->minScale, dynamic->maxScale);
+
+    if (dynamic->targetTime <= 0.0f || dynamic->queries[0] == 0) {
+        return (dynamic->targetTime > 0.0f) ? dynamic->scale : dynamic->maxScale;
+    }
+
+    /* --- Consume the queries completed, oldest first --- */
+
+    for (int i = 0; i < R3D_TARGET_TIMER_QUERIES; i++)
+    {
+        int index = (dynamic->queryIndex + i) % R3D_TARGET_TIMER_QUERIES;
+        if (!dynamic->pending[index]) continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(dynamic->queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(dynamic->queries[index], GL_QUERY_RESULT, &elapsed);
+        dynamic->pending[index] = false;
+
+        float time = (float)((double)elapsed * 1e-6);
+        if (time <= 0.0f) continue;
+
+        // The cost mostly follows the number of pixels, hence the square root.
+        // The scale drops quickly on spikes and recovers slowly to avoid oscillations.
+        float desired = dynamic->scale * sqrtf(dynamic->targetTime / time);
+        float rate = (desired < dynamic->scale) ? 0.5f : 0.1f;
+
+        dynamic->scale += (desired - dynamic->scale) * rate;
+        dynamic->scale = fminf(fmaxf(dynamic->scale, minScale), dynamic->maxScale);
+    }
+
+    float scale = floorf(dynamic->scale / R3D_TARGET_SCALE_STEP + 0.5f) * R3D_TARGET_SCALE_STEP;
+
+    return fminf(fmaxf(scale, minScale), dynamic->maxScale);
+}
+
+void r3d_target_begin_timer(void)
+{
+    r3d_target_dynamic_t* dynamic = &R3D_MOD_TARGET.dynamic;
+
+    if (dynamic->targetTime <= 0.0f) {
+        return;
+    }
+
+    if (dynamic->queries[0] == 0) {
+        glGenQueries(R3D_TARGET_TIMER_QUERIES, dynamic->queries);
+    }
+
+    // The GPU is too far behind, this frame is not measured rather than waiting
+    if (dynamic->pending[dynamic->queryIndex]) {
+        return;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, dynamic->queries[dynamic->queryIndex]);
+    dynamic->timing = true;
+}
+
+void r3d_target_end_timer(void)
+{
+    r3d_target_dynamic_t* dynamic = &R3D_MOD_TARGET.dynamic;
+
+    if (!dynamic->timing) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+
+    dynamic->pending[dynamic->queryIndex] = true;
+    dynamic->queryIndex = (dynamic->queryIndex + 1) % R3D_TARGET_TIMER_QUERIES;
+    dynamic->timing = false;
+}
+
 void r3d_target_set_blit_screen(const RenderTexture* screen)
 {
     if (screen != NULL) R3D_MOD_TARGET.screen = *screen;
@@ -230,7 +472,7 @@ float r3d_target_get_render_aspect(void)
     float aspect = 1.0f;
 
     if (R3D_MOD_TARGET.keepAspect) {
-        aspect = (float)R3D_MOD_TARGET.resW / R3D_MOD_TARGET.resH;
+        aspect = (float)R3D_MOD_TARGET.allocW / R3D_MOD_TARGET.allocH;
     }
     else {
         if (R3D_MOD_TARGET.screen.id != 0) {
@@ -247,8 +489,8 @@ float r3d_target_get_render_aspect(void)
 
 int r3d_target_get_mip_count(void)
 {
-    int w = R3D_MOD_TARGET.resW;
-    int h = R3D_MOD_TARGET.resH;
+    int w = R3D_MOD_TARGET.allocW;
+    int h = R3D_MOD_TARGET.allocH;
 
     return get_mip_count(w, h);
 }
@@ -304,7 +546,7 @@ void r3d_target_clear(const r3d_target_t* targets, int count)
 {
     int fboIndex = get_or_create_fbo(targets, count);
     if (fboIndex != R3D_MOD_TARGET.currentFbo) {
-        glBindFramebuffer(GL_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
+        r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
         R3D_MOD_TARGET.currentFbo = fboIndex;
         set_viewport(targets[0]);
     }
@@ -312,8 +554,8 @@ void r3d_target_clear(const r3d_target_t* targets, int count)
     bool hasDepth = false;
     bool hasColor = false;
     for (int i = 0; i < count; i++) {
-        hasDepth |= (targets[i] == R3D_TARGET_DEPTH);
-        hasColor |= (targets[i] != R3D_TARGET_DEPTH);
+        hasDepth |= is_depth_target(targets[i]);
+        hasColor |= !is_depth_target(targets[i]);
     }
 
     assert(hasDepth || hasColor);
@@ -327,7 +569,7 @@ void r3d_target_clear(const r3d_target_t* targets, int count)
 
     if (hasDepth) {
         bitfield |= GL_DEPTH_BUFFER_BIT;
-        glDepthMask(GL_TRUE);
+        r3d_state_depth_mask(true);
         glClearDepth(1.0f);
     }
 
@@ -338,7 +580,7 @@ void r3d_target_bind(const r3d_target_t* targets, int count)
 {
     int fboIndex = get_or_create_fbo(targets, count);
     if (fboIndex != R3D_MOD_TARGET.currentFbo) {
-        glBindFramebuffer(GL_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
+        r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
         R3D_MOD_TARGET.currentFbo = fboIndex;
         set_viewport(targets[0]);
     }
@@ -359,13 +601,36 @@ void r3d_target_set_mip_level(int attachment, int level)
     );
 }
 
+void r3d_target_bind_image(int unit, r3d_target_t target, int level, GLenum access)
+{
+    use_targets(&target, 1);
+
+    glBindImageTexture(
+        unit, R3D_MOD_TARGET.targets[target], level,
+        GL_FALSE, 0, access, TARGET_CONFIG[target].internalFormat
+    );
+}
+
+GLuint r3d_target_get_mip_counter(void)
+{
+    if (R3D_MOD_TARGET.mipCounter == 0) {
+        GLuint zero = 0;
+        glGenBuffers(1, &R3D_MOD_TARGET.mipCounter);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, R3D_MOD_TARGET.mipCounter);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zero), &zero, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    return R3D_MOD_TARGET.mipCounter;
+}
+
 void r3d_target_gen_mipmap(r3d_target_t target)
 {
     GLuint id = r3d_target_get(target);
 
-    glBindTexture(GL_TEXTURE_2D, id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, id);
     glGenerateMipmap(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
 }
 
 GLuint r3d_target_get(r3d_target_t target)
@@ -374,11 +639,42 @@ GLuint r3d_target_get(r3d_target_t target)
         return 0;
     }
 
-    assert(R3D_MOD_TARGET.targetLoaded[target]);
+    // Targets read before being written this frame (histories, buffers queried by the user) are loaded here
+    use_targets(&target, 1);
+
     return R3D_MOD_TARGET.targets[target];
 }
 
-void r3d_target_blit(r3d_target_t target)
+void r3d_target_release_unused(void)
+{
+    uint32_t frame = R3D_MOD_TARGET.frameIndex++;
+
+    for (int i = 0; i < R3D_TARGET_COUNT; i++) {
+        if (R3D_MOD_TARGET.targetLoaded[i] && frame - R3D_MOD_TARGET.targetLastUse[i] >= R3D_TARGET_RELEASE_FRAMES) {
+            target_release(i);
+        }
+    }
+}
+
+Vector2 r3d_target_output_to_render(Vector2 point)
+{
+    int outW = 0, outH = 0;
+    int dstX = 0, dstY = 0;
+    int dstW = 0, dstH = 0;
+
+    get_blit_area(&outW, &outH, &dstX, &dstY, &dstW, &dstH);
+
+    // The output is given from the top, the blit area from the bottom
+    float x = point.x - dstX;
+    float y = (outH - point.y) - dstY;
+
+    return (Vector2) {
+        x * R3D_MOD_TARGET.resW / dstW,
+        y * R3D_MOD_TARGET.resH / dstH
+    };
+}
+
+void r3d_target_blit(r3d_target_t target, bool upscaled)
 {
     /*
      * NOTE: At this point, the frame is considered finished,
@@ -386,42 +682,25 @@ void r3d_target_blit(r3d_target_t target)
      */
     R3D_MOD_TARGET.currentFbo = -1;
 
-    unsigned int dstId = 0;
+    unsigned int dstId = R3D_MOD_TARGET.screen.id;
+    int outW = 0, outH = 0;
     int dstX = 0, dstY = 0;
     int dstW = 0, dstH = 0;
 
-    if (R3D_MOD_TARGET.screen.id != 0) {
-        dstId = R3D_MOD_TARGET.screen.id;
-        dstW = R3D_MOD_TARGET.screen.texture.width;
-        dstH = R3D_MOD_TARGET.screen.texture.height;
-    }
-    else {
-        dstW = GetRenderWidth();
-        dstH = GetRenderHeight();
-    }
-
-    if (R3D_MOD_TARGET.keepAspect) {
-        float srcRatio = (float)R3D_MOD_TARGET.resW / R3D_MOD_TARGET.resH;
-        float dstRatio = (float)dstW / dstH;
-        if (srcRatio > dstRatio) {
-            int prevH = dstH;
-            dstH = (int)(dstW / srcRatio + 0.5f);
-            dstY = (prevH - dstH) / 2;
-        }
-        else {
-            int prevW = dstW;
-            dstW = (int)(dstH * srcRatio + 0.5f);
-            dstX = (prevW - dstW) / 2;
-        }
-    }
+    get_blit_area(&outW, &outH, &dstX, &dstY, &dstW, &dstH);
 
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dstId);
+    r3d_state_bind_framebuffer(GL_DRAW_FRAMEBUFFER, dstId);
     int fboIndex = get_or_create_fbo((r3d_target_t[]){target, R3D_TARGET_DEPTH}, 2);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
+    r3d_state_bind_framebuffer(GL_READ_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
 
-    if (R3D_MOD_TARGET.blitLinear) {
+    // The rendered area is upscaled with a linear filter when smaller than the targets
+    bool scaled = (R3D_MOD_TARGET.resW != R3D_MOD_TARGET.allocW || R3D_MOD_TARGET.resH != R3D_MOD_TARGET.allocH);
+
+    if (R3D_MOD_TARGET.blitLinear || scaled) {
+        int srcW = upscaled ? R3D_MOD_TARGET.allocW : R3D_MOD_TARGET.resW;
+        int srcH = upscaled ? R3D_MOD_TARGET.allocH : R3D_MOD_TARGET.resH;
         glBlitFramebuffer(
-            0, 0, R3D_MOD_TARGET.resW, R3D_MOD_TARGET.resH,
+            0, 0, srcW, srcH,
             dstX, dstY, dstX + dstW, dstY + dstH,
             GL_COLOR_BUFFER_BIT, GL_LINEAR
         );
@@ -440,3 +719,19 @@ void r3d_target_blit(r3d_target_t target)
         );
     }
 }
+
+void r3d_target_blit_color(r3d_target_t target, GLuint dstFbo, int dstW, int dstH)
+{
+    // Same as 'r3d_target_blit()', the frame is finished here
+    R3D_MOD_TARGET.currentFbo = -1;
+
+    r3d_state_bind_framebuffer(GL_DRAW_FRAMEBUFFER, dstFbo);
+    int fboIndex = get_or_create_fbo((r3d_target_t[]){target, R3D_TARGET_DEPTH}, 2);
+    r3d_state_bind_framebuffer(GL_READ_FRAMEBUFFER, R3D_MOD_TARGET.fbo[fboIndex].id);
+
+    glBlitFramebuffer(
+        0, 0, R3D_MOD_TARGET.resW, R3D_MOD_TARGET.resH,
+        0, 0, dstW, dstH,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR
+    );
+}
@@ -20,6 +20,7 @@
  * Enums for all internal render targets.
  * To add a new target, define a new enum before `R3D_TARGET_DEPTH`,
  * then add its creation parameters in `TARGET_CONFIG` in `r3d_target.c`.
+ * Depth targets are attached as depth and must be given last when binding.
  * Loading happens on-demand during bind operations.
  */
 typedef enum {
@@ -31,12 +32,27 @@ typedef enum {
     R3D_TARGET_SPECULAR,        //< Full - Mip 1 - RGB[16|16|16]
     R3D_TARGET_SSAO_0,          //< Half - Mip 1 - R[8]
     R3D_TARGET_SSAO_1,          //< Half - Mip 1 - R[8]
+    R3D_TARGET_SSAO_HISTORY_0,  //< Half - Mip 1 - RG[16|16]
+    R3D_TARGET_SSAO_HISTORY_1,  //< Half - Mip 1 - RG[16|16]
     R3D_TARGET_SSIL_0,          //< Half - Mip 1 - RGBA[16|16|16|16]
     R3D_TARGET_SSIL_1,          //< Half - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_SSIL_SPARSE,     //< Quarter - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_SSIL_HISTORY_0,  //< Half - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_SSIL_HISTORY_1,  //< Half - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_SSIL_GEOMETRY_0, //< Half - Mip 1 - RGB[16|16|16]
+    R3D_TARGET_SSIL_GEOMETRY_1, //< Half - Mip 1 - RGB[16|16|16]
     R3D_TARGET_SSR,             //< Half - Mip N - RGBA[16|16|16|16]
-    R3D_TARGET_BLOOM,           //< Full - Mip N - RGB[16|16|16]
+    R3D_TARGET_BLOOM,           //< Full - Mip N - RGBA[16|16|16|16]
     R3D_TARGET_SCENE_0,         //< Full - Mip 1 - RGB[16|16|16]
     R3D_TARGET_SCENE_1,         //< Full - Mip 1 - RGB[16|16|16]
+    R3D_TARGET_TAA_HISTORY_0,   //< Full - Mip 1 - RGB[16|16|16]
+    R3D_TARGET_TAA_HISTORY_1,   //< Full - Mip 1 - RGB[16|16|16]
+    R3D_TARGET_OIT_ACCUM,       //< Full - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_OIT_WEIGHT,      //< Full - Mip 1 - R[16]
+    R3D_TARGET_REDUCED_HALF,    //< Half - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_REDUCED_QUARTER, //< Quarter - Mip 1 - RGBA[16|16|16|16]
+    R3D_TARGET_DEPTH_HALF,      //< Half - Mip 1 - D[24]
+    R3D_TARGET_DEPTH_QUARTER,   //< Quarter - Mip 1 - D[24]
     R3D_TARGET_DEPTH,           //< Full - Mip 1 - D[24]
     R3D_TARGET_COUNT
 } r3d_target_t;
@@ -73,6 +89,9 @@ typedef enum {
 #define R3D_TARGET_HEIGHT       R3D_MOD_TARGET.resH
 #define R3D_TARGET_RESOLUTION   R3D_MOD_TARGET.resW, R3D_MOD_TARGET.resH
 
+#define R3D_TARGET_ALLOC_WIDTH  R3D_MOD_TARGET.allocW
+#define R3D_TARGET_ALLOC_HEIGHT R3D_MOD_TARGET.allocH
+
 #define R3D_TARGET_TEXEL_WIDTH  R3D_MOD_TARGET.txlW
 #define R3D_TARGET_TEXEL_HEIGHT R3D_MOD_TARGET.txlH
 #define R3D_TARGET_TEXEL_SIZE   R3D_MOD_TARGET.txlW, R3D_MOD_TARGET.txlH
@@ -122,6 +141,7 @@ typedef enum {
 
 #define R3D_TARGET_MAX_FRAMEBUFFERS 32
 #define R3D_TARGET_MAX_ATTACHMENTS  8
+#define R3D_TARGET_RELEASE_FRAMES   120     //< Frames a target can stay unused before its memory is freed
 
 typedef struct {
     GLuint id;
@@ -129,6 +149,28 @@ typedef struct {
     int count;
 } r3d_target_fbo_t;
 
+// ========================================
+// DYNAMIC RESOLUTION
+// ========================================
+
+#define R3D_TARGET_TIMER_QUERIES    4       //< Frames the GPU time can be read back late
+#define R3D_TARGET_SCALE_STEP       0.025f  //< Granularity of the render scale, avoids resizing the viewports every frame
+
+/*
+ * Render scale controller fed by GPU timer queries.
+ * The queries are read back a few frames late without waiting for them.
+ */
+typedef struct {
+    GLuint queries[R3D_TARGET_TIMER_QUERIES];   //< Ring of time elapsed queries, created on first use
+    bool pending[R3D_TARGET_TIMER_QUERIES];     //< The query has been issued and not read back yet
+    int queryIndex;                             //< Next query of the ring to issue
+    bool timing;                                //< A query is running for the current frame
+    float targetTime;                           //< GPU time aimed for per frame in milliseconds, zero when disabled
+    float minScale;                             //< Lowest render scale allowed
+    float maxScale;                             //< Render scale used when disabled, highest one allowed otherwise
+    float scale;                                //< Unquantized render scale chosen by the controller
+} r3d_target_dynamic_t;
+
 // ========================================
 // MODULE STATE
 // ========================================
@@ -141,12 +183,20 @@ extern struct r3d_target {
 
     bool targetLoaded[R3D_TARGET_COUNT];
     GLuint targets[R3D_TARGET_COUNT];
+    uint32_t targetLastUse[R3D_TARGET_COUNT];           //< Frame each target was last bound or sampled
+    uint32_t frameIndex;                                //< Frames ended, see 'r3d_target_release_unused()'
+
+    GLuint mipCounter;                                  //< Atomic counter of the single dispatch mip chains, created on first use
+
+    r3d_target_dynamic_t dynamic;                       //< Dynamic resolution controller
 
     RenderTexture screen;
-    uint32_t resW, resH;
-    float txlW, txlH;
+    uint32_t resW, resH;                                //< Rendered resolution, the bottom left area of the targets
+    uint32_t allocW, allocH;                            //< Resolution the targets are allocated with
+    float txlW, txlH;                                   //< Texel size of the allocated targets
     bool keepAspect;
     bool blitLinear;
+    bool compact;                                       //< The light accumulation targets are stored as R11F_G11F_B10F
 
 } R3D_MOD_TARGET;
 
@@ -173,6 +223,55 @@ void r3d_target_quit(void);
  */
 void r3d_target_resize(int resW, int resH);
 
+/*
+ * Frees the targets unused for 'R3D_TARGET_RELEASE_FRAMES' frames, those of the effects disabled.
+ * They are loaded again on demand, like on their first use. Called once at the end of each frame.
+ */
+void r3d_target_release_unused(void);
+
+/*
+ * Switches the diffuse and specular targets to R11F_G11F_B10F, or back to RGBA16F.
+ * The targets already allocated are reallocated, their content is lost.
+ */
+void r3d_target_set_compact(bool compact);
+
+/*
+ * Renders into the bottom left area of the targets, scaled from their allocated resolution.
+ * No target is reallocated, the viewports, the blit and 'uvScale' of the view block follow it.
+ * Must be called outside of the passes, the FBO cache is reset to apply the new viewports.
+ */
+void r3d_target_set_render_scale(float scale);
+
+/*
+ * Returns the fraction of the targets covered by the rendered area, per axis.
+ */
+Vector2 r3d_target_get_uv_scale(void);
+
+/*
+ * Enables the dynamic resolution with a GPU time to aim for per frame,
+ * or disables it with a target time of zero and goes back to the full resolution.
+ */
+void r3d_target_set_dynamic_resolution(float targetTime, float minScale);
+
+/*
+ * Sets the highest render scale, the one used when the dynamic resolution is disabled.
+ */
+void r3d_target_set_max_render_scale(float scale);
+
+/*
+ * Reads back the GPU times available and returns the render scale to use for the next frame.
+ * Returns the highest render scale when the dynamic resolution is disabled.
+ */
+float r3d_target_update_dynamic_scale(void);
+
+/*
+ * Measures the GPU time of the commands issued until 'r3d_target_end_timer()'.
+ * Does nothing when the dynamic resolution is disabled, or when all the queries are still pending.
+ */
+void r3d_target_begin_timer(void);
+
+void r3d_target_end_timer(void);
+
 /*
  * Defines the target where the blit is performed.
  * Also uses the associated data to determine the aspect ratio.
@@ -193,17 +292,18 @@ float r3d_target_get_render_aspect(void);
 
 /*
  * Returns the total number of mip levels of the internal buffers
- * based on their full resolution.
+ * based on their allocated resolution.
  */
 int r3d_target_get_mip_count(void);
 
 /*
- * Returns the internal resolution for the specified mip level.
+ * Returns the rendered resolution for the specified mip level.
+ * Used for the viewports, it is smaller than the targets with dynamic resolution.
  */
 void r3d_target_get_resolution(int* w, int* h, int level);
 
 /*
- * Returns the texel size for the specified mip level.
+ * Returns the texel size of the allocated targets for the specified mip level.
  */
 void r3d_target_get_texel_size(float* w, float* h, int level);
 
@@ -245,6 +345,18 @@ void r3d_target_bind(const r3d_target_t* targets, int count);
  */
 void r3d_target_set_mip_level(int attachment, int level);
 
+/*
+ * Binds a level of the target to an image unit, loading the target if needed.
+ * The format of the image is the internal format of the target. Requires OpenGL 4.3.
+ */
+void r3d_target_bind_image(int unit, r3d_target_t target, int level, GLenum access);
+
+/*
+ * Returns the storage buffer holding the counter used by the single dispatch mip chains
+ * to find their last work group. The shaders reset it to zero once done. Requires OpenGL 4.3.
+ */
+GLuint r3d_target_get_mip_counter(void);
+
 /*
  * Generates mipmaps for the specified target.
  * Asserts that the target has already been created.
@@ -254,15 +366,29 @@ void r3d_target_gen_mipmap(r3d_target_t target);
 /*
  * Returns the texture ID corresponding to the requested target.
  * Returns 0 if the target enum is invalid.
- * Asserts that the requested target has been created.
- * If not created yet, it means we never bound this target, so it would be empty.
+ * Loads the target if it has been released or never bound, its content is then undefined.
  */
 GLuint r3d_target_get(r3d_target_t target);
 
 /*
- * Blits mip 0 of the specified target to the screen or RenderTexture2D
- * set in the module state.
+ * Converts a point given in pixels of the screen or RenderTexture of the blit, from the top left,
+ * to pixels of the rendered area of the targets, from the bottom left. Follows the letterboxing
+ * of 'R3D_FLAG_ASPECT_KEEP' and the render scale, the result may lie outside of the rendered area.
+ */
+Vector2 r3d_target_output_to_render(Vector2 point);
+
+/*
+ * Blits the rendered area of mip 0 of the specified target to the screen
+ * or RenderTexture2D set in the module state, upscaled if needed.
+ * When 'upscaled' is true, the color of the target already covers the whole
+ * allocated resolution, only the depth is taken from the rendered area.
+ */
+void r3d_target_blit(r3d_target_t target, bool upscaled);
+
+/*
+ * Blits only the color of the rendered area of mip 0 of the specified target,
+ * stretched with linear filtering over the whole given framebuffer.
  */
-void r3d_target_blit(r3d_target_t target);
+void r3d_target_blit_color(r3d_target_t target, GLuint dstFbo, int dstW, int dstH);
 
 #endif // R3D_MODULE_TARGET_H
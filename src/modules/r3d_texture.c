@@ -7,10 +7,17 @@
  */
 
 #include "./r3d_texture.h"
+
+#include <tinycthread.h>
 #include <raymath.h>
+#include <uthash.h>
 #include <stdint.h>
 #include <string.h>
+#include <rlgl.h>
 #include <glad.h>
+#include <math.h>
+
+#include "./r3d_state.h"
 
 // ========================================
 // TEXTURE DATA INCLUDES
@@ -22,9 +29,42 @@
 // MODULE STATE
 // ========================================
 
+typedef struct {
+    uint64_t key;
+    GLuint id;
+    Texture2D texture;
+    int refCount;
+    UT_hash_handle hh;          // Indexed by key
+    UT_hash_handle hhId;        // Indexed by texture id
+} r3d_shared_texture_t;
+
+typedef struct {
+    GLuint id;
+    Image image;                                        // Whole mipmap chain, kept to upload the finer levels
+    unsigned int glInternalFormat, glFormat, glType;
+    size_t offsets[R3D_TEXTURE_STREAM_MAX_LEVELS];      // Offset of each level in the image data
+    int baseLevel;                                      // Coarsest level uploaded up front, never released
+    int residentLevel;                                  // Finest level uploaded, used as GL_TEXTURE_BASE_LEVEL
+    int requestedLevel;                                 // Finest level requested since the last update
+    int wantedLevel;                                    // Level the texture converges to
+    uint32_t requestFrame;                              // Last update with a request
+    UT_hash_handle hh;                                  // Indexed by texture id
+} r3d_streamed_texture_t;
+
 static struct r3d_texture {
     GLuint textures[R3D_TEXTURE_COUNT];
     bool loaded[R3D_TEXTURE_COUNT];
+
+    // Textures shared between the loaded models, the importers look them up from their threads
+    r3d_shared_texture_t* sharedByKey;
+    r3d_shared_texture_t* sharedById;
+    mtx_t sharedLock;
+
+    // Textures whose finer levels are uploaded on demand, only used by the thread owning the context
+    r3d_streamed_texture_t* streamed;
+    size_t streamedBytes;                               // Memory of the levels uploaded
+    size_t streamBudget;                                // Memory allowed to the levels, zero for no limit
+    uint32_t streamFrame;                               // Incremented by each update
 } R3D_MOD_TEXTURE;
 
 // ========================================
@@ -68,38 +108,132 @@ static const texture_loader_func LOADERS[] = {
 
 void load_white(void) {
     const uint8_t px[4] = {255, 255, 255, 255};
-    glBindTexture(GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_WHITE]);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_WHITE]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
     tex_params(GL_TEXTURE_2D, GL_NEAREST, GL_CLAMP_TO_EDGE);
 }
 
 void load_black(void) {
     const uint8_t px[4] = {0, 0, 0, 255};
-    glBindTexture(GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_BLACK]);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_BLACK]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
     tex_params(GL_TEXTURE_2D, GL_NEAREST, GL_CLAMP_TO_EDGE);
 }
 
 void load_blank(void) {
     const uint8_t px[4] = {0, 0, 0, 0};
-    glBindTexture(GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_BLANK]);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_BLANK]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
     tex_params(GL_TEXTURE_2D, GL_NEAREST, GL_CLAMP_TO_EDGE);
 }
 
 void load_normal(void) {
     const uint8_t px[4] = {127, 127, 255, 0};
-    glBindTexture(GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_NORMAL]);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_NORMAL]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
     tex_params(GL_TEXTURE_2D, GL_NEAREST, GL_CLAMP_TO_EDGE);
 }
 
 void load_ibl_brdf_lut(void) {
-    glBindTexture(GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_IBL_BRDF_LUT]);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, R3D_MOD_TEXTURE.textures[R3D_TEXTURE_IBL_BRDF_LUT]);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_HALF_FLOAT, BRDF_LUT_512_RG16_FLOAT_RAW);
     tex_params(GL_TEXTURE_2D, GL_LINEAR, GL_CLAMP_TO_EDGE);
 }
 
+// ========================================
+// STREAMING FUNCTIONS
+// ========================================
+
+static inline int level_dim(int size, int level)
+{
+    return (size >> level) > 1 ? (size >> level) : 1;
+}
+
+static size_t level_size(const r3d_streamed_texture_t* entry, int level)
+{
+    const Image* image = &entry->image;
+    return GetPixelDataSize(level_dim(image->width, level), level_dim(image->height, level), image->format);
+}
+
+static void upload_level(const r3d_streamed_texture_t* entry, int level)
+{
+    const Image* image = &entry->image;
+    const uint8_t* data = (const uint8_t*)image->data + entry->offsets[level];
+    int w = level_dim(image->width, level);
+    int h = level_dim(image->height, level);
+
+    if (image->format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        GLsizei size = (GLsizei)level_size(entry, level);
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry->glInternalFormat, w, h, 0, size, data);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, level, entry->glInternalFormat, w, h, 0, entry->glFormat, entry->glType, data);
+    }
+}
+
+static void refine_level(r3d_streamed_texture_t* entry)
+{
+    int level = entry->residentLevel - 1;
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, entry->id);
+    upload_level(entry, level);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+
+    entry->residentLevel = level;
+    R3D_MOD_TEXTURE.streamedBytes += level_size(entry, level);
+}
+
+static void release_level(r3d_streamed_texture_t* entry)
+{
+    int level = entry->residentLevel;
+
+    // The level leaves the sampled range first, then its storage is redefined empty
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, entry->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+
+    if (entry->image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, entry->glInternalFormat, 0, 0, 0, 0, NULL);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, level, entry->glInternalFormat, 0, 0, 0, entry->glFormat, entry->glType, NULL);
+    }
+
+    entry->residentLevel = level + 1;
+    R3D_MOD_TEXTURE.streamedBytes -= level_size(entry, level);
+}
+
+// Releases the levels finer than wanted until 'required' bytes fit in the budget
+static bool make_room(size_t required, const r3d_streamed_texture_t* keep)
+{
+    size_t budget = R3D_MOD_TEXTURE.streamBudget;
+
+    r3d_streamed_texture_t *entry, *tmp;
+    HASH_ITER(hh, R3D_MOD_TEXTURE.streamed, entry, tmp) {
+        if (R3D_MOD_TEXTURE.streamedBytes + required <= budget) break;
+        if (entry == keep) continue;
+        while (entry->residentLevel < entry->wantedLevel && R3D_MOD_TEXTURE.streamedBytes + required > budget) {
+            release_level(entry);
+        }
+    }
+
+    return R3D_MOD_TEXTURE.streamedBytes + required <= budget;
+}
+
+static void forget_streamed(GLuint id)
+{
+    r3d_streamed_texture_t* entry = NULL;
+    HASH_FIND(hh, R3D_MOD_TEXTURE.streamed, &id, sizeof(GLuint), entry);
+    if (entry == NULL) return;
+
+    for (int i = entry->residentLevel; i < entry->image.mipmaps; i++) {
+        R3D_MOD_TEXTURE.streamedBytes -= level_size(entry, i);
+    }
+
+    HASH_DELETE(hh, R3D_MOD_TEXTURE.streamed, entry);
+    UnloadImage(entry->image);
+    RL_FREE(entry);
+}
+
 // ========================================
 // MODULE FUNCTIONS
 // ========================================
@@ -107,11 +241,29 @@ void load_ibl_brdf_lut(void) {
 bool r3d_texture_init(void) {
     memset(&R3D_MOD_TEXTURE, 0, sizeof(R3D_MOD_TEXTURE));
     glGenTextures(R3D_TEXTURE_COUNT, R3D_MOD_TEXTURE.textures);
+    mtx_init(&R3D_MOD_TEXTURE.sharedLock, mtx_plain);
     return true;
 }
 
 void r3d_texture_quit(void) {
     glDeleteTextures(R3D_TEXTURE_COUNT, R3D_MOD_TEXTURE.textures);
+
+    // The shared textures still referenced belong to the materials of the user
+    r3d_shared_texture_t *entry, *tmp;
+    HASH_ITER(hh, R3D_MOD_TEXTURE.sharedByKey, entry, tmp) {
+        HASH_DELETE(hhId, R3D_MOD_TEXTURE.sharedById, entry);
+        HASH_DELETE(hh, R3D_MOD_TEXTURE.sharedByKey, entry);
+        RL_FREE(entry);
+    }
+
+    mtx_destroy(&R3D_MOD_TEXTURE.sharedLock);
+
+    r3d_streamed_texture_t *streamed, *tmpStreamed;
+    HASH_ITER(hh, R3D_MOD_TEXTURE.streamed, streamed, tmpStreamed) {
+        HASH_DELETE(hh, R3D_MOD_TEXTURE.streamed, streamed);
+        UnloadImage(streamed->image);
+        RL_FREE(streamed);
+    }
 }
 
 bool r3d_texture_is_default(GLuint id) {
@@ -128,3 +280,213 @@ GLuint r3d_texture_get(r3d_texture_t texture) {
     }
     return R3D_MOD_TEXTURE.textures[texture];
 }
+
+bool r3d_texture_acquire_shared(uint64_t key, Texture2D* texture) {
+    mtx_lock(&R3D_MOD_TEXTURE.sharedLock);
+
+    r3d_shared_texture_t* entry = NULL;
+    HASH_FIND(hh, R3D_MOD_TEXTURE.sharedByKey, &key, sizeof(uint64_t), entry);
+    if (entry != NULL) {
+        *texture = entry->texture;
+        entry->refCount++;
+    }
+
+    mtx_unlock(&R3D_MOD_TEXTURE.sharedLock);
+
+    return entry != NULL;
+}
+
+Texture2D r3d_texture_share(uint64_t key, Texture2D texture) {
+    mtx_lock(&R3D_MOD_TEXTURE.sharedLock);
+
+    // The same sources may have been loaded concurrently by another import
+    r3d_shared_texture_t* entry = NULL;
+    HASH_FIND(hh, R3D_MOD_TEXTURE.sharedByKey, &key, sizeof(uint64_t), entry);
+    if (entry != NULL) {
+        Texture2D shared = entry->texture;
+        entry->refCount++;
+        mtx_unlock(&R3D_MOD_TEXTURE.sharedLock);
+        forget_streamed(texture.id);
+        UnloadTexture(texture);
+        return shared;
+    }
+
+    entry = RL_CALLOC(1, sizeof(r3d_shared_texture_t));
+    if (entry != NULL) {
+        entry->key = key;
+        entry->id = texture.id;
+        entry->texture = texture;
+        entry->refCount = 1;
+        HASH_ADD(hh, R3D_MOD_TEXTURE.sharedByKey, key, sizeof(uint64_t), entry);
+        HASH_ADD(hhId, R3D_MOD_TEXTURE.sharedById, id, sizeof(GLuint), entry);
+    }
+
+    mtx_unlock(&R3D_MOD_TEXTURE.sharedLock);
+
+    return texture;
+}
+
+void r3d_texture_release(GLuint id) {
+    if (id == 0 || r3d_texture_is_default(id)) {
+        return;
+    }
+
+    mtx_lock(&R3D_MOD_TEXTURE.sharedLock);
+
+    r3d_shared_texture_t* entry = NULL;
+    HASH_FIND(hhId, R3D_MOD_TEXTURE.sharedById, &id, sizeof(GLuint), entry);
+
+    bool unload = (entry == NULL || --entry->refCount == 0);
+    if (entry != NULL && unload) {
+        HASH_DELETE(hhId, R3D_MOD_TEXTURE.sharedById, entry);
+        HASH_DELETE(hh, R3D_MOD_TEXTURE.sharedByKey, entry);
+        RL_FREE(entry);
+    }
+
+    mtx_unlock(&R3D_MOD_TEXTURE.sharedLock);
+
+    if (unload) {
+        forget_streamed(id);
+        glDeleteTextures(1, &id);
+    }
+}
+
+Texture2D r3d_texture_load_streamed(Image image) {
+    Texture2D texture = {0};
+
+    int largest = (image.width > image.height) ? image.width : image.height;
+    if (image.data == NULL || image.mipmaps <= 1 || image.mipmaps > R3D_TEXTURE_STREAM_MAX_LEVELS ||
+        largest <= R3D_TEXTURE_STREAM_BASE_SIZE) {
+        return texture;
+    }
+
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    rlGetGlTextureFormats(image.format, &glInternalFormat, &glFormat, &glType);
+    if (glInternalFormat == 0) {
+        return texture;
+    }
+
+    r3d_streamed_texture_t* entry = RL_CALLOC(1, sizeof(r3d_streamed_texture_t));
+    if (entry == NULL) {
+        return texture;
+    }
+
+    entry->image = image;
+    entry->glInternalFormat = glInternalFormat;
+    entry->glFormat = glFormat;
+    entry->glType = glType;
+
+    size_t offset = 0;
+    for (int i = 0; i < image.mipmaps; i++) {
+        entry->offsets[i] = offset;
+        offset += level_size(entry, i);
+    }
+
+    // Coarsest level needed to draw the texture, the first one within the base size
+    int base = 0;
+    while (base < image.mipmaps - 1 && (largest >> base) > R3D_TEXTURE_STREAM_BASE_SIZE) {
+        base++;
+    }
+
+    entry->baseLevel = base;
+    entry->residentLevel = base;
+    entry->requestedLevel = base;
+    entry->wantedLevel = base;
+    entry->requestFrame = R3D_MOD_TEXTURE.streamFrame;
+
+    glGenTextures(1, &entry->id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, entry->id);
+
+    // The rows of the small levels are not aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int i = base; i < image.mipmaps; i++) {
+        upload_level(entry, i);
+        R3D_MOD_TEXTURE.streamedBytes += level_size(entry, i);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.mipmaps - 1);
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
+
+    HASH_ADD(hh, R3D_MOD_TEXTURE.streamed, id, sizeof(GLuint), entry);
+
+    texture.id = entry->id;
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.mipmaps = image.mipmaps;
+    texture.format = image.format;
+
+    return texture;
+}
+
+bool r3d_texture_has_streamed(void) {
+    return R3D_MOD_TEXTURE.streamed != NULL;
+}
+
+void r3d_texture_stream_request(GLuint id, float pixels) {
+    if (id == 0 || R3D_MOD_TEXTURE.streamed == NULL) {
+        return;
+    }
+
+    r3d_streamed_texture_t* entry = NULL;
+    HASH_FIND(hh, R3D_MOD_TEXTURE.streamed, &id, sizeof(GLuint), entry);
+    if (entry == NULL) return;
+
+    // One texel per pixel along the largest side
+    int largest = (entry->image.width > entry->image.height) ? entry->image.width : entry->image.height;
+    int level = 0;
+    if (pixels < (float)largest) {
+        level = (int)floorf(log2f((float)largest / fmaxf(pixels, 1.0f)));
+    }
+
+    if (level > entry->baseLevel) level = entry->baseLevel;
+    if (level < entry->requestedLevel) entry->requestedLevel = level;
+
+    entry->requestFrame = R3D_MOD_TEXTURE.streamFrame;
+}
+
+void r3d_texture_stream_update(void) {
+    uint32_t frame = R3D_MOD_TEXTURE.streamFrame++;
+    size_t uploadBudget = R3D_TEXTURE_STREAM_UPLOAD_BYTES;
+    bool uploaded = false;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    r3d_streamed_texture_t *entry, *tmp;
+
+    /* --- The textures follow their requests, the ones left unused fall back to their base level --- */
+
+    HASH_ITER(hh, R3D_MOD_TEXTURE.streamed, entry, tmp) {
+        if (entry->requestFrame == frame) entry->wantedLevel = entry->requestedLevel;
+        else if (frame - entry->requestFrame > R3D_TEXTURE_STREAM_KEEP_FRAMES) entry->wantedLevel = entry->baseLevel;
+        entry->requestedLevel = entry->baseLevel;
+    }
+
+    /* --- One finer level per texture and per frame, so that all textures refine together --- */
+
+    HASH_ITER(hh, R3D_MOD_TEXTURE.streamed, entry, tmp) {
+        if (entry->residentLevel <= entry->wantedLevel) continue;
+
+        size_t size = level_size(entry, entry->residentLevel - 1);
+
+        // A level larger than the whole upload budget is only allowed alone
+        if (size > uploadBudget && uploaded) break;
+
+        if (R3D_MOD_TEXTURE.streamBudget > 0 && !make_room(size, entry)) {
+            continue;
+        }
+
+        refine_level(entry);
+
+        uploadBudget = (size < uploadBudget) ? uploadBudget - size : 0;
+        uploaded = true;
+    }
+
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
+}
+
+void r3d_texture_stream_set_budget(size_t bytes) {
+    R3D_MOD_TEXTURE.streamBudget = bytes;
+}
@@ -10,6 +10,8 @@
 #define R3D_MODULE_TEXTURE_H
 
 #include <raylib.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <glad.h>
 
 // ========================================
@@ -25,6 +27,15 @@ typedef enum {
     R3D_TEXTURE_COUNT
 } r3d_texture_t;
 
+// ========================================
+// STREAMING CONSTANTS
+// ========================================
+
+#define R3D_TEXTURE_STREAM_BASE_SIZE        128         //< Largest level uploaded up front by the streamed textures
+#define R3D_TEXTURE_STREAM_MAX_LEVELS       16          //< Levels of the largest streamed texture
+#define R3D_TEXTURE_STREAM_UPLOAD_BYTES     (8 << 20)   //< Bytes of finer levels uploaded per frame at most
+#define R3D_TEXTURE_STREAM_KEEP_FRAMES      120         //< Frames a texture keeps its levels wanted after its last request
+
 // ========================================
 // HELPER MACROS
 // ========================================
@@ -59,4 +70,58 @@ bool r3d_texture_is_default(GLuint id);
  */
 GLuint r3d_texture_get(r3d_texture_t texture);
 
+/*
+ * Looks up a shared texture by the key of its sources and takes a reference on it.
+ * Returns false if no texture is registered with this key.
+ * Can be called from any thread.
+ */
+bool r3d_texture_acquire_shared(uint64_t key, Texture2D* texture);
+
+/*
+ * Registers a texture with one reference under the key of its sources.
+ * If the key is already registered, the given texture is deleted and the
+ * registered one is returned with a new reference.
+ */
+Texture2D r3d_texture_share(uint64_t key, Texture2D texture);
+
+/*
+ * Releases a texture that may be shared.
+ * Shared textures are deleted with their last reference, the others
+ * immediately, and the default textures are ignored.
+ */
+void r3d_texture_release(GLuint id);
+
+/*
+ * Creates a streamed texture from an image holding its whole mipmap chain.
+ * Only the levels up to `R3D_TEXTURE_STREAM_BASE_SIZE` texels are uploaded, the finer ones
+ * are uploaded by `r3d_texture_stream_update()` once the draws request them.
+ * The module takes the image on success, it is released with the texture.
+ * Returns a texture with a zero id if the image is too small or has no mipmaps.
+ */
+Texture2D r3d_texture_load_streamed(Image image);
+
+/*
+ * Returns true if any streamed texture is loaded.
+ */
+bool r3d_texture_has_streamed(void);
+
+/*
+ * Requests the level of a streamed texture that covers 'pixels' on screen with one texel per pixel.
+ * The finest level requested during the frame is kept, other textures are ignored.
+ */
+void r3d_texture_stream_request(GLuint id, float pixels);
+
+/*
+ * Uploads the finer levels requested since the last update, up to `R3D_TEXTURE_STREAM_UPLOAD_BYTES`.
+ * Over the budget, the levels no longer requested are released first, the textures that
+ * cannot fit keep their coarser levels until memory is available.
+ * Called once per frame by `R3D_End()`
+ */
+void r3d_texture_stream_update(void);
+
+/*
+ * Sets the memory allowed to the levels of the streamed textures, zero for no limit.
+ */
+void r3d_texture_stream_set_budget(size_t bytes);
+
 #endif // R3D_MODULE_TEXTURE_H
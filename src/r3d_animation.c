@@ -9,10 +9,33 @@
 #include <r3d/r3d_animation.h>
 #include <raymath.h>
 #include <string.h>
+#include <float.h>
 #include <glad.h>
 
+#include <tinycthread.h>
+#include <stdatomic.h>
+
 #include "./importer/r3d_importer.h"
 #include "./details/r3d_math.h"
+#include "./details/r3d_keyframe.h"
+#include "./details/r3d_cpu.h"
+#include "./modules/r3d_cache.h"
+#include "./modules/r3d_draw.h"
+#include "./modules/r3d_skin.h"
+
+// ========================================
+// CONSTANTS
+// ========================================
+
+// Fewer players per worker would cost more in thread creation than it saves
+#define ANIMATION_PLAYERS_PER_THREAD 16
+
+// Keys scanned forward from the cursor before falling back to a binary search
+#define ANIMATION_CURSOR_MAX_SCAN 4
+
+// Texels before the animations in the table of a baked library, the first one holds the bone count
+// NOTE: The table layout must match 'BakedPoseOffset()' in the skinned vertex shaders
+#define ANIMATION_BAKED_TABLE_HEADER 1
 
 // ========================================
 // PUBLIC API
@@ -31,7 +54,7 @@ R3D_AnimationLib R3D_LoadAnimationLib(const char* filePath)
         return animLib;
     }
 
-    r3d_importer_load_animations(&importer, &animLib);
+    r3d_importer_load_animations(&importer, &animLib, R3D_CACHE_GET(animationTolerance));
     r3d_importer_destroy(&importer);
 
     return animLib;
@@ -46,7 +69,7 @@ R3D_AnimationLib R3D_LoadAnimationLibFromMemory(const void* data, unsigned int s
         return animLib;
     }
 
-    r3d_importer_load_animations(&importer, &animLib);
+    r3d_importer_load_animations(&importer, &animLib, R3D_CACHE_GET(animationTolerance));
     r3d_importer_destroy(&importer);
 
     return animLib;
@@ -112,25 +135,73 @@ R3D_AnimationPlayer* R3D_LoadAnimationPlayer(const R3D_Skeleton* skeleton, const
     player->localPose = RL_CALLOC(skeleton->boneCount, sizeof(Matrix));
     player->globalPose = RL_CALLOC(skeleton->boneCount, sizeof(Matrix));
 
-    glGenTextures(1, &player->texGlobalPose);
-    glBindTexture(GL_TEXTURE_1D, player->texGlobalPose);
-    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA32F, 4 * skeleton->boneCount, 0, GL_RGBA, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_1D, 0);
+    // Resolved once, the channels of each animation are not ordered by bone
+    player->channelMap = RL_MALLOC(animLib->count * skeleton->boneCount * sizeof(int));
+    for (int i = 0; i < animLib->count * skeleton->boneCount; i++) {
+        player->channelMap[i] = -1;
+    }
+    for (int iAnim = 0; iAnim < animLib->count; iAnim++) {
+        const R3D_Animation* anim = &animLib->animations[iAnim];
+        for (int iChannel = anim->channelCount - 1; iChannel >= 0; iChannel--) {
+            int iBone = anim->channels[iChannel].boneIndex;
+            if (iBone >= 0 && iBone < skeleton->boneCount) {
+                player->channelMap[iAnim * skeleton->boneCount + iBone] = iChannel;
+            }
+        }
+    }
+
+    player->keyCursors = RL_CALLOC(3 * animLib->count * skeleton->boneCount, sizeof(uint32_t));
+
+    // Constant for each root bone, the bind pose never changes
+    player->rootParentPose = RL_MALLOC(skeleton->boneCount * sizeof(Matrix));
+    for (int iBone = 0; iBone < skeleton->boneCount; iBone++) {
+        player->rootParentPose[iBone] = R3D_MATRIX_IDENTITY;
+        if (skeleton->bones[iBone].parent < 0) {
+            Matrix invLocalBind = MatrixInvert(skeleton->bindLocal[iBone]);
+            player->rootParentPose[iBone] = r3d_matrix_multiply(&invLocalBind, &skeleton->bindPose[iBone]);
+        }
+    }
+
+    // The bind pose is drawn until the first pose is calculated
+    for (int iBone = 0; iBone < skeleton->boneCount; iBone++) {
+        player->globalPose[iBone] = R3D_MATRIX_IDENTITY;
+    }
+
+    player->poseOffset = r3d_skin_alloc(skeleton->boneCount);
+    r3d_skin_write(player->poseOffset, player->globalPose, skeleton->boneCount);
+
+    // Full detail until the renderer records the player, considered drawn by the last frame
+    player->lod = (R3D_AnimationLod) {0};
+    player->lodScreenSize = FLT_MAX;
+    player->lodFrame = R3D_MOD_DRAW.frameIndex - 1;
+
+    player->leafBones = RL_MALLOC(skeleton->boneCount * sizeof(bool));
+    for (int iBone = 0; iBone < skeleton->boneCount; iBone++) {
+        player->leafBones[iBone] = true;
+    }
+    for (int iBone = 0; iBone < skeleton->boneCount; iBone++) {
+        int parent = skeleton->bones[iBone].parent;
+        if (parent >= 0) player->leafBones[parent] = false;
+    }
+
+    player->skipLeafBones = false;
+    player->reducedPoses = RL_MALLOC(2 * skeleton->boneCount * sizeof(Matrix));
+    player->reducedElapsed = -1.0f;
 
     return player;
 }
 
 void R3D_UnloadAnimationPlayer(R3D_AnimationPlayer* player)
 {
-    if (player->texGlobalPose > 0) {
-        glDeleteTextures(1, &player->texGlobalPose);
-    }
+    r3d_skin_free(player->poseOffset, player->skeleton.boneCount);
 
     RL_FREE(player->localPose);
     RL_FREE(player->globalPose);
+    RL_FREE(player->channelMap);
+    RL_FREE(player->rootParentPose);
+    RL_FREE(player->keyCursors);
+    RL_FREE(player->leafBones);
+    RL_FREE(player->reducedPoses);
     RL_FREE(player->states);
 }
 
@@ -156,44 +227,192 @@ void R3D_AdvanceAnimationPlayerTime(R3D_AnimationPlayer* player, float dt)
     }
 }
 
-static void compute_pose(R3D_AnimationPlayer* player, float totalWeight);
+static const Matrix* calculate_pose(R3D_AnimationPlayer* player);
+static const Matrix* update_pose(R3D_AnimationPlayer* player, float dt);
 static void upload_pose(const R3D_AnimationPlayer* player, const Matrix* pose);
+static int update_worker(void* arg);
+
+typedef struct {
+    R3D_AnimationPlayer** players;
+    const Matrix** poses;           //< Pose to upload for each player, NULL if unchanged
+    atomic_int nextPlayer;
+    int count;
+    float dt;
+} update_context_t;
 
 void R3D_CalculateAnimationPlayerPose(R3D_AnimationPlayer* player)
 {
-    const int boneCount = player->skeleton.boneCount;
-    const int animCount = player->animLib.count;
+    upload_pose(player, calculate_pose(player));
+}
 
-    R3D_AnimationState* states = player->states;
+void R3D_UpdateAnimationPlayer(R3D_AnimationPlayer* player, float dt)
+{
+    const Matrix* pose = update_pose(player, dt);
+    if (pose != NULL) {
+        upload_pose(player, pose);
+    }
+    R3D_AdvanceAnimationPlayerTime(player, dt);
+}
+
+void R3D_UpdateAnimationPlayers(R3D_AnimationPlayer** players, int count, float dt)
+{
+    if (players == NULL || count <= 0) return;
+
+    update_context_t ctx = {0};
+    ctx.players = players;
+    ctx.poses = RL_MALLOC(count * sizeof(*ctx.poses));
+    ctx.count = count;
+    ctx.dt = dt;
+    atomic_init(&ctx.nextPlayer, 0);
+
+    /* --- Calculate the poses, the calling thread takes its share --- */
+
+    int numThreads = r3d_cpu_count() - 1;
+    if (numThreads > count / ANIMATION_PLAYERS_PER_THREAD - 1) {
+        numThreads = count / ANIMATION_PLAYERS_PER_THREAD - 1;
+    }
+
+    thrd_t threads[64];
+    if (numThreads > 64) numThreads = 64;
+
+    int launched = 0;
+    for (int i = 0; i < numThreads; i++) {
+        if (thrd_create(&threads[launched], update_worker, &ctx) == thrd_success) {
+            launched++;
+        }
+    }
+
+    update_worker(&ctx);
+
+    for (int i = 0; i < launched; i++) {
+        thrd_join(threads[i], NULL);
+    }
+
+    /* --- Upload the poses from the thread owning the context --- */
+
+    for (int i = 0; i < count; i++) {
+        if (ctx.poses[i] != NULL) {
+            upload_pose(players[i], ctx.poses[i]);
+        }
+    }
+
+    RL_FREE(ctx.poses);
+}
+
+// ----------------------------------------
+// ANIMATION: Baked Animation Functions
+// ----------------------------------------
+
+R3D_BakedAnimationLib R3D_BakeAnimationLib(const R3D_Skeleton* skeleton, const R3D_AnimationLib* animLib, float frameRate, bool loop)
+{
+    R3D_BakedAnimationLib baked = {0};
+    baked.poseOffset = -1;
+
+    if (skeleton == NULL || animLib == NULL || skeleton->boneCount <= 0 || animLib->count <= 0 || frameRate <= 0.0f) {
+        TraceLog(LOG_WARNING, "R3D: Invalid parameters passed to R3D_BakeAnimationLib");
+        return baked;
+    }
+
+    const int boneCount = skeleton->boneCount;
+    const int animCount = animLib->count;
+
+    /* --- Count the frames of each animation --- */
+
+    int* frameCounts = RL_MALLOC(animCount * sizeof(int));
+    int frameTotal = 0;
 
-    float totalWeight = 0.0f;
     for (int iAnim = 0; iAnim < animCount; iAnim++) {
-        totalWeight += states[iAnim].weight;
+        const R3D_Animation* anim = &animLib->animations[iAnim];
+        float duration = (anim->ticksPerSecond > 0.0f) ? anim->duration / anim->ticksPerSecond : 0.0f;
+        frameCounts[iAnim] = (int)ceilf(duration * frameRate);
+        if (frameCounts[iAnim] < 1) frameCounts[iAnim] = 1;
+        frameTotal += frameCounts[iAnim];
     }
 
-    if (totalWeight > 0.0f) {
-        compute_pose(player, totalWeight);
-        upload_pose(player, player->globalPose);
+    /* --- Reserve the animation table and the frames --- */
+
+    int tableMatrices = (ANIMATION_BAKED_TABLE_HEADER + animCount + 3) / 4;
+    int matrixCount = tableMatrices + frameTotal * boneCount;
+
+    int poseOffset = r3d_skin_alloc(matrixCount);
+    if (poseOffset < 0) {
+        TraceLog(LOG_ERROR, "R3D: Failed to reserve %d matrices for the baked animations", matrixCount);
+        RL_FREE(frameCounts);
+        return baked;
     }
-    else {
-        //memcpy(player->localPose, player->skeleton.bindLocal, boneCount * sizeof(Matrix));
-        //memcpy(player->globalPose, player->skeleton.bindPose, boneCount * sizeof(Matrix));
-        upload_pose(player, player->skeleton.bindPose);
+
+    R3D_AnimationPlayer* player = R3D_LoadAnimationPlayer(skeleton, animLib);
+
+    /* --- Write the table, one texel per animation after the header --- */
+
+    Vector4* table = RL_CALLOC(4 * tableMatrices, sizeof(Vector4));
+    table[0].x = (float)boneCount;
+
+    int firstMatrix = tableMatrices;
+    for (int iAnim = 0; iAnim < animCount; iAnim++) {
+        table[ANIMATION_BAKED_TABLE_HEADER + iAnim] = (Vector4) {
+            (float)firstMatrix, (float)frameCounts[iAnim], frameRate, loop ? 1.0f : 0.0f
+        };
+        firstMatrix += frameCounts[iAnim] * boneCount;
+    }
+
+    r3d_skin_write(poseOffset, (const Matrix*)table, tableMatrices);
+    RL_FREE(table);
+
+    /* --- Sample each animation alone --- */
+
+    firstMatrix = poseOffset + tableMatrices;
+    for (int iAnim = 0; iAnim < animCount; iAnim++) {
+        for (int i = 0; i < animCount; i++) {
+            player->states[i] = (R3D_AnimationState) {0};
+        }
+        player->states[iAnim].weight = 1.0f;
+
+        for (int iFrame = 0; iFrame < frameCounts[iAnim]; iFrame++) {
+            player->states[iAnim].currentTime = (float)iFrame / frameRate;
+            r3d_skin_write(firstMatrix, calculate_pose(player), boneCount);
+            firstMatrix += boneCount;
+        }
     }
+
+    R3D_UnloadAnimationPlayer(player);
+    RL_FREE(player);
+    RL_FREE(frameCounts);
+
+    baked.count = animCount;
+    baked.boneCount = boneCount;
+    baked.frameCount = frameTotal;
+    baked.frameRate = frameRate;
+    baked.poseOffset = poseOffset;
+    baked.matrixCount = matrixCount;
+
+    return baked;
 }
 
-void R3D_UpdateAnimationPlayer(R3D_AnimationPlayer* player, float dt)
+void R3D_UnloadBakedAnimationLib(R3D_BakedAnimationLib* baked)
 {
-    R3D_CalculateAnimationPlayerPose(player);
-    R3D_AdvanceAnimationPlayerTime(player, dt);
+    r3d_skin_free(baked->poseOffset, baked->matrixCount);
+
+    *baked = (R3D_BakedAnimationLib) {0};
+    baked->poseOffset = -1;
+}
+
+bool R3D_IsBakedAnimationLibValid(const R3D_BakedAnimationLib* baked)
+{
+    return (baked->poseOffset >= 0 && baked->matrixCount > 0);
 }
 
 // ============================================================================
 // INTERNAL FUNCTIONS
 // ============================================================================
 
+/*
+ * Finds the keys around 'time', starting from the key found by the previous call.
+ * Playback is almost always forward, so the keys are usually found within a few steps,
+ * the cursor is only searched again when the time goes back or jumps ahead.
+ */
 static void find_key_frames(
-    const float* times, uint32_t count, float time,
+    const float* times, uint32_t count, float time, uint32_t* cursor,
     uint32_t* outIdx0, uint32_t* outIdx1, float* outT)
 {
     // No keys
@@ -207,6 +426,7 @@ static void find_key_frames(
     if (count == 1 || time <= times[0]) {
         *outIdx0 = *outIdx1 = 0;
         *outT = 0.0f;
+        *cursor = 0;
         return;
     }
 
@@ -214,19 +434,39 @@ static void find_key_frames(
     if (time >= times[count - 1]) {
         *outIdx0 = *outIdx1 = count - 1;
         *outT = 0.0f;
+        *cursor = count - 2;
         return;
     }
 
-    // Binary search
-    uint32_t left = 0;
-    uint32_t right = count - 1;
+    // Short forward scan from the previous key
+    uint32_t left = (*cursor < count - 1) ? *cursor : count - 2;
+    bool found = false;
+
+    if (times[left] <= time) {
+        for (int i = 0; i < ANIMATION_CURSOR_MAX_SCAN; i++) {
+            if (times[left + 1] > time) {
+                found = true;
+                break;
+            }
+            left++;
+        }
+    }
 
-    while (right - left > 1) {
-        uint32_t mid = (left + right) >> 1;
-        if (times[mid] <= time) left = mid;
-        else right = mid;
+    // Binary search
+    if (!found) {
+        left = 0;
+        uint32_t right = count - 1;
+
+        while (right - left > 1) {
+            uint32_t mid = (left + right) >> 1;
+            if (times[mid] <= time) left = mid;
+            else right = mid;
+        }
     }
 
+    uint32_t right = left + 1;
+
+    *cursor = left;
     *outIdx0 = left;
     *outIdx1 = right;
 
@@ -237,7 +477,27 @@ static void find_key_frames(
     *outT = (dt > 0.0f) ? (time - t0) / dt : 0.0f;
 }
 
-static Transform interpolate_channel(const R3D_AnimationChannel* channel, float time)
+// Quantized keys are unpacked on the fly, only the two keys around the sampled time are read
+static inline Vector3 get_vector3_key(const R3D_AnimationTrack* track, uint32_t index)
+{
+    if (track->quantized) {
+        const r3d_keyframe_vec3_t* keys = (const r3d_keyframe_vec3_t*)track->values;
+        return r3d_keyframe_unpack_vec3(keys[index], track->rangeMin, track->rangeSize);
+    }
+    return ((const Vector3*)track->values)[index];
+}
+
+static inline Quaternion get_quaternion_key(const R3D_AnimationTrack* track, uint32_t index)
+{
+    if (track->quantized) {
+        const r3d_keyframe_quat_t* keys = (const r3d_keyframe_quat_t*)track->values;
+        return r3d_keyframe_unpack_quat(keys[index]);
+    }
+    return ((const Quaternion*)track->values)[index];
+}
+
+// The cursors of the translation, rotation and scale tracks are updated
+static Transform interpolate_channel(const R3D_AnimationChannel* channel, float time, uint32_t cursors[3])
 {
     Transform result = {
         .translation = { 0.0f, 0.0f, 0.0f },
@@ -253,12 +513,14 @@ static Transform interpolate_channel(const R3D_AnimationChannel* channel, float
         find_key_frames(
             channel->translation.times,
             channel->translation.count,
-            time,
+            time, &cursors[0],
             &i0, &i1, &t
         );
 
-        const Vector3* values = (const Vector3*)channel->translation.values;
-        result.translation = Vector3Lerp(values[i0], values[i1], t);
+        result.translation = Vector3Lerp(
+            get_vector3_key(&channel->translation, i0),
+            get_vector3_key(&channel->translation, i1), t
+        );
     }
 
     // Rotation
@@ -269,12 +531,14 @@ static Transform interpolate_channel(const R3D_AnimationChannel* channel, float
         find_key_frames(
             channel->rotation.times,
             channel->rotation.count,
-            time,
+            time, &cursors[1],
             &i0, &i1, &t
         );
 
-        const Quaternion* values = (const Quaternion*)channel->rotation.values;
-        result.rotation = QuaternionSlerp(values[i0], values[i1], t);
+        result.rotation = QuaternionSlerp(
+            get_quaternion_key(&channel->rotation, i0),
+            get_quaternion_key(&channel->rotation, i1), t
+        );
     }
 
     // Scale
@@ -285,32 +549,25 @@ static Transform interpolate_channel(const R3D_AnimationChannel* channel, float
         find_key_frames(
             channel->scale.times,
             channel->scale.count,
-            time,
+            time, &cursors[2],
             &i0, &i1, &t
         );
 
-        const Vector3* values = (const Vector3*)channel->scale.values;
-        result.scale = Vector3Lerp(values[i0], values[i1], t);
+        result.scale = Vector3Lerp(
+            get_vector3_key(&channel->scale, i0),
+            get_vector3_key(&channel->scale, i1), t
+        );
     }
 
     return result;
 }
 
-static const R3D_AnimationChannel* find_channel_for_bone(const R3D_Animation* anim, int iBone)
-{
-    for (int i = 0; i < anim->channelCount; i++) {
-        if (anim->channels[i].boneIndex == iBone) {
-            return &anim->channels[i];
-        }
-    }
-    return NULL;
-}
-
-void compute_pose(R3D_AnimationPlayer* player, float totalWeight)
+static void compute_pose(R3D_AnimationPlayer* player, float totalWeight)
 {
     const int boneCount = player->skeleton.boneCount;
     const int animCount = player->animLib.count;
-    R3D_AnimationState* states = player->states;
+    const R3D_AnimationState* states = player->states;
+    const float invTotalWeight = 1.0f / totalWeight;
 
     for (int iBone = 0; iBone < boneCount; iBone++)
     {
@@ -319,16 +576,17 @@ void compute_pose(R3D_AnimationPlayer* player, float totalWeight)
 
         for (int iAnim = 0; iAnim < animCount; iAnim++)
         {
-            const R3D_Animation* anim = &player->animLib.animations[iAnim];
             const R3D_AnimationState* state = &states[iAnim];
             if (state->weight <= 0.0f) continue;
 
-            const R3D_AnimationChannel* channel = find_channel_for_bone(anim, iBone);
-            if (!channel) continue;
+            int iChannel = player->channelMap[iAnim * boneCount + iBone];
+            if (iChannel < 0 || (player->skipLeafBones && player->leafBones[iBone])) continue;
             isAnimated = true;
 
-            Transform local = interpolate_channel(channel, state->currentTime * anim->ticksPerSecond);
-            float w = state->weight / totalWeight;
+            const R3D_Animation* anim = &player->animLib.animations[iAnim];
+            uint32_t* cursors = &player->keyCursors[3 * (iAnim * boneCount + iBone)];
+            Transform local = interpolate_channel(&anim->channels[iChannel], state->currentTime * anim->ticksPerSecond, cursors);
+            float w = state->weight * invTotalWeight;
 
             blended.translation = Vector3Add(blended.translation, Vector3Scale(local.translation, w));
             blended.rotation = QuaternionAdd(blended.rotation, QuaternionScale(local.rotation, w));
@@ -343,23 +601,106 @@ void compute_pose(R3D_AnimationPlayer* player, float totalWeight)
             player->localPose[iBone] = player->skeleton.bindLocal[iBone];
         }
 
+        // Parents come before their children, their transform is already in scene space
         int parentIdx = player->skeleton.bones[iBone].parent;
-        if (parentIdx >= 0) {
-            player->localPose[iBone] = r3d_matrix_multiply(&player->localPose[iBone], &player->localPose[parentIdx]);
-        }
-        else {
-            Matrix invLocalBind = MatrixInvert(player->skeleton.bindLocal[iBone]);
-            Matrix parentGlobalScene = r3d_matrix_multiply(&invLocalBind, &player->skeleton.bindPose[iBone]);
-            player->localPose[iBone] = r3d_matrix_multiply(&player->localPose[iBone], &parentGlobalScene);
-        }
+        const Matrix* parent = (parentIdx >= 0) ? &player->localPose[parentIdx] : &player->rootParentPose[iBone];
+        player->localPose[iBone] = r3d_matrix_multiply(&player->localPose[iBone], parent);
+    }
+
+    // The offsets do not depend on the hierarchy, they are applied to all the bones at once
+    r3d_matrix_multiply_batch(player->globalPose, player->skeleton.boneOffsets, player->localPose, boneCount);
+}
+
+// Only touches the CPU data of the player, can run on any thread
+const Matrix* calculate_pose(R3D_AnimationPlayer* player)
+{
+    const int animCount = player->animLib.count;
+    const R3D_AnimationState* states = player->states;
+
+    float totalWeight = 0.0f;
+    for (int iAnim = 0; iAnim < animCount; iAnim++) {
+        totalWeight += states[iAnim].weight;
+    }
+
+    if (totalWeight <= 0.0f) {
+        return player->skeleton.bindPose;
+    }
+
+    compute_pose(player, totalWeight);
+
+    return player->globalPose;
+}
+
+/*
+ * Evaluates the pose allowed by the level of detail policy of the player, before its time advances.
+ * Only touches the CPU data of the player, can run on any thread.
+ * Returns NULL if the pose uploaded by the previous update is kept.
+ */
+const Matrix* update_pose(R3D_AnimationPlayer* player, float dt)
+{
+    const R3D_AnimationLod* lod = &player->lod;
+    const int boneCount = player->skeleton.boneCount;
 
-        player->globalPose[iBone] = r3d_matrix_multiply(&player->skeleton.boneOffsets[iBone], &player->localPose[iBone]);
+    // The renderer records the players of a frame before incrementing its index
+    bool drawn = (player->lodFrame + 1 == R3D_MOD_DRAW.frameIndex);
+    if (lod->freezeCulled && !drawn) {
+        return NULL;
     }
+
+    float screenSize = player->lodScreenSize;
+    player->skipLeafBones = (screenSize < lod->leafSize);
+
+    if (screenSize >= lod->reducedSize || lod->reducedRate <= 0.0f) {
+        player->reducedElapsed = -1.0f;
+        return calculate_pose(player);
+    }
+
+    /* --- Reduced rate, interpolates between the two last evaluations --- */
+
+    Matrix* prevPose = &player->reducedPoses[0];
+    Matrix* nextPose = &player->reducedPoses[boneCount];
+    float interval = 1.0f / lod->reducedRate;
+
+    if (player->reducedElapsed < 0.0f) {
+        memcpy(nextPose, calculate_pose(player), boneCount * sizeof(Matrix));
+        memcpy(prevPose, nextPose, boneCount * sizeof(Matrix));
+        player->reducedElapsed = 0.0f;
+    }
+    else if (player->reducedElapsed >= interval) {
+        memcpy(prevPose, nextPose, boneCount * sizeof(Matrix));
+        memcpy(nextPose, calculate_pose(player), boneCount * sizeof(Matrix));
+        player->reducedElapsed = fmodf(player->reducedElapsed, interval);
+    }
+
+    float t = player->reducedElapsed / interval;
+    player->reducedElapsed += dt;
+
+    const float* prev = (const float*)prevPose;
+    const float* next = (const float*)nextPose;
+    float* pose = (float*)player->globalPose;
+
+    for (int i = 0; i < 16 * boneCount; i++) {
+        pose[i] = prev[i] + (next[i] - prev[i]) * t;
+    }
+
+    return player->globalPose;
+}
+
+int update_worker(void* arg)
+{
+    update_context_t* ctx = arg;
+
+    int index;
+    while ((index = atomic_fetch_add(&ctx->nextPlayer, 1)) < ctx->count) {
+        R3D_AnimationPlayer* player = ctx->players[index];
+        ctx->poses[index] = update_pose(player, ctx->dt);
+        R3D_AdvanceAnimationPlayerTime(player, ctx->dt);
+    }
+
+    return 0;
 }
 
 void upload_pose(const R3D_AnimationPlayer* player, const Matrix* pose)
 {
-    glBindTexture(GL_TEXTURE_1D, player->texGlobalPose);
-    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 4 * player->skeleton.boneCount, GL_RGBA, GL_FLOAT, pose);
-    glBindTexture(GL_TEXTURE_1D, 0);
+    r3d_skin_write(player->poseOffset, pose, player->skeleton.boneCount);
 }
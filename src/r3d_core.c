@@ -14,14 +14,25 @@
 
 #include <assimp/cimport.h>
 #include <float.h>
+#include <string.h>
 
 #include "./modules/r3d_primitive.h"
 #include "./modules/r3d_texture.h"
 #include "./modules/r3d_target.h"
 #include "./modules/r3d_shader.h"
 #include "./modules/r3d_light.h"
+#include "./modules/r3d_skin.h"
+#include "./modules/r3d_preskin.h"
 #include "./modules/r3d_cache.h"
+#include "./modules/r3d_arena.h"
+#include "./modules/r3d_occlusion.h"
+#include "./modules/r3d_pick.h"
+#include "./modules/r3d_probe.h"
+#include "./modules/r3d_profile.h"
+#include "./modules/r3d_scene.h"
 #include "./modules/r3d_draw.h"
+#include "./modules/r3d_state.h"
+#include "./modules/r3d_stream.h"
 
 // ========================================
 // PUBLIC API
@@ -29,12 +40,22 @@
 
 void R3D_Init(int resWidth, int resHeight, R3D_Flags flags)
 {
+    r3d_state_init();
     r3d_primitive_init();
     r3d_texture_init();
     r3d_target_init(resWidth, resHeight);
     r3d_shader_init();
     r3d_light_init();
+    r3d_skin_init();
+    r3d_preskin_init();
     r3d_cache_init(flags);
+    r3d_arena_init();
+    r3d_occlusion_init();
+    r3d_pick_init();
+    r3d_probe_init();
+    r3d_profile_init();
+    r3d_scene_init();
+    r3d_stream_init();
     r3d_draw_init();
 
     // Defines suitable clipping plane distances for r3d
@@ -48,8 +69,18 @@ void R3D_Close(void)
     r3d_target_quit();
     r3d_shader_quit();
     r3d_light_quit();
+    r3d_skin_quit();
+    r3d_preskin_quit();
     r3d_cache_quit();
+    r3d_arena_quit();
+    r3d_occlusion_quit();
+    r3d_pick_quit();
+    r3d_probe_quit();
+    r3d_profile_quit();
+    r3d_scene_quit();
     r3d_draw_quit();
+    r3d_stream_quit();
+    r3d_state_quit();
 }
 
 bool R3D_HasState(R3D_Flags flags)
@@ -69,7 +100,8 @@ void R3D_ClearState(R3D_Flags flags)
 
 void R3D_GetResolution(int* width, int* height)
 {
-    r3d_target_get_resolution(width, height, 0);
+    if (width) *width = R3D_TARGET_ALLOC_WIDTH;
+    if (height) *height = R3D_TARGET_ALLOC_HEIGHT;
 }
 
 void R3D_UpdateResolution(int width, int height)
@@ -80,6 +112,37 @@ void R3D_UpdateResolution(int width, int height)
     }
 
     r3d_target_resize(width, height);
+
+    // The history targets are reallocated, their content is lost
+    R3D_CACHE_SET(temporal.ssaoHistory, false);
+    R3D_CACHE_SET(temporal.ssilHistory, false);
+    R3D_CACHE_SET(temporal.taaHistory, false);
+}
+
+void R3D_SetResolutionScale(float scale)
+{
+    r3d_target_set_max_render_scale(scale);
+}
+
+void R3D_EnableDynamicResolution(float targetFrameTime, float minScale)
+{
+    if (targetFrameTime <= 0.0f) {
+        TraceLog(LOG_ERROR, "R3D: Invalid frame time given to 'R3D_EnableDynamicResolution'");
+        return;
+    }
+
+    r3d_target_set_dynamic_resolution(targetFrameTime, minScale);
+}
+
+void R3D_DisableDynamicResolution(void)
+{
+    r3d_target_set_dynamic_resolution(0.0f, 1.0f);
+}
+
+float R3D_GetResolutionScale(void)
+{
+    Vector2 scale = r3d_target_get_uv_scale();
+    return fmaxf(scale.x, scale.y);
 }
 
 void R3D_SetTextureFilter(TextureFilter filter)
@@ -106,3 +169,85 @@ void R3D_DisableLayers(R3D_Layer bitfield)
 {
     R3D_CACHE_FLAGS_CLEAR(layers, bitfield);
 }
+
+void R3D_SetLodBias(float bias)
+{
+    R3D_CACHE_SET(lodBias, bias);
+}
+
+void R3D_SetShadowLodBias(float bias)
+{
+    R3D_CACHE_SET(shadowLodBias, bias);
+}
+
+void R3D_SetModelLodCount(int count)
+{
+    if (count < 0) count = 0;
+    if (count > R3D_MESH_MAX_LODS) count = R3D_MESH_MAX_LODS;
+
+    R3D_CACHE_SET(modelLodCount, count);
+}
+
+void R3D_SetModelCompactVertices(bool enabled)
+{
+    R3D_CACHE_SET(modelCompactVertices, enabled);
+}
+
+void R3D_SetModelTextureCompression(bool enabled)
+{
+    R3D_CACHE_SET(modelCompressTextures, enabled);
+}
+
+void R3D_SetModelTextureStreaming(bool enabled)
+{
+    R3D_CACHE_SET(modelStreamTextures, enabled);
+}
+
+void R3D_SetTextureStreamingBudget(size_t bytes)
+{
+    r3d_texture_stream_set_budget(bytes);
+}
+
+void R3D_SetAnimationCompression(float tolerance)
+{
+    if (tolerance < 0.0f) tolerance = 0.0f;
+
+    R3D_CACHE_SET(animationTolerance, tolerance);
+}
+
+void R3D_SetShaderCacheDirectory(const char* path)
+{
+    char* dir = R3D_MOD_CACHE.programCacheDir;
+    size_t size = sizeof(R3D_MOD_CACHE.programCacheDir);
+
+    if (path == NULL) {
+        dir[0] = '\0';
+        return;
+    }
+
+    if (strlen(path) >= size) {
+        TraceLog(LOG_WARNING, "R3D: Shader cache directory path is too long, the cache is disabled");
+        dir[0] = '\0';
+        return;
+    }
+
+    strncpy(dir, path, size);
+}
+
+void R3D_PrecompileShaders(void)
+{
+    r3d_shader_precompile();
+}
+
+int R3D_PollShaderPrecompilation(void)
+{
+    return r3d_shader_precompile_poll();
+}
+
+R3D_StateStats R3D_GetStateStats(void)
+{
+    return (R3D_StateStats) {
+        .issuedCalls = R3D_MOD_STATE.lastIssuedCalls,
+        .filteredCalls = R3D_MOD_STATE.lastFilteredCalls
+    };
+}
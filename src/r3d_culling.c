@@ -6,6 +6,9 @@
  * For conditions of distribution and use, see accompanying LICENSE file.
  */
 
+#include <r3d/r3d_culling.h>
+
+#include "./modules/r3d_occlusion.h"
 #include "./modules/r3d_cache.h"
 
 // ========================================
@@ -31,3 +34,11 @@ bool R3D_IsOBBInFrustum(BoundingBox aabb, Matrix transform)
 {
 	return r3d_frustum_is_obb_in(&R3D_CACHE_GET(viewState.frustum), &aabb, &transform);
 }
+
+R3D_OcclusionStats R3D_GetOcclusionStats(void)
+{
+	return (R3D_OcclusionStats) {
+		.testedGroups = R3D_MOD_OCCLUSION.testedGroups,
+		.culledGroups = R3D_MOD_OCCLUSION.culledGroups
+	};
+}
@@ -9,6 +9,50 @@
 #include <r3d/r3d_curves.h>
 #include <raymath.h>
 #include <stdlib.h>
+#include <glad.h>
+
+#include "./modules/r3d_state.h"
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static float evaluate_keyframes(const R3D_InterpolationCurve* curve, float time)
+{
+    if (curve->count == 0) return 0.0f;
+    if (time <= curve->keyframes[0].time) return curve->keyframes[0].value;
+    if (time >= curve->keyframes[curve->count - 1].time) return curve->keyframes[curve->count - 1].value;
+
+    // Find the two keyframes surrounding the given time
+    for (int i = 0; i < (int)curve->count - 1; i++) {
+        const R3D_Keyframe* kf1 = &curve->keyframes[i];
+        const R3D_Keyframe* kf2 = &curve->keyframes[i + 1];
+
+        if (time >= kf1->time && time <= kf2->time) {
+            float t = (time - kf1->time) / (kf2->time - kf1->time); // Normalized time between kf1 and kf2
+            return Lerp(kf1->value, kf2->value, t);
+        }
+    }
+
+    return 0.0f; // Fallback (should not be reached)
+}
+
+static void sample_keyframes(R3D_InterpolationCurve* curve)
+{
+    float step = 1.0f / (curve->lutSize - 1);
+    for (unsigned int i = 0; i < curve->lutSize; i++) {
+        curve->lut[i] = evaluate_keyframes(curve, i * step);
+    }
+}
+
+static void upload_lut(const R3D_InterpolationCurve* curve)
+{
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_1D, curve->texture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, curve->lutSize, 0, GL_RED, GL_FLOAT, curve->lut);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+}
 
 // ========================================
 // PUBLIC API
@@ -16,7 +60,7 @@
 
 R3D_InterpolationCurve R3D_LoadInterpolationCurve(int capacity)
 {
-    R3D_InterpolationCurve curve;
+    R3D_InterpolationCurve curve = { 0 };
 
     curve.keyframes = RL_MALLOC(capacity * sizeof(*curve.keyframes));
     curve.capacity = capacity;
@@ -27,7 +71,11 @@ R3D_InterpolationCurve R3D_LoadInterpolationCurve(int capacity)
 
 void R3D_UnloadInterpolationCurve(R3D_InterpolationCurve curve)
 {
+    if (curve.texture != 0) {
+        glDeleteTextures(1, &curve.texture);
+    }
     RL_FREE(curve.keyframes);
+    RL_FREE(curve.lut);
     curve.capacity = 0;
     curve.count = 0;
 }
@@ -46,25 +94,75 @@ bool R3D_AddKeyframe(R3D_InterpolationCurve* curve, float time, float value)
         .time = time, .value = value
     };
 
+    if (curve->lut != NULL) {
+        sample_keyframes(curve);
+        if (curve->texture != 0) {
+            upload_lut(curve);
+        }
+    }
+
     return true;
 }
 
 float R3D_EvaluateCurve(R3D_InterpolationCurve curve, float time)
 {
-    if (curve.count == 0) return 0.0f;
-    if (time <= curve.keyframes[0].time) return curve.keyframes[0].value;
-    if (time >= curve.keyframes[curve.count - 1].time) return curve.keyframes[curve.count - 1].value;
+    if (curve.lut == NULL) {
+        return evaluate_keyframes(&curve, time);
+    }
 
-    // Find the two keyframes surrounding the given time
-    for (int i = 0; i < (int)curve.count - 1; i++) {
-        const R3D_Keyframe* kf1 = &curve.keyframes[i];
-        const R3D_Keyframe* kf2 = &curve.keyframes[i + 1];
+    float x = Clamp(time, 0.0f, 1.0f) * (curve.lutSize - 1);
+    unsigned int i = (unsigned int)x;
+    if (i >= curve.lutSize - 1) i = curve.lutSize - 2;
 
-        if (time >= kf1->time && time <= kf2->time) {
-            float t = (time - kf1->time) / (kf2->time - kf1->time); // Normalized time between kf1 and kf2
-            return Lerp(kf1->value, kf2->value, t);
+    return Lerp(curve.lut[i], curve.lut[i + 1], x - i);
+}
+
+bool R3D_BakeCurve(R3D_InterpolationCurve* curve, int resolution)
+{
+    if (resolution == 0) {
+        if (curve->texture != 0) {
+            glDeleteTextures(1, &curve->texture);
+            curve->texture = 0;
         }
+        RL_FREE(curve->lut);
+        curve->lut = NULL;
+        curve->lutSize = 0;
+        return true;
     }
 
-    return 0.0f; // Fallback (should not be reached)
+    if (resolution < 2) {
+        TraceLog(LOG_WARNING, "R3D: Curve lookup tables need at least 2 samples (got %i)", resolution);
+        return false;
+    }
+
+    if (curve->lut == NULL || curve->lutSize != (unsigned int)resolution) {
+        float* lut = RL_REALLOC(curve->lut, resolution * sizeof(*lut));
+        if (lut == NULL) return false;
+        curve->lut = lut;
+        curve->lutSize = resolution;
+    }
+
+    sample_keyframes(curve);
+
+    if (curve->texture != 0) {
+        upload_lut(curve);
+    }
+
+    return true;
+}
+
+bool R3D_UploadCurve(R3D_InterpolationCurve* curve)
+{
+    if (curve->lut == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Cannot upload a curve that is not baked");
+        return false;
+    }
+
+    if (curve->texture == 0) {
+        glGenTextures(1, &curve->texture);
+    }
+
+    upload_lut(curve);
+
+    return true;
 }
@@ -23,8 +23,17 @@
 #include "./modules/r3d_shader.h"
 #include "./modules/r3d_shader_custom.h"
 #include "./modules/r3d_light.h"
+#include "./modules/r3d_skin.h"
+#include "./modules/r3d_preskin.h"
 #include "./modules/r3d_cache.h"
+#include "./modules/r3d_occlusion.h"
+#include "./modules/r3d_pick.h"
+#include "./modules/r3d_probe.h"
+#include "./modules/r3d_profile.h"
+#include "./modules/r3d_scene.h"
 #include "./modules/r3d_draw.h"
+#include "./modules/r3d_state.h"
+#include "./modules/r3d_stream.h"
 
 // ========================================
 // HELPER MACROS
@@ -40,39 +49,109 @@
 #define R3D_IS_SHADOW_CAST_ONLY(mode) \
     ((R3D_SHADOW_CAST_ONLY_MASK & (1 << (mode))) != 0)
 
+#define R3D_INSTANCING_MODE(group) \
+    ((group)->instanced.particles ? R3D_SHADER_INSTANCING_PARTICLE : \
+     (group)->instanced.sprites ? R3D_SHADER_INSTANCING_SPRITE : R3D_SHADER_INSTANCING_MATRIX)
+
+#define R3D_IS_CALL_WEIGHTED_OIT(call) \
+    ((call)->material->transparencyMode == R3D_TRANSPARENCY_ALPHA && \
+     (call)->material->blendMode == R3D_BLEND_MIX)
+
+#define R3D_IS_CALL_REDUCIBLE(call) \
+    ((call)->material->blendMode == R3D_BLEND_ADDITIVE ? \
+     (call)->material->transparencyMode != R3D_TRANSPARENCY_PREPASS : \
+     ((call)->material->transparencyMode == R3D_TRANSPARENCY_ALPHA && \
+      ((call)->material->blendMode == R3D_BLEND_MIX || \
+       (call)->material->blendMode == R3D_BLEND_PREMULTIPLIED_ALPHA)))
+
+#define R3D_CALL_RESOLUTION(call) \
+    (R3D_IS_CALL_REDUCIBLE(call) ? (call)->material->resolution : R3D_RESOLUTION_FULL)
+
+/*
+ * Targets of the forward draws at reduced resolution, indexed by 'R3D_RenderResolution'.
+ * The factor is the number of full resolution texels per reduced texel, on each axis.
+ */
+static const struct {
+    r3d_target_t color;
+    r3d_target_t depth;
+    int factor;
+} REDUCED_TARGETS[] = {
+    [R3D_RESOLUTION_HALF]    = { R3D_TARGET_REDUCED_HALF,    R3D_TARGET_DEPTH_HALF,    2 },
+    [R3D_RESOLUTION_QUARTER] = { R3D_TARGET_REDUCED_QUARTER, R3D_TARGET_DEPTH_QUARTER, 4 },
+};
+
+/*
+ * Minimum number of lights without shadows for the deferred pass
+ * to shade them all at once from the clusters, instead of one draw per light.
+ */
+#define R3D_DEFERRED_CLUSTER_MIN_LIGHTS 4
+
+/*
+ * Cosine of the widest spot light drawn with a cone volume,
+ * wider spot lights use the sphere volume of their range.
+ */
+#define R3D_DEFERRED_VOLUME_MIN_CONE_COS 0.5f
+
+/*
+ * Weight of the reprojected history in the temporal SSAO,
+ * the occlusion converges over roughly ten frames.
+ */
+#define R3D_SSAO_HISTORY_WEIGHT 0.9f
+
+/*
+ * Bloom levels written by the single dispatch downsampling, one image unit each,
+ * the minimum guaranteed by OpenGL 4.3. See 'MAX_LEVELS' in 'bloom_down.comp'.
+ */
+#define R3D_BLOOM_COMPUTE_LEVELS 8
+
 // ========================================
 // INTERNAL FUNCTIONS
 // ========================================
 
 static void raster_depth(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP);
-static void raster_depth_cube(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP);
+static void raster_depth_queue(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP);
+static void raster_depth_flush(bool shadow, const Matrix* matVP);
+static void raster_depth_cube(const r3d_draw_call_t* call, bool shadow);
 static void raster_geometry(const r3d_draw_call_t* call);
+static void raster_geometry_batch(void);
+static void raster_geometry_bucket(void);
 static void raster_decal(const r3d_draw_call_t* call);
-static void raster_forward(const r3d_draw_call_t* call);
+static void raster_forward(const r3d_draw_call_t* call, bool passBlend);
 
 static void pass_scene_shadow(void);
 static void pass_scene_geometry(void);
 static void pass_scene_decals(void);
+static void pass_scene_decals_clustered(int numBatches);
 
-static r3d_target_t pass_prepare_ssao(void);
-static r3d_target_t pass_prepare_ssil(void);
+static r3d_target_t pass_prepare_ssao(bool temporal);
+static r3d_target_t pass_prepare_ssil(bool temporal);
 static r3d_target_t pass_prepare_ssr(void);
 
 static void pass_deferred_ambient(r3d_target_t ssaoSource, r3d_target_t ssilSource, r3d_target_t ssrSource);
 static void pass_deferred_lights(r3d_target_t ssaoSource);
+static void pass_deferred_lights_clustered(r3d_target_t ssaoSource);
 static void pass_deferred_compose(r3d_target_t sceneTarget);
 
 static void pass_scene_prepass(void);
 static void pass_scene_forward(r3d_target_t sceneTarget);
+static void pass_scene_forward_resolve(r3d_target_t sceneTarget);
+static void pass_scene_forward_reduced(R3D_RenderResolution resolution, const r3d_frustum_t* frustum);
+static void pass_scene_forward_compose(r3d_target_t sceneTarget, R3D_RenderResolution resolution);
 static void pass_scene_background(r3d_target_t sceneTarget);
 
 static r3d_target_t pass_post_setup(r3d_target_t sceneTarget);
 static r3d_target_t pass_post_fog(r3d_target_t sceneTarget);
 static r3d_target_t pass_post_dof(r3d_target_t sceneTarget);
-static r3d_target_t pass_post_bloom(r3d_target_t sceneTarget);
-static r3d_target_t pass_post_output(r3d_target_t sceneTarget);
+static int pass_prepare_bloom(r3d_target_t sceneSource);
+static r3d_target_t pass_post_output(r3d_target_t sceneTarget, bool fog, int bloomLevels);
 static r3d_target_t pass_post_fxaa(r3d_target_t sceneTarget);
+static r3d_target_t pass_post_taa(r3d_target_t sceneSource, Vector2 jitter);
+
+static void select_view(int index);
+static void cull_and_sort_view(const r3d_frustum_t* frustum, Vector3 viewPosition, bool occlusionCulling);
+static void render_view(bool probeCapture, bool temporal, bool occlusionCulling, Vector2 taaJitter, bool* ssaoTemporal, bool* ssilTemporal);
 
+static void merge_draw_buffers(void);
 static void reset_raylib_state(void);
 
 // ========================================
@@ -103,109 +182,268 @@ void R3D_BeginEx(Camera3D camera, const RenderTexture* target)
     );
 
     r3d_draw_clear();
+
+    R3D_MOD_DRAW.views.count = 0;
 }
 
-void R3D_End(void)
+void R3D_BeginMultiView(const Camera3D* cameras, const RenderTexture* targets, int count)
 {
-    /* --- Update and collect all visible lights then render shadow maps --- */
+    if (count < 1 || count > R3D_MAX_VIEWS) {
+        TraceLog(LOG_WARNING, "R3D: Multi-view rendering supports 1 to %i views (got %i)", R3D_MAX_VIEWS, count);
+        count = (count < 1) ? 1 : R3D_MAX_VIEWS;
+    }
 
-    r3d_light_update_and_cull(&R3D_CACHE_GET(viewState.frustum), R3D_CACHE_GET(viewState.viewPosition));
+    R3D_BeginEx(cameras[0], &targets[0]);
 
-    pass_scene_shadow();
+    // The aspect of each view follows the size of its target
+    for (int i = 0; i < count; i++) {
+        r3d_draw_view_t* view = &R3D_MOD_DRAW.views.list[i];
+        r3d_target_set_blit_screen(&targets[i]);
+        r3d_cache_update_view_state(cameras[i], r3d_target_get_render_aspect(), rlGetCullDistanceNear(), rlGetCullDistanceFar());
+        view->view = R3D_CACHE_GET(viewState.view);
+        view->proj = R3D_CACHE_GET(viewState.proj);
+        view->aspect = R3D_CACHE_GET(viewState.aspect);
+        view->near = R3D_CACHE_GET(viewState.near);
+        view->far = R3D_CACHE_GET(viewState.far);
+        view->target = targets[i];
+    }
 
-    /* --- Cull groups and sort all draw calls before rendering --- */
+    R3D_MOD_DRAW.views.count = count;
+    R3D_MOD_DRAW.views.stereo = false;
 
-    if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
-        r3d_draw_compute_visible_groups(&R3D_CACHE_GET(viewState.frustum));
+    // The draws are pushed with the first view, it selects the levels of detail
+    select_view(0);
+}
+
+void R3D_BeginStereo(const Matrix* views, const Matrix* projections, const RenderTexture* targets)
+{
+    rlDrawRenderBatchActive();
+
+    r3d_target_set_blit_mode(
+        R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_ASPECT_KEEP),
+        R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_BLIT_LINEAR)
+    );
+
+    // The planes are recovered from the projections given by the runtime, they ignore the cull distances of rlgl
+    for (int i = 0; i < 2; i++) {
+        r3d_draw_view_t* view = &R3D_MOD_DRAW.views.list[i];
+        Matrix proj = projections[i];
+        view->view = views[i];
+        view->proj = proj;
+        view->aspect = proj.m5 / proj.m0;
+        view->near = proj.m14 / (proj.m10 - 1.0f);
+        view->far = proj.m14 / (proj.m10 + 1.0f);
+        view->target = targets[i];
     }
 
-    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_OPAQUE_SORTING)) {
-        r3d_draw_sort_list(R3D_DRAW_DEFERRED, R3D_CACHE_GET(viewState.viewPosition), R3D_DRAW_SORT_FRONT_TO_BACK);
+    R3D_MOD_DRAW.views.count = 2;
+    R3D_MOD_DRAW.views.stereo = true;
+
+    select_view(0);
+
+    r3d_draw_clear();
+}
+
+void R3D_End(void)
+{
+    /* --- The context was left to raylib since the last frame, nothing is known about it --- */
+
+    r3d_state_begin();
+
+    /* --- Upload the poses calculated since the last frame --- */
+
+    r3d_skin_upload();
+
+    /* --- Merge the draws recorded by other threads before anything is culled --- */
+
+    merge_draw_buffers();
+
+    /* --- Per-instance culling is done on the GPU if requested and supported --- */
+
+    R3D_MOD_DRAW.gpuCulling = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_GPU_INSTANCE_CULLING) && GLAD_GL_VERSION_4_3;
+
+    /* --- Consecutive identical draws are merged into instanced draws if requested --- */
+
+    R3D_MOD_DRAW.autoInstancing = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_AUTO_INSTANCING);
+
+    /* --- Probe captures are rendered from another view, the main view keeps its temporal data --- */
+
+    bool probeCapture = r3d_probe_is_capturing();
+
+    /* --- The views of a multi-view frame share the lights, the shadows and the submitted draws --- */
+
+    bool multiView = (R3D_MOD_DRAW.views.count > 0) && !probeCapture;
+    bool stereo = multiView && R3D_MOD_DRAW.views.stereo;
+    int numViews = multiView ? R3D_MOD_DRAW.views.count : 1;
+
+    // The history of the temporal effects and of the occlusion culling belongs to a single view
+    bool temporal = !probeCapture && !multiView;
+
+    /* --- The rendered area follows the GPU time of the previous frames, probe faces are always complete --- */
+
+    r3d_target_set_render_scale(probeCapture ? 1.0f : r3d_target_update_dynamic_scale());
+    R3D_CACHE_SET(viewState.uvScale, r3d_target_get_uv_scale());
+
+    if (!probeCapture) {
+        r3d_target_begin_timer();
     }
 
-    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_TRANSPARENT_SORTING)) {
-        r3d_draw_sort_list(R3D_DRAW_PREPASS, R3D_CACHE_GET(viewState.viewPosition), R3D_DRAW_SORT_BACK_TO_FRONT);
-        r3d_draw_sort_list(R3D_DRAW_FORWARD, R3D_CACHE_GET(viewState.viewPosition), R3D_DRAW_SORT_BACK_TO_FRONT);
+    /* --- Timestamps of the passes are read back a few frames later, probe captures are not measured --- */
+
+    r3d_profile_begin_frame(R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_GPU_PROFILING) && !probeCapture);
+
+    /* --- The projection is jittered by a sub-pixel amount each frame for the temporal anti-aliasing --- */
+
+    // First eight points of the Halton (2, 3) sequence, centered on the pixel
+    static const Vector2 TAA_JITTER[8] = {
+        { 0.0f,    -0.1667f}, {-0.25f,    0.1667f}, { 0.25f,  -0.3889f}, {-0.375f,  -0.0556f},
+        { 0.125f,   0.2778f}, {-0.125f,  -0.2778f}, { 0.375f,  0.0556f}, {-0.4375f,  0.3889f}
+    };
+
+    bool taaEnabled = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_TAA) && temporal;
+    Vector2 taaJitter = {0};
+
+    if (taaEnabled) {
+        int w = 0, h = 0;
+        r3d_target_get_resolution(&w, &h, 0);
+        taaJitter = TAA_JITTER[R3D_CACHE_GET(temporal.frameIndex) % 8];
+        r3d_cache_jitter_view_state((Vector2) {2.0f * taaJitter.x / w, 2.0f * taaJitter.y / h});
     }
 
-    /* --- Upload and bind uniform buffers --- */
+    /* --- The layout of the light accumulation targets follows the state --- */
 
-    r3d_cache_bind_view_state(R3D_SHADER_UBO_VIEW_SLOT);
+    r3d_target_set_compact(R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_COMPACT_GBUFFER));
 
-    /* --- Opaque and decal rendering with deferred lighting and composition --- */
+    /* --- Occlusion culling relies on the groups found visible by frustum culling --- */
 
-    r3d_target_t sceneTarget = R3D_TARGET_SCENE_0;
+    bool occlusionCulling =
+        R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_OCCLUSION_CULLING) &&
+        !R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING) &&
+        temporal;
 
-    if (r3d_draw_has_deferred()) {
-        R3D_TARGET_CLEAR(R3D_TARGET_ALL_DEFERRED);
+    if (!occlusionCulling && !probeCapture) {
+        r3d_occlusion_reset();
+    }
 
-        pass_scene_geometry();
-        if (r3d_draw_has_decal()) {
-            pass_scene_decals();
-        }
+    /* --- Gather the frustum of each view --- */
 
-        r3d_target_t ssaoSource = R3D_TARGET_INVALID;
-        if (R3D_CACHE_GET(environment.ssao.enabled)) {
-            ssaoSource = pass_prepare_ssao();
-        }
+    r3d_frustum_t viewFrustums[R3D_MAX_VIEWS];
+    Vector3 viewPositions[R3D_MAX_VIEWS];
+    Matrix viewProjs[R3D_MAX_VIEWS];
 
-        if (r3d_light_has_visible()) {
-            pass_deferred_lights(ssaoSource);
-        }
+    for (int i = 0; i < numViews; i++) {
+        if (multiView) select_view(i);
+        viewFrustums[i] = R3D_CACHE_GET(viewState.frustum);
+        viewPositions[i] = R3D_CACHE_GET(viewState.viewPosition);
+        viewProjs[i] = R3D_CACHE_GET(viewState.viewProj);
+    }
 
-        r3d_target_t ssilSource = R3D_TARGET_INVALID;
-        if (R3D_CACHE_GET(environment.ssil.enabled)) {
-            ssilSource = pass_prepare_ssil();
-        }
+    // Both eyes are culled with a single frustum enclosing them, it must outlive the rendering of the views
+    r3d_frustum_t stereoFrustum = {0};
+    if (stereo) {
+        stereoFrustum = r3d_frustum_create_union(viewProjs[0], viewProjs[1]);
+    }
 
-        r3d_target_t ssrSource = R3D_TARGET_INVALID;
-        if (R3D_CACHE_GET(environment.ssr.enabled)) {
-            ssrSource = pass_prepare_ssr();
-        }
+    /* --- Update and collect the lights visible by any view then render shadow maps --- */
 
-        pass_deferred_ambient(ssaoSource, ssilSource, ssrSource);
-        pass_deferred_compose(sceneTarget);
+    double cullStart = GetTime();
+
+    // The pyramid is built from the camera alone, the lights of the other views can't be tested against it
+    r3d_light_update_and_cull(
+        viewFrustums, viewProjs, numViews,
+        R3D_CACHE_GET(viewState.near), R3D_CACHE_GET(viewState.far),
+        occlusionCulling && numViews == 1 && !probeCapture
+    );
+
+    r3d_light_update_shadow_caches(R3D_MOD_SCENE.staticRevision, R3D_MOD_SCENE.numStatic > 0);
+
+    /* --- Submit the retained objects seen by the cameras or by the shadows updated this frame --- */
+
+    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
+        r3d_scene_submit(NULL, numViews);
+    }
+    else if (stereo) {
+        r3d_scene_submit(&stereoFrustum, 1);
     }
     else {
-        R3D_TARGET_CLEAR(R3D_TARGET_DEPTH);
+        r3d_scene_submit(viewFrustums, numViews);
     }
 
-    /* --- Then background and transparent rendering --- */
+    R3D_PROFILE_COUNT(drawGroups, R3D_MOD_DRAW.numGroups);
+    R3D_PROFILE_COUNT(drawCalls, R3D_MOD_DRAW.numCalls);
+    R3D_PROFILE_COUNT(cullingTime, r3d_profile_elapsed_ms(cullStart));
 
-    pass_scene_background(sceneTarget);
+    /* --- Skinned meshes are skinned once here, then drawn as static meshes by every pass --- */
 
-    if (r3d_draw_has_forward() || r3d_draw_has_prepass()) {
-        if (r3d_draw_has_prepass()) pass_scene_prepass();
-        pass_scene_forward(sceneTarget);
+    r3d_preskin_begin();
+
+    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_PRE_SKINNING) && GLAD_GL_VERSION_4_3) {
+        r3d_draw_preskin_calls();
     }
 
-    /* --- Applying effects over the scene and final blit --- */
+    r3d_preskin_end();
 
-    sceneTarget = pass_post_setup(sceneTarget);
+    /* --- The streamed textures refine toward the levels needed by the visible groups --- */
 
-    if (R3D_CACHE_GET(environment.fog.mode) != R3D_FOG_DISABLED) {
-        sceneTarget = pass_post_fog(sceneTarget);
+    if (r3d_texture_has_streamed()) {
+        int w = 0, h = 0;
+        r3d_target_get_resolution(&w, &h, 0);
+        r3d_draw_request_texture_levels((float)h);
+        r3d_texture_stream_update();
     }
 
-    if (R3D_CACHE_GET(environment.dof.mode) != R3D_DOF_DISABLED) {
-        sceneTarget = pass_post_dof(sceneTarget);
+    r3d_profile_begin(R3D_PROFILE_SHADOWS);
+    pass_scene_shadow();
+    r3d_profile_end(R3D_PROFILE_SHADOWS);
+
+    /* --- Render each view from the shared draws and shadows, the eyes also share their draw lists --- */
+
+    if (stereo) {
+        Vector3 center = Vector3Lerp(viewPositions[0], viewPositions[1], 0.5f);
+        cull_and_sort_view(&stereoFrustum, center, occlusionCulling);
     }
 
-    if (R3D_CACHE_GET(environment.bloom.mode) != R3D_BLOOM_DISABLED) {
-        sceneTarget = pass_post_bloom(sceneTarget);
+    bool ssaoTemporal = false;
+    bool ssilTemporal = false;
+
+    for (int i = 0; i < numViews; i++) {
+        if (multiView) select_view(i);
+        if (!stereo) {
+            cull_and_sort_view(&R3D_CACHE_GET(viewState.frustum), R3D_CACHE_GET(viewState.viewPosition), occlusionCulling);
+        }
+        render_view(probeCapture, temporal, occlusionCulling, taaJitter, &ssaoTemporal, &ssilTemporal);
     }
 
-    sceneTarget = pass_post_output(sceneTarget);
+    /* --- The picks read the targets of the main view, a frame of several views leaves them for the next one --- */
 
-    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_FXAA)) {
-        sceneTarget = pass_post_fxaa(sceneTarget);
+    if (!probeCapture && !multiView) {
+        r3d_pick_flush(r3d_draw_has_deferred());
     }
 
-    r3d_target_blit(r3d_target_swap_scene(sceneTarget));
+    r3d_profile_end_frame(!probeCapture);
+    r3d_target_end_timer();
+    r3d_target_release_unused();
 
     /* --- Reset states changed by R3D --- */
 
     reset_raylib_state();
+    r3d_state_end();
+
+    /* --- Keep the main view state for the temporal effects of the next frame --- */
+
+    if (!probeCapture) {
+        R3D_CACHE_SET(temporal.prevViewProj, R3D_CACHE_GET(viewState.viewProjNoJitter));
+        R3D_CACHE_SET(temporal.prevUvScale, R3D_CACHE_GET(viewState.uvScale));
+        R3D_CACHE_SET(temporal.frameIndex, R3D_CACHE_GET(temporal.frameIndex) + 1);
+        R3D_CACHE_SET(temporal.ssaoHistory, ssaoTemporal);
+        R3D_CACHE_SET(temporal.ssilHistory, ssilTemporal);
+        R3D_CACHE_SET(temporal.taaHistory, taaEnabled);
+    }
+
+    /* --- Rotate the ring buffers for the next frame --- */
+
+    r3d_stream_next_frame();
+    R3D_MOD_DRAW.frameIndex++;
 }
 
 void R3D_DrawMesh(const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform)
@@ -220,10 +458,9 @@ void R3D_DrawMesh(const R3D_Mesh* mesh, const R3D_Material* material, Matrix tra
     r3d_draw_group_push(&drawGroup);
 
     r3d_draw_call_t drawCall = {0};
-    drawCall.material = material ? *material : R3D_GetDefaultMaterial();
     drawCall.mesh = *mesh;
 
-    r3d_draw_call_push(&drawCall, false);
+    r3d_draw_call_push(&drawCall, material, false);
 }
 
 void R3D_DrawMeshInstanced(const R3D_Mesh* mesh, const R3D_Material* material, const Matrix* instanceTransforms, int instanceCount)
@@ -264,10 +501,42 @@ void R3D_DrawMeshInstancedPro(const R3D_Mesh* mesh, const R3D_Material* material
 
     r3d_draw_call_t drawCall = {0};
 
-    drawCall.material = material ? *material : R3D_GetDefaultMaterial();
     drawCall.mesh = *mesh;
 
-    r3d_draw_call_push(&drawCall, false);
+    r3d_draw_call_push(&drawCall, material, false);
+}
+
+void R3D_DrawMeshInstanceBuffer(const R3D_Mesh* mesh, const R3D_Material* material, const R3D_InstanceBuffer* instances)
+{
+    R3D_DrawMeshInstanceBufferPro(mesh, material, NULL, MatrixIdentity(), instances);
+}
+
+void R3D_DrawMeshInstanceBufferPro(const R3D_Mesh* mesh, const R3D_Material* material,
+                                   const BoundingBox* globalAabb, Matrix globalTransform,
+                                   const R3D_InstanceBuffer* instances)
+{
+    if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+        return;
+    }
+
+    if (instances == NULL || instances->count <= 0 || !R3D_IsInstanceBufferValid(instances)) {
+        return;
+    }
+
+    r3d_draw_group_t drawGroup = {0};
+
+    drawGroup.transform = globalTransform;
+    drawGroup.instanced.allAabb = globalAabb ? *globalAabb : (BoundingBox) {0};
+    drawGroup.instanced.buffer = instances;
+    drawGroup.instanced.count = instances->count;
+
+    r3d_draw_group_push(&drawGroup);
+
+    r3d_draw_call_t drawCall = {0};
+
+    drawCall.mesh = *mesh;
+
+    r3d_draw_call_push(&drawCall, material, false);
 }
 
 void R3D_DrawModel(const R3D_Model* model, Vector3 position, float scale)
@@ -314,10 +583,9 @@ void R3D_DrawModelPro(const R3D_Model* model, Matrix transform)
 
         r3d_draw_call_t drawCall = {0};
 
-        drawCall.material = model->materials[model->meshMaterials[i]];
         drawCall.mesh = *mesh;
 
-        r3d_draw_call_push(&drawCall, false);
+        r3d_draw_call_push(&drawCall, &model->materials[model->meshMaterials[i]], false);
     }
 }
 
@@ -367,10 +635,56 @@ void R3D_DrawModelInstancedPro(const R3D_Model* model,
 
         r3d_draw_call_t drawCall = {0};
 
-        drawCall.material = model->materials[model->meshMaterials[i]];
         drawCall.mesh = *mesh;
 
-        r3d_draw_call_push(&drawCall, false);
+        r3d_draw_call_push(&drawCall, &model->materials[model->meshMaterials[i]], false);
+    }
+}
+
+void R3D_DrawModelInstanceBuffer(const R3D_Model* model, const R3D_InstanceBuffer* instances)
+{
+    R3D_DrawModelInstanceBufferPro(model, NULL, MatrixIdentity(), instances);
+}
+
+void R3D_DrawModelInstanceBufferPro(const R3D_Model* model,
+                                    const BoundingBox* globalAabb, Matrix globalTransform,
+                                    const R3D_InstanceBuffer* instances)
+{
+    if (model == NULL || instances == NULL || instances->count <= 0 || model->meshCount == 0) {
+        return;
+    }
+
+    if (!R3D_IsInstanceBufferValid(instances)) {
+        return;
+    }
+
+    r3d_draw_group_t drawGroup = {0};
+
+    drawGroup.aabb = model->aabb;
+    drawGroup.transform = globalTransform;
+    drawGroup.skeleton = model->skeleton;
+    drawGroup.player = model->player;
+    drawGroup.baked = model->bakedAnimations;
+
+    drawGroup.instanced.allAabb = globalAabb ? *globalAabb : (BoundingBox) {0};
+    drawGroup.instanced.buffer = instances;
+    drawGroup.instanced.count = instances->count;
+
+    r3d_draw_group_push(&drawGroup);
+
+    for (int i = 0; i < model->meshCount; i++)
+    {
+        const R3D_Mesh* mesh = &model->meshes[i];
+
+        if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+            continue;
+        }
+
+        r3d_draw_call_t drawCall = {0};
+
+        drawCall.mesh = *mesh;
+
+        r3d_draw_call_push(&drawCall, &model->materials[model->meshMaterials[i]], false);
     }
 }
 
@@ -382,12 +696,11 @@ void R3D_DrawDecal(const R3D_Decal* decal, Matrix transform)
     r3d_draw_group_push(&drawGroup);
 
     r3d_draw_call_t drawCall = {0};
-    drawCall.material = decal->material;
     drawCall.mesh.shadowCastMode = R3D_SHADOW_CAST_DISABLED;
     drawCall.mesh.aabb.min = (Vector3) {-0.5f, -0.5f, -0.5f};
     drawCall.mesh.aabb.max = (Vector3) {+0.5f, +0.5f, +0.5f};
 
-    r3d_draw_call_push(&drawCall, true);
+    r3d_draw_call_push(&drawCall, &decal->material, true);
 }
 
 void R3D_DrawDecalInstanced(const R3D_Decal* decal, const Matrix* instanceTransforms, int instanceCount)
@@ -407,12 +720,11 @@ void R3D_DrawDecalInstanced(const R3D_Decal* decal, const Matrix* instanceTransf
 
     r3d_draw_call_t drawCall = {0};
 
-    drawCall.material = decal->material;
     drawCall.mesh.shadowCastMode = R3D_SHADOW_CAST_DISABLED;
     drawCall.mesh.aabb.min = (Vector3) {-0.5f, -0.5f, -0.5f};
     drawCall.mesh.aabb.max = (Vector3) {+0.5f, +0.5f, +0.5f};
 
-    r3d_draw_call_push(&drawCall, true);
+    r3d_draw_call_push(&drawCall, &decal->material, true);
 }
 
 void R3D_DrawParticleSystem(const R3D_ParticleSystem* system, const R3D_Mesh* mesh, const R3D_Material* material)
@@ -426,154 +738,357 @@ void R3D_DrawParticleSystemEx(const R3D_ParticleSystem* system, const R3D_Mesh*
         return;
     }
 
-    R3D_DrawMeshInstancedPro(
-        mesh, material, &system->aabb, transform,
-        &system->particles->transform, sizeof(R3D_Particle),
-        &system->particles->color, sizeof(R3D_Particle),
-        system->count
-    );
-}
-
-// ========================================
-// INTERNAL FUNCTIONS
-// ========================================
-
-void raster_depth(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP)
-{
-    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
-
-    /* --- Send matrices --- */
-
-    R3D_SHADER_SET_MAT4(scene.depth, uMatModel, group->transform);
-    R3D_SHADER_SET_MAT4(scene.depth, uMatVP, *matVP);
-
-    /* --- Send skinning related data --- */
+    if (system->mode == R3D_PARTICLE_MODE_GPU) {
+        R3D_DrawMeshInstanceBufferPro(mesh, material, &system->aabb, transform, &system->instanceBuffer);
+        return;
+    }
 
-    if (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
-        R3D_SHADER_BIND_SAMPLER_1D(scene.depth, uTexBoneMatrices, group->player ? group->player->texGlobalPose : group->skeleton.texBindPose);
-        R3D_SHADER_SET_INT(scene.depth, uSkinning, true);
+    if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+        return;
     }
-    else {
-        R3D_SHADER_SET_INT(scene.depth, uSkinning, false);
+
+    if (system->count == 0) {
+        return;
     }
 
-    /* --- Send billboard related data --- */
+    BoundingBox aabb = system->aabb;
 
-    R3D_SHADER_SET_INT(scene.depth, uBillboard, call->material.billboardMode);
-    if (call->material.billboardMode != R3D_BILLBOARD_DISABLED) {
-        R3D_SHADER_SET_MAT4(scene.depth, uMatInvView, R3D_CACHE_GET(viewState.invView));
+    // The refitted bounds only enclose the positions, the particles rotate freely
+    // so they are padded by the sphere enclosing the mesh at the largest scale
+    if (system->autoBounds) {
+        Vector3 farthest = Vector3Max(Vector3Negate(mesh->aabb.min), mesh->aabb.max);
+        float radius = Vector3Length(farthest) * system->boundsScale;
+        aabb.min = Vector3SubtractValue(aabb.min, radius);
+        aabb.max = Vector3AddValue(aabb.max, radius);
     }
 
-    /* --- Set texcoord offset/scale --- */
+    r3d_draw_group_t drawGroup = {0};
 
-    R3D_SHADER_SET_VEC2(scene.depth, uTexCoordOffset, call->material.uvOffset);
-    R3D_SHADER_SET_VEC2(scene.depth, uTexCoordScale, call->material.uvScale);
+    drawGroup.transform = transform;
+    drawGroup.instanced.allAabb = aabb;
+    drawGroup.instanced.particles = system->instances;
+    drawGroup.instanced.count = system->count;
 
-    /* --- Set transparency material data --- */
+    r3d_draw_group_push(&drawGroup);
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.depth, uTexAlbedo, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    R3D_SHADER_SET_FLOAT(scene.depth, uAlpha, ((float)call->material.albedo.color.a / 255));
+    r3d_draw_call_t drawCall = {0};
 
-    if (call->material.transparencyMode == R3D_TRANSPARENCY_PREPASS) {
-        R3D_SHADER_SET_FLOAT(scene.depth, uAlphaCutoff, shadow ? 0.1f : 0.99f);
-    }
-    else {
-        R3D_SHADER_SET_FLOAT(scene.depth, uAlphaCutoff, call->material.alphaCutoff);
-    }
+    drawCall.mesh = *mesh;
 
-    /* --- Applying material parameters that are independent of shaders --- */
+    r3d_draw_call_push(&drawCall, material, false);
+}
 
-    if (shadow) {
-        r3d_draw_apply_shadow_cast_mode(call->mesh.shadowCastMode, call->material.cullMode);
+void R3D_DrawSprites(const R3D_Mesh* mesh, const R3D_Material* material, const R3D_Sprite* sprites, int count)
+{
+    if (mesh == NULL || sprites == NULL || count <= 0) {
+        return;
     }
-    else {
-        r3d_draw_apply_cull_mode(call->material.cullMode);
+
+    if (!R3D_CACHE_FLAGS_HAS(layers, mesh->layerMask)) {
+        return;
     }
 
-    /* --- Rendering the object corresponding to the draw call --- */
+    // The sprites roll and may face the camera, so their bounds
+    // are padded by the sphere enclosing the quad at their largest size
+    Vector3 farthest = Vector3Max(Vector3Negate(mesh->aabb.min), mesh->aabb.max);
+    float meshRadius = Vector3Length(farthest);
 
-    if (r3d_draw_has_instances(group)) {
-        R3D_SHADER_SET_INT(scene.depth, uInstancing, true);
-        r3d_draw_instanced(call, 10, -1);
-    }
-    else {
-        R3D_SHADER_SET_INT(scene.depth, uInstancing, false);
-        r3d_draw(call);
+    BoundingBox aabb = {
+        .min = { +FLT_MAX, +FLT_MAX, +FLT_MAX },
+        .max = { -FLT_MAX, -FLT_MAX, -FLT_MAX }
+    };
+
+    for (int i = 0; i < count; i++) {
+        const R3D_Sprite* sprite = &sprites[i];
+        float radius = meshRadius * fmaxf(fabsf(sprite->size.x), fabsf(sprite->size.y));
+        aabb.min = Vector3Min(aabb.min, Vector3SubtractValue(sprite->position, radius));
+        aabb.max = Vector3Max(aabb.max, Vector3AddValue(sprite->position, radius));
     }
 
-    /* --- Unbind samplers --- */
+    r3d_draw_group_t drawGroup = {0};
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(scene.depth, uTexAlbedo);
-}
+    drawGroup.transform = MatrixIdentity();
+    drawGroup.instanced.allAabb = aabb;
+    drawGroup.instanced.sprites = sprites;
+    drawGroup.instanced.count = count;
 
-void raster_depth_cube(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP)
-{
-    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+    r3d_draw_group_push(&drawGroup);
 
-    /* --- Send matrices --- */
+    r3d_draw_call_t drawCall = {0};
 
-    R3D_SHADER_SET_MAT4(scene.depthCube, uMatModel, group->transform);
-    R3D_SHADER_SET_MAT4(scene.depthCube, uMatVP, *matVP);
+    drawCall.mesh = *mesh;
 
-    /* --- Send skinning related data --- */
+    r3d_draw_call_push(&drawCall, material, false);
+}
 
-    if (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
-        R3D_SHADER_BIND_SAMPLER_1D(scene.depthCube, uTexBoneMatrices, group->player ? group->player->texGlobalPose : group->skeleton.texBindPose);
-        R3D_SHADER_SET_INT(scene.depthCube, uSkinning, true);
+R3D_DrawBuffer* R3D_CreateDrawBuffer(void)
+{
+    R3D_DrawBuffer* buffer = r3d_draw_buffer_create();
+    if (buffer == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on draw buffer creation");
     }
-    else {
-        R3D_SHADER_SET_INT(scene.depthCube, uSkinning, false);
+    return buffer;
+}
+
+void R3D_DestroyDrawBuffer(R3D_DrawBuffer* buffer)
+{
+    if (buffer == NULL) {
+        return;
     }
 
-    /* --- Send billboard related data --- */
+    r3d_draw_buffer_destroy(buffer);
+}
 
-    R3D_SHADER_SET_INT(scene.depthCube, uBillboard, call->material.billboardMode);
-    if (call->material.billboardMode != R3D_BILLBOARD_DISABLED) {
-        R3D_SHADER_SET_MAT4(scene.depthCube, uMatInvView, R3D_CACHE_GET(viewState.invView));
+void R3D_DrawBufferMesh(R3D_DrawBuffer* buffer, const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform)
+{
+    if (buffer == NULL || mesh == NULL) {
+        return;
     }
 
-    /* --- Set texcoord offset/scale --- */
+    r3d_draw_group_t drawGroup = {0};
+    drawGroup.aabb = mesh->aabb;
+    drawGroup.transform = transform;
 
-    R3D_SHADER_SET_VEC2(scene.depthCube, uTexCoordOffset, call->material.uvOffset);
-    R3D_SHADER_SET_VEC2(scene.depthCube, uTexCoordScale, call->material.uvScale);
+    if (!r3d_draw_buffer_push_group(buffer, &drawGroup) ||
+        !r3d_draw_buffer_push_call(buffer, mesh, material)) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on draw buffer recording");
+    }
+}
 
-    /* --- Set transparency material data --- */
+void R3D_DrawBufferModel(R3D_DrawBuffer* buffer, const R3D_Model* model, Matrix transform)
+{
+    if (buffer == NULL || model == NULL) {
+        return;
+    }
+
+    r3d_draw_group_t drawGroup = {0};
+
+    drawGroup.aabb = model->aabb;
+    drawGroup.transform = transform;
+    drawGroup.skeleton = model->skeleton;
+    drawGroup.player = model->player;
+
+    if (!r3d_draw_buffer_push_group(buffer, &drawGroup)) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on draw buffer recording");
+        return;
+    }
+
+    for (int i = 0; i < model->meshCount; i++) {
+        if (!r3d_draw_buffer_push_call(buffer, &model->meshes[i], &model->materials[model->meshMaterials[i]])) {
+            TraceLog(LOG_ERROR, "R3D: Bad alloc on draw buffer recording");
+            return;
+        }
+    }
+}
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+void raster_depth(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP)
+{
+    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+    bool bucketed = r3d_draw_call_is_bucketed(call);
+
+    /* --- Send matrices --- */
+
+    // The transforms of a bucket are read from the instance attributes
+    R3D_SHADER_SET_MAT4(scene.depth, uMatModel, bucketed ? MatrixIdentity() : group->transform);
+    R3D_SHADER_SET_MAT4(scene.depth, uMatVP, *matVP);
+
+    /* --- Send vertex format related data --- */
+
+    if (call->mesh.vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        const BoundingBox* bounds = &call->mesh.quantizationBounds;
+        R3D_SHADER_SET_INT(scene.depth, uCompactVertex, true);
+        R3D_SHADER_SET_VEC3(scene.depth, uPositionMin, bounds->min);
+        R3D_SHADER_SET_VEC3(scene.depth, uPositionSize, Vector3Subtract(bounds->max, bounds->min));
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.depth, uCompactVertex, false);
+    }
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.depthCube, uTexAlbedo, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    R3D_SHADER_SET_FLOAT(scene.depthCube, uAlpha, ((float)call->material.albedo.color.a / 255));
+    /* --- Send skinning related data --- */
 
-    if (call->material.transparencyMode == R3D_TRANSPARENCY_PREPASS) {
-        R3D_SHADER_SET_FLOAT(scene.depthCube, uAlphaCutoff, shadow ? 0.1f : 0.99f);
+    if (r3d_draw_has_baked_animation(group)) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.depth, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.depth, uBoneOffset, group->baked->poseOffset);
+        R3D_SHADER_SET_INT(scene.depth, uBakedAnimation, true);
+        R3D_SHADER_SET_INT(scene.depth, uSkinning, true);
+    }
+    else if (!call->preSkinned && (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton))) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.depth, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.depth, uBoneOffset, group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset);
+        R3D_SHADER_SET_INT(scene.depth, uBakedAnimation, false);
+        R3D_SHADER_SET_INT(scene.depth, uSkinning, true);
     }
     else {
-        R3D_SHADER_SET_FLOAT(scene.depthCube, uAlphaCutoff, call->material.alphaCutoff);
+        R3D_SHADER_SET_INT(scene.depth, uSkinning, false);
+    }
+
+    /* --- Send billboard related data --- */
+
+    R3D_SHADER_SET_INT(scene.depth, uBillboard, call->material->billboardMode);
+    if (call->material->billboardMode != R3D_BILLBOARD_DISABLED) {
+        R3D_SHADER_SET_MAT4(scene.depth, uMatInvView, R3D_CACHE_GET(viewState.invView));
     }
 
+    /* --- Set texcoord offset/scale --- */
+
+    R3D_SHADER_SET_VEC2(scene.depth, uTexCoordOffset, call->material->uvOffset);
+    R3D_SHADER_SET_VEC2(scene.depth, uTexCoordScale, call->material->uvScale);
+
+    /* --- Set transparency material data --- */
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.depth, uTexAlbedo, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    R3D_SHADER_SET_FLOAT(scene.depth, uAlpha, ((float)call->material->albedo.color.a / 255));
+
+    float alphaCutoff = (call->material->transparencyMode == R3D_TRANSPARENCY_PREPASS)
+        ? (shadow ? 0.1f : 0.99f) : call->material->alphaCutoff;
+
+    R3D_SHADER_SET_FLOAT(scene.depth, uAlphaCutoff, alphaCutoff);
+
     /* --- Applying material parameters that are independent of shaders --- */
 
     if (shadow) {
-        r3d_draw_apply_shadow_cast_mode(call->mesh.shadowCastMode, call->material.cullMode);
+        r3d_draw_apply_shadow_cast_mode(call->mesh.shadowCastMode, call->material->cullMode);
     }
     else {
-        r3d_draw_apply_cull_mode(call->material.cullMode);
+        r3d_draw_apply_cull_mode(call->material->cullMode);
     }
 
     /* --- Rendering the object corresponding to the draw call --- */
 
+    // Opaque enough calls only fetch the positions, and the skinning
+    bool depthOnly = r3d_draw_call_is_depth_only(call, alphaCutoff);
+
     if (r3d_draw_has_instances(group)) {
-        R3D_SHADER_SET_INT(scene.depthCube, uInstancing, true);
-        r3d_draw_instanced(call, 10, -1);
+        R3D_SHADER_SET_INT(scene.depth, uInstancing, R3D_INSTANCING_MODE(group));
+        if (depthOnly) r3d_draw_depth_instanced(call, 10);
+        else r3d_draw_instanced(call, 10, -1);
+    }
+    else if (bucketed) {
+        R3D_SHADER_SET_INT(scene.depth, uInstancing, R3D_SHADER_INSTANCING_MATRIX);
+        r3d_draw_bucket_instanced(10, depthOnly);
     }
     else {
-        R3D_SHADER_SET_INT(scene.depthCube, uInstancing, false);
-        r3d_draw(call);
+        R3D_SHADER_SET_INT(scene.depth, uInstancing, R3D_SHADER_INSTANCING_NONE);
+        if (depthOnly) r3d_draw_depth(call);
+        else r3d_draw(call);
+    }
+
+    /* --- Unbind samplers --- */
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.depth, uTexAlbedo);
+}
+
+// Merges the call into the pending bucket if identical, the bucket is drawn otherwise
+void raster_depth_queue(const r3d_draw_call_t* call, bool shadow, const Matrix* matVP)
+{
+    if (!r3d_draw_bucket_accepts(call)) {
+        raster_depth_flush(shadow, matVP);
+    }
+
+    if (r3d_draw_bucket_accepts(call)) {
+        r3d_draw_bucket_push(call);
+    }
+    else {
+        raster_depth(call, shadow, matVP);
+    }
+}
+
+void raster_depth_flush(bool shadow, const Matrix* matVP)
+{
+    if (R3D_MOD_DRAW.bucket.numCalls > 0) {
+        raster_depth(R3D_MOD_DRAW.bucket.calls[0], shadow, matVP);
+        r3d_draw_bucket_clear();
+    }
+}
+
+void raster_depth_cube(const r3d_draw_call_t* call, bool shadow)
+{
+    const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+
+    /* --- Send matrices --- */
+
+    R3D_SHADER_SET_MAT4(scene.depthCube, uMatModel, group->transform);
+
+    /* --- Send vertex format related data --- */
+
+    if (call->mesh.vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        const BoundingBox* bounds = &call->mesh.quantizationBounds;
+        R3D_SHADER_SET_INT(scene.depthCube, uCompactVertex, true);
+        R3D_SHADER_SET_VEC3(scene.depthCube, uPositionMin, bounds->min);
+        R3D_SHADER_SET_VEC3(scene.depthCube, uPositionSize, Vector3Subtract(bounds->max, bounds->min));
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.depthCube, uCompactVertex, false);
+    }
+
+    /* --- Send skinning related data --- */
+
+    if (r3d_draw_has_baked_animation(group)) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.depthCube, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.depthCube, uBoneOffset, group->baked->poseOffset);
+        R3D_SHADER_SET_INT(scene.depthCube, uBakedAnimation, true);
+        R3D_SHADER_SET_INT(scene.depthCube, uSkinning, true);
+    }
+    else if (!call->preSkinned && (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton))) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.depthCube, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.depthCube, uBoneOffset, group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset);
+        R3D_SHADER_SET_INT(scene.depthCube, uBakedAnimation, false);
+        R3D_SHADER_SET_INT(scene.depthCube, uSkinning, true);
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.depthCube, uSkinning, false);
+    }
+
+    /* --- Send billboard related data --- */
+
+    R3D_SHADER_SET_INT(scene.depthCube, uBillboard, call->material->billboardMode);
+    if (call->material->billboardMode != R3D_BILLBOARD_DISABLED) {
+        R3D_SHADER_SET_MAT4(scene.depthCube, uMatInvView, R3D_CACHE_GET(viewState.invView));
+    }
+
+    /* --- Set texcoord offset/scale --- */
+
+    R3D_SHADER_SET_VEC2(scene.depthCube, uTexCoordOffset, call->material->uvOffset);
+    R3D_SHADER_SET_VEC2(scene.depthCube, uTexCoordScale, call->material->uvScale);
+
+    /* --- Set transparency material data --- */
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.depthCube, uTexAlbedo, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    R3D_SHADER_SET_FLOAT(scene.depthCube, uAlpha, ((float)call->material->albedo.color.a / 255));
+
+    float alphaCutoff = (call->material->transparencyMode == R3D_TRANSPARENCY_PREPASS)
+        ? (shadow ? 0.1f : 0.99f) : call->material->alphaCutoff;
+
+    R3D_SHADER_SET_FLOAT(scene.depthCube, uAlphaCutoff, alphaCutoff);
+
+    /* --- Applying material parameters that are independent of shaders --- */
+
+    if (shadow) {
+        r3d_draw_apply_shadow_cast_mode(call->mesh.shadowCastMode, call->material->cullMode);
     }
+    else {
+        r3d_draw_apply_cull_mode(call->material->cullMode);
+    }
+
+    /* --- Rendering the object corresponding to the draw call --- */
 
-    /* --- Unbind vertex buffers --- */
+    // Opaque enough calls only fetch the positions, and the skinning
+    bool depthOnly = r3d_draw_call_is_depth_only(call, alphaCutoff);
 
-    rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
+    if (r3d_draw_has_instances(group)) {
+        R3D_SHADER_SET_INT(scene.depthCube, uInstancing, R3D_INSTANCING_MODE(group));
+        if (depthOnly) r3d_draw_depth_instanced(call, 10);
+        else r3d_draw_instanced(call, 10, -1);
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.depthCube, uInstancing, R3D_SHADER_INSTANCING_NONE);
+        if (depthOnly) r3d_draw_depth(call);
+        else r3d_draw(call);
+    }
 
     /* --- Unbind samplers --- */
 
@@ -584,20 +1099,41 @@ void raster_depth_cube(const r3d_draw_call_t* call, bool shadow, const Matrix* m
 static void raster_geometry_custom(const r3d_draw_call_t* call)
 {
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
-    const R3D_Shader* shader = call->material.shader;
+    const R3D_Shader* shader = call->material->shader;
 
     /* --- Switch to custom shader --- */
-    glUseProgram(R3D_GetCustomShaderProgram(shader));
+    r3d_state_use_program(R3D_GetCustomShaderProgram(shader));
 
     /* --- Send matrices --- */
     Matrix matNormal = r3d_matrix_normal(&group->transform);
     R3D_CustomShaderSetMatModel(shader, (float*)&group->transform);
     R3D_CustomShaderSetMatNormal(shader, (float*)&matNormal);
 
+    /* --- Send vertex format related data --- */
+    if (call->mesh.vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        const BoundingBox* bounds = &call->mesh.quantizationBounds;
+        R3D_CustomShaderSetCompactVertex(shader, true);
+        R3D_CustomShaderSetPositionMin(shader, bounds->min.x, bounds->min.y, bounds->min.z);
+        R3D_CustomShaderSetPositionSize(shader,
+            bounds->max.x - bounds->min.x,
+            bounds->max.y - bounds->min.y,
+            bounds->max.z - bounds->min.z);
+    }
+    else {
+        R3D_CustomShaderSetCompactVertex(shader, false);
+    }
+
     /* --- Send skinning related data --- */
-    if (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
-        glActiveTexture(GL_TEXTURE0 + 0); // Bone matrices slot
-        glBindTexture(GL_TEXTURE_1D, group->player ? group->player->texGlobalPose : group->skeleton.texBindPose);
+    if (r3d_draw_has_baked_animation(group)) {
+        r3d_state_bind_texture(0, GL_TEXTURE_BUFFER, R3D_MOD_SKIN.texture);
+        R3D_CustomShaderSetBoneOffset(shader, group->baked->poseOffset);
+        R3D_CustomShaderSetBakedAnimation(shader, true);
+        R3D_CustomShaderSetSkinning(shader, true);
+    }
+    else if (!call->preSkinned && (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton))) {
+        r3d_state_bind_texture(0, GL_TEXTURE_BUFFER, R3D_MOD_SKIN.texture);
+        R3D_CustomShaderSetBoneOffset(shader, group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset);
+        R3D_CustomShaderSetBakedAnimation(shader, false);
         R3D_CustomShaderSetSkinning(shader, true);
     }
     else {
@@ -605,94 +1141,109 @@ static void raster_geometry_custom(const r3d_draw_call_t* call)
     }
 
     /* --- Send billboard related data --- */
-    R3D_CustomShaderSetBillboard(shader, call->material.billboardMode);
+    R3D_CustomShaderSetBillboard(shader, call->material->billboardMode);
 
     /* --- Set factor material maps --- */
-    R3D_CustomShaderSetEmissionEnergy(shader, call->material.emission.energy);
-    R3D_CustomShaderSetNormalScale(shader, call->material.normal.scale);
-    R3D_CustomShaderSetOcclusion(shader, call->material.orm.occlusion);
-    R3D_CustomShaderSetRoughness(shader, call->material.orm.roughness);
-    R3D_CustomShaderSetMetalness(shader, call->material.orm.metalness);
+    R3D_CustomShaderSetEmissionEnergy(shader, call->material->emission.energy);
+    R3D_CustomShaderSetNormalScale(shader, call->material->normal.scale);
+    R3D_CustomShaderSetOcclusion(shader, call->material->orm.occlusion);
+    R3D_CustomShaderSetRoughness(shader, call->material->orm.roughness);
+    R3D_CustomShaderSetMetalness(shader, call->material->orm.metalness);
 
     /* --- Set misc material values --- */
-    R3D_CustomShaderSetAlphaCutoff(shader, call->material.alphaCutoff);
+    R3D_CustomShaderSetAlphaCutoff(shader, call->material->alphaCutoff);
 
     /* --- Set texcoord offset/scale --- */
-    R3D_CustomShaderSetTexCoordOffset(shader, call->material.uvOffset.x, call->material.uvOffset.y);
-    R3D_CustomShaderSetTexCoordScale(shader, call->material.uvScale.x, call->material.uvScale.y);
+    R3D_CustomShaderSetTexCoordOffset(shader, call->material->uvOffset.x, call->material->uvOffset.y);
+    R3D_CustomShaderSetTexCoordScale(shader, call->material->uvScale.x, call->material->uvScale.y);
 
     /* --- Set color material maps --- */
     R3D_CustomShaderSetAlbedoColor(shader,
-        call->material.albedo.color.r / 255.0f,
-        call->material.albedo.color.g / 255.0f,
-        call->material.albedo.color.b / 255.0f,
-        call->material.albedo.color.a / 255.0f);
+        call->material->albedo.color.r / 255.0f,
+        call->material->albedo.color.g / 255.0f,
+        call->material->albedo.color.b / 255.0f,
+        call->material->albedo.color.a / 255.0f);
     R3D_CustomShaderSetEmissionColor(shader,
-        call->material.emission.color.r / 255.0f,
-        call->material.emission.color.g / 255.0f,
-        call->material.emission.color.b / 255.0f);
+        call->material->emission.color.r / 255.0f,
+        call->material->emission.color.g / 255.0f,
+        call->material->emission.color.b / 255.0f);
 
     /* --- Bind active texture maps (same slots as default shader) --- */
-    glActiveTexture(GL_TEXTURE0 + 1);
-    glBindTexture(GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    glActiveTexture(GL_TEXTURE0 + 2);
-    glBindTexture(GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material.normal.texture.id, NORMAL));
-    glActiveTexture(GL_TEXTURE0 + 3);
-    glBindTexture(GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material.emission.texture.id, BLACK));
-    glActiveTexture(GL_TEXTURE0 + 4);
-    glBindTexture(GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material.orm.texture.id, BLACK));
+    r3d_state_bind_texture(1, GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    r3d_state_bind_texture(2, GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material->normal.texture.id, NORMAL));
+    r3d_state_bind_texture(3, GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material->emission.texture.id, BLACK));
+    r3d_state_bind_texture(4, GL_TEXTURE_2D, R3D_TEXTURE_SELECT(call->material->orm.texture.id, BLACK));
 
     /* --- Bind custom uniforms --- */
-    R3D_BindCustomUniforms(shader, &call->material);
+    R3D_BindCustomUniforms(shader, call->material);
 
     /* --- Applying material parameters that are independent of shaders --- */
-    r3d_draw_apply_cull_mode(call->material.cullMode);
+    r3d_draw_apply_cull_mode(call->material->cullMode);
 
     /* --- Rendering the object corresponding to the draw call --- */
     if (r3d_draw_has_instances(group)) {
-        R3D_CustomShaderSetInstancing(shader, true);
+        R3D_CustomShaderSetInstancing(shader, R3D_INSTANCING_MODE(group));
         r3d_draw_instanced(call, 10, 14);
     }
     else {
-        R3D_CustomShaderSetInstancing(shader, false);
+        R3D_CustomShaderSetInstancing(shader, R3D_SHADER_INSTANCING_NONE);
         r3d_draw(call);
     }
 
     /* --- Unbind textures --- */
-    glActiveTexture(GL_TEXTURE0 + 1);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0 + 2);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0 + 3);
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glActiveTexture(GL_TEXTURE0 + 4);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(1, GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(2, GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(3, GL_TEXTURE_2D, 0);
+    r3d_state_bind_texture(4, GL_TEXTURE_2D, 0);
 
     /* --- Switch back to default geometry shader --- */
-    glUseProgram(R3D_MOD_SHADER.scene.geometry.id);
+    r3d_state_use_program(R3D_MOD_SHADER.scene.geometry.id);
 }
 
 void raster_geometry(const r3d_draw_call_t* call)
 {
     /* --- Check for custom shader --- */
-    if (call->material.shader != NULL) {
+    if (call->material->shader != NULL) {
         raster_geometry_custom(call);
         return;
     }
 
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
+    bool bucketed = r3d_draw_call_is_bucketed(call);
 
     /* --- Send matrices --- */
 
-    Matrix matNormal = r3d_matrix_normal(&group->transform);
+    // The transforms of a bucket are read from the instance attributes
+    Matrix matModel = bucketed ? MatrixIdentity() : group->transform;
+    Matrix matNormal = r3d_matrix_normal(&matModel);
 
-    R3D_SHADER_SET_MAT4(scene.geometry, uMatModel, group->transform);
+    R3D_SHADER_SET_MAT4(scene.geometry, uMatModel, matModel);
     R3D_SHADER_SET_MAT4(scene.geometry, uMatNormal, matNormal);
 
+    /* --- Send vertex format related data --- */
+
+    if (call->mesh.vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        const BoundingBox* bounds = &call->mesh.quantizationBounds;
+        R3D_SHADER_SET_INT(scene.geometry, uCompactVertex, true);
+        R3D_SHADER_SET_VEC3(scene.geometry, uPositionMin, bounds->min);
+        R3D_SHADER_SET_VEC3(scene.geometry, uPositionSize, Vector3Subtract(bounds->max, bounds->min));
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.geometry, uCompactVertex, false);
+    }
+
     /* --- Send skinning related data --- */
 
-    if (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
-        R3D_SHADER_BIND_SAMPLER_1D(scene.geometry, uTexBoneMatrices, group->player ? group->player->texGlobalPose : group->skeleton.texBindPose);
+    if (r3d_draw_has_baked_animation(group)) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.geometry, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.geometry, uBoneOffset, group->baked->poseOffset);
+        R3D_SHADER_SET_INT(scene.geometry, uBakedAnimation, true);
+        R3D_SHADER_SET_INT(scene.geometry, uSkinning, true);
+    }
+    else if (!call->preSkinned && (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton))) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.geometry, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.geometry, uBoneOffset, group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset);
+        R3D_SHADER_SET_INT(scene.geometry, uBakedAnimation, false);
         R3D_SHADER_SET_INT(scene.geometry, uSkinning, true);
     }
     else {
@@ -701,49 +1252,53 @@ void raster_geometry(const r3d_draw_call_t* call)
 
     /* --- Send billboard related data --- */
 
-    R3D_SHADER_SET_INT(scene.geometry, uBillboard, call->material.billboardMode);
+    R3D_SHADER_SET_INT(scene.geometry, uBillboard, call->material->billboardMode);
 
     /* --- Set factor material maps --- */
 
-    R3D_SHADER_SET_FLOAT(scene.geometry, uEmissionEnergy, call->material.emission.energy);
-    R3D_SHADER_SET_FLOAT(scene.geometry, uNormalScale, call->material.normal.scale);
-    R3D_SHADER_SET_FLOAT(scene.geometry, uOcclusion, call->material.orm.occlusion);
-    R3D_SHADER_SET_FLOAT(scene.geometry, uRoughness, call->material.orm.roughness);
-    R3D_SHADER_SET_FLOAT(scene.geometry, uMetalness, call->material.orm.metalness);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uEmissionEnergy, call->material->emission.energy);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uNormalScale, call->material->normal.scale);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uOcclusion, call->material->orm.occlusion);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uRoughness, call->material->orm.roughness);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uMetalness, call->material->orm.metalness);
 
     /* --- Set misc material values --- */
 
-    R3D_SHADER_SET_FLOAT(scene.geometry, uAlphaCutoff, call->material.alphaCutoff);
+    R3D_SHADER_SET_FLOAT(scene.geometry, uAlphaCutoff, call->material->alphaCutoff);
 
     /* --- Set texcoord offset/scale --- */
 
-    R3D_SHADER_SET_VEC2(scene.geometry, uTexCoordOffset, call->material.uvOffset);
-    R3D_SHADER_SET_VEC2(scene.geometry, uTexCoordScale, call->material.uvScale);
+    R3D_SHADER_SET_VEC2(scene.geometry, uTexCoordOffset, call->material->uvOffset);
+    R3D_SHADER_SET_VEC2(scene.geometry, uTexCoordScale, call->material->uvScale);
 
     /* --- Set color material maps --- */
 
-    R3D_SHADER_SET_COL4(scene.geometry, uAlbedoColor, call->material.albedo.color);
-    R3D_SHADER_SET_COL3(scene.geometry, uEmissionColor, call->material.emission.color);
+    R3D_SHADER_SET_COL4(scene.geometry, uAlbedoColor, call->material->albedo.color);
+    R3D_SHADER_SET_COL3(scene.geometry, uEmissionColor, call->material->emission.color);
 
     /* --- Bind active texture maps --- */
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexAlbedo, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexNormal, R3D_TEXTURE_SELECT(call->material.normal.texture.id, NORMAL));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexEmission, R3D_TEXTURE_SELECT(call->material.emission.texture.id, BLACK));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexORM, R3D_TEXTURE_SELECT(call->material.orm.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexAlbedo, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexNormal, R3D_TEXTURE_SELECT(call->material->normal.texture.id, NORMAL));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexEmission, R3D_TEXTURE_SELECT(call->material->emission.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexORM, R3D_TEXTURE_SELECT(call->material->orm.texture.id, BLACK));
 
     /* --- Applying material parameters that are independent of shaders --- */
 
-    r3d_draw_apply_cull_mode(call->material.cullMode);
+    r3d_draw_apply_cull_mode(call->material->cullMode);
 
     /* --- Rendering the object corresponding to the draw call --- */
 
     if (r3d_draw_has_instances(group)) {
-        R3D_SHADER_SET_INT(scene.geometry, uInstancing, true);
+        R3D_SHADER_SET_INT(scene.geometry, uInstancing, R3D_INSTANCING_MODE(group));
         r3d_draw_instanced(call, 10, 14);
     }
+    else if (bucketed) {
+        R3D_SHADER_SET_INT(scene.geometry, uInstancing, R3D_SHADER_INSTANCING_MATRIX);
+        r3d_draw_bucket_instanced(10, false);
+    }
     else {
-        R3D_SHADER_SET_INT(scene.geometry, uInstancing, false);
+        R3D_SHADER_SET_INT(scene.geometry, uInstancing, R3D_SHADER_INSTANCING_NONE);
         r3d_draw(call);
     }
 
@@ -755,6 +1310,58 @@ void raster_geometry(const r3d_draw_call_t* call)
     R3D_SHADER_UNBIND_SAMPLER_2D(scene.geometry, uTexORM);
 }
 
+void raster_geometry_bucket(void)
+{
+    if (R3D_MOD_DRAW.bucket.numCalls > 0) {
+        raster_geometry(R3D_MOD_DRAW.bucket.calls[0]);
+        r3d_draw_bucket_clear();
+    }
+}
+
+void raster_geometry_batch(void)
+{
+    int count = R3D_MOD_DRAW.batch.numCalls;
+    if (count == 0) return;
+
+    if (count == 1) {
+        raster_geometry(R3D_MOD_DRAW.batch.calls[0]);
+        r3d_draw_batch_clear();
+        return;
+    }
+
+    // All the calls share the textures and cull mode of the first one,
+    // their transforms and material parameters are read from the instance attributes
+    const R3D_Material* material = R3D_MOD_DRAW.batch.calls[0]->material;
+    Matrix identity = MatrixIdentity();
+
+    R3D_SHADER_SET_MAT4(scene.geometry, uMatModel, identity);
+    R3D_SHADER_SET_MAT4(scene.geometry, uMatNormal, identity);
+
+    R3D_SHADER_SET_INT(scene.geometry, uCompactVertex, false);
+    R3D_SHADER_SET_INT(scene.geometry, uSkinning, false);
+    R3D_SHADER_SET_INT(scene.geometry, uBillboard, R3D_BILLBOARD_DISABLED);
+    R3D_SHADER_SET_INT(scene.geometry, uInstancing, R3D_SHADER_INSTANCING_MATRIX);
+    R3D_SHADER_SET_INT(scene.geometry, uBatchMaterial, true);
+
+    R3D_SHADER_SET_COL4(scene.geometry, uAlbedoColor, WHITE);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexAlbedo, R3D_TEXTURE_SELECT(material->albedo.texture.id, WHITE));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexNormal, R3D_TEXTURE_SELECT(material->normal.texture.id, NORMAL));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexEmission, R3D_TEXTURE_SELECT(material->emission.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.geometry, uTexORM, R3D_TEXTURE_SELECT(material->orm.texture.id, BLACK));
+
+    r3d_draw_apply_cull_mode(material->cullMode);
+    r3d_draw_batch_multi(10, 14, 7);
+    r3d_draw_batch_clear();
+
+    R3D_SHADER_SET_INT(scene.geometry, uBatchMaterial, false);
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.geometry, uTexAlbedo);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.geometry, uTexNormal);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.geometry, uTexEmission);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.geometry, uTexORM);
+}
+
 void raster_decal(const r3d_draw_call_t* call)
 {
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
@@ -768,41 +1375,41 @@ void raster_decal(const r3d_draw_call_t* call)
 
     /* --- Set factor material maps --- */
 
-    R3D_SHADER_SET_FLOAT(scene.decal, uEmissionEnergy, call->material.emission.energy);
-    R3D_SHADER_SET_FLOAT(scene.decal, uNormalScale, call->material.normal.scale);
-    R3D_SHADER_SET_FLOAT(scene.decal, uOcclusion, call->material.orm.occlusion);
-    R3D_SHADER_SET_FLOAT(scene.decal, uRoughness, call->material.orm.roughness);
-    R3D_SHADER_SET_FLOAT(scene.decal, uMetalness, call->material.orm.metalness);
+    R3D_SHADER_SET_FLOAT(scene.decal, uEmissionEnergy, call->material->emission.energy);
+    R3D_SHADER_SET_FLOAT(scene.decal, uNormalScale, call->material->normal.scale);
+    R3D_SHADER_SET_FLOAT(scene.decal, uOcclusion, call->material->orm.occlusion);
+    R3D_SHADER_SET_FLOAT(scene.decal, uRoughness, call->material->orm.roughness);
+    R3D_SHADER_SET_FLOAT(scene.decal, uMetalness, call->material->orm.metalness);
 
     /* --- Set misc material values --- */
 
-    R3D_SHADER_SET_FLOAT(scene.decal, uAlphaCutoff, call->material.alphaCutoff);
+    R3D_SHADER_SET_FLOAT(scene.decal, uAlphaCutoff, call->material->alphaCutoff);
 
     /* --- Set texcoord offset/scale --- */
 
-    R3D_SHADER_SET_VEC2(scene.decal, uTexCoordOffset, call->material.uvOffset);
-    R3D_SHADER_SET_VEC2(scene.decal, uTexCoordScale, call->material.uvScale);
+    R3D_SHADER_SET_VEC2(scene.decal, uTexCoordOffset, call->material->uvOffset);
+    R3D_SHADER_SET_VEC2(scene.decal, uTexCoordScale, call->material->uvScale);
 
     /* --- Set color material maps --- */
 
-    R3D_SHADER_SET_COL4(scene.decal, uAlbedoColor, call->material.albedo.color);
-    R3D_SHADER_SET_COL3(scene.decal, uEmissionColor, call->material.emission.color);
+    R3D_SHADER_SET_COL4(scene.decal, uAlbedoColor, call->material->albedo.color);
+    R3D_SHADER_SET_COL3(scene.decal, uEmissionColor, call->material->emission.color);
 
     /* --- Bind active texture maps --- */
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexAlbedo, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexNormal, R3D_TEXTURE_SELECT(call->material.normal.texture.id, NORMAL));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexEmission, R3D_TEXTURE_SELECT(call->material.emission.texture.id, BLACK));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexORM, R3D_TEXTURE_SELECT(call->material.orm.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexAlbedo, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexNormal, R3D_TEXTURE_SELECT(call->material->normal.texture.id, NORMAL));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexEmission, R3D_TEXTURE_SELECT(call->material->emission.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexORM, R3D_TEXTURE_SELECT(call->material->orm.texture.id, BLACK));
 
     /* --- Applying material parameters that are independent of shaders --- */
 
-    r3d_draw_apply_blend_mode(call->material.blendMode, call->material.transparencyMode);
+    r3d_draw_apply_blend_mode(call->material->blendMode, call->material->transparencyMode);
 
     /* --- Disable face culling to avoid issues when camera is inside the decal bounding mesh --- */
     // TODO: Implement check for if camera is inside the mesh and apply the appropriate face culling / depth testing
 
-    glDisable(GL_CULL_FACE);
+    r3d_state_disable(GL_CULL_FACE);
 
     /* --- Rendering the object corresponding to the draw call --- */
 
@@ -831,7 +1438,7 @@ void raster_decal(const r3d_draw_call_t* call)
     R3D_SHADER_UNBIND_SAMPLER_2D(scene.decal, uTexORM);
 }
 
-void raster_forward(const r3d_draw_call_t* call)
+void raster_forward(const r3d_draw_call_t* call, bool passBlend)
 {
     const r3d_draw_group_t* group = r3d_draw_get_call_group(call);
 
@@ -842,10 +1449,30 @@ void raster_forward(const r3d_draw_call_t* call)
     R3D_SHADER_SET_MAT4(scene.forward, uMatModel, group->transform);
     R3D_SHADER_SET_MAT4(scene.forward, uMatNormal, matNormal);
 
+    /* --- Send vertex format related data --- */
+
+    if (call->mesh.vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        const BoundingBox* bounds = &call->mesh.quantizationBounds;
+        R3D_SHADER_SET_INT(scene.forward, uCompactVertex, true);
+        R3D_SHADER_SET_VEC3(scene.forward, uPositionMin, bounds->min);
+        R3D_SHADER_SET_VEC3(scene.forward, uPositionSize, Vector3Subtract(bounds->max, bounds->min));
+    }
+    else {
+        R3D_SHADER_SET_INT(scene.forward, uCompactVertex, false);
+    }
+
     /* --- Send skinning related data --- */
 
-    if (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton)) {
-        R3D_SHADER_BIND_SAMPLER_1D(scene.forward, uTexBoneMatrices, group->player ? group->player->texGlobalPose : group->skeleton.texBindPose);
+    if (r3d_draw_has_baked_animation(group)) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.forward, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.forward, uBoneOffset, group->baked->poseOffset);
+        R3D_SHADER_SET_INT(scene.forward, uBakedAnimation, true);
+        R3D_SHADER_SET_INT(scene.forward, uSkinning, true);
+    }
+    else if (!call->preSkinned && (group->player != NULL || R3D_IsSkeletonValid(&group->skeleton))) {
+        R3D_SHADER_BIND_SAMPLER_BUFFER(scene.forward, uTexBoneMatrices, R3D_MOD_SKIN.texture);
+        R3D_SHADER_SET_INT(scene.forward, uBoneOffset, group->player ? group->player->poseOffset : group->skeleton.bindPoseOffset);
+        R3D_SHADER_SET_INT(scene.forward, uBakedAnimation, false);
         R3D_SHADER_SET_INT(scene.forward, uSkinning, true);
     }
     else {
@@ -854,50 +1481,53 @@ void raster_forward(const r3d_draw_call_t* call)
 
     /* --- Send billboard related data --- */
 
-    R3D_SHADER_SET_INT(scene.forward, uBillboard, call->material.billboardMode);
+    R3D_SHADER_SET_INT(scene.forward, uBillboard, call->material->billboardMode);
 
     /* --- Set factor material maps --- */
 
-    R3D_SHADER_SET_FLOAT(scene.forward, uEmissionEnergy, call->material.emission.energy);
-    R3D_SHADER_SET_FLOAT(scene.forward, uNormalScale, call->material.normal.scale);
-    R3D_SHADER_SET_FLOAT(scene.forward, uOcclusion, call->material.orm.occlusion);
-    R3D_SHADER_SET_FLOAT(scene.forward, uRoughness, call->material.orm.roughness);
-    R3D_SHADER_SET_FLOAT(scene.forward, uMetalness, call->material.orm.metalness);
+    R3D_SHADER_SET_FLOAT(scene.forward, uEmissionEnergy, call->material->emission.energy);
+    R3D_SHADER_SET_FLOAT(scene.forward, uNormalScale, call->material->normal.scale);
+    R3D_SHADER_SET_FLOAT(scene.forward, uOcclusion, call->material->orm.occlusion);
+    R3D_SHADER_SET_FLOAT(scene.forward, uRoughness, call->material->orm.roughness);
+    R3D_SHADER_SET_FLOAT(scene.forward, uMetalness, call->material->orm.metalness);
 
     /* --- Set misc material values --- */
 
-    R3D_SHADER_SET_FLOAT(scene.forward, uAlphaCutoff, call->material.alphaCutoff);
+    R3D_SHADER_SET_FLOAT(scene.forward, uAlphaCutoff, call->material->alphaCutoff);
 
     /* --- Set texcoord offset/scale --- */
 
-    R3D_SHADER_SET_VEC2(scene.forward, uTexCoordOffset, call->material.uvOffset);
-    R3D_SHADER_SET_VEC2(scene.forward, uTexCoordScale, call->material.uvScale);
+    R3D_SHADER_SET_VEC2(scene.forward, uTexCoordOffset, call->material->uvOffset);
+    R3D_SHADER_SET_VEC2(scene.forward, uTexCoordScale, call->material->uvScale);
 
     /* --- Set color material maps --- */
 
-    R3D_SHADER_SET_COL4(scene.forward, uAlbedoColor, call->material.albedo.color);
-    R3D_SHADER_SET_COL3(scene.forward, uEmissionColor, call->material.emission.color);
+    R3D_SHADER_SET_COL4(scene.forward, uAlbedoColor, call->material->albedo.color);
+    R3D_SHADER_SET_COL3(scene.forward, uEmissionColor, call->material->emission.color);
 
     /* --- Bind active texture maps --- */
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexAlbedo, R3D_TEXTURE_SELECT(call->material.albedo.texture.id, WHITE));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexNormal, R3D_TEXTURE_SELECT(call->material.normal.texture.id, NORMAL));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexEmission, R3D_TEXTURE_SELECT(call->material.emission.texture.id, BLACK));
-    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexORM, R3D_TEXTURE_SELECT(call->material.orm.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexAlbedo, R3D_TEXTURE_SELECT(call->material->albedo.texture.id, WHITE));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexNormal, R3D_TEXTURE_SELECT(call->material->normal.texture.id, NORMAL));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexEmission, R3D_TEXTURE_SELECT(call->material->emission.texture.id, BLACK));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexORM, R3D_TEXTURE_SELECT(call->material->orm.texture.id, BLACK));
 
     /* --- Applying material parameters that are independent of shaders --- */
 
-    r3d_draw_apply_blend_mode(call->material.blendMode, call->material.transparencyMode);
-    r3d_draw_apply_cull_mode(call->material.cullMode);
+    // The weighted accumulation and the reduced targets set the blending of their draws
+    if (!passBlend) {
+        r3d_draw_apply_blend_mode(call->material->blendMode, call->material->transparencyMode);
+    }
+    r3d_draw_apply_cull_mode(call->material->cullMode);
 
     /* --- Rendering the object corresponding to the draw call --- */
 
     if (r3d_draw_has_instances(group)) {
-        R3D_SHADER_SET_INT(scene.forward, uInstancing, true);
+        R3D_SHADER_SET_INT(scene.forward, uInstancing, R3D_INSTANCING_MODE(group));
         r3d_draw_instanced(call, 10, 14);
     }
     else {
-        R3D_SHADER_SET_INT(scene.forward, uInstancing, false);
+        R3D_SHADER_SET_INT(scene.forward, uInstancing, R3D_SHADER_INSTANCING_NONE);
         r3d_draw(call);
     }
 
@@ -911,120 +1541,378 @@ void raster_forward(const r3d_draw_call_t* call)
 
 void pass_scene_shadow(void)
 {
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_TRUE);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(true);
+
+    R3D_MOD_DRAW.shadowLods = true;
+
+    // All the shadows are rendered in the tiles of the atlas, the scissor restricts the clears to them
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_LIGHT.shadowAtlasFbo);
+    r3d_state_enable(GL_SCISSOR_TEST);
 
     R3D_LIGHT_FOR_EACH_VISIBLE(light)
     {
-        if (!r3d_light_shadow_should_be_upadted(light, true)) {
+        if (!r3d_light_has_shadow_tiles(light) || !r3d_light_shadow_should_be_upadted(light, true)) {
             continue;
         }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, light->shadowMap.fbo);
-        glViewport(0, 0, light->shadowMap.resolution, light->shadowMap.resolution);
+        R3D_PROFILE_COUNT(shadowMapsUpdated, 1);
 
         if (light->type == R3D_LIGHT_OMNI) {
             R3D_SHADER_USE(scene.depthCube);
             R3D_SHADER_SET_FLOAT(scene.depthCube, uFar, light->far);
             R3D_SHADER_SET_VEC3(scene.depthCube, uViewPosition, light->position);
 
+            /* --- Send the projections of the faces --- */
+
+            // The tiles share one viewport covering the atlas, the geometry shader
+            // moves the projection of each face into its tile and clips it there
+            float invAtlasSize = 1.0f / R3D_MOD_LIGHT.shadowAtlasSize;
+
             for (int iFace = 0; iFace < 6; iFace++) {
-                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + iFace, light->shadowMap.tex, 0);
-                glClear(GL_DEPTH_BUFFER_BIT);
+                r3d_rect_t tile = r3d_light_get_shadow_tile(light, iFace);
+                R3D_SHADER_SET_MAT4(scene.depthCube, uMatFaceVP[iFace], light->matVP[iFace]);
+                R3D_SHADER_SET_VEC4(scene.depthCube, uFaceTiles[iFace], ((Vector4) {
+                    tile.w * invAtlasSize, tile.h * invAtlasSize,
+                    (2 * tile.x + tile.w) * invAtlasSize - 1.0f,
+                    (2 * tile.y + tile.h) * invAtlasSize - 1.0f
+                }));
+            }
 
-                const r3d_frustum_t* frustum = NULL;
-                if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
-                    frustum = &light->frustum[iFace];
-                    r3d_draw_compute_visible_groups(frustum);
+            glViewport(0, 0, R3D_MOD_LIGHT.shadowAtlasSize, R3D_MOD_LIGHT.shadowAtlasSize);
+            for (int i = 0; i < 4; i++) r3d_state_enable(GL_CLIP_DISTANCE0 + i);
+
+            const r3d_frustum_t* frustum = NULL;
+            if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
+                frustum = &light->volumeFrustum;
+                r3d_draw_compute_visible_groups(frustum);
+            }
+
+            // The budget can leave some faces to the next frames
+            uint32_t updateMask = light->state.viewMask;
+            uint32_t cacheMask = light->shadowMap.cacheMask;
+            uint32_t rebuildMask = light->shadowMap.cacheRebuildMask;
+
+            /* --- Render the static casters of the faces whose cache is rebuilt --- */
+
+            if (rebuildMask != 0) {
+                r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_LIGHT.shadowCacheFbo);
+
+                for (int iFace = 0; iFace < 6; iFace++) {
+                    if (!r3d_light_rebuilds_shadow_cache(light, iFace)) continue;
+                    r3d_rect_t tile = r3d_light_get_shadow_tile(light, iFace);
+                    glScissor(tile.x, tile.y, tile.w, tile.h);
+                    glClear(GL_DEPTH_BUFFER_BIT);
                 }
 
-                #define COND (call->mesh.shadowCastMode != R3D_SHADOW_CAST_DISABLED)
+                glScissor(0, 0, R3D_MOD_LIGHT.shadowAtlasSize, R3D_MOD_LIGHT.shadowAtlasSize);
+
+                #define COND (call->mesh.shadowCastMode != R3D_SHADOW_CAST_DISABLED && r3d_draw_get_call_group(call)->staticCaster)
                 R3D_DRAW_FOR_EACH(call, COND, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS) {
-                    raster_depth_cube(call, true, &light->matVP[iFace]);
+                    uint32_t faceMask = (frustum != NULL) ? r3d_draw_call_get_view_mask(call, light->frustum, 6) : 0x3F;
+                    faceMask &= rebuildMask;
+                    if (faceMask != 0) {
+                        R3D_SHADER_SET_INT(scene.depthCube, uFaceMask, (int)faceMask);
+                        raster_depth_cube(call, true);
+                    }
                 }
                 #undef COND
+
+                r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_LIGHT.shadowAtlasFbo);
             }
 
-            // The bone matrices texture may have been bind during drawcalls, so UNBIND!
-            R3D_SHADER_UNBIND_SAMPLER_1D(scene.depthCube, uTexBoneMatrices);
-        }
-        else {
-            glClear(GL_DEPTH_BUFFER_BIT);
-            R3D_SHADER_USE(scene.depth);
+            /* --- Start the faces from their cached static casters, or clear them --- */
 
-            const r3d_frustum_t* frustum = NULL;
-            if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
-                frustum = &light->frustum[0];
-                r3d_draw_compute_visible_groups(frustum);
+            for (int iFace = 0; iFace < 6; iFace++) {
+                if (!r3d_light_is_shadow_view_updated(light, iFace)) continue;
+                r3d_rect_t tile = r3d_light_get_shadow_tile(light, iFace);
+                glScissor(tile.x, tile.y, tile.w, tile.h);
+                if (r3d_light_has_shadow_cache(light, iFace)) {
+                    r3d_state_bind_framebuffer(GL_READ_FRAMEBUFFER, R3D_MOD_LIGHT.shadowCacheFbo);
+                    glBlitFramebuffer(
+                        tile.x, tile.y, tile.x + tile.w, tile.y + tile.h,
+                        tile.x, tile.y, tile.x + tile.w, tile.y + tile.h,
+                        GL_DEPTH_BUFFER_BIT, GL_NEAREST
+                    );
+                }
+                else {
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
             }
 
+            glScissor(0, 0, R3D_MOD_LIGHT.shadowAtlasSize, R3D_MOD_LIGHT.shadowAtlasSize);
+
+            /* --- Submit each caster once, with the faces where it is visible --- */
+
+            // The static casters are only rendered in the faces without cache
             #define COND (call->mesh.shadowCastMode != R3D_SHADOW_CAST_DISABLED)
             R3D_DRAW_FOR_EACH(call, COND, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS) {
-                raster_depth(call, true, &light->matVP[0]);
+                uint32_t faceMask = (frustum != NULL) ? r3d_draw_call_get_view_mask(call, light->frustum, 6) : 0x3F;
+                faceMask &= updateMask;
+                if (r3d_draw_get_call_group(call)->staticCaster) faceMask &= ~cacheMask;
+                if (faceMask != 0) {
+                    R3D_SHADER_SET_INT(scene.depthCube, uFaceMask, (int)faceMask);
+                    raster_depth_cube(call, true);
+                }
             }
             #undef COND
 
+            for (int i = 0; i < 4; i++) r3d_state_disable(GL_CLIP_DISTANCE0 + i);
+
+            // The bone matrices texture may have been bind during drawcalls, so UNBIND!
+            R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.depthCube, uTexBoneMatrices);
+        }
+        else {
+            R3D_SHADER_USE(scene.depth);
+
+            // Only the cascades of dir lights rendered with this update are cleared
+            int numViews = r3d_light_get_shadow_views(light);
+            for (int iView = 0; iView < numViews; iView++) {
+                if (!r3d_light_is_shadow_view_updated(light, iView)) {
+                    continue;
+                }
+
+                r3d_rect_t tile = r3d_light_get_shadow_tile(light, iView);
+                glViewport(tile.x, tile.y, tile.w, tile.h);
+                glScissor(tile.x, tile.y, tile.w, tile.h);
+
+                bool culling = !R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING);
+                bool cached = r3d_light_has_shadow_cache(light, iView);
+
+                /* --- Render the static casters in the cache if it is rebuilt --- */
+
+                // The cache is kept while the view changes, its casters are culled with the whole light frustum
+                if (r3d_light_rebuilds_shadow_cache(light, iView)) {
+                    const r3d_frustum_t* frustum = NULL;
+                    if (culling) {
+                        frustum = &light->frustum[iView];
+                        r3d_draw_compute_visible_groups(frustum);
+                    }
+
+                    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_LIGHT.shadowCacheFbo);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+
+                    #define COND (call->mesh.shadowCastMode != R3D_SHADOW_CAST_DISABLED && r3d_draw_get_call_group(call)->staticCaster)
+                    R3D_DRAW_FOR_EACH(call, COND, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS) {
+                        raster_depth_queue(call, true, &light->matVP[iView]);
+                    }
+                    raster_depth_flush(true, &light->matVP[iView]);
+                    #undef COND
+
+                    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, R3D_MOD_LIGHT.shadowAtlasFbo);
+                }
+
+                /* --- Start from the cached static casters, then add the others --- */
+
+                // Only the casters able to shadow the receivers in view are rendered
+                const r3d_frustum_t* frustum = NULL;
+                if (culling) {
+                    frustum = &light->casterFrustum[iView];
+                    r3d_draw_compute_visible_groups(frustum);
+                }
+
+                if (cached) {
+                    r3d_state_bind_framebuffer(GL_READ_FRAMEBUFFER, R3D_MOD_LIGHT.shadowCacheFbo);
+                    glBlitFramebuffer(
+                        tile.x, tile.y, tile.x + tile.w, tile.y + tile.h,
+                        tile.x, tile.y, tile.x + tile.w, tile.y + tile.h,
+                        GL_DEPTH_BUFFER_BIT, GL_NEAREST
+                    );
+                }
+                else {
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                }
+
+                #define COND (call->mesh.shadowCastMode != R3D_SHADOW_CAST_DISABLED && !(cached && r3d_draw_get_call_group(call)->staticCaster))
+                R3D_DRAW_FOR_EACH(call, COND, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS) {
+                    raster_depth_queue(call, true, &light->matVP[iView]);
+                }
+                raster_depth_flush(true, &light->matVP[iView]);
+                #undef COND
+            }
+
             // The bone matrices texture may have been bind during drawcalls, so UNBIND!
-            R3D_SHADER_UNBIND_SAMPLER_1D(scene.depth, uTexBoneMatrices);
+            R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.depth, uTexBoneMatrices);
         }
     }
+
+    r3d_state_disable(GL_SCISSOR_TEST);
+
+    R3D_MOD_DRAW.shadowLods = false;
 }
 
 void pass_scene_geometry(void)
 {
-    R3D_TARGET_BIND(R3D_TARGET_GBUFFER);
-    R3D_SHADER_USE(scene.geometry);
-
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-
     const r3d_frustum_t* frustum = NULL;
     if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
         frustum = &R3D_CACHE_GET(viewState.frustum);
     }
 
-    R3D_DRAW_FOR_EACH(call, true, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED) {
-        raster_geometry(call);
-    }
+    /* --- Lay down the depth first, the G-buffer is then only written by the visible fragments --- */
 
-    // The bone matrices texture may have been bind during drawcalls, so UNBIND!
-    R3D_SHADER_UNBIND_SAMPLER_1D(scene.geometry, uTexBoneMatrices);
-}
+    // Custom shaders may move their vertices, they are rendered with a regular depth test afterwards
+    bool depthPrepass = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_DEPTH_PREPASS);
 
-void pass_scene_decals(void)
-{
-    R3D_TARGET_BIND(R3D_TARGET_GBUFFER);
-    R3D_SHADER_USE(scene.decal);
+    if (depthPrepass) {
+        R3D_TARGET_BIND(R3D_TARGET_DEPTH);
+        R3D_SHADER_USE(scene.depth);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
-    glEnable(GL_BLEND);
+        r3d_state_enable(GL_DEPTH_TEST);
+        r3d_state_depth_func(GL_LEQUAL);
+        r3d_state_depth_mask(true);
+        r3d_state_disable(GL_BLEND);
 
-    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+        R3D_DRAW_FOR_EACH(call, call->material->shader == NULL, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED) {
+            raster_depth_queue(call, false, &R3D_CACHE_GET(viewState.viewProj));
+        }
+        raster_depth_flush(false, &R3D_CACHE_GET(viewState.viewProj));
 
-    const r3d_frustum_t* frustum = NULL;
-    if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
-        frustum = &R3D_CACHE_GET(viewState.frustum);
+        R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.depth, uTexBoneMatrices);
     }
 
-    R3D_DRAW_FOR_EACH(call, true, frustum, R3D_DRAW_DECAL_INST, R3D_DRAW_DECAL) {
-        raster_decal(call);
-    }
+    /* --- Fill the G-buffer --- */
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decal, uTexDepth);
-}
+    R3D_TARGET_BIND(R3D_TARGET_GBUFFER);
+    R3D_SHADER_USE(scene.geometry);
 
-r3d_target_t pass_prepare_ssao(void)
-{
-    glDisable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(depthPrepass ? GL_EQUAL : GL_LEQUAL);
+    r3d_state_depth_mask(!depthPrepass);
+    r3d_state_disable(GL_BLEND);
 
-    /* --- Calculate SSAO --- */
+    // The lists are state sorted, compatible calls are contiguous and merged into multi-draws,
+    // or into instanced draws for the identical calls that can't be batched
+    R3D_DRAW_FOR_EACH(call, true, frustum, R3D_DRAW_DEFERRED_INST, R3D_DRAW_DEFERRED) {
+        if (!r3d_draw_batch_accepts(call)) {
+            raster_geometry_batch();
+        }
+        if (!r3d_draw_bucket_accepts(call)) {
+            raster_geometry_bucket();
+        }
+        if (r3d_draw_call_is_batchable(call)) {
+            r3d_draw_batch_push(call);
+        }
+        else if (r3d_draw_bucket_accepts(call)) {
+            r3d_draw_bucket_push(call);
+        }
+        else if (depthPrepass && call->material->shader != NULL) {
+            r3d_state_depth_func(GL_LEQUAL);
+            r3d_state_depth_mask(true);
+            raster_geometry(call);
+            r3d_state_depth_func(GL_EQUAL);
+            r3d_state_depth_mask(false);
+        }
+        else {
+            raster_geometry(call);
+        }
+    }
+
+    raster_geometry_batch();
+    raster_geometry_bucket();
+
+    // The bone matrices texture may have been bind during drawcalls, so UNBIND!
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.geometry, uTexBoneMatrices);
+}
+
+void pass_scene_decals(void)
+{
+    const r3d_frustum_t* frustum = NULL;
+    if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
+        frustum = &R3D_CACHE_GET(viewState.frustum);
+    }
+
+    /* --- Apply the decals from the screen tiles when there are enough of them --- */
+
+    int numBatches = r3d_draw_build_decal_clusters(frustum, &R3D_CACHE_GET(viewState.viewProj));
+    if (numBatches > 0) {
+        pass_scene_decals_clustered(numBatches);
+    }
+
+    /* --- Then draw the volume of the remaining decals --- */
+
+    R3D_TARGET_BIND(R3D_TARGET_GBUFFER);
+    R3D_SHADER_USE(scene.decal);
+
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(false);
+    r3d_state_enable(GL_BLEND);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decal, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+
+    R3D_DRAW_FOR_EACH(call, !r3d_draw_decal_is_clustered(call), frustum, R3D_DRAW_DECAL_INST, R3D_DRAW_DECAL) {
+        raster_decal(call);
+    }
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decal, uTexDepth);
+}
+
+void pass_scene_decals_clustered(int numBatches)
+{
+    // Only the geometry is touched, the decals of a pixel are composited by the shader then blended once
+    R3D_TARGET_BIND(R3D_TARGET_ALBEDO, R3D_TARGET_DIFFUSE, R3D_TARGET_ORM, R3D_TARGET_DEPTH);
+    R3D_SHADER_USE(scene.decalClustered);
+
+    r3d_state_enable(GL_SCISSOR_TEST);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_GREATER);
+    r3d_state_depth_mask(false);
+    r3d_state_enable(GL_BLEND);
+    r3d_state_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.decalClustered, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_BIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecals, R3D_MOD_DRAW.decals.paramTexture);
+    R3D_SHADER_BIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecalTiles, R3D_MOD_DRAW.decals.tileTexture);
+    R3D_SHADER_BIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecalIndices, R3D_MOD_DRAW.decals.indexTexture);
+
+    R3D_SHADER_SET_VEC2(scene.decalClustered, uTileScale, (Vector2) {
+        (float)R3D_SHADER_DECAL_TILE_X / R3D_TARGET_WIDTH,
+        (float)R3D_SHADER_DECAL_TILE_Y / R3D_TARGET_HEIGHT
+    });
+
+    for (int i = 0; i < numBatches; i++)
+    {
+        const r3d_draw_decal_batch_t* batch = &R3D_MOD_DRAW.decals.batches[i];
+        if (batch->numDecals == 0) continue;
+
+        const R3D_Material* material = batch->material;
+
+        R3D_SHADER_BIND_SAMPLER_2D(scene.decalClustered, uTexAlbedo, R3D_TEXTURE_SELECT(material->albedo.texture.id, WHITE));
+        R3D_SHADER_BIND_SAMPLER_2D(scene.decalClustered, uTexEmission, R3D_TEXTURE_SELECT(material->emission.texture.id, BLACK));
+        R3D_SHADER_BIND_SAMPLER_2D(scene.decalClustered, uTexORM, R3D_TEXTURE_SELECT(material->orm.texture.id, BLACK));
+
+        R3D_SHADER_SET_INT(scene.decalClustered, uTileOffset, i * R3D_SHADER_DECAL_TILE_X * R3D_SHADER_DECAL_TILE_Y);
+
+        // Scissor to the tiles covered by the batch, rounded outwards to whole pixels
+        int x0 = batch->tileMin[0] * R3D_TARGET_WIDTH / R3D_SHADER_DECAL_TILE_X;
+        int y0 = batch->tileMin[1] * R3D_TARGET_HEIGHT / R3D_SHADER_DECAL_TILE_Y;
+        int x1 = ((batch->tileMax[0] + 1) * R3D_TARGET_WIDTH + R3D_SHADER_DECAL_TILE_X - 1) / R3D_SHADER_DECAL_TILE_X;
+        int y1 = ((batch->tileMax[1] + 1) * R3D_TARGET_HEIGHT + R3D_SHADER_DECAL_TILE_Y - 1) / R3D_SHADER_DECAL_TILE_Y;
+
+        glScissor(x0, y0, x1 - x0, y1 - y0);
+
+        R3D_PRIMITIVE_DRAW_SCREEN();
+    }
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decalClustered, uTexAlbedo);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decalClustered, uTexEmission);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decalClustered, uTexORM);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.decalClustered, uTexDepth);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecals);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecalTiles);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.decalClustered, uTexDecalIndices);
+
+    r3d_state_disable(GL_SCISSOR_TEST);
+}
+
+r3d_target_t pass_prepare_ssao(bool temporal)
+{
+    r3d_state_disable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
+
+    /* --- Calculate SSAO --- */
 
     r3d_target_t ssaoTarget = R3D_TARGET_SSAO_0;
     R3D_TARGET_BIND_AND_SWAP_SSAO(ssaoTarget);
@@ -1036,6 +1924,7 @@ r3d_target_t pass_prepare_ssao(void)
     R3D_SHADER_SET_FLOAT(prepare.ssao, uBias, R3D_CACHE_GET(environment.ssao.bias));
     R3D_SHADER_SET_FLOAT(prepare.ssao, uIntensity, R3D_CACHE_GET(environment.ssao.intensity));
     R3D_SHADER_SET_FLOAT(prepare.ssao, uPower, R3D_CACHE_GET(environment.ssao.power));
+    R3D_SHADER_SET_INT(prepare.ssao, uFrameIndex, temporal ? (int)R3D_CACHE_GET(temporal.frameIndex) : 0);
 
     R3D_SHADER_BIND_SAMPLER_2D(prepare.ssao, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
     R3D_SHADER_BIND_SAMPLER_2D(prepare.ssao, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
@@ -1045,7 +1934,62 @@ r3d_target_t pass_prepare_ssao(void)
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssao, uTexDepth);
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssao, uTexNormal);
 
-    /* --- Blur SSAO --- */
+    /* --- Accumulate SSAO over frames, replaces the blur --- */
+
+    if (temporal)
+    {
+        // The history targets alternate each frame, one is read while the other is written
+        uint32_t frame = R3D_CACHE_GET(temporal.frameIndex);
+        r3d_target_t historyTarget = R3D_TARGET_SSAO_HISTORY_0 + (frame & 1);
+        r3d_target_t prevHistoryTarget = R3D_TARGET_SSAO_HISTORY_0 + ((frame + 1) & 1);
+        bool hasHistory = R3D_CACHE_GET(temporal.ssaoHistory);
+
+        R3D_TARGET_BIND(historyTarget);
+        R3D_SHADER_USE(prepare.ssaoTemporal);
+
+        R3D_SHADER_SET_MAT4(prepare.ssaoTemporal, uMatPrevViewProj, R3D_CACHE_GET(temporal.prevViewProj));
+        R3D_SHADER_SET_VEC2(prepare.ssaoTemporal, uPrevUvScale, R3D_CACHE_GET(temporal.prevUvScale));
+        R3D_SHADER_SET_FLOAT(prepare.ssaoTemporal, uHistoryWeight, hasHistory ? R3D_SSAO_HISTORY_WEIGHT : 0.0f);
+
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoTemporal, uTexSource, r3d_target_get(r3d_target_swap_ssao(ssaoTarget)));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoTemporal, uTexHistory, hasHistory ? r3d_target_get(prevHistoryTarget) : r3d_texture_get(R3D_TEXTURE_WHITE));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoTemporal, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+
+        R3D_PRIMITIVE_DRAW_SCREEN();
+
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoTemporal, uTexSource);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoTemporal, uTexHistory);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoTemporal, uTexDepth);
+
+        return historyTarget;
+    }
+
+    /* --- Blur SSAO, both directions in a single dispatch when compute shaders are supported --- */
+
+    if (GLAD_GL_VERSION_4_3) {
+        r3d_target_t sourceTarget = r3d_target_swap_ssao(ssaoTarget);
+        int w = 0, h = 0;
+
+        R3D_SHADER_USE(prepare.ssaoBlurCompute);
+
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexSource, r3d_target_get(sourceTarget));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+
+        r3d_target_bind_image(0, ssaoTarget, 0, GL_WRITE_ONLY);
+
+        r3d_target_get_resolution(&w, &h, 1);
+        glDispatchCompute((w + 15) / 16, (h + 15) / 16, 1);
+
+        // The result is then sampled, and rendered into again by the next frame
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexSource);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexNormal);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssaoBlurCompute, uTexDepth);
+
+        return ssaoTarget;
+    }
 
     R3D_SHADER_USE(prepare.ssaoBlur);
 
@@ -1071,16 +2015,33 @@ r3d_target_t pass_prepare_ssao(void)
     return r3d_target_swap_ssao(ssaoTarget);
 }
 
-r3d_target_t pass_prepare_ssil(void)
+r3d_target_t pass_prepare_ssil(bool temporal)
 {
-    glDisable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_disable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
 
     /* --- Calculate SSIL --- */
 
+    // When temporal, one pixel of each 2x2 block is shaded into the sparse target, in turn
+    static const Vector2 PIXEL_OFFSETS[4] = {
+        {0.0f, 0.0f}, {1.0f, 1.0f}, {1.0f, 0.0f}, {0.0f, 1.0f}
+    };
+
+    uint32_t frame = R3D_CACHE_GET(temporal.frameIndex);
+    Vector2 pixelOffset = PIXEL_OFFSETS[frame % 4];
+    Vector2 texelSize = {0};
+
     r3d_target_t ssilTarget = R3D_TARGET_SSIL_0;
-    R3D_TARGET_BIND_AND_SWAP_SSIL(ssilTarget);
+    r3d_target_t historyTarget = R3D_TARGET_INVALID;
+
+    if (temporal) {
+        r3d_target_get_texel_size(&texelSize.x, &texelSize.y, 1);
+        R3D_TARGET_BIND(R3D_TARGET_SSIL_SPARSE);
+    }
+    else {
+        R3D_TARGET_BIND_AND_SWAP_SSIL(ssilTarget);
+    }
 
     R3D_SHADER_USE(prepare.ssil);
 
@@ -1094,6 +2055,9 @@ r3d_target_t pass_prepare_ssil(void)
     R3D_SHADER_SET_FLOAT(prepare.ssil, uHitThickness, R3D_CACHE_GET(environment.ssil.hitThickness));
     R3D_SHADER_SET_FLOAT(prepare.ssil, uAoPower, R3D_CACHE_GET(environment.ssil.aoPower));
     R3D_SHADER_SET_FLOAT(prepare.ssil, uEnergy, R3D_CACHE_GET(environment.ssil.energy));
+    R3D_SHADER_SET_INT(prepare.ssil, uFrameIndex, temporal ? (int)frame : 0);
+    R3D_SHADER_SET_VEC2(prepare.ssil, uPixelOffset, pixelOffset);
+    R3D_SHADER_SET_VEC2(prepare.ssil, uTexelSize, texelSize);
 
     R3D_PRIMITIVE_DRAW_SCREEN();
 
@@ -1101,7 +2065,68 @@ r3d_target_t pass_prepare_ssil(void)
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssil, uTexNormal);
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssil, uTexLight);
 
-    /* --- Blur SSIL --- */
+    /* --- Reconstruct the full SSIL from the sparse samples and the history --- */
+
+    if (temporal)
+    {
+        // The history targets alternate each frame, one is read while the other is written
+        historyTarget = R3D_TARGET_SSIL_HISTORY_0 + (frame & 1);
+        r3d_target_t geometryTarget = R3D_TARGET_SSIL_GEOMETRY_0 + (frame & 1);
+        r3d_target_t prevHistoryTarget = R3D_TARGET_SSIL_HISTORY_0 + ((frame + 1) & 1);
+        r3d_target_t prevGeometryTarget = R3D_TARGET_SSIL_GEOMETRY_0 + ((frame + 1) & 1);
+        bool hasHistory = R3D_CACHE_GET(temporal.ssilHistory);
+
+        float convergence = Clamp(R3D_CACHE_GET(environment.ssil.convergence), 0.0f, 1.0f);
+
+        R3D_TARGET_BIND(historyTarget, geometryTarget);
+        R3D_SHADER_USE(prepare.ssilTemporal);
+
+        R3D_SHADER_SET_MAT4(prepare.ssilTemporal, uMatPrevViewProj, R3D_CACHE_GET(temporal.prevViewProj));
+        R3D_SHADER_SET_VEC2(prepare.ssilTemporal, uPrevUvScale, R3D_CACHE_GET(temporal.prevUvScale));
+        R3D_SHADER_SET_VEC2(prepare.ssilTemporal, uPixelOffset, pixelOffset);
+        R3D_SHADER_SET_FLOAT(prepare.ssilTemporal, uConvergence, hasHistory ? convergence : 1.0f);
+
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilTemporal, uTexSparse, r3d_target_get(R3D_TARGET_SSIL_SPARSE));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilTemporal, uTexHistory, hasHistory ? r3d_target_get(prevHistoryTarget) : r3d_texture_get(R3D_TEXTURE_BLACK));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilTemporal, uTexHistoryGeometry, hasHistory ? r3d_target_get(prevGeometryTarget) : r3d_texture_get(R3D_TEXTURE_BLACK));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilTemporal, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilTemporal, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+
+        R3D_PRIMITIVE_DRAW_SCREEN();
+
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilTemporal, uTexSparse);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilTemporal, uTexHistory);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilTemporal, uTexHistoryGeometry);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilTemporal, uTexDepth);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilTemporal, uTexNormal);
+    }
+
+    /* --- Blur SSIL, the history itself is kept unblurred --- */
+
+    if (GLAD_GL_VERSION_4_3) {
+        r3d_target_t sourceTarget = temporal ? historyTarget : r3d_target_swap_ssil(ssilTarget);
+        int w = 0, h = 0;
+
+        R3D_SHADER_USE(prepare.ssilBlurCompute);
+
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexSource, r3d_target_get(sourceTarget));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+
+        r3d_target_bind_image(0, ssilTarget, 0, GL_WRITE_ONLY);
+
+        r3d_target_get_resolution(&w, &h, 1);
+        glDispatchCompute((w + 15) / 16, (h + 15) / 16, 1);
+
+        // The result is then sampled, and rendered into again by the next frame
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexSource);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexNormal);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssilBlurCompute, uTexDepth);
+
+        return ssilTarget;
+    }
 
     R3D_SHADER_USE(prepare.ssilBlur);
 
@@ -1110,7 +2135,7 @@ r3d_target_t pass_prepare_ssil(void)
 
     // Horizontal pass
     R3D_TARGET_BIND_AND_SWAP_SSIL(ssilTarget);
-    R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilBlur, uTexSource, r3d_target_get(ssilTarget));
+    R3D_SHADER_BIND_SAMPLER_2D(prepare.ssilBlur, uTexSource, r3d_target_get(temporal ? historyTarget : ssilTarget));
     R3D_SHADER_SET_VEC2(prepare.ssilBlur, uDirection, (Vector2) {1.0f, 0.0f});
     R3D_PRIMITIVE_DRAW_SCREEN();
 
@@ -1129,9 +2154,9 @@ r3d_target_t pass_prepare_ssil(void)
 
 r3d_target_t pass_prepare_ssr(void)
 {
-    glDisable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_disable(GL_DEPTH_TEST);   //< Can't depth test to touch only the geometry, since the target is half res...
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
 
     R3D_TARGET_BIND(R3D_TARGET_SSR);
     R3D_SHADER_USE(prepare.ssr);
@@ -1141,7 +2166,9 @@ r3d_target_t pass_prepare_ssr(void)
     R3D_SHADER_BIND_SAMPLER_2D(prepare.ssr, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
     R3D_SHADER_BIND_SAMPLER_2D(prepare.ssr, uTexORM, r3d_target_get(R3D_TARGET_ORM));
     R3D_SHADER_BIND_SAMPLER_2D(prepare.ssr, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_BIND_SAMPLER_2D(prepare.ssr, uTexHiZ, R3D_MOD_OCCLUSION.texture);
 
+    R3D_SHADER_SET_INT(prepare.ssr, uHiZMaxLevel, R3D_MOD_OCCLUSION.numLevels - 1);
     R3D_SHADER_SET_INT(prepare.ssr, uMaxRaySteps, R3D_CACHE_GET(environment.ssr.maxRaySteps));
     R3D_SHADER_SET_INT(prepare.ssr, uBinarySearchSteps, R3D_CACHE_GET(environment.ssr.binarySearchSteps));
     R3D_SHADER_SET_FLOAT(prepare.ssr, uRayMarchLength, R3D_CACHE_GET(environment.ssr.rayMarchLength));
@@ -1149,6 +2176,7 @@ r3d_target_t pass_prepare_ssr(void)
     R3D_SHADER_SET_FLOAT(prepare.ssr, uDepthTolerance, R3D_CACHE_GET(environment.ssr.depthTolerance));
     R3D_SHADER_SET_FLOAT(prepare.ssr, uEdgeFadeStart, R3D_CACHE_GET(environment.ssr.edgeFadeStart));
     R3D_SHADER_SET_FLOAT(prepare.ssr, uEdgeFadeEnd, R3D_CACHE_GET(environment.ssr.edgeFadeEnd));
+    R3D_SHADER_SET_FLOAT(prepare.ssr, uRoughnessCutoff, R3D_CACHE_GET(environment.ssr.roughnessCutoff));
 
     R3D_SHADER_SET_COL3(prepare.ssr, uAmbientColor, R3D_CACHE_GET(environment.ambient.color));
     R3D_SHADER_SET_FLOAT(prepare.ssr, uAmbientEnergy, R3D_CACHE_GET(environment.ambient.energy));
@@ -1160,6 +2188,7 @@ r3d_target_t pass_prepare_ssr(void)
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssr, uTexNormal);
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssr, uTexORM);
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssr, uTexDepth);
+    R3D_SHADER_UNBIND_SAMPLER_2D(prepare.ssr, uTexHiZ);
 
     r3d_target_gen_mipmap(R3D_TARGET_SSR);
 
@@ -1168,18 +2197,55 @@ r3d_target_t pass_prepare_ssr(void)
 
 void pass_deferred_ambient(r3d_target_t ssaoSource, r3d_target_t ssilSource, r3d_target_t ssrSource)
 {
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_GREATER);
-    glDepthMask(GL_FALSE);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_GREATER);
+    r3d_state_depth_mask(false);
 
     // Set additive blending to accumulate light contributions
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
-    glBlendEquation(GL_FUNC_ADD);
+    r3d_state_enable(GL_BLEND);
+    r3d_state_blend_func(GL_ONE, GL_ONE);
+    r3d_state_blend_equation(GL_FUNC_ADD);
+
+    /* --- Calculate skybox IBL contribution, with the reflection probes if any is visible --- */
 
-    /* --- Calculate skybox IBL contribution --- */
+    if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0 && r3d_probe_has_visible())
+    {
+        R3D_TARGET_BIND(R3D_TARGET_LIGHTING);
+        R3D_SHADER_USE(deferred.ambientProbes);
+
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexAlbedo, r3d_target_get(R3D_TARGET_ALBEDO));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexSSAO, R3D_TEXTURE_SELECT(r3d_target_get(ssaoSource), WHITE));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexSSIL, R3D_TEXTURE_SELECT(r3d_target_get(ssilSource), BLACK));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexSSR, R3D_TEXTURE_SELECT(r3d_target_get(ssrSource), BLANK));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexORM, r3d_target_get(R3D_TARGET_ORM));
+        R3D_SHADER_BIND_SAMPLER_CUBE(deferred.ambientProbes, uCubePrefilter, R3D_CACHE_GET(environment.background.sky.prefilter.id));
+        R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientProbes, uTexBrdfLut, r3d_texture_get(R3D_TEXTURE_IBL_BRDF_LUT));
+        R3D_SHADER_BIND_SAMPLER_CUBE_ARRAY(deferred.ambientProbes, uCubeProbes, R3D_MOD_PROBE.arrayTex);
+
+        R3D_SHADER_SET_VEC4(deferred.ambientProbes, uQuatSkybox, R3D_CACHE_GET(environment.background.rotation));
+        R3D_SHADER_SET_FLOAT(deferred.ambientProbes, uAmbientEnergy, R3D_CACHE_GET(environment.ambient.energy));
+        R3D_SHADER_SET_FLOAT(deferred.ambientProbes, uReflectEnergy, R3D_CACHE_GET(environment.ambient.reflect));
+        R3D_SHADER_SET_FLOAT(deferred.ambientProbes, uMipCountSSR, (float)(r3d_target_get_mip_count() - 1));
+
+        R3D_PRIMITIVE_DRAW_SCREEN();
+
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexAlbedo);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexNormal);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexDepth);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexSSAO);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexSSIL);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexSSR);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexORM);
+        R3D_SHADER_UNBIND_SAMPLER_CUBE(deferred.ambientProbes, uCubePrefilter);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientProbes, uTexBrdfLut);
+        R3D_SHADER_UNBIND_SAMPLER_CUBE_ARRAY(deferred.ambientProbes, uCubeProbes);
+    }
+
+    /* --- Otherwise, calculate skybox IBL contribution --- */
 
-    if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0)
+    else if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0)
     {
         R3D_TARGET_BIND(R3D_TARGET_LIGHTING);
         R3D_SHADER_USE(deferred.ambientIbl);
@@ -1191,7 +2257,6 @@ void pass_deferred_ambient(r3d_target_t ssaoSource, r3d_target_t ssilSource, r3d
         R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientIbl, uTexSSIL, R3D_TEXTURE_SELECT(r3d_target_get(ssilSource), BLACK));
         R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientIbl, uTexSSR, R3D_TEXTURE_SELECT(r3d_target_get(ssrSource), BLANK));
         R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientIbl, uTexORM, r3d_target_get(R3D_TARGET_ORM));
-        R3D_SHADER_BIND_SAMPLER_CUBE(deferred.ambientIbl, uCubeIrradiance, R3D_CACHE_GET(environment.background.sky.irradiance.id));
         R3D_SHADER_BIND_SAMPLER_CUBE(deferred.ambientIbl, uCubePrefilter, R3D_CACHE_GET(environment.background.sky.prefilter.id));
         R3D_SHADER_BIND_SAMPLER_2D(deferred.ambientIbl, uTexBrdfLut, r3d_texture_get(R3D_TEXTURE_IBL_BRDF_LUT));
 
@@ -1209,7 +2274,6 @@ void pass_deferred_ambient(r3d_target_t ssaoSource, r3d_target_t ssilSource, r3d
         R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientIbl, uTexSSIL);
         R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientIbl, uTexSSR);
         R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientIbl, uTexORM);
-        R3D_SHADER_UNBIND_SAMPLER_CUBE(deferred.ambientIbl, uCubeIrradiance);
         R3D_SHADER_UNBIND_SAMPLER_CUBE(deferred.ambientIbl, uCubePrefilter);
         R3D_SHADER_UNBIND_SAMPLER_2D(deferred.ambientIbl, uTexBrdfLut);
     }
@@ -1241,120 +2305,244 @@ void pass_deferred_ambient(r3d_target_t ssaoSource, r3d_target_t ssilSource, r3d
     }
 }
 
+static r3d_primitive_t get_light_volume(const r3d_light_t* light, Matrix* matModel, Vector3* center, float* radius)
+{
+    if (light->type == R3D_LIGHT_SPOT && light->outerCutOff >= R3D_DEFERRED_VOLUME_MIN_CONE_COS)
+    {
+        float base = light->range * sqrtf(1.0f - light->outerCutOff * light->outerCutOff) / light->outerCutOff;
+
+        Vector3 dir = light->direction;
+        Vector3 ref = (fabsf(dir.y) < 0.99f) ? (Vector3) {0, 1, 0} : (Vector3) {1, 0, 0};
+        Vector3 right = Vector3Normalize(Vector3CrossProduct(ref, dir));
+        Vector3 up = Vector3CrossProduct(dir, right);
+
+        *matModel = (Matrix) {
+            right.x * base, up.x * base, dir.x * light->range, light->position.x,
+            right.y * base, up.y * base, dir.y * light->range, light->position.y,
+            right.z * base, up.z * base, dir.z * light->range, light->position.z,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        // Bounding sphere of the apex and the base, with a margin for the enclosing cone
+        *center = Vector3Add(light->position, Vector3Scale(dir, 0.5f * light->range));
+        *radius = 1.1f * sqrtf(0.25f * light->range * light->range + base * base);
+
+        return R3D_PRIMITIVE_CONE;
+    }
+
+    *matModel = (Matrix) {
+        light->range, 0.0f, 0.0f, light->position.x,
+        0.0f, light->range, 0.0f, light->position.y,
+        0.0f, 0.0f, light->range, light->position.z,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+
+    // Margin for the enclosing sphere
+    *center = light->position;
+    *radius = 1.1f * light->range;
+
+    return R3D_PRIMITIVE_SPHERE;
+}
+
 void pass_deferred_lights(r3d_target_t ssaoSource)
 {
     /* --- Setup OpenGL pipeline --- */
 
     R3D_TARGET_BIND(R3D_TARGET_LIGHTING);
 
-    glEnable(GL_SCISSOR_TEST);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_GREATER);
-    glDepthMask(GL_FALSE);
+    r3d_state_enable(GL_SCISSOR_TEST);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_GREATER);
+    r3d_state_depth_mask(false);
 
     // Set additive blending to accumulate light contributions
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
-    glBlendEquation(GL_FUNC_ADD);
+    r3d_state_enable(GL_BLEND);
+    r3d_state_blend_func(GL_ONE, GL_ONE);
+    r3d_state_blend_equation(GL_FUNC_ADD);
 
-    /* --- Enable shader and setup constant stuff --- */
+    /* --- Shade the lights without shadows in a single pass when there are enough of them --- */
 
-    R3D_SHADER_USE(deferred.lighting);
+    int clusteredCount = R3D_MOD_LIGHT.blockLightCount - R3D_MOD_LIGHT.blockShadowCount;
+    bool clustered = (clusteredCount >= R3D_DEFERRED_CLUSTER_MIN_LIGHTS);
 
-    R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uTexAlbedo, r3d_target_get(R3D_TARGET_ALBEDO));
-    R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
-    R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
-    R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uTexSSAO, R3D_TEXTURE_SELECT(r3d_target_get(ssaoSource), WHITE));
-    R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uTexORM, r3d_target_get(R3D_TARGET_ORM));
+    if (clustered) {
+        pass_deferred_lights_clustered(ssaoSource);
+    }
 
-    R3D_SHADER_SET_FLOAT(deferred.lighting, uSSAOLightAffect, R3D_CACHE_GET(environment.ssao.lightAffect));
+    /* --- Get the distance from the camera to the corners of the near plane --- */
 
-    /* --- Calculate lighting contributions --- */
+    // NOTE: Light volumes closer than this could be clipped by the near plane,
+    //       their back faces are then drawn instead, which are only clipped by the far
+    //       plane and are kept with the depth clamp. Orthographic views always use back faces.
 
-    R3D_LIGHT_FOR_EACH_VISIBLE(light)
+    const Matrix* proj = &R3D_CACHE_GET(viewState.proj);
+    bool ortho = (proj->m15 != 0.0f);
+
+    float tanX = 1.0f / proj->m0, tanY = 1.0f / proj->m5;
+    float nearMargin = R3D_CACHE_GET(viewState.near) * sqrtf(1.0f + tanX * tanX + tanY * tanY);
+
+    r3d_state_enable(GL_DEPTH_CLAMP);
+
+    /* --- Calculate lighting contributions, grouped by program variant --- */
+
+    // Each variant is specialized for a light type, with or without shadows,
+    // the lights are accumulated in any order so they are visited once per variant
+    int lastVariant = -1;
+
+    for (int variant = 0; variant < R3D_SHADER_LIGHTING_VARIANTS; variant++)
     {
-        r3d_rect_t dst = {0, 0, R3D_TARGET_WIDTH, R3D_TARGET_HEIGHT};
-        if (light->type != R3D_LIGHT_DIR) {
-            dst = r3d_light_get_screen_rect(light, &R3D_CACHE_GET(viewState.viewProj), dst.w, dst.h);
-        }
+        int iBlock = 0;
 
-        glScissor(dst.x, dst.y, dst.w, dst.h);
+        R3D_LIGHT_FOR_EACH_VISIBLE(light)
+        {
+            // Lights without shadows in the light block are shaded from the clusters
+            int index = iBlock++;
+            if (clustered && index >= R3D_MOD_LIGHT.blockShadowCount && index < R3D_MOD_LIGHT.blockLightCount) {
+                continue;
+            }
 
-        // Sending data common to each type of light
-        R3D_SHADER_SET_VEC3(deferred.lighting, uLight.color, light->color);
-        R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.specular, light->specular);
-        R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.energy, light->energy);
-        R3D_SHADER_SET_INT(deferred.lighting, uLight.type, light->type);
+            // The shadows of the lights in the light block are in the shadow block, at the same index
+            bool shadow = (index < R3D_MOD_LIGHT.blockShadowCount);
+            if (R3D_SHADER_LIGHTING_VARIANT(light->type, shadow) != variant) {
+                continue;
+            }
 
-        // Sending specific data according to the type of light
-        if (light->type == R3D_LIGHT_DIR) {
-            R3D_SHADER_SET_VEC3(deferred.lighting, uLight.direction, light->direction);
-        }
-        else if (light->type == R3D_LIGHT_SPOT) {
-            R3D_SHADER_SET_VEC3(deferred.lighting, uLight.position, light->position);
-            R3D_SHADER_SET_VEC3(deferred.lighting, uLight.direction, light->direction);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.range, light->range);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.attenuation, light->attenuation);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.innerCutOff, light->innerCutOff);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.outerCutOff, light->outerCutOff);
-        }
-        else if (light->type == R3D_LIGHT_OMNI) {
-            R3D_SHADER_SET_VEC3(deferred.lighting, uLight.position, light->position);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.range, light->range);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.attenuation, light->attenuation);
-        }
+            // Enable the variant and setup constant stuff
+            if (lastVariant != variant) {
+                lastVariant = variant;
+
+                R3D_SHADER_USE(deferred.lighting[variant]);
+
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexAlbedo, r3d_target_get(R3D_TARGET_ALBEDO));
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexSSAO, R3D_TEXTURE_SELECT(r3d_target_get(ssaoSource), WHITE));
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexORM, r3d_target_get(R3D_TARGET_ORM));
+                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting[variant], uTexShadowAtlas, R3D_MOD_LIGHT.shadowAtlasTex);
+
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uSSAOLightAffect, R3D_CACHE_GET(environment.ssao.lightAffect));
+            }
+
+            r3d_rect_t dst = {0, 0, R3D_TARGET_WIDTH, R3D_TARGET_HEIGHT};
+            if (light->type != R3D_LIGHT_DIR) {
+                dst = r3d_light_get_screen_rect(light, &R3D_CACHE_GET(viewState.viewProj), dst.w, dst.h);
+            }
+
+            glScissor(dst.x, dst.y, dst.w, dst.h);
+
+            // Sending data common to each type of light
+            R3D_SHADER_SET_VEC3(deferred.lighting[variant], uLight.color, light->color);
+            R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.specular, light->specular);
+            R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.energy, light->energy * light->fade);
+
+            // Sending specific data according to the type of light
+            if (light->type == R3D_LIGHT_DIR) {
+                R3D_SHADER_SET_VEC3(deferred.lighting[variant], uLight.direction, light->direction);
+            }
+            else if (light->type == R3D_LIGHT_SPOT) {
+                R3D_SHADER_SET_VEC3(deferred.lighting[variant], uLight.position, light->position);
+                R3D_SHADER_SET_VEC3(deferred.lighting[variant], uLight.direction, light->direction);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.range, light->range);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.attenuation, light->attenuation);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.innerCutOff, light->innerCutOff);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.outerCutOff, light->outerCutOff);
+            }
+            else if (light->type == R3D_LIGHT_OMNI) {
+                R3D_SHADER_SET_VEC3(deferred.lighting[variant], uLight.position, light->position);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.range, light->range);
+                R3D_SHADER_SET_FLOAT(deferred.lighting[variant], uLight.attenuation, light->attenuation);
+            }
 
-        // Sending shadow map data
-        if (light->shadow) {
-            if (light->type == R3D_LIGHT_OMNI) {
-                R3D_SHADER_BIND_SAMPLER_CUBE(deferred.lighting, uLight.shadowCubemap, light->shadowMap.tex);
+            if (shadow) {
+                R3D_SHADER_SET_INT(deferred.lighting[variant], uLight.shadowIndex, index);
+            }
+
+            // Accumulate this light!
+            if (light->type == R3D_LIGHT_DIR) {
+                R3D_SHADER_SET_INT(deferred.lighting[variant], uVolume, false);
+                r3d_state_disable(GL_CULL_FACE);
+                r3d_state_depth_func(GL_GREATER);
+                R3D_PRIMITIVE_DRAW_SCREEN();
             }
             else {
-                R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.shadowTexelSize, light->shadowTexelSize);
-                R3D_SHADER_BIND_SAMPLER_2D(deferred.lighting, uLight.shadowMap, light->shadowMap.tex);
-                R3D_SHADER_SET_MAT4(deferred.lighting, uLight.matVP, light->matVP);
-                if (light->type == R3D_LIGHT_DIR) {
-                    R3D_SHADER_SET_VEC3(deferred.lighting, uLight.position, light->position);
-                }
+                Matrix matModel;
+                Vector3 center;
+                float radius;
+
+                r3d_primitive_t volume = get_light_volume(light, &matModel, &center, &radius);
+                bool inside = ortho || Vector3Distance(R3D_CACHE_GET(viewState.viewPosition), center) < radius + nearMargin;
+
+                R3D_SHADER_SET_INT(deferred.lighting[variant], uVolume, true);
+                R3D_SHADER_SET_MAT4(deferred.lighting[variant], uMatModel, matModel);
+
+                // From the outside, shade the geometry behind the front faces,
+                // from the inside, shade the geometry in front of the back faces
+                r3d_state_enable(GL_CULL_FACE);
+                r3d_state_cull_face(inside ? GL_FRONT : GL_BACK);
+                r3d_state_depth_func(inside ? GL_GEQUAL : GL_LEQUAL);
+
+                r3d_primitive_draw(volume);
             }
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.shadowSoftness, light->shadowSoftness);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.shadowDepthBias, light->shadowDepthBias);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.shadowSlopeBias, light->shadowSlopeBias);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.near, light->near);
-            R3D_SHADER_SET_FLOAT(deferred.lighting, uLight.far, light->far);
-            R3D_SHADER_SET_INT(deferred.lighting, uLight.shadow, true);
-        }
-        else {
-            R3D_SHADER_SET_INT(deferred.lighting, uLight.shadow, false);
         }
-
-        // Accumulate this light!
-        R3D_PRIMITIVE_DRAW_SCREEN();
     }
 
     /* --- Unbind all textures --- */
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting, uTexAlbedo);
-    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting, uTexNormal);
-    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting, uTexDepth);
-    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting, uTexORM);
-
-    R3D_SHADER_UNBIND_SAMPLER_CUBE(deferred.lighting, uLight.shadowCubemap);
-    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting, uLight.shadowMap);
+    if (lastVariant >= 0) {
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting[lastVariant], uTexAlbedo);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting[lastVariant], uTexNormal);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting[lastVariant], uTexDepth);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting[lastVariant], uTexORM);
+        R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lighting[lastVariant], uTexShadowAtlas);
+    }
 
     /* --- Reset undesired state --- */
 
-    glDisable(GL_SCISSOR_TEST);
+    r3d_state_disable(GL_SCISSOR_TEST);
+    r3d_state_disable(GL_DEPTH_CLAMP);
+    r3d_state_disable(GL_CULL_FACE);
+}
+
+void pass_deferred_lights_clustered(r3d_target_t ssaoSource)
+{
+    glScissor(0, 0, R3D_TARGET_WIDTH, R3D_TARGET_HEIGHT);
+
+    R3D_SHADER_USE(deferred.lightingClustered);
+
+    R3D_SHADER_BIND_SAMPLER_2D(deferred.lightingClustered, uTexAlbedo, r3d_target_get(R3D_TARGET_ALBEDO));
+    R3D_SHADER_BIND_SAMPLER_2D(deferred.lightingClustered, uTexNormal, r3d_target_get(R3D_TARGET_NORMAL));
+    R3D_SHADER_BIND_SAMPLER_2D(deferred.lightingClustered, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_BIND_SAMPLER_2D(deferred.lightingClustered, uTexSSAO, R3D_TEXTURE_SELECT(r3d_target_get(ssaoSource), WHITE));
+    R3D_SHADER_BIND_SAMPLER_2D(deferred.lightingClustered, uTexORM, r3d_target_get(R3D_TARGET_ORM));
+    R3D_SHADER_BIND_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightClusters, R3D_MOD_LIGHT.clusterRangeTexture);
+    R3D_SHADER_BIND_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightIndices, R3D_MOD_LIGHT.clusterIndexTexture);
+
+    R3D_SHADER_SET_VEC2(deferred.lightingClustered, uClusterTileScale, (Vector2) {
+        (float)R3D_SHADER_FORWARD_CLUSTER_X / R3D_TARGET_WIDTH,
+        (float)R3D_SHADER_FORWARD_CLUSTER_Y / R3D_TARGET_HEIGHT
+    });
+    R3D_SHADER_SET_VEC2(deferred.lightingClustered, uClusterSlice, R3D_MOD_LIGHT.clusterSlice);
+    R3D_SHADER_SET_FLOAT(deferred.lightingClustered, uSSAOLightAffect, R3D_CACHE_GET(environment.ssao.lightAffect));
+
+    R3D_PRIMITIVE_DRAW_SCREEN();
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lightingClustered, uTexAlbedo);
+    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lightingClustered, uTexNormal);
+    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lightingClustered, uTexDepth);
+    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lightingClustered, uTexSSAO);
+    R3D_SHADER_UNBIND_SAMPLER_2D(deferred.lightingClustered, uTexORM);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightClusters);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(deferred.lightingClustered, uTexLightIndices);
 }
 
 void pass_deferred_compose(r3d_target_t sceneTarget)
 {
     R3D_TARGET_BIND(sceneTarget, R3D_TARGET_DEPTH);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_GREATER);
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_GREATER);
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
 
     R3D_SHADER_USE(deferred.compose);
 
@@ -1372,9 +2560,9 @@ void pass_scene_prepass(void)
     R3D_TARGET_BIND(R3D_TARGET_DEPTH);
     R3D_SHADER_USE(scene.depth);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_TRUE);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(true);
 
     const r3d_frustum_t* frustum = NULL;
     if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
@@ -1382,78 +2570,32 @@ void pass_scene_prepass(void)
     }
 
     R3D_DRAW_FOR_EACH(call, true, frustum, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS) {
-        raster_depth(call, false, &R3D_CACHE_GET(viewState.viewProj));
+        raster_depth_queue(call, false, &R3D_CACHE_GET(viewState.viewProj));
     }
+    raster_depth_flush(false, &R3D_CACHE_GET(viewState.viewProj));
 
     // NOTE: The storage texture of the matrices may have been bind during drawcalls
-    R3D_SHADER_UNBIND_SAMPLER_1D(scene.forward, uTexBoneMatrices);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.forward, uTexBoneMatrices);
 }
 
 static void pass_scene_forward_send_lights(const r3d_draw_call_t* call)
 {
-    int iLight = 0;
+    /* --- The other lights are read from the clusters, only send the shadowed lights affecting the draw --- */
 
-    R3D_LIGHT_FOR_EACH_VISIBLE(light)
-    {
-        // Check if the geometry "touches" the light area
-        // It's not the most accurate possible but hey
-        if (light->type != R3D_LIGHT_DIR) {
-            if (!CheckCollisionBoxes(light->aabb, call->mesh.aabb)) {
-                continue;
-            }
-        }
-
-        R3D_SHADER_SET_INT(scene.forward, uLights[iLight].enabled, true);
-        R3D_SHADER_SET_INT(scene.forward, uLights[iLight].type, light->type);
-        R3D_SHADER_SET_VEC3(scene.forward, uLights[iLight].color, light->color);
-        R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].specular, light->specular);
-        R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].energy, light->energy);
-
-        if (light->type == R3D_LIGHT_DIR) {
-            R3D_SHADER_SET_VEC3(scene.forward, uLights[iLight].direction, light->direction);
-        }
-        else if (light->type == R3D_LIGHT_SPOT) {
-            R3D_SHADER_SET_VEC3(scene.forward, uLights[iLight].position, light->position);
-            R3D_SHADER_SET_VEC3(scene.forward, uLights[iLight].direction, light->direction);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].range, light->range);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].attenuation, light->attenuation);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].innerCutOff, light->innerCutOff);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].outerCutOff, light->outerCutOff);
-        }
-        else if (light->type == R3D_LIGHT_OMNI) {
-            R3D_SHADER_SET_VEC3(scene.forward, uLights[iLight].position, light->position);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].range, light->range);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].attenuation, light->attenuation);
-        }
+    Vector3 center, extent;
+    r3d_draw_get_call_world_box(call, &center, &extent);
 
-        if (light->shadow) {
-            if (light->type == R3D_LIGHT_OMNI) {
-                R3D_SHADER_BIND_SAMPLER_CUBE(scene.forward, uShadowMapCube[iLight], light->shadowMap.tex);
-            }
-            else {
-                R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].shadowTexelSize, light->shadowTexelSize);
-                R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uShadowMap2D[iLight], light->shadowMap.tex);
-                R3D_SHADER_SET_MAT4(scene.forward, uMatLightVP[iLight], light->matVP);
-            }
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].shadowSoftness, light->shadowSoftness);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].shadowDepthBias, light->shadowDepthBias);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].shadowSlopeBias, light->shadowSlopeBias);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].near, light->near);
-            R3D_SHADER_SET_FLOAT(scene.forward, uLights[iLight].far, light->far);
-            R3D_SHADER_SET_INT(scene.forward, uLights[iLight].shadow, true);
-        }
-        else {
-            R3D_SHADER_SET_INT(scene.forward, uLights[iLight].shadow, false);
-        }
+    uint32_t mask = r3d_light_get_shadow_mask(center, extent);
 
-        if (++iLight == R3D_SHADER_FORWARD_NUM_LIGHTS) {
-            break;
+    int iLight = 0;
+    for (int index = 0; mask != 0; index++, mask >>= 1) {
+        if (mask & 1u) {
+            R3D_SHADER_SET_INT(scene.forward, uShadowIndices[iLight], index);
+            iLight++;
         }
     }
 
-    for (int i = iLight; i < R3D_SHADER_FORWARD_NUM_LIGHTS; i++) {
-        R3D_SHADER_SET_INT(scene.forward, uLights[i].enabled, false);
-    }
+    R3D_SHADER_SET_INT(scene.forward, uShadowCount, iLight);
 }
 
 void pass_scene_forward(r3d_target_t sceneTarget)
@@ -1461,13 +2603,12 @@ void pass_scene_forward(r3d_target_t sceneTarget)
     R3D_TARGET_BIND(sceneTarget, R3D_TARGET_DEPTH);
     R3D_SHADER_USE(scene.forward);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
-    glEnable(GL_BLEND);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(false);
+    r3d_state_enable(GL_BLEND);
 
     if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0) {
-        R3D_SHADER_BIND_SAMPLER_CUBE(scene.forward, uCubeIrradiance, R3D_CACHE_GET(environment.background.sky.irradiance.id));
         R3D_SHADER_BIND_SAMPLER_CUBE(scene.forward, uCubePrefilter, R3D_CACHE_GET(environment.background.sky.prefilter.id));
         R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexBrdfLut, r3d_texture_get(R3D_TEXTURE_IBL_BRDF_LUT));
 
@@ -1484,43 +2625,187 @@ void pass_scene_forward(r3d_target_t sceneTarget)
 
     R3D_SHADER_SET_VEC3(scene.forward, uViewPosition, R3D_CACHE_GET(viewState.viewPosition));
 
+    R3D_SHADER_BIND_SAMPLER_BUFFER(scene.forward, uTexLightClusters, R3D_MOD_LIGHT.clusterRangeTexture);
+    R3D_SHADER_BIND_SAMPLER_BUFFER(scene.forward, uTexLightIndices, R3D_MOD_LIGHT.clusterIndexTexture);
+    R3D_SHADER_BIND_SAMPLER_2D(scene.forward, uTexShadowAtlas, R3D_MOD_LIGHT.shadowAtlasTex);
+
+    R3D_SHADER_SET_VEC2(scene.forward, uClusterTileScale, (Vector2) {
+        (float)R3D_SHADER_FORWARD_CLUSTER_X / R3D_TARGET_WIDTH,
+        (float)R3D_SHADER_FORWARD_CLUSTER_Y / R3D_TARGET_HEIGHT
+    });
+    R3D_SHADER_SET_VEC2(scene.forward, uClusterSlice, R3D_MOD_LIGHT.clusterSlice);
+
     const r3d_frustum_t* frustum = NULL;
     if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
         frustum = &R3D_CACHE_GET(viewState.frustum);
     }
 
+    /* --- Draw the blended calls, leaving the alpha ones to the weighted accumulation if enabled --- */
+
+    bool weightedOIT = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_WEIGHTED_OIT);
+    bool hasWeighted = false;
+    bool hasReduced[3] = {0};
+
+    R3D_SHADER_SET_INT(scene.forward, uWeightedOIT, false);
+
     R3D_DRAW_FOR_EACH(call, true, frustum, R3D_DRAW_PREPASS_INST, R3D_DRAW_PREPASS, R3D_DRAW_FORWARD_INST, R3D_DRAW_FORWARD) {
+        R3D_RenderResolution resolution = R3D_CALL_RESOLUTION(call);
+        if (resolution != R3D_RESOLUTION_FULL) {
+            hasReduced[resolution] = true;
+            continue;
+        }
+        if (weightedOIT && R3D_IS_CALL_WEIGHTED_OIT(call)) {
+            hasWeighted = true;
+            continue;
+        }
         pass_scene_forward_send_lights(call);
-        raster_forward(call);
+        raster_forward(call, false);
+    }
+
+    /* --- Accumulate the alpha calls in any order, see 'pass_scene_forward_resolve()' --- */
+
+    if (hasWeighted) {
+        R3D_TARGET_CLEAR(R3D_TARGET_OIT_ACCUM, R3D_TARGET_OIT_WEIGHT);
+        R3D_TARGET_BIND(R3D_TARGET_OIT_ACCUM, R3D_TARGET_OIT_WEIGHT, R3D_TARGET_DEPTH);
+
+        // Sum of the weighted colors in RGB, product of the transmittances in alpha
+        r3d_state_blend_func_separate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        R3D_SHADER_SET_INT(scene.forward, uWeightedOIT, true);
+
+        R3D_DRAW_FOR_EACH(call, R3D_IS_CALL_WEIGHTED_OIT(call), frustum, R3D_DRAW_FORWARD_INST, R3D_DRAW_FORWARD) {
+            pass_scene_forward_send_lights(call);
+            raster_forward(call, true);
+        }
+    }
+
+    /* --- Draw the reduced resolution calls into their targets, composed after the resolve --- */
+
+    for (int res = R3D_RESOLUTION_HALF; res <= R3D_RESOLUTION_QUARTER; res++) {
+        if (hasReduced[res]) pass_scene_forward_reduced(res, frustum);
     }
 
     if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0) {
-        R3D_SHADER_UNBIND_SAMPLER_CUBE(scene.forward, uCubeIrradiance);
         R3D_SHADER_UNBIND_SAMPLER_CUBE(scene.forward, uCubePrefilter);
         R3D_SHADER_UNBIND_SAMPLER_2D(scene.forward, uTexBrdfLut);
     }
 
-    for (int i = 0; i < R3D_SHADER_FORWARD_NUM_LIGHTS; i++) {
-        R3D_SHADER_UNBIND_SAMPLER_CUBE(scene.forward, uShadowMapCube[i]);
-        R3D_SHADER_UNBIND_SAMPLER_2D(scene.forward, uShadowMap2D[i]);
-    }
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.forward, uTexLightClusters);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.forward, uTexLightIndices);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.forward, uTexShadowAtlas);
 
     // NOTE: The storage texture of the matrices may have been bind during drawcalls
-    R3D_SHADER_UNBIND_SAMPLER_1D(scene.forward, uTexBoneMatrices);
+    R3D_SHADER_UNBIND_SAMPLER_BUFFER(scene.forward, uTexBoneMatrices);
+
+    if (hasWeighted) {
+        pass_scene_forward_resolve(sceneTarget);
+    }
+
+    for (int res = R3D_RESOLUTION_HALF; res <= R3D_RESOLUTION_QUARTER; res++) {
+        if (hasReduced[res]) pass_scene_forward_compose(sceneTarget, res);
+    }
+}
+
+void pass_scene_forward_resolve(r3d_target_t sceneTarget)
+{
+    R3D_TARGET_BIND(sceneTarget, R3D_TARGET_DEPTH);
+    R3D_SHADER_USE(scene.oitResolve);
+
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_depth_mask(false);
+    r3d_state_enable(GL_BLEND);
+
+    // Average color weighted by the coverage, over the scene attenuated by the remaining transmittance
+    r3d_state_blend_func(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.oitResolve, uTexAccum, r3d_target_get(R3D_TARGET_OIT_ACCUM));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.oitResolve, uTexWeight, r3d_target_get(R3D_TARGET_OIT_WEIGHT));
+
+    R3D_PRIMITIVE_DRAW_SCREEN();
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.oitResolve, uTexAccum);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.oitResolve, uTexWeight);
+}
+
+// NOTE: Called during the forward pass, its shader and samplers are still bound
+void pass_scene_forward_reduced(R3D_RenderResolution resolution, const r3d_frustum_t* frustum)
+{
+    int factor = REDUCED_TARGETS[resolution].factor;
+
+    /* --- Downsample the depth buffer, the color is cleared by the same draw --- */
+
+    R3D_TARGET_BIND(REDUCED_TARGETS[resolution].color, REDUCED_TARGETS[resolution].depth);
+    R3D_SHADER_USE(scene.depthDownsample);
+
+    r3d_state_disable(GL_BLEND);
+    r3d_state_disable(GL_CULL_FACE);
+    r3d_state_depth_func(GL_ALWAYS);
+    r3d_state_depth_mask(true);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.depthDownsample, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_SET_INT(scene.depthDownsample, uFactor, factor);
+
+    R3D_PRIMITIVE_DRAW_SCREEN();
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.depthDownsample, uTexDepth);
+
+    /* --- Draw the calls tested against the reduced depth --- */
+
+    R3D_SHADER_USE(scene.forward);
+
+    r3d_state_enable(GL_BLEND);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(false);
+
+    // The clusters are found from the fragment coordinates, which are in reduced texels here
+    R3D_SHADER_SET_VEC2(scene.forward, uClusterTileScale, (Vector2) {
+        (float)(R3D_SHADER_FORWARD_CLUSTER_X * factor) / R3D_TARGET_WIDTH,
+        (float)(R3D_SHADER_FORWARD_CLUSTER_Y * factor) / R3D_TARGET_HEIGHT
+    });
+
+    R3D_DRAW_FOR_EACH(call, R3D_CALL_RESOLUTION(call) == resolution, frustum, R3D_DRAW_FORWARD_INST, R3D_DRAW_FORWARD) {
+        pass_scene_forward_send_lights(call);
+        r3d_draw_apply_reduced_blend_mode(call->material->blendMode, call->material->transparencyMode);
+        raster_forward(call, true);
+    }
+}
+
+void pass_scene_forward_compose(r3d_target_t sceneTarget, R3D_RenderResolution resolution)
+{
+    // NOTE: The full resolution depth is sampled, so it is not attached
+    R3D_TARGET_BIND(sceneTarget);
+    R3D_SHADER_USE(scene.reducedCompose);
+
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_disable(GL_CULL_FACE);
+    r3d_state_depth_mask(false);
+    r3d_state_enable(GL_BLEND);
+
+    // Blended colors over the scene attenuated by the remaining transmittance
+    r3d_state_blend_func(GL_ONE, GL_SRC_ALPHA);
+
+    R3D_SHADER_BIND_SAMPLER_2D(scene.reducedCompose, uTexColor, r3d_target_get(REDUCED_TARGETS[resolution].color));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.reducedCompose, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_BIND_SAMPLER_2D(scene.reducedCompose, uTexReducedDepth, r3d_target_get(REDUCED_TARGETS[resolution].depth));
+
+    R3D_PRIMITIVE_DRAW_SCREEN();
+
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.reducedCompose, uTexColor);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.reducedCompose, uTexDepth);
+    R3D_SHADER_UNBIND_SAMPLER_2D(scene.reducedCompose, uTexReducedDepth);
 }
 
 void pass_scene_background(r3d_target_t sceneTarget)
 {
     R3D_TARGET_BIND(sceneTarget, R3D_TARGET_DEPTH);
 
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_enable(GL_DEPTH_TEST);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
 
     if (R3D_CACHE_GET(environment.background.sky.cubemap.id) != 0) {
         R3D_SHADER_USE(scene.skybox);
-        glDisable(GL_CULL_FACE);
+        r3d_state_disable(GL_CULL_FACE);
 
         R3D_SHADER_BIND_SAMPLER_CUBE(scene.skybox, uCubeSky, R3D_CACHE_GET(environment.background.sky.cubemap.id));
         R3D_SHADER_SET_FLOAT(scene.skybox, uSkyEnergy, R3D_CACHE_GET(environment.background.energy));
@@ -1547,9 +2832,9 @@ void pass_scene_background(r3d_target_t sceneTarget)
 
 r3d_target_t pass_post_setup(r3d_target_t sceneTarget)
 {
-    glDisable(GL_DEPTH_TEST);
-    glDepthMask(GL_FALSE);
-    glDisable(GL_BLEND);
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_depth_mask(false);
+    r3d_state_disable(GL_BLEND);
 
     return r3d_target_swap_scene(sceneTarget);
 }
@@ -1598,9 +2883,8 @@ r3d_target_t pass_post_dof(r3d_target_t sceneTarget)
     return sceneTarget;
 }
 
-r3d_target_t pass_post_bloom(r3d_target_t sceneTarget)
+int pass_prepare_bloom(r3d_target_t sceneSource)
 {
-    r3d_target_t sceneSource = r3d_target_swap_scene(sceneTarget);
     GLuint sceneSourceID = r3d_target_get(sceneSource);
     int mipCount = r3d_target_get_mip_count();
 
@@ -1630,21 +2914,58 @@ r3d_target_t pass_post_bloom(r3d_target_t sceneTarget)
     if (maxLevel > mipCount) maxLevel = mipCount;
     else if (maxLevel < 1) maxLevel = 1;
 
+    /* --- Bloom: Single dispatch downsampling, when compute shaders are supported --- */
+
+    int firstLevel = 0;
+
+    if (GLAD_GL_VERSION_4_3)
+    {
+        firstLevel = (maxLevel < R3D_BLOOM_COMPUTE_LEVELS) ? maxLevel : R3D_BLOOM_COMPUTE_LEVELS;
+
+        R3D_SHADER_USE(prepare.bloomDownCompute);
+
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.bloomDownCompute, uTexSource, sceneSourceID);
+        R3D_SHADER_SET_VEC4(prepare.bloomDownCompute, uPrefilter, prefilter);
+        R3D_SHADER_SET_INT(prepare.bloomDownCompute, uLevelCount, firstLevel);
+
+        // Every unit must hold a valid image, those beyond the levels written repeat the last one
+        for (int i = 0; i < R3D_BLOOM_COMPUTE_LEVELS; i++) {
+            int level = (i < firstLevel) ? i : firstLevel - 1;
+            r3d_target_bind_image(i, R3D_TARGET_BLOOM, level, GL_READ_WRITE);
+        }
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, r3d_target_get_mip_counter());
+
+        r3d_target_get_resolution(&srcW, &srcH, 0);
+        glDispatchCompute((srcW + 63) / 64, (srcH + 63) / 64, 1);
+
+        // The levels are then sampled, and blended into by the upsampling
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        R3D_SHADER_UNBIND_SAMPLER_2D(prepare.bloomDownCompute, uTexSource);
+    }
+
     /* --- Bloom: Karis average before downsampling --- */
 
     R3D_SHADER_USE(prepare.bloomDown);
 
-    r3d_target_get_texel_size(&txSrcW, &txSrcH, 0);
-    r3d_target_get_resolution(&srcW, &srcH, 0);
-    r3d_target_set_mip_level(0, 0);
+    if (firstLevel == 0)
+    {
+        r3d_target_get_texel_size(&txSrcW, &txSrcH, 0);
+        r3d_target_get_resolution(&srcW, &srcH, 0);
+        r3d_target_set_mip_level(0, 0);
 
-    R3D_SHADER_BIND_SAMPLER_2D(prepare.bloomDown, uTexture, sceneSourceID);
+        R3D_SHADER_BIND_SAMPLER_2D(prepare.bloomDown, uTexture, sceneSourceID);
 
-    R3D_SHADER_SET_VEC2(prepare.bloomDown, uTexelSize, (Vector2) {txSrcW, txSrcH});
-    R3D_SHADER_SET_VEC4(prepare.bloomDown, uPrefilter, prefilter);
-    R3D_SHADER_SET_INT(prepare.bloomDown, uDstLevel, 0);
+        R3D_SHADER_SET_VEC2(prepare.bloomDown, uTexelSize, (Vector2) {txSrcW, txSrcH});
+        R3D_SHADER_SET_VEC4(prepare.bloomDown, uPrefilter, prefilter);
+        R3D_SHADER_SET_INT(prepare.bloomDown, uDstLevel, 0);
 
-    R3D_PRIMITIVE_DRAW_SCREEN();
+        R3D_PRIMITIVE_DRAW_SCREEN();
+
+        firstLevel = 1;
+    }
 
     /* --- Bloom: Downsampling --- */
 
@@ -1652,7 +2973,7 @@ r3d_target_t pass_post_bloom(r3d_target_t sceneTarget)
     // Given that we'll be sampling a different level from where we're writing
     R3D_SHADER_BIND_SAMPLER_2D(prepare.bloomDown, uTexture, r3d_target_get(R3D_TARGET_BLOOM));
 
-    for (int dstLevel = 1; dstLevel < maxLevel; dstLevel++)
+    for (int dstLevel = firstLevel; dstLevel < maxLevel; dstLevel++)
     {
         r3d_target_get_texel_size(&txSrcW, &txSrcH, dstLevel - 1);
         r3d_target_get_resolution(&srcW, &srcH, dstLevel - 1);
@@ -1673,13 +2994,14 @@ r3d_target_t pass_post_bloom(r3d_target_t sceneTarget)
 
     R3D_SHADER_USE(prepare.bloomUp);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_ONE, GL_ONE);
-    glBlendEquation(GL_FUNC_ADD);
+    r3d_state_enable(GL_BLEND);
+    r3d_state_blend_func(GL_ONE, GL_ONE);
+    r3d_state_blend_equation(GL_FUNC_ADD);
 
     R3D_SHADER_BIND_SAMPLER_2D(prepare.bloomUp, uTexture, r3d_target_get(R3D_TARGET_BLOOM));
 
-    for (int dstLevel = maxLevel - 2; dstLevel >= 0; dstLevel--)
+    // The first level is upsampled into while composing the scene
+    for (int dstLevel = maxLevel - 2; dstLevel >= 1; dstLevel--)
     {
         r3d_target_get_texel_size(&txSrcW, &txSrcH, dstLevel + 1);
         r3d_target_get_resolution(&srcW, &srcH, dstLevel + 1);
@@ -1699,79 +3021,376 @@ r3d_target_t pass_post_bloom(r3d_target_t sceneTarget)
 
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.bloomUp, uTexture);
 
-    glDisable(GL_BLEND);
+    r3d_state_disable(GL_BLEND);
 
-    /* --- Apply bloom to the scene --- */
+    return maxLevel;
+}
 
-    R3D_TARGET_BIND_AND_SWAP_SCENE(sceneTarget);
-    R3D_SHADER_USE(post.bloom);
+r3d_target_t pass_post_output(r3d_target_t sceneTarget, bool fog, int bloomLevels)
+{
+    int variant = R3D_SHADER_OUTPUT_VARIANT(fog, bloomLevels > 0);
 
-    R3D_SHADER_BIND_SAMPLER_2D(post.bloom, uTexColor, sceneSourceID);
-    R3D_SHADER_BIND_SAMPLER_2D(post.bloom, uTexBloomBlur, r3d_target_get(R3D_TARGET_BLOOM));
+    R3D_TARGET_BIND_AND_SWAP_SCENE(sceneTarget);
+    R3D_SHADER_USE(post.output[variant]);
+
+    R3D_SHADER_BIND_SAMPLER_2D(post.output[variant], uTexColor, r3d_target_get(sceneTarget));
+
+    R3D_SHADER_SET_FLOAT(post.output[variant], uTonemapExposure, R3D_CACHE_GET(environment.tonemap.exposure));
+    R3D_SHADER_SET_FLOAT(post.output[variant], uTonemapWhite, R3D_CACHE_GET(environment.tonemap.white));
+    R3D_SHADER_SET_INT(post.output[variant], uTonemapMode, R3D_CACHE_GET(environment.tonemap.mode));
+    R3D_SHADER_SET_FLOAT(post.output[variant], uBrightness, R3D_CACHE_GET(environment.color.brightness));
+    R3D_SHADER_SET_FLOAT(post.output[variant], uContrast, R3D_CACHE_GET(environment.color.contrast));
+    R3D_SHADER_SET_FLOAT(post.output[variant], uSaturation, R3D_CACHE_GET(environment.color.saturation));
+
+    if (fog) {
+        R3D_SHADER_BIND_SAMPLER_2D(post.output[variant], uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+
+        R3D_SHADER_SET_INT(post.output[variant], uFogMode, R3D_CACHE_GET(environment.fog.mode));
+        R3D_SHADER_SET_COL3(post.output[variant], uFogColor, R3D_CACHE_GET(environment.fog.color));
+        R3D_SHADER_SET_FLOAT(post.output[variant], uFogStart, R3D_CACHE_GET(environment.fog.start));
+        R3D_SHADER_SET_FLOAT(post.output[variant], uFogEnd, R3D_CACHE_GET(environment.fog.end));
+        R3D_SHADER_SET_FLOAT(post.output[variant], uFogDensity, R3D_CACHE_GET(environment.fog.density));
+        R3D_SHADER_SET_FLOAT(post.output[variant], uSkyAffect, R3D_CACHE_GET(environment.fog.skyAffect));
+    }
+
+    if (bloomLevels > 0) {
+        R3D_SHADER_BIND_SAMPLER_2D(post.output[variant], uTexBloomBlur, r3d_target_get(R3D_TARGET_BLOOM));
+
+        // A negative radius skips the last upsampling, there is nothing to upsample with a single level
+        float txSrcW = 0, txSrcH = 0;
+        r3d_target_get_texel_size(&txSrcW, &txSrcH, 1);
+        float filterRadius = R3D_CACHE_GET(environment.bloom.filterRadius);
+        R3D_SHADER_SET_VEC2(post.output[variant], uFilterRadius, (bloomLevels > 1)
+            ? (Vector2) {filterRadius * txSrcW, filterRadius * txSrcH}
+            : (Vector2) {-1.0f, -1.0f}
+        );
 
-    R3D_SHADER_SET_INT(post.bloom, uBloomMode, R3D_CACHE_GET(environment.bloom.mode));
-    R3D_SHADER_SET_FLOAT(post.bloom, uBloomIntensity, R3D_CACHE_GET(environment.bloom.intensity));
+        R3D_SHADER_SET_INT(post.output[variant], uBloomMode, R3D_CACHE_GET(environment.bloom.mode));
+        R3D_SHADER_SET_FLOAT(post.output[variant], uBloomIntensity, R3D_CACHE_GET(environment.bloom.intensity));
+    }
 
     R3D_PRIMITIVE_DRAW_SCREEN();
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(post.bloom, uTexColor);
-    R3D_SHADER_UNBIND_SAMPLER_2D(post.bloom, uTexBloomBlur);
+    R3D_SHADER_UNBIND_SAMPLER_2D(post.output[variant], uTexColor);
+    if (fog) R3D_SHADER_UNBIND_SAMPLER_2D(post.output[variant], uTexDepth);
+    if (bloomLevels > 0) R3D_SHADER_UNBIND_SAMPLER_2D(post.output[variant], uTexBloomBlur);
 
     return sceneTarget;
 }
 
-r3d_target_t pass_post_output(r3d_target_t sceneTarget)
+r3d_target_t pass_post_fxaa(r3d_target_t sceneTarget)
 {
     R3D_TARGET_BIND_AND_SWAP_SCENE(sceneTarget);
-    R3D_SHADER_USE(post.output);
-
-    R3D_SHADER_BIND_SAMPLER_2D(post.output, uTexColor, r3d_target_get(sceneTarget));
+    R3D_SHADER_USE(post.fxaa);
 
-    R3D_SHADER_SET_FLOAT(post.output, uTonemapExposure, R3D_CACHE_GET(environment.tonemap.exposure));
-    R3D_SHADER_SET_FLOAT(post.output, uTonemapWhite, R3D_CACHE_GET(environment.tonemap.white));
-    R3D_SHADER_SET_INT(post.output, uTonemapMode, R3D_CACHE_GET(environment.tonemap.mode));
-    R3D_SHADER_SET_FLOAT(post.output, uBrightness, R3D_CACHE_GET(environment.color.brightness));
-    R3D_SHADER_SET_FLOAT(post.output, uContrast, R3D_CACHE_GET(environment.color.contrast));
-    R3D_SHADER_SET_FLOAT(post.output, uSaturation, R3D_CACHE_GET(environment.color.saturation));
+    R3D_SHADER_BIND_SAMPLER_2D(post.fxaa, uTexture, r3d_target_get(sceneTarget));
 
+    R3D_SHADER_SET_VEC2(post.fxaa, uTexelSize, (Vector2) {R3D_TARGET_TEXEL_SIZE});
     R3D_PRIMITIVE_DRAW_SCREEN();
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(post.output, uTexColor);
+    R3D_SHADER_UNBIND_SAMPLER_2D(post.fxaa, uTexture);
 
     return sceneTarget;
 }
 
-r3d_target_t pass_post_fxaa(r3d_target_t sceneTarget)
+r3d_target_t pass_post_taa(r3d_target_t sceneSource, Vector2 jitter)
 {
-    R3D_TARGET_BIND_AND_SWAP_SCENE(sceneTarget);
-    R3D_SHADER_USE(post.fxaa);
+    // The history targets alternate each frame, one is read while the other is written
+    uint32_t frame = R3D_CACHE_GET(temporal.frameIndex);
+    r3d_target_t historyTarget = R3D_TARGET_TAA_HISTORY_0 + (frame & 1);
+    r3d_target_t prevHistoryTarget = R3D_TARGET_TAA_HISTORY_0 + ((frame + 1) & 1);
+    bool hasHistory = R3D_CACHE_GET(temporal.taaHistory);
 
-    R3D_SHADER_BIND_SAMPLER_2D(post.fxaa, uTexture, r3d_target_get(sceneTarget));
+    // The rendered area is reconstructed over the whole targets, the view block keeps the scale of the current samples
+    R3D_TARGET_BIND(historyTarget);
+    glViewport(0, 0, R3D_TARGET_ALLOC_WIDTH, R3D_TARGET_ALLOC_HEIGHT);
+
+    R3D_SHADER_USE(post.taa);
+
+    R3D_SHADER_SET_MAT4(post.taa, uMatPrevViewProj, R3D_CACHE_GET(temporal.prevViewProj));
+    R3D_SHADER_SET_VEC2(post.taa, uJitter, jitter);
+    R3D_SHADER_SET_FLOAT(post.taa, uHistoryWeight, hasHistory ? 1.0f : 0.0f);
+
+    R3D_SHADER_BIND_SAMPLER_2D(post.taa, uTexColor, r3d_target_get(sceneSource));
+    R3D_SHADER_BIND_SAMPLER_2D(post.taa, uTexDepth, r3d_target_get(R3D_TARGET_DEPTH));
+    R3D_SHADER_BIND_SAMPLER_2D(post.taa, uTexHistory, hasHistory ? r3d_target_get(prevHistoryTarget) : r3d_texture_get(R3D_TEXTURE_BLACK));
 
-    R3D_SHADER_SET_VEC2(post.fxaa, uTexelSize, (Vector2) {R3D_TARGET_TEXEL_SIZE});
     R3D_PRIMITIVE_DRAW_SCREEN();
 
-    R3D_SHADER_UNBIND_SAMPLER_2D(post.fxaa, uTexture);
+    R3D_SHADER_UNBIND_SAMPLER_2D(post.taa, uTexColor);
+    R3D_SHADER_UNBIND_SAMPLER_2D(post.taa, uTexDepth);
+    R3D_SHADER_UNBIND_SAMPLER_2D(post.taa, uTexHistory);
 
-    return sceneTarget;
+    return historyTarget;
+}
+
+/*
+ * Makes a view of the multi-view or stereo frame current, see `R3D_BeginMultiView()` and `R3D_BeginStereo()`.
+ */
+void select_view(int index)
+{
+    const r3d_draw_view_t* view = &R3D_MOD_DRAW.views.list[index];
+
+    r3d_target_set_blit_screen(&view->target);
+    r3d_cache_set_view_state(view->view, view->proj, view->aspect, view->near, view->far);
+}
+
+/*
+ * Culls the groups against the given frustum and sorts all draw calls from the given position.
+ */
+void cull_and_sort_view(const r3d_frustum_t* frustum, Vector3 viewPosition, bool occlusionCulling)
+{
+    double cullStart = GetTime();
+
+    if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING)) {
+        r3d_draw_compute_visible_groups(frustum);
+    }
+
+    if (occlusionCulling) {
+        r3d_occlusion_update();
+        r3d_draw_cull_occluded_groups();
+    }
+
+    r3d_draw_record_animation_lods(!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_NO_FRUSTUM_CULLING));
+
+    R3D_PROFILE_COUNT(cullingTime, r3d_profile_elapsed_ms(cullStart));
+
+    double sortStart = GetTime();
+
+    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_OPAQUE_SORTING)) {
+        r3d_draw_sort_list(R3D_DRAW_DEFERRED, viewPosition, R3D_DRAW_SORT_FRONT_TO_BACK);
+    }
+    else {
+        r3d_draw_sort_list(R3D_DRAW_DEFERRED, viewPosition, R3D_DRAW_SORT_STATE);
+    }
+
+    r3d_draw_sort_list(R3D_DRAW_DEFERRED_INST, viewPosition, R3D_DRAW_SORT_STATE);
+
+    // The weighted transparency does not depend on the order, the calls are grouped by state instead
+    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_WEIGHTED_OIT)) {
+        r3d_draw_sort_list(R3D_DRAW_FORWARD, viewPosition, R3D_DRAW_SORT_STATE);
+    }
+
+    if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_TRANSPARENT_SORTING)) {
+        r3d_draw_sort_list(R3D_DRAW_PREPASS, viewPosition, R3D_DRAW_SORT_BACK_TO_FRONT);
+        if (!R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_WEIGHTED_OIT)) {
+            r3d_draw_sort_list(R3D_DRAW_FORWARD, viewPosition, R3D_DRAW_SORT_BACK_TO_FRONT);
+        }
+    }
+
+    R3D_PROFILE_COUNT(sortingTime, r3d_profile_elapsed_ms(sortStart));
+}
+
+/*
+ * Renders the culled and sorted draws from the current view into its target.
+ * The shadow maps of the frame must have been rendered first, they are shared by all views.
+ */
+void render_view(bool probeCapture, bool temporal, bool occlusionCulling, Vector2 taaJitter, bool* ssaoTemporal, bool* ssilTemporal)
+{
+    /* --- Upload and bind uniform buffers --- */
+
+    r3d_cache_bind_view_state(R3D_SHADER_UBO_VIEW_SLOT);
+    r3d_cache_bind_sky_state(R3D_SHADER_UBO_SKY_SLOT);
+    r3d_probe_bind_visible(R3D_SHADER_UBO_PROBE_SLOT, &R3D_CACHE_GET(viewState.frustum));
+
+    if (r3d_light_has_visible() || r3d_draw_has_forward() || r3d_draw_has_prepass()) {
+        r3d_light_bind_visible(R3D_SHADER_UBO_LIGHT_SLOT, R3D_SHADER_UBO_SHADOW_SLOT);
+        r3d_light_build_clusters(
+            &R3D_CACHE_GET(viewState.view), &R3D_CACHE_GET(viewState.viewProj),
+            R3D_CACHE_GET(viewState.near), R3D_CACHE_GET(viewState.far)
+        );
+    }
+
+    /* --- Opaque and decal rendering with deferred lighting and composition --- */
+
+    r3d_target_t sceneTarget = R3D_TARGET_SCENE_0;
+    bool taaEnabled = R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_TAA) && temporal;
+    bool ssrEnabled = R3D_CACHE_GET(environment.ssr.enabled) && !probeCapture;
+
+    if (r3d_draw_has_deferred()) {
+        R3D_TARGET_CLEAR(R3D_TARGET_ALL_DEFERRED);
+
+        r3d_profile_begin(R3D_PROFILE_GEOMETRY);
+        pass_scene_geometry();
+        r3d_profile_end(R3D_PROFILE_GEOMETRY);
+
+        // The depth pyramid is shared by the occlusion culling and the reflections
+        if (occlusionCulling || ssrEnabled) {
+            r3d_profile_begin(R3D_PROFILE_DEPTH_PYRAMID);
+            r3d_occlusion_build_pyramid();
+            r3d_profile_end(R3D_PROFILE_DEPTH_PYRAMID);
+        }
+        if (occlusionCulling) {
+            r3d_occlusion_start_readback(&R3D_CACHE_GET(viewState.viewProj));
+        }
+
+        if (r3d_draw_has_decal()) {
+            r3d_profile_begin(R3D_PROFILE_DECALS);
+            pass_scene_decals();
+            r3d_profile_end(R3D_PROFILE_DECALS);
+        }
+
+        r3d_target_t ssaoSource = R3D_TARGET_INVALID;
+        if (R3D_CACHE_GET(environment.ssao.enabled)) {
+            *ssaoTemporal = R3D_CACHE_GET(environment.ssao.temporal) && temporal;
+            r3d_profile_begin(R3D_PROFILE_SSAO);
+            ssaoSource = pass_prepare_ssao(*ssaoTemporal);
+            r3d_profile_end(R3D_PROFILE_SSAO);
+        }
+
+        if (r3d_light_has_visible()) {
+            r3d_profile_begin(R3D_PROFILE_LIGHTING);
+            pass_deferred_lights(ssaoSource);
+            r3d_profile_end(R3D_PROFILE_LIGHTING);
+        }
+
+        r3d_target_t ssilSource = R3D_TARGET_INVALID;
+        if (R3D_CACHE_GET(environment.ssil.enabled) && !probeCapture) {
+            *ssilTemporal = R3D_CACHE_GET(environment.ssil.temporal) && temporal;
+            r3d_profile_begin(R3D_PROFILE_SSIL);
+            ssilSource = pass_prepare_ssil(*ssilTemporal);
+            r3d_profile_end(R3D_PROFILE_SSIL);
+        }
+
+        r3d_target_t ssrSource = R3D_TARGET_INVALID;
+        if (ssrEnabled) {
+            r3d_profile_begin(R3D_PROFILE_SSR);
+            ssrSource = pass_prepare_ssr();
+            r3d_profile_end(R3D_PROFILE_SSR);
+        }
+
+        r3d_profile_begin(R3D_PROFILE_AMBIENT);
+        pass_deferred_ambient(ssaoSource, ssilSource, ssrSource);
+        pass_deferred_compose(sceneTarget);
+        r3d_profile_end(R3D_PROFILE_AMBIENT);
+    }
+    else {
+        R3D_TARGET_CLEAR(R3D_TARGET_DEPTH);
+        if (occlusionCulling) {
+            r3d_occlusion_reset();
+        }
+    }
+
+    /* --- Then background and transparent rendering --- */
+
+    r3d_profile_begin(R3D_PROFILE_BACKGROUND);
+    pass_scene_background(sceneTarget);
+    r3d_profile_end(R3D_PROFILE_BACKGROUND);
+
+    if (r3d_draw_has_forward() || r3d_draw_has_prepass()) {
+        r3d_profile_begin(R3D_PROFILE_FORWARD);
+        if (r3d_draw_has_prepass()) pass_scene_prepass();
+        pass_scene_forward(sceneTarget);
+        r3d_profile_end(R3D_PROFILE_FORWARD);
+    }
+
+    /* --- Applying effects over the scene and final blit --- */
+
+    sceneTarget = pass_post_setup(sceneTarget);
+
+    // The fog is fused into the output pass, unless the depth of field has to blur it first
+    bool fogEnabled = (R3D_CACHE_GET(environment.fog.mode) != R3D_FOG_DISABLED);
+    bool dofEnabled = (R3D_CACHE_GET(environment.dof.mode) != R3D_DOF_DISABLED);
+    bool fogFused = fogEnabled && !dofEnabled && !probeCapture;
+
+    if (fogEnabled && !fogFused) {
+        r3d_profile_begin(R3D_PROFILE_FOG);
+        sceneTarget = pass_post_fog(sceneTarget);
+        r3d_profile_end(R3D_PROFILE_FOG);
+    }
+
+    // Probe faces are stored in linear HDR, the camera effects are applied when they are reflected
+    if (probeCapture) {
+        r3d_probe_end_capture(r3d_target_swap_scene(sceneTarget));
+    }
+    else {
+        if (dofEnabled) {
+            r3d_profile_begin(R3D_PROFILE_DOF);
+            sceneTarget = pass_post_dof(sceneTarget);
+            r3d_profile_end(R3D_PROFILE_DOF);
+        }
+
+        int bloomLevels = 0;
+        if (R3D_CACHE_GET(environment.bloom.mode) != R3D_BLOOM_DISABLED) {
+            r3d_profile_begin(R3D_PROFILE_BLOOM);
+            bloomLevels = pass_prepare_bloom(r3d_target_swap_scene(sceneTarget));
+            r3d_profile_end(R3D_PROFILE_BLOOM);
+        }
+
+        r3d_profile_begin(R3D_PROFILE_OUTPUT);
+        sceneTarget = pass_post_output(sceneTarget, fogFused, bloomLevels);
+        r3d_profile_end(R3D_PROFILE_OUTPUT);
+
+        if (taaEnabled) {
+            r3d_profile_begin(R3D_PROFILE_ANTI_ALIASING);
+            r3d_target_t taaTarget = pass_post_taa(r3d_target_swap_scene(sceneTarget), taaJitter);
+            r3d_profile_end(R3D_PROFILE_ANTI_ALIASING);
+            r3d_target_blit(taaTarget, true);
+        }
+        else {
+            if (R3D_CACHE_FLAGS_HAS(state, R3D_FLAG_FXAA)) {
+                r3d_profile_begin(R3D_PROFILE_ANTI_ALIASING);
+                sceneTarget = pass_post_fxaa(sceneTarget);
+                r3d_profile_end(R3D_PROFILE_ANTI_ALIASING);
+            }
+            r3d_target_blit(r3d_target_swap_scene(sceneTarget), false);
+        }
+    }
+}
+
+void merge_draw_buffers(void)
+{
+    for (int iBuffer = 0; iBuffer < R3D_MOD_DRAW.buffers.count; iBuffer++)
+    {
+        R3D_DrawBuffer* buffer = R3D_MOD_DRAW.buffers.list[iBuffer];
+
+        for (int iGroup = 0; iGroup < buffer->numGroups; iGroup++)
+        {
+            const r3d_draw_buffer_group_t* group = &buffer->groups[iGroup];
+
+            r3d_draw_group_push_bounded(&group->group, group->center, group->extent);
+
+            for (int iCall = 0; iCall < group->numCalls; iCall++)
+            {
+                const r3d_draw_buffer_call_t* call = &buffer->calls[group->firstCall + iCall];
+
+                if (!R3D_CACHE_FLAGS_HAS(layers, call->mesh.layerMask)) {
+                    continue;
+                }
+
+                r3d_draw_call_t drawCall = {0};
+                drawCall.mesh = call->mesh;
+
+                // The copy stays in the buffer until the next recording, no need to intern it
+                if (call->defaultMaterial) r3d_draw_call_push(&drawCall, NULL, false);
+                else r3d_draw_call_push_retained(&drawCall, &call->material, false);
+            }
+        }
+
+        buffer->numGroups = 0;
+        buffer->numCalls = 0;
+    }
 }
 
 void reset_raylib_state(void)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindVertexArray(0);
-    glUseProgram(0);
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    r3d_state_bind_vao(0);
+    r3d_state_use_program(0);
 
-    glViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+    // Without window, the renders only go to targets and raylib has no screen viewport
+    if (GetRenderWidth() > 0 && GetRenderHeight() > 0) {
+        glViewport(0, 0, GetRenderWidth(), GetRenderHeight());
+    }
 
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
+    r3d_state_disable(GL_DEPTH_TEST);
+    r3d_state_enable(GL_CULL_FACE);
+    r3d_state_enable(GL_BLEND);
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glBlendEquation(GL_FUNC_ADD);
-    glDepthFunc(GL_LEQUAL);
-    glDepthMask(GL_TRUE);
+    r3d_state_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    r3d_state_blend_equation(GL_FUNC_ADD);
+    r3d_state_depth_func(GL_LEQUAL);
+    r3d_state_depth_mask(true);
 
     // Here we re-define the blend mode via rlgl to ensure its internal state
     // matches what we've just set manually with OpenGL.
@@ -0,0 +1,229 @@
+/* r3d_instance.c -- R3D Instance Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_instance.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <glad.h>
+
+#include "./modules/r3d_draw.h"
+#include "./modules/r3d_profile.h"
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static GLuint create_storage(size_t size, R3D_InstanceUsage usage, void** mapped)
+{
+    GLuint vbo = 0;
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    if (GLAD_GL_ARB_buffer_storage) {
+        if (usage == R3D_STREAMED_INSTANCES) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+            *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+        }
+        else {
+            glBufferStorage(GL_ARRAY_BUFFER, size, NULL, GL_DYNAMIC_STORAGE_BIT);
+        }
+    }
+    else {
+        GLenum glUsage = GL_STATIC_DRAW;
+        switch (usage) {
+        case R3D_STATIC_INSTANCES: glUsage = GL_STATIC_DRAW; break;
+        case R3D_DYNAMIC_INSTANCES: glUsage = GL_DYNAMIC_DRAW; break;
+        case R3D_STREAMED_INSTANCES: glUsage = GL_STREAM_DRAW; break;
+        default: break;
+        }
+        glBufferData(GL_ARRAY_BUFFER, size, NULL, glUsage);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return vbo;
+}
+
+static void write_range(GLuint vbo, void* mapped, size_t offset, const void* data, size_t size)
+{
+    R3D_PROFILE_COUNT(instanceBytes, size);
+
+    if (mapped != NULL) {
+        memcpy((uint8_t*)mapped + offset, data, size);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void advance_segment(R3D_InstanceBuffer* buffer)
+{
+    // The previous segment is still read by the commands already submitted,
+    // we fence it and make sure the next one has been fully consumed by the GPU
+
+    bool mapped = (buffer->mapTransforms != NULL);
+
+    if (mapped) {
+        buffer->fences[buffer->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    buffer->segment = (buffer->segment + 1) % buffer->numSegments;
+    buffer->frame = R3D_MOD_DRAW.frameIndex;
+
+    GLsync fence = (GLsync)buffer->fences[buffer->segment];
+    if (fence == NULL) return;
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    glDeleteSync(fence);
+    buffer->fences[buffer->segment] = NULL;
+}
+
+/*
+ * Validates an upload range and switches streamed buffers to their segment of the frame.
+ */
+static bool begin_upload(R3D_InstanceBuffer* buffer, int offset, int count, const char* funcName)
+{
+    if (!R3D_IsInstanceBufferValid(buffer)) {
+        TraceLog(LOG_WARNING, "R3D: Invalid instance buffer passed to %s", funcName);
+        return false;
+    }
+
+    if (offset < 0 || count <= 0 || offset + count > buffer->capacity) {
+        TraceLog(LOG_WARNING, "R3D: Out of range upload in %s (offset: %i, count: %i, capacity: %i)",
+                 funcName, offset, count, buffer->capacity);
+        return false;
+    }
+
+    if (buffer->numSegments > 1 && buffer->frame != R3D_MOD_DRAW.frameIndex) {
+        advance_segment(buffer);
+    }
+
+    return true;
+}
+
+static void end_upload(R3D_InstanceBuffer* buffer, int offset, int count)
+{
+    if (offset + count > buffer->count) {
+        buffer->count = offset + count;
+    }
+}
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_InstanceBuffer R3D_LoadInstanceBuffer(int capacity, R3D_InstanceFlags flags, R3D_InstanceUsage usage)
+{
+    R3D_InstanceBuffer buffer = {0};
+
+    if (capacity <= 0) {
+        TraceLog(LOG_WARNING, "R3D: Invalid capacity passed to R3D_LoadInstanceBuffer");
+        return buffer;
+    }
+
+    if (usage < R3D_STATIC_INSTANCES || usage > R3D_STREAMED_INSTANCES) {
+        TraceLog(LOG_WARNING, "R3D: Invalid instance usage; R3D_STATIC_INSTANCES will be used");
+        usage = R3D_STATIC_INSTANCES;
+    }
+
+    buffer.numSegments = (usage == R3D_STREAMED_INSTANCES) ? R3D_INSTANCE_RING_SIZE : 1;
+    buffer.flags = flags | R3D_INSTANCE_TRANSFORM;
+    buffer.frame = R3D_MOD_DRAW.frameIndex;
+    buffer.capacity = capacity;
+    buffer.usage = usage;
+
+    size_t numInstances = (size_t)capacity * buffer.numSegments;
+
+    buffer.vboTransforms = create_storage(numInstances * sizeof(Matrix), usage, &buffer.mapTransforms);
+
+    if (flags & R3D_INSTANCE_COLOR) {
+        buffer.vboColors = create_storage(numInstances * sizeof(Color), usage, &buffer.mapColors);
+    }
+
+    if (flags & R3D_INSTANCE_ANIMATION) {
+        buffer.vboAnimations = create_storage(numInstances * sizeof(R3D_InstanceAnimation), usage, &buffer.mapAnimations);
+    }
+
+    // Immutable streamed storages can only be written through their mapping
+    if (GLAD_GL_ARB_buffer_storage && usage == R3D_STREAMED_INSTANCES) {
+        if (buffer.mapTransforms == NULL ||
+            (buffer.vboColors != 0 && buffer.mapColors == NULL) ||
+            (buffer.vboAnimations != 0 && buffer.mapAnimations == NULL)) {
+            TraceLog(LOG_ERROR, "R3D: Failed to map the storage of a streamed instance buffer");
+            R3D_UnloadInstanceBuffer(&buffer);
+        }
+    }
+
+    return buffer;
+}
+
+void R3D_UnloadInstanceBuffer(R3D_InstanceBuffer* buffer)
+{
+    for (int i = 0; i < R3D_INSTANCE_RING_SIZE; i++) {
+        if (buffer->fences[i]) glDeleteSync((GLsync)buffer->fences[i]);
+    }
+
+    // NOTE: Deleting the buffers implicitly unmaps them
+    if (buffer->vboTransforms != 0) glDeleteBuffers(1, &buffer->vboTransforms);
+    if (buffer->vboColors != 0) glDeleteBuffers(1, &buffer->vboColors);
+    if (buffer->vboAnimations != 0) glDeleteBuffers(1, &buffer->vboAnimations);
+
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+bool R3D_IsInstanceBufferValid(const R3D_InstanceBuffer* buffer)
+{
+    return (buffer->vboTransforms != 0) && (buffer->capacity > 0);
+}
+
+void R3D_UploadInstances(R3D_InstanceBuffer* buffer, int offset, int count, const Matrix* transforms, const Color* colors)
+{
+    if (!begin_upload(buffer, offset, count, "R3D_UploadInstances")) {
+        return;
+    }
+
+    size_t base = (size_t)buffer->segment * buffer->capacity + offset;
+
+    if (transforms != NULL) {
+        write_range(buffer->vboTransforms, buffer->mapTransforms, base * sizeof(Matrix), transforms, count * sizeof(Matrix));
+    }
+
+    if (colors != NULL && buffer->vboColors != 0) {
+        write_range(buffer->vboColors, buffer->mapColors, base * sizeof(Color), colors, count * sizeof(Color));
+    }
+
+    end_upload(buffer, offset, count);
+}
+
+void R3D_UploadInstanceAnimations(R3D_InstanceBuffer* buffer, int offset, int count, const R3D_InstanceAnimation* animations)
+{
+    if (animations == NULL || !begin_upload(buffer, offset, count, "R3D_UploadInstanceAnimations")) {
+        return;
+    }
+
+    if (buffer->vboAnimations == 0) {
+        TraceLog(LOG_WARNING, "R3D: Instance buffer created without R3D_INSTANCE_ANIMATION passed to R3D_UploadInstanceAnimations");
+        return;
+    }
+
+    size_t base = (size_t)buffer->segment * buffer->capacity + offset;
+    size_t stride = sizeof(R3D_InstanceAnimation);
+
+    write_range(buffer->vboAnimations, buffer->mapAnimations, base * stride, animations, count * stride);
+
+    end_upload(buffer, offset, count);
+}
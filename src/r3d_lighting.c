@@ -264,6 +264,12 @@ bool R3D_IsShadowEnabled(R3D_Light id)
     return light->shadow;
 }
 
+int R3D_GetShadowResolution(R3D_Light id)
+{
+    GET_LIGHT_OR_RETURN(light, id, 0);
+    return light->shadow ? light->shadowMap.tileSize : 0;
+}
+
 R3D_ShadowUpdateMode R3D_GetShadowUpdateMode(R3D_Light id)
 {
     GET_LIGHT_OR_RETURN(light, id, 0);
@@ -294,6 +300,36 @@ void R3D_UpdateShadowMap(R3D_Light id)
     light->state.shadowShouldBeUpdated = true;
 }
 
+int R3D_GetShadowUpdateBudget(void)
+{
+    return R3D_MOD_LIGHT.shadowUpdateBudget;
+}
+
+void R3D_SetShadowUpdateBudget(int views)
+{
+    R3D_MOD_LIGHT.shadowUpdateBudget = (views > 0) ? views : 0;
+}
+
+int R3D_GetLightBudget(void)
+{
+    return R3D_MOD_LIGHT.lightBudget;
+}
+
+void R3D_SetLightBudget(int lights)
+{
+    R3D_MOD_LIGHT.lightBudget = (lights > 0) ? lights : 0;
+}
+
+float R3D_GetLightImportanceThreshold(void)
+{
+    return R3D_MOD_LIGHT.lightThreshold;
+}
+
+void R3D_SetLightImportanceThreshold(float threshold)
+{
+    R3D_MOD_LIGHT.lightThreshold = fmaxf(threshold, 0.0f);
+}
+
 float R3D_GetShadowSoftness(R3D_Light id)
 {
     GET_LIGHT_OR_RETURN(light, id, 0);
@@ -306,6 +342,24 @@ void R3D_SetShadowSoftness(R3D_Light id, float softness)
     light->shadowSoftness = softness * light->shadowTexelSize;
 }
 
+R3D_ShadowQuality R3D_GetShadowQuality(R3D_Light id)
+{
+    GET_LIGHT_OR_RETURN(light, id, R3D_SHADOW_QUALITY_HIGH);
+    return light->shadowQuality;
+}
+
+void R3D_SetShadowQuality(R3D_Light id, R3D_ShadowQuality quality)
+{
+    GET_LIGHT_OR_RETURN(light, id);
+
+    if (quality < R3D_SHADOW_QUALITY_LOW || quality > R3D_SHADOW_QUALITY_HIGH) {
+        TraceLog(LOG_WARNING, "R3D: Invalid shadow quality (%i) for light [ID %i]", quality, id);
+        return;
+    }
+
+    light->shadowQuality = quality;
+}
+
 float R3D_GetShadowDepthBias(R3D_Light id)
 {
     GET_LIGHT_OR_RETURN(light, id, 0);
@@ -330,6 +384,55 @@ void R3D_SetShadowSlopeBias(R3D_Light id, float value)
     light->shadowSlopeBias = value;
 }
 
+int R3D_GetShadowCascadeCount(R3D_Light id)
+{
+    GET_LIGHT_OR_RETURN(light, id, 0);
+    return (light->type == R3D_LIGHT_DIR) ? light->shadowCascades : 0;
+}
+
+void R3D_SetShadowCascadeCount(R3D_Light id, int count)
+{
+    GET_LIGHT_OR_RETURN(light, id);
+    if (light->type != R3D_LIGHT_DIR) {
+        TraceLog(LOG_WARNING, "R3D: Can't set shadow cascades for light [ID %i]; it's not directional", id);
+        return;
+    }
+    r3d_light_set_shadow_cascades(light, count);
+}
+
+float R3D_GetShadowCascadeSplit(R3D_Light id)
+{
+    GET_LIGHT_OR_RETURN(light, id, 0);
+    return light->shadowCascadeSplit;
+}
+
+void R3D_SetShadowCascadeSplit(R3D_Light id, float split)
+{
+    GET_LIGHT_OR_RETURN(light, id);
+    if (light->type != R3D_LIGHT_DIR) {
+        TraceLog(LOG_WARNING, "R3D: Can't set shadow cascade split for light [ID %i]; it's not directional", id);
+        return;
+    }
+    light->shadowCascadeSplit = Clamp(split, 0.0f, 1.0f);
+    light->state.cascadesShouldBeUpdated = true;
+}
+
+int R3D_GetShadowCascadeUpdateInterval(R3D_Light id)
+{
+    GET_LIGHT_OR_RETURN(light, id, 0);
+    return light->state.cascadeInterval;
+}
+
+void R3D_SetShadowCascadeUpdateInterval(R3D_Light id, int updates)
+{
+    GET_LIGHT_OR_RETURN(light, id);
+    if (light->type != R3D_LIGHT_DIR) {
+        TraceLog(LOG_WARNING, "R3D: Can't set shadow cascade update interval for light [ID %i]; it's not directional", id);
+        return;
+    }
+    light->state.cascadeInterval = (updates > 1) ? updates : 1;
+}
+
 BoundingBox R3D_GetLightBoundingBox(R3D_Light id)
 {
     GET_LIGHT_OR_RETURN(light, id, (BoundingBox) {0});
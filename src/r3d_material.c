@@ -44,6 +44,7 @@ R3D_Material R3D_GetDefaultMaterial(void)
     material.billboardMode = R3D_BILLBOARD_DISABLED;
     material.blendMode = R3D_BLEND_MIX;
     material.cullMode = R3D_CULL_BACK;
+    material.resolution = R3D_RESOLUTION_FULL;
     material.uvOffset = (Vector2) {0.0f, 0.0f};
     material.uvScale = (Vector2) {1.0f, 1.0f};
     material.alphaCutoff = 0.01f;
@@ -53,17 +54,9 @@ R3D_Material R3D_GetDefaultMaterial(void)
 
 void R3D_UnloadMaterial(const R3D_Material* material)
 {
-#define UNLOAD_TEXTURE_IF_VALID(id) \
-    do { \
-        if ((id) != 0 && !r3d_texture_is_default(id)) { \
-            glDeleteTextures(1, &id); \
-        } \
-    } while (0)
-
-    UNLOAD_TEXTURE_IF_VALID(material->albedo.texture.id);
-    UNLOAD_TEXTURE_IF_VALID(material->emission.texture.id);
-    UNLOAD_TEXTURE_IF_VALID(material->normal.texture.id);
-    UNLOAD_TEXTURE_IF_VALID(material->orm.texture.id);
-
-#undef UNLOAD_TEXTURE_IF_VALID
+    // Textures shared with other models are only deleted with their last reference
+    r3d_texture_release(material->albedo.texture.id);
+    r3d_texture_release(material->emission.texture.id);
+    r3d_texture_release(material->normal.texture.id);
+    r3d_texture_release(material->orm.texture.id);
 }
@@ -12,86 +12,173 @@
 #include <stddef.h>
 #include <glad.h>
 
+#include "./modules/r3d_arena.h"
+#include "./modules/r3d_preskin.h"
+#include "./modules/r3d_state.h"
+#include "./details/r3d_vertex.h"
+
 // ========================================
-// PUBLIC API
+// INTERNAL FUNCTIONS
 // ========================================
 
-R3D_Mesh R3D_LoadMesh(R3D_PrimitiveType type, const R3D_MeshData* data, const BoundingBox* aabb, R3D_MeshUsage usage)
+static GLenum get_gl_usage(R3D_MeshUsage usage)
 {
-    R3D_Mesh mesh = { 0 };
+    switch (usage) {
+    case R3D_STATIC_MESH: return GL_STATIC_DRAW;
+    case R3D_DYNAMIC_MESH: return GL_DYNAMIC_DRAW;
+    case R3D_STREAMED_MESH: return GL_STREAM_DRAW;
+    default: break;
+    }
 
-    if (data == NULL || data->vertexCount <= 0 || !data->vertices) {
-        TraceLog(LOG_WARNING, "R3D: Invalid mesh data passed to R3D_UpdateMesh");
-        return mesh;
+    TraceLog(LOG_WARNING, "R3D: Invalid mesh usage; R3D_STATIC_MESH will be used");
+    return GL_STATIC_DRAW;
+}
+
+static void upload_stream(const R3D_Mesh* mesh, GLuint vbo, r3d_vertex_stream_e stream, const R3D_MeshData* data, GLenum glUsage, bool allocate)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (!r3d_vertex_upload(mesh->vertexFormat, stream, data->vertices, data->vertexCount, 0, &mesh->quantizationBounds, allocate, glUsage)) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate the vertices to upload");
     }
+}
 
-    GLenum glUsage = GL_STATIC_DRAW;
-    switch (usage) {
-    case R3D_STATIC_MESH: glUsage = GL_STATIC_DRAW; break;
-    case R3D_DYNAMIC_MESH: glUsage = GL_DYNAMIC_DRAW; break;
-    case R3D_STREAMED_MESH: glUsage = GL_STREAM_DRAW; break;
-    default:
-        TraceLog(LOG_WARNING, "R3D: Invalid mesh usage; R3D_STATIC_MESH will be used");
-        break;
+static void upload_streams(const R3D_Mesh* mesh, const R3D_MeshData* data, GLenum glUsage, bool allocate)
+{
+    upload_stream(mesh, mesh->vbo, R3D_VERTEX_STREAM_POSITION, data, glUsage, allocate);
+    upload_stream(mesh, mesh->attribVbo, R3D_VERTEX_STREAM_ATTRIBS, data, glUsage, allocate);
+
+    if (mesh->skinVbo != 0) {
+        upload_stream(mesh, mesh->skinVbo, R3D_VERTEX_STREAM_SKIN, data, glUsage, allocate);
     }
 
-    // Creation of the VAO
-    glGenVertexArrays(1, &mesh.vao);
-    glBindVertexArray(mesh.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static void setup_vertex_array(const R3D_Mesh* mesh, GLuint vao, bool depthOnly)
+{
+    r3d_state_bind_vao(vao);
 
-    // Creation of the VBO
-    glGenBuffers(1, &mesh.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-    glBufferData(GL_ARRAY_BUFFER, data->vertexCount * sizeof(R3D_Vertex), data->vertices, glUsage);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_POSITION);
 
-    // position (vec3)
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, position));
+    if (mesh->skinVbo != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->skinVbo);
+        r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_SKIN);
+    }
 
-    // texcoord (vec2)
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, texcoord));
+    // The depth passes only read the positions and the skinning
+    if (!depthOnly) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->attribVbo);
+        r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_ATTRIBS);
+    }
 
-    // normal (vec3)
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, normal));
+    r3d_vertex_setup_defaults();
 
-    // color (vec4)
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, color));
+    if (mesh->ebo != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    }
 
-    // tangent (vec4)
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, tangent));
+    r3d_state_bind_vao(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
 
-    // boneIds (ivec4)
-    glEnableVertexAttribArray(5);
-    glVertexAttribIPointer(5, 4, GL_INT, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, boneIds));
+static void update_depth_vertex_array(R3D_Mesh* mesh, const R3D_MeshData* data)
+{
+    // Translucent vertex colors are needed for alpha testing, the depth passes then use the full VAO
+    bool depthOnly = !r3d_vertex_has_alpha(data);
 
-    // weights (vec4)
-    glEnableVertexAttribArray(6);
-    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(R3D_Vertex), (void*)offsetof(R3D_Vertex, weights));
+    if (depthOnly && mesh->depthVao == 0) {
+        glGenVertexArrays(1, &mesh->depthVao);
+        setup_vertex_array(mesh, mesh->depthVao, true);
+    }
+    else if (!depthOnly && mesh->depthVao != 0) {
+        glDeleteVertexArrays(1, &mesh->depthVao);
+        mesh->depthVao = 0;
+    }
+}
 
-    // Default matrix instance (mat4)
-    glVertexAttrib4f(10, 1.0f, 0.0f, 0.0f, 0.0f);
-    glVertexAttrib4f(11, 0.0f, 1.0f, 0.0f, 0.0f);
-    glVertexAttrib4f(12, 0.0f, 0.0f, 1.0f, 0.0f);
-    glVertexAttrib4f(13, 0.0f, 0.0f, 0.0f, 1.0f);
+static void update_bounds(R3D_Mesh* mesh, const R3D_MeshData* data, const BoundingBox* aabb)
+{
+    if (aabb != NULL) mesh->aabb = *aabb;
+    else if (mesh->vertexFormat == R3D_VERTEX_FORMAT_COMPACT) mesh->aabb = mesh->quantizationBounds;
+    else mesh->aabb = R3D_CalculateMeshDataBoundingBox(data);
+}
 
-    // Default color instance (vec4)
-    glVertexAttrib4f(14, 1.0f, 1.0f, 1.0f, 1.0f);
+static bool fits_bounds(const R3D_MeshData* data, const BoundingBox* bounds)
+{
+    for (int i = 0; i < data->vertexCount; i++) {
+        Vector3 p = data->vertices[i].position;
+        if (p.x < bounds->min.x || p.y < bounds->min.y || p.z < bounds->min.z ||
+            p.x > bounds->max.x || p.y > bounds->max.y || p.z > bounds->max.z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void load_owned_buffers(R3D_Mesh* mesh, const R3D_MeshData* data, GLenum glUsage)
+{
+    // Creation of the vertex streams
+    glGenBuffers(1, &mesh->vbo);
+    glGenBuffers(1, &mesh->attribVbo);
+    if (r3d_vertex_has_skin(data)) {
+        glGenBuffers(1, &mesh->skinVbo);
+    }
+
+    upload_streams(mesh, data, glUsage, true);
 
     // EBO if indices present
     if (data->indexCount > 0 && data->indices) {
-        glGenBuffers(1, &mesh.ebo);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+        glGenBuffers(1, &mesh->ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, data->indexCount * sizeof(uint32_t), data->indices, glUsage);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    // Cleaning
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    // Creation of the VAOs
+    glGenVertexArrays(1, &mesh->vao);
+    setup_vertex_array(mesh, mesh->vao, false);
+    update_depth_vertex_array(mesh, data);
+}
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_Mesh R3D_LoadMesh(R3D_PrimitiveType type, const R3D_MeshData* data, const BoundingBox* aabb, R3D_MeshUsage usage)
+{
+    return R3D_LoadMeshEx(type, data, aabb, usage, R3D_VERTEX_FORMAT_FULL);
+}
+
+R3D_Mesh R3D_LoadMeshEx(R3D_PrimitiveType type, const R3D_MeshData* data, const BoundingBox* aabb, R3D_MeshUsage usage, R3D_VertexFormat format)
+{
+    R3D_Mesh mesh = { 0 };
+
+    if (data == NULL || data->vertexCount <= 0 || !data->vertices) {
+        TraceLog(LOG_WARNING, "R3D: Invalid mesh data passed to R3D_LoadMesh");
+        return mesh;
+    }
+
+    GLenum glUsage = get_gl_usage(usage);
+
+    // Compact vertices store bone indices on 8 bits
+    if (format == R3D_VERTEX_FORMAT_COMPACT && !r3d_vertex_can_compact(data)) {
+        TraceLog(LOG_WARNING, "R3D: Bone indices exceed 255; R3D_VERTEX_FORMAT_FULL will be used");
+        format = R3D_VERTEX_FORMAT_FULL;
+    }
+
+    mesh.vertexFormat = format;
+    if (format == R3D_VERTEX_FORMAT_COMPACT) {
+        mesh.quantizationBounds = R3D_CalculateMeshDataBoundingBox(data);
+    }
+
+    // Static indexed triangles are sub-allocated from the shared arena,
+    // which allows their draws to be merged into multi-draw commands
+    bool shared = (usage == R3D_STATIC_MESH && type == R3D_PRIMITIVE_TRIANGLES && format == R3D_VERTEX_FORMAT_FULL);
+    if (!shared || !r3d_arena_alloc(&mesh, data)) {
+        load_owned_buffers(&mesh, data, glUsage);
+    }
 
     // Fill mesh infos
     mesh.vertexCount = mesh.allocVertexCount = data->vertexCount;
@@ -102,16 +189,27 @@ R3D_Mesh R3D_LoadMesh(R3D_PrimitiveType type, const R3D_MeshData* data, const Bo
     mesh.usage = usage;
 
     // Compute the bounding box, if needed
-    mesh.aabb = (aabb != NULL) ? *aabb
-        : R3D_CalculateMeshDataBoundingBox(data);
+    update_bounds(&mesh, data, aabb);
 
     return mesh;
 }
 
 void R3D_UnloadMesh(R3D_Mesh* mesh)
 {
+    if (r3d_arena_owns(mesh->vao)) {
+        r3d_arena_free(mesh);
+        return;
+    }
+
+    if (mesh->skinVbo != 0) {
+        r3d_preskin_release(mesh);
+    }
+
     if (mesh->vao != 0) glDeleteVertexArrays(1, &mesh->vao);
+    if (mesh->depthVao != 0) glDeleteVertexArrays(1, &mesh->depthVao);
     if (mesh->vbo != 0) glDeleteBuffers(1, &mesh->vbo);
+    if (mesh->skinVbo != 0) glDeleteBuffers(1, &mesh->skinVbo);
+    if (mesh->attribVbo != 0) glDeleteBuffers(1, &mesh->attribVbo);
     if (mesh->ebo != 0) glDeleteBuffers(1, &mesh->ebo);
 }
 
@@ -343,45 +441,231 @@ bool R3D_UpdateMesh(R3D_Mesh* mesh, const R3D_MeshData* data, const BoundingBox*
         return false;
     }
 
-    GLenum glUsage = GL_STATIC_DRAW;
-    switch (mesh->usage) {
-    case R3D_STATIC_MESH: glUsage = GL_STATIC_DRAW; break;
-    case R3D_DYNAMIC_MESH: glUsage = GL_DYNAMIC_DRAW; break;
-    case R3D_STREAMED_MESH: glUsage = GL_STREAM_DRAW; break;
-    default:
-        TraceLog(LOG_WARNING, "R3D: Invalid mesh usage; R3D_STATIC_MESH will be used");
-        break;
+    // The levels of detail reference the previous vertices
+    R3D_ClearMeshLods(mesh);
+
+    GLenum glUsage = get_gl_usage(mesh->usage);
+
+    if (r3d_arena_owns(mesh->vao)) {
+        if (!r3d_arena_update(mesh, data)) return false;
+        mesh->vertexCount = data->vertexCount;
+        mesh->indexCount = data->indexCount;
+        update_bounds(mesh, data, aabb);
+        return true;
     }
 
-    glBindVertexArray(mesh->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    // The layout of the vertex array is kept, compact meshes are re-encoded in new bounds
+    if (mesh->vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        if (!r3d_vertex_can_compact(data)) {
+            TraceLog(LOG_WARNING, "R3D: Cannot update compact mesh; Bone indices exceed 255");
+            return false;
+        }
+        mesh->quantizationBounds = R3D_CalculateMeshDataBoundingBox(data);
+    }
 
-    if (mesh->allocVertexCount < data->vertexCount) {
-        glBufferData(GL_ARRAY_BUFFER, mesh->vertexCount * sizeof(R3D_Vertex), data->vertices, glUsage);
+    // The skinning stream is only created once bone weights appear,
+    // the vertex arrays then have to be declared again
+    bool layoutChanged = false;
+
+    if (mesh->skinVbo == 0 && r3d_vertex_has_skin(data)) {
+        glGenBuffers(1, &mesh->skinVbo);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->skinVbo);
+        glBufferData(GL_ARRAY_BUFFER, mesh->allocVertexCount * r3d_vertex_stride(mesh->vertexFormat, R3D_VERTEX_STREAM_SKIN), NULL, glUsage);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        layoutChanged = true;
+    }
+
+    // Streamed meshes always reallocate their storage, the driver then orphans the previous one
+    // instead of waiting for the draws still reading it
+    bool orphan = (mesh->usage == R3D_STREAMED_MESH);
+
+    if (orphan || mesh->allocVertexCount < data->vertexCount) {
+        upload_streams(mesh, data, glUsage, true);
         mesh->allocVertexCount = data->vertexCount;
     }
     else {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, mesh->vertexCount * sizeof(R3D_Vertex), data->vertices);
+        upload_streams(mesh, data, glUsage, false);
     }
 
     if (data->indexCount > 0) {
-        if (mesh->allocIndexCount < data->indexCount) {
-            if (mesh->ebo == 0) glGenBuffers(1, &mesh->ebo);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->indexCount * sizeof(uint32_t), data->indices, glUsage);
+        if (mesh->ebo == 0) {
+            glGenBuffers(1, &mesh->ebo);
+            layoutChanged = true;
+        }
+        // NOTE: The element buffer binding is part of the VAO state, we don't want to alter the bound VAO
+        r3d_state_bind_vao(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+        if (orphan || mesh->allocIndexCount < data->indexCount) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, data->indexCount * sizeof(uint32_t), data->indices, glUsage);
             mesh->allocIndexCount = data->indexCount;
         }
         else {
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, mesh->indexCount * sizeof(uint32_t), data->indices);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, data->indexCount * sizeof(uint32_t), data->indices);
         }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    if (layoutChanged) {
+        setup_vertex_array(mesh, mesh->vao, false);
+        if (mesh->depthVao != 0) {
+            setup_vertex_array(mesh, mesh->depthVao, true);
+        }
+    }
+
+    update_depth_vertex_array(mesh, data);
 
     mesh->vertexCount = data->vertexCount;
     mesh->indexCount = data->indexCount;
+    update_bounds(mesh, data, aabb);
+
+    return true;
+}
+
+bool R3D_UpdateMeshRange(R3D_Mesh* mesh, int firstVertex, int vertexCount, const R3D_Vertex* vertices)
+{
+    if (!mesh || mesh->vao == 0 || mesh->vbo == 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot update mesh range; Invalid mesh instance");
+        return false;
+    }
+
+    if (!vertices || vertexCount <= 0 || firstVertex < 0 || firstVertex + vertexCount > mesh->vertexCount) {
+        TraceLog(LOG_WARNING, "R3D: Invalid vertex range given to R3D_UpdateMeshRange");
+        return false;
+    }
+
+    // Only the vertex streams are rewritten, the indices and the levels of detail remain valid
+    R3D_MeshData range = { .vertices = (R3D_Vertex*)vertices, .vertexCount = vertexCount };
+
+    if (mesh->skinVbo == 0 && r3d_vertex_has_skin(&range)) {
+        TraceLog(LOG_WARNING, "R3D: Cannot update mesh range; The mesh has no bone weights, use R3D_UpdateMesh");
+        return false;
+    }
+
+    bool hasAlpha = r3d_vertex_has_alpha(&range);
+
+    if (r3d_arena_owns(mesh->vao)) {
+        if (!r3d_arena_update_vertices(mesh, firstVertex, vertices, vertexCount)) return false;
+        if (hasAlpha) mesh->depthVao = 0;
+        return true;
+    }
+
+    // The other vertices keep their encoding, the range must fit in the same bounds
+    if (mesh->vertexFormat == R3D_VERTEX_FORMAT_COMPACT) {
+        if (!r3d_vertex_can_compact(&range) || !fits_bounds(&range, &mesh->quantizationBounds)) {
+            TraceLog(LOG_WARNING, "R3D: Cannot update compact mesh range; The vertices leave its bounds, use R3D_UpdateMesh");
+            return false;
+        }
+    }
+
+    bool uploaded = true;
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    uploaded &= r3d_vertex_upload(mesh->vertexFormat, R3D_VERTEX_STREAM_POSITION, vertices, vertexCount, firstVertex, &mesh->quantizationBounds, false, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->attribVbo);
+    uploaded &= r3d_vertex_upload(mesh->vertexFormat, R3D_VERTEX_STREAM_ATTRIBS, vertices, vertexCount, firstVertex, &mesh->quantizationBounds, false, 0);
+    if (mesh->skinVbo != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->skinVbo);
+        uploaded &= r3d_vertex_upload(mesh->vertexFormat, R3D_VERTEX_STREAM_SKIN, vertices, vertexCount, firstVertex, &mesh->quantizationBounds, false, 0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!uploaded) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate the vertices to upload");
+        return false;
+    }
+
+    // Translucent vertex colors now require the full vertex array in the depth passes
+    if (hasAlpha && mesh->depthVao != 0) {
+        glDeleteVertexArrays(1, &mesh->depthVao);
+        mesh->depthVao = 0;
+    }
 
     return true;
 }
+
+bool R3D_AddMeshLod(R3D_Mesh* mesh, const uint32_t* indices, int indexCount, float screenSize)
+{
+    if (!mesh || mesh->vao == 0 || mesh->ebo == 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot add mesh LOD; The mesh must be indexed");
+        return false;
+    }
+
+    if (!indices || indexCount <= 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot add mesh LOD; Invalid indices");
+        return false;
+    }
+
+    if (mesh->lodCount >= R3D_MESH_MAX_LODS) {
+        TraceLog(LOG_WARNING, "R3D: Cannot add mesh LOD; The mesh already has %i levels", R3D_MESH_MAX_LODS);
+        return false;
+    }
+
+    int firstIndex = -1;
+
+    if (r3d_arena_owns(mesh->vao)) {
+        firstIndex = r3d_arena_alloc_indices(mesh, indices, indexCount);
+        if (firstIndex < 0) {
+            TraceLog(LOG_WARNING, "R3D: Cannot add mesh LOD; The mesh arena chunk is full");
+            return false;
+        }
+    }
+    else {
+        // Levels are stored after the indices of the mesh and of the previous levels
+        firstIndex = mesh->allocIndexCount;
+        if (mesh->lodCount > 0) {
+            const R3D_MeshLod* last = &mesh->lods[mesh->lodCount - 1];
+            firstIndex = last->firstIndex + last->indexCount;
+        }
+
+        GLenum glUsage = GL_STATIC_DRAW;
+        if (mesh->usage == R3D_DYNAMIC_MESH) glUsage = GL_DYNAMIC_DRAW;
+        else if (mesh->usage == R3D_STREAMED_MESH) glUsage = GL_STREAM_DRAW;
+
+        // Grow the element buffer by copying its content into a new one
+        GLuint ebo = 0;
+        glGenBuffers(1, &ebo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+        glBufferData(GL_COPY_WRITE_BUFFER, (firstIndex + indexCount) * sizeof(uint32_t), NULL, glUsage);
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh->ebo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, firstIndex * sizeof(uint32_t));
+        glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(uint32_t), indexCount * sizeof(uint32_t), indices);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        r3d_state_bind_vao(mesh->vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        if (mesh->depthVao != 0) {
+            r3d_state_bind_vao(mesh->depthVao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        }
+        r3d_state_bind_vao(0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        glDeleteBuffers(1, &mesh->ebo);
+        mesh->ebo = ebo;
+    }
+
+    R3D_MeshLod* lod = &mesh->lods[mesh->lodCount++];
+
+    lod->firstIndex = firstIndex;
+    lod->indexCount = indexCount;
+    lod->screenSize = screenSize;
+
+    return true;
+}
+
+void R3D_ClearMeshLods(R3D_Mesh* mesh)
+{
+    if (!mesh || mesh->lodCount == 0) {
+        return;
+    }
+
+    // Owned buffers keep the storage of the levels until their next reallocation
+    if (r3d_arena_owns(mesh->vao)) {
+        for (int i = 0; i < mesh->lodCount; i++) {
+            r3d_arena_free_indices(mesh, mesh->lods[i].firstIndex, mesh->lods[i].indexCount);
+        }
+    }
+
+    mesh->lodCount = 0;
+}
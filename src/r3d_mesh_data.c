@@ -11,8 +11,1323 @@
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>
+#include <tinycthread.h>
+#include <stdatomic.h>
 
 #include "./details/r3d_math.h"
+#include "./details/r3d_simd.h"
+#include "./details/r3d_cpu.h"
+
+// ========================================
+// MESH OPTIMIZATION (INTERNAL)
+// ========================================
+
+#define OPTIMIZE_CACHE_SIZE         32      //< Size of the LRU cache modeled when ordering the triangles
+#define OPTIMIZE_VALENCE_MAX        32      //< Valence above which vertices share the same score
+#define OPTIMIZE_FIFO_SIZE          16      //< Size of the FIFO cache modeled when splitting the clusters
+#define OPTIMIZE_OVERDRAW_THRESHOLD 1.05f   //< Cache efficiency that can be traded to reduce overdraw
+
+/*
+ * Score of a vertex following Forsyth's linear-speed vertex cache optimization.
+ * Recently used vertices and the ones left with few triangles are preferred.
+ */
+static float optimize_vertex_score(int cachePosition, uint32_t liveTriangles)
+{
+    if (liveTriangles == 0) return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePosition >= 0) {
+        /* The last triangle gets a fixed score, so that the next one is not forced to share an edge with it */
+        if (cachePosition < 3) score = 0.75f;
+        else score = powf(1.0f - (float)(cachePosition - 3) / (OPTIMIZE_CACHE_SIZE - 3), 1.5f);
+    }
+
+    if (liveTriangles > OPTIMIZE_VALENCE_MAX) {
+        liveTriangles = OPTIMIZE_VALENCE_MAX;
+    }
+
+    return score + 2.0f / sqrtf((float)liveTriangles);
+}
+
+/*
+ * Reorders the triangles to maximize the hits of the post-transform vertex cache.
+ * Returns false on allocation failure, the indices are then left untouched.
+ */
+static bool optimize_vertex_cache(uint32_t* indices, int indexCount, int vertexCount)
+{
+    int triangleCount = indexCount / 3;
+    if (triangleCount < 2) return true;
+
+    uint32_t* live = RL_CALLOC(vertexCount, sizeof(uint32_t));
+    uint32_t* offsets = RL_MALLOC((vertexCount + 1) * sizeof(uint32_t));
+    uint32_t* adjacency = RL_MALLOC(3 * triangleCount * sizeof(uint32_t));
+    int* cachePosition = RL_MALLOC(vertexCount * sizeof(int));
+    float* vertexScores = RL_MALLOC(vertexCount * sizeof(float));
+    float* triangleScores = RL_MALLOC(triangleCount * sizeof(float));
+    uint8_t* emitted = RL_CALLOC(triangleCount, sizeof(uint8_t));
+    uint32_t* source = RL_MALLOC(3 * triangleCount * sizeof(uint32_t));
+
+    bool success = live && offsets && adjacency && cachePosition && vertexScores && triangleScores && emitted && source;
+
+    if (success)
+    {
+        memcpy(source, indices, 3 * triangleCount * sizeof(uint32_t));
+
+        for (int i = 0; i < 3 * triangleCount; i++) {
+            live[source[i]]++;
+        }
+
+        offsets[0] = 0;
+        for (int v = 0; v < vertexCount; v++) {
+            offsets[v + 1] = offsets[v] + live[v];
+            live[v] = 0;
+        }
+
+        for (int i = 0; i < 3 * triangleCount; i++) {
+            uint32_t v = source[i];
+            adjacency[offsets[v] + live[v]++] = i / 3;
+        }
+
+        for (int v = 0; v < vertexCount; v++) {
+            cachePosition[v] = -1;
+            vertexScores[v] = optimize_vertex_score(-1, live[v]);
+        }
+
+        for (int t = 0; t < triangleCount; t++) {
+            const uint32_t* tri = &source[3 * t];
+            triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+        }
+
+        uint32_t cache[OPTIMIZE_CACHE_SIZE + 3];
+        int cacheCount = 0;
+
+        int best = -1;
+        int next = 0;
+
+        for (int written = 0; written < triangleCount; written++)
+        {
+            /* Without a candidate around the cache, restart from the next triangle of the input */
+            if (best < 0) {
+                while (emitted[next]) next++;
+                best = next;
+            }
+
+            const uint32_t* tri = &source[3 * best];
+            indices[3 * written + 0] = tri[0];
+            indices[3 * written + 1] = tri[1];
+            indices[3 * written + 2] = tri[2];
+            emitted[best] = 1;
+
+            /* Removes the triangle from the live triangles of its vertices */
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = tri[k];
+                uint32_t* list = &adjacency[offsets[v]];
+                for (uint32_t i = 0; i < live[v]; i++) {
+                    if (list[i] == (uint32_t)best) {
+                        list[i] = list[--live[v]];
+                        break;
+                    }
+                }
+            }
+
+            /* Moves the vertices of the triangle to the front of the cache */
+            uint32_t newCache[OPTIMIZE_CACHE_SIZE + 3];
+            int newCount = 0;
+
+            newCache[newCount++] = tri[0];
+            newCache[newCount++] = tri[1];
+            newCache[newCount++] = tri[2];
+
+            for (int i = 0; i < cacheCount; i++) {
+                uint32_t v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                    newCache[newCount++] = v;
+                }
+            }
+
+            /* Updates the scores of the vertices that moved or left the cache */
+            for (int i = 0; i < newCount; i++)
+            {
+                uint32_t v = newCache[i];
+                int position = (i < OPTIMIZE_CACHE_SIZE) ? i : -1;
+
+                float score = optimize_vertex_score(position, live[v]);
+                float delta = score - vertexScores[v];
+
+                cachePosition[v] = position;
+                vertexScores[v] = score;
+
+                for (uint32_t j = 0; j < live[v]; j++) {
+                    triangleScores[adjacency[offsets[v] + j]] += delta;
+                }
+            }
+
+            cacheCount = (newCount < OPTIMIZE_CACHE_SIZE) ? newCount : OPTIMIZE_CACHE_SIZE;
+            memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+            /* The next triangle is the best one around the cache */
+            best = -1;
+            float bestScore = -FLT_MAX;
+
+            for (int i = 0; i < cacheCount; i++) {
+                uint32_t v = cache[i];
+                for (uint32_t j = 0; j < live[v]; j++) {
+                    uint32_t t = adjacency[offsets[v] + j];
+                    if (triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+    }
+
+    RL_FREE(live);
+    RL_FREE(offsets);
+    RL_FREE(adjacency);
+    RL_FREE(cachePosition);
+    RL_FREE(vertexScores);
+    RL_FREE(triangleScores);
+    RL_FREE(emitted);
+    RL_FREE(source);
+
+    return success;
+}
+
+static int optimize_fifo_misses(uint32_t* cacheTime, uint32_t* timestamp, const uint32_t* tri)
+{
+    int misses = 0;
+
+    for (int k = 0; k < 3; k++) {
+        if (*timestamp - cacheTime[tri[k]] > OPTIMIZE_FIFO_SIZE) {
+            cacheTime[tri[k]] = (*timestamp)++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+typedef struct {
+    float key;
+    int cluster;
+} optimize_cluster_t;
+
+static int optimize_compare_clusters(const void* a, const void* b)
+{
+    const optimize_cluster_t* ca = a;
+    const optimize_cluster_t* cb = b;
+
+    if (ca->key != cb->key) return (ca->key < cb->key) ? 1 : -1;
+
+    return ca->cluster - cb->cluster;
+}
+
+/*
+ * Reorders clusters of triangles so that the ones facing outward are drawn first,
+ * following Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+ * Clusters are split wherever the vertex cache efficiency allows it, so that the order
+ * given by 'optimize_vertex_cache()' is kept within each of them.
+ */
+static bool optimize_overdraw(const R3D_Vertex* vertices, int vertexCount, uint32_t* indices, int indexCount)
+{
+    int triangleCount = indexCount / 3;
+    if (triangleCount < 2) return true;
+
+    uint32_t* cacheTime = RL_CALLOC(vertexCount, sizeof(uint32_t));
+    int* hardClusters = RL_MALLOC((triangleCount + 1) * sizeof(int));
+    int* clusters = RL_MALLOC((triangleCount + 1) * sizeof(int));
+    optimize_cluster_t* sort = RL_MALLOC(triangleCount * sizeof(optimize_cluster_t));
+    uint32_t* source = RL_MALLOC(3 * triangleCount * sizeof(uint32_t));
+
+    bool success = cacheTime && hardClusters && clusters && sort && source;
+
+    if (success)
+    {
+        memcpy(source, indices, 3 * triangleCount * sizeof(uint32_t));
+
+        /* Hard boundaries are triangles missing all their vertices in the cache */
+        uint32_t timestamp = OPTIMIZE_FIFO_SIZE + 1;
+        int hardCount = 0;
+
+        for (int t = 0; t < triangleCount; t++) {
+            if (optimize_fifo_misses(cacheTime, &timestamp, &source[3 * t]) == 3) {
+                hardClusters[hardCount++] = t;
+            }
+        }
+        hardClusters[hardCount] = triangleCount;
+
+        /* Soft boundaries split the hard clusters once their efficiency is reached */
+        int clusterCount = 0;
+
+        for (int c = 0; c < hardCount; c++)
+        {
+            int start = hardClusters[c];
+            int end = hardClusters[c + 1];
+
+            timestamp += OPTIMIZE_FIFO_SIZE + 1;
+            int misses = 0;
+            for (int t = start; t < end; t++) {
+                misses += optimize_fifo_misses(cacheTime, &timestamp, &source[3 * t]);
+            }
+
+            float threshold = OPTIMIZE_OVERDRAW_THRESHOLD * misses / (end - start);
+
+            clusters[clusterCount++] = start;
+            timestamp += OPTIMIZE_FIFO_SIZE + 1;
+
+            int runningMisses = 0;
+            int runningTriangles = 0;
+
+            for (int t = start; t < end; t++) {
+                runningMisses += optimize_fifo_misses(cacheTime, &timestamp, &source[3 * t]);
+                runningTriangles++;
+                if ((float)runningMisses / runningTriangles <= threshold) {
+                    clusters[clusterCount++] = t + 1;
+                    timestamp += OPTIMIZE_FIFO_SIZE + 1;
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+
+            /* The remainder is merged into the last complete cluster, it is rarely efficient on its own */
+            if (clusters[clusterCount - 1] != start) {
+                clusterCount--;
+            }
+        }
+
+        clusters[clusterCount] = triangleCount;
+
+        /* Clusters are sorted by how much they face away from the center of the mesh */
+        Vector3 meshCentroid = {0};
+        for (int i = 0; i < 3 * triangleCount; i++) {
+            meshCentroid = Vector3Add(meshCentroid, vertices[source[i]].position);
+        }
+        meshCentroid = Vector3Scale(meshCentroid, 1.0f / (3 * triangleCount));
+
+        for (int c = 0; c < clusterCount; c++)
+        {
+            Vector3 centroid = {0};
+            Vector3 normal = {0};
+            float area = 0.0f;
+
+            for (int t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                Vector3 p0 = vertices[source[3 * t + 0]].position;
+                Vector3 p1 = vertices[source[3 * t + 1]].position;
+                Vector3 p2 = vertices[source[3 * t + 2]].position;
+
+                Vector3 n = Vector3CrossProduct(Vector3Subtract(p1, p0), Vector3Subtract(p2, p0));
+                float a = Vector3Length(n);
+
+                Vector3 center = Vector3Scale(Vector3Add(Vector3Add(p0, p1), p2), 1.0f / 3.0f);
+                centroid = Vector3Add(centroid, Vector3Scale(center, a));
+                normal = Vector3Add(normal, n);
+                area += a;
+            }
+
+            float key = 0.0f;
+            if (area > 0.0f) {
+                centroid = Vector3Scale(centroid, 1.0f / area);
+                key = Vector3DotProduct(Vector3Subtract(centroid, meshCentroid), Vector3Normalize(normal));
+            }
+
+            sort[c] = (optimize_cluster_t) { key, c };
+        }
+
+        qsort(sort, clusterCount, sizeof(*sort), optimize_compare_clusters);
+
+        int written = 0;
+        for (int i = 0; i < clusterCount; i++) {
+            int c = sort[i].cluster;
+            int count = 3 * (clusters[c + 1] - clusters[c]);
+            memcpy(&indices[written], &source[3 * clusters[c]], count * sizeof(uint32_t));
+            written += count;
+        }
+    }
+
+    RL_FREE(cacheTime);
+    RL_FREE(hardClusters);
+    RL_FREE(clusters);
+    RL_FREE(sort);
+    RL_FREE(source);
+
+    return success;
+}
+
+/*
+ * Reorders the vertices in their order of first use, unused vertices are moved at the end.
+ * Returns false on allocation failure, the mesh data is then left untouched.
+ */
+static bool optimize_vertex_fetch(R3D_MeshData* meshData)
+{
+    uint32_t* remap = RL_MALLOC(meshData->vertexCount * sizeof(uint32_t));
+    R3D_Vertex* vertices = RL_MALLOC(meshData->vertexCount * sizeof(R3D_Vertex));
+
+    if (!remap || !vertices) {
+        RL_FREE(remap);
+        RL_FREE(vertices);
+        return false;
+    }
+
+    memset(remap, 0xFF, meshData->vertexCount * sizeof(uint32_t));
+
+    uint32_t next = 0;
+    for (int i = 0; i < meshData->indexCount; i++) {
+        uint32_t* index = &meshData->indices[i];
+        if (remap[*index] == UINT32_MAX) {
+            remap[*index] = next++;
+        }
+        *index = remap[*index];
+    }
+
+    for (int v = 0; v < meshData->vertexCount; v++) {
+        if (remap[v] == UINT32_MAX) {
+            remap[v] = next++;
+        }
+        vertices[remap[v]] = meshData->vertices[v];
+    }
+
+    RL_FREE(meshData->vertices);
+    meshData->vertices = vertices;
+
+    RL_FREE(remap);
+
+    return true;
+}
+
+// ========================================
+// MESH SIMPLIFICATION (INTERNAL)
+// ========================================
+
+#define SIMPLIFY_NONE           UINT32_MAX          //< No open edge
+#define SIMPLIFY_MANY           (UINT32_MAX - 1)    //< More than one open edge
+#define SIMPLIFY_EDGE_WEIGHT    10.0                //< Weight of the quadrics holding the borders and seams in place
+#define SIMPLIFY_PASS_BOUND     1.5f                //< Error growth allowed within a pass, relative to the error of its goal
+
+typedef enum {
+    SIMPLIFY_MANIFOLD,                  //< Interior vertex, collapses onto any neighbor
+    SIMPLIFY_BORDER,                    //< Vertex of an open border, collapses along the border
+    SIMPLIFY_SEAM,                      //< Vertex split in two attribute sets, collapses along the seam
+    SIMPLIFY_LOCKED                     //< Vertex that is never collapsed
+} simplify_kind_t;
+
+typedef struct {
+    double a00, a11, a22;
+    double a01, a02, a12;
+    double b0, b1, b2;
+    double c, w;
+} simplify_quadric_t;
+
+typedef struct {
+    uint32_t source;
+    uint32_t target;
+    float error;
+} simplify_collapse_t;
+
+/*
+ * Working state of the simplification.
+ * Vertices are attribute sets, several of them can share the same position.
+ * The ones sharing a position are linked together in a circular list of wedges.
+ */
+typedef struct {
+    Vector3* positions;                 //< Positions rescaled to the unit cube
+    uint32_t* remap;                    //< First vertex sharing the same position
+    uint32_t* wedge;                    //< Next referenced vertex sharing the same position
+    uint32_t* openIn;                   //< Source of the open edge ending at each vertex
+    uint32_t* openOut;                  //< Target of the open edge starting at each vertex
+    uint8_t* kind;                      //< Collapse rules of each vertex, see 'simplify_kind_t'
+    uint32_t* offsets;                  //< First entry of each vertex in 'triangles'
+    uint32_t* triangles;                //< Triangles around each vertex
+    simplify_quadric_t* quadrics;       //< Error quadric of each position
+    simplify_collapse_t* collapses;     //< Candidate collapses of the pass
+    uint32_t* collapseRemap;            //< Vertex replacing each vertex at the end of the pass
+    uint8_t* collapseLocked;            //< Positions touched by a collapse of the pass
+} simplify_context_t;
+
+static void simplify_free_context(simplify_context_t* ctx)
+{
+    RL_FREE(ctx->positions);
+    RL_FREE(ctx->remap);
+    RL_FREE(ctx->wedge);
+    RL_FREE(ctx->openIn);
+    RL_FREE(ctx->openOut);
+    RL_FREE(ctx->kind);
+    RL_FREE(ctx->offsets);
+    RL_FREE(ctx->triangles);
+    RL_FREE(ctx->quadrics);
+    RL_FREE(ctx->collapses);
+    RL_FREE(ctx->collapseRemap);
+    RL_FREE(ctx->collapseLocked);
+}
+
+static bool simplify_alloc_context(simplify_context_t* ctx, int vertexCount, int indexCount)
+{
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->positions = RL_MALLOC(vertexCount * sizeof(*ctx->positions));
+    ctx->remap = RL_MALLOC(vertexCount * sizeof(*ctx->remap));
+    ctx->wedge = RL_MALLOC(vertexCount * sizeof(*ctx->wedge));
+    ctx->openIn = RL_MALLOC(vertexCount * sizeof(*ctx->openIn));
+    ctx->openOut = RL_MALLOC(vertexCount * sizeof(*ctx->openOut));
+    ctx->kind = RL_MALLOC(vertexCount * sizeof(*ctx->kind));
+    ctx->offsets = RL_MALLOC((vertexCount + 1) * sizeof(*ctx->offsets));
+    ctx->triangles = RL_MALLOC(indexCount * sizeof(*ctx->triangles));
+    ctx->quadrics = RL_CALLOC(vertexCount, sizeof(*ctx->quadrics));
+    ctx->collapses = RL_MALLOC(indexCount * sizeof(*ctx->collapses));
+    ctx->collapseRemap = RL_MALLOC(vertexCount * sizeof(*ctx->collapseRemap));
+    ctx->collapseLocked = RL_MALLOC(vertexCount * sizeof(*ctx->collapseLocked));
+
+    if (!ctx->positions || !ctx->remap || !ctx->wedge || !ctx->openIn || !ctx->openOut || !ctx->kind ||
+        !ctx->offsets || !ctx->triangles || !ctx->quadrics || !ctx->collapses || !ctx->collapseRemap || !ctx->collapseLocked) {
+        simplify_free_context(ctx);
+        return false;
+    }
+
+    return true;
+}
+
+static uint32_t simplify_hash_position(Vector3 p)
+{
+    uint32_t h[3];
+    memcpy(h, &p, sizeof(h));
+
+    /* Fold negative zeros, they compare equal to positive ones */
+    for (int i = 0; i < 3; i++) {
+        if ((h[i] << 1) == 0) h[i] = 0;
+    }
+
+    return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+}
+
+static uint32_t simplify_hash_vertex(const R3D_Vertex* vertex)
+{
+    const uint8_t* bytes = (const uint8_t*)vertex;
+    uint32_t h = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(*vertex); i++) {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+/*
+ * Maps every vertex to the first one with the same position, or with the
+ * same attributes when 'exact' is set. Returns false on allocation failure.
+ */
+static bool simplify_build_remap(const R3D_Vertex* vertices, int vertexCount, uint32_t* remap, bool exact)
+{
+    uint32_t tableSize = 1;
+    while (tableSize < 2 * (uint32_t)vertexCount) {
+        tableSize <<= 1;
+    }
+
+    uint32_t* table = RL_MALLOC(tableSize * sizeof(uint32_t));
+    if (table == NULL) return false;
+
+    memset(table, 0xFF, tableSize * sizeof(uint32_t));
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        const R3D_Vertex* vertex = &vertices[v];
+
+        uint32_t hash = exact ? simplify_hash_vertex(vertex) : simplify_hash_position(vertex->position);
+        uint32_t slot = hash & (tableSize - 1);
+
+        for (;;) {
+            uint32_t entry = table[slot];
+            if (entry == UINT32_MAX) {
+                table[slot] = v;
+                remap[v] = v;
+                break;
+            }
+            const R3D_Vertex* other = &vertices[entry];
+            bool equal = exact ? (memcmp(other, vertex, sizeof(*vertex)) == 0) : (
+                other->position.x == vertex->position.x &&
+                other->position.y == vertex->position.y &&
+                other->position.z == vertex->position.z
+            );
+            if (equal) {
+                remap[v] = entry;
+                break;
+            }
+            slot = (slot + 1) & (tableSize - 1);
+        }
+    }
+
+    RL_FREE(table);
+
+    return true;
+}
+
+static void simplify_build_adjacency(simplify_context_t* ctx, const uint32_t* indices, int indexCount, int vertexCount)
+{
+    uint32_t* offsets = ctx->offsets;
+
+    memset(offsets, 0, (vertexCount + 1) * sizeof(uint32_t));
+
+    for (int i = 0; i < indexCount; i++) {
+        offsets[indices[i]]++;
+    }
+
+    uint32_t sum = 0;
+    for (int v = 0; v < vertexCount; v++) {
+        uint32_t count = offsets[v];
+        offsets[v] = sum;
+        sum += count;
+    }
+
+    for (int i = 0; i < indexCount; i++) {
+        ctx->triangles[offsets[indices[i]]++] = i / 3;
+    }
+
+    /* Each offset now points to the end of its vertex, shift them back */
+    memmove(offsets + 1, offsets, vertexCount * sizeof(uint32_t));
+    offsets[0] = 0;
+}
+
+static bool simplify_has_edge(const simplify_context_t* ctx, const uint32_t* indices, uint32_t a, uint32_t b)
+{
+    for (uint32_t i = ctx->offsets[a]; i < ctx->offsets[a + 1]; i++) {
+        const uint32_t* tri = &indices[3 * ctx->triangles[i]];
+        if ((tri[0] == a && tri[1] == b) || (tri[1] == a && tri[2] == b) || (tri[2] == a && tri[0] == b)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool simplify_has_position_edge(const simplify_context_t* ctx, const uint32_t* indices, uint32_t a, uint32_t b)
+{
+    uint32_t wa = a;
+    do {
+        uint32_t wb = b;
+        do {
+            if (simplify_has_edge(ctx, indices, wa, wb)) return true;
+            wb = ctx->wedge[wb];
+        } while (wb != b);
+        wa = ctx->wedge[wa];
+    } while (wa != a);
+
+    return false;
+}
+
+/*
+ * Links the referenced vertices sharing a position, then finds the open edges
+ * of each vertex and derives the way it is allowed to collapse.
+ */
+static void simplify_classify_vertices(simplify_context_t* ctx, const uint32_t* indices, int vertexCount)
+{
+    uint32_t* first = ctx->collapseRemap;
+
+    for (int v = 0; v < vertexCount; v++) {
+        first[v] = SIMPLIFY_NONE;
+        ctx->wedge[v] = v;
+    }
+
+    for (int v = 0; v < vertexCount; v++) {
+        if (ctx->offsets[v] == ctx->offsets[v + 1]) continue;
+        uint32_t r = ctx->remap[v];
+        if (first[r] == SIMPLIFY_NONE) {
+            first[r] = v;
+        }
+        else {
+            ctx->wedge[v] = ctx->wedge[first[r]];
+            ctx->wedge[first[r]] = v;
+        }
+    }
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        uint32_t openIn = SIMPLIFY_NONE;
+        uint32_t openOut = SIMPLIFY_NONE;
+
+        for (uint32_t i = ctx->offsets[v]; i < ctx->offsets[v + 1]; i++)
+        {
+            const uint32_t* tri = &indices[3 * ctx->triangles[i]];
+            int k = (tri[0] == (uint32_t)v) ? 0 : (tri[1] == (uint32_t)v) ? 1 : 2;
+
+            uint32_t next = tri[(k + 1) % 3];
+            uint32_t prev = tri[(k + 2) % 3];
+
+            if (!simplify_has_edge(ctx, indices, next, v)) {
+                openOut = (openOut == SIMPLIFY_NONE) ? next : SIMPLIFY_MANY;
+            }
+            if (!simplify_has_edge(ctx, indices, v, prev)) {
+                openIn = (openIn == SIMPLIFY_NONE) ? prev : SIMPLIFY_MANY;
+            }
+        }
+
+        ctx->openIn[v] = openIn;
+        ctx->openOut[v] = openOut;
+    }
+
+    for (int v = 0; v < vertexCount; v++)
+    {
+        uint32_t openIn = ctx->openIn[v];
+        uint32_t openOut = ctx->openOut[v];
+        uint32_t w = ctx->wedge[v];
+
+        simplify_kind_t kind = SIMPLIFY_LOCKED;
+
+        if (w == (uint32_t)v) {
+            if (openIn == SIMPLIFY_NONE && openOut == SIMPLIFY_NONE) {
+                kind = SIMPLIFY_MANIFOLD;
+            }
+            /* The open edges must also be open between positions, or the vertex ends a seam */
+            else if (openIn < SIMPLIFY_MANY && openOut < SIMPLIFY_MANY &&
+                     !simplify_has_position_edge(ctx, indices, openOut, v) &&
+                     !simplify_has_position_edge(ctx, indices, v, openIn)) {
+                kind = SIMPLIFY_BORDER;
+            }
+        }
+        else if (ctx->wedge[w] == (uint32_t)v) {
+            /* Both sides of a seam must close each other */
+            uint32_t wIn = ctx->openIn[w];
+            uint32_t wOut = ctx->openOut[w];
+            if (openIn < SIMPLIFY_MANY && openOut < SIMPLIFY_MANY && wIn < SIMPLIFY_MANY && wOut < SIMPLIFY_MANY &&
+                ctx->remap[openOut] == ctx->remap[wIn] && ctx->remap[openIn] == ctx->remap[wOut]) {
+                kind = SIMPLIFY_SEAM;
+            }
+        }
+
+        ctx->kind[v] = (uint8_t)kind;
+    }
+}
+
+static void simplify_quadric_add_plane(simplify_quadric_t* q, Vector3 n, float d, double w)
+{
+    q->a00 += w * n.x * n.x;
+    q->a11 += w * n.y * n.y;
+    q->a22 += w * n.z * n.z;
+    q->a01 += w * n.x * n.y;
+    q->a02 += w * n.x * n.z;
+    q->a12 += w * n.y * n.z;
+    q->b0 += w * n.x * d;
+    q->b1 += w * n.y * d;
+    q->b2 += w * n.z * d;
+    q->c += w * d * d;
+    q->w += w;
+}
+
+static void simplify_quadric_add(simplify_quadric_t* dst, const simplify_quadric_t* src)
+{
+    dst->a00 += src->a00;
+    dst->a11 += src->a11;
+    dst->a22 += src->a22;
+    dst->a01 += src->a01;
+    dst->a02 += src->a02;
+    dst->a12 += src->a12;
+    dst->b0 += src->b0;
+    dst->b1 += src->b1;
+    dst->b2 += src->b2;
+    dst->c += src->c;
+    dst->w += src->w;
+}
+
+static float simplify_quadric_error(const simplify_quadric_t* q, Vector3 p)
+{
+    double e = q->a00 * p.x * p.x + q->a11 * p.y * p.y + q->a22 * p.z * p.z
+             + 2.0 * (q->a01 * p.x * p.y + q->a02 * p.x * p.z + q->a12 * p.y * p.z)
+             + 2.0 * (q->b0 * p.x + q->b1 * p.y + q->b2 * p.z)
+             + q->c;
+
+    return (float)(fabs(e) / ((q->w > 0.0) ? q->w : 1.0));
+}
+
+static void simplify_build_quadrics(simplify_context_t* ctx, const uint32_t* indices, int indexCount)
+{
+    for (int i = 0; i < indexCount; i += 3)
+    {
+        const uint32_t* tri = &indices[i];
+
+        Vector3 p0 = ctx->positions[tri[0]];
+        Vector3 p1 = ctx->positions[tri[1]];
+        Vector3 p2 = ctx->positions[tri[2]];
+
+        Vector3 normal = Vector3CrossProduct(Vector3Subtract(p1, p0), Vector3Subtract(p2, p0));
+        float length = Vector3Length(normal);
+        if (length <= 0.0f) continue;
+
+        normal = Vector3Scale(normal, 1.0f / length);
+        float d = -Vector3DotProduct(normal, p0);
+
+        for (int k = 0; k < 3; k++) {
+            simplify_quadric_add_plane(&ctx->quadrics[ctx->remap[tri[k]]], normal, d, 0.5 * length);
+        }
+
+        /* Open edges also get a plane orthogonal to their triangle, so that borders and seams keep their shape */
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t a = tri[k];
+            uint32_t b = tri[(k + 1) % 3];
+            if (simplify_has_edge(ctx, indices, b, a)) continue;
+
+            Vector3 edge = Vector3Subtract(ctx->positions[b], ctx->positions[a]);
+            Vector3 edgeNormal = Vector3CrossProduct(edge, normal);
+            float edgeLength = Vector3Length(edgeNormal);
+            if (edgeLength <= 0.0f) continue;
+
+            edgeNormal = Vector3Scale(edgeNormal, 1.0f / edgeLength);
+            float edgeD = -Vector3DotProduct(edgeNormal, ctx->positions[a]);
+            double weight = SIMPLIFY_EDGE_WEIGHT * edgeLength * edgeLength;
+
+            simplify_quadric_add_plane(&ctx->quadrics[ctx->remap[a]], edgeNormal, edgeD, weight);
+            simplify_quadric_add_plane(&ctx->quadrics[ctx->remap[b]], edgeNormal, edgeD, weight);
+        }
+    }
+}
+
+static bool simplify_can_collapse(const simplify_context_t* ctx, uint32_t source, uint32_t target)
+{
+    simplify_kind_t sourceKind = ctx->kind[source];
+    simplify_kind_t targetKind = ctx->kind[target];
+
+    bool alongOpenEdge = (ctx->openOut[source] == target || ctx->openIn[source] == target);
+
+    switch (sourceKind) {
+    case SIMPLIFY_MANIFOLD:
+        return true;
+    case SIMPLIFY_BORDER:
+        return alongOpenEdge && (targetKind == SIMPLIFY_BORDER || targetKind == SIMPLIFY_LOCKED);
+    case SIMPLIFY_SEAM:
+        return alongOpenEdge && (targetKind == SIMPLIFY_SEAM || targetKind == SIMPLIFY_LOCKED);
+    default:
+        break;
+    }
+
+    return false;
+}
+
+/*
+ * Returns the vertex receiving the other side of a seam collapsed from 'source' to 'target'.
+ * The other side follows its own open edge leading to the position of 'target'.
+ */
+static uint32_t simplify_seam_target(const simplify_context_t* ctx, uint32_t source, uint32_t target)
+{
+    uint32_t other = ctx->wedge[source];
+    uint32_t otherTarget = (ctx->openOut[source] == target) ? ctx->openIn[other] : ctx->openOut[other];
+
+    if (otherTarget >= SIMPLIFY_MANY || ctx->remap[otherTarget] != ctx->remap[target]) {
+        return SIMPLIFY_NONE;
+    }
+
+    return otherTarget;
+}
+
+static bool simplify_has_triangle_flip(const simplify_context_t* ctx, const uint32_t* indices, uint32_t source, uint32_t target)
+{
+    Vector3 ps = ctx->positions[source];
+    Vector3 pt = ctx->positions[target];
+    uint32_t rt = ctx->remap[target];
+
+    for (uint32_t i = ctx->offsets[source]; i < ctx->offsets[source + 1]; i++)
+    {
+        const uint32_t* tri = &indices[3 * ctx->triangles[i]];
+        int k = (tri[0] == source) ? 0 : (tri[1] == source) ? 1 : 2;
+
+        uint32_t b = tri[(k + 1) % 3];
+        uint32_t c = tri[(k + 2) % 3];
+
+        /* Triangles sharing the collapsed edge disappear */
+        if (ctx->remap[b] == rt || ctx->remap[c] == rt) continue;
+
+        Vector3 pb = ctx->positions[b];
+        Vector3 pc = ctx->positions[c];
+
+        Vector3 n0 = Vector3CrossProduct(Vector3Subtract(pb, ps), Vector3Subtract(pc, ps));
+        Vector3 n1 = Vector3CrossProduct(Vector3Subtract(pb, pt), Vector3Subtract(pc, pt));
+
+        if (Vector3DotProduct(n0, n1) <= 0.0f) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void simplify_lock_ring(simplify_context_t* ctx, const uint32_t* indices, uint32_t vertex)
+{
+    uint32_t w = vertex;
+    do {
+        for (uint32_t i = ctx->offsets[w]; i < ctx->offsets[w + 1]; i++) {
+            const uint32_t* tri = &indices[3 * ctx->triangles[i]];
+            ctx->collapseLocked[ctx->remap[tri[0]]] = 1;
+            ctx->collapseLocked[ctx->remap[tri[1]]] = 1;
+            ctx->collapseLocked[ctx->remap[tri[2]]] = 1;
+        }
+        w = ctx->wedge[w];
+    } while (w != vertex);
+}
+
+static int simplify_compare_collapses(const void* a, const void* b)
+{
+    float ea = ((const simplify_collapse_t*)a)->error;
+    float eb = ((const simplify_collapse_t*)b)->error;
+    return (ea > eb) - (ea < eb);
+}
+
+/*
+ * Collects the allowed collapses of every edge, keeping the cheapest direction.
+ * Returns the number of candidates written in 'collapses'.
+ */
+static int simplify_pick_collapses(simplify_context_t* ctx, const uint32_t* indices, int indexCount)
+{
+    int count = 0;
+
+    for (int i = 0; i < indexCount; i++)
+    {
+        uint32_t a = indices[i];
+        uint32_t b = indices[(i % 3 == 2) ? i - 2 : i + 1];
+
+        /* Interior edges are seen from both of their triangles, keep one of them */
+        if (ctx->kind[a] == SIMPLIFY_MANIFOLD && ctx->kind[b] == SIMPLIFY_MANIFOLD && ctx->remap[a] > ctx->remap[b]) {
+            continue;
+        }
+
+        simplify_collapse_t collapse = { SIMPLIFY_NONE, SIMPLIFY_NONE, FLT_MAX };
+
+        if (simplify_can_collapse(ctx, a, b)) {
+            collapse = (simplify_collapse_t) { a, b, simplify_quadric_error(&ctx->quadrics[ctx->remap[a]], ctx->positions[b]) };
+        }
+
+        if (simplify_can_collapse(ctx, b, a)) {
+            float error = simplify_quadric_error(&ctx->quadrics[ctx->remap[b]], ctx->positions[a]);
+            if (error < collapse.error) {
+                collapse = (simplify_collapse_t) { b, a, error };
+            }
+        }
+
+        if (collapse.source != SIMPLIFY_NONE) {
+            ctx->collapses[count++] = collapse;
+        }
+    }
+
+    qsort(ctx->collapses, count, sizeof(*ctx->collapses), simplify_compare_collapses);
+
+    return count;
+}
+
+/*
+ * Performs the cheapest collapses of the pass that do not touch each other.
+ * Returns the estimated number of triangles removed.
+ */
+static int simplify_perform_collapses(simplify_context_t* ctx, const uint32_t* indices, int collapseCount,
+                                      int vertexCount, int triangleGoal, float errorLimit, float* maxError)
+{
+    for (int v = 0; v < vertexCount; v++) {
+        ctx->collapseRemap[v] = v;
+        ctx->collapseLocked[v] = 0;
+    }
+
+    /* Bounds the error of the pass from the collapse expected to reach its goal */
+    int goalIndex = (triangleGoal < collapseCount) ? triangleGoal : collapseCount - 1;
+    float passLimit = ctx->collapses[goalIndex].error * SIMPLIFY_PASS_BOUND;
+    if (passLimit > errorLimit) passLimit = errorLimit;
+
+    int removed = 0;
+
+    for (int i = 0; i < collapseCount && removed < triangleGoal; i++)
+    {
+        const simplify_collapse_t* collapse = &ctx->collapses[i];
+        if (collapse->error > passLimit) break;
+
+        uint32_t source = collapse->source;
+        uint32_t target = collapse->target;
+
+        if (ctx->collapseLocked[ctx->remap[source]] || ctx->collapseLocked[ctx->remap[target]]) {
+            continue;
+        }
+
+        uint32_t seamSource = SIMPLIFY_NONE;
+        uint32_t seamTarget = SIMPLIFY_NONE;
+
+        if (ctx->kind[source] == SIMPLIFY_SEAM) {
+            seamSource = ctx->wedge[source];
+            seamTarget = simplify_seam_target(ctx, source, target);
+            if (seamTarget == SIMPLIFY_NONE) continue;
+        }
+
+        if (simplify_has_triangle_flip(ctx, indices, source, target)) continue;
+        if (seamSource != SIMPLIFY_NONE && simplify_has_triangle_flip(ctx, indices, seamSource, seamTarget)) continue;
+
+        ctx->collapseRemap[source] = target;
+        if (seamSource != SIMPLIFY_NONE) {
+            ctx->collapseRemap[seamSource] = seamTarget;
+        }
+
+        simplify_lock_ring(ctx, indices, source);
+        simplify_quadric_add(&ctx->quadrics[ctx->remap[target]], &ctx->quadrics[ctx->remap[source]]);
+
+        removed += (ctx->kind[source] == SIMPLIFY_BORDER) ? 1 : 2;
+
+        if (collapse->error > *maxError) {
+            *maxError = collapse->error;
+        }
+    }
+
+    return removed;
+}
+
+/*
+ * Applies the collapses of the pass and removes the triangles that became degenerate.
+ * Returns the new number of indices.
+ */
+static int simplify_remap_indices(const simplify_context_t* ctx, uint32_t* indices, int indexCount)
+{
+    int count = 0;
+
+    for (int i = 0; i < indexCount; i += 3)
+    {
+        uint32_t a = ctx->collapseRemap[indices[i + 0]];
+        uint32_t b = ctx->collapseRemap[indices[i + 1]];
+        uint32_t c = ctx->collapseRemap[indices[i + 2]];
+
+        uint32_t ra = ctx->remap[a];
+        uint32_t rb = ctx->remap[b];
+        uint32_t rc = ctx->remap[c];
+
+        if (ra == rb || rb == rc || rc == ra) continue;
+
+        indices[count++] = a;
+        indices[count++] = b;
+        indices[count++] = c;
+    }
+
+    return count;
+}
+
+// ========================================
+// MESH TANGENT FRAME (INTERNAL)
+// ========================================
+
+#define FRAME_CHUNK_SIZE        4096    //< Triangles or vertices claimed at once by a thread
+#define FRAME_PARALLEL_MIN      32768   //< Elements below which the work stays on the calling thread
+#define FRAME_MAX_THREADS       64
+
+typedef void (*frame_kernel_t)(void* user, int begin, int end);
+
+typedef struct {
+    frame_kernel_t kernel;
+    void* user;
+    int count;
+    atomic_int next;
+} frame_dispatch_t;
+
+/*
+ * Per triangle vectors accumulated into the vertices, stored as structure of arrays.
+ * Each vertex then sums the vectors of its own triangles through the adjacency,
+ * in triangle order, so no two threads ever write the same vertex.
+ */
+typedef struct {
+    R3D_MeshData* mesh;
+    int triangleCount;
+    float* face[6];                 //< x, y, z of the normal, or of the tangent then the bitangent
+    int* adjOffsets;                //< First entry in 'adjTriangles' of each vertex, plus the end
+    int* adjTriangles;              //< Triangles of each vertex, one entry per corner
+} frame_context_t;
+
+static int frame_worker(void* arg)
+{
+    frame_dispatch_t* dispatch = (frame_dispatch_t*)arg;
+
+    int begin;
+    while ((begin = atomic_fetch_add(&dispatch->next, FRAME_CHUNK_SIZE)) < dispatch->count) {
+        int end = (begin + FRAME_CHUNK_SIZE < dispatch->count) ? begin + FRAME_CHUNK_SIZE : dispatch->count;
+        dispatch->kernel(dispatch->user, begin, end);
+    }
+
+    return 0;
+}
+
+// Runs the kernel over [0, count) in chunks, the calling thread takes its share
+static void frame_dispatch(frame_kernel_t kernel, void* user, int count)
+{
+    frame_dispatch_t dispatch = { .kernel = kernel, .user = user, .count = count };
+    atomic_init(&dispatch.next, 0);
+
+    int numChunks = (count + FRAME_CHUNK_SIZE - 1) / FRAME_CHUNK_SIZE;
+    // Already on a thread of a parallel job (e.g. the mesh conversion of the importer), the work stays here
+    int numThreads = (count >= FRAME_PARALLEL_MIN && !r3d_cpu_is_worker()) ? r3d_cpu_count() - 1 : 0;
+    if (numThreads > numChunks - 1) numThreads = numChunks - 1;
+    if (numThreads > FRAME_MAX_THREADS) numThreads = FRAME_MAX_THREADS;
+
+    thrd_t threads[FRAME_MAX_THREADS];
+
+    int launched = 0;
+    for (int i = 0; i < numThreads; i++) {
+        if (thrd_create(&threads[launched], frame_worker, &dispatch) == thrd_success) {
+            launched++;
+        }
+    }
+
+    frame_worker(&dispatch);
+
+    for (int i = 0; i < launched; i++) {
+        thrd_join(threads[i], NULL);
+    }
+}
+
+static inline uint32_t frame_corner(const R3D_MeshData* mesh, int triangle, int corner)
+{
+    int i = 3 * triangle + corner;
+    return (mesh->indexCount > 0 && mesh->indices != NULL) ? mesh->indices[i] : (uint32_t)i;
+}
+
+static bool frame_build_adjacency(frame_context_t* ctx)
+{
+    const R3D_MeshData* mesh = ctx->mesh;
+    int cornerCount = 3 * ctx->triangleCount;
+
+    ctx->adjOffsets = RL_CALLOC(mesh->vertexCount + 1, sizeof(int));
+    ctx->adjTriangles = RL_MALLOC(cornerCount * sizeof(int));
+    if (ctx->adjOffsets == NULL || ctx->adjTriangles == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < cornerCount; i++) {
+        ctx->adjOffsets[frame_corner(mesh, i / 3, i % 3) + 1]++;
+    }
+
+    for (int v = 0; v < mesh->vertexCount; v++) {
+        ctx->adjOffsets[v + 1] += ctx->adjOffsets[v];
+    }
+
+    // The offsets are shifted by one vertex while filling, then restored
+    for (int i = 0; i < cornerCount; i++) {
+        uint32_t v = frame_corner(mesh, i / 3, i % 3);
+        ctx->adjTriangles[ctx->adjOffsets[v]++] = i / 3;
+    }
+
+    memmove(&ctx->adjOffsets[1], &ctx->adjOffsets[0], mesh->vertexCount * sizeof(int));
+    ctx->adjOffsets[0] = 0;
+
+    return true;
+}
+
+static bool frame_alloc_context(frame_context_t* ctx, R3D_MeshData* mesh, int numFace)
+{
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->mesh = mesh;
+    ctx->triangleCount = (mesh->indexCount > 0 && mesh->indices != NULL)
+        ? mesh->indexCount / 3 : mesh->vertexCount / 3;
+
+    for (int i = 0; i < numFace; i++) {
+        ctx->face[i] = RL_MALLOC((ctx->triangleCount + 4) * sizeof(float));
+        if (ctx->face[i] == NULL) return false;
+    }
+
+    return frame_build_adjacency(ctx);
+}
+
+static void frame_free_context(frame_context_t* ctx)
+{
+    for (int i = 0; i < 6; i++) {
+        RL_FREE(ctx->face[i]);
+    }
+    RL_FREE(ctx->adjOffsets);
+    RL_FREE(ctx->adjTriangles);
+}
+
+/*
+ * Gathers the edges and the texcoord deltas of four triangles into lanes.
+ * The lanes past 'end' repeat the last triangle, their results are written
+ * in the padding of the face arrays.
+ */
+static void frame_gather(const frame_context_t* ctx, int t, int end, bool texcoords,
+                         float e[6][4], float duv[4][4])
+{
+    const R3D_Vertex* vertices = ctx->mesh->vertices;
+
+    for (int l = 0; l < 4; l++)
+    {
+        int tri = (t + l < end) ? t + l : end - 1;
+
+        const R3D_Vertex* v0 = &vertices[frame_corner(ctx->mesh, tri, 0)];
+        const R3D_Vertex* v1 = &vertices[frame_corner(ctx->mesh, tri, 1)];
+        const R3D_Vertex* v2 = &vertices[frame_corner(ctx->mesh, tri, 2)];
+
+        e[0][l] = v1->position.x - v0->position.x;
+        e[1][l] = v1->position.y - v0->position.y;
+        e[2][l] = v1->position.z - v0->position.z;
+        e[3][l] = v2->position.x - v0->position.x;
+        e[4][l] = v2->position.y - v0->position.y;
+        e[5][l] = v2->position.z - v0->position.z;
+
+        if (texcoords) {
+            duv[0][l] = v1->texcoord.x - v0->texcoord.x;
+            duv[1][l] = v1->texcoord.y - v0->texcoord.y;
+            duv[2][l] = v2->texcoord.x - v0->texcoord.x;
+            duv[3][l] = v2->texcoord.y - v0->texcoord.y;
+        }
+    }
+}
+
+// Computes the unnormalized normal of the triangles in [begin, end)
+static void frame_face_normals(void* user, int begin, int end)
+{
+    frame_context_t* ctx = (frame_context_t*)user;
+    float* nx = ctx->face[0];
+    float* ny = ctx->face[1];
+    float* nz = ctx->face[2];
+
+    for (int t = begin; t < end; t += 4)
+    {
+        float e[6][4], duv[4][4];
+        frame_gather(ctx, t, end, false, e, duv);
+
+    #if defined(R3D_HAS_SSE)
+        __m128 e1x = _mm_loadu_ps(e[0]), e1y = _mm_loadu_ps(e[1]), e1z = _mm_loadu_ps(e[2]);
+        __m128 e2x = _mm_loadu_ps(e[3]), e2y = _mm_loadu_ps(e[4]), e2z = _mm_loadu_ps(e[5]);
+        _mm_storeu_ps(&nx[t], _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)));
+        _mm_storeu_ps(&ny[t], _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)));
+        _mm_storeu_ps(&nz[t], _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+    #elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+        float32x4_t e1x = vld1q_f32(e[0]), e1y = vld1q_f32(e[1]), e1z = vld1q_f32(e[2]);
+        float32x4_t e2x = vld1q_f32(e[3]), e2y = vld1q_f32(e[4]), e2z = vld1q_f32(e[5]);
+        vst1q_f32(&nx[t], vsubq_f32(vmulq_f32(e1y, e2z), vmulq_f32(e1z, e2y)));
+        vst1q_f32(&ny[t], vsubq_f32(vmulq_f32(e1z, e2x), vmulq_f32(e1x, e2z)));
+        vst1q_f32(&nz[t], vsubq_f32(vmulq_f32(e1x, e2y), vmulq_f32(e1y, e2x)));
+    #else
+        for (int l = 0; l < 4; l++) {
+            nx[t + l] = e[1][l] * e[5][l] - e[2][l] * e[4][l];
+            ny[t + l] = e[2][l] * e[3][l] - e[0][l] * e[5][l];
+            nz[t + l] = e[0][l] * e[4][l] - e[1][l] * e[3][l];
+        }
+    #endif
+    }
+}
+
+// Computes the unnormalized tangent and bitangent of the triangles in [begin, end)
+static void frame_face_tangents(void* user, int begin, int end)
+{
+    frame_context_t* ctx = (frame_context_t*)user;
+
+    for (int t = begin; t < end; t += 4)
+    {
+        float e[6][4], duv[4][4], invDet[4];
+        frame_gather(ctx, t, end, true, e, duv);
+
+        // Triangles with collinear UVs contribute nothing
+        for (int l = 0; l < 4; l++) {
+            float det = duv[0][l] * duv[3][l] - duv[2][l] * duv[1][l];
+            invDet[l] = (fabsf(det) < 1e-6f) ? 0.0f : 1.0f / det;
+        }
+
+    #if defined(R3D_HAS_SSE)
+        __m128 s = _mm_loadu_ps(invDet);
+        __m128 du1 = _mm_mul_ps(_mm_loadu_ps(duv[0]), s), dv1 = _mm_mul_ps(_mm_loadu_ps(duv[1]), s);
+        __m128 du2 = _mm_mul_ps(_mm_loadu_ps(duv[2]), s), dv2 = _mm_mul_ps(_mm_loadu_ps(duv[3]), s);
+        for (int c = 0; c < 3; c++) {
+            __m128 e1 = _mm_loadu_ps(e[c]), e2 = _mm_loadu_ps(e[c + 3]);
+            _mm_storeu_ps(&ctx->face[c][t], _mm_sub_ps(_mm_mul_ps(dv2, e1), _mm_mul_ps(dv1, e2)));
+            _mm_storeu_ps(&ctx->face[c + 3][t], _mm_sub_ps(_mm_mul_ps(du1, e2), _mm_mul_ps(du2, e1)));
+        }
+    #elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+        float32x4_t s = vld1q_f32(invDet);
+        float32x4_t du1 = vmulq_f32(vld1q_f32(duv[0]), s), dv1 = vmulq_f32(vld1q_f32(duv[1]), s);
+        float32x4_t du2 = vmulq_f32(vld1q_f32(duv[2]), s), dv2 = vmulq_f32(vld1q_f32(duv[3]), s);
+        for (int c = 0; c < 3; c++) {
+            float32x4_t e1 = vld1q_f32(e[c]), e2 = vld1q_f32(e[c + 3]);
+            vst1q_f32(&ctx->face[c][t], vsubq_f32(vmulq_f32(dv2, e1), vmulq_f32(dv1, e2)));
+            vst1q_f32(&ctx->face[c + 3][t], vsubq_f32(vmulq_f32(du1, e2), vmulq_f32(du2, e1)));
+        }
+    #else
+        for (int l = 0; l < 4; l++) {
+            float du1 = duv[0][l] * invDet[l], dv1 = duv[1][l] * invDet[l];
+            float du2 = duv[2][l] * invDet[l], dv2 = duv[3][l] * invDet[l];
+            for (int c = 0; c < 3; c++) {
+                ctx->face[c][t + l] = dv2 * e[c][l] - dv1 * e[c + 3][l];
+                ctx->face[c + 3][t + l] = du1 * e[c + 3][l] - du2 * e[c][l];
+            }
+        }
+    #endif
+    }
+}
+
+// Sums the face vector 'first' to 'first + 2' of the triangles of a vertex
+static inline Vector3 frame_sum_faces(const frame_context_t* ctx, int vertex, int first)
+{
+    Vector3 sum = { 0 };
+
+    for (int i = ctx->adjOffsets[vertex]; i < ctx->adjOffsets[vertex + 1]; i++) {
+        int t = ctx->adjTriangles[i];
+        sum.x += ctx->face[first + 0][t];
+        sum.y += ctx->face[first + 1][t];
+        sum.z += ctx->face[first + 2][t];
+    }
+
+    return sum;
+}
+
+// Writes the normal of the vertices in [begin, end)
+static void frame_vertex_normals(void* user, int begin, int end)
+{
+    frame_context_t* ctx = (frame_context_t*)user;
+
+    for (int v = begin; v < end; v++) {
+        ctx->mesh->vertices[v].normal = Vector3Normalize(frame_sum_faces(ctx, v, 0));
+    }
+}
+
+// Writes the tangent of the vertices in [begin, end), orthogonalized (Gram-Schmidt) with its handedness
+static void frame_vertex_tangents(void* user, int begin, int end)
+{
+    frame_context_t* ctx = (frame_context_t*)user;
+
+    for (int v = begin; v < end; v++)
+    {
+        R3D_Vertex* vertex = &ctx->mesh->vertices[v];
+
+        Vector3 n = vertex->normal;
+        Vector3 t = frame_sum_faces(ctx, v, 0);
+        Vector3 b = frame_sum_faces(ctx, v, 3);
+
+        t = Vector3Subtract(t, Vector3Scale(n, Vector3DotProduct(n, t)));
+        float tLength = Vector3Length(t);
+        if (tLength > 1e-6f) {
+            t = Vector3Scale(t, 1.0f / tLength);
+        }
+        else {
+            // Fallback: generate an arbitrary tangent perpendicular to the normal
+            t = fabsf(n.x) < 0.9f ? (Vector3) {1.0f, 0.0f, 0.0f } : (Vector3) {0.0f, 1.0f, 0.0f };
+            t = Vector3Normalize(Vector3Subtract(t, Vector3Scale(n, Vector3DotProduct(n, t))));
+        }
+
+        float handedness = (Vector3DotProduct(Vector3CrossProduct(n, t), b) < 0.0f) ? -1.0f : 1.0f;
+        vertex->tangent = (Vector4) {t.x, t.y, t.z, handedness };
+    }
+}
+
+typedef struct {
+    R3D_MeshData* mesh;
+    Matrix rotation;
+} frame_rotate_t;
+
+// Rotates the position, normal and tangent of the vertices in [begin, end)
+static void frame_rotate_vertices(void* user, int begin, int end)
+{
+    frame_rotate_t* ctx = (frame_rotate_t*)user;
+
+    for (int i = begin; i < end; i++)
+    {
+        R3D_Vertex* vertex = &ctx->mesh->vertices[i];
+
+        vertex->position = r3d_vector3_transform_linear(vertex->position, &ctx->rotation);
+        vertex->normal = r3d_vector3_transform_linear(vertex->normal, &ctx->rotation);
+
+        // Preserve w component for handedness
+        Vector3 tangent = { vertex->tangent.x, vertex->tangent.y, vertex->tangent.z };
+        tangent = r3d_vector3_transform_linear(tangent, &ctx->rotation);
+
+        vertex->tangent.x = tangent.x;
+        vertex->tangent.y = tangent.y;
+        vertex->tangent.z = tangent.z;
+    }
+}
 
 // ========================================
 // PUBLIC API
@@ -1742,23 +3057,12 @@ void R3D_RotateMeshData(R3D_MeshData* meshData, Quaternion rotation)
 {
     if (meshData == NULL || meshData->vertices == NULL) return;
 
-    for (int i = 0; i < meshData->vertexCount; i++)
-    {
-        meshData->vertices[i].position = Vector3RotateByQuaternion(meshData->vertices[i].position, rotation);
-        meshData->vertices[i].normal = Vector3RotateByQuaternion(meshData->vertices[i].normal, rotation);
-
-        // Preserve w component for handedness
-        Vector3 tangentVec = (Vector3) {
-            meshData->vertices[i].tangent.x, 
-            meshData->vertices[i].tangent.y, 
-            meshData->vertices[i].tangent.z
-        };
-        tangentVec = Vector3RotateByQuaternion(tangentVec, rotation);
+    frame_rotate_t ctx = {
+        .mesh = meshData,
+        .rotation = QuaternionToMatrix(rotation)
+    };
 
-        meshData->vertices[i].tangent.x = tangentVec.x;
-        meshData->vertices[i].tangent.y = tangentVec.y;
-        meshData->vertices[i].tangent.z = tangentVec.z;
-    }
+    frame_dispatch(frame_rotate_vertices, &ctx, meshData->vertexCount);
 }
 
 void R3D_ScaleMeshData(R3D_MeshData* meshData, Vector3 scale)
@@ -1823,172 +3127,34 @@ void R3D_GenMeshDataNormals(R3D_MeshData* meshData)
 {
     if (meshData == NULL || meshData->vertices == NULL) return;
 
-    for (int i = 0; i < meshData->vertexCount; i++) {
-        meshData->vertices[i].normal = (Vector3) {0};
-    }
-
-    if (meshData->indexCount > 0 && meshData->indices != NULL) {
-        for (int i = 0; i < meshData->indexCount; i += 3)
-        {
-            uint32_t i0 = meshData->indices[i];
-            uint32_t i1 = meshData->indices[i + 1];
-            uint32_t i2 = meshData->indices[i + 2];
-
-            Vector3 v0 = meshData->vertices[i0].position;
-            Vector3 v1 = meshData->vertices[i1].position;
-            Vector3 v2 = meshData->vertices[i2].position;
-
-            Vector3 edge1 = Vector3Subtract(v1, v0);
-            Vector3 edge2 = Vector3Subtract(v2, v0);
-            Vector3 faceNormal = Vector3CrossProduct(edge1, edge2);
-
-            meshData->vertices[i0].normal = Vector3Add(meshData->vertices[i0].normal, faceNormal);
-            meshData->vertices[i1].normal = Vector3Add(meshData->vertices[i1].normal, faceNormal);
-            meshData->vertices[i2].normal = Vector3Add(meshData->vertices[i2].normal, faceNormal);
-        }
+    frame_context_t ctx;
+    if (!frame_alloc_context(&ctx, meshData, 3)) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate memory for normal calculation");
+        frame_free_context(&ctx);
+        return;
     }
-    else {
-        for (int i = 0; i < meshData->vertexCount; i += 3)
-        {
-            Vector3 v0 = meshData->vertices[i].position;
-            Vector3 v1 = meshData->vertices[i + 1].position;
-            Vector3 v2 = meshData->vertices[i + 2].position;
-
-            Vector3 edge1 = Vector3Subtract(v1, v0);
-            Vector3 edge2 = Vector3Subtract(v2, v0);
-            Vector3 faceNormal = Vector3CrossProduct(edge1, edge2);
 
-            meshData->vertices[i + 0].normal = Vector3Add(meshData->vertices[i + 0].normal, faceNormal);
-            meshData->vertices[i + 1].normal = Vector3Add(meshData->vertices[i + 1].normal, faceNormal);
-            meshData->vertices[i + 2].normal = Vector3Add(meshData->vertices[i + 2].normal, faceNormal);
-        }
-    }
+    frame_dispatch(frame_face_normals, &ctx, ctx.triangleCount);
+    frame_dispatch(frame_vertex_normals, &ctx, meshData->vertexCount);
 
-    for (int i = 0; i < meshData->vertexCount; i++) {
-        meshData->vertices[i].normal = Vector3Normalize(meshData->vertices[i].normal);
-    }
+    frame_free_context(&ctx);
 }
 
 void R3D_GenMeshDataTangents(R3D_MeshData* meshData)
 {
     if (meshData == NULL || meshData->vertices == NULL) return;
 
-    Vector3* bitangents = RL_CALLOC(meshData->vertexCount, sizeof(Vector3));
-    if (bitangents == NULL) {
+    frame_context_t ctx;
+    if (!frame_alloc_context(&ctx, meshData, 6)) {
         TraceLog(LOG_ERROR, "R3D: Failed to allocate memory for tangent calculation");
+        frame_free_context(&ctx);
         return;
     }
 
-    for (int i = 0; i < meshData->vertexCount; i++) {
-        meshData->vertices[i].tangent = (Vector4) {0};
-    }
-
-    #define PROCESS_TRIANGLE(i0, i1, i2)                                \
-    do {                                                                \
-        Vector3 v0 = meshData->vertices[i0].position;                   \
-        Vector3 v1 = meshData->vertices[i1].position;                   \
-        Vector3 v2 = meshData->vertices[i2].position;                   \
-                                                                        \
-        Vector2 uv0 = meshData->vertices[i0].texcoord;                  \
-        Vector2 uv1 = meshData->vertices[i1].texcoord;                  \
-        Vector2 uv2 = meshData->vertices[i2].texcoord;                  \
-                                                                        \
-        Vector3 edge1 = Vector3Subtract(v1, v0);                        \
-        Vector3 edge2 = Vector3Subtract(v2, v0);                        \
-                                                                        \
-        Vector2 deltaUV1 = Vector2Subtract(uv1, uv0);                   \
-        Vector2 deltaUV2 = Vector2Subtract(uv2, uv0);                   \
-                                                                        \
-        float det = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;  \
-                                                                        \
-        /* Skip the degenerate cases (collinear UVs) */                 \
-        if (fabsf(det) < 1e-6f) {                                       \
-            break;                                                      \
-        }                                                               \
-                                                                        \
-        float invDet = 1.0f / det;                                      \
-                                                                        \
-        Vector3 tangent = {                                             \
-            invDet * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x),     \
-            invDet * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y),     \
-            invDet * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z)      \
-        };                                                              \
-                                                                        \
-        Vector3 bitangent = {                                           \
-            invDet * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x),    \
-            invDet * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y),    \
-            invDet * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z)     \
-        };                                                              \
-                                                                        \
-        meshData->vertices[i0].tangent.x += tangent.x;                  \
-        meshData->vertices[i0].tangent.y += tangent.y;                  \
-        meshData->vertices[i0].tangent.z += tangent.z;                  \
-                                                                        \
-        meshData->vertices[i1].tangent.x += tangent.x;                  \
-        meshData->vertices[i1].tangent.y += tangent.y;                  \
-        meshData->vertices[i1].tangent.z += tangent.z;                  \
-                                                                        \
-        meshData->vertices[i2].tangent.x += tangent.x;                  \
-        meshData->vertices[i2].tangent.y += tangent.y;                  \
-        meshData->vertices[i2].tangent.z += tangent.z;                  \
-                                                                        \
-        bitangents[i0].x += bitangent.x;                                \
-        bitangents[i0].y += bitangent.y;                                \
-        bitangents[i0].z += bitangent.z;                                \
-                                                                        \
-        bitangents[i1].x += bitangent.x;                                \
-        bitangents[i1].y += bitangent.y;                                \
-        bitangents[i1].z += bitangent.z;                                \
-                                                                        \
-        bitangents[i2].x += bitangent.x;                                \
-        bitangents[i2].y += bitangent.y;                                \
-        bitangents[i2].z += bitangent.z;                                \
-    } while(0);
-
-    if (meshData->indexCount > 0 && meshData->indices != NULL) {
-        for (int i = 0; i < meshData->indexCount; i += 3) {
-            PROCESS_TRIANGLE(
-                meshData->indices[i],
-                meshData->indices[i + 1],
-                meshData->indices[i + 2]
-            );
-        }
-    }
-    else {
-        for (int i = 0; i < meshData->vertexCount; i += 3) {
-            PROCESS_TRIANGLE(i, i + 1, i + 2);
-        }
-    }
-
-    #undef PROCESS_TRIANGLE
-
-    // Orthogonalization (Gram-Schmidt) and handedness calculation
-    for (int i = 0; i < meshData->vertexCount; i++)
-    {
-        Vector3 n = meshData->vertices[i].normal;
-        Vector3 t = {
-            meshData->vertices[i].tangent.x,
-            meshData->vertices[i].tangent.y,
-            meshData->vertices[i].tangent.z
-        };
-
-        // Gram-Schmidt orthogonalization
-        t = Vector3Subtract(t, Vector3Scale(n, Vector3DotProduct(n, t)));
-        float tLength = Vector3Length(t);
-        if (tLength > 1e-6f) {
-            t = Vector3Scale(t, 1.0f / tLength);
-        }
-        else {
-            // Fallback: generate an arbitrary tangent perpendicular to the normal
-            t = fabsf(n.x) < 0.9f ? (Vector3) {1.0f, 0.0f, 0.0f } : (Vector3) {0.0f, 1.0f, 0.0f };
-            t = Vector3Normalize(Vector3Subtract(t, Vector3Scale(n, Vector3DotProduct(n, t))));
-        }
-
-        float handedness = (Vector3DotProduct(Vector3CrossProduct(n, t), bitangents[i]) < 0.0f) ? -1.0f : 1.0f;
-        meshData->vertices[i].tangent = (Vector4) {t.x, t.y, t.z, handedness };
-    }
+    frame_dispatch(frame_face_tangents, &ctx, ctx.triangleCount);
+    frame_dispatch(frame_vertex_tangents, &ctx, meshData->vertexCount);
 
-    RL_FREE(bitangents);
+    frame_free_context(&ctx);
 }
 
 BoundingBox R3D_CalculateMeshDataBoundingBox(const R3D_MeshData* meshData)
@@ -2010,3 +3176,100 @@ BoundingBox R3D_CalculateMeshDataBoundingBox(const R3D_MeshData* meshData)
 
     return bounds;
 }
+
+int R3D_SimplifyMeshData(const R3D_MeshData* meshData, uint32_t* indices, int targetIndexCount, float targetError, float* resultError)
+{
+    if (resultError) *resultError = 0.0f;
+
+    if (meshData == NULL || meshData->vertices == NULL || meshData->vertexCount <= 0 || indices == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Cannot simplify null mesh data");
+        return 0;
+    }
+
+    int vertexCount = meshData->vertexCount;
+    int indexCount = (meshData->indices != NULL) ? meshData->indexCount : meshData->vertexCount;
+    indexCount -= indexCount % 3;
+
+    simplify_context_t ctx;
+    if (!simplify_alloc_context(&ctx, vertexCount, indexCount)) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate memory for mesh simplification");
+        return 0;
+    }
+
+    // Vertices with identical attributes are merged, so that they can collapse as one
+    if (!simplify_build_remap(meshData->vertices, vertexCount, ctx.collapseRemap, true) ||
+        !simplify_build_remap(meshData->vertices, vertexCount, ctx.remap, false)) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate memory for mesh simplification");
+        simplify_free_context(&ctx);
+        return 0;
+    }
+
+    for (int i = 0; i < indexCount; i++) {
+        uint32_t index = (meshData->indices != NULL) ? meshData->indices[i] : (uint32_t)i;
+        indices[i] = ctx.collapseRemap[index];
+    }
+
+    for (int v = 0; v < vertexCount; v++) {
+        ctx.collapseRemap[v] = v;
+    }
+
+    int count = simplify_remap_indices(&ctx, indices, indexCount);
+
+    // Errors are measured in the unit cube of the mesh, so the target is relative to its size
+    BoundingBox bounds = R3D_CalculateMeshDataBoundingBox(meshData);
+    Vector3 size = Vector3Subtract(bounds.max, bounds.min);
+    float extent = fmaxf(size.x, fmaxf(size.y, size.z));
+    float invExtent = (extent > 0.0f) ? 1.0f / extent : 1.0f;
+
+    for (int v = 0; v < vertexCount; v++) {
+        ctx.positions[v] = Vector3Scale(Vector3Subtract(meshData->vertices[v].position, bounds.min), invExtent);
+    }
+
+    simplify_build_adjacency(&ctx, indices, count, vertexCount);
+    simplify_build_quadrics(&ctx, indices, count);
+
+    float errorLimit = targetError * targetError;
+    float maxError = 0.0f;
+
+    while (count > targetIndexCount)
+    {
+        simplify_build_adjacency(&ctx, indices, count, vertexCount);
+        simplify_classify_vertices(&ctx, indices, vertexCount);
+
+        int collapseCount = simplify_pick_collapses(&ctx, indices, count);
+        if (collapseCount == 0) break;
+
+        int triangleGoal = (count - targetIndexCount + 2) / 3;
+        int removed = simplify_perform_collapses(&ctx, indices, collapseCount, vertexCount, triangleGoal, errorLimit, &maxError);
+        if (removed == 0) break;
+
+        count = simplify_remap_indices(&ctx, indices, count);
+    }
+
+    simplify_free_context(&ctx);
+
+    // The remaining triangles are reordered like the ones of an optimized mesh
+    if (optimize_vertex_cache(indices, count, vertexCount)) {
+        optimize_overdraw(meshData->vertices, vertexCount, indices, count);
+    }
+
+    if (resultError) *resultError = sqrtf(maxError);
+
+    return count;
+}
+
+void R3D_OptimizeMeshData(R3D_MeshData* meshData)
+{
+    if (meshData == NULL || meshData->vertices == NULL) return;
+    if (meshData->indices == NULL || meshData->indexCount < 3) return;
+
+    int triangleIndexCount = meshData->indexCount - meshData->indexCount % 3;
+
+    bool success = optimize_vertex_cache(meshData->indices, triangleIndexCount, meshData->vertexCount);
+    success = success && optimize_overdraw(meshData->vertices, meshData->vertexCount, meshData->indices, triangleIndexCount);
+    success = success && optimize_vertex_fetch(meshData);
+
+    if (!success) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate memory for mesh optimization; The mesh is only partially optimized");
+    }
+}
@@ -11,22 +11,71 @@
 #include <r3d/r3d_model.h>
 #include <r3d/r3d_mesh.h>
 
+#include <tinycthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
 #include "./importer/r3d_importer.h"
 #include "./modules/r3d_cache.h"
 
+// ========================================
+// ASYNC REQUEST STATE
+// ========================================
+
+typedef enum {
+    REQUEST_STAGE_PARSING,      //< The loading thread imports the scene
+    REQUEST_STAGE_CONVERTING,   //< Textures can be uploaded, meshes are being converted
+    REQUEST_STAGE_UPLOADING,    //< The loading thread is done, the rest happens in R3D_PumpUploads()
+    REQUEST_STAGE_ABORTED,      //< The loading thread failed
+} request_stage_t;
+
+struct R3D_ModelRequest {
+    char* filePath;
+    thrd_t thread;
+    bool threadRunning;
+    atomic_int stage;
+
+    // Settings captured when the request is made
+    TextureFilter filter;
+    bool compressTextures;
+    bool streamTextures;
+    R3D_VertexFormat format;
+    int lodCount;
+
+    // Written by the loading thread until 'stage' leaves REQUEST_STAGE_PARSING
+    r3d_importer_t importer;
+    r3d_importer_texture_cache_t* textureCache;
+    r3d_importer_mesh_batch_t* meshBatch;
+    R3D_Model model;
+
+    R3D_ModelRequestStatus status;
+    int totalUploads;
+    int totalMeshes;            //< Meshes of the batch, all pending until 'stage' reaches REQUEST_STAGE_UPLOADING
+
+    R3D_ModelRequest* next;
+};
+
+static R3D_ModelRequest* g_requests = NULL;
+static const R3D_Model g_emptyModel = { 0 };
+
 // ========================================
 // INTERNAL FUNCTIONS
 // ========================================
 
 static bool import_model(r3d_importer_t* importer, R3D_Model* model)
 {
-    r3d_importer_texture_cache_t* textureCache = r3d_importer_load_texture_cache(importer, R3D_CACHE_GET(textureFilter));
+    r3d_importer_texture_cache_t* textureCache = r3d_importer_load_texture_cache(
+        importer, R3D_CACHE_GET(textureFilter), R3D_CACHE_GET(modelCompressTextures), R3D_CACHE_GET(modelStreamTextures)
+    );
     if (textureCache == NULL) {
         r3d_importer_destroy(importer);
         return false;
     }
 
-    if (!r3d_importer_load_meshes(importer, model)) {
+    R3D_VertexFormat format = R3D_CACHE_GET(modelCompactVertices)
+        ? R3D_VERTEX_FORMAT_COMPACT : R3D_VERTEX_FORMAT_FULL;
+
+    if (!r3d_importer_load_meshes(importer, model, R3D_CACHE_GET(modelLodCount), format)) {
         r3d_importer_destroy(importer);
         return false;
     }
@@ -37,10 +86,143 @@ static bool import_model(r3d_importer_t* importer, R3D_Model* model)
     }
 
     if (!r3d_importer_load_materials(importer, model, textureCache)) {
+        r3d_importer_unload_texture_cache(textureCache);
         r3d_importer_destroy(importer);
         return false;
     }
 
+    r3d_importer_unload_texture_cache(textureCache);
+
+    return true;
+}
+
+static int request_thread(void* arg)
+{
+    R3D_ModelRequest* request = arg;
+
+    if (!r3d_importer_create_from_file(&request->importer, request->filePath)) {
+        atomic_store(&request->stage, REQUEST_STAGE_ABORTED);
+        return 0;
+    }
+
+    request->textureCache = r3d_importer_begin_texture_cache(
+        &request->importer, request->filter, request->compressTextures, request->streamTextures
+    );
+    if (request->textureCache == NULL) {
+        atomic_store(&request->stage, REQUEST_STAGE_ABORTED);
+        return 0;
+    }
+
+    request->meshBatch = r3d_importer_begin_meshes(&request->importer, &request->model, request->lodCount);
+    if (request->meshBatch == NULL) {
+        atomic_store(&request->stage, REQUEST_STAGE_ABORTED);
+        return 0;
+    }
+
+    request->totalMeshes = r3d_importer_get_pending_mesh_count(request->meshBatch);
+    request->totalUploads = r3d_importer_get_pending_texture_count(request->textureCache)
+                          + request->totalMeshes;
+
+    // The textures decoded so far can be uploaded while the meshes are converted
+    atomic_store(&request->stage, REQUEST_STAGE_CONVERTING);
+    r3d_importer_convert_meshes(request->meshBatch);
+    atomic_store(&request->stage, REQUEST_STAGE_UPLOADING);
+
+    return 0;
+}
+
+static void request_join(R3D_ModelRequest* request)
+{
+    if (request->threadRunning) {
+        thrd_join(request->thread, NULL);
+        request->threadRunning = false;
+    }
+}
+
+static void request_release(R3D_ModelRequest* request)
+{
+    request_join(request);
+
+    if (request->meshBatch != NULL) {
+        r3d_importer_end_meshes(request->meshBatch, &request->model);
+        request->meshBatch = NULL;
+    }
+
+    if (request->textureCache != NULL) {
+        r3d_importer_unload_texture_cache(request->textureCache);
+        request->textureCache = NULL;
+    }
+
+    R3D_UnloadModel(&request->model, true);
+    memset(&request->model, 0, sizeof(request->model));
+
+    r3d_importer_destroy(&request->importer);
+}
+
+static bool request_finalize(R3D_ModelRequest* request)
+{
+    request_join(request);
+
+    r3d_importer_end_texture_cache(request->textureCache);
+
+    bool meshesLoaded = r3d_importer_end_meshes(request->meshBatch, &request->model);
+    request->meshBatch = NULL;
+
+    if (!meshesLoaded
+        || !r3d_importer_load_skeleton(&request->importer, &request->model.skeleton)
+        || !r3d_importer_load_materials(&request->importer, &request->model, request->textureCache)) {
+        return false;
+    }
+
+    r3d_importer_unload_texture_cache(request->textureCache);
+    request->textureCache = NULL;
+
+    r3d_importer_destroy(&request->importer);
+
+    return true;
+}
+
+/*
+ * Performs the next unit of work of a pending request
+ * Returns false when the request waits for its loading threads
+ */
+static bool request_pump(R3D_ModelRequest* request)
+{
+    int stage = atomic_load(&request->stage);
+
+    if (stage == REQUEST_STAGE_PARSING) {
+        return false;
+    }
+
+    if (stage == REQUEST_STAGE_ABORTED) {
+        TraceLog(LOG_WARNING, "R3D: Failed to load model '%s' asynchronously", request->filePath);
+        request_release(request);
+        request->status = R3D_MODEL_REQUEST_FAILED;
+        return true;
+    }
+
+    if (r3d_importer_upload_next_texture(request->textureCache, false)) {
+        return true;
+    }
+
+    // Meshes are uploaded once all are converted, the upload never waits this way
+    if (stage == REQUEST_STAGE_CONVERTING || r3d_importer_get_pending_texture_count(request->textureCache) > 0) {
+        return false;
+    }
+
+    if (r3d_importer_upload_next_mesh(request->meshBatch, &request->model, request->format)) {
+        return true;
+    }
+
+    if (request_finalize(request)) {
+        request->status = R3D_MODEL_REQUEST_READY;
+    }
+    else {
+        TraceLog(LOG_WARNING, "R3D: Failed to load model '%s' asynchronously", request->filePath);
+        request_release(request);
+        request->status = R3D_MODEL_REQUEST_FAILED;
+    }
+
     return true;
 }
 
@@ -108,6 +290,134 @@ R3D_Model R3D_LoadModelFromMesh(const R3D_Mesh* mesh)
     return model;
 }
 
+R3D_ModelRequest* R3D_LoadModelAsync(const char* filePath)
+{
+    if (filePath == NULL) {
+        return NULL;
+    }
+
+    R3D_ModelRequest* request = RL_CALLOC(1, sizeof(R3D_ModelRequest));
+    if (request == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Unable to allocate memory for model request");
+        return NULL;
+    }
+
+    size_t pathSize = strlen(filePath) + 1;
+    request->filePath = RL_MALLOC(pathSize);
+    if (request->filePath == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Unable to allocate memory for model request");
+        RL_FREE(request);
+        return NULL;
+    }
+    memcpy(request->filePath, filePath, pathSize);
+
+    request->filter = R3D_CACHE_GET(textureFilter);
+    request->compressTextures = R3D_CACHE_GET(modelCompressTextures);
+    request->streamTextures = R3D_CACHE_GET(modelStreamTextures);
+    request->lodCount = R3D_CACHE_GET(modelLodCount);
+    request->format = R3D_CACHE_GET(modelCompactVertices)
+        ? R3D_VERTEX_FORMAT_COMPACT : R3D_VERTEX_FORMAT_FULL;
+
+    request->status = R3D_MODEL_REQUEST_PENDING;
+    atomic_init(&request->stage, REQUEST_STAGE_PARSING);
+
+    if (thrd_create(&request->thread, request_thread, request) == thrd_success) {
+        request->threadRunning = true;
+    }
+    else {
+        // Without thread, the whole CPU work happens in this call
+        request_thread(request);
+    }
+
+    request->next = g_requests;
+    g_requests = request;
+
+    return request;
+}
+
+void R3D_PumpUploads(float budgetMs)
+{
+    double deadline = GetTime() + budgetMs / 1000.0;
+    bool progressed = false;
+
+    // At least one unit of work is done per call, whatever the budget
+    for (R3D_ModelRequest* request = g_requests; request != NULL; request = request->next) {
+        while (request->status == R3D_MODEL_REQUEST_PENDING) {
+            if (progressed && GetTime() >= deadline) return;
+            if (!request_pump(request)) break;
+            progressed = true;
+        }
+    }
+}
+
+R3D_ModelRequestStatus R3D_GetModelRequestStatus(const R3D_ModelRequest* request)
+{
+    return request ? request->status : R3D_MODEL_REQUEST_FAILED;
+}
+
+float R3D_GetModelRequestProgress(const R3D_ModelRequest* request)
+{
+    if (request == NULL || request->status != R3D_MODEL_REQUEST_PENDING) {
+        return 1.0f;
+    }
+
+    int stage = atomic_load(&request->stage);
+
+    if (stage != REQUEST_STAGE_CONVERTING && stage != REQUEST_STAGE_UPLOADING) {
+        return 0.0f;
+    }
+
+    if (request->totalUploads == 0) {
+        return 1.0f;
+    }
+
+    // The batch belongs to the loading thread during the conversion, no mesh is uploaded before its end
+    int pendingMeshes = (stage == REQUEST_STAGE_UPLOADING)
+        ? r3d_importer_get_pending_mesh_count(request->meshBatch)
+        : request->totalMeshes;
+
+    int pending = r3d_importer_get_pending_texture_count(request->textureCache) + pendingMeshes;
+
+    return (float)(request->totalUploads - pending) / request->totalUploads;
+}
+
+const R3D_Model* R3D_GetModelRequestModel(const R3D_ModelRequest* request)
+{
+    if (request == NULL || request->status != R3D_MODEL_REQUEST_READY) {
+        return &g_emptyModel;
+    }
+
+    return &request->model;
+}
+
+R3D_Model R3D_FinishModelRequest(R3D_ModelRequest* request)
+{
+    R3D_Model model = { 0 };
+
+    if (request == NULL) {
+        return model;
+    }
+
+    for (R3D_ModelRequest** it = &g_requests; *it != NULL; it = &(*it)->next) {
+        if (*it == request) {
+            *it = request->next;
+            break;
+        }
+    }
+
+    if (request->status == R3D_MODEL_REQUEST_READY) {
+        model = request->model;
+    }
+    else if (request->status == R3D_MODEL_REQUEST_PENDING) {
+        request_release(request);
+    }
+
+    RL_FREE(request->filePath);
+    RL_FREE(request);
+
+    return model;
+}
+
 void R3D_UnloadModel(R3D_Model* model, bool unloadMaterials)
 {
     R3D_UnloadSkeleton(&model->skeleton);
@@ -0,0 +1,388 @@
+/* r3d_model_batch.c -- R3D Static Batch Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_mesh_data.h>
+#include <r3d/r3d_material.h>
+#include <r3d/r3d_model.h>
+#include <r3d/r3d_mesh.h>
+#include <raymath.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <glad.h>
+
+#include "./details/r3d_vertex.h"
+#include "./details/r3d_math.h"
+
+// ========================================
+// INTERNAL TYPES
+// ========================================
+
+/*
+ * One mesh of one source model, placed in the world.
+ * Parts sharing the same batch key are merged into the same output mesh.
+ */
+typedef struct {
+    const Matrix* transform;
+    int material;                       //< Index in the unique materials
+    int source;                         //< Index in the decoded source meshes
+    R3D_ShadowCastMode shadowCastMode;
+    R3D_Layer layerMask;
+    int cell[3];                        //< Cell containing the center of the world bounds
+} batch_part_t;
+
+typedef struct {
+    batch_part_t* parts;
+    int numParts;
+    R3D_Material* materials;
+    int numMaterials;
+    R3D_MeshData* sources;              //< Decoded vertices and indices of each distinct GPU mesh
+    const R3D_Mesh** sourceMeshes;
+    int numSources;
+} batch_context_t;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static bool read_buffer(GLuint buffer, size_t offset, size_t size, void* data)
+{
+    if (size == 0) return true;
+    if (buffer == 0) return false;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    return true;
+}
+
+static bool read_stream(R3D_Vertex* vertices, const R3D_Mesh* mesh, GLuint buffer, r3d_vertex_stream_e stream)
+{
+    size_t stride = r3d_vertex_stride(mesh->vertexFormat, stream);
+    size_t size = mesh->vertexCount * stride;
+
+    void* encoded = RL_MALLOC(size);
+    if (encoded == NULL) return false;
+
+    bool success = read_buffer(buffer, mesh->baseVertex * stride, size, encoded);
+    if (success) {
+        r3d_vertex_decode(vertices, mesh->vertexFormat, stream, encoded, mesh->vertexCount, &mesh->quantizationBounds);
+    }
+
+    RL_FREE(encoded);
+
+    return success;
+}
+
+// Reads back the vertices and indices of a mesh, non-indexed meshes get sequential indices
+static bool read_mesh(R3D_MeshData* data, const R3D_Mesh* mesh)
+{
+    bool indexed = (mesh->ebo != 0 && mesh->indexCount > 0);
+
+    *data = R3D_CreateMeshData(mesh->vertexCount, indexed ? mesh->indexCount : mesh->vertexCount);
+    if (!R3D_IsMeshDataValid(data) || data->indices == NULL) {
+        return false;
+    }
+
+    if (!read_stream(data->vertices, mesh, mesh->vbo, R3D_VERTEX_STREAM_POSITION) ||
+        !read_stream(data->vertices, mesh, mesh->attribVbo, R3D_VERTEX_STREAM_ATTRIBS)) {
+        return false;
+    }
+
+    if (indexed) {
+        return read_buffer(mesh->ebo, mesh->firstIndex * sizeof(uint32_t), mesh->indexCount * sizeof(uint32_t), data->indices);
+    }
+
+    for (int i = 0; i < data->indexCount; i++) {
+        data->indices[i] = (uint32_t)i;
+    }
+
+    return true;
+}
+
+static bool is_batchable(const R3D_Mesh* mesh, const R3D_Material* material)
+{
+    return mesh->vao != 0 && mesh->vertexCount > 0 &&
+           mesh->skinVbo == 0 &&
+           mesh->primitiveType == R3D_PRIMITIVE_TRIANGLES &&
+           material->billboardMode == R3D_BILLBOARD_DISABLED;
+}
+
+static int find_material(batch_context_t* ctx, const R3D_Material* material)
+{
+    for (int i = 0; i < ctx->numMaterials; i++) {
+        if (memcmp(&ctx->materials[i], material, sizeof(R3D_Material)) == 0) {
+            return i;
+        }
+    }
+
+    ctx->materials[ctx->numMaterials] = *material;
+    return ctx->numMaterials++;
+}
+
+// Meshes drawn by several models share their GPU buffers, they are only read back once
+static int find_source(batch_context_t* ctx, const R3D_Mesh* mesh)
+{
+    for (int i = 0; i < ctx->numSources; i++) {
+        const R3D_Mesh* other = ctx->sourceMeshes[i];
+        if (other->vao == mesh->vao && other->baseVertex == mesh->baseVertex && other->firstIndex == mesh->firstIndex &&
+            other->vertexCount == mesh->vertexCount && other->indexCount == mesh->indexCount) {
+            return i;
+        }
+    }
+
+    if (!read_mesh(&ctx->sources[ctx->numSources], mesh)) {
+        R3D_UnloadMeshData(&ctx->sources[ctx->numSources]);
+        return -1;
+    }
+
+    ctx->sourceMeshes[ctx->numSources] = mesh;
+    return ctx->numSources++;
+}
+
+static int compare_parts(const void* a, const void* b)
+{
+    const batch_part_t* pa = (const batch_part_t*)a;
+    const batch_part_t* pb = (const batch_part_t*)b;
+
+    if (pa->material != pb->material) return (pa->material < pb->material) ? -1 : 1;
+    if (pa->shadowCastMode != pb->shadowCastMode) return (pa->shadowCastMode < pb->shadowCastMode) ? -1 : 1;
+    if (pa->layerMask != pb->layerMask) return (pa->layerMask < pb->layerMask) ? -1 : 1;
+
+    for (int i = 0; i < 3; i++) {
+        if (pa->cell[i] != pb->cell[i]) return (pa->cell[i] < pb->cell[i]) ? -1 : 1;
+    }
+
+    return 0;
+}
+
+static bool same_batch(const batch_part_t* a, const batch_part_t* b)
+{
+    return a->material == b->material && a->shadowCastMode == b->shadowCastMode && a->layerMask == b->layerMask &&
+           a->cell[0] == b->cell[0] && a->cell[1] == b->cell[1] && a->cell[2] == b->cell[2];
+}
+
+// Appends the vertices of a part transformed to world space, mirrored parts have their winding flipped
+static void append_part(R3D_MeshData* dst, int* vertexCount, int* indexCount, const R3D_MeshData* src, const Matrix* transform)
+{
+    Matrix normalMatrix = r3d_matrix_normal(transform);
+    bool mirrored = (MatrixDeterminant(*transform) < 0.0f);
+
+    int baseVertex = *vertexCount;
+
+    for (int i = 0; i < src->vertexCount; i++)
+    {
+        R3D_Vertex vertex = src->vertices[i];
+
+        vertex.position = r3d_vector3_transform(vertex.position, transform);
+        vertex.normal = Vector3Normalize(r3d_vector3_transform_linear(vertex.normal, &normalMatrix));
+
+        Vector3 tangent = { vertex.tangent.x, vertex.tangent.y, vertex.tangent.z };
+        tangent = Vector3Normalize(r3d_vector3_transform_linear(tangent, transform));
+        vertex.tangent = (Vector4) { tangent.x, tangent.y, tangent.z, mirrored ? -vertex.tangent.w : vertex.tangent.w };
+
+        dst->vertices[baseVertex + i] = vertex;
+    }
+
+    uint32_t* indices = &dst->indices[*indexCount];
+
+    for (int i = 0; i + 2 < src->indexCount; i += 3) {
+        indices[i + 0] = baseVertex + src->indices[i + 0];
+        indices[i + 1] = baseVertex + src->indices[mirrored ? i + 2 : i + 1];
+        indices[i + 2] = baseVertex + src->indices[mirrored ? i + 1 : i + 2];
+    }
+
+    *vertexCount += src->vertexCount;
+    *indexCount += src->indexCount - src->indexCount % 3;
+}
+
+static bool build_batch_mesh(R3D_Mesh* mesh, const batch_context_t* ctx, const batch_part_t* parts, int numParts)
+{
+    int totalVertices = 0, totalIndices = 0;
+
+    for (int i = 0; i < numParts; i++) {
+        const R3D_MeshData* src = &ctx->sources[parts[i].source];
+        totalVertices += src->vertexCount;
+        totalIndices += src->indexCount;
+    }
+
+    R3D_MeshData data = R3D_CreateMeshData(totalVertices, totalIndices);
+    if (!R3D_IsMeshDataValid(&data) || data.indices == NULL) {
+        R3D_UnloadMeshData(&data);
+        return false;
+    }
+
+    int vertexCount = 0, indexCount = 0;
+
+    for (int i = 0; i < numParts; i++) {
+        append_part(&data, &vertexCount, &indexCount, &ctx->sources[parts[i].source], parts[i].transform);
+    }
+
+    data.indexCount = indexCount;
+
+    R3D_OptimizeMeshData(&data);
+
+    *mesh = R3D_LoadMesh(R3D_PRIMITIVE_TRIANGLES, &data, NULL, R3D_STATIC_MESH);
+    mesh->shadowCastMode = parts[0].shadowCastMode;
+    mesh->layerMask = parts[0].layerMask;
+
+    R3D_UnloadMeshData(&data);
+
+    return R3D_IsMeshValid(mesh);
+}
+
+static void release_context(batch_context_t* ctx)
+{
+    for (int i = 0; i < ctx->numSources; i++) {
+        R3D_UnloadMeshData(&ctx->sources[i]);
+    }
+
+    RL_FREE(ctx->parts);
+    RL_FREE(ctx->materials);
+    RL_FREE(ctx->sources);
+    RL_FREE(ctx->sourceMeshes);
+}
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_Model R3D_BuildStaticBatch(const R3D_Model* models, const Matrix* transforms, int count, float cellSize)
+{
+    R3D_Model model = { 0 };
+
+    if (models == NULL || transforms == NULL || count <= 0) {
+        TraceLog(LOG_WARNING, "R3D: Invalid models given to R3D_BuildStaticBatch");
+        return model;
+    }
+
+    int maxParts = 0;
+    for (int i = 0; i < count; i++) {
+        maxParts += models[i].meshCount;
+    }
+
+    batch_context_t ctx = { 0 };
+    ctx.parts = RL_MALLOC((maxParts + 1) * sizeof(*ctx.parts));
+    ctx.materials = RL_MALLOC((maxParts + 1) * sizeof(*ctx.materials));
+    ctx.sources = RL_CALLOC(maxParts + 1, sizeof(*ctx.sources));
+    ctx.sourceMeshes = RL_MALLOC((maxParts + 1) * sizeof(*ctx.sourceMeshes));
+
+    if (!ctx.parts || !ctx.materials || !ctx.sources || !ctx.sourceMeshes) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on static batch creation");
+        release_context(&ctx);
+        return model;
+    }
+
+    /* --- Collect the meshes of every model with their world placement --- */
+
+    int skipped = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        const R3D_Model* source = &models[i];
+
+        for (int j = 0; j < source->meshCount; j++)
+        {
+            const R3D_Mesh* mesh = &source->meshes[j];
+
+            R3D_Material material = R3D_GetDefaultMaterial();
+            if (source->meshMaterials != NULL && source->materials != NULL) {
+                int index = source->meshMaterials[j];
+                if (index >= 0 && index < source->materialCount) {
+                    material = source->materials[index];
+                }
+            }
+
+            if (!is_batchable(mesh, &material) || source->skeleton.boneCount > 0) {
+                skipped++;
+                continue;
+            }
+
+            int sourceIndex = find_source(&ctx, mesh);
+            if (sourceIndex < 0) {
+                skipped++;
+                continue;
+            }
+
+            batch_part_t* part = &ctx.parts[ctx.numParts++];
+
+            part->transform = &transforms[i];
+            part->material = find_material(&ctx, &material);
+            part->source = sourceIndex;
+            part->shadowCastMode = mesh->shadowCastMode;
+            part->layerMask = mesh->layerMask;
+
+            // Parts are binned by the center of their world bounds, a cell size of zero keeps one cell
+            Vector3 center = Vector3Scale(Vector3Add(mesh->aabb.min, mesh->aabb.max), 0.5f);
+            center = r3d_vector3_transform(center, &transforms[i]);
+            part->cell[0] = (cellSize > 0.0f) ? (int)floorf(center.x / cellSize) : 0;
+            part->cell[1] = (cellSize > 0.0f) ? (int)floorf(center.y / cellSize) : 0;
+            part->cell[2] = (cellSize > 0.0f) ? (int)floorf(center.z / cellSize) : 0;
+        }
+    }
+
+    if (skipped > 0) {
+        TraceLog(LOG_WARNING, "R3D: %i meshes left out of the static batch (skinned, not triangles, billboarded or unreadable)", skipped);
+    }
+
+    if (ctx.numParts == 0) {
+        release_context(&ctx);
+        return model;
+    }
+
+    /* --- Merge the parts sharing the same material, settings and cell --- */
+
+    qsort(ctx.parts, ctx.numParts, sizeof(*ctx.parts), compare_parts);
+
+    int numBatches = 1;
+    for (int i = 1; i < ctx.numParts; i++) {
+        if (!same_batch(&ctx.parts[i - 1], &ctx.parts[i])) numBatches++;
+    }
+
+    model.meshes = RL_CALLOC(numBatches, sizeof(R3D_Mesh));
+    model.meshMaterials = RL_MALLOC(numBatches * sizeof(int));
+    model.materials = RL_MALLOC(ctx.numMaterials * sizeof(R3D_Material));
+
+    if (!model.meshes || !model.meshMaterials || !model.materials) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on static batch creation");
+        R3D_UnloadModel(&model, false);
+        release_context(&ctx);
+        return (R3D_Model) { 0 };
+    }
+
+    memcpy(model.materials, ctx.materials, ctx.numMaterials * sizeof(R3D_Material));
+    model.materialCount = ctx.numMaterials;
+
+    model.aabb.min = (Vector3) { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+    model.aabb.max = (Vector3) { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (int begin = 0; begin < ctx.numParts; )
+    {
+        int end = begin + 1;
+        while (end < ctx.numParts && same_batch(&ctx.parts[begin], &ctx.parts[end])) end++;
+
+        R3D_Mesh* mesh = &model.meshes[model.meshCount];
+        if (build_batch_mesh(mesh, &ctx, &ctx.parts[begin], end - begin)) {
+            model.meshMaterials[model.meshCount++] = ctx.parts[begin].material;
+            model.aabb.min = Vector3Min(model.aabb.min, mesh->aabb.min);
+            model.aabb.max = Vector3Max(model.aabb.max, mesh->aabb.max);
+        }
+        else {
+            TraceLog(LOG_WARNING, "R3D: Failed to build a mesh of the static batch");
+        }
+
+        begin = end;
+    }
+
+    release_context(&ctx);
+
+    return model;
+}
@@ -0,0 +1,786 @@
+/* r3d_model_cache.c -- R3D Model Cache Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_material.h>
+#include <r3d/r3d_skeleton.h>
+#include <r3d/r3d_model.h>
+#include <r3d/r3d_utils.h>
+#include <r3d/r3d_mesh.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <glad.h>
+
+#include "./modules/r3d_texture.h"
+#include "./modules/r3d_arena.h"
+#include "./modules/r3d_cache.h"
+#include "./modules/r3d_state.h"
+#include "./modules/r3d_skin.h"
+#include "./details/r3d_mapped_file.h"
+#include "./details/r3d_vertex.h"
+
+// ========================================
+// FILE FORMAT
+// ========================================
+
+/*
+ * A cache file is a header followed by the textures, the materials, the meshes and the skeleton.
+ * Every record is followed by its blobs, each blob starts on a 16 bytes boundary so that
+ * the mapped file can be handed to the driver as is. The vertex streams are stored exactly
+ * as they are encoded on the GPU, the file is therefore only valid for the build that wrote it.
+ */
+
+#define MODEL_CACHE_MAGIC       0x4D443352u     //< "R3DM"
+#define MODEL_CACHE_VERSION     1u
+#define MODEL_CACHE_ALIGNMENT   16
+
+// Texture indices of the default textures, the others index the texture records
+#define TEXTURE_INDEX_WHITE     -1
+#define TEXTURE_INDEX_BLACK     -2
+#define TEXTURE_INDEX_NORMAL    -3
+
+#define MATERIAL_MAP_COUNT      4               //< Albedo, emission, normal and ORM
+
+#define MESH_FLAG_SKIN          (1u << 0)       //< The mesh has a skinning stream
+#define MESH_FLAG_ALPHA         (1u << 1)       //< The vertex colors are translucent, no depth VAO
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t textureCount;
+    int32_t materialCount;
+    int32_t meshCount;
+    int32_t boneCount;
+    BoundingBox aabb;
+} model_cache_header_t;
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    int32_t format;                 //< PixelFormat of the data, only the first level is stored
+    int32_t wrap;                   //< TextureWrap
+    int32_t mipmaps;                //< Non-zero if the mipmaps must be generated
+    uint32_t dataSize;
+} texture_record_t;
+
+typedef struct {
+    int32_t textures[MATERIAL_MAP_COUNT];
+    Color albedoColor;
+    Color emissionColor;
+    float emissionEnergy;
+    float normalScale;
+    float occlusion;
+    float roughness;
+    float metalness;
+    int32_t transparencyMode;
+    int32_t billboardMode;
+    int32_t blendMode;
+    int32_t cullMode;
+    Vector2 uvOffset;
+    Vector2 uvScale;
+    float alphaCutoff;
+} material_record_t;
+
+typedef struct {
+    int32_t material;
+    int32_t vertexCount;
+    int32_t indexCount;
+    int32_t lodIndexCount;          //< Indices of the levels of detail, stored after the ones of the mesh
+    int32_t primitiveType;
+    int32_t usage;
+    int32_t vertexFormat;
+    int32_t shadowCastMode;
+    uint32_t layerMask;
+    uint32_t flags;
+    BoundingBox quantizationBounds;
+    BoundingBox aabb;
+    int32_t lodCount;
+    R3D_MeshLod lods[R3D_MESH_MAX_LODS];    //< First indices are relative to the level indices
+} mesh_record_t;
+
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+} cache_reader_t;
+
+// ========================================
+// WRITING FUNCTIONS
+// ========================================
+
+static bool write_block(FILE* file, const void* data, size_t size)
+{
+    static const uint8_t zeros[MODEL_CACHE_ALIGNMENT] = { 0 };
+
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+
+    long position = ftell(file);
+    if (position < 0) return false;
+
+    size_t padding = (MODEL_CACHE_ALIGNMENT - (position % MODEL_CACHE_ALIGNMENT)) % MODEL_CACHE_ALIGNMENT;
+    return padding == 0 || fwrite(zeros, 1, padding, file) == padding;
+}
+
+static bool write_buffer(FILE* file, GLuint buffer, size_t offset, size_t size)
+{
+    if (size == 0) return true;
+
+    void* data = RL_MALLOC(size);
+    if (data == NULL) return false;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, offset, size, data);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    bool success = write_block(file, data, size);
+    RL_FREE(data);
+
+    return success;
+}
+
+static int get_texture_index(Texture2D* textures, int* count, Texture2D texture)
+{
+    GLuint id = texture.id;
+
+    if (id == 0 || id == R3D_GetWhiteTexture().id) return TEXTURE_INDEX_WHITE;
+    if (id == R3D_GetBlackTexture().id) return TEXTURE_INDEX_BLACK;
+    if (id == R3D_GetNormalTexture().id) return TEXTURE_INDEX_NORMAL;
+    if (r3d_texture_is_default(id)) return TEXTURE_INDEX_WHITE;
+
+    for (int i = 0; i < *count; i++) {
+        if (textures[i].id == id) return i;
+    }
+
+    textures[*count] = texture;
+
+    return (*count)++;
+}
+
+static int get_texture_wrap(GLuint id)
+{
+    GLint wrap = GL_REPEAT;
+
+    glBindTexture(GL_TEXTURE_2D, id);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, &wrap);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    switch (wrap) {
+    case GL_CLAMP_TO_EDGE: return TEXTURE_WRAP_CLAMP;
+    case GL_MIRRORED_REPEAT: return TEXTURE_WRAP_MIRROR_REPEAT;
+    default: break;
+    }
+
+    return TEXTURE_WRAP_REPEAT;
+}
+
+static bool write_texture(FILE* file, Texture2D texture)
+{
+    Image image = LoadImageFromTexture(texture);
+
+    texture_record_t record = {
+        .width = image.width,
+        .height = image.height,
+        .format = image.format,
+        .wrap = get_texture_wrap(texture.id),
+        .mipmaps = (texture.mipmaps > 1),
+        .dataSize = 0
+    };
+
+    // Compressed textures cannot be read back, they are replaced by the white texture on load
+    if (image.data != NULL) {
+        record.dataSize = (uint32_t)GetPixelDataSize(image.width, image.height, image.format);
+    }
+    else {
+        TraceLog(LOG_WARNING, "R3D: Texture %u cannot be read back, it will not be cached", texture.id);
+    }
+
+    bool success = write_block(file, &record, sizeof(record))
+                && write_block(file, image.data, record.dataSize);
+
+    UnloadImage(image);
+
+    return success;
+}
+
+static void fill_material_record(material_record_t* record, const R3D_Material* material, Texture2D* textures, int* count)
+{
+    record->textures[0] = get_texture_index(textures, count, material->albedo.texture);
+    record->textures[1] = get_texture_index(textures, count, material->emission.texture);
+    record->textures[2] = get_texture_index(textures, count, material->normal.texture);
+    record->textures[3] = get_texture_index(textures, count, material->orm.texture);
+
+    record->albedoColor = material->albedo.color;
+    record->emissionColor = material->emission.color;
+    record->emissionEnergy = material->emission.energy;
+    record->normalScale = material->normal.scale;
+    record->occlusion = material->orm.occlusion;
+    record->roughness = material->orm.roughness;
+    record->metalness = material->orm.metalness;
+    record->transparencyMode = material->transparencyMode;
+    record->billboardMode = material->billboardMode;
+    record->blendMode = material->blendMode;
+    record->cullMode = material->cullMode;
+    record->uvOffset = material->uvOffset;
+    record->uvScale = material->uvScale;
+    record->alphaCutoff = material->alphaCutoff;
+}
+
+static bool write_mesh(FILE* file, const R3D_Mesh* mesh, int material)
+{
+    mesh_record_t record = {
+        .material = material,
+        .vertexCount = mesh->vertexCount,
+        .indexCount = (mesh->ebo != 0) ? mesh->indexCount : 0,
+        .primitiveType = mesh->primitiveType,
+        .usage = mesh->usage,
+        .vertexFormat = mesh->vertexFormat,
+        .shadowCastMode = mesh->shadowCastMode,
+        .layerMask = mesh->layerMask,
+        .flags = 0,
+        .quantizationBounds = mesh->quantizationBounds,
+        .aabb = mesh->aabb,
+        .lodCount = (mesh->ebo != 0) ? mesh->lodCount : 0
+    };
+
+    if (mesh->skinVbo != 0) record.flags |= MESH_FLAG_SKIN;
+    if (mesh->depthVao == 0) record.flags |= MESH_FLAG_ALPHA;
+
+    for (int i = 0; i < record.lodCount; i++) {
+        record.lods[i] = mesh->lods[i];
+        record.lods[i].firstIndex = record.lodIndexCount;
+        record.lodIndexCount += mesh->lods[i].indexCount;
+    }
+
+    size_t positionStride = r3d_vertex_stride(mesh->vertexFormat, R3D_VERTEX_STREAM_POSITION);
+    size_t skinStride = r3d_vertex_stride(mesh->vertexFormat, R3D_VERTEX_STREAM_SKIN);
+    size_t attribStride = r3d_vertex_stride(mesh->vertexFormat, R3D_VERTEX_STREAM_ATTRIBS);
+
+    if (!write_block(file, &record, sizeof(record))) return false;
+    if (!write_buffer(file, mesh->vbo, mesh->baseVertex * positionStride, mesh->vertexCount * positionStride)) return false;
+    if (mesh->skinVbo != 0 && !write_buffer(file, mesh->skinVbo, mesh->baseVertex * skinStride, mesh->vertexCount * skinStride)) return false;
+    if (!write_buffer(file, mesh->attribVbo, mesh->baseVertex * attribStride, mesh->vertexCount * attribStride)) return false;
+    if (!write_buffer(file, mesh->ebo, mesh->firstIndex * sizeof(uint32_t), record.indexCount * sizeof(uint32_t))) return false;
+
+    for (int i = 0; i < record.lodCount; i++) {
+        const R3D_MeshLod* lod = &mesh->lods[i];
+        if (!write_buffer(file, mesh->ebo, lod->firstIndex * sizeof(uint32_t), lod->indexCount * sizeof(uint32_t))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool write_skeleton(FILE* file, const R3D_Skeleton* skeleton)
+{
+    size_t matricesSize = skeleton->boneCount * sizeof(Matrix);
+
+    return write_block(file, skeleton->bones, skeleton->boneCount * sizeof(R3D_BoneInfo))
+        && write_block(file, skeleton->boneOffsets, matricesSize)
+        && write_block(file, skeleton->bindLocal, matricesSize)
+        && write_block(file, skeleton->bindPose, matricesSize);
+}
+
+// ========================================
+// READING FUNCTIONS
+// ========================================
+
+static const void* read_block(cache_reader_t* reader, size_t size)
+{
+    if (size > reader->size - reader->offset) {
+        return NULL;
+    }
+
+    const void* block = reader->data + reader->offset;
+
+    size_t end = reader->offset + size;
+    end = (end + MODEL_CACHE_ALIGNMENT - 1) & ~(size_t)(MODEL_CACHE_ALIGNMENT - 1);
+    reader->offset = (end < reader->size) ? end : reader->size;
+
+    return block;
+}
+
+static void setup_vertex_array(const R3D_Mesh* mesh, GLuint vao, bool depthOnly)
+{
+    r3d_state_bind_vao(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_POSITION);
+
+    if (mesh->skinVbo != 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->skinVbo);
+        r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_SKIN);
+    }
+
+    if (!depthOnly) {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->attribVbo);
+        r3d_vertex_setup_stream(mesh->vertexFormat, R3D_VERTEX_STREAM_ATTRIBS);
+    }
+
+    r3d_vertex_setup_defaults();
+
+    if (mesh->ebo != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    }
+
+    r3d_state_bind_vao(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+static GLuint create_buffer(GLenum target, const void* data, size_t size, GLenum glUsage)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    glBufferData(target, size, data, glUsage);
+    glBindBuffer(target, 0);
+    return buffer;
+}
+
+static void load_owned_mesh(R3D_Mesh* mesh, const mesh_record_t* record, const void* positions,
+                            const void* skin, const void* attribs, const uint32_t* indices)
+{
+    GLenum glUsage = GL_STATIC_DRAW;
+    if (record->usage == R3D_DYNAMIC_MESH) glUsage = GL_DYNAMIC_DRAW;
+    else if (record->usage == R3D_STREAMED_MESH) glUsage = GL_STREAM_DRAW;
+
+    int vertexCount = record->vertexCount;
+    R3D_VertexFormat format = record->vertexFormat;
+
+    mesh->vbo = create_buffer(GL_ARRAY_BUFFER, positions, vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_POSITION), glUsage);
+    mesh->attribVbo = create_buffer(GL_ARRAY_BUFFER, attribs, vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_ATTRIBS), glUsage);
+    if (skin != NULL) {
+        mesh->skinVbo = create_buffer(GL_ARRAY_BUFFER, skin, vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_SKIN), glUsage);
+    }
+
+    // The levels of detail follow the indices of the mesh, as done by 'R3D_AddMeshLod()'
+    int totalIndices = record->indexCount + record->lodIndexCount;
+    if (totalIndices > 0) {
+        mesh->ebo = create_buffer(GL_ELEMENT_ARRAY_BUFFER, indices, totalIndices * sizeof(uint32_t), glUsage);
+        for (int i = 0; i < record->lodCount; i++) {
+            mesh->lods[i] = record->lods[i];
+            mesh->lods[i].firstIndex += record->indexCount;
+        }
+        mesh->lodCount = record->lodCount;
+    }
+
+    glGenVertexArrays(1, &mesh->vao);
+    setup_vertex_array(mesh, mesh->vao, false);
+
+    if ((record->flags & MESH_FLAG_ALPHA) == 0) {
+        glGenVertexArrays(1, &mesh->depthVao);
+        setup_vertex_array(mesh, mesh->depthVao, true);
+    }
+}
+
+static bool load_shared_mesh(R3D_Mesh* mesh, const mesh_record_t* record, const void* positions,
+                             const void* attribs, const uint32_t* indices)
+{
+    bool hasAlpha = (record->flags & MESH_FLAG_ALPHA) != 0;
+    if (!r3d_arena_alloc_encoded(mesh, positions, attribs, record->vertexCount, indices, record->indexCount, hasAlpha)) {
+        return false;
+    }
+
+    const uint32_t* lodIndices = indices + record->indexCount;
+
+    for (int i = 0; i < record->lodCount; i++) {
+        const R3D_MeshLod* lod = &record->lods[i];
+        int firstIndex = r3d_arena_alloc_indices(mesh, lodIndices + lod->firstIndex, lod->indexCount);
+        if (firstIndex < 0) {
+            TraceLog(LOG_WARNING, "R3D: The mesh arena chunk is full; %i cached levels of detail are dropped", record->lodCount - i);
+            break;
+        }
+        mesh->lods[i] = *lod;
+        mesh->lods[i].firstIndex = firstIndex;
+        mesh->lodCount++;
+    }
+
+    return true;
+}
+
+static bool read_mesh(cache_reader_t* reader, R3D_Mesh* mesh, int* material)
+{
+    const mesh_record_t* record = read_block(reader, sizeof(mesh_record_t));
+    if (record == NULL || record->vertexCount <= 0 || record->indexCount < 0 || record->lodIndexCount < 0 ||
+        record->lodCount < 0 || record->lodCount > R3D_MESH_MAX_LODS || (record->lodCount > 0 && record->indexCount == 0) ||
+        record->vertexFormat < 0 ||
+        record->vertexFormat > R3D_VERTEX_FORMAT_COMPACT) {
+        return false;
+    }
+
+    R3D_VertexFormat format = record->vertexFormat;
+    bool hasSkin = (record->flags & MESH_FLAG_SKIN) != 0;
+
+    const void* positions = read_block(reader, record->vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_POSITION));
+    const void* skin = hasSkin ? read_block(reader, record->vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_SKIN)) : NULL;
+    const void* attribs = read_block(reader, record->vertexCount * r3d_vertex_stride(format, R3D_VERTEX_STREAM_ATTRIBS));
+    if (positions == NULL || attribs == NULL || (hasSkin && skin == NULL)) return false;
+
+    const uint32_t* indices = NULL;
+    if (record->indexCount > 0) {
+        // NOTE: The levels of detail are written as one blob per level, each one padded
+        indices = read_block(reader, record->indexCount * sizeof(uint32_t));
+        if (indices == NULL) return false;
+    }
+
+    memset(mesh, 0, sizeof(*mesh));
+    mesh->vertexFormat = format;
+
+    uint32_t* packedIndices = NULL;
+    const uint32_t* allIndices = indices;
+
+    // The levels are packed after the indices of the mesh, the padding between the blobs is removed
+    if (record->lodCount > 0) {
+        packedIndices = RL_MALLOC((record->indexCount + record->lodIndexCount) * sizeof(uint32_t));
+        if (packedIndices == NULL) return false;
+
+        memcpy(packedIndices, indices, record->indexCount * sizeof(uint32_t));
+        for (int i = 0; i < record->lodCount; i++) {
+            const uint32_t* lodIndices = read_block(reader, record->lods[i].indexCount * sizeof(uint32_t));
+            if (lodIndices == NULL || record->lods[i].firstIndex + record->lods[i].indexCount > record->lodIndexCount) {
+                RL_FREE(packedIndices);
+                return false;
+            }
+            memcpy(packedIndices + record->indexCount + record->lods[i].firstIndex, lodIndices, record->lods[i].indexCount * sizeof(uint32_t));
+        }
+
+        allIndices = packedIndices;
+    }
+
+    bool shared = (record->usage == R3D_STATIC_MESH && record->primitiveType == R3D_PRIMITIVE_TRIANGLES &&
+                   format == R3D_VERTEX_FORMAT_FULL && !hasSkin);
+
+    if (!shared || !load_shared_mesh(mesh, record, positions, attribs, allIndices)) {
+        load_owned_mesh(mesh, record, positions, skin, attribs, allIndices);
+        mesh->allocVertexCount = record->vertexCount;
+        mesh->allocIndexCount = record->indexCount;
+    }
+
+    RL_FREE(packedIndices);
+
+    mesh->vertexCount = record->vertexCount;
+    mesh->indexCount = record->indexCount;
+    mesh->shadowCastMode = record->shadowCastMode;
+    mesh->primitiveType = record->primitiveType;
+    mesh->usage = record->usage;
+    mesh->quantizationBounds = record->quantizationBounds;
+    mesh->layerMask = record->layerMask;
+    mesh->aabb = record->aabb;
+
+    *material = record->material;
+
+    return true;
+}
+
+static bool read_texture(cache_reader_t* reader, Texture2D* texture)
+{
+    const texture_record_t* record = read_block(reader, sizeof(texture_record_t));
+    if (record == NULL) return false;
+
+    const void* data = read_block(reader, record->dataSize);
+    if (data == NULL) return false;
+
+    *texture = (Texture2D) { 0 };
+
+    if (record->dataSize == 0 || record->dataSize != (uint32_t)GetPixelDataSize(record->width, record->height, record->format)) {
+        return true;
+    }
+
+    Image image = {
+        .data = (void*)data,
+        .width = record->width,
+        .height = record->height,
+        .mipmaps = 1,
+        .format = record->format
+    };
+
+    *texture = LoadTextureFromImage(image);
+    if (texture->id == 0) return true;
+
+    TextureFilter filter = R3D_CACHE_GET(textureFilter);
+    if (record->mipmaps || filter >= TEXTURE_FILTER_TRILINEAR) {
+        GenTextureMipmaps(texture);
+    }
+    SetTextureWrap(*texture, record->wrap);
+    SetTextureFilter(*texture, filter);
+
+    return true;
+}
+
+static Texture2D resolve_texture(const Texture2D* textures, int count, int index)
+{
+    if (index >= 0 && index < count && textures[index].id != 0) return textures[index];
+    if (index == TEXTURE_INDEX_BLACK) return R3D_GetBlackTexture();
+    if (index == TEXTURE_INDEX_NORMAL) return R3D_GetNormalTexture();
+    return R3D_GetWhiteTexture();
+}
+
+static void read_material(const material_record_t* record, R3D_Material* material, const Texture2D* textures, int count)
+{
+    *material = R3D_GetDefaultMaterial();
+
+    material->albedo.texture = resolve_texture(textures, count, record->textures[0]);
+    material->emission.texture = resolve_texture(textures, count, record->textures[1]);
+    material->normal.texture = resolve_texture(textures, count, record->textures[2]);
+    material->orm.texture = resolve_texture(textures, count, record->textures[3]);
+
+    material->albedo.color = record->albedoColor;
+    material->emission.color = record->emissionColor;
+    material->emission.energy = record->emissionEnergy;
+    material->normal.scale = record->normalScale;
+    material->orm.occlusion = record->occlusion;
+    material->orm.roughness = record->roughness;
+    material->orm.metalness = record->metalness;
+    material->transparencyMode = record->transparencyMode;
+    material->billboardMode = record->billboardMode;
+    material->blendMode = record->blendMode;
+    material->cullMode = record->cullMode;
+    material->uvOffset = record->uvOffset;
+    material->uvScale = record->uvScale;
+    material->alphaCutoff = record->alphaCutoff;
+}
+
+static bool read_skeleton(cache_reader_t* reader, R3D_Skeleton* skeleton, int boneCount)
+{
+    size_t matricesSize = boneCount * sizeof(Matrix);
+
+    const void* bones = read_block(reader, boneCount * sizeof(R3D_BoneInfo));
+    const void* boneOffsets = read_block(reader, matricesSize);
+    const void* bindLocal = read_block(reader, matricesSize);
+    const void* bindPose = read_block(reader, matricesSize);
+    if (!bones || !boneOffsets || !bindLocal || !bindPose) return false;
+
+    skeleton->bones = RL_MALLOC(boneCount * sizeof(R3D_BoneInfo));
+    skeleton->boneOffsets = RL_MALLOC(matricesSize);
+    skeleton->bindLocal = RL_MALLOC(matricesSize);
+    skeleton->bindPose = RL_MALLOC(matricesSize);
+    skeleton->boneCount = boneCount;
+    skeleton->bindPoseOffset = -1;
+
+    if (!skeleton->bones || !skeleton->boneOffsets || !skeleton->bindLocal || !skeleton->bindPose) {
+        return false;
+    }
+
+    memcpy(skeleton->bones, bones, boneCount * sizeof(R3D_BoneInfo));
+    memcpy(skeleton->boneOffsets, boneOffsets, matricesSize);
+    memcpy(skeleton->bindLocal, bindLocal, matricesSize);
+    memcpy(skeleton->bindPose, bindPose, matricesSize);
+
+    skeleton->bindPoseOffset = r3d_skin_alloc(boneCount);
+    if (skeleton->bindPoseOffset < 0) {
+        return false;
+    }
+
+    r3d_skin_write(skeleton->bindPoseOffset, skeleton->bindPose, boneCount);
+
+    return true;
+}
+
+static bool read_model(cache_reader_t* reader, R3D_Model* model)
+{
+    const model_cache_header_t* header = read_block(reader, sizeof(model_cache_header_t));
+    if (header == NULL || header->magic != MODEL_CACHE_MAGIC) {
+        TraceLog(LOG_WARNING, "R3D: Invalid model cache file");
+        return false;
+    }
+
+    if (header->version != MODEL_CACHE_VERSION) {
+        TraceLog(LOG_WARNING, "R3D: Model cache version %u is not supported", header->version);
+        return false;
+    }
+
+    if (header->textureCount < 0 || header->materialCount <= 0 || header->meshCount <= 0 || header->boneCount < 0) {
+        TraceLog(LOG_WARNING, "R3D: Invalid model cache file");
+        return false;
+    }
+
+    Texture2D* textures = NULL;
+    if (header->textureCount > 0) {
+        textures = RL_CALLOC(header->textureCount, sizeof(Texture2D));
+        if (textures == NULL) return false;
+    }
+
+    bool success = true;
+
+    for (int i = 0; success && i < header->textureCount; i++) {
+        success = read_texture(reader, &textures[i]);
+    }
+
+    model->materials = RL_CALLOC(header->materialCount, sizeof(R3D_Material));
+    model->meshes = RL_CALLOC(header->meshCount, sizeof(R3D_Mesh));
+    model->meshMaterials = RL_CALLOC(header->meshCount, sizeof(int));
+    success = success && model->materials && model->meshes && model->meshMaterials;
+
+    // NOTE: The textures are owned by the materials from now on
+    if (success) {
+        model->materialCount = header->materialCount;
+        for (int i = 0; i < header->materialCount; i++) {
+            const material_record_t* record = read_block(reader, sizeof(material_record_t));
+            if (record == NULL) { success = false; break; }
+            read_material(record, &model->materials[i], textures, header->textureCount);
+        }
+    }
+
+    for (int i = 0; success && i < header->meshCount; i++) {
+        int material = 0;
+        success = read_mesh(reader, &model->meshes[i], &material);
+        if (success) {
+            model->meshMaterials[i] = (material >= 0 && material < model->materialCount) ? material : 0;
+            model->meshCount++;
+        }
+    }
+
+    if (success && header->boneCount > 0) {
+        success = read_skeleton(reader, &model->skeleton, header->boneCount);
+    }
+
+    model->aabb = header->aabb;
+
+    // Textures not referenced by any material would leak otherwise
+    for (int i = 0; i < header->textureCount; i++) {
+        bool referenced = false;
+        for (int j = 0; !referenced && j < model->materialCount; j++) {
+            const R3D_Material* material = &model->materials[j];
+            referenced = (material->albedo.texture.id == textures[i].id || material->emission.texture.id == textures[i].id ||
+                          material->normal.texture.id == textures[i].id || material->orm.texture.id == textures[i].id);
+        }
+        if (!referenced && textures[i].id != 0) {
+            UnloadTexture(textures[i]);
+        }
+    }
+
+    RL_FREE(textures);
+
+    if (!success) {
+        TraceLog(LOG_WARNING, "R3D: Model cache file is truncated or corrupted");
+    }
+
+    return success;
+}
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+bool R3D_SaveModelCache(const R3D_Model* model, const char* filePath)
+{
+    if (model == NULL || model->meshCount <= 0 || model->materialCount <= 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot save the model cache; Invalid model");
+        return false;
+    }
+
+    // Each material references at most one texture per map
+    Texture2D* textures = RL_MALLOC(model->materialCount * MATERIAL_MAP_COUNT * sizeof(Texture2D));
+    material_record_t* materials = RL_CALLOC(model->materialCount, sizeof(material_record_t));
+    if (textures == NULL || materials == NULL) {
+        RL_FREE(textures);
+        RL_FREE(materials);
+        return false;
+    }
+
+    int textureCount = 0;
+    for (int i = 0; i < model->materialCount; i++) {
+        fill_material_record(&materials[i], &model->materials[i], textures, &textureCount);
+    }
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Cannot open '%s' to save the model cache", filePath);
+        RL_FREE(textures);
+        RL_FREE(materials);
+        return false;
+    }
+
+    model_cache_header_t header = {
+        .magic = MODEL_CACHE_MAGIC,
+        .version = MODEL_CACHE_VERSION,
+        .textureCount = textureCount,
+        .materialCount = model->materialCount,
+        .meshCount = model->meshCount,
+        .boneCount = model->skeleton.boneCount,
+        .aabb = model->aabb
+    };
+
+    bool success = write_block(file, &header, sizeof(header));
+
+    for (int i = 0; success && i < textureCount; i++) {
+        success = write_texture(file, textures[i]);
+    }
+
+    for (int i = 0; success && i < model->materialCount; i++) {
+        success = write_block(file, &materials[i], sizeof(material_record_t));
+    }
+
+    for (int i = 0; success && i < model->meshCount; i++) {
+        int material = (model->meshMaterials != NULL) ? model->meshMaterials[i] : 0;
+        success = write_mesh(file, &model->meshes[i], material);
+    }
+
+    if (success && model->skeleton.boneCount > 0) {
+        success = write_skeleton(file, &model->skeleton);
+    }
+
+    success = (fclose(file) == 0) && success;
+
+    RL_FREE(textures);
+    RL_FREE(materials);
+
+    if (!success) {
+        TraceLog(LOG_WARNING, "R3D: Failed to write the model cache '%s'", filePath);
+        remove(filePath);
+    }
+
+    return success;
+}
+
+R3D_Model R3D_LoadModelCache(const char* filePath)
+{
+    R3D_Model model = { 0 };
+
+    r3d_mapped_file_t file;
+    if (!r3d_mapped_file_open(&file, filePath)) {
+        TraceLog(LOG_WARNING, "R3D: Cannot open the model cache '%s'", filePath);
+        return model;
+    }
+
+    cache_reader_t reader = {
+        .data = file.data,
+        .size = file.size,
+        .offset = 0
+    };
+
+    if (!read_model(&reader, &model)) {
+        R3D_UnloadModel(&model, true);
+        model = (R3D_Model) { 0 };
+    }
+
+    r3d_mapped_file_close(&file);
+
+    return model;
+}
+
+R3D_Model R3D_LoadModelCached(const char* filePath, const char* cachePath)
+{
+    R3D_Model model = { 0 };
+
+    // The cache is only trusted if it was written after the last change of the source
+    if (FileExists(cachePath) && GetFileModTime(cachePath) >= GetFileModTime(filePath)) {
+        model = R3D_LoadModelCache(cachePath);
+        if (model.meshCount > 0) return model;
+    }
+
+    model = R3D_LoadModel(filePath);
+    if (model.meshCount > 0) {
+        R3D_SaveModelCache(&model, cachePath);
+    }
+
+    return model;
+}
@@ -14,20 +14,52 @@
 #include <limits.h>
 #include <float.h>
 #include <math.h>
+#include <glad.h>
 
+#include <tinycthread.h>
+#include <stdatomic.h>
+
+#include "./modules/r3d_shader.h"
 #include "./details/r3d_math.h"
+#include "./details/r3d_half.h"
+#include "./details/r3d_simd.h"
+#include "./details/r3d_cpu.h"
+
+/* Module constants */
+
+#define PARTICLES_PER_CHUNK     16384
+#define PARTICLES_STACK_CHUNKS  16      //< Chunks listed on the stack, larger updates allocate their list
+
+// NOTE: Must match the definitions of 'particle_update.comp'
+#define GPU_CURVE_SAMPLES       32
+#define GPU_PARTICLE_SIZE       (6 * sizeof(Vector4))
+#define GPU_HEADER_SIZE         (4 * sizeof(uint32_t))
 
 /* Helper functions */
 
-static float r3d_randf(void)
+// Each system owns its random state, so that systems can be updated from several threads
+static uint32_t r3d_rand(uint32_t* state)
+{
+    uint32_t z = (*state += 0x9E3779B9u);
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    return z ^ (z >> 16);
+}
+
+static float r3d_randf(uint32_t* state)
 {
     static const float INV_65535 = 1.0f / 0xFFFF;
-    return (float)GetRandomValue(0, 0xFFFF) * INV_65535;
+    return (float)(r3d_rand(state) & 0xFFFF) * INV_65535;
 }
 
-static float r3d_randf_range(float min, float max)
+static float r3d_randf_range(uint32_t* state, float min, float max)
 {
-    return min + r3d_randf() * (max - min);
+    return min + r3d_randf(state) * (max - min);
+}
+
+static int r3d_randi_range(uint32_t* state, int min, int max)
+{
+    return min + (int)(r3d_rand(state) % (uint32_t)(max - min + 1));
 }
 
 static float r3d_min3f(float a, float b, float c)
@@ -46,16 +78,584 @@ static float r3d_max3f(float a, float b, float c)
     return max;
 }
 
+// Returns the initial velocity of a particle, spread in a cone around the initial velocity
+static Vector3 r3d_particles_random_velocity(R3D_ParticleSystem* system)
+{
+    // Normalize the initial direction
+    Vector3 direction = Vector3Normalize(system->initialVelocity);
+
+    // Generate random angles
+    float elevation = r3d_randf_range(&system->seed, 0, system->spreadAngle * DEG2RAD);
+    float azimuth = r3d_randf_range(&system->seed, 0, 2.0f * PI);
+
+    // Precompute trigonometric values for the cone
+    float cosElevation = cosf(elevation);
+    float sinElevation = sqrtf(1.0f - cosElevation * cosElevation); // Use the trigonometric identity
+    float cosAzimuth = cosf(azimuth);
+    float sinAzimuth = sinf(azimuth);
+
+    // Calculate the vector within the cone (local coordinate system)
+    Vector3 spreadDirection = {
+        sinElevation * cosAzimuth,
+        sinElevation * sinAzimuth,
+        cosElevation
+    };
+
+    // Generate the local basis around 'direction'
+    Vector3 arbitraryAxis = (fabsf(direction.y) > 0.9999f)
+        ? (Vector3) { 0.0f, 0.0f, 1.0f }
+        : (Vector3) { 1.0f, 0.0f, 0.0f };
+
+    Vector3 binormal = Vector3Normalize(Vector3CrossProduct(arbitraryAxis, direction));
+    Vector3 normal = Vector3CrossProduct(direction, binormal);
+
+    // Transform 'spreadDirection' to the global coordinate system
+    Vector3 velocity = {
+        spreadDirection.x * binormal.x + spreadDirection.y * normal.x + spreadDirection.z * direction.x,
+        spreadDirection.x * binormal.y + spreadDirection.y * normal.y + spreadDirection.z * direction.y,
+        spreadDirection.x * binormal.z + spreadDirection.y * normal.z + spreadDirection.z * direction.z
+    };
+
+    // Scale the final velocity
+    velocity = Vector3Scale(velocity, Vector3Length(system->initialVelocity));
+
+    return (Vector3) {
+        velocity.x + r3d_randf_range(&system->seed, -system->velocityVariance.x, system->velocityVariance.x),
+        velocity.y + r3d_randf_range(&system->seed, -system->velocityVariance.y, system->velocityVariance.y),
+        velocity.z + r3d_randf_range(&system->seed, -system->velocityVariance.z, system->velocityVariance.z)
+    };
+}
+
+static float r3d_particles_random_lifetime(R3D_ParticleSystem* system)
+{
+    return system->lifetime + r3d_randf_range(&system->seed, -system->lifetimeVariance, system->lifetimeVariance);
+}
+
+/* Update kernels */
+
+// Adds 'value' to each element of 'dst'
+static void r3d_particles_add(float* dst, float value, int count)
+{
+    int i = 0;
+
+#if defined(R3D_HAS_AVX)
+    const __m256 v = _mm256_set1_ps(value);
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(&dst[i], _mm256_add_ps(_mm256_loadu_ps(&dst[i]), v));
+    }
+#elif defined(R3D_HAS_SSE)
+    const __m128 v = _mm_set1_ps(value);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(&dst[i], _mm_add_ps(_mm_loadu_ps(&dst[i]), v));
+    }
+#elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+    const float32x4_t v = vdupq_n_f32(value);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(&dst[i], vaddq_f32(vld1q_f32(&dst[i]), v));
+    }
+#endif
+
+    for (; i < count; i++) {
+        dst[i] += value;
+    }
+}
+
+// Adds 'src' scaled by 'scale' to each element of 'dst'
+static void r3d_particles_madd(float* dst, const float* src, float scale, int count)
+{
+    int i = 0;
+
+#if defined(R3D_HAS_AVX)
+    const __m256 s = _mm256_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+    #if defined(R3D_HAS_FMA_AVX)
+        __m256 r = _mm256_fmadd_ps(_mm256_loadu_ps(&src[i]), s, _mm256_loadu_ps(&dst[i]));
+    #else
+        __m256 r = _mm256_add_ps(_mm256_loadu_ps(&dst[i]), _mm256_mul_ps(_mm256_loadu_ps(&src[i]), s));
+    #endif
+        _mm256_storeu_ps(&dst[i], r);
+    }
+#elif defined(R3D_HAS_SSE)
+    const __m128 s = _mm_set1_ps(scale);
+    for (; i + 4 <= count; i += 4) {
+        __m128 r = _mm_add_ps(_mm_loadu_ps(&dst[i]), _mm_mul_ps(_mm_loadu_ps(&src[i]), s));
+        _mm_storeu_ps(&dst[i], r);
+    }
+#elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(&dst[i], vmlaq_n_f32(vld1q_f32(&dst[i]), vld1q_f32(&src[i]), scale));
+    }
+#endif
+
+    for (; i < count; i++) {
+        dst[i] += src[i] * scale;
+    }
+}
+
+// Returns the smallest and the largest element of 'src', 'count' must be positive
+static void r3d_particles_range(const float* src, int count, float* outMin, float* outMax)
+{
+    int i = 0;
+    float vmin = src[0];
+    float vmax = src[0];
+
+#if defined(R3D_HAS_AVX)
+    if (count >= 8) {
+        __m256 mn = _mm256_loadu_ps(src), mx = mn;
+        for (i = 8; i + 8 <= count; i += 8) {
+            __m256 v = _mm256_loadu_ps(&src[i]);
+            mn = _mm256_min_ps(mn, v);
+            mx = _mm256_max_ps(mx, v);
+        }
+        float lanesMin[8], lanesMax[8];
+        _mm256_storeu_ps(lanesMin, mn);
+        _mm256_storeu_ps(lanesMax, mx);
+        for (int l = 0; l < 8; l++) {
+            vmin = fminf(vmin, lanesMin[l]);
+            vmax = fmaxf(vmax, lanesMax[l]);
+        }
+    }
+#elif defined(R3D_HAS_SSE)
+    if (count >= 4) {
+        __m128 mn = _mm_loadu_ps(src), mx = mn;
+        for (i = 4; i + 4 <= count; i += 4) {
+            __m128 v = _mm_loadu_ps(&src[i]);
+            mn = _mm_min_ps(mn, v);
+            mx = _mm_max_ps(mx, v);
+        }
+        float lanesMin[4], lanesMax[4];
+        _mm_storeu_ps(lanesMin, mn);
+        _mm_storeu_ps(lanesMax, mx);
+        for (int l = 0; l < 4; l++) {
+            vmin = fminf(vmin, lanesMin[l]);
+            vmax = fmaxf(vmax, lanesMax[l]);
+        }
+    }
+#elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+    if (count >= 4) {
+        float32x4_t mn = vld1q_f32(src), mx = mn;
+        for (i = 4; i + 4 <= count; i += 4) {
+            float32x4_t v = vld1q_f32(&src[i]);
+            mn = vminq_f32(mn, v);
+            mx = vmaxq_f32(mx, v);
+        }
+        float lanesMin[4], lanesMax[4];
+        vst1q_f32(lanesMin, mn);
+        vst1q_f32(lanesMax, mx);
+        for (int l = 0; l < 4; l++) {
+            vmin = fminf(vmin, lanesMin[l]);
+            vmax = fmaxf(vmax, lanesMax[l]);
+        }
+    }
+#endif
+
+    for (; i < count; i++) {
+        vmin = fminf(vmin, src[i]);
+        vmax = fmaxf(vmax, src[i]);
+    }
+
+    *outMin = vmin;
+    *outMax = vmax;
+}
+
+// Returns the index of the first expired lifetime from 'start', or 'count' if there is none
+static int r3d_particles_find_expired(const float* lifetime, int start, int count)
+{
+    int i = start;
+
+    /*
+     * Whole batches of living particles are skipped with a single test,
+     * the scalar loop below then locates the expired one within the batch.
+     */
+
+#if defined(R3D_HAS_AVX)
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m256 expired = _mm256_cmp_ps(_mm256_loadu_ps(&lifetime[i]), zero, _CMP_LE_OQ);
+        if (_mm256_movemask_ps(expired)) break;
+    }
+#elif defined(R3D_HAS_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 expired = _mm_cmple_ps(_mm_loadu_ps(&lifetime[i]), zero);
+        if (_mm_movemask_ps(expired)) break;
+    }
+#elif defined(R3D_HAS_NEON) || defined(R3D_HAS_NEON_FMA)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        uint32x4_t expired = vcleq_f32(vld1q_f32(&lifetime[i]), zero);
+        uint32x2_t any = vorr_u32(vget_low_u32(expired), vget_high_u32(expired));
+        if (vget_lane_u32(vpmax_u32(any, any), 0)) break;
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (lifetime[i] <= 0.0f) break;
+    }
+
+    return i;
+}
+
+// Replaces the particle at 'dst' by the particle at 'src'
+static void r3d_particles_move(R3D_ParticleSystem* system, int dst, int src)
+{
+    for (int s = 0; s < R3D_PARTICLE_STREAM_COUNT; s++) {
+        system->streams[s][dst] = system->streams[s][src];
+    }
+    system->instances[dst] = system->instances[src];
+}
+
+// Writes the transform of the particle at 'i' into its instance record, the color is kept
+static void r3d_particles_pack(R3D_ParticleSystem* system, int i)
+{
+    float** streams = system->streams;
+    R3D_ParticleInstance* instance = &system->instances[i];
+
+    instance->position.x = streams[R3D_PARTICLE_POSITION_X][i];
+    instance->position.y = streams[R3D_PARTICLE_POSITION_Y][i];
+    instance->position.z = streams[R3D_PARTICLE_POSITION_Z][i];
+
+    // Wrapped so that the half floats keep their precision on long lived spinning particles
+    instance->rotation[0] = r3d_cvt_fh(Wrap(streams[R3D_PARTICLE_ROTATION_X][i], -PI, PI));
+    instance->rotation[1] = r3d_cvt_fh(Wrap(streams[R3D_PARTICLE_ROTATION_Y][i], -PI, PI));
+    instance->rotation[2] = r3d_cvt_fh(Wrap(streams[R3D_PARTICLE_ROTATION_Z][i], -PI, PI));
+    instance->rotation[3] = 0;
+
+    instance->scale[0] = r3d_cvt_fh(streams[R3D_PARTICLE_SCALE_X][i]);
+    instance->scale[1] = r3d_cvt_fh(streams[R3D_PARTICLE_SCALE_Y][i]);
+    instance->scale[2] = r3d_cvt_fh(streams[R3D_PARTICLE_SCALE_Z][i]);
+    instance->scale[3] = 0;
+}
+
+/* Parallel update */
+
+typedef struct {
+    R3D_ParticleSystem* system;
+    int begin, end;
+    int alive;                      //< Live particles, compacted at the start of the chunk
+    BoundingBox bounds;             //< Positions of the live particles, only computed with 'autoBounds'
+    float maxScale;                 //< Largest scale component of the live particles, same
+} update_chunk_t;
+
+typedef struct {
+    update_chunk_t* chunks;
+    atomic_int nextChunk;
+    int count;
+    float dt;
+} update_context_t;
+
+// Simulates the particles in [begin, end), expired ones are swap-removed within the range
+static int update_range(R3D_ParticleSystem* system, int begin, int end, float deltaTime)
+{
+    float** streams = system->streams;
+
+    /* --- Age the particles and swap-remove the expired ones --- */
+
+    float* lifetime = streams[R3D_PARTICLE_LIFETIME];
+    r3d_particles_add(&lifetime[begin], -deltaTime, end - begin);
+
+    int i = begin;
+    while ((i = r3d_particles_find_expired(lifetime, i, end)) < end) {
+        r3d_particles_move(system, i, --end);
+    }
+
+    /* --- Evaluate the curves, only when the system uses them --- */
+
+    if (system->scaleOverLifetime || system->opacityOverLifetime ||
+        system->speedOverLifetime || system->angularVelocityOverLifetime)
+    {
+        for (i = begin; i < end; i++)
+        {
+            float t = 1.0f - (lifetime[i] / system->lifetime);
+
+            if (system->scaleOverLifetime) {
+                float scale = R3D_EvaluateCurve(*system->scaleOverLifetime, t);
+                streams[R3D_PARTICLE_SCALE_X][i] = streams[R3D_PARTICLE_BASE_SCALE_X][i] * scale;
+                streams[R3D_PARTICLE_SCALE_Y][i] = streams[R3D_PARTICLE_BASE_SCALE_Y][i] * scale;
+                streams[R3D_PARTICLE_SCALE_Z][i] = streams[R3D_PARTICLE_BASE_SCALE_Z][i] * scale;
+            }
+
+            if (system->opacityOverLifetime) {
+                float scale = R3D_EvaluateCurve(*system->opacityOverLifetime, t);
+                system->instances[i].color.a = (unsigned char)Clamp(streams[R3D_PARTICLE_BASE_OPACITY][i] * scale, 0.0f, 255.0f);
+            }
+
+            if (system->speedOverLifetime) {
+                float scale = R3D_EvaluateCurve(*system->speedOverLifetime, t);
+                streams[R3D_PARTICLE_VELOCITY_X][i] = streams[R3D_PARTICLE_BASE_VELOCITY_X][i] * scale;
+                streams[R3D_PARTICLE_VELOCITY_Y][i] = streams[R3D_PARTICLE_BASE_VELOCITY_Y][i] * scale;
+                streams[R3D_PARTICLE_VELOCITY_Z][i] = streams[R3D_PARTICLE_BASE_VELOCITY_Z][i] * scale;
+            }
+
+            if (system->angularVelocityOverLifetime) {
+                float scale = R3D_EvaluateCurve(*system->angularVelocityOverLifetime, t);
+                streams[R3D_PARTICLE_ANGULAR_VELOCITY_X][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_X][i] * scale;
+                streams[R3D_PARTICLE_ANGULAR_VELOCITY_Y][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Y][i] * scale;
+                streams[R3D_PARTICLE_ANGULAR_VELOCITY_Z][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Z][i] * scale;
+            }
+        }
+    }
+
+    /* --- Integrate rotation, position then velocity --- */
+
+    float angularStep = deltaTime * DEG2RAD;
+    r3d_particles_madd(&streams[R3D_PARTICLE_ROTATION_X][begin], &streams[R3D_PARTICLE_ANGULAR_VELOCITY_X][begin], angularStep, end - begin);
+    r3d_particles_madd(&streams[R3D_PARTICLE_ROTATION_Y][begin], &streams[R3D_PARTICLE_ANGULAR_VELOCITY_Y][begin], angularStep, end - begin);
+    r3d_particles_madd(&streams[R3D_PARTICLE_ROTATION_Z][begin], &streams[R3D_PARTICLE_ANGULAR_VELOCITY_Z][begin], angularStep, end - begin);
+
+    r3d_particles_madd(&streams[R3D_PARTICLE_POSITION_X][begin], &streams[R3D_PARTICLE_VELOCITY_X][begin], deltaTime, end - begin);
+    r3d_particles_madd(&streams[R3D_PARTICLE_POSITION_Y][begin], &streams[R3D_PARTICLE_VELOCITY_Y][begin], deltaTime, end - begin);
+    r3d_particles_madd(&streams[R3D_PARTICLE_POSITION_Z][begin], &streams[R3D_PARTICLE_VELOCITY_Z][begin], deltaTime, end - begin);
+
+    r3d_particles_add(&streams[R3D_PARTICLE_VELOCITY_X][begin], system->gravity.x * deltaTime, end - begin);
+    r3d_particles_add(&streams[R3D_PARTICLE_VELOCITY_Y][begin], system->gravity.y * deltaTime, end - begin);
+    r3d_particles_add(&streams[R3D_PARTICLE_VELOCITY_Z][begin], system->gravity.z * deltaTime, end - begin);
+
+    /* --- Pack the instance records, the matrices are built by the vertex shader --- */
+
+    for (i = begin; i < end; i++) {
+        r3d_particles_pack(system, i);
+    }
+
+    return end - begin;
+}
+
+// Computes the bounds of the positions and the largest scale of the particles in [begin, end)
+static void measure_range(const R3D_ParticleSystem* system, int begin, int end, BoundingBox* bounds, float* maxScale)
+{
+    float* const* streams = system->streams;
+    int count = end - begin;
+
+    r3d_particles_range(&streams[R3D_PARTICLE_POSITION_X][begin], count, &bounds->min.x, &bounds->max.x);
+    r3d_particles_range(&streams[R3D_PARTICLE_POSITION_Y][begin], count, &bounds->min.y, &bounds->max.y);
+    r3d_particles_range(&streams[R3D_PARTICLE_POSITION_Z][begin], count, &bounds->min.z, &bounds->max.z);
+
+    // Scales may be negative with a large variance, only their magnitude matters
+    float scale = 0.0f;
+    for (int s = R3D_PARTICLE_SCALE_X; s <= R3D_PARTICLE_SCALE_Z; s++) {
+        float smin, smax;
+        r3d_particles_range(&streams[s][begin], count, &smin, &smax);
+        scale = fmaxf(scale, fmaxf(fabsf(smin), fabsf(smax)));
+    }
+
+    *maxScale = scale;
+}
+
+static int update_worker(void* arg)
+{
+    update_context_t* ctx = arg;
+
+    int index;
+    while ((index = atomic_fetch_add(&ctx->nextChunk, 1)) < ctx->count) {
+        update_chunk_t* chunk = &ctx->chunks[index];
+        chunk->alive = update_range(chunk->system, chunk->begin, chunk->end, ctx->dt);
+        if (chunk->system->autoBounds && chunk->alive > 0) {
+            measure_range(chunk->system, chunk->begin, chunk->begin + chunk->alive, &chunk->bounds, &chunk->maxScale);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Makes the live particles of consecutive chunks of a system contiguous.
+ * Only the holes below the new count are filled, with the last live particles,
+ * so the number of particles moved never exceeds the number of expired ones.
+ */
+static void merge_chunks(const update_chunk_t* chunks, int numChunks)
+{
+    R3D_ParticleSystem* system = chunks[0].system;
+
+    int total = 0;
+    for (int c = 0; c < numChunks; c++) {
+        total += chunks[c].alive;
+    }
+
+    int s = numChunks - 1;
+    int src = chunks[s].begin + chunks[s].alive;
+
+    for (int c = 0; c < numChunks && chunks[c].begin < total; c++)
+    {
+        int holeEnd = (chunks[c].end < total) ? chunks[c].end : total;
+
+        for (int hole = chunks[c].begin + chunks[c].alive; hole < holeEnd; hole++) {
+            while (src == chunks[s].begin) {
+                s--, src = chunks[s].begin + chunks[s].alive;
+            }
+            src--;
+            r3d_particles_move(system, hole, src);
+        }
+    }
+
+    system->count = total;
+
+    if (!system->autoBounds || total == 0) {
+        return;
+    }
+
+    BoundingBox bounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+    float maxScale = 0.0f;
+
+    for (int c = 0; c < numChunks; c++) {
+        if (chunks[c].alive == 0) continue;
+        bounds.min = Vector3Min(bounds.min, chunks[c].bounds.min);
+        bounds.max = Vector3Max(bounds.max, chunks[c].bounds.max);
+        maxScale = fmaxf(maxScale, chunks[c].maxScale);
+    }
+
+    system->aabb = bounds;
+    system->boundsScale = maxScale;
+}
+
+/* GPU simulation */
+
+static bool r3d_particles_gpu_load(R3D_ParticleSystem* system)
+{
+    system->instanceBuffer = R3D_LoadInstanceBuffer(system->capacity, R3D_INSTANCE_COLOR, R3D_DYNAMIC_INSTANCES);
+    if (!R3D_IsInstanceBufferValid(&system->instanceBuffer)) {
+        return false;
+    }
+
+    glGenBuffers(1, &system->ssboParticles);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, system->ssboParticles);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, GPU_HEADER_SIZE + system->capacity * GPU_PARTICLE_SIZE, NULL, GL_DYNAMIC_COPY);
+
+    // All the particles start dead, and must not be drawn before the first update
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, system->instanceBuffer.vboTransforms);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    system->instanceBuffer.count = system->capacity;
+
+    return true;
+}
+
+static void r3d_particles_gpu_sample_curve(float* samples, const R3D_InterpolationCurve* curve)
+{
+    for (int i = 0; i < GPU_CURVE_SAMPLES; i++) {
+        samples[i] = R3D_EvaluateCurve(*curve, (float)i / (GPU_CURVE_SAMPLES - 1));
+    }
+}
+
+static void r3d_particles_gpu_update(R3D_ParticleSystem* system, float deltaTime)
+{
+    // NOTE: Same order as the 'CURVE_*' definitions of the shader
+    const R3D_InterpolationCurve* curves[4] = {
+        system->scaleOverLifetime,
+        system->speedOverLifetime,
+        system->opacityOverLifetime,
+        system->angularVelocityOverLifetime
+    };
+
+    float samples[4 * GPU_CURVE_SAMPLES] = { 0 };
+    int curveMask = 0, textureMask = 0;
+
+    // Uploaded curves are sampled from their texture, the others are sampled here
+    for (int i = 0; i < 4; i++) {
+        if (curves[i] == NULL) continue;
+        curveMask |= 1 << i;
+        if (curves[i]->texture != 0) textureMask |= 1 << i;
+        else r3d_particles_gpu_sample_curve(&samples[i * GPU_CURVE_SAMPLES], curves[i]);
+    }
+
+    // Reset the emission counter of the dispatch
+    const uint32_t emitted = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, system->ssboParticles);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(emitted), &emitted);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    R3D_SHADER_USE(prepare.particleUpdate);
+
+    R3D_SHADER_SET_FLOAT(prepare.particleUpdate, uDeltaTime, deltaTime);
+    R3D_SHADER_SET_INT(prepare.particleUpdate, uParticleCount, system->capacity);
+    R3D_SHADER_SET_INT(prepare.particleUpdate, uEmitCount, system->pendingEmissions);
+    R3D_SHADER_SET_INT(prepare.particleUpdate, uSeed, (int)system->seed++);
+
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uPosition, system->position);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uGravity, system->gravity);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uInitialScale, system->initialScale);
+    R3D_SHADER_SET_FLOAT(prepare.particleUpdate, uScaleVariance, system->scaleVariance);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uInitialRotation, system->initialRotation);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uRotationVariance, system->rotationVariance);
+    R3D_SHADER_SET_VEC4(prepare.particleUpdate, uInitialColor, (Vector4) {
+        system->initialColor.r, system->initialColor.g, system->initialColor.b, system->initialColor.a
+    });
+    R3D_SHADER_SET_VEC4(prepare.particleUpdate, uColorVariance, (Vector4) {
+        system->colorVariance.r, system->colorVariance.g, system->colorVariance.b, system->colorVariance.a
+    });
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uInitialVelocity, system->initialVelocity);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uVelocityVariance, system->velocityVariance);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uInitialAngularVelocity, system->initialAngularVelocity);
+    R3D_SHADER_SET_VEC3(prepare.particleUpdate, uAngularVelocityVariance, system->angularVelocityVariance);
+    R3D_SHADER_SET_FLOAT(prepare.particleUpdate, uLifetime, system->lifetime);
+    R3D_SHADER_SET_FLOAT(prepare.particleUpdate, uLifetimeVariance, system->lifetimeVariance);
+    R3D_SHADER_SET_FLOAT(prepare.particleUpdate, uSpreadAngle, system->spreadAngle);
+
+    R3D_SHADER_SET_INT(prepare.particleUpdate, uCurveMask, curveMask);
+    R3D_SHADER_SET_INT(prepare.particleUpdate, uCurveTextureMask, textureMask);
+    if (curveMask & ~textureMask) {
+        R3D_SHADER_SET_FLOAT_V(prepare.particleUpdate, uCurves, samples, 4 * GPU_CURVE_SAMPLES);
+    }
+
+    R3D_SHADER_BIND_SAMPLER_1D(prepare.particleUpdate, uTexScaleCurve, curves[0] ? curves[0]->texture : 0);
+    R3D_SHADER_BIND_SAMPLER_1D(prepare.particleUpdate, uTexSpeedCurve, curves[1] ? curves[1]->texture : 0);
+    R3D_SHADER_BIND_SAMPLER_1D(prepare.particleUpdate, uTexOpacityCurve, curves[2] ? curves[2]->texture : 0);
+    R3D_SHADER_BIND_SAMPLER_1D(prepare.particleUpdate, uTexAngularVelocityCurve, curves[3] ? curves[3]->texture : 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, system->ssboParticles);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, system->instanceBuffer.vboTransforms);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, system->instanceBuffer.vboColors);
+
+    glDispatchCompute((system->capacity + 63) / 64, 1, 1);
+
+    // The outputs are read as instance attributes, or by the instance culling shader
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    for (int i = 0; i < 3; i++) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i, 0);
+    }
+
+    system->pendingEmissions = 0;
+}
+
 /* Public functions */
 
 R3D_ParticleSystem R3D_LoadParticleSystem(int maxParticles)
+{
+    return R3D_LoadParticleSystemEx(maxParticles, R3D_PARTICLE_MODE_CPU);
+}
+
+R3D_ParticleSystem R3D_LoadParticleSystemEx(int maxParticles, R3D_ParticleMode mode)
 {
     R3D_ParticleSystem system = { 0 };
 
-    system.particles = RL_MALLOC(sizeof(R3D_Particle) * maxParticles);
     system.capacity = maxParticles;
     system.count = 0;
 
+    if (mode == R3D_PARTICLE_MODE_GPU && !GLAD_GL_VERSION_4_3) {
+        TraceLog(LOG_WARNING, "R3D: GPU particles require OpenGL 4.3; Falling back to CPU simulation");
+        mode = R3D_PARTICLE_MODE_CPU;
+    }
+
+    if (mode == R3D_PARTICLE_MODE_GPU && !r3d_particles_gpu_load(&system)) {
+        TraceLog(LOG_WARNING, "R3D: Failed to create the buffers of a GPU particle system; Falling back to CPU simulation");
+        R3D_UnloadInstanceBuffer(&system.instanceBuffer);
+        mode = R3D_PARTICLE_MODE_CPU;
+    }
+
+    if (mode == R3D_PARTICLE_MODE_CPU) {
+        system.instances = RL_MALLOC(sizeof(R3D_ParticleInstance) * maxParticles);
+
+        float* streams = RL_MALLOC(sizeof(float) * maxParticles * R3D_PARTICLE_STREAM_COUNT);
+        for (int i = 0; i < R3D_PARTICLE_STREAM_COUNT; i++) {
+            system.streams[i] = streams + i * maxParticles;
+        }
+    }
+
+    system.mode = mode;
+    system.seed = ((uint32_t)GetRandomValue(0, 0xFFFF) << 16) | (uint32_t)GetRandomValue(0, 0xFFFF);
+
     system.position = (Vector3){ 0, 0, 0 };
     system.gravity = (Vector3){ 0, -9.81f, 0 };
 
@@ -92,6 +692,8 @@ R3D_ParticleSystem R3D_LoadParticleSystem(int maxParticles)
     };
 
     system.autoEmission = true;
+    system.autoBounds = (mode == R3D_PARTICLE_MODE_CPU);
+    system.boundsScale = 0.0f;
 
     return system;
 }
@@ -99,164 +701,182 @@ R3D_ParticleSystem R3D_LoadParticleSystem(int maxParticles)
 void R3D_UnloadParticleSystem(R3D_ParticleSystem* system)
 {
     if (system) {
-        RL_FREE(system->particles);
+        if (system->mode == R3D_PARTICLE_MODE_GPU) {
+            R3D_UnloadInstanceBuffer(&system->instanceBuffer);
+            glDeleteBuffers(1, &system->ssboParticles);
+            return;
+        }
+        RL_FREE(system->instances);
+        RL_FREE(system->streams[0]);
     }
 }
 
 bool R3D_EmitParticle(R3D_ParticleSystem* system)
 {
+    if (system->mode == R3D_PARTICLE_MODE_GPU) {
+        if (system->pendingEmissions >= system->capacity) return false;
+        system->pendingEmissions++;
+        return true;
+    }
+
     if (system->count >= system->capacity) {
         return false;
     }
 
-    // Normalize the initial direction
-    Vector3 direction = Vector3Normalize(system->initialVelocity);
+    Vector3 velocity = r3d_particles_random_velocity(system);
 
-    // Generate random angles
-    float elevation = r3d_randf_range(0, system->spreadAngle * DEG2RAD);
-    float azimuth = r3d_randf_range(0, 2.0f * PI);
+    // Initialize particle
+    float** streams = system->streams;
+    int i = system->count++;
 
-    // Precompute trigonometric values for the cone
-    float cosElevation = cosf(elevation);
-    float sinElevation = sqrtf(1.0f - cosElevation * cosElevation); // Use the trigonometric identity
-    float cosAzimuth = cosf(azimuth);
-    float sinAzimuth = sinf(azimuth);
+    streams[R3D_PARTICLE_LIFETIME][i] = r3d_particles_random_lifetime(system);
 
-    // Calculate the vector within the cone (local coordinate system)
-    Vector3 spreadDirection = {
-        sinElevation * cosAzimuth,
-        sinElevation * sinAzimuth,
-        cosElevation
-    };
+    streams[R3D_PARTICLE_POSITION_X][i] = system->position.x;
+    streams[R3D_PARTICLE_POSITION_Y][i] = system->position.y;
+    streams[R3D_PARTICLE_POSITION_Z][i] = system->position.z;
 
-    // Generate the local basis around 'direction'
-    Vector3 arbitraryAxis = (fabsf(direction.y) > 0.9999f)
-        ? (Vector3) { 0.0f, 0.0f, 1.0f }
-        : (Vector3) { 1.0f, 0.0f, 0.0f };
+    streams[R3D_PARTICLE_ROTATION_X][i] = (system->initialRotation.x + r3d_randf_range(&system->seed, -system->rotationVariance.x, system->rotationVariance.x)) * DEG2RAD;
+    streams[R3D_PARTICLE_ROTATION_Y][i] = (system->initialRotation.y + r3d_randf_range(&system->seed, -system->rotationVariance.y, system->rotationVariance.y)) * DEG2RAD;
+    streams[R3D_PARTICLE_ROTATION_Z][i] = (system->initialRotation.z + r3d_randf_range(&system->seed, -system->rotationVariance.z, system->rotationVariance.z)) * DEG2RAD;
 
-    Vector3 binormal = Vector3Normalize(Vector3CrossProduct(arbitraryAxis, direction));
-    Vector3 normal = Vector3CrossProduct(direction, binormal);
+    Vector3 scale = Vector3AddValue(
+        system->initialScale, r3d_randf_range(&system->seed, -system->scaleVariance, system->scaleVariance)
+    );
 
-    // Transform 'spreadDirection' to the global coordinate system
-    Vector3 velocity = {
-        spreadDirection.x * binormal.x + spreadDirection.y * normal.x + spreadDirection.z * direction.x,
-        spreadDirection.x * binormal.y + spreadDirection.y * normal.y + spreadDirection.z * direction.y,
-        spreadDirection.x * binormal.z + spreadDirection.y * normal.z + spreadDirection.z * direction.z
+    streams[R3D_PARTICLE_SCALE_X][i] = streams[R3D_PARTICLE_BASE_SCALE_X][i] = scale.x;
+    streams[R3D_PARTICLE_SCALE_Y][i] = streams[R3D_PARTICLE_BASE_SCALE_Y][i] = scale.y;
+    streams[R3D_PARTICLE_SCALE_Z][i] = streams[R3D_PARTICLE_BASE_SCALE_Z][i] = scale.z;
+
+    streams[R3D_PARTICLE_VELOCITY_X][i] = streams[R3D_PARTICLE_BASE_VELOCITY_X][i] = velocity.x;
+    streams[R3D_PARTICLE_VELOCITY_Y][i] = streams[R3D_PARTICLE_BASE_VELOCITY_Y][i] = velocity.y;
+    streams[R3D_PARTICLE_VELOCITY_Z][i] = streams[R3D_PARTICLE_BASE_VELOCITY_Z][i] = velocity.z;
+
+    streams[R3D_PARTICLE_ANGULAR_VELOCITY_X][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_X][i] =
+        system->initialAngularVelocity.x + r3d_randf_range(&system->seed, -system->angularVelocityVariance.x, system->angularVelocityVariance.x);
+    streams[R3D_PARTICLE_ANGULAR_VELOCITY_Y][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Y][i] =
+        system->initialAngularVelocity.y + r3d_randf_range(&system->seed, -system->angularVelocityVariance.y, system->angularVelocityVariance.y);
+    streams[R3D_PARTICLE_ANGULAR_VELOCITY_Z][i] = streams[R3D_PARTICLE_BASE_ANGULAR_VELOCITY_Z][i] =
+        system->initialAngularVelocity.z + r3d_randf_range(&system->seed, -system->angularVelocityVariance.z, system->angularVelocityVariance.z);
+
+    Color color = {
+        (unsigned char)(system->initialColor.r + r3d_randi_range(&system->seed, -system->colorVariance.r, system->colorVariance.r)),
+        (unsigned char)(system->initialColor.g + r3d_randi_range(&system->seed, -system->colorVariance.g, system->colorVariance.g)),
+        (unsigned char)(system->initialColor.g + r3d_randi_range(&system->seed, -system->colorVariance.b, system->colorVariance.b)),
+        (unsigned char)(system->initialColor.a + r3d_randi_range(&system->seed, -system->colorVariance.a, system->colorVariance.a))
     };
 
-    // Scale the final velocity
-    velocity = Vector3Scale(velocity, Vector3Length(system->initialVelocity));
+    streams[R3D_PARTICLE_BASE_OPACITY][i] = color.a;
 
-    // Initialize particle
-    R3D_Particle particle = { 0 };
+    system->instances[i].color = color;
+    r3d_particles_pack(system, i);
 
-    particle.lifetime = system->lifetime + r3d_randf_range(-system->lifetimeVariance, system->lifetimeVariance);
+    // Keep the bounds valid until the next update refits them
+    if (system->autoBounds) {
+        float maxScale = fmaxf(fabsf(scale.x), fmaxf(fabsf(scale.y), fabsf(scale.z)));
+        if (i == 0) {
+            system->aabb = (BoundingBox) { system->position, system->position };
+            system->boundsScale = maxScale;
+        }
+        else {
+            system->aabb.min = Vector3Min(system->aabb.min, system->position);
+            system->aabb.max = Vector3Max(system->aabb.max, system->position);
+            system->boundsScale = fmaxf(system->boundsScale, maxScale);
+        }
+    }
 
-    particle.position = system->position;
+    return true;
+}
 
-    particle.rotation = (Vector3){
-        (system->initialRotation.x + r3d_randf_range(-system->rotationVariance.x, system->rotationVariance.x)) * DEG2RAD,
-        (system->initialRotation.y + r3d_randf_range(-system->rotationVariance.y, system->rotationVariance.y)) * DEG2RAD,
-        (system->initialRotation.z + r3d_randf_range(-system->rotationVariance.z, system->rotationVariance.z)) * DEG2RAD
-    };
+void R3D_UpdateParticleSystem(R3D_ParticleSystem* system, float deltaTime)
+{
+    R3D_UpdateParticleSystems(&system, 1, deltaTime);
+}
 
-    particle.scale = particle.baseScale = Vector3AddValue(
-        system->initialScale, r3d_randf_range(-system->scaleVariance, system->scaleVariance)
-    );
+void R3D_UpdateParticleSystems(R3D_ParticleSystem** systems, int count, float deltaTime)
+{
+    if (systems == NULL || count <= 0) return;
 
-    particle.transform = r3d_matrix_scale_rotxyz_translate(
-        particle.scale, particle.rotation, particle.position
-    );
+    /* --- Emit from the calling thread, and split the live particles into chunks --- */
 
-    particle.velocity = particle.baseVelocity = (Vector3){
-        velocity.x + r3d_randf_range(-system->velocityVariance.x, system->velocityVariance.x),
-        velocity.y + r3d_randf_range(-system->velocityVariance.y, system->velocityVariance.y),
-        velocity.z + r3d_randf_range(-system->velocityVariance.z, system->velocityVariance.z)
-    };
+    int numChunks = 0;
 
-    particle.angularVelocity = particle.baseAngularVelocity = (Vector3){
-        system->initialAngularVelocity.x + r3d_randf_range(-system->angularVelocityVariance.x, system->angularVelocityVariance.x),
-        system->initialAngularVelocity.y + r3d_randf_range(-system->angularVelocityVariance.y, system->angularVelocityVariance.y),
-        system->initialAngularVelocity.z + r3d_randf_range(-system->angularVelocityVariance.z, system->angularVelocityVariance.z)
-    };
+    for (int i = 0; i < count; i++)
+    {
+        R3D_ParticleSystem* system = systems[i];
 
-    particle.color = (Color){
-        (unsigned char)(system->initialColor.r + GetRandomValue(-system->colorVariance.r, system->colorVariance.r)),
-        (unsigned char)(system->initialColor.g + GetRandomValue(-system->colorVariance.g, system->colorVariance.g)),
-        (unsigned char)(system->initialColor.g + GetRandomValue(-system->colorVariance.b, system->colorVariance.b)),
-        (unsigned char)(system->initialColor.a + GetRandomValue(-system->colorVariance.a, system->colorVariance.a))
-    };
+        if (system->autoEmission && system->emissionRate > 0.0f) {
+            system->emissionTimer -= deltaTime;
+            while (system->emissionTimer <= 0.0f) {
+                system->emissionTimer += 1.0f / system->emissionRate;
+                R3D_EmitParticle(system);
+            }
+        }
 
-    particle.baseOpacity = particle.color.a;
+        if (system->mode == R3D_PARTICLE_MODE_GPU) {
+            r3d_particles_gpu_update(system, deltaTime);
+            continue;
+        }
 
-    // Adding the particle to the system
-    system->particles[system->count++] = particle;
+        numChunks += (system->count + PARTICLES_PER_CHUNK - 1) / PARTICLES_PER_CHUNK;
+    }
 
-    return true;
-}
+    if (numChunks == 0) return;
 
-void R3D_UpdateParticleSystem(R3D_ParticleSystem* system, float deltaTime)
-{
-    if (system->autoEmission && system->emissionRate > 0.0f) {
-        system->emissionTimer -= deltaTime;
-        while (system->emissionTimer <= 0.0f) {
-            system->emissionTimer += 1.0f / system->emissionRate;
-            R3D_EmitParticle(system);
-        }
-    }
+    // A single system or a few chunks are listed on the stack, nothing is allocated per update
+    update_chunk_t stackChunks[PARTICLES_STACK_CHUNKS];
 
-    for (int i = system->count - 1; i >= 0; i--) {
-        R3D_Particle* particle = &system->particles[i];
+    update_context_t ctx = {0};
+    ctx.chunks = (numChunks <= PARTICLES_STACK_CHUNKS) ? stackChunks : RL_MALLOC(numChunks * sizeof(*ctx.chunks));
+    ctx.count = numChunks;
 
-        particle->lifetime -= deltaTime;
-        if (particle->lifetime <= 0.0f) {
-            *particle = system->particles[--system->count];
-            continue;
+    if (ctx.chunks == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the update chunks of %i particle systems", count);
+        return;
+    }
+    ctx.dt = deltaTime;
+    atomic_init(&ctx.nextChunk, 0);
+
+    for (int i = 0, c = 0; i < count; i++) {
+        if (systems[i]->mode == R3D_PARTICLE_MODE_GPU) continue;
+        for (int begin = 0; begin < systems[i]->count; begin += PARTICLES_PER_CHUNK, c++) {
+            ctx.chunks[c].system = systems[i];
+            ctx.chunks[c].begin = begin;
+            ctx.chunks[c].end = (begin + PARTICLES_PER_CHUNK < systems[i]->count)
+                ? begin + PARTICLES_PER_CHUNK : systems[i]->count;
         }
+    }
 
-        float t = 1.0f - (particle->lifetime / system->lifetime);
+    /* --- Simulate the chunks, the calling thread takes its share, a single chunk never starts a thread --- */
 
-        if (system->scaleOverLifetime) {
-            float scale = R3D_EvaluateCurve(*system->scaleOverLifetime, t);
-            particle->scale.x = particle->baseScale.x * scale;
-            particle->scale.y = particle->baseScale.y * scale;
-            particle->scale.z = particle->baseScale.z * scale;
-        }
+    int numThreads = r3d_cpu_count() - 1;
+    if (numThreads > numChunks - 1) numThreads = numChunks - 1;
 
-        if (system->opacityOverLifetime) {
-            float scale = R3D_EvaluateCurve(*system->opacityOverLifetime, t);
-            particle->color.a = (unsigned char)Clamp(particle->baseOpacity * scale, 0.0f, 255.0f);
-        }
+    thrd_t threads[64];
+    if (numThreads > 64) numThreads = 64;
 
-        if (system->speedOverLifetime) {
-            float scale = R3D_EvaluateCurve(*system->speedOverLifetime, t);
-            particle->velocity.x = particle->baseVelocity.x * scale;
-            particle->velocity.y = particle->baseVelocity.y * scale;
-            particle->velocity.z = particle->baseVelocity.z * scale;
+    int launched = 0;
+    for (int i = 0; i < numThreads; i++) {
+        if (thrd_create(&threads[launched], update_worker, &ctx) == thrd_success) {
+            launched++;
         }
+    }
 
-        if (system->angularVelocityOverLifetime) {
-            float scale = R3D_EvaluateCurve(*system->angularVelocityOverLifetime, t);
-            particle->angularVelocity.x = particle->baseAngularVelocity.x * scale;
-            particle->angularVelocity.y = particle->baseAngularVelocity.y * scale;
-            particle->angularVelocity.z = particle->baseAngularVelocity.z * scale;
-        }
+    update_worker(&ctx);
 
-        particle->rotation.x += particle->angularVelocity.x * deltaTime * DEG2RAD;
-        particle->rotation.y += particle->angularVelocity.y * deltaTime * DEG2RAD;
-        particle->rotation.z += particle->angularVelocity.z * deltaTime * DEG2RAD;
+    for (int i = 0; i < launched; i++) {
+        thrd_join(threads[i], NULL);
+    }
 
-        particle->position.x += particle->velocity.x * deltaTime;
-        particle->position.y += particle->velocity.y * deltaTime;
-        particle->position.z += particle->velocity.z * deltaTime;
+    /* --- Merge the live particles of the chunks of each system --- */
 
-        particle->transform = r3d_matrix_scale_rotxyz_translate(
-            particle->scale, particle->rotation, particle->position
-        );
+    for (int c = 0; c < numChunks; ) {
+        int first = c;
+        while (c < numChunks && ctx.chunks[c].system == ctx.chunks[first].system) c++;
+        merge_chunks(&ctx.chunks[first], c - first);
+    }
 
-        particle->velocity.x += system->gravity.x * deltaTime;
-        particle->velocity.y += system->gravity.y * deltaTime;
-        particle->velocity.z += system->gravity.z * deltaTime;
+    if (ctx.chunks != stackChunks) {
+        RL_FREE(ctx.chunks);
     }
 }
 
@@ -266,27 +886,25 @@ void R3D_CalculateParticleSystemBoundingBox(R3D_ParticleSystem* system)
     Vector3 aabbMin = { FLT_MAX, FLT_MAX, FLT_MAX };
     Vector3 aabbMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
-    // Loop over all particles in the emitter (considering the particle capacity)
+    // Sample as many particles as the system can hold, as they would be emitted
     for (int i = 0; i < system->capacity; i++) {
-        // Emit a particle for the current iteration
-        R3D_EmitParticle(system);
-
-        // Get the current particle from the emitter
-        const R3D_Particle* particle = &system->particles[i];
+        float lifetime = r3d_particles_random_lifetime(system);
+        Vector3 position = system->position;
+        Vector3 velocity = r3d_particles_random_velocity(system);
 
         // Calculate the position of the particle at half its lifetime (intermediate position)
-        float halfLifetime = particle->lifetime * 0.5f;
+        float halfLifetime = lifetime * 0.5f;
         Vector3 midPosition = {
-            particle->transform.m12 + particle->velocity.x * halfLifetime + 0.5f * system->gravity.x * halfLifetime * halfLifetime,
-            particle->transform.m13 + particle->velocity.y * halfLifetime + 0.5f * system->gravity.y * halfLifetime * halfLifetime,
-            particle->transform.m14 + particle->velocity.z * halfLifetime + 0.5f * system->gravity.z * halfLifetime * halfLifetime
+            position.x + velocity.x * halfLifetime + 0.5f * system->gravity.x * halfLifetime * halfLifetime,
+            position.y + velocity.y * halfLifetime + 0.5f * system->gravity.y * halfLifetime * halfLifetime,
+            position.z + velocity.z * halfLifetime + 0.5f * system->gravity.z * halfLifetime * halfLifetime
         };
 
         // Calculate the position of the particle at the end of its lifetime (final position)
         Vector3 futurePosition = {
-            particle->transform.m12 + particle->velocity.x * particle->lifetime + 0.5f * system->gravity.x * particle->lifetime * particle->lifetime,
-            particle->transform.m13 + particle->velocity.y * particle->lifetime + 0.5f * system->gravity.y * particle->lifetime * particle->lifetime,
-            particle->transform.m14 + particle->velocity.z * particle->lifetime + 0.5f * system->gravity.z * particle->lifetime * particle->lifetime
+            position.x + velocity.x * lifetime + 0.5f * system->gravity.x * lifetime * lifetime,
+            position.y + velocity.y * lifetime + 0.5f * system->gravity.y * lifetime * lifetime,
+            position.z + velocity.z * lifetime + 0.5f * system->gravity.z * lifetime * lifetime
         };
 
         // Expand the AABB by comparing the current min and max with the calculated positions
@@ -300,9 +918,7 @@ void R3D_CalculateParticleSystemBoundingBox(R3D_ParticleSystem* system)
         aabbMax.z = r3d_max3f(aabbMax.z, midPosition.z, futurePosition.z);
     }
 
-    // Clear any previous state or data in the emitter
-    system->count = 0;
-
-    // Update the particle system's AABB with the calculated bounds
+    // Update the particle system's AABB with the calculated bounds, it is no longer refitted
     system->aabb = (BoundingBox){ aabbMin, aabbMax };
+    system->autoBounds = false;
 }
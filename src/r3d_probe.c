@@ -0,0 +1,246 @@
+/* r3d_probe.h -- R3D Reflection Probe Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_probe.h>
+#include <r3d/r3d_draw.h>
+#include <raymath.h>
+#include <stddef.h>
+#include <string.h>
+#include <rlgl.h>
+
+#include "./details/r3d_mapped_file.h"
+
+#include "./modules/r3d_probe.h"
+#include "./modules/r3d_cache.h"
+
+// ========================================
+// HELPER MACROS
+// ========================================
+
+#define GET_PROBE_OR_RETURN(var_name, id, ...)  \
+    r3d_probe_t* var_name;                      \
+    do {                                        \
+        var_name = r3d_probe_get(id);           \
+        if (var_name == NULL) {                 \
+            TraceLog(LOG_ERROR, "Invalid reflection probe [ID %i] given to '%s'", id, __func__);  \
+            return __VA_ARGS__;                 \
+        }                                       \
+    } while(0)
+
+// ========================================
+// BAKED PROBE FILES
+// ========================================
+
+#define R3D_PROBE_BAKED_MAGIC "R3DP"
+#define R3D_PROBE_BAKED_VERSION 1
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    int32_t size;
+    int32_t levels;
+} r3d_probe_baked_header_t;
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_ReflectionProbe R3D_CreateReflectionProbe(BoundingBox bounds)
+{
+    return r3d_probe_new(bounds);
+}
+
+void R3D_DestroyReflectionProbe(R3D_ReflectionProbe id)
+{
+    r3d_probe_delete(id);
+}
+
+bool R3D_IsReflectionProbeExist(R3D_ReflectionProbe id)
+{
+    return r3d_probe_is_valid(id);
+}
+
+bool R3D_IsReflectionProbeActive(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, false);
+    return probe->enabled;
+}
+
+void R3D_SetReflectionProbeActive(R3D_ReflectionProbe id, bool active)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->enabled = active;
+}
+
+BoundingBox R3D_GetReflectionProbeBounds(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, (BoundingBox) {0});
+    return probe->bounds;
+}
+
+void R3D_SetReflectionProbeBounds(R3D_ReflectionProbe id, BoundingBox bounds)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->bounds = bounds;
+}
+
+Vector3 R3D_GetReflectionProbePosition(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, (Vector3) {0});
+    return probe->position;
+}
+
+void R3D_SetReflectionProbePosition(R3D_ReflectionProbe id, Vector3 position)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->position = position;
+}
+
+float R3D_GetReflectionProbeBlendDistance(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, 0.0f);
+    return probe->blendDistance;
+}
+
+void R3D_SetReflectionProbeBlendDistance(R3D_ReflectionProbe id, float distance)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->blendDistance = distance;
+}
+
+float R3D_GetReflectionProbeIntensity(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, 0.0f);
+    return probe->intensity;
+}
+
+void R3D_SetReflectionProbeIntensity(R3D_ReflectionProbe id, float intensity)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->intensity = intensity;
+}
+
+float R3D_GetReflectionProbeImportance(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, 0.0f);
+    return probe->importance;
+}
+
+void R3D_SetReflectionProbeImportance(R3D_ReflectionProbe id, float importance)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->importance = importance;
+}
+
+R3D_ProbeUpdateMode R3D_GetReflectionProbeUpdateMode(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id, R3D_PROBE_UPDATE_ONCE);
+    return probe->updateMode;
+}
+
+void R3D_SetReflectionProbeUpdateMode(R3D_ReflectionProbe id, R3D_ProbeUpdateMode mode)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->updateMode = mode;
+
+    if (mode == R3D_PROBE_UPDATE_ALWAYS) {
+        probe->pending = true;
+    }
+}
+
+void R3D_UpdateReflectionProbe(R3D_ReflectionProbe id)
+{
+    GET_PROBE_OR_RETURN(probe, id);
+    probe->pending = true;
+}
+
+bool R3D_BeginReflectionProbeCapture(void)
+{
+    Camera3D camera = { 0 };
+    if (!r3d_probe_begin_capture(R3D_CACHE_GET(viewState.viewPosition), &camera)) {
+        return false;
+    }
+
+    R3D_BeginEx(camera, NULL);
+
+    // The faces are square whatever the size of the render targets, they are stretched back when stored
+    r3d_cache_update_view_state(camera, 1.0, rlGetCullDistanceNear(), rlGetCullDistanceFar());
+
+    return true;
+}
+
+bool R3D_SaveReflectionProbe(R3D_ReflectionProbe id, const char* filePath)
+{
+    GET_PROBE_OR_RETURN(probe, id, false);
+
+    if (!probe->captured) {
+        TraceLog(LOG_WARNING, "R3D: Cannot save reflection probe [ID %i] before its first capture", id);
+        return false;
+    }
+
+    r3d_probe_baked_header_t header = {
+        .version = R3D_PROBE_BAKED_VERSION,
+        .size = R3D_PROBE_SIZE,
+        .levels = R3D_PROBE_LEVELS
+    };
+    memcpy(header.magic, R3D_PROBE_BAKED_MAGIC, sizeof(header.magic));
+
+    size_t size = sizeof(header) + r3d_probe_get_data_size();
+
+    unsigned char* data = RL_MALLOC(size);
+    if (data == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the baked reflection probe data");
+        return false;
+    }
+
+    memcpy(data, &header, sizeof(header));
+
+    bool success = r3d_probe_read(id, data + sizeof(header))
+        && SaveFileData(filePath, data, (int)size);
+
+    if (!success) {
+        TraceLog(LOG_WARNING, "R3D: Failed to save baked reflection probe '%s'", filePath);
+    }
+
+    RL_FREE(data);
+
+    return success;
+}
+
+bool R3D_LoadReflectionProbeBaked(R3D_ReflectionProbe id, const char* filePath)
+{
+    GET_PROBE_OR_RETURN(probe, id, false);
+
+    r3d_mapped_file_t file = { 0 };
+    if (!r3d_mapped_file_open(&file, filePath)) {
+        TraceLog(LOG_WARNING, "R3D: Failed to open baked reflection probe '%s'", filePath);
+        return false;
+    }
+
+    r3d_probe_baked_header_t header = { 0 };
+    if (file.size >= sizeof(header)) {
+        memcpy(&header, file.data, sizeof(header));
+    }
+
+    // The size of the probes is fixed, files from another configuration are rejected
+    if (memcmp(header.magic, R3D_PROBE_BAKED_MAGIC, sizeof(header.magic)) != 0
+        || header.version != R3D_PROBE_BAKED_VERSION
+        || header.size != R3D_PROBE_SIZE
+        || header.levels != R3D_PROBE_LEVELS
+        || file.size < sizeof(header) + r3d_probe_get_data_size()) {
+        TraceLog(LOG_WARNING, "R3D: Invalid baked reflection probe '%s'", filePath);
+        r3d_mapped_file_close(&file);
+        return false;
+    }
+
+    bool success = r3d_probe_write(id, (const unsigned char*)file.data + sizeof(header));
+
+    r3d_mapped_file_close(&file);
+
+    return success;
+}
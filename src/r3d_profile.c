@@ -0,0 +1,30 @@
+/* r3d_profile.c -- R3D Profiling Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_profile.h>
+
+#include "./modules/r3d_profile.h"
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_FrameProfile R3D_GetFrameProfile(void)
+{
+    return R3D_MOD_PROFILE.result;
+}
+
+R3D_FrameStats R3D_GetFrameStats(void)
+{
+    return R3D_MOD_PROFILE.lastStats;
+}
+
+const char* R3D_GetProfilePassName(R3D_ProfilePass pass)
+{
+    return r3d_profile_get_pass_name(pass);
+}
@@ -0,0 +1,222 @@
+/* r3d_readback.c -- R3D Readback Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_readback.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <glad.h>
+
+#include "./modules/r3d_pick.h"
+
+// ========================================
+// INTERNAL STRUCTURES
+// ========================================
+
+typedef struct {
+    GLuint buffer;                  //< Pixel pack buffer, resized to the targets read
+    size_t capacity;                //< Size of the storage of 'buffer'
+    GLsync fence;                   //< Signaled once the pixels are in 'buffer'
+    int width;
+    int height;
+    int tag;
+} readback_slot_t;
+
+struct R3D_ReadbackQueue {
+    readback_slot_t* slots;
+    int capacity;
+    int head;                       //< Next slot written by R3D_QueueReadback()
+    int count;                      //< Slots queued and not polled yet
+};
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_ReadbackQueue* R3D_LoadReadbackQueue(int capacity)
+{
+    if (capacity < 1) {
+        TraceLog(LOG_WARNING, "R3D: Invalid readback queue capacity (%i), using 1", capacity);
+        capacity = 1;
+    }
+
+    R3D_ReadbackQueue* queue = RL_CALLOC(1, sizeof(R3D_ReadbackQueue));
+    if (queue == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate the readback queue");
+        return NULL;
+    }
+
+    queue->slots = RL_CALLOC(capacity, sizeof(readback_slot_t));
+    if (queue->slots == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Failed to allocate the readback queue");
+        RL_FREE(queue);
+        return NULL;
+    }
+
+    queue->capacity = capacity;
+
+    // The buffers are created on their first use, with the size of the targets read
+    GLuint* buffers = RL_MALLOC(capacity * sizeof(GLuint));
+    if (buffers != NULL) {
+        glGenBuffers(capacity, buffers);
+        for (int i = 0; i < capacity; i++) {
+            queue->slots[i].buffer = buffers[i];
+        }
+        RL_FREE(buffers);
+    }
+
+    return queue;
+}
+
+void R3D_UnloadReadbackQueue(R3D_ReadbackQueue* queue)
+{
+    if (queue == NULL) return;
+
+    for (int i = 0; i < queue->capacity; i++) {
+        readback_slot_t* slot = &queue->slots[i];
+        if (slot->fence != NULL) glDeleteSync(slot->fence);
+        if (slot->buffer != 0) glDeleteBuffers(1, &slot->buffer);
+    }
+
+    RL_FREE(queue->slots);
+    RL_FREE(queue);
+}
+
+bool R3D_QueueReadback(R3D_ReadbackQueue* queue, const RenderTexture* target, int tag)
+{
+    if (queue == NULL || target == NULL || target->id == 0) {
+        TraceLog(LOG_WARNING, "R3D: Invalid readback target");
+        return false;
+    }
+
+    if (queue->count == queue->capacity) {
+        return false;
+    }
+
+    readback_slot_t* slot = &queue->slots[queue->head];
+    if (slot->buffer == 0) {
+        return false;
+    }
+
+    int w = target->texture.width;
+    int h = target->texture.height;
+    size_t size = (size_t)w * h * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+
+    // The storage is kept between the renders of a batch, they usually share their size
+    if (size > slot->capacity) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        slot->capacity = size;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target->id);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    // The copy is recorded after the frame, glReadPixels returns without waiting for it
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Flushed now so that the fence can signal without a later call from the application
+    slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    slot->width = w;
+    slot->height = h;
+    slot->tag = tag;
+
+    queue->head = (queue->head + 1) % queue->capacity;
+    queue->count++;
+
+    return true;
+}
+
+bool R3D_PollReadback(R3D_ReadbackQueue* queue, Image* image, int* tag, bool wait)
+{
+    if (queue == NULL || image == NULL || queue->count == 0) {
+        return false;
+    }
+
+    int index = (queue->head - queue->count + queue->capacity) % queue->capacity;
+    readback_slot_t* slot = &queue->slots[index];
+
+    GLenum result = glClientWaitSync(slot->fence, 0, 0);
+    while (wait && result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(slot->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+
+    if (result == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+
+    glDeleteSync(slot->fence);
+    slot->fence = NULL;
+    queue->count--;
+
+    size_t rowSize = (size_t)slot->width * 4;
+    size_t size = rowSize * slot->height;
+
+    *image = (Image) {0};
+    if (tag) *tag = slot->tag;
+
+    if (result == GL_WAIT_FAILED) {
+        TraceLog(LOG_WARNING, "R3D: Failed to wait for a readback");
+        return false;
+    }
+
+    uint8_t* pixels = RL_MALLOC(size);
+    if (pixels == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the pixels of a readback");
+        return false;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+
+    const uint8_t* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (mapped == NULL) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        TraceLog(LOG_WARNING, "R3D: Failed to map the pixels of a readback");
+        RL_FREE(pixels);
+        return false;
+    }
+
+    // OpenGL gives the rows from bottom to top
+    for (int y = 0; y < slot->height; y++) {
+        memcpy(pixels + y * rowSize, mapped + (slot->height - 1 - y) * rowSize, rowSize);
+    }
+
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    image->data = pixels;
+    image->width = slot->width;
+    image->height = slot->height;
+    image->mipmaps = 1;
+    image->format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    return true;
+}
+
+int R3D_GetReadbackCount(const R3D_ReadbackQueue* queue)
+{
+    return (queue != NULL) ? queue->count : 0;
+}
+
+bool R3D_RequestPick(Rectangle area, int tag)
+{
+    return r3d_pick_request(area, tag);
+}
+
+bool R3D_PollPick(R3D_PickResult* result, bool wait)
+{
+    if (result == NULL) return false;
+    return r3d_pick_poll(result, wait);
+}
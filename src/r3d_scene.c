@@ -0,0 +1,125 @@
+/* r3d_scene.c -- R3D Scene Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_scene.h>
+#include <raymath.h>
+#include <stddef.h>
+
+#include "./modules/r3d_scene.h"
+
+// ========================================
+// HELPER MACROS
+// ========================================
+
+#define GET_OBJECT_OR_RETURN(var_name, id, ...) \
+    r3d_scene_object_t* var_name;               \
+    do {                                        \
+        var_name = r3d_scene_get(id);           \
+        if (var_name == NULL) {                 \
+            TraceLog(LOG_ERROR, "Invalid scene object [ID %i] given to '%s'", id, __func__);  \
+            return __VA_ARGS__;                 \
+        }                                       \
+    } while(0)
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_SceneObject R3D_CreateSceneModel(const R3D_Model* model, Matrix transform)
+{
+    if (model == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Cannot create a scene object from a NULL model");
+        return -1;
+    }
+
+    return r3d_scene_new(model, NULL, transform);
+}
+
+R3D_SceneObject R3D_CreateSceneMesh(const R3D_Mesh* mesh, const R3D_Material* material, Matrix transform)
+{
+    if (mesh == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Cannot create a scene object from a NULL mesh");
+        return -1;
+    }
+
+    R3D_SceneObject id = r3d_scene_new(NULL, mesh, transform);
+
+    r3d_scene_object_t* object = r3d_scene_get(id);
+    if (object != NULL && material != NULL) {
+        object->material = *material;
+    }
+
+    return id;
+}
+
+void R3D_DestroySceneObject(R3D_SceneObject id)
+{
+    r3d_scene_delete(id);
+}
+
+bool R3D_IsSceneObjectExist(R3D_SceneObject id)
+{
+    return r3d_scene_get(id) != NULL;
+}
+
+bool R3D_IsSceneObjectActive(R3D_SceneObject id)
+{
+    GET_OBJECT_OR_RETURN(object, id, false);
+    return object->active;
+}
+
+void R3D_SetSceneObjectActive(R3D_SceneObject id, bool active)
+{
+    GET_OBJECT_OR_RETURN(object, id);
+    r3d_scene_set_active(object, active);
+}
+
+Matrix R3D_GetSceneObjectTransform(R3D_SceneObject id)
+{
+    GET_OBJECT_OR_RETURN(object, id, MatrixIdentity());
+    return object->transform;
+}
+
+void R3D_SetSceneObjectTransform(R3D_SceneObject id, Matrix transform)
+{
+    GET_OBJECT_OR_RETURN(object, id);
+    r3d_scene_set_transform(object, transform);
+}
+
+void R3D_SetSceneObjectMaterial(R3D_SceneObject id, const R3D_Material* material)
+{
+    GET_OBJECT_OR_RETURN(object, id);
+
+    if (material != NULL) {
+        object->material = *material;
+        object->overrideMaterial = (object->model != NULL);
+    }
+    else {
+        object->material = R3D_GetDefaultMaterial();
+        object->overrideMaterial = false;
+    }
+
+    r3d_scene_touch_static(object);
+}
+
+bool R3D_IsSceneObjectStatic(R3D_SceneObject id)
+{
+    GET_OBJECT_OR_RETURN(object, id, false);
+    return object->isStatic;
+}
+
+void R3D_SetSceneObjectStatic(R3D_SceneObject id, bool isStatic)
+{
+    GET_OBJECT_OR_RETURN(object, id);
+    r3d_scene_set_static(object, isStatic);
+}
+
+int R3D_QuerySceneObjects(BoundingBox box, R3D_SceneObject* objects, int maxObjects)
+{
+    return r3d_scene_query_box(&box, objects, maxObjects);
+}
@@ -12,9 +12,14 @@
 #include <rlgl.h>
 #include <glad.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 
+#include "./modules/r3d_state.h"
+#include "./modules/r3d_cache.h"
+#include "./details/r3d_program_cache.h"
+
 // Include generated shader headers
 #include "shaders/geometry.vert.h"
 #include "shaders/geometry.frag.h"
@@ -23,6 +28,7 @@
 struct R3D_Shader {
     unsigned int program;                                   // OpenGL shader program ID
     R3D_UniformInfo customUniforms[R3D_MAX_CUSTOM_UNIFORMS];
+    uint32_t customHashes[R3D_MAX_CUSTOM_UNIFORMS];          // Hash of the name of each custom uniform
     int customUniformCount;
     int nextTexSlot;                                        // Next available texture slot for custom samplers
 
@@ -37,6 +43,9 @@ struct R3D_Shader {
     int locInstancing;
     int locSkinning;
     int locBillboard;
+    int locCompactVertex;
+    int locPositionMin;
+    int locPositionSize;
     int locTexAlbedo;
     int locTexNormal;
     int locTexEmission;
@@ -47,6 +56,8 @@ struct R3D_Shader {
     int locRoughness;
     int locMetalness;
     int locTexBoneMatrices;
+    int locBoneOffset;
+    int locBakedAnimation;
 };
 
 // Marker in geometry.frag that gets replaced with user code
@@ -59,6 +70,16 @@ struct R3D_Shader {
 // Helper functions
 // ============================================================================
 
+// Helper: FNV-1a hash of a uniform name, compared before the names themselves
+static uint32_t hash_uniform_name(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    for (const char* c = name; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+    return hash;
+}
+
 static GLuint compile_shader_source(const char* source, GLenum shaderType)
 {
     GLuint shader = glCreateShader(shaderType);
@@ -94,6 +115,7 @@ static GLuint link_shader_program(GLuint vertShader, GLuint fragShader)
 
     glAttachShader(program, vertShader);
     glAttachShader(program, fragShader);
+    r3d_program_cache_hint(program);
     glLinkProgram(program);
 
     int success;
@@ -109,6 +131,30 @@ static GLuint link_shader_program(GLuint vertShader, GLuint fragShader)
     return program;
 }
 
+// Compile the geometry vertex shader with the composed fragment shader, and link them
+static GLuint compile_program(const char* composedFrag)
+{
+    // Compile vertex shader (unchanged)
+    GLuint vs = compile_shader_source(GEOMETRY_VERT, GL_VERTEX_SHADER);
+    if (vs == 0) {
+        return 0;
+    }
+
+    // Compile composed fragment shader
+    GLuint fs = compile_shader_source(composedFrag, GL_FRAGMENT_SHADER);
+    if (fs == 0) {
+        glDeleteShader(vs);
+        return 0;
+    }
+
+    // Link program
+    GLuint program = link_shader_program(vs, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    return program;
+}
+
 // Split user code into uniforms (lines starting with "uniform") and body
 // Uniforms need to be inserted after #version, body goes at the marker
 static void split_user_code(const char* userCode, char** outUniforms, char** outBody)
@@ -236,7 +282,8 @@ static void discover_custom_uniforms(R3D_Shader* shader)
         "uTexAlbedo", "uTexNormal", "uTexEmission", "uTexORM", "uTexBoneMatrices",
         "uAlphaCutoff", "uNormalScale", "uOcclusion", "uRoughness", "uMetalness",
         "uAlbedoColor", "uEmissionEnergy", "uEmissionColor",
-        "uTexCoordOffset", "uTexCoordScale", "uInstancing", "uSkinning", "uBillboard",
+        "uTexCoordOffset", "uTexCoordScale", "uInstancing", "uSkinning", "uBoneOffset", "uBakedAnimation", "uBillboard",
+        "uCompactVertex", "uPositionMin", "uPositionSize",
         "uMatModel", "uMatNormal", "ViewBlock", NULL
     };
 
@@ -265,6 +312,7 @@ static void discover_custom_uniforms(R3D_Shader* shader)
         strncpy(info->name, name, R3D_MAX_UNIFORM_NAME_LENGTH - 1);
         info->name[R3D_MAX_UNIFORM_NAME_LENGTH - 1] = '\0';
         info->location = glGetUniformLocation(shader->program, name);
+        shader->customHashes[shader->customUniformCount - 1] = hash_uniform_name(info->name);
 
         // Map GL type to our enum
         switch (type) {
@@ -288,7 +336,7 @@ static void discover_custom_uniforms(R3D_Shader* shader)
                 info->type = R3D_PARAM_TEX2D;
                 info->texSlot = shader->nextTexSlot++;
                 // Set the sampler uniform to its texture slot
-                glUseProgram(shader->program);
+                r3d_state_use_program(shader->program);
                 glUniform1i(info->location, info->texSlot);
                 break;
             default:
@@ -321,6 +369,9 @@ static void cache_builtin_uniforms(R3D_Shader* shader)
     shader->locInstancing = glGetUniformLocation(shader->program, "uInstancing");
     shader->locSkinning = glGetUniformLocation(shader->program, "uSkinning");
     shader->locBillboard = glGetUniformLocation(shader->program, "uBillboard");
+    shader->locCompactVertex = glGetUniformLocation(shader->program, "uCompactVertex");
+    shader->locPositionMin = glGetUniformLocation(shader->program, "uPositionMin");
+    shader->locPositionSize = glGetUniformLocation(shader->program, "uPositionSize");
     shader->locTexAlbedo = glGetUniformLocation(shader->program, "uTexAlbedo");
     shader->locTexNormal = glGetUniformLocation(shader->program, "uTexNormal");
     shader->locTexEmission = glGetUniformLocation(shader->program, "uTexEmission");
@@ -331,6 +382,8 @@ static void cache_builtin_uniforms(R3D_Shader* shader)
     shader->locRoughness = glGetUniformLocation(shader->program, "uRoughness");
     shader->locMetalness = glGetUniformLocation(shader->program, "uMetalness");
     shader->locTexBoneMatrices = glGetUniformLocation(shader->program, "uTexBoneMatrices");
+    shader->locBoneOffset = glGetUniformLocation(shader->program, "uBoneOffset");
+    shader->locBakedAnimation = glGetUniformLocation(shader->program, "uBakedAnimation");
 }
 
 // ============================================================================
@@ -359,26 +412,19 @@ R3D_Shader* R3D_CreateCustomShader(const char* fragmentCode)
         return NULL;
     }
 
-    // Compile vertex shader (unchanged)
-    GLuint vs = compile_shader_source(GEOMETRY_VERT, GL_VERTEX_SHADER);
-    if (vs == 0) {
-        RL_FREE(composedFrag);
-        return NULL;
-    }
-
-    // Compile composed fragment shader
-    GLuint fs = compile_shader_source(composedFrag, GL_FRAGMENT_SHADER);
-    RL_FREE(composedFrag);
+    // Load the program binary of a previous run if available
+    const char* sources[] = { GEOMETRY_VERT, composedFrag };
+    uint64_t key = r3d_program_cache_key(sources, 2);
 
-    if (fs == 0) {
-        glDeleteShader(vs);
-        return NULL;
+    GLuint program = r3d_program_cache_load(R3D_MOD_CACHE.programCacheDir, key);
+    if (program == 0) {
+        program = compile_program(composedFrag);
+        if (program != 0) {
+            r3d_program_cache_store(R3D_MOD_CACHE.programCacheDir, key, program);
+        }
     }
 
-    // Link program
-    GLuint program = link_shader_program(vs, fs);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    RL_FREE(composedFrag);
 
     if (program == 0) {
         return NULL;
@@ -406,13 +452,13 @@ R3D_Shader* R3D_CreateCustomShader(const char* fragmentCode)
     }
 
     // Set built-in sampler uniforms to their texture slots (same as default geometry shader)
-    glUseProgram(program);
+    r3d_state_use_program(program);
     if (shader->locTexBoneMatrices >= 0) glUniform1i(shader->locTexBoneMatrices, 0);
     if (shader->locTexAlbedo >= 0) glUniform1i(shader->locTexAlbedo, 1);
     if (shader->locTexNormal >= 0) glUniform1i(shader->locTexNormal, 2);
     if (shader->locTexEmission >= 0) glUniform1i(shader->locTexEmission, 3);
     if (shader->locTexORM >= 0) glUniform1i(shader->locTexORM, 4);
-    glUseProgram(0);
+    r3d_state_use_program(0);
 
     TraceLog(LOG_INFO, "R3D_CreateCustomShader: Created custom shader (program=%u)", program);
 
@@ -430,6 +476,19 @@ void R3D_DestroyCustomShader(R3D_Shader* shader)
     RL_FREE(shader);
 }
 
+// Helper: Find the custom uniform of a shader by name, returns -1 if not found
+static int find_custom_uniform(const R3D_Shader* shader, const char* name)
+{
+    uint32_t hash = hash_uniform_name(name);
+
+    for (int i = 0; i < shader->customUniformCount; i++) {
+        if (shader->customHashes[i] == hash && strcmp(shader->customUniforms[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 // Helper: Find or create a parameter slot in a material
 static R3D_MaterialParam* FindOrCreateParam(R3D_Material* material, const char* name, R3D_ParamType type)
 {
@@ -520,19 +579,14 @@ void R3D_BindCustomUniforms(const R3D_Shader* shader, const R3D_Material* materi
 {
     if (!shader || !material) return;
 
-    for (int i = 0; i < shader->customUniformCount; i++) {
-        const R3D_UniformInfo* info = &shader->customUniforms[i];
+    for (int i = 0; i < material->paramCount; i++) {
+        const R3D_MaterialParam* param = &material->params[i];
 
-        // Find matching param in material
-        const R3D_MaterialParam* param = NULL;
-        for (int j = 0; j < material->paramCount; j++) {
-            if (strcmp(material->params[j].name, info->name) == 0) {
-                param = &material->params[j];
-                break;
-            }
-        }
+        // The names are matched through their hashes, the material is left untouched
+        int uniformIndex = find_custom_uniform(shader, param->name);
+        if (uniformIndex < 0) continue; // Not used by the shader
 
-        if (!param) continue; // Param not set on material
+        const R3D_UniformInfo* info = &shader->customUniforms[uniformIndex];
 
         // Bind based on type
         switch (info->type) {
@@ -549,8 +603,7 @@ void R3D_BindCustomUniforms(const R3D_Shader* shader, const R3D_Material* materi
                 glUniform4fv(info->location, 1, param->value.v4);
                 break;
             case R3D_PARAM_TEX2D:
-                glActiveTexture(GL_TEXTURE0 + info->texSlot);
-                glBindTexture(GL_TEXTURE_2D, param->value.tex.id);
+                r3d_state_bind_texture(info->texSlot, GL_TEXTURE_2D, param->value.tex.id);
                 break;
         }
     }
@@ -611,12 +664,42 @@ void R3D_CustomShaderSetSkinning(const R3D_Shader* shader, int value)
         glUniform1i(shader->locSkinning, value);
 }
 
+void R3D_CustomShaderSetBoneOffset(const R3D_Shader* shader, int value)
+{
+    if (shader && shader->locBoneOffset >= 0)
+        glUniform1i(shader->locBoneOffset, value);
+}
+
+void R3D_CustomShaderSetBakedAnimation(const R3D_Shader* shader, int value)
+{
+    if (shader && shader->locBakedAnimation >= 0)
+        glUniform1i(shader->locBakedAnimation, value);
+}
+
 void R3D_CustomShaderSetBillboard(const R3D_Shader* shader, int value)
 {
     if (shader && shader->locBillboard >= 0)
         glUniform1i(shader->locBillboard, value);
 }
 
+void R3D_CustomShaderSetCompactVertex(const R3D_Shader* shader, int value)
+{
+    if (shader && shader->locCompactVertex >= 0)
+        glUniform1i(shader->locCompactVertex, value);
+}
+
+void R3D_CustomShaderSetPositionMin(const R3D_Shader* shader, float x, float y, float z)
+{
+    if (shader && shader->locPositionMin >= 0)
+        glUniform3f(shader->locPositionMin, x, y, z);
+}
+
+void R3D_CustomShaderSetPositionSize(const R3D_Shader* shader, float x, float y, float z)
+{
+    if (shader && shader->locPositionSize >= 0)
+        glUniform3f(shader->locPositionSize, x, y, z);
+}
+
 void R3D_CustomShaderSetAlphaCutoff(const R3D_Shader* shader, float value)
 {
     if (shader && shader->locAlphaCutoff >= 0)
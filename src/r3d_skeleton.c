@@ -12,6 +12,7 @@
 #include <glad.h>
 
 #include "./importer/r3d_importer.h"
+#include "./modules/r3d_skin.h"
 
 // ========================================
 // PUBLIC API
@@ -49,9 +50,7 @@ R3D_Skeleton R3D_LoadSkeletonFromData(const void* data, unsigned int size, const
 
 void R3D_UnloadSkeleton(R3D_Skeleton* skeleton)
 {
-    if (skeleton->texBindPose > 0) {
-        glDeleteTextures(1, &skeleton->texBindPose);
-    }
+    r3d_skin_free(skeleton->bindPoseOffset, skeleton->boneCount);
 
     RL_FREE(skeleton->bones);
     RL_FREE(skeleton->boneOffsets);
@@ -61,5 +60,5 @@ void R3D_UnloadSkeleton(R3D_Skeleton* skeleton)
 
 bool R3D_IsSkeletonValid(const R3D_Skeleton* skeleton)
 {
-    return (skeleton->texBindPose > 0);
+    return (skeleton->boneCount > 0 && skeleton->bindPoseOffset >= 0);
 }
@@ -10,18 +10,76 @@
 #include <raymath.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <assert.h>
 #include <rlgl.h>
 #include <glad.h>
 
+#include "./details/r3d_mapped_file.h"
+#include "./details/r3d_half.h"
+
 #include "./modules/r3d_primitive.h"
 #include "./modules/r3d_shader.h"
 #include "./modules/r3d_cache.h"
+#include "./modules/r3d_state.h"
 
 // ========================================
 // INTERNAL FUNCTIONS
 // ========================================
 
+/*
+ * Returns the half float format storing the float formats, zero for the other formats.
+ * The driver converts the floats during the upload, without any intermediate copy.
+ */
+static GLenum r3d_skybox_get_half_format(int format)
+{
+    switch (format) {
+    case PIXELFORMAT_UNCOMPRESSED_R32: return GL_R16F;
+    case PIXELFORMAT_UNCOMPRESSED_R32G32B32: return GL_RGB16F;
+    case PIXELFORMAT_UNCOMPRESSED_R32G32B32A32: return GL_RGBA16F;
+    default: break;
+    }
+    return 0;
+}
+
+/*
+ * Converts the pixels of a float image to half floats in place, then shrinks its storage.
+ * Used for the images decoded by the skybox itself, which are only uploaded afterwards.
+ */
+static void r3d_skybox_pack_half(Image* image)
+{
+    int channels = 0;
+    int halfFormat = 0;
+
+    switch (image->format) {
+    case PIXELFORMAT_UNCOMPRESSED_R32: channels = 1, halfFormat = PIXELFORMAT_UNCOMPRESSED_R16; break;
+    case PIXELFORMAT_UNCOMPRESSED_R32G32B32: channels = 3, halfFormat = PIXELFORMAT_UNCOMPRESSED_R16G16B16; break;
+    case PIXELFORMAT_UNCOMPRESSED_R32G32B32A32: channels = 4, halfFormat = PIXELFORMAT_UNCOMPRESSED_R16G16B16A16; break;
+    default: return;
+    }
+
+    if (image->data == NULL || image->mipmaps != 1) {
+        return;
+    }
+
+    // Each half is written over floats that were already read
+    unsigned char* bytes = image->data;
+    size_t count = (size_t)image->width * image->height * channels;
+
+    for (size_t i = 0; i < count; i++) {
+        float value;
+        memcpy(&value, bytes + i * sizeof(float), sizeof(float));
+        r3d_half_t half = r3d_cvt_fh(value);
+        memcpy(bytes + i * sizeof(r3d_half_t), &half, sizeof(r3d_half_t));
+    }
+
+    void* data = RL_REALLOC(image->data, count * sizeof(r3d_half_t));
+    if (data != NULL) image->data = data;
+
+    image->format = halfFormat;
+}
+
 static TextureCubemap r3d_skybox_load_cubemap_from_layout(const Image* image, CubemapLayout layout)
 {
     TextureCubemap cubemap = { 0 };
@@ -71,157 +129,243 @@ static TextureCubemap r3d_skybox_load_cubemap_from_layout(const Image* image, Cu
 
     int size = cubemap.width;
 
-    bool facesAllocatedHere = false;    //< Indicates whether we are even allocated the faces...
-    Image faces = { 0 };                //< Vertical column image
+    if (image->format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        TraceLog(LOG_WARNING, "R3D: Failed to load cubemap image; compressed layouts are not supported");
+        return (TextureCubemap) { 0 };
+    }
+
+    // NOTE: Faces follow the convention +X, -X, +Y, -Y, +Z, -Z
+    Rectangle srcRecs[6] = { 0 };
 
     if (layout == CUBEMAP_LAYOUT_LINE_VERTICAL) {
-        faces = *image; // Image data already follows expected convention
+        for (int i = 0; i < 6; i++) {
+            srcRecs[i].y = (float)i * size;
+        }
     }
     //else if (layout == CUBEMAP_LAYOUT_PANORAMA) {
     //    // REVIEW: CUBEMAP_LAYOUT_PANORAMA does not yet exist in raylib...
     //    //         We currently manage it in a separate function...
     //}
-    else
-    {
-        Rectangle srcRecs[6] = { 0 };
-
+    else if (layout == CUBEMAP_LAYOUT_LINE_HORIZONTAL) {
         for (int i = 0; i < 6; i++) {
-            srcRecs[i] = (Rectangle){ 0, 0, (float)size, (float)size };
+            srcRecs[i].x = (float)i * size;
         }
+    }
+    else if (layout == CUBEMAP_LAYOUT_CROSS_THREE_BY_FOUR) {
+        srcRecs[0].x = (float)size; srcRecs[0].y = (float)size;
+        srcRecs[1].x = (float)size; srcRecs[1].y = 3.0f * size;
+        srcRecs[2].x = (float)size; srcRecs[2].y = 0;
+        srcRecs[3].x = (float)size; srcRecs[3].y = 2.0f * size;
+        srcRecs[4].x = 0;           srcRecs[4].y = (float)size;
+        srcRecs[5].x = 2.0f * size; srcRecs[5].y = (float)size;
+    }
+    else if (layout == CUBEMAP_LAYOUT_CROSS_FOUR_BY_THREE) {
+        srcRecs[0].x = 2.0f * size; srcRecs[0].y = (float)size;
+        srcRecs[1].x = 0;           srcRecs[1].y = (float)size;
+        srcRecs[2].x = (float)size; srcRecs[2].y = 0;
+        srcRecs[3].x = (float)size; srcRecs[3].y = 2.0f * size;
+        srcRecs[4].x = (float)size; srcRecs[4].y = (float)size;
+        srcRecs[5].x = 3.0f * size; srcRecs[5].y = (float)size;
+    }
 
-        if (layout == CUBEMAP_LAYOUT_LINE_HORIZONTAL) {
-            for (int i = 0; i < 6; i++) {
-                srcRecs[i].x = (float)i * size;
-            }
-        }
-        else if (layout == CUBEMAP_LAYOUT_CROSS_THREE_BY_FOUR) {
-            srcRecs[0].x = (float)size; srcRecs[0].y = (float)size;
-            srcRecs[1].x = (float)size; srcRecs[1].y = 3.0f * size;
-            srcRecs[2].x = (float)size; srcRecs[2].y = 0;
-            srcRecs[3].x = (float)size; srcRecs[3].y = 2.0f * size;
-            srcRecs[4].x = 0;           srcRecs[4].y = (float)size;
-            srcRecs[5].x = 2.0f * size; srcRecs[5].y = (float)size;
-        }
-        else if (layout == CUBEMAP_LAYOUT_CROSS_FOUR_BY_THREE) {
-            srcRecs[0].x = 2.0f * size; srcRecs[0].y = (float)size;
-            srcRecs[1].x = 0;           srcRecs[1].y = (float)size;
-            srcRecs[2].x = (float)size; srcRecs[2].y = 0;
-            srcRecs[3].x = (float)size; srcRecs[3].y = 2.0f * size;
-            srcRecs[4].x = (float)size; srcRecs[4].y = (float)size;
-            srcRecs[5].x = 3.0f * size; srcRecs[5].y = (float)size;
-        }
+    /* --- Upload each face straight from its rectangle in the image, without copying it first --- */
 
-        /* --- Convert image data to 6 faces in a vertical column, that's the optimum layout for loading --- */
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    rlGetGlTextureFormats(image->format, &glInternalFormat, &glFormat, &glType);
 
-        faces.width = size;
-        faces.height = 6 * size;
-        faces.format = image->format;
-        faces.mipmaps = 1;
+    GLenum halfFormat = r3d_skybox_get_half_format(image->format);
+    if (halfFormat != 0) glInternalFormat = halfFormat;
 
-        int bytesPerPixel = GetPixelDataSize(1, 1, image->format);
-        faces.data = RL_CALLOC(size * size * 6 * bytesPerPixel, 1);
-        facesAllocatedHere = true;
+    glGenTextures(1, &cubemap.id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, cubemap.id);
 
-        // NOTE: Image formatting does not work with compressed textures
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, image->width);
 
-        for (int i = 0; i < 6; i++) {
-            Rectangle dstRec = (Rectangle){ 0, (float)i * size, (float)size, (float)size };
-            ImageDraw(&faces, *image, srcRecs[i], dstRec, WHITE);
-        }
+    for (int i = 0; i < 6; i++) {
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, (int)srcRecs[i].x);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, (int)srcRecs[i].y);
+        glTexImage2D(
+            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, glInternalFormat,
+            size, size, 0, glFormat, glType, image->data
+        );
     }
 
-    // NOTE: Cubemap data is expected to be provided as 6 images in a single data array,
-    // one after the other (that's a vertical image), following convention: +X, -X, +Y, -Y, +Z, -Z
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    cubemap.format = image->format;
+    cubemap.mipmaps = 1;
 
-    cubemap.id = rlLoadTextureCubemap(faces.data, size, faces.format, faces.mipmaps);
-    if (cubemap.id == 0) {
-        TraceLog(LOG_WARNING, "R3D: Failed to load cubemap image");
-        goto cleanup;
+    // Same swizzles as the textures loaded by raylib
+    if (image->format == PIXELFORMAT_UNCOMPRESSED_GRAYSCALE) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    else if (image->format == PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA) {
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+        glTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
     }
-    cubemap.format = faces.format;
-    cubemap.mipmaps = faces.mipmaps;
 
     // Generate mipmaps and set texture parameters
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap.id);
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-cleanup:
-    if (facesAllocatedHere) {
-        UnloadImage(faces);
-    }
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
 
     return cubemap;
 }
 
-static TextureCubemap r3d_skybox_load_cubemap_from_panorama(Image image, int size)
-{
-    // Temporarily loads the panorama
-    Texture2D panorama = LoadTextureFromImage(image);
-    SetTextureFilter(panorama, TEXTURE_FILTER_BILINEAR);
+#define R3D_SKYBOX_PREFILTER_SIZE   128
+#define R3D_SKYBOX_PREFILTER_LEVELS 8       //< 1 + (int)floor(log2(R3D_SKYBOX_PREFILTER_SIZE))
+#define R3D_SKYBOX_SH_SAMPLE_SIZE   32
 
-    // Create the skybox cubemap texture
-    unsigned int cubemapId = 0;
-    glGenTextures(1, &cubemapId);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapId);
-    for (int i = 0; i < 6; i++) {
-        glTexImage2D(
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F,
-            size, size, 0, GL_RGB, GL_FLOAT, NULL
-        );
+static GLuint r3d_skybox_alloc_cubemap(int size, int levels)
+{
+    GLuint id = 0;
+    glGenTextures(1, &id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, id);
+    for (int face = 0; face < 6; face++) {
+        for (int level = 0; level < levels; level++) {
+            int levelSize = (size >> level > 0) ? size >> level : 1;
+            glTexImage2D(
+                GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB16F,
+                levelSize, levelSize, 0, GL_RGB, GL_FLOAT, NULL
+            );
+        }
     }
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
+    return id;
+}
+
+static void r3d_skybox_generate_mipmaps(GLuint id)
+{
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, id);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
+}
+
+static void r3d_skybox_begin_passes(GLuint fbo)
+{
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, fbo);
+    r3d_state_disable(GL_CULL_FACE);
+}
 
-    // Create and configure the working framebuffer
-    unsigned int fbo = rlLoadFramebuffer();
+static void r3d_skybox_end_passes(void)
+{
+    // Reset framebuffer, viewport and re-enable culling
+    r3d_state_bind_framebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
+    r3d_state_enable(GL_CULL_FACE);
+}
 
-    // Calculate projection matrix
+static void r3d_skybox_setup_panorama_shader(GLuint panoramaId)
+{
     const Matrix matProj = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
 
-    // Enable and configure the shader for converting panorama to cubemap
     R3D_SHADER_USE(prepare.cubemapFromEquirectangular);
     R3D_SHADER_SET_MAT4(prepare.cubemapFromEquirectangular, uMatProj, matProj);
-    R3D_SHADER_BIND_SAMPLER_2D(prepare.cubemapFromEquirectangular, uTexEquirectangular, panorama.id);
+    R3D_SHADER_BIND_SAMPLER_2D(prepare.cubemapFromEquirectangular, uTexEquirectangular, panoramaId);
+}
 
-    // Set viewport to framebuffer dimensions
+static void r3d_skybox_render_panorama_face(GLuint cubemapId, int size, int face)
+{
     glViewport(0, 0, size, size);
-    glDisable(GL_CULL_FACE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemapId, 0);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    R3D_SHADER_SET_MAT4(prepare.cubemapFromEquirectangular, uMatView, R3D_CACHE_GET(matCubeViews[face]));
+    R3D_PRIMITIVE_DRAW_CUBE();
+}
 
-    // Bind the working framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+static void r3d_skybox_setup_prefilter_shader(TextureCubemap sky)
+{
+    const Matrix matProj = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
 
-    // Loop through and render each cubemap face
-    for (int i = 0; i < 6; i++) {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubemapId, 0);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        R3D_SHADER_SET_MAT4(prepare.cubemapFromEquirectangular, uMatView, R3D_CACHE_GET(matCubeViews[i]));
-        R3D_PRIMITIVE_DRAW_CUBE();
+    R3D_SHADER_USE(prepare.cubemapPrefilter);
+    R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatProj, matProj);
+    R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uResolution, (float)sky.width);
+    R3D_SHADER_BIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap, sky.id);
+}
+
+static void r3d_skybox_render_prefilter_face(GLuint prefilterId, int mip, int face)
+{
+    int mipSize = R3D_SKYBOX_PREFILTER_SIZE >> mip;
+    float roughness = (float)mip / (float)(R3D_SKYBOX_PREFILTER_LEVELS - 1);
+
+    glViewport(0, 0, mipSize, mipSize);
+    R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uRoughness, roughness);
+    R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatView, R3D_CACHE_GET(matCubeViews[face]));
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, prefilterId, mip);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    R3D_PRIMITIVE_DRAW_CUBE();
+}
+
+static Texture2D r3d_skybox_upload_panorama(Image image)
+{
+    GLenum halfFormat = r3d_skybox_get_half_format(image.format);
+
+    if (halfFormat == 0) {
+        Texture2D panorama = LoadTextureFromImage(image);
+        SetTextureFilter(panorama, TEXTURE_FILTER_BILINEAR);
+        return panorama;
     }
 
-    // Unbind texture
+    // Float panoramas are stored in half precision, like the cubemap they are projected into
+    unsigned int glInternalFormat = 0, glFormat = 0, glType = 0;
+    rlGetGlTextureFormats(image.format, &glInternalFormat, &glFormat, &glType);
+
+    Texture2D panorama = {
+        .width = image.width,
+        .height = image.height,
+        .mipmaps = 1,
+        .format = image.format
+    };
+
+    glGenTextures(1, &panorama.id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, panorama.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, halfFormat, image.width, image.height, 0, glFormat, glType, image.data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_2D, 0);
+
+    return panorama;
+}
+
+static TextureCubemap r3d_skybox_load_cubemap_from_panorama(Image image, int size)
+{
+    // Temporarily loads the panorama
+    Texture2D panorama = r3d_skybox_upload_panorama(image);
+
+    // Create the skybox cubemap texture and the working framebuffer
+    GLuint cubemapId = r3d_skybox_alloc_cubemap(size, 1);
+    GLuint fbo = rlLoadFramebuffer();
+
+    // Render each cubemap face from the panorama
+    r3d_skybox_begin_passes(fbo);
+    r3d_skybox_setup_panorama_shader(panorama.id);
+    for (int i = 0; i < 6; i++) {
+        r3d_skybox_render_panorama_face(cubemapId, size, i);
+    }
     R3D_SHADER_UNBIND_SAMPLER_2D(prepare.cubemapFromEquirectangular, uTexEquirectangular);
+    r3d_skybox_end_passes();
 
-    // Cleanup the working framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
     glDeleteFramebuffers(1, &fbo);
 
-    // Reset viewport and re-enable culling
-    glViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-    glEnable(GL_CULL_FACE);
-
-    // Generate mipmaps and set texture parameters
-    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapId);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    r3d_skybox_generate_mipmaps(cubemapId);
 
     // Return cubemap texture
     TextureCubemap cubemap = {
@@ -229,7 +373,7 @@ static TextureCubemap r3d_skybox_load_cubemap_from_panorama(Image image, int siz
         .width = size,
         .height = size,
         .mipmaps = 1,
-        .format = panorama.format
+        .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
     };
 
     // Download the temporary panorama
@@ -238,158 +382,315 @@ static TextureCubemap r3d_skybox_load_cubemap_from_panorama(Image image, int siz
     return cubemap;
 }
 
-static TextureCubemap r3d_skybox_generate_irradiance(TextureCubemap sky)
+static int r3d_skybox_sh_sample_level(int skySize, int* size)
 {
-    // Compute irradiance resolution
-    int size = sky.width / 16;
-    if (size < 32) size = 32;
+    // The mipmaps of the sky are enough for such a low frequency signal
+    int level = 0;
+    *size = skySize;
+    while (*size > R3D_SKYBOX_SH_SAMPLE_SIZE) {
+        *size /= 2, level++;
+    }
+    return level;
+}
 
-    // Create the irradiance cubemap texture
-    unsigned int irradianceId = 0;
-    glGenTextures(1, &irradianceId);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceId);
-    for (int i = 0; i < 6; i++) {
-        glTexImage2D(
-            GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F,
-            size, size, 0, GL_RGB, GL_FLOAT, NULL
-        );
+static void r3d_skybox_project_sh(const float* pixels, int size, Vector3 sh[9])
+{
+    /* --- Project the radiance on the L2 basis, each texel weighted by its solid angle --- */
+
+    double coeffs[9][3] = { 0 };
+    double totalWeight = 0.0;
+
+    for (int face = 0; face < 6; face++) {
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                float u = 2.0f * (x + 0.5f) / size - 1.0f;
+                float v = 2.0f * (y + 0.5f) / size - 1.0f;
+
+                // Same conventions as the OpenGL cubemap lookups
+                Vector3 dir = { 0 };
+                switch (face) {
+                case 0: dir = (Vector3) { 1.0f, -v, -u }; break;
+                case 1: dir = (Vector3) { -1.0f, -v, u }; break;
+                case 2: dir = (Vector3) { u, 1.0f, v }; break;
+                case 3: dir = (Vector3) { u, -1.0f, -v }; break;
+                case 4: dir = (Vector3) { u, -v, 1.0f }; break;
+                case 5: dir = (Vector3) { -u, -v, -1.0f }; break;
+                }
+
+                float d2 = 1.0f + u * u + v * v;
+                float weight = 1.0f / (d2 * sqrtf(d2));
+                dir = Vector3Scale(dir, 1.0f / sqrtf(d2));
+
+                float basis[9] = {
+                    0.282095f,
+                    0.488603f * dir.y,
+                    0.488603f * dir.z,
+                    0.488603f * dir.x,
+                    1.092548f * dir.x * dir.y,
+                    1.092548f * dir.y * dir.z,
+                    0.315392f * (3.0f * dir.z * dir.z - 1.0f),
+                    1.092548f * dir.x * dir.z,
+                    0.546274f * (dir.x * dir.x - dir.y * dir.y)
+                };
+
+                const float* texel = pixels + 3 * ((face * size + y) * size + x);
+                for (int i = 0; i < 9; i++) {
+                    float w = basis[i] * weight;
+                    coeffs[i][0] += texel[0] * w;
+                    coeffs[i][1] += texel[1] * w;
+                    coeffs[i][2] += texel[2] * w;
+                }
+
+                totalWeight += weight;
+            }
+        }
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Create and configure the working framebuffer
-    unsigned int fbo = rlLoadFramebuffer();
+    /* --- Convolve with the cosine lobe, divided by PI like the diffuse BRDF --- */
 
-    // Calculate projection matrix
-    const Matrix matProj = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+    static const double BAND_FACTORS[9] = {
+        1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25, 0.25, 0.25, 0.25, 0.25
+    };
 
-    // Enable and configure irradiance convolution shader
-    R3D_SHADER_USE(prepare.cubemapIrradiance);
-    R3D_SHADER_SET_MAT4(prepare.cubemapIrradiance, uMatProj, matProj);
-    R3D_SHADER_BIND_SAMPLER_CUBE(prepare.cubemapIrradiance, uCubemap, sky.id);
+    double norm = 4.0 * PI / totalWeight;
+    for (int i = 0; i < 9; i++) {
+        sh[i].x = (float)(coeffs[i][0] * norm * BAND_FACTORS[i]);
+        sh[i].y = (float)(coeffs[i][1] * norm * BAND_FACTORS[i]);
+        sh[i].z = (float)(coeffs[i][2] * norm * BAND_FACTORS[i]);
+    }
+}
 
-    // Set viewport to framebuffer dimensions
-    glViewport(0, 0, size, size);
-    glDisable(GL_CULL_FACE);
+static void r3d_skybox_compute_irradiance_sh(TextureCubemap sky, Vector3 sh[9])
+{
+    memset(sh, 0, 9 * sizeof(Vector3));
+    if (sky.id == 0) return;
 
-    // Bind the working framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    int size = 0;
+    int level = r3d_skybox_sh_sample_level(sky.width, &size);
 
-    // Render irradiance to cubemap faces
-    for (int i = 0; i < 6; i++) {
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceId, 0);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        R3D_SHADER_SET_MAT4(prepare.cubemapIrradiance, uMatView, R3D_CACHE_GET(matCubeViews[i]));
-        R3D_PRIMITIVE_DRAW_CUBE();
+    float* pixels = RL_MALLOC(6 * size * size * 3 * sizeof(float));
+    if (pixels == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the skybox irradiance samples");
+        return;
     }
 
-    // Unbind texture
-    R3D_SHADER_UNBIND_SAMPLER_CUBE(prepare.cubemapIrradiance, uCubemap);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, sky.id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int face = 0; face < 6; face++) {
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_FLOAT, pixels + face * size * size * 3);
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
 
-    // Cleanup the working framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &fbo);
+    r3d_skybox_project_sh(pixels, size, sh);
 
-    // Reset viewport and re-enable culling
-    glViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-    glEnable(GL_CULL_FACE);
+    RL_FREE(pixels);
+}
 
-    // Return irradiance cubemap
-    TextureCubemap irradiance = {
-        .id = irradianceId,
-        .width = size,
-        .height = size,
-        .mipmaps = 1,
-        .format = RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32
+static TextureCubemap r3d_skybox_generate_prefilter(TextureCubemap sky)
+{
+    // Create the prefilter cubemap texture and the working framebuffer
+    GLuint prefilterId = r3d_skybox_alloc_cubemap(R3D_SKYBOX_PREFILTER_SIZE, R3D_SKYBOX_PREFILTER_LEVELS);
+    GLuint fbo = rlLoadFramebuffer();
+
+    // Render all faces of each mipmap level
+    r3d_skybox_begin_passes(fbo);
+    r3d_skybox_setup_prefilter_shader(sky);
+    for (int mip = 0; mip < R3D_SKYBOX_PREFILTER_LEVELS; mip++) {
+        for (int i = 0; i < 6; i++) {
+            r3d_skybox_render_prefilter_face(prefilterId, mip, i);
+        }
+    }
+    R3D_SHADER_UNBIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap);
+    r3d_skybox_end_passes();
+
+    glDeleteFramebuffers(1, &fbo);
+
+    // Return prefiltered cubemap
+    TextureCubemap prefilter = {
+        .id = prefilterId,
+        .width = R3D_SKYBOX_PREFILTER_SIZE,
+        .height = R3D_SKYBOX_PREFILTER_SIZE,
+        .mipmaps = R3D_SKYBOX_PREFILTER_LEVELS,
+        .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
     };
 
-    return irradiance;
+    return prefilter;
 }
 
-static TextureCubemap r3d_skybox_generate_prefilter(TextureCubemap sky)
+// ========================================
+// BAKED SKYBOX FILES
+// ========================================
+
+#define R3D_SKYBOX_BAKED_MAGIC "R3DS"
+#define R3D_SKYBOX_BAKED_VERSION 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    int32_t cubemapSize;            //< Only the first level is stored, the others are generated
+    int32_t prefilterSize;
+    int32_t prefilterLevels;
+    float irradianceSH[9][3];
+} r3d_skybox_baked_header_t;
+
+static size_t r3d_skybox_baked_cubemap_size(int size, int levels)
 {
-    static const int PREFILTER_SIZE = 128;
-    static const int MAX_MIP_LEVELS = 8;    //< 1 + (int)floor(log2(PREFILTER_SIZE))
+    size_t total = 0;
+    for (int level = 0; level < levels; level++) {
+        int levelSize = (size >> level > 0) ? size >> level : 1;
+        total += 6 * (size_t)levelSize * levelSize * 3 * sizeof(r3d_half_t);
+    }
+    return total;
+}
 
-    // Create the prefilter cubemap texture
-    unsigned int prefilterId = 0;
-    glGenTextures(1, &prefilterId);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, prefilterId);
-    for (int face = 0; face < 6; face++) {
-        for (int level = 0; level < MAX_MIP_LEVELS; level++) {
-            int size = PREFILTER_SIZE >> level;
+static unsigned char* r3d_skybox_read_cubemap(unsigned char* dst, GLuint id, int size, int levels)
+{
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    // Levels one after the other, each with its faces in the order +X, -X, +Y, -Y, +Z, -Z
+    for (int level = 0; level < levels; level++) {
+        int levelSize = (size >> level > 0) ? size >> level : 1;
+        for (int face = 0; face < 6; face++) {
+            glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_HALF_FLOAT, dst);
+            dst += (size_t)levelSize * levelSize * 3 * sizeof(r3d_half_t);
+        }
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
+
+    return dst;
+}
+
+static TextureCubemap r3d_skybox_upload_cubemap(const unsigned char** src, int size, int levels, bool generateMipmaps)
+{
+    unsigned int id = 0;
+    glGenTextures(1, &id);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (int level = 0; level < levels; level++) {
+        int levelSize = (size >> level > 0) ? size >> level : 1;
+        for (int face = 0; face < 6; face++) {
             glTexImage2D(
                 GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB16F,
-                size, size, 0, GL_RGB, GL_FLOAT, NULL
+                levelSize, levelSize, 0, GL_RGB, GL_HALF_FLOAT, *src
             );
+            *src += (size_t)levelSize * levelSize * 3 * sizeof(r3d_half_t);
         }
     }
+
+    if (generateMipmaps) {
+        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    }
+
+    bool mipmapped = generateMipmaps || levels > 1;
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
 
-    // Create a working framebuffer
-    // It will be configured for each mipmap
-    unsigned int fbo = rlLoadFramebuffer();
+    TextureCubemap cubemap = {
+        .id = id,
+        .width = size,
+        .height = size,
+        .mipmaps = levels,
+        .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
+    };
 
-    // Calculate projection matrix
-    const Matrix matProj = MatrixPerspective(90.0 * DEG2RAD, 1.0, 0.1, 10.0);
+    return cubemap;
+}
 
-    // Enable shader for prefiltering
-    R3D_SHADER_USE(prepare.cubemapPrefilter);
-    R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatProj, matProj);
-    R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uResolution, (float)sky.width);
-    R3D_SHADER_BIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap, sky.id);
+// ========================================
+// INCREMENTAL UPDATES
+// ========================================
+
+typedef enum {
+    R3D_SKYBOX_UPDATE_IDLE,
+    R3D_SKYBOX_UPDATE_CUBEMAP,      //< One pass per face of the cubemap
+    R3D_SKYBOX_UPDATE_MIPMAPS,      //< One pass for the whole mipmap chain
+    R3D_SKYBOX_UPDATE_READBACK,     //< One pass queuing the copy of the harmonics samples
+    R3D_SKYBOX_UPDATE_PREFILTER,    //< One pass per face and level of the prefilter
+    R3D_SKYBOX_UPDATE_FINISH        //< Waits for the samples, no pass counted
+} r3d_skybox_update_stage_t;
+
+struct R3D_SkyboxUpdater {
+    R3D_Skybox skyboxes[2];         //< Front skybox is the one returned, the other one is updated
+    int front;
+    int size;
+    GLuint fbo;
+    GLuint readbackPbo;
+    GLsync readbackFence;
+    int readbackSize;               //< Face size of the harmonics samples
+    Texture2D panorama;             //< Not owned, must stay valid until the update is done
+    r3d_skybox_update_stage_t stage;
+    int pass;                       //< Index of the next pass in the current stage
+};
+
+static void r3d_skybox_release_fence(R3D_SkyboxUpdater* updater)
+{
+    if (updater->readbackFence != NULL) {
+        glDeleteSync(updater->readbackFence);
+        updater->readbackFence = NULL;
+    }
+}
 
-    // Configure framebuffer and rendering parameters
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glDisable(GL_CULL_FACE);
+static void r3d_skybox_queue_sh_readback(R3D_SkyboxUpdater* updater, GLuint cubemapId)
+{
+    int size = 0;
+    int level = r3d_skybox_sh_sample_level(updater->size, &size);
+    size_t faceSize = (size_t)size * size * 3 * sizeof(float);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, updater->readbackPbo);
+    if (updater->readbackSize != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, 6 * faceSize, NULL, GL_STREAM_READ);
+        updater->readbackSize = size;
+    }
 
-    // Process each mipmap level
-    for (int mip = 0; mip < MAX_MIP_LEVELS; mip++)
-    {
-        int mipWidth = (int)(PREFILTER_SIZE * powf(0.5, (float)mip));
-        int mipHeight = (int)(PREFILTER_SIZE * powf(0.5, (float)mip));
+    // The copies are only queued here, the fence tells when they can be mapped
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, cubemapId);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int face = 0; face < 6; face++) {
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGB, GL_FLOAT, (void*)(face * faceSize));
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    r3d_state_bind_texture(R3D_STATE_UPLOAD_UNIT, GL_TEXTURE_CUBE_MAP, 0);
 
-        glViewport(0, 0, mipWidth, mipHeight);
-        float roughness = (float)mip / (float)(MAX_MIP_LEVELS - 1);
-        R3D_SHADER_SET_FLOAT(prepare.cubemapPrefilter, uRoughness, roughness);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        // Render all faces of the cubemap
-        for (int i = 0; i < 6; i++) {
-            R3D_SHADER_SET_MAT4(prepare.cubemapPrefilter, uMatView, R3D_CACHE_GET(matCubeViews[i]));
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, prefilterId, mip);
-            glClear(GL_DEPTH_BUFFER_BIT);
-            R3D_PRIMITIVE_DRAW_CUBE();
-        }
+    r3d_skybox_release_fence(updater);
+    updater->readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static bool r3d_skybox_consume_sh_readback(R3D_SkyboxUpdater* updater, Vector3 sh[9])
+{
+    GLenum status = glClientWaitSync(updater->readbackFence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
     }
 
-    // Unbind texture
-    R3D_SHADER_UNBIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap);
+    r3d_skybox_release_fence(updater);
 
-    // Cleanup the working framebuffer
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDeleteFramebuffers(1, &fbo);
-    
-    // Reset viewport and re-enable culling
-    glViewport(0, 0, rlGetFramebufferWidth(), rlGetFramebufferHeight());
-    glEnable(GL_CULL_FACE);
+    int size = updater->readbackSize;
+    size_t dataSize = 6 * (size_t)size * size * 3 * sizeof(float);
 
-    // Return prefiltered cubemap
-    TextureCubemap prefilter = {
-        .id = prefilterId,
-        .width = PREFILTER_SIZE,
-        .height = PREFILTER_SIZE,
-        .mipmaps = MAX_MIP_LEVELS,
-        .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
-    };
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, updater->readbackPbo);
+    const float* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, dataSize, GL_MAP_READ_BIT);
+    if (pixels != NULL) {
+        r3d_skybox_project_sh(pixels, size, sh);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else {
+        TraceLog(LOG_WARNING, "R3D: Failed to map the skybox irradiance samples");
+        memset(sh, 0, 9 * sizeof(Vector3));
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-    return prefilter;
+    return true;
 }
 
 // ========================================
@@ -399,6 +700,7 @@ static TextureCubemap r3d_skybox_generate_prefilter(TextureCubemap sky)
 R3D_Skybox R3D_LoadSkybox(const char* filePath, CubemapLayout layout)
 {
     Image image = LoadImage(filePath);
+    r3d_skybox_pack_half(&image);
     R3D_Skybox skybox = R3D_LoadSkyboxFromMemory(image, layout);
     UnloadImage(image);
     return skybox;
@@ -408,7 +710,7 @@ R3D_Skybox R3D_LoadSkyboxFromMemory(Image image, CubemapLayout layout)
 {
     R3D_Skybox skybox = { 0 };
     skybox.cubemap = r3d_skybox_load_cubemap_from_layout(&image, layout);
-    skybox.irradiance = r3d_skybox_generate_irradiance(skybox.cubemap);
+    r3d_skybox_compute_irradiance_sh(skybox.cubemap, skybox.irradianceSH);
     skybox.prefilter = r3d_skybox_generate_prefilter(skybox.cubemap);
     return skybox;
 }
@@ -416,6 +718,7 @@ R3D_Skybox R3D_LoadSkyboxFromMemory(Image image, CubemapLayout layout)
 R3D_Skybox R3D_LoadSkyboxPanorama(const char* filePath, int size)
 {
     Image image = LoadImage(filePath);
+    r3d_skybox_pack_half(&image);
     R3D_Skybox skybox = R3D_LoadSkyboxPanoramaFromMemory(image, size);
     UnloadImage(image);
     return skybox;
@@ -425,14 +728,242 @@ R3D_Skybox R3D_LoadSkyboxPanoramaFromMemory(Image image, int size)
 {
     R3D_Skybox skybox = { 0 };
     skybox.cubemap = r3d_skybox_load_cubemap_from_panorama(image, size);
-    skybox.irradiance = r3d_skybox_generate_irradiance(skybox.cubemap);
+    r3d_skybox_compute_irradiance_sh(skybox.cubemap, skybox.irradianceSH);
     skybox.prefilter = r3d_skybox_generate_prefilter(skybox.cubemap);
     return skybox;
 }
 
+bool R3D_SaveSkybox(R3D_Skybox sky, const char* filePath)
+{
+    if (sky.cubemap.id == 0 || sky.prefilter.id == 0) {
+        TraceLog(LOG_WARNING, "R3D: Cannot save an incomplete skybox to '%s'", filePath);
+        return false;
+    }
+
+    r3d_skybox_baked_header_t header = {
+        .version = R3D_SKYBOX_BAKED_VERSION,
+        .cubemapSize = sky.cubemap.width,
+        .prefilterSize = sky.prefilter.width,
+        .prefilterLevels = sky.prefilter.mipmaps
+    };
+    memcpy(header.magic, R3D_SKYBOX_BAKED_MAGIC, sizeof(header.magic));
+
+    for (int i = 0; i < 9; i++) {
+        header.irradianceSH[i][0] = sky.irradianceSH[i].x;
+        header.irradianceSH[i][1] = sky.irradianceSH[i].y;
+        header.irradianceSH[i][2] = sky.irradianceSH[i].z;
+    }
+
+    size_t size = sizeof(header)
+        + r3d_skybox_baked_cubemap_size(header.cubemapSize, 1)
+        + r3d_skybox_baked_cubemap_size(header.prefilterSize, header.prefilterLevels);
+
+    unsigned char* data = RL_MALLOC(size);
+    if (data == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the baked skybox data");
+        return false;
+    }
+
+    memcpy(data, &header, sizeof(header));
+
+    unsigned char* dst = data + sizeof(header);
+    dst = r3d_skybox_read_cubemap(dst, sky.cubemap.id, header.cubemapSize, 1);
+    dst = r3d_skybox_read_cubemap(dst, sky.prefilter.id, header.prefilterSize, header.prefilterLevels);
+
+    bool success = SaveFileData(filePath, data, (int)size);
+    if (!success) {
+        TraceLog(LOG_WARNING, "R3D: Failed to save baked skybox '%s'", filePath);
+    }
+
+    RL_FREE(data);
+
+    return success;
+}
+
+R3D_Skybox R3D_LoadSkyboxBaked(const char* filePath)
+{
+    R3D_Skybox skybox = { 0 };
+
+    r3d_mapped_file_t file = { 0 };
+    if (!r3d_mapped_file_open(&file, filePath)) {
+        TraceLog(LOG_WARNING, "R3D: Failed to open baked skybox '%s'", filePath);
+        return skybox;
+    }
+
+    r3d_skybox_baked_header_t header = { 0 };
+    if (file.size >= sizeof(header)) {
+        memcpy(&header, file.data, sizeof(header));
+    }
+
+    if (memcmp(header.magic, R3D_SKYBOX_BAKED_MAGIC, sizeof(header.magic)) != 0
+        || header.version != R3D_SKYBOX_BAKED_VERSION
+        || header.cubemapSize <= 0
+        || header.prefilterSize <= 0 || header.prefilterLevels <= 0
+        || file.size < sizeof(header)
+            + r3d_skybox_baked_cubemap_size(header.cubemapSize, 1)
+            + r3d_skybox_baked_cubemap_size(header.prefilterSize, header.prefilterLevels)) {
+        TraceLog(LOG_WARNING, "R3D: Invalid baked skybox '%s'", filePath);
+        r3d_mapped_file_close(&file);
+        return skybox;
+    }
+
+    // Plain uploads, the convolutions were done when the skybox was saved
+    const unsigned char* src = (const unsigned char*)file.data + sizeof(header);
+    skybox.cubemap = r3d_skybox_upload_cubemap(&src, header.cubemapSize, 1, true);
+    skybox.prefilter = r3d_skybox_upload_cubemap(&src, header.prefilterSize, header.prefilterLevels, false);
+
+    // Same as the generated cubemaps, the mipmaps of the sky are not counted
+    skybox.cubemap.mipmaps = 1;
+
+    for (int i = 0; i < 9; i++) {
+        skybox.irradianceSH[i] = (Vector3) {
+            header.irradianceSH[i][0], header.irradianceSH[i][1], header.irradianceSH[i][2]
+        };
+    }
+
+    r3d_mapped_file_close(&file);
+
+    return skybox;
+}
+
 void R3D_UnloadSkybox(R3D_Skybox sky)
 {
     UnloadTexture(sky.cubemap);
-    UnloadTexture(sky.irradiance);
     UnloadTexture(sky.prefilter);
 }
+
+R3D_SkyboxUpdater* R3D_LoadSkyboxUpdater(int size)
+{
+    R3D_SkyboxUpdater* updater = RL_CALLOC(1, sizeof(R3D_SkyboxUpdater));
+    if (updater == NULL) {
+        TraceLog(LOG_WARNING, "R3D: Failed to allocate the skybox updater");
+        return NULL;
+    }
+
+    updater->size = size;
+
+    // Both skyboxes are allocated once, the updates only render into them
+    for (int i = 0; i < 2; i++) {
+        R3D_Skybox* sky = &updater->skyboxes[i];
+        sky->cubemap = (TextureCubemap) {
+            .id = r3d_skybox_alloc_cubemap(size, 1),
+            .width = size,
+            .height = size,
+            .mipmaps = 1,
+            .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
+        };
+        sky->prefilter = (TextureCubemap) {
+            .id = r3d_skybox_alloc_cubemap(R3D_SKYBOX_PREFILTER_SIZE, R3D_SKYBOX_PREFILTER_LEVELS),
+            .width = R3D_SKYBOX_PREFILTER_SIZE,
+            .height = R3D_SKYBOX_PREFILTER_SIZE,
+            .mipmaps = R3D_SKYBOX_PREFILTER_LEVELS,
+            .format = RL_PIXELFORMAT_UNCOMPRESSED_R16G16B16
+        };
+        r3d_skybox_generate_mipmaps(sky->cubemap.id);
+    }
+
+    updater->fbo = rlLoadFramebuffer();
+    glGenBuffers(1, &updater->readbackPbo);
+
+    return updater;
+}
+
+void R3D_UnloadSkyboxUpdater(R3D_SkyboxUpdater* updater)
+{
+    if (updater == NULL) return;
+
+    r3d_skybox_release_fence(updater);
+    glDeleteBuffers(1, &updater->readbackPbo);
+    glDeleteFramebuffers(1, &updater->fbo);
+
+    R3D_UnloadSkybox(updater->skyboxes[0]);
+    R3D_UnloadSkybox(updater->skyboxes[1]);
+
+    RL_FREE(updater);
+}
+
+void R3D_RequestSkyboxUpdate(R3D_SkyboxUpdater* updater, Texture2D panorama)
+{
+    // Any update in progress is restarted, the front skybox is left untouched
+    r3d_skybox_release_fence(updater);
+
+    updater->panorama = panorama;
+    updater->stage = R3D_SKYBOX_UPDATE_CUBEMAP;
+    updater->pass = 0;
+}
+
+bool R3D_UpdateSkyboxIncremental(R3D_SkyboxUpdater* updater, int maxPasses)
+{
+    if (updater->stage == R3D_SKYBOX_UPDATE_IDLE) {
+        return false;
+    }
+
+    R3D_Skybox* back = &updater->skyboxes[1 - updater->front];
+    int passes = 0;
+
+    if (maxPasses < 1) {
+        maxPasses = 1;
+    }
+
+    r3d_skybox_begin_passes(updater->fbo);
+
+    while (passes < maxPasses && updater->stage != R3D_SKYBOX_UPDATE_FINISH)
+    {
+        switch (updater->stage) {
+        case R3D_SKYBOX_UPDATE_CUBEMAP:
+            r3d_skybox_setup_panorama_shader(updater->panorama.id);
+            while (passes < maxPasses && updater->pass < 6) {
+                r3d_skybox_render_panorama_face(back->cubemap.id, updater->size, updater->pass++);
+                passes++;
+            }
+            R3D_SHADER_UNBIND_SAMPLER_2D(prepare.cubemapFromEquirectangular, uTexEquirectangular);
+            if (updater->pass == 6) {
+                updater->stage = R3D_SKYBOX_UPDATE_MIPMAPS;
+                updater->pass = 0;
+            }
+            break;
+        case R3D_SKYBOX_UPDATE_MIPMAPS:
+            r3d_skybox_generate_mipmaps(back->cubemap.id);
+            updater->stage = R3D_SKYBOX_UPDATE_READBACK;
+            passes++;
+            break;
+        case R3D_SKYBOX_UPDATE_READBACK:
+            r3d_skybox_queue_sh_readback(updater, back->cubemap.id);
+            updater->stage = R3D_SKYBOX_UPDATE_PREFILTER;
+            passes++;
+            break;
+        case R3D_SKYBOX_UPDATE_PREFILTER:
+            r3d_skybox_setup_prefilter_shader(back->cubemap);
+            while (passes < maxPasses && updater->pass < 6 * R3D_SKYBOX_PREFILTER_LEVELS) {
+                r3d_skybox_render_prefilter_face(back->prefilter.id, updater->pass / 6, updater->pass % 6);
+                updater->pass++;
+                passes++;
+            }
+            R3D_SHADER_UNBIND_SAMPLER_CUBE(prepare.cubemapPrefilter, uCubemap);
+            if (updater->pass == 6 * R3D_SKYBOX_PREFILTER_LEVELS) {
+                updater->stage = R3D_SKYBOX_UPDATE_FINISH;
+                updater->pass = 0;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    r3d_skybox_end_passes();
+
+    // The swap waits for the harmonics, so the lighting never mixes two skies
+    if (updater->stage != R3D_SKYBOX_UPDATE_FINISH || !r3d_skybox_consume_sh_readback(updater, back->irradianceSH)) {
+        return false;
+    }
+
+    updater->front = 1 - updater->front;
+    updater->stage = R3D_SKYBOX_UPDATE_IDLE;
+
+    return true;
+}
+
+R3D_Skybox R3D_GetUpdatedSkybox(const R3D_SkyboxUpdater* updater)
+{
+    return updater->skyboxes[updater->front];
+}
@@ -0,0 +1,334 @@
+/* r3d_terrain.c -- R3D Terrain Module.
+ *
+ * Copyright (c) 2025 Le Juez Victor
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * For conditions of distribution and use, see accompanying LICENSE file.
+ */
+
+#include <r3d/r3d_mesh_data.h>
+#include <r3d/r3d_material.h>
+#include <r3d/r3d_terrain.h>
+#include <r3d/r3d_draw.h>
+#include <r3d/r3d_mesh.h>
+#include <raymath.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+// ========================================
+// INTERNAL TYPES
+// ========================================
+
+typedef struct {
+    float* heights;                     //< Normalized heights, row by row along Z
+    int width, depth;                   //< Number of samples along X and Z
+    Vector3 size;
+    float stepX, stepZ;
+} terrain_map_t;
+
+// ========================================
+// INTERNAL FUNCTIONS
+// ========================================
+
+static float map_height(const terrain_map_t* map, int x, int z)
+{
+    x = (x < 0) ? 0 : (x >= map->width) ? map->width - 1 : x;
+    z = (z < 0) ? 0 : (z >= map->depth) ? map->depth - 1 : z;
+    return map->heights[z * map->width + x];
+}
+
+// Same layout as R3D_GenMeshDataHeightmap, the gradient is taken from the whole map
+// so that the normals match across the borders of the chunks
+static R3D_Vertex map_vertex(const terrain_map_t* map, int x, int z)
+{
+    float gradX = (map_height(map, x + 1, z) - map_height(map, x - 1, z)) / (2.0f * map->stepX);
+    float gradZ = (map_height(map, x, z + 1) - map_height(map, x, z - 1)) / (2.0f * map->stepZ);
+
+    Vector3 tangent = Vector3Normalize((Vector3) { 1.0f, gradX, 0.0f });
+
+    return (R3D_Vertex) {
+        .position = {
+            -0.5f * map->size.x + x * map->stepX,
+            map_height(map, x, z) * map->size.y,
+            -0.5f * map->size.z + z * map->stepZ
+        },
+        .texcoord = { (float)x / (map->width - 1), (float)z / (map->depth - 1) },
+        .normal = Vector3Normalize((Vector3) { -gradX, 1.0f, -gradZ }),
+        .color = { 255, 255, 255, 255 },
+        .tangent = { tangent.x, tangent.y, tangent.z, 1.0f }
+    };
+}
+
+/*
+ * The skirts follow the border of the chunk counter-clockwise seen from above,
+ * starting at the -Z edge, so that their triangles face outward.
+ */
+static int edge_length(int edge, int w, int h)
+{
+    return (edge % 2 == 0) ? w : h;
+}
+
+static uint32_t edge_grid_vertex(int edge, int i, int w, int h)
+{
+    switch (edge) {
+    case 0: return i;
+    case 1: return i * (w + 1) + w;
+    case 2: return h * (w + 1) + (w - i);
+    default: return (h - i) * (w + 1);
+    }
+}
+
+static uint32_t edge_skirt_vertex(int edge, int i, int w, int h)
+{
+    uint32_t base = (w + 1) * (h + 1);
+    for (int e = 0; e < edge; e++) {
+        base += edge_length(e, w, h) + 1;
+    }
+    return base + i;
+}
+
+// Writes the triangles of a chunk of 'w' by 'h' quads, sampling every 'step' rows and columns
+static int gen_chunk_indices(uint32_t* indices, int w, int h, int step)
+{
+    int count = 0;
+
+    for (int z = 0; z < h; z += step)
+    {
+        int z1 = (z + step < h) ? z + step : h;
+
+        for (int x = 0; x < w; x += step)
+        {
+            int x1 = (x + step < w) ? x + step : w;
+
+            uint32_t topLeft = z * (w + 1) + x;
+            uint32_t topRight = z * (w + 1) + x1;
+            uint32_t bottomLeft = z1 * (w + 1) + x;
+            uint32_t bottomRight = z1 * (w + 1) + x1;
+
+            indices[count++] = topLeft;
+            indices[count++] = bottomLeft;
+            indices[count++] = topRight;
+
+            indices[count++] = topRight;
+            indices[count++] = bottomLeft;
+            indices[count++] = bottomRight;
+        }
+    }
+
+    for (int edge = 0; edge < 4; edge++)
+    {
+        int length = edge_length(edge, w, h);
+
+        for (int i = 0; i < length; i += step)
+        {
+            int i1 = (i + step < length) ? i + step : length;
+
+            uint32_t a = edge_grid_vertex(edge, i, w, h);
+            uint32_t b = edge_grid_vertex(edge, i1, w, h);
+            uint32_t skirtA = edge_skirt_vertex(edge, i, w, h);
+            uint32_t skirtB = edge_skirt_vertex(edge, i1, w, h);
+
+            indices[count++] = a;
+            indices[count++] = b;
+            indices[count++] = skirtA;
+
+            indices[count++] = b;
+            indices[count++] = skirtB;
+            indices[count++] = skirtA;
+        }
+    }
+
+    return count;
+}
+
+static bool load_chunk(R3D_Mesh* mesh, const terrain_map_t* map, int x0, int z0, int w, int h, int lodCount)
+{
+    int gridCount = (w + 1) * (h + 1);
+    int vertexCount = gridCount + 2 * (w + 1) + 2 * (h + 1);
+    int indexCount = 6 * (w * h + 2 * w + 2 * h);
+
+    R3D_MeshData data = R3D_CreateMeshData(vertexCount, indexCount);
+    if (!R3D_IsMeshDataValid(&data) || data.indices == NULL) {
+        R3D_UnloadMeshData(&data);
+        return false;
+    }
+
+    /* --- Generate the grid vertices --- */
+
+    float minY = FLT_MAX, maxY = -FLT_MAX;
+
+    for (int z = 0; z <= h; z++) {
+        for (int x = 0; x <= w; x++) {
+            R3D_Vertex vertex = map_vertex(map, x0 + x, z0 + z);
+            minY = fminf(minY, vertex.position.y);
+            maxY = fmaxf(maxY, vertex.position.y);
+            data.vertices[z * (w + 1) + x] = vertex;
+        }
+    }
+
+    /* --- Generate the skirts, lowered below the lowest height of the chunk --- */
+
+    // The gap between two levels along an edge never exceeds the height range of the chunk
+    float skirtDepth = (maxY - minY) + 0.01f * map->size.y;
+
+    for (int edge = 0; edge < 4; edge++) {
+        int length = edge_length(edge, w, h);
+        for (int i = 0; i <= length; i++) {
+            R3D_Vertex vertex = data.vertices[edge_grid_vertex(edge, i, w, h)];
+            vertex.position.y -= skirtDepth;
+            data.vertices[edge_skirt_vertex(edge, i, w, h)] = vertex;
+        }
+    }
+
+    /* --- Upload the full level, then the coarser ones --- */
+
+    data.indexCount = gen_chunk_indices(data.indices, w, h, 1);
+
+    *mesh = R3D_LoadMesh(R3D_PRIMITIVE_TRIANGLES, &data, NULL, R3D_STATIC_MESH);
+    if (!R3D_IsMeshValid(mesh)) {
+        R3D_UnloadMeshData(&data);
+        return false;
+    }
+
+    int extent = (w > h) ? w : h;
+
+    for (int level = 1; level <= lodCount; level++)
+    {
+        // Stop once the previous level is a single quad
+        int step = 1 << level;
+        if ((step >> 1) >= extent) break;
+
+        int count = gen_chunk_indices(data.indices, w, h, step);
+        if (!R3D_AddMeshLod(mesh, data.indices, count, 0.5f / (float)(1 << (level - 1)))) {
+            break;
+        }
+    }
+
+    R3D_UnloadMeshData(&data);
+
+    return true;
+}
+
+// ========================================
+// PUBLIC API
+// ========================================
+
+R3D_Terrain R3D_LoadTerrain(Image heightmap, Vector3 size, int chunkSize, int lodCount)
+{
+    R3D_Terrain terrain = { 0 };
+
+    if (heightmap.data == NULL || heightmap.width <= 1 || heightmap.height <= 1 ||
+        size.x <= 0.0f || size.y <= 0.0f || size.z <= 0.0f || chunkSize <= 0) {
+        TraceLog(LOG_WARNING, "R3D: Invalid parameters given to R3D_LoadTerrain");
+        return terrain;
+    }
+
+    if (lodCount < 0) lodCount = 0;
+    if (lodCount > R3D_MESH_MAX_LODS) lodCount = R3D_MESH_MAX_LODS;
+
+    /* --- Read the heights once --- */
+
+    terrain_map_t map = {
+        .width = heightmap.width,
+        .depth = heightmap.height,
+        .size = size,
+        .stepX = size.x / (heightmap.width - 1),
+        .stepZ = size.z / (heightmap.height - 1)
+    };
+
+    Color* pixels = LoadImageColors(heightmap);
+    map.heights = RL_MALLOC(map.width * map.depth * sizeof(float));
+
+    if (pixels == NULL || map.heights == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on terrain creation");
+        if (pixels) UnloadImageColors(pixels);
+        RL_FREE(map.heights);
+        return terrain;
+    }
+
+    for (int i = 0; i < map.width * map.depth; i++) {
+        map.heights[i] = (float)pixels[i].r / 255;
+    }
+
+    UnloadImageColors(pixels);
+
+    /* --- Build the chunks --- */
+
+    int quadsX = map.width - 1;
+    int quadsZ = map.depth - 1;
+
+    terrain.chunkCountX = (quadsX + chunkSize - 1) / chunkSize;
+    terrain.chunkCountZ = (quadsZ + chunkSize - 1) / chunkSize;
+    terrain.chunks = RL_CALLOC(terrain.chunkCountX * terrain.chunkCountZ, sizeof(R3D_Mesh));
+
+    if (terrain.chunks == NULL) {
+        TraceLog(LOG_ERROR, "R3D: Bad alloc on terrain creation");
+        RL_FREE(map.heights);
+        return (R3D_Terrain) { 0 };
+    }
+
+    terrain.material = R3D_GetDefaultMaterial();
+    terrain.aabb.min = (Vector3) { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+    terrain.aabb.max = (Vector3) { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (int cz = 0; cz < terrain.chunkCountZ; cz++)
+    {
+        for (int cx = 0; cx < terrain.chunkCountX; cx++)
+        {
+            int x0 = cx * chunkSize, z0 = cz * chunkSize;
+            int w = (quadsX - x0 < chunkSize) ? quadsX - x0 : chunkSize;
+            int h = (quadsZ - z0 < chunkSize) ? quadsZ - z0 : chunkSize;
+
+            R3D_Mesh* chunk = &terrain.chunks[cz * terrain.chunkCountX + cx];
+
+            if (!load_chunk(chunk, &map, x0, z0, w, h, lodCount)) {
+                TraceLog(LOG_ERROR, "R3D: Failed to load terrain chunk (%i, %i)", cx, cz);
+                RL_FREE(map.heights);
+                R3D_UnloadTerrain(&terrain, false);
+                return (R3D_Terrain) { 0 };
+            }
+
+            terrain.aabb.min = Vector3Min(terrain.aabb.min, chunk->aabb.min);
+            terrain.aabb.max = Vector3Max(terrain.aabb.max, chunk->aabb.max);
+        }
+    }
+
+    RL_FREE(map.heights);
+
+    return terrain;
+}
+
+void R3D_UnloadTerrain(R3D_Terrain* terrain, bool unloadMaterial)
+{
+    if (terrain == NULL) {
+        return;
+    }
+
+    if (terrain->chunks != NULL) {
+        for (int i = 0; i < terrain->chunkCountX * terrain->chunkCountZ; i++) {
+            R3D_UnloadMesh(&terrain->chunks[i]);
+        }
+        RL_FREE(terrain->chunks);
+    }
+
+    if (unloadMaterial) {
+        R3D_UnloadMaterial(&terrain->material);
+    }
+
+    *terrain = (R3D_Terrain) { 0 };
+}
+
+void R3D_DrawTerrain(const R3D_Terrain* terrain, Vector3 position)
+{
+    if (terrain == NULL || terrain->chunks == NULL) {
+        return;
+    }
+
+    Matrix transform = MatrixTranslate(position.x, position.y, position.z);
+
+    for (int i = 0; i < terrain->chunkCountX * terrain->chunkCountZ; i++) {
+        R3D_DrawMesh(&terrain->chunks[i], &terrain->material, transform);
+    }
+}
@@ -53,8 +53,8 @@ Texture2D R3D_GetBufferNormal(void)
 {
     Texture2D texture = { 0 };
     texture.id = r3d_target_get(R3D_TARGET_NORMAL);
-    texture.width = R3D_TARGET_WIDTH;
-    texture.height = R3D_TARGET_HEIGHT;
+    texture.width = R3D_TARGET_ALLOC_WIDTH;
+    texture.height = R3D_TARGET_ALLOC_HEIGHT;
     texture.mipmaps = 1;
     texture.format = PIXELFORMAT_UNCOMPRESSED_R32;
     return texture;
@@ -64,8 +64,8 @@ Texture2D R3D_GetBufferDepth(void)
 {
     Texture2D texture = { 0 };
     texture.id = r3d_target_get(R3D_TARGET_DEPTH);
-    texture.width = R3D_TARGET_WIDTH;
-    texture.height = R3D_TARGET_HEIGHT;
+    texture.width = R3D_TARGET_ALLOC_WIDTH;
+    texture.height = R3D_TARGET_ALLOC_HEIGHT;
     texture.mipmaps = 1;
     texture.format = PIXELFORMAT_UNCOMPRESSED_R32;
     return texture;
@@ -95,12 +95,12 @@ void R3D_DrawBufferAlbedo(float x, float y, float w, float h)
 {
     Texture2D tex = {
         .id = r3d_target_get(R3D_TARGET_ALBEDO),
-        .width = R3D_TARGET_WIDTH,
-        .height = R3D_TARGET_HEIGHT
+        .width = R3D_TARGET_ALLOC_WIDTH,
+        .height = R3D_TARGET_ALLOC_HEIGHT
     };
 
     DrawTexturePro(
-        tex, (Rectangle) { 0, 0, (float)tex.width, (float)-tex.height },
+        tex, (Rectangle) { 0, 0, (float)R3D_TARGET_WIDTH, (float)-R3D_TARGET_HEIGHT },
         (Rectangle) { x, y, w, h }, (Vector2) { 0 }, 0, WHITE
     );
 
@@ -115,12 +115,12 @@ void R3D_DrawBufferNormal(float x, float y, float w, float h)
 {
     Texture2D tex = {
         .id = r3d_target_get(R3D_TARGET_NORMAL),
-        .width = R3D_TARGET_WIDTH,
-        .height = R3D_TARGET_HEIGHT
+        .width = R3D_TARGET_ALLOC_WIDTH,
+        .height = R3D_TARGET_ALLOC_HEIGHT
     };
 
     DrawTexturePro(
-        tex, (Rectangle) { 0, 0, (float)tex.width, (float)-tex.height },
+        tex, (Rectangle) { 0, 0, (float)R3D_TARGET_WIDTH, (float)-R3D_TARGET_HEIGHT },
         (Rectangle) { x, y, w, h }, (Vector2) { 0 }, 0, WHITE
     );
 
@@ -135,12 +135,12 @@ void R3D_DrawBufferORM(float x, float y, float w, float h)
 {
     Texture2D tex = {
         .id = r3d_target_get(R3D_TARGET_ORM),
-        .width = R3D_TARGET_WIDTH,
-        .height = R3D_TARGET_HEIGHT
+        .width = R3D_TARGET_ALLOC_WIDTH,
+        .height = R3D_TARGET_ALLOC_HEIGHT
     };
 
     DrawTexturePro(
-        tex, (Rectangle) { 0, 0, (float)tex.width, (float)-tex.height },
+        tex, (Rectangle) { 0, 0, (float)R3D_TARGET_WIDTH, (float)-R3D_TARGET_HEIGHT },
         (Rectangle) { x, y, w, h }, (Vector2) { 0 }, 0, WHITE
     );
 